@@ -0,0 +1,201 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Splitting of video frames into bands of rows processed in parallel, shared
+ * by the plugins. Everything is static inline, so each plugin gets its own
+ * copy. */
+
+#ifndef __GST_VIDEO_BANDS_PRIVATE_H__
+#define __GST_VIDEO_BANDS_PRIVATE_H__
+
+#include <gst/gst.h>
+#include <gst/video/video.h>
+
+G_BEGIN_DECLS
+
+/* Processes a frame in place. Called with a frame describing a band of rows
+ * of the original frame. */
+typedef void (*GstVideoBandsFunc) (gpointer user_data, GstVideoFrame * band);
+
+/* Processes rows @y to @y + @height */
+typedef void (*GstVideoBandsRowsFunc) (gpointer user_data, gint y,
+    gint height);
+
+/* Splits frames into bands of rows that are processed in parallel by a thread
+ * pool and the calling thread */
+typedef struct
+{
+  GThreadPool *pool;
+  GMutex lock;
+  GCond cond;
+  guint pending;
+} GstVideoBands;
+
+typedef struct
+{
+  gint y, height;
+  GstVideoBandsRowsFunc func;
+  gpointer user_data;
+} GstVideoBand;
+
+typedef struct
+{
+  GstVideoFrame *frame;
+  GstVideoBandsFunc func;
+  gpointer user_data;
+} GstVideoBandsFrame;
+
+static inline void
+gst_video_bands_init (GstVideoBands * bands)
+{
+  bands->pool = NULL;
+  bands->pending = 0;
+  g_mutex_init (&bands->lock);
+  g_cond_init (&bands->cond);
+}
+
+static inline void
+gst_video_bands_clear (GstVideoBands * bands)
+{
+  if (bands->pool)
+    g_thread_pool_free (bands->pool, FALSE, TRUE);
+  bands->pool = NULL;
+  g_mutex_clear (&bands->lock);
+  g_cond_clear (&bands->cond);
+}
+
+/* make @band describe rows @y to @y + @height of @frame */
+static inline void
+gst_video_bands_slice_frame (const GstVideoFrame * frame, GstVideoFrame * band,
+    gint y, gint height)
+{
+  guint c;
+
+  *band = *frame;
+  GST_VIDEO_INFO_HEIGHT (&band->info) = height;
+
+  for (c = 0; c < GST_VIDEO_FRAME_N_COMPONENTS (frame); c++) {
+    gint plane = GST_VIDEO_FRAME_COMP_PLANE (frame, c);
+
+    band->data[plane] = (guint8 *) frame->data[plane] +
+        GST_VIDEO_FORMAT_INFO_SCALE_HEIGHT (frame->info.finfo, c, y) *
+        GST_VIDEO_FRAME_PLANE_STRIDE (frame, plane);
+  }
+}
+
+/* bands must start on a row that all subsampled components start on */
+static inline gint
+gst_video_bands_alignment (const GstVideoFrame * frame)
+{
+  gint align = 1;
+  guint c;
+
+  for (c = 0; c < GST_VIDEO_FRAME_N_COMPONENTS (frame); c++)
+    align = MAX (align, 1 << GST_VIDEO_FORMAT_INFO_H_SUB (frame->info.finfo,
+            c));
+
+  return align;
+}
+
+static inline void
+gst_video_bands_process_band (GstVideoBand * band, GstVideoBands * bands)
+{
+  band->func (band->user_data, band->y, band->height);
+
+  g_mutex_lock (&bands->lock);
+  if (--bands->pending == 0)
+    g_cond_signal (&bands->cond);
+  g_mutex_unlock (&bands->lock);
+}
+
+/* Runs @func on up to @n_threads bands of the rows 0 to @height, with each
+ * band starting on a multiple of @align. 0 uses one band per CPU. */
+static inline void
+gst_video_bands_process_rows (GstVideoBands * bands, guint n_threads,
+    gint height, gint align, GstVideoBandsRowsFunc func, gpointer user_data)
+{
+  GstVideoBand *slices;
+  guint n_bands, i;
+  gint band_height, y;
+
+  if (n_threads == 0)
+    n_threads = g_get_num_processors ();
+
+  band_height = GST_ROUND_UP_N ((height + n_threads - 1) / n_threads, align);
+  n_bands = band_height > 0 ? (height + band_height - 1) / band_height : 0;
+
+  if (n_bands <= 1) {
+    func (user_data, 0, height);
+    return;
+  }
+
+  if (!bands->pool) {
+    bands->pool =
+        g_thread_pool_new ((GFunc) gst_video_bands_process_band, bands,
+        n_bands - 1, FALSE, NULL);
+  } else if (g_thread_pool_get_max_threads (bands->pool) < (gint) n_bands - 1) {
+    g_thread_pool_set_max_threads (bands->pool, n_bands - 1, NULL);
+  }
+
+  slices = g_newa (GstVideoBand, n_bands);
+  for (i = 0, y = 0; i < n_bands; i++, y += band_height) {
+    slices[i].y = y;
+    slices[i].height = MIN (band_height, height - y);
+    slices[i].func = func;
+    slices[i].user_data = user_data;
+  }
+
+  bands->pending = n_bands - 1;
+  for (i = 1; i < n_bands; i++)
+    g_thread_pool_push (bands->pool, &slices[i], NULL);
+
+  /* the first band is done by the calling thread */
+  func (user_data, slices[0].y, slices[0].height);
+
+  g_mutex_lock (&bands->lock);
+  while (bands->pending > 0)
+    g_cond_wait (&bands->cond, &bands->lock);
+  g_mutex_unlock (&bands->lock);
+}
+
+static inline void
+gst_video_bands_process_frame_rows (GstVideoBandsFrame * data, gint y,
+    gint height)
+{
+  GstVideoFrame band;
+
+  gst_video_bands_slice_frame (data->frame, &band, y, height);
+  data->func (data->user_data, &band);
+}
+
+/* Runs @func on @frame, split into up to @n_threads bands of rows. 0 uses one
+ * band per CPU. */
+static inline void
+gst_video_bands_process (GstVideoBands * bands, guint n_threads,
+    GstVideoFrame * frame, GstVideoBandsFunc func, gpointer user_data)
+{
+  GstVideoBandsFrame data = { frame, func, user_data };
+
+  gst_video_bands_process_rows (bands, n_threads,
+      GST_VIDEO_FRAME_HEIGHT (frame), gst_video_bands_alignment (frame),
+      (GstVideoBandsRowsFunc) gst_video_bands_process_frame_rows, &data);
+}
+
+G_END_DECLS
+
+#endif /* __GST_VIDEO_BANDS_PRIVATE_H__ */
@@ -109,6 +109,7 @@ enum
 #define DEFAULT_BLACK_SENSITIVITY 100
 #define DEFAULT_WHITE_SENSITIVITY 100
 #define DEFAULT_PREFER_PASSTHROUGH FALSE
+#define DEFAULT_N_THREADS 1
 
 enum
 {
@@ -122,7 +123,8 @@ enum
   PROP_NOISE_LEVEL,
   PROP_BLACK_SENSITIVITY,
   PROP_WHITE_SENSITIVITY,
-  PROP_PREFER_PASSTHROUGH
+  PROP_PREFER_PASSTHROUGH,
+  PROP_N_THREADS
 };
 
 static GstStaticPadTemplate gst_alpha_src_template =
@@ -268,6 +270,21 @@ gst_alpha_class_init (GstAlphaClass * klass)
           DEFAULT_PREFER_PASSTHROUGH,
           G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstAlpha:n-threads:
+   *
+   * Maximum number of threads used to process each frame. The frame is split
+   * into bands of rows that are processed in parallel. 0 uses one thread per
+   * CPU.
+   *
+   * Since: 1.24
+   */
+  g_object_class_install_property (G_OBJECT_CLASS (klass),
+      PROP_N_THREADS, g_param_spec_uint ("n-threads", "Threads",
+          "Maximum number of threads to use (0 = number of CPUs)", 0,
+          G_MAXINT, DEFAULT_N_THREADS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_set_static_metadata (gstelement_class, "Alpha filter",
       "Filter/Effect/Video",
       "Adds an alpha channel to video - uniform or via chroma-keying",
@@ -303,8 +320,10 @@ gst_alpha_init (GstAlpha * alpha)
   alpha->noise_level = DEFAULT_NOISE_LEVEL;
   alpha->black_sensitivity = DEFAULT_BLACK_SENSITIVITY;
   alpha->white_sensitivity = DEFAULT_WHITE_SENSITIVITY;
+  alpha->n_threads = DEFAULT_N_THREADS;
 
   g_mutex_init (&alpha->lock);
+  gst_video_bands_init (&alpha->bands);
 }
 
 static void
@@ -312,6 +331,7 @@ gst_alpha_finalize (GObject * object)
 {
   GstAlpha *alpha = GST_ALPHA (object);
 
+  gst_video_bands_clear (&alpha->bands);
   g_mutex_clear (&alpha->lock);
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
@@ -380,6 +400,9 @@ gst_alpha_set_property (GObject * object, guint prop_id,
       alpha->prefer_passthrough = prefer_passthrough;
       break;
     }
+    case PROP_N_THREADS:
+      alpha->n_threads = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -428,6 +451,11 @@ gst_alpha_get_property (GObject * object, guint prop_id, GValue * value,
     case PROP_PREFER_PASSTHROUGH:
       g_value_set_boolean (value, alpha->prefer_passthrough);
       break;
+    case PROP_N_THREADS:
+      GST_ALPHA_LOCK (alpha);
+      g_value_set_uint (value, alpha->n_threads);
+      GST_ALPHA_UNLOCK (alpha);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -555,10 +583,8 @@ chroma_keying_yuv (gint a, gint * y, gint * u,
   gint x1, y1;
   gint x, z;
   gint b_alpha;
-
-  /* too dark or too bright, keep alpha */
-  if (*y < smin || *y > smax)
-    return a;
+  gint key_y, key_u, key_v;
+  gint keep;
 
   /* Convert foreground to XZ coords where X direction is defined by
      the key color */
@@ -578,10 +604,11 @@ chroma_keying_yuv (gint a, gint * y, gint * u,
   tmp = (x * accept_angle_tg) >> 4;
   tmp = MIN (tmp, 127);
 
-  if (abs (z) > tmp) {
-    /* keep foreground Kfg = 0 */
-    return a;
-  }
+  /* too dark, too bright or outside of the accept angle: keep the pixel and
+   * its alpha (Kfg = 0). Everything below is computed anyway and selected at
+   * the end, so that the loops calling this don't branch per pixel */
+  keep = (*y < smin) | (*y > smax) | (abs (z) > tmp);
+
   /* Compute Kfg (implicitly) and Kbg, suppress foreground in XZ coord
      according to Kfg */
   tmp = (z * accept_angle_ctg) >> 4;
@@ -598,14 +625,14 @@ chroma_keying_yuv (gint a, gint * y, gint * u,
   tmp = (tmp1 * kfgy_scale) >> 4;
   tmp1 = MIN (tmp, 255);
 
-  *y = (*y < tmp1) ? 0 : *y - tmp1;
+  key_y = (*y < tmp1) ? 0 : *y - tmp1;
 
   /* Convert suppressed foreground back to CbCr */
   tmp = (x1 * cb - y1 * cr) >> 7;
-  *u = CLAMP (tmp, -128, 127);
+  key_u = CLAMP (tmp, -128, 127);
 
   tmp = (x1 * cr + y1 * cb) >> 7;
-  *v = CLAMP (tmp, -128, 127);
+  key_v = CLAMP (tmp, -128, 127);
 
   /* Deal with noise. For now, a circle around the key color with
      radius of noise_level treated as exact key color. Introduces
@@ -617,7 +644,11 @@ chroma_keying_yuv (gint a, gint * y, gint * u,
   if (tmp < noise_level2)
     b_alpha = 0;
 
-  return b_alpha;
+  *y = keep ? *y : key_y;
+  *u = keep ? *u : key_u;
+  *v = keep ? *v : key_v;
+
+  return keep ? a : b_alpha;
 }
 
 #define APPLY_MATRIX(m,o,v1,v2,v3) ((m[o*4] * v1 + m[o*4+1] * v2 + m[o*4+2] * v3 + m[o*4+3]) >> 8)
@@ -2620,6 +2651,41 @@ gst_alpha_before_transform (GstBaseTransform * btrans, GstBuffer * buf)
     gst_object_sync_values (GST_OBJECT (alpha), timestamp);
 }
 
+typedef struct
+{
+  GstAlpha *alpha;
+  GstVideoFrame *in_frame;
+  GstVideoFrame *out_frame;
+} GstAlphaJob;
+
+static void
+gst_alpha_process_rows (GstAlphaJob * job, gint y, gint height)
+{
+  GstVideoFrame in_band, out_band;
+
+  gst_video_bands_slice_frame (job->in_frame, &in_band, y, height);
+  gst_video_bands_slice_frame (job->out_frame, &out_band, y, height);
+  job->alpha->process (&in_band, &out_band, job->alpha);
+}
+
+/* called with the alpha lock, which keeps the parameters stable while the
+ * other threads read them */
+static void
+gst_alpha_process_frame (GstAlpha * alpha, guint n_threads,
+    GstVideoFrame * in_frame, GstVideoFrame * out_frame)
+{
+  GstAlphaJob job = { alpha, in_frame, out_frame };
+  gint align;
+
+  /* the bands have to start on a chroma row of both formats */
+  align = MAX (gst_video_bands_alignment (in_frame),
+      gst_video_bands_alignment (out_frame));
+
+  gst_video_bands_process_rows (&alpha->bands, n_threads,
+      GST_VIDEO_FRAME_HEIGHT (in_frame), align,
+      (GstVideoBandsRowsFunc) gst_alpha_process_rows, &job);
+}
+
 static GstFlowReturn
 gst_alpha_transform_frame (GstVideoFilter * filter, GstVideoFrame * in_frame,
     GstVideoFrame * out_frame)
@@ -2631,7 +2697,7 @@ gst_alpha_transform_frame (GstVideoFilter * filter, GstVideoFrame * in_frame,
   if (G_UNLIKELY (!alpha->process))
     goto not_negotiated;
 
-  alpha->process (in_frame, out_frame, alpha);
+  gst_alpha_process_frame (alpha, alpha->n_threads, in_frame, out_frame);
 
   GST_ALPHA_UNLOCK (alpha);
 
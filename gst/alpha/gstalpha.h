@@ -27,6 +27,8 @@
 #include <gst/video/video.h>
 #include <gst/video/gstvideofilter.h>
 
+#include <gst/video-bands-private.h>
+
 G_BEGIN_DECLS
 
 #define GST_TYPE_ALPHA (gst_alpha_get_type ())
@@ -79,9 +81,14 @@ struct _GstAlpha
 
   gboolean prefer_passthrough;
 
+  guint n_threads;
+
   /* processing function */
   void (*process) (const GstVideoFrame *in_frame, GstVideoFrame *out_frame, GstAlpha *alpha);
 
+  /* processes the row bands of a frame, see n-threads */
+  GstVideoBands bands;
+
   /* precalculated values for chroma keying */
   gint8 cb, cr;
   gint8 kg;
@@ -57,13 +57,15 @@ enum
   PROP_SCRATCH_LINES,
   PROP_COLOR_AGING,
   PROP_PITS,
-  PROP_DUSTS
+  PROP_DUSTS,
+  PROP_N_THREADS
 };
 
 #define DEFAULT_SCRATCH_LINES 7
 #define DEFAULT_COLOR_AGING TRUE
 #define DEFAULT_PITS TRUE
 #define DEFAULT_DUSTS TRUE
+#define DEFAULT_N_THREADS 1
 
 #if G_BYTE_ORDER == G_LITTLE_ENDIAN
 #define CAPS_STR GST_VIDEO_CAPS_MAKE ("{ BGRx, RGBx }")
@@ -89,33 +91,47 @@ G_DEFINE_TYPE (GstAgingTV, gst_agingtv, GST_TYPE_VIDEO_FILTER);
 GST_ELEMENT_REGISTER_DEFINE (agingtv, "agingtv", GST_RANK_NONE,
     GST_TYPE_AGINGTV);
 
+typedef struct
+{
+  GstVideoFrame *in_frame, *out_frame;
+  gint c;
+  guint seed;
+} GstAgingTVJob;
+
+/* every row draws its noise from its own random state so that bands of rows
+ * can be aged in parallel */
 static void
-coloraging (guint32 * src, guint32 * dest, gint video_area, gint * c)
+coloraging (GstAgingTVJob * job, gint y, gint height)
 {
   guint32 a, b;
-  gint i;
-  gint c_tmp = *c;
-
-  c_tmp -= (gint) (fastrand ()) >> 28;
-  if (c_tmp < 0)
-    c_tmp = 0;
-  if (c_tmp > 0x18)
-    c_tmp = 0x18;
-
-  for (i = 0; i < video_area; i++) {
-    a = *src++;
-    b = (a & 0xfcfcfc) >> 2;
-    *dest++ =
-        a - b + (c_tmp | (c_tmp << 8) | (c_tmp << 16)) +
-        ((fastrand () >> 8) & 0x101010);
+  gint x, width = GST_VIDEO_FRAME_WIDTH (job->in_frame);
+  gint c_tmp = job->c;
+  guint seed;
+
+  for (; height > 0; y++, height--) {
+    const guint32 *src =
+        (const guint32 *) ((guint8 *) GST_VIDEO_FRAME_PLANE_DATA (job->in_frame,
+            0) + y * GST_VIDEO_FRAME_PLANE_STRIDE (job->in_frame, 0));
+    guint32 *dest =
+        (guint32 *) ((guint8 *) GST_VIDEO_FRAME_PLANE_DATA (job->out_frame,
+            0) + y * GST_VIDEO_FRAME_PLANE_STRIDE (job->out_frame, 0));
+
+    seed = fastrand_row_seed (job->seed, y);
+
+    for (x = 0; x < width; x++) {
+      a = src[x];
+      b = (a & 0xfcfcfc) >> 2;
+      dest[x] =
+          a - b + (c_tmp | (c_tmp << 8) | (c_tmp << 16)) +
+          ((fastrand_r (&seed) >> 8) & 0x101010);
+    }
   }
-  *c = c_tmp;
 }
 
 
 static void
 scratching (scratch * scratches, gint scratch_lines, guint32 * dest, gint width,
-    gint height)
+    gint height, guint * state)
 {
   gint i, y, y1, y2;
   guint32 *p, a, b;
@@ -142,7 +158,7 @@ scratching (scratch * scratches, gint scratch_lines, guint32 * dest, gint width,
       if (scratch->life) {
         y2 = height;
       } else {
-        y2 = fastrand () % height;
+        y2 = fastrand_r (state) % height;
       }
       for (y = y1; y < y2; y++) {
         a = *p & 0xfefeff;
@@ -152,11 +168,11 @@ scratching (scratch * scratches, gint scratch_lines, guint32 * dest, gint width,
         p += width;
       }
     } else {
-      if ((fastrand () & 0xf0000000) == 0) {
-        scratch->life = 2 + (fastrand () >> 27);
-        scratch->x = fastrand () % (width * 256);
-        scratch->dx = ((int) fastrand ()) >> 23;
-        scratch->init = (fastrand () % (height - 1)) + 1;
+      if ((fastrand_r (state) & 0xf0000000) == 0) {
+        scratch->life = 2 + (fastrand_r (state) >> 27);
+        scratch->x = fastrand_r (state) % (width * 256);
+        scratch->dx = ((int) fastrand_r (state)) >> 23;
+        scratch->init = (fastrand_r (state) % (height - 1)) + 1;
       }
     }
   }
@@ -164,7 +180,7 @@ scratching (scratch * scratches, gint scratch_lines, guint32 * dest, gint width,
 
 static void
 dusts (guint32 * dest, gint width, gint height, gint * dust_interval,
-    gint area_scale)
+    gint area_scale, guint * state)
 {
   gint i, j;
   gint dnum;
@@ -172,18 +188,18 @@ dusts (guint32 * dest, gint width, gint height, gint * dust_interval,
   guint x, y;
 
   if (*dust_interval == 0) {
-    if ((fastrand () & 0xf0000000) == 0) {
-      *dust_interval = fastrand () >> 29;
+    if ((fastrand_r (state) & 0xf0000000) == 0) {
+      *dust_interval = fastrand_r (state) >> 29;
     }
     return;
   }
-  dnum = area_scale * 4 + (fastrand () >> 27);
+  dnum = area_scale * 4 + (fastrand_r (state) >> 27);
 
   for (i = 0; i < dnum; i++) {
-    x = fastrand () % width;
-    y = fastrand () % height;
-    d = fastrand () >> 29;
-    len = fastrand () % area_scale + 5;
+    x = fastrand_r (state) % width;
+    y = fastrand_r (state) % height;
+    d = fastrand_r (state) >> 29;
+    len = fastrand_r (state) % area_scale + 5;
     for (j = 0; j < len; j++) {
       dest[y * width + x] = 0x101010;
       y += dy[d];
@@ -192,7 +208,7 @@ dusts (guint32 * dest, gint width, gint height, gint * dust_interval,
       if (y >= height || x >= width)
         break;
 
-      d = (d + fastrand () % 3 - 1) & 7;
+      d = (d + fastrand_r (state) % 3 - 1) & 7;
     }
   }
   *dust_interval = *dust_interval - 1;
@@ -200,7 +216,7 @@ dusts (guint32 * dest, gint width, gint height, gint * dust_interval,
 
 static void
 pits (guint32 * dest, gint width, gint height, gint area_scale,
-    gint * pits_interval)
+    gint * pits_interval, guint * state)
 {
   gint i, j;
   gint pnum, size, pnumscale;
@@ -208,25 +224,25 @@ pits (guint32 * dest, gint width, gint height, gint area_scale,
 
   pnumscale = area_scale * 2;
   if (*pits_interval) {
-    pnum = pnumscale + (fastrand () % pnumscale);
+    pnum = pnumscale + (fastrand_r (state) % pnumscale);
 
     *pits_interval = *pits_interval - 1;
   } else {
-    pnum = fastrand () % pnumscale;
+    pnum = fastrand_r (state) % pnumscale;
 
-    if ((fastrand () & 0xf8000000) == 0) {
-      *pits_interval = (fastrand () >> 28) + 20;
+    if ((fastrand_r (state) & 0xf8000000) == 0) {
+      *pits_interval = (fastrand_r (state) >> 28) + 20;
     }
   }
   for (i = 0; i < pnum; i++) {
-    x = fastrand () % (width - 1);
-    y = fastrand () % (height - 1);
+    x = fastrand_r (state) % (width - 1);
+    y = fastrand_r (state) % (height - 1);
 
-    size = fastrand () >> 28;
+    size = fastrand_r (state) >> 28;
 
     for (j = 0; j < size; j++) {
-      x = x + fastrand () % 3 - 1;
-      y = y + fastrand () % 3 - 1;
+      x = x + fastrand_r (state) % 3 - 1;
+      y = y + fastrand_r (state) % 3 - 1;
 
       if (y >= height || x >= width)
         break;
@@ -256,6 +272,9 @@ gst_agingtv_get_property (GObject * object, guint prop_id,
     case PROP_DUSTS:
       g_value_set_boolean (value, agingtv->dusts);
       break;
+    case PROP_N_THREADS:
+      g_value_set_uint (value, agingtv->n_threads);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
   }
@@ -281,6 +300,11 @@ gst_agingtv_set_property (GObject * object, guint prop_id,
     case PROP_DUSTS:
       agingtv->dusts = g_value_get_boolean (value);
       break;
+    case PROP_N_THREADS:
+      GST_OBJECT_LOCK (agingtv);
+      agingtv->n_threads = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (agingtv);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
   }
@@ -294,6 +318,7 @@ gst_agingtv_start (GstBaseTransform * trans)
   agingtv->coloraging_state = 0x18;
   agingtv->dust_interval = 0;
   agingtv->pits_interval = 0;
+  agingtv->rand = 0;
 
   memset (agingtv->scratches, 0, sizeof (agingtv->scratches));
 
@@ -307,8 +332,9 @@ gst_agingtv_transform_frame (GstVideoFilter * filter, GstVideoFrame * in_frame,
   GstAgingTV *agingtv = GST_AGINGTV (filter);
   gint area_scale;
   GstClockTime timestamp, stream_time;
-  gint width, height, stride, video_size;
-  guint32 *src, *dest;
+  gint width, height;
+  guint32 *dest;
+  guint n_threads;
 
   timestamp = GST_BUFFER_TIMESTAMP (in_frame->buffer);
   stream_time =
@@ -323,30 +349,54 @@ gst_agingtv_transform_frame (GstVideoFilter * filter, GstVideoFrame * in_frame,
 
   width = GST_VIDEO_FRAME_WIDTH (in_frame);
   height = GST_VIDEO_FRAME_HEIGHT (in_frame);
-  stride = GST_VIDEO_FRAME_PLANE_STRIDE (in_frame, 0);
-  video_size = stride * height / 4;
 
-  src = GST_VIDEO_FRAME_PLANE_DATA (in_frame, 0);
   dest = GST_VIDEO_FRAME_PLANE_DATA (out_frame, 0);
 
   area_scale = width * height / 64 / 480;
   if (area_scale <= 0)
     area_scale = 1;
 
-  if (agingtv->color_aging)
-    coloraging (src, dest, video_size, &agingtv->coloraging_state);
-  else
-    memcpy (dest, src, stride * height);
+  GST_OBJECT_LOCK (agingtv);
+  n_threads = agingtv->n_threads;
+  GST_OBJECT_UNLOCK (agingtv);
+
+  if (agingtv->color_aging) {
+    GstAgingTVJob job = { in_frame, out_frame };
+
+    job.c = agingtv->coloraging_state -
+        ((gint) (fastrand_r (&agingtv->rand)) >> 28);
+    job.c = CLAMP (job.c, 0, 0x18);
+    agingtv->coloraging_state = job.c;
+    job.seed = fastrand_r (&agingtv->rand);
+
+    gst_video_bands_process_rows (&agingtv->bands, n_threads, height, 1,
+        (GstVideoBandsRowsFunc) coloraging, &job);
+  } else {
+    gst_video_frame_copy (out_frame, in_frame);
+  }
 
-  scratching (agingtv->scratches, agingtv->scratch_lines, dest, width, height);
+  scratching (agingtv->scratches, agingtv->scratch_lines, dest, width, height,
+      &agingtv->rand);
   if (agingtv->pits)
-    pits (dest, width, height, area_scale, &agingtv->pits_interval);
+    pits (dest, width, height, area_scale, &agingtv->pits_interval,
+        &agingtv->rand);
   if (area_scale > 1 && agingtv->dusts)
-    dusts (dest, width, height, &agingtv->dust_interval, area_scale);
+    dusts (dest, width, height, &agingtv->dust_interval, area_scale,
+        &agingtv->rand);
 
   return GST_FLOW_OK;
 }
 
+static void
+gst_agingtv_finalize (GObject * object)
+{
+  GstAgingTV *agingtv = GST_AGINGTV (object);
+
+  gst_video_bands_clear (&agingtv->bands);
+
+  G_OBJECT_CLASS (gst_agingtv_parent_class)->finalize (object);
+}
+
 static void
 gst_agingtv_class_init (GstAgingTVClass * klass)
 {
@@ -357,6 +407,7 @@ gst_agingtv_class_init (GstAgingTVClass * klass)
 
   gobject_class->set_property = gst_agingtv_set_property;
   gobject_class->get_property = gst_agingtv_get_property;
+  gobject_class->finalize = gst_agingtv_finalize;
 
   g_object_class_install_property (gobject_class, PROP_SCRATCH_LINES,
       g_param_spec_uint ("scratch-lines", "Scratch Lines",
@@ -378,6 +429,20 @@ gst_agingtv_class_init (GstAgingTVClass * klass)
           "Dusts", DEFAULT_DUSTS,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | GST_PARAM_CONTROLLABLE));
 
+  /**
+   * GstAgingTV:n-threads:
+   *
+   * Maximum number of threads used to process each frame, in bands of rows.
+   * 0 uses one thread per CPU.
+   *
+   * Since: 1.24
+   */
+  g_object_class_install_property (gobject_class, PROP_N_THREADS,
+      g_param_spec_uint ("n-threads", "Threads",
+          "Maximum number of threads to use (0 = number of CPUs)", 0,
+          G_MAXINT, DEFAULT_N_THREADS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_set_static_metadata (gstelement_class, "AgingTV effect",
       "Filter/Effect/Video",
       "AgingTV adds age to video input using scratches and dust",
@@ -401,4 +466,6 @@ gst_agingtv_init (GstAgingTV * agingtv)
   agingtv->color_aging = DEFAULT_COLOR_AGING;
   agingtv->pits = DEFAULT_PITS;
   agingtv->dusts = DEFAULT_DUSTS;
+  agingtv->n_threads = DEFAULT_N_THREADS;
+  gst_video_bands_init (&agingtv->bands);
 }
@@ -31,6 +31,7 @@
 
 #include <gst/video/video.h>
 #include <gst/video/gstvideofilter.h>
+#include <gst/video-bands-private.h>
 
 G_BEGIN_DECLS
 
@@ -74,6 +75,12 @@ struct _GstAgingTV
   gint dust_interval;
   gint pits_interval;
 
+  /* fastrand_r() state of the noise, scratches, dust and pits, so that
+   * other instances don't change what this one draws */
+  guint rand;
+
+  guint n_threads;
+  GstVideoBands bands;
 };
 
 struct _GstAgingTVClass
@@ -56,6 +56,7 @@
 #define DEFAULT_CUBE_BITS   4
 #define MAX_CUBE_BITS       5
 #define MIN_CUBE_BITS       0
+#define DEFAULT_N_THREADS   1
 
 typedef enum _dice_dir
 {
@@ -88,7 +89,8 @@ GST_STATIC_PAD_TEMPLATE ("sink",
 enum
 {
   PROP_0,
-  PROP_CUBE_BITS
+  PROP_CUBE_BITS,
+  PROP_N_THREADS
 };
 
 static gboolean
@@ -100,69 +102,59 @@ gst_dicetv_set_info (GstVideoFilter * vfilter, GstCaps * incaps,
   g_free (filter->dicemap);
   filter->dicemap =
       (guint8 *) g_malloc (GST_VIDEO_INFO_WIDTH (in_info) *
-      GST_VIDEO_INFO_WIDTH (in_info));
+      GST_VIDEO_INFO_HEIGHT (in_info));
   gst_dicetv_create_map (filter, in_info);
 
   return TRUE;
 }
 
-static GstFlowReturn
-gst_dicetv_transform_frame (GstVideoFilter * vfilter, GstVideoFrame * in_frame,
-    GstVideoFrame * out_frame)
+typedef struct
 {
-  GstDiceTV *filter = GST_DICETV (vfilter);
-  guint32 *src, *dest;
-  gint i, map_x, map_y, map_i, base, dx, dy, di;
-  gint video_stride, g_cube_bits, g_cube_size;
-  gint g_map_height, g_map_width;
-  GstClockTime timestamp, stream_time;
-  const guint8 *dicemap;
-
-  timestamp = GST_BUFFER_TIMESTAMP (in_frame->buffer);
-  stream_time =
-      gst_segment_to_stream_time (&GST_BASE_TRANSFORM (vfilter)->segment,
-      GST_FORMAT_TIME, timestamp);
-
-  GST_DEBUG_OBJECT (filter, "sync to %" GST_TIME_FORMAT,
-      GST_TIME_ARGS (timestamp));
-
-  if (GST_CLOCK_TIME_IS_VALID (stream_time))
-    gst_object_sync_values (GST_OBJECT (filter), stream_time);
+  GstDiceTV *filter;
+  GstVideoFrame *in_frame, *out_frame;
+} GstDiceTVJob;
 
-  src = (guint32 *) GST_VIDEO_FRAME_PLANE_DATA (in_frame, 0);
-  dest = (guint32 *) GST_VIDEO_FRAME_PLANE_DATA (out_frame, 0);
-  video_stride = GST_VIDEO_FRAME_PLANE_STRIDE (in_frame, 0);
-
-  GST_OBJECT_LOCK (filter);
-  g_cube_bits = filter->g_cube_bits;
-  g_cube_size = filter->g_cube_size;
-  g_map_height = filter->g_map_height;
-  g_map_width = filter->g_map_width;
-
-  dicemap = filter->dicemap;
-  video_stride /= 4;
+/* Each cube only reads and writes its own square, so rows of cubes can be
+ * done in any order. */
+static void
+gst_dicetv_rows (GstDiceTVJob * job, gint map_y, gint height)
+{
+  GstDiceTV *filter = job->filter;
+  const guint32 *src = GST_VIDEO_FRAME_PLANE_DATA (job->in_frame, 0);
+  guint32 *dest = GST_VIDEO_FRAME_PLANE_DATA (job->out_frame, 0);
+  gint sstride = GST_VIDEO_FRAME_PLANE_STRIDE (job->in_frame, 0) / 4;
+  gint dstride = GST_VIDEO_FRAME_PLANE_STRIDE (job->out_frame, 0) / 4;
+  gint width = GST_VIDEO_FRAME_WIDTH (job->in_frame);
+  gint g_cube_bits = filter->g_cube_bits;
+  gint g_cube_size = filter->g_cube_size;
+  gint g_map_width = filter->g_map_width;
+  gint i, map_x, map_i, sbase, dbase, dx, dy, di;
+
+  for (; height > 0; map_y++, height--) {
+    map_i = map_y * g_map_width;
 
-  map_i = 0;
-  for (map_y = 0; map_y < g_map_height; map_y++) {
     for (map_x = 0; map_x < g_map_width; map_x++) {
-      base = (map_y << g_cube_bits) * video_stride + (map_x << g_cube_bits);
+      sbase = (map_y << g_cube_bits) * sstride + (map_x << g_cube_bits);
+      dbase = (map_y << g_cube_bits) * dstride + (map_x << g_cube_bits);
 
-      switch (dicemap[map_i]) {
+      switch (filter->dicemap[map_i]) {
         case DICE_UP:
           for (dy = 0; dy < g_cube_size; dy++) {
-            i = base + dy * video_stride;
+            i = sbase + dy * sstride;
+            di = dbase + dy * dstride;
             for (dx = 0; dx < g_cube_size; dx++) {
-              dest[i] = src[i];
+              dest[di] = src[i];
               i++;
+              di++;
             }
           }
           break;
         case DICE_LEFT:
           for (dy = 0; dy < g_cube_size; dy++) {
-            i = base + dy * video_stride;
+            i = sbase + dy * sstride;
 
             for (dx = 0; dx < g_cube_size; dx++) {
-              di = base + (dx * video_stride) + (g_cube_size - dy - 1);
+              di = dbase + (dx * dstride) + (g_cube_size - dy - 1);
               dest[di] = src[i];
               i++;
             }
@@ -170,8 +162,8 @@ gst_dicetv_transform_frame (GstVideoFilter * vfilter, GstVideoFrame * in_frame,
           break;
         case DICE_DOWN:
           for (dy = 0; dy < g_cube_size; dy++) {
-            di = base + dy * video_stride;
-            i = base + (g_cube_size - dy - 1) * video_stride + g_cube_size;
+            di = dbase + dy * dstride;
+            i = sbase + (g_cube_size - dy - 1) * sstride + g_cube_size;
             for (dx = 0; dx < g_cube_size; dx++) {
               i--;
               dest[di] = src[i];
@@ -181,9 +173,9 @@ gst_dicetv_transform_frame (GstVideoFilter * vfilter, GstVideoFrame * in_frame,
           break;
         case DICE_RIGHT:
           for (dy = 0; dy < g_cube_size; dy++) {
-            i = base + (dy * video_stride);
+            i = sbase + (dy * sstride);
             for (dx = 0; dx < g_cube_size; dx++) {
-              di = base + dy + (g_cube_size - dx - 1) * video_stride;
+              di = dbase + dy + (g_cube_size - dx - 1) * dstride;
               dest[di] = src[i];
               i++;
             }
@@ -195,6 +187,51 @@ gst_dicetv_transform_frame (GstVideoFilter * vfilter, GstVideoFrame * in_frame,
       }
       map_i++;
     }
+
+    /* the columns right of the last cube are passed through */
+    dx = g_map_width << g_cube_bits;
+    if (dx < width) {
+      for (dy = 0; dy < g_cube_size; dy++) {
+        i = ((map_y << g_cube_bits) + dy) * sstride + dx;
+        di = ((map_y << g_cube_bits) + dy) * dstride + dx;
+        memcpy (dest + di, src + i, (width - dx) * sizeof (guint32));
+      }
+    }
+  }
+}
+
+static GstFlowReturn
+gst_dicetv_transform_frame (GstVideoFilter * vfilter, GstVideoFrame * in_frame,
+    GstVideoFrame * out_frame)
+{
+  GstDiceTV *filter = GST_DICETV (vfilter);
+  GstDiceTVJob job = { filter, in_frame, out_frame };
+  GstClockTime timestamp, stream_time;
+  gint y;
+
+  timestamp = GST_BUFFER_TIMESTAMP (in_frame->buffer);
+  stream_time =
+      gst_segment_to_stream_time (&GST_BASE_TRANSFORM (vfilter)->segment,
+      GST_FORMAT_TIME, timestamp);
+
+  GST_DEBUG_OBJECT (filter, "sync to %" GST_TIME_FORMAT,
+      GST_TIME_ARGS (timestamp));
+
+  if (GST_CLOCK_TIME_IS_VALID (stream_time))
+    gst_object_sync_values (GST_OBJECT (filter), stream_time);
+
+  GST_OBJECT_LOCK (filter);
+  gst_video_bands_process_rows (&filter->bands, filter->n_threads,
+      filter->g_map_height, 1, (GstVideoBandsRowsFunc) gst_dicetv_rows, &job);
+
+  /* and so are the rows below the last row of cubes */
+  for (y = filter->g_map_height << filter->g_cube_bits;
+      y < GST_VIDEO_FRAME_HEIGHT (in_frame); y++) {
+    memcpy ((guint8 *) GST_VIDEO_FRAME_PLANE_DATA (out_frame, 0) +
+        y * GST_VIDEO_FRAME_PLANE_STRIDE (out_frame, 0),
+        (guint8 *) GST_VIDEO_FRAME_PLANE_DATA (in_frame, 0) +
+        y * GST_VIDEO_FRAME_PLANE_STRIDE (in_frame, 0),
+        GST_VIDEO_FRAME_WIDTH (in_frame) * sizeof (guint32));
   }
   GST_OBJECT_UNLOCK (filter);
 
@@ -241,6 +278,11 @@ gst_dicetv_set_property (GObject * object, guint prop_id, const GValue * value,
       gst_dicetv_create_map (filter, &GST_VIDEO_FILTER (filter)->in_info);
       GST_OBJECT_UNLOCK (filter);
       break;
+    case PROP_N_THREADS:
+      GST_OBJECT_LOCK (filter);
+      filter->n_threads = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (filter);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -257,6 +299,11 @@ gst_dicetv_get_property (GObject * object, guint prop_id, GValue * value,
     case PROP_CUBE_BITS:
       g_value_set_int (value, filter->g_cube_bits);
       break;
+    case PROP_N_THREADS:
+      GST_OBJECT_LOCK (filter);
+      g_value_set_uint (value, filter->n_threads);
+      GST_OBJECT_UNLOCK (filter);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -271,6 +318,8 @@ gst_dicetv_finalize (GObject * object)
   g_free (filter->dicemap);
   filter->dicemap = NULL;
 
+  gst_video_bands_clear (&filter->bands);
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -290,6 +339,20 @@ gst_dicetv_class_init (GstDiceTVClass * klass)
           MIN_CUBE_BITS, MAX_CUBE_BITS, DEFAULT_CUBE_BITS,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | GST_PARAM_CONTROLLABLE));
 
+  /**
+   * GstDiceTV:n-threads:
+   *
+   * Maximum number of threads used to process each frame, in bands of rows.
+   * 0 uses one thread per CPU.
+   *
+   * Since: 1.24
+   */
+  g_object_class_install_property (gobject_class, PROP_N_THREADS,
+      g_param_spec_uint ("n-threads", "Threads",
+          "Maximum number of threads to use (0 = number of CPUs)", 0,
+          G_MAXINT, DEFAULT_N_THREADS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_set_static_metadata (gstelement_class, "DiceTV effect",
       "Filter/Effect/Video",
       "'Dices' the screen up into many small squares",
@@ -313,4 +376,6 @@ gst_dicetv_init (GstDiceTV * filter)
   filter->g_cube_size = 0;
   filter->g_map_height = 0;
   filter->g_map_width = 0;
+  filter->n_threads = DEFAULT_N_THREADS;
+  gst_video_bands_init (&filter->bands);
 }
@@ -33,6 +33,7 @@
 
 #include <gst/video/video.h>
 #include <gst/video/gstvideofilter.h>
+#include <gst/video-bands-private.h>
 
 G_BEGIN_DECLS
 
@@ -61,6 +62,9 @@ struct _GstDiceTV
   gint g_cube_size;
   gint g_map_height;
   gint g_map_width;
+
+  guint n_threads;
+  GstVideoBands bands;
 };
 
 struct _GstDiceTVClass
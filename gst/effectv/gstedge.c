@@ -47,6 +47,14 @@
 #include "gstedge.h"
 #include "gsteffectv.h"
 
+enum
+{
+  PROP_0,
+  PROP_N_THREADS
+};
+
+#define DEFAULT_N_THREADS 1
+
 #define gst_edgetv_parent_class parent_class
 G_DEFINE_TYPE (GstEdgeTV, gst_edgetv, GST_TYPE_VIDEO_FILTER);
 GST_ELEMENT_REGISTER_DEFINE (edgetv, "edgetv", GST_RANK_NONE, GST_TYPE_EDGETV);
@@ -84,7 +92,6 @@ gst_edgetv_set_info (GstVideoFilter * filter, GstCaps * incaps,
 
   edgetv->map_width = width / 4;
   edgetv->map_height = height / 4;
-  edgetv->video_width_margin = width % 4;
 
   map_size = edgetv->map_width * edgetv->map_height * sizeof (guint32) * 2;
 
@@ -94,112 +101,206 @@ gst_edgetv_set_info (GstVideoFilter * filter, GstCaps * incaps,
   return TRUE;
 }
 
+/* number of 4x4 blocks handled at once by the inner loops */
+#define EDGE_BLOCK 64
+
+typedef struct
+{
+  GstEdgeTV *filter;
+  GstVideoFrame *in_frame, *out_frame;
+} GstEdgeTVJob;
+
+/* squared difference of the colour channels of @p and @q, with the low bit
+ * of each channel cleared so two values can be added with saturation */
+static inline guint32
+edge_diff (guint32 p, guint32 q)
+{
+  gint r, g, b;
+
+  r = (gint) ((p >> 16) & 0xff) - (gint) ((q >> 16) & 0xff);
+  g = (gint) ((p >> 8) & 0xff) - (gint) ((q >> 8) & 0xff);
+  b = (gint) (p & 0xff) - (gint) (q & 0xff);
+  r *= r;
+  g *= g;
+  b *= b;
+  r = r >> 5;                   /* To lack the lower bit for saturated addition,  */
+  g = g >> 5;                   /* divide the value with 32, instead of 16. It is */
+  b = b >> 4;                   /* same as `v2 &= 0xfefeff' */
+  r = MIN (r, 127);
+  g = MIN (g, 127);
+  b = MIN (b, 255);
+
+  return (r << 17) | (g << 9) | b;
+}
+
+static inline guint32
+edge_add (guint32 a, guint32 b)
+{
+  guint32 r = a + b;
+  guint32 g = r & 0x01010100;
+
+  return r | (g - (g >> 8));
+}
+
+/* The map holds the differences of the top left pixel of each 4x4 block
+ * to the block on its left and to the block above. It only depends on the
+ * current frame, so all bands fill their rows of it before any are drawn. */
+static void
+gst_edgetv_map_rows (GstEdgeTVJob * job, gint y, gint height)
+{
+  GstEdgeTV *filter = job->filter;
+  gint map_width = filter->map_width;
+  guint32 *hmap = filter->map;
+  guint32 *vmap = filter->map + map_width * filter->map_height;
+  gint stride = GST_VIDEO_FRAME_PLANE_STRIDE (job->in_frame, 0) / 4;
+  gint x, i, n, end;
+  guint32 p[EDGE_BLOCK] = { 0 }, left[EDGE_BLOCK] = { 0 };
+  guint32 up[EDGE_BLOCK] = { 0 }, h[EDGE_BLOCK], v[EDGE_BLOCK];
+
+  end = MIN (y + height, filter->map_height - 1);
+  for (y = MAX (y, 1); y < end; y++) {
+    const guint32 *src =
+        (const guint32 *) GST_VIDEO_FRAME_PLANE_DATA (job->in_frame,
+        0) + y * 4 * stride;
+
+    for (x = 1; x < map_width - 1; x += n) {
+      n = MIN (EDGE_BLOCK, map_width - 1 - x);
+
+      /* gather the top left pixels so that the arithmetic below runs on
+       * whole blocks of contiguous values */
+      left[0] = src[x * 4 - 4];
+      for (i = 0; i < n; i++) {
+        p[i] = src[(x + i) * 4];
+        up[i] = src[(x + i) * 4 - stride * 4];
+      }
+      for (i = 1; i < n; i++)
+        left[i] = p[i - 1];
+
+      for (i = 0; i < EDGE_BLOCK; i++) {
+        h[i] = edge_diff (p[i], left[i]);
+        v[i] = edge_diff (p[i], up[i]);
+      }
+
+      memcpy (hmap + y * map_width + x, h, n * sizeof (guint32));
+      memcpy (vmap + y * map_width + x, v, n * sizeof (guint32));
+    }
+  }
+}
+
+static inline void
+edge_clear (guint32 * dest, gint from, gint to, gint width)
+{
+  to = MIN (to, width);
+  if (from < to)
+    memset (dest + from, 0, (to - from) * sizeof (guint32));
+}
+
+static void
+gst_edgetv_draw_rows (GstEdgeTVJob * job, gint y, gint height)
+{
+  GstEdgeTV *filter = job->filter;
+  gint map_width = filter->map_width, map_height = filter->map_height;
+  const guint32 *hmap = filter->map;
+  const guint32 *vmap = filter->map + map_width * map_height;
+  gint width = GST_VIDEO_FRAME_WIDTH (job->out_frame);
+  gint stride = GST_VIDEO_FRAME_PLANE_STRIDE (job->out_frame, 0) / 4;
+  gint x, i, n, row, end_row;
+  guint32 v0[EDGE_BLOCK] = { 0 }, v1[EDGE_BLOCK] = { 0 };
+  guint32 v2[EDGE_BLOCK] = { 0 }, v3[EDGE_BLOCK] = { 0 };
+  guint32 a[EDGE_BLOCK], b[EDGE_BLOCK], c[EDGE_BLOCK], d[EDGE_BLOCK];
+
+  for (; height > 0; y++, height--) {
+    guint32 *dest =
+        (guint32 *) GST_VIDEO_FRAME_PLANE_DATA (job->out_frame,
+        0) + y * 4 * stride;
+
+    /* the last block row also covers the rows left over below the map */
+    end_row = y == map_height - 1 ? GST_VIDEO_FRAME_HEIGHT (job->out_frame) -
+        y * 4 : 4;
+
+    /* blocks on the edges of the map have no neighbours and stay black */
+    if (y == 0 || y == map_height - 1) {
+      for (row = 0; row < end_row; row++)
+        edge_clear (dest + row * stride, 0, width, width);
+      continue;
+    }
+
+    for (row = 0; row < 4; row++) {
+      edge_clear (dest + row * stride, 0, 4, width);
+      edge_clear (dest + row * stride, (map_width - 1) * 4, width, width);
+    }
+
+    for (x = 1; x < map_width - 1; x += n) {
+      guint32 *d0 = dest + x * 4, *d1 = d0 + stride;
+      guint32 *d2 = d1 + stride, *d3 = d2 + stride;
+
+      n = MIN (EDGE_BLOCK, map_width - 1 - x);
+
+      memcpy (v0, hmap + (y - 1) * map_width + x, n * sizeof (guint32));
+      memcpy (v1, vmap + y * map_width + x - 1, n * sizeof (guint32));
+      memcpy (v2, hmap + y * map_width + x, n * sizeof (guint32));
+      memcpy (v3, vmap + y * map_width + x, n * sizeof (guint32));
+
+      for (i = 0; i < EDGE_BLOCK; i++) {
+        a[i] = edge_add (v0[i], v1[i]);
+        b[i] = edge_add (v0[i], v3[i]);
+        c[i] = edge_add (v2[i], v1[i]);
+        d[i] = edge_add (v2[i], v3[i]);
+      }
+
+      for (i = 0; i < n; i++) {
+        d0[i * 4] = a[i];
+        d0[i * 4 + 1] = b[i];
+        d0[i * 4 + 2] = v3[i];
+        d0[i * 4 + 3] = v3[i];
+        d1[i * 4] = c[i];
+        d1[i * 4 + 1] = d[i];
+        d1[i * 4 + 2] = v3[i];
+        d1[i * 4 + 3] = v3[i];
+        d2[i * 4] = v2[i];
+        d2[i * 4 + 1] = v2[i];
+        d2[i * 4 + 2] = 0;
+        d2[i * 4 + 3] = 0;
+        d3[i * 4] = v2[i];
+        d3[i * 4 + 1] = v2[i];
+        d3[i * 4 + 2] = 0;
+        d3[i * 4 + 3] = 0;
+      }
+    }
+  }
+}
+
 static GstFlowReturn
 gst_edgetv_transform_frame (GstVideoFilter * vfilter, GstVideoFrame * in_frame,
     GstVideoFrame * out_frame)
 {
   GstEdgeTV *filter = GST_EDGETV (vfilter);
-  gint x, y, r, g, b;
-  guint32 *src, *dest;
-  guint32 p, q;
-  guint32 v0, v1, v2, v3;
-  gint width, map_height, map_width;
-  gint video_width_margin;
-  guint32 *map;
-  GstFlowReturn ret = GST_FLOW_OK;
-
-  map = filter->map;
-  map_height = filter->map_height;
-  map_width = filter->map_width;
-  video_width_margin = filter->video_width_margin;
-
-  src = GST_VIDEO_FRAME_PLANE_DATA (in_frame, 0);
-  dest = GST_VIDEO_FRAME_PLANE_DATA (out_frame, 0);
-
-  width = GST_VIDEO_FRAME_WIDTH (in_frame);
-
-  src += width * 4 + 4;
-  dest += width * 4 + 4;
-
-  for (y = 1; y < map_height - 1; y++) {
-    for (x = 1; x < map_width - 1; x++) {
-      p = *src;
-      q = *(src - 4);
-
-      /* difference between the current pixel and left neighbor. */
-      r = ((p & 0xff0000) - (q & 0xff0000)) >> 16;
-      g = ((p & 0xff00) - (q & 0xff00)) >> 8;
-      b = (p & 0xff) - (q & 0xff);
-      r *= r;
-      g *= g;
-      b *= b;
-      r = r >> 5;               /* To lack the lower bit for saturated addition,  */
-      g = g >> 5;               /* divide the value with 32, instead of 16. It is */
-      b = b >> 4;               /* same as `v2 &= 0xfefeff' */
-      if (r > 127)
-        r = 127;
-      if (g > 127)
-        g = 127;
-      if (b > 255)
-        b = 255;
-      v2 = (r << 17) | (g << 9) | b;
-
-      /* difference between the current pixel and upper neighbor. */
-      q = *(src - width * 4);
-      r = ((p & 0xff0000) - (q & 0xff0000)) >> 16;
-      g = ((p & 0xff00) - (q & 0xff00)) >> 8;
-      b = (p & 0xff) - (q & 0xff);
-      r *= r;
-      g *= g;
-      b *= b;
-      r = r >> 5;
-      g = g >> 5;
-      b = b >> 4;
-      if (r > 127)
-        r = 127;
-      if (g > 127)
-        g = 127;
-      if (b > 255)
-        b = 255;
-      v3 = (r << 17) | (g << 9) | b;
-
-      v0 = map[(y - 1) * map_width * 2 + x * 2];
-      v1 = map[y * map_width * 2 + (x - 1) * 2 + 1];
-      map[y * map_width * 2 + x * 2] = v2;
-      map[y * map_width * 2 + x * 2 + 1] = v3;
-      r = v0 + v1;
-      g = r & 0x01010100;
-      dest[0] = r | (g - (g >> 8));
-      r = v0 + v3;
-      g = r & 0x01010100;
-      dest[1] = r | (g - (g >> 8));
-      dest[2] = v3;
-      dest[3] = v3;
-      r = v2 + v1;
-      g = r & 0x01010100;
-      dest[width] = r | (g - (g >> 8));
-      r = v2 + v3;
-      g = r & 0x01010100;
-      dest[width + 1] = r | (g - (g >> 8));
-      dest[width + 2] = v3;
-      dest[width + 3] = v3;
-      dest[width * 2] = v2;
-      dest[width * 2 + 1] = v2;
-      dest[width * 2 + 2] = 0;
-      dest[width * 2 + 3] = 0;
-      dest[width * 3] = v2;
-      dest[width * 3 + 1] = v2;
-      dest[width * 3 + 2] = 0;
-      dest[width * 3 + 3] = 0;
-
-      src += 4;
-      dest += 4;
+  GstEdgeTVJob job = { filter, in_frame, out_frame };
+  guint n_threads;
+  gint y;
+
+  GST_OBJECT_LOCK (filter);
+  n_threads = filter->n_threads;
+  GST_OBJECT_UNLOCK (filter);
+
+  /* too small for a single block */
+  if (filter->map_height == 0) {
+    for (y = 0; y < GST_VIDEO_FRAME_HEIGHT (out_frame); y++) {
+      guint8 *dest = (guint8 *) GST_VIDEO_FRAME_PLANE_DATA (out_frame, 0) +
+          y * GST_VIDEO_FRAME_PLANE_STRIDE (out_frame, 0);
+
+      memset (dest, 0, GST_VIDEO_FRAME_WIDTH (out_frame) * 4);
     }
-    src += width * 3 + 8 + video_width_margin;
-    dest += width * 3 + 8 + video_width_margin;
+    return GST_FLOW_OK;
   }
 
-  return ret;
+  gst_video_bands_process_rows (&filter->bands, n_threads,
+      filter->map_height, 1, (GstVideoBandsRowsFunc) gst_edgetv_map_rows, &job);
+  gst_video_bands_process_rows (&filter->bands, n_threads,
+      filter->map_height, 1, (GstVideoBandsRowsFunc) gst_edgetv_draw_rows,
+      &job);
+
+  return GST_FLOW_OK;
 }
 
 static gboolean
@@ -220,10 +321,47 @@ gst_edgetv_finalize (GObject * object)
 
   g_free (edgetv->map);
   edgetv->map = NULL;
+  gst_video_bands_clear (&edgetv->bands);
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
+static void
+gst_edgetv_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstEdgeTV *edgetv = GST_EDGETV (object);
+
+  switch (prop_id) {
+    case PROP_N_THREADS:
+      GST_OBJECT_LOCK (edgetv);
+      edgetv->n_threads = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (edgetv);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_edgetv_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstEdgeTV *edgetv = GST_EDGETV (object);
+
+  switch (prop_id) {
+    case PROP_N_THREADS:
+      GST_OBJECT_LOCK (edgetv);
+      g_value_set_uint (value, edgetv->n_threads);
+      GST_OBJECT_UNLOCK (edgetv);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
 static void
 gst_edgetv_class_init (GstEdgeTVClass * klass)
 {
@@ -232,8 +370,24 @@ gst_edgetv_class_init (GstEdgeTVClass * klass)
   GstBaseTransformClass *trans_class = (GstBaseTransformClass *) klass;
   GstVideoFilterClass *vfilter_class = (GstVideoFilterClass *) klass;
 
+  gobject_class->set_property = gst_edgetv_set_property;
+  gobject_class->get_property = gst_edgetv_get_property;
   gobject_class->finalize = gst_edgetv_finalize;
 
+  /**
+   * GstEdgeTV:n-threads:
+   *
+   * Maximum number of threads used to process each frame, in bands of rows.
+   * 0 uses one thread per CPU.
+   *
+   * Since: 1.24
+   */
+  g_object_class_install_property (gobject_class, PROP_N_THREADS,
+      g_param_spec_uint ("n-threads", "Threads",
+          "Maximum number of threads to use (0 = number of CPUs)", 0,
+          G_MAXINT, DEFAULT_N_THREADS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_set_static_metadata (gstelement_class, "EdgeTV effect",
       "Filter/Effect/Video",
       "Apply edge detect on video", "Wim Taymans <wim.taymans@chello.be>");
@@ -253,4 +407,6 @@ gst_edgetv_class_init (GstEdgeTVClass * klass)
 static void
 gst_edgetv_init (GstEdgeTV * edgetv)
 {
+  edgetv->n_threads = DEFAULT_N_THREADS;
+  gst_video_bands_init (&edgetv->bands);
 }
@@ -31,6 +31,7 @@
 
 #include <gst/video/video.h>
 #include <gst/video/gstvideofilter.h>
+#include <gst/video-bands-private.h>
 
 G_BEGIN_DECLS
 
@@ -55,7 +56,9 @@ struct _GstEdgeTV
   /* < private > */
   gint map_width, map_height;
   guint32 *map;
-  gint video_width_margin;
+
+  guint n_threads;
+  GstVideoBands bands;
 };
 
 struct _GstEdgeTVClass
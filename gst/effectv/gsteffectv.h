@@ -44,3 +44,27 @@ fastrand (void)
   return (fastrand_val = fastrand_val * 1103515245 + 12345);
 }
 
+/* same as fastrand() with the state in @val, for bands of rows that are
+ * processed in parallel */
+static inline guint
+fastrand_r (guint * val)
+{
+  return (*val = *val * 1103515245 + 12345);
+}
+
+/* initial fastrand_r() state for row @y of a frame, so that the random
+ * numbers don't depend on how the frame was split into bands */
+static inline guint
+fastrand_row_seed (guint seed, gint y)
+{
+  guint h = seed ^ ((guint) y * 0x9e3779b9);
+
+  h ^= h >> 16;
+  h *= 0x85ebca6b;
+  h ^= h >> 13;
+  h *= 0xc2b2ae35;
+  h ^= h >> 16;
+
+  return h;
+}
+
@@ -83,13 +83,15 @@ gst_optv_mode_get_type (void)
 #define DEFAULT_MODE OP_SPIRAL1
 #define DEFAULT_SPEED 16
 #define DEFAULT_THRESHOLD 60
+#define DEFAULT_N_THREADS 1
 
 enum
 {
   PROP_0,
   PROP_MODE,
   PROP_SPEED,
-  PROP_THRESHOLD
+  PROP_THRESHOLD,
+  PROP_N_THREADS
 };
 
 static guint32 palette[256];
@@ -199,17 +201,45 @@ image_y_over (guint32 * src, guint8 * diff, gint y_threshold, gint video_area)
   }
 }
 
+typedef struct
+{
+  GstOpTV *filter;
+  GstVideoFrame *in_frame, *out_frame;
+  const gint8 *opmap;
+  guint8 phase;
+} GstOpTVJob;
+
+static void
+gst_optv_rows (GstOpTVJob * job, gint y, gint height)
+{
+  gint x, width = GST_VIDEO_FRAME_WIDTH (job->in_frame);
+  gint sstride = GST_VIDEO_FRAME_PLANE_STRIDE (job->in_frame, 0) / 4;
+  gint dstride = GST_VIDEO_FRAME_PLANE_STRIDE (job->out_frame, 0) / 4;
+  guint8 phase = job->phase;
+
+  for (; height > 0; y++, height--) {
+    guint32 *src =
+        (guint32 *) GST_VIDEO_FRAME_PLANE_DATA (job->in_frame, 0) + y * sstride;
+    guint32 *dest =
+        (guint32 *) GST_VIDEO_FRAME_PLANE_DATA (job->out_frame,
+        0) + y * dstride;
+    const gint8 *p = job->opmap + y * width;
+    guint8 *diff = job->filter->diff + y * width;
+
+    image_y_over (src, diff, job->filter->threshold, width);
+
+    for (x = 0; x < width; x++)
+      dest[x] = palette[(((guint8) (p[x] + phase)) ^ diff[x]) & 255];
+  }
+}
+
 static GstFlowReturn
 gst_optv_transform_frame (GstVideoFilter * vfilter, GstVideoFrame * in_frame,
     GstVideoFrame * out_frame)
 {
   GstOpTV *filter = GST_OPTV (vfilter);
-  guint32 *src, *dest;
-  gint8 *p;
-  guint8 *diff;
-  gint x, y, width, height;
+  GstOpTVJob job = { filter, in_frame, out_frame };
   GstClockTime timestamp, stream_time;
-  guint8 phase;
 
   timestamp = GST_BUFFER_TIMESTAMP (in_frame->buffer);
   stream_time =
@@ -225,41 +255,29 @@ gst_optv_transform_frame (GstVideoFilter * vfilter, GstVideoFrame * in_frame,
   if (G_UNLIKELY (filter->opmap[0] == NULL))
     return GST_FLOW_NOT_NEGOTIATED;
 
-  src = GST_VIDEO_FRAME_PLANE_DATA (in_frame, 0);
-  dest = GST_VIDEO_FRAME_PLANE_DATA (out_frame, 0);
-
-  width = GST_VIDEO_FRAME_WIDTH (in_frame);
-  height = GST_VIDEO_FRAME_HEIGHT (in_frame);
-
   GST_OBJECT_LOCK (filter);
   switch (filter->mode) {
     default:
     case 0:
-      p = filter->opmap[OP_SPIRAL1];
+      job.opmap = filter->opmap[OP_SPIRAL1];
       break;
     case 1:
-      p = filter->opmap[OP_SPIRAL2];
+      job.opmap = filter->opmap[OP_SPIRAL2];
       break;
     case 2:
-      p = filter->opmap[OP_PARABOLA];
+      job.opmap = filter->opmap[OP_PARABOLA];
       break;
     case 3:
-      p = filter->opmap[OP_HSTRIPE];
+      job.opmap = filter->opmap[OP_HSTRIPE];
       break;
   }
 
   filter->phase -= filter->speed;
+  job.phase = filter->phase;
 
-  diff = filter->diff;
-  image_y_over (src, diff, filter->threshold, width * height);
-  phase = filter->phase;
-
-  for (y = 0; y < height; y++) {
-    for (x = 0; x < width; x++) {
-      *dest++ = palette[(((guint8) (*p + phase)) ^ *diff++) & 255];
-      p++;
-    }
-  }
+  gst_video_bands_process_rows (&filter->bands, filter->n_threads,
+      GST_VIDEO_FRAME_HEIGHT (in_frame), 1,
+      (GstVideoBandsRowsFunc) gst_optv_rows, &job);
   GST_OBJECT_UNLOCK (filter);
 
   return GST_FLOW_OK;
@@ -314,6 +332,8 @@ gst_optv_finalize (GObject * object)
   g_free (filter->diff);
   filter->diff = NULL;
 
+  gst_video_bands_clear (&filter->bands);
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -334,6 +354,9 @@ gst_optv_set_property (GObject * object, guint prop_id, const GValue * value,
     case PROP_THRESHOLD:
       filter->threshold = g_value_get_uint (value);
       break;
+    case PROP_N_THREADS:
+      filter->n_threads = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -357,6 +380,11 @@ gst_optv_get_property (GObject * object, guint prop_id, GValue * value,
     case PROP_THRESHOLD:
       g_value_set_uint (value, filter->threshold);
       break;
+    case PROP_N_THREADS:
+      GST_OBJECT_LOCK (filter);
+      g_value_set_uint (value, filter->n_threads);
+      GST_OBJECT_UNLOCK (filter);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -391,6 +419,20 @@ gst_optv_class_init (GstOpTVClass * klass)
           "Luma threshold", 0, G_MAXINT, DEFAULT_THRESHOLD,
           GST_PARAM_CONTROLLABLE | G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstOpTV:n-threads:
+   *
+   * Maximum number of threads used to process each frame, in bands of rows.
+   * 0 uses one thread per CPU.
+   *
+   * Since: 1.24
+   */
+  g_object_class_install_property (gobject_class, PROP_N_THREADS,
+      g_param_spec_uint ("n-threads", "Threads",
+          "Maximum number of threads to use (0 = number of CPUs)", 0,
+          G_MAXINT, DEFAULT_N_THREADS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_set_static_metadata (gstelement_class, "OpTV effect",
       "Filter/Effect/Video",
       "Optical art meets real-time video effect",
@@ -418,4 +460,6 @@ gst_optv_init (GstOpTV * filter)
   filter->speed = DEFAULT_SPEED;
   filter->mode = DEFAULT_MODE;
   filter->threshold = DEFAULT_THRESHOLD;
+  filter->n_threads = DEFAULT_N_THREADS;
+  gst_video_bands_init (&filter->bands);
 }
@@ -52,10 +52,13 @@
 /* This number also must be 2^n just for the speed. */
 #define PLANES 16
 
+#define DEFAULT_N_THREADS 1
+
 enum
 {
   PROP_0,
-  PROP_PLANES
+  PROP_PLANES,
+  PROP_N_THREADS
 };
 
 #define gst_quarktv_parent_class parent_class
@@ -84,27 +87,65 @@ gst_quarktv_set_info (GstVideoFilter * vfilter, GstCaps * incaps,
     GstVideoInfo * in_info, GstCaps * outcaps, GstVideoInfo * out_info)
 {
   GstQuarkTV *filter = GST_QUARKTV (vfilter);
-  gint width, height;
-
-  width = GST_VIDEO_INFO_WIDTH (in_info);
-  height = GST_VIDEO_INFO_HEIGHT (in_info);
 
   gst_quarktv_planetable_clear (filter);
-  filter->area = width * height;
 
   return TRUE;
 }
 
+typedef struct
+{
+  GstVideoFrame *in_frame, *out_frame;
+  /* the planes, with a NULL buffer for planes that are not filled yet */
+  GstVideoFrame *frames;
+  gint planes, current_plane;
+  guint seed;
+} GstQuarkTVJob;
+
+static void
+gst_quarktv_rows (GstQuarkTVJob * job, gint y, gint height)
+{
+  gint x, width = GST_VIDEO_FRAME_WIDTH (job->in_frame);
+  guint seed;
+
+  for (; height > 0; y++, height--) {
+    const guint32 *src =
+        (const guint32 *) ((guint8 *) GST_VIDEO_FRAME_PLANE_DATA (job->in_frame,
+            0) + y * GST_VIDEO_FRAME_PLANE_STRIDE (job->in_frame, 0));
+    guint32 *dest =
+        (guint32 *) ((guint8 *) GST_VIDEO_FRAME_PLANE_DATA (job->out_frame,
+            0) + y * GST_VIDEO_FRAME_PLANE_STRIDE (job->out_frame, 0));
+
+    seed = fastrand_row_seed (job->seed, y);
+
+    /* For each pixel */
+    for (x = 0; x < width; x++) {
+      GstVideoFrame *rand;
+
+      /* pick a random buffer */
+      rand = &job->frames[(job->current_plane +
+              (fastrand_r (&seed) >> 24)) % job->planes];
+
+      /* Copy the pixel from the random buffer to dest */
+      if (rand->buffer)
+        dest[x] = ((const guint32 *) ((guint8 *)
+                GST_VIDEO_FRAME_PLANE_DATA (rand, 0) +
+                y * GST_VIDEO_FRAME_PLANE_STRIDE (rand, 0)))[x];
+      else
+        dest[x] = src[x];
+    }
+  }
+}
+
 static GstFlowReturn
 gst_quarktv_transform_frame (GstVideoFilter * vfilter, GstVideoFrame * in_frame,
     GstVideoFrame * out_frame)
 {
   GstQuarkTV *filter = GST_QUARKTV (vfilter);
-  gint area;
-  guint32 *src, *dest;
+  GstQuarkTVJob job = { in_frame, out_frame };
   GstClockTime timestamp;
   GstBuffer **planetable;
-  gint planes, current_plane;
+  gint i, planes, current_plane;
 
   timestamp = GST_BUFFER_TIMESTAMP (in_frame->buffer);
   timestamp =
@@ -120,11 +161,7 @@ gst_quarktv_transform_frame (GstVideoFilter * vfilter, GstVideoFrame * in_frame,
   if (G_UNLIKELY (filter->planetable == NULL))
     return GST_FLOW_FLUSHING;
 
-  src = GST_VIDEO_FRAME_PLANE_DATA (in_frame, 0);
-  dest = GST_VIDEO_FRAME_PLANE_DATA (out_frame, 0);
-
   GST_OBJECT_LOCK (filter);
-  area = filter->area;
   planetable = filter->planetable;
   planes = filter->planes;
   current_plane = filter->current_plane;
@@ -133,19 +170,26 @@ gst_quarktv_transform_frame (GstVideoFilter * vfilter, GstVideoFrame * in_frame,
     gst_buffer_unref (planetable[current_plane]);
   planetable[current_plane] = gst_buffer_ref (in_frame->buffer);
 
-  /* For each pixel */
-  while (--area) {
-    GstBuffer *rand;
+  /* map all planes once instead of extracting every pixel from them */
+  job.frames = g_new0 (GstVideoFrame, planes);
+  for (i = 0; i < planes; i++) {
+    if (planetable[i] && !gst_video_frame_map (&job.frames[i],
+            &vfilter->in_info, planetable[i], GST_MAP_READ))
+      job.frames[i].buffer = NULL;
+  }
+  job.planes = planes;
+  job.current_plane = current_plane;
+  job.seed = fastrand_r (&filter->rand);
 
-    /* pick a random buffer */
-    rand = planetable[(current_plane + (fastrand () >> 24)) % planes];
+  gst_video_bands_process_rows (&filter->bands, filter->n_threads,
+      GST_VIDEO_FRAME_HEIGHT (in_frame), 1,
+      (GstVideoBandsRowsFunc) gst_quarktv_rows, &job);
 
-    /* Copy the pixel from the random buffer to dest, FIXME, slow */
-    if (rand)
-      gst_buffer_extract (rand, area * 4, &dest[area], 4);
-    else
-      dest[area] = src[area];
+  for (i = 0; i < planes; i++) {
+    if (job.frames[i].buffer)
+      gst_video_frame_unmap (&job.frames[i]);
   }
+  g_free (job.frames);
 
   filter->current_plane--;
   if (filter->current_plane < 0)
@@ -182,6 +226,7 @@ gst_quarktv_start (GstBaseTransform * trans)
   }
   filter->planetable =
       (GstBuffer **) g_malloc0 (filter->planes * sizeof (GstBuffer *));
+  filter->rand = 0;
 
   return TRUE;
 }
@@ -197,6 +242,8 @@ gst_quarktv_finalize (GObject * object)
     filter->planetable = NULL;
   }
 
+  gst_video_bands_clear (&filter->bands);
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -236,6 +283,9 @@ gst_quarktv_set_property (GObject * object, guint prop_id, const GValue * value,
       }
       break;
     }
+    case PROP_N_THREADS:
+      filter->n_threads = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -253,6 +303,11 @@ gst_quarktv_get_property (GObject * object, guint prop_id, GValue * value,
     case PROP_PLANES:
       g_value_set_int (value, filter->planes);
       break;
+    case PROP_N_THREADS:
+      GST_OBJECT_LOCK (filter);
+      g_value_set_uint (value, filter->n_threads);
+      GST_OBJECT_UNLOCK (filter);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -277,6 +332,20 @@ gst_quarktv_class_init (GstQuarkTVClass * klass)
           "Number of planes", 1, 64, PLANES,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | GST_PARAM_CONTROLLABLE));
 
+  /**
+   * GstQuarkTV:n-threads:
+   *
+   * Maximum number of threads used to process each frame, in bands of rows.
+   * 0 uses one thread per CPU.
+   *
+   * Since: 1.24
+   */
+  g_object_class_install_property (gobject_class, PROP_N_THREADS,
+      g_param_spec_uint ("n-threads", "Threads",
+          "Maximum number of threads to use (0 = number of CPUs)", 0,
+          G_MAXINT, DEFAULT_N_THREADS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_set_static_metadata (gstelement_class, "QuarkTV effect",
       "Filter/Effect/Video",
       "Motion dissolver", "FUKUCHI, Kentarou <fukuchi@users.sourceforge.net>");
@@ -298,4 +367,6 @@ gst_quarktv_init (GstQuarkTV * filter)
 {
   filter->planes = PLANES;
   filter->current_plane = filter->planes - 1;
+  filter->n_threads = DEFAULT_N_THREADS;
+  gst_video_bands_init (&filter->bands);
 }
@@ -31,6 +31,7 @@
 
 #include <gst/video/video.h>
 #include <gst/video/gstvideofilter.h>
+#include <gst/video-bands-private.h>
 
 G_BEGIN_DECLS
 
@@ -53,10 +54,15 @@ struct _GstQuarkTV
   GstVideoFilter element;
 
   /* < private > */
-  gint area;
   gint planes;
   gint current_plane;
   GstBuffer **planetable;
+
+  /* state for picking the planes, reset on start */
+  guint rand;
+
+  guint n_threads;
+  GstVideoBands bands;
 };
 
 struct _GstQuarkTVClass
@@ -115,6 +115,7 @@ gst_radioactv_color_get_type (void)
 #define DEFAULT_COLOR COLOR_WHITE
 #define DEFAULT_INTERVAL 3
 #define DEFAULT_TRIGGER FALSE
+#define DEFAULT_N_THREADS 1
 
 enum
 {
@@ -122,7 +123,8 @@ enum
   PROP_MODE,
   PROP_COLOR,
   PROP_INTERVAL,
-  PROP_TRIGGER
+  PROP_TRIGGER,
+  PROP_N_THREADS
 };
 
 #define COLORS 32
@@ -228,22 +230,93 @@ setTable (GstRadioacTV * filter)
 #undef VIDEO_HWIDTH
 #undef VIDEO_HHEIGHT
 
+typedef struct
+{
+  GstRadioacTV *filter;
+  GstVideoFrame *in_frame, *out_frame;
+  /* add the motion of this frame to the light, and keep the frame */
+  gboolean accumulate, snap;
+  const guint32 *palette;
+  /* the frame the light is added to, with its stride in pixels */
+  const guint32 *src;
+  gint sstride;
+} GstRadioacTVJob;
+
+/* Background image is refreshed every frame */
+static void
+image_bgsubtract_update_y (const guint32 * src, gint16 * background,
+    guint8 * diff, gint video_area, gint y_threshold)
+{
+  gint i;
+  gint R, G, B;
+  const guint32 *p;
+  gint16 *q;
+  guint8 *r;
+  gint v;
+
+  p = src;
+  q = background;
+  r = diff;
+  for (i = 0; i < video_area; i++) {
+    R = ((*p) & 0xff0000) >> (16 - 1);
+    G = ((*p) & 0xff00) >> (8 - 2);
+    B = (*p) & 0xff;
+    v = (R + G + B) - (gint) (*q);
+    *q = (gint16) (R + G + B);
+    *r = ((v + y_threshold) >> 24) | ((y_threshold - v) >> 24);
+
+    p++;
+    q++;
+    r++;
+  }
+}
+
 static void
-blur (GstRadioacTV * filter)
+bgsubtract (GstRadioacTVJob * job, gint y, gint height)
 {
-  gint x, y;
+  GstRadioacTV *filter = job->filter;
+  gint x, width = GST_VIDEO_FRAME_WIDTH (job->in_frame);
+  guint8 *diff, *p;
+
+  for (; height > 0; y++, height--) {
+    const guint32 *src =
+        (const guint32 *) ((guint8 *) GST_VIDEO_FRAME_PLANE_DATA (job->in_frame,
+            0) + y * GST_VIDEO_FRAME_PLANE_STRIDE (job->in_frame, 0));
+
+    diff = filter->diff + y * width;
+    image_bgsubtract_update_y (src, filter->background + y * width, diff,
+        width, MAGIC_THRESHOLD * 7);
+
+    if (job->accumulate) {
+      diff += filter->buf_margin_left;
+      p = filter->blurzoombuf + y * filter->buf_width;
+      for (x = 0; x < filter->buf_width; x++) {
+        p[x] |= diff[x] >> 3;
+      }
+      if (job->snap) {
+        memcpy (filter->snapframe + y * width, src, width * 4);
+      }
+    }
+  }
+}
+
+/* blurs the rows of the first half of blurzoombuf into the second half */
+static void
+blur (GstRadioacTVJob * job, gint y, gint height)
+{
+  GstRadioacTV *filter = job->filter;
+  gint x, end;
   gint width;
   guint8 *p, *q;
   guint8 v;
-  GstVideoInfo *info;
-
-  info = &GST_VIDEO_FILTER (filter)->in_info;
 
   width = filter->buf_width;
-  p = filter->blurzoombuf + GST_VIDEO_INFO_WIDTH (info) + 1;
-  q = p + filter->buf_area;
+  end = MIN (y + height, filter->buf_height - 1);
+
+  for (y = MAX (y, 1); y < end; y++) {
+    p = filter->blurzoombuf + y * width + 1;
+    q = p + filter->buf_area;
 
-  for (y = filter->buf_height - 2; y > 0; y--) {
     for (x = width - 2; x > 0; x--) {
       v = (*(p - width) + *(p - 1) + *(p + 1) + *(p + width)) / 4 - 1;
       if (v == 255)
@@ -252,25 +325,35 @@ blur (GstRadioacTV * filter)
       p++;
       q++;
     }
-    p += 2;
-    q += 2;
   }
 }
 
+/* zooms the second half of blurzoombuf back into the first half */
 static void
-zoom (GstRadioacTV * filter)
+zoom (GstRadioacTVJob * job, gint y, gint height)
 {
-  gint b, x, y;
+  GstRadioacTV *filter = job->filter;
+  gint b, x, i;
   guint8 *p, *q;
-  gint blocks, height;
-  gint dx;
+  gint blocks, row_step;
+  guint dx;
 
-  p = filter->blurzoombuf + filter->buf_area;
-  q = filter->blurzoombuf;
-  height = filter->buf_height;
   blocks = filter->buf_width_blocks;
 
-  for (y = 0; y < height; y++) {
+  /* every row moves p on by the number of bits set in blurzoomx, so the
+   * position at the start of the band can be computed directly */
+  row_step = 0;
+  for (b = 0; b < blocks; b++) {
+    for (dx = filter->blurzoomx[b]; dx; dx >>= 1)
+      row_step += dx & 1;
+  }
+
+  p = filter->blurzoombuf + filter->buf_area;
+  for (i = 0; i < y; i++)
+    p += filter->blurzoomy[i] + row_step;
+  q = filter->blurzoombuf + y * filter->buf_width;
+
+  for (; height > 0; y++, height--) {
     p += filter->blurzoomy[y];
     for (b = 0; b < blocks; b++) {
       dx = filter->blurzoomx[b];
@@ -284,38 +367,35 @@ zoom (GstRadioacTV * filter)
 }
 
 static void
-blurzoomcore (GstRadioacTV * filter)
+compose (GstRadioacTVJob * job, gint y, gint height)
 {
-  blur (filter);
-  zoom (filter);
-}
+  GstRadioacTV *filter = job->filter;
+  const guint32 *palette = job->palette;
+  gint x;
+  guint32 a, b;
+  const guint8 *p;
 
-/* Background image is refreshed every frame */
-static void
-image_bgsubtract_update_y (guint32 * src, gint16 * background, guint8 * diff,
-    gint video_area, gint y_threshold)
-{
-  gint i;
-  gint R, G, B;
-  guint32 *p;
-  gint16 *q;
-  guint8 *r;
-  gint v;
+  for (; height > 0; y++, height--) {
+    const guint32 *src = job->src + y * job->sstride;
+    guint32 *dest =
+        (guint32 *) ((guint8 *) GST_VIDEO_FRAME_PLANE_DATA (job->out_frame,
+            0) + y * GST_VIDEO_FRAME_PLANE_STRIDE (job->out_frame, 0));
 
-  p = src;
-  q = background;
-  r = diff;
-  for (i = 0; i < video_area; i++) {
-    R = ((*p) & 0xff0000) >> (16 - 1);
-    G = ((*p) & 0xff00) >> (8 - 2);
-    B = (*p) & 0xff;
-    v = (R + G + B) - (gint) (*q);
-    *q = (gint16) (R + G + B);
-    *r = ((v + y_threshold) >> 24) | ((y_threshold - v) >> 24);
+    p = filter->blurzoombuf + y * filter->buf_width;
 
-    p++;
-    q++;
-    r++;
+    for (x = 0; x < filter->buf_margin_left; x++) {
+      *dest++ = *src++;
+    }
+    for (x = 0; x < filter->buf_width; x++) {
+      a = *src++ & 0xfefeff;
+      b = palette[*p++];
+      a += b;
+      b = a & 0x1010100;
+      *dest++ = a | (b - (b >> 8));
+    }
+    for (x = 0; x < filter->buf_margin_right; x++) {
+      *dest++ = *src++;
+    }
   }
 }
 
@@ -324,12 +404,9 @@ gst_radioactv_transform_frame (GstVideoFilter * vfilter,
     GstVideoFrame * in_frame, GstVideoFrame * out_frame)
 {
   GstRadioacTV *filter = GST_RADIOACTV (vfilter);
-  guint32 *src, *dest;
+  GstRadioacTVJob job = { filter, in_frame, out_frame };
   GstClockTime timestamp, stream_time;
-  gint x, y, width, height;
-  guint32 a, b;
-  guint8 *diff, *p;
-  guint32 *palette;
+  gint height;
 
   timestamp = GST_BUFFER_TIMESTAMP (in_frame->buffer);
   stream_time =
@@ -342,72 +419,49 @@ gst_radioactv_transform_frame (GstVideoFilter * vfilter,
   if (GST_CLOCK_TIME_IS_VALID (stream_time))
     gst_object_sync_values (GST_OBJECT (filter), stream_time);
 
-  src = GST_VIDEO_FRAME_PLANE_DATA (in_frame, 0);
-  dest = GST_VIDEO_FRAME_PLANE_DATA (out_frame, 0);
-
-  width = GST_VIDEO_FRAME_WIDTH (in_frame);
   height = GST_VIDEO_FRAME_HEIGHT (in_frame);
 
   GST_OBJECT_LOCK (filter);
 #if G_BYTE_ORDER == G_LITTLE_ENDIAN
   if (GST_VIDEO_FRAME_FORMAT (in_frame) == GST_VIDEO_FORMAT_RGBx) {
-    palette = &palettes[COLORS * filter->color];
+    job.palette = &palettes[COLORS * filter->color];
   } else {
-    palette = &palettes[COLORS * swap_tab[filter->color]];
+    job.palette = &palettes[COLORS * swap_tab[filter->color]];
   }
 #else
   if (GST_VIDEO_FRAME_FORMAT (in_frame) == GST_VIDEO_FORMAT_xBGR) {
-    palette = &palettes[COLORS * filter->color];
+    job.palette = &palettes[COLORS * filter->color];
   } else {
-    palette = &palettes[COLORS * swap_tab[filter->color]];
+    job.palette = &palettes[COLORS * swap_tab[filter->color]];
   }
 #endif
-  diff = filter->diff;
 
   if (filter->mode == 3 && filter->trigger)
     filter->snaptime = 0;
   else if (filter->mode == 3 && !filter->trigger)
     filter->snaptime = 1;
 
+  /* every step reads rows of the previous one that other bands wrote */
   if (filter->mode != 2 || filter->snaptime <= 0) {
-    image_bgsubtract_update_y (src, filter->background, diff,
-        width * height, MAGIC_THRESHOLD * 7);
-    if (filter->mode == 0 || filter->snaptime <= 0) {
-      diff += filter->buf_margin_left;
-      p = filter->blurzoombuf;
-      for (y = 0; y < filter->buf_height; y++) {
-        for (x = 0; x < filter->buf_width; x++) {
-          p[x] |= diff[x] >> 3;
-        }
-        diff += width;
-        p += filter->buf_width;
-      }
-      if (filter->mode == 1 || filter->mode == 2) {
-        memcpy (filter->snapframe, src, width * height * 4);
-      }
-    }
+    job.accumulate = filter->mode == 0 || filter->snaptime <= 0;
+    job.snap = filter->mode == 1 || filter->mode == 2;
+    gst_video_bands_process_rows (&filter->bands, filter->n_threads, height,
+        1, (GstVideoBandsRowsFunc) bgsubtract, &job);
   }
-  blurzoomcore (filter);
+  gst_video_bands_process_rows (&filter->bands, filter->n_threads,
+      filter->buf_height, 1, (GstVideoBandsRowsFunc) blur, &job);
+  gst_video_bands_process_rows (&filter->bands, filter->n_threads,
+      filter->buf_height, 1, (GstVideoBandsRowsFunc) zoom, &job);
 
   if (filter->mode == 1 || filter->mode == 2) {
-    src = filter->snapframe;
-  }
-  p = filter->blurzoombuf;
-  for (y = 0; y < height; y++) {
-    for (x = 0; x < filter->buf_margin_left; x++) {
-      *dest++ = *src++;
-    }
-    for (x = 0; x < filter->buf_width; x++) {
-      a = *src++ & 0xfefeff;
-      b = palette[*p++];
-      a += b;
-      b = a & 0x1010100;
-      *dest++ = a | (b - (b >> 8));
-    }
-    for (x = 0; x < filter->buf_margin_right; x++) {
-      *dest++ = *src++;
-    }
+    job.src = filter->snapframe;
+    job.sstride = GST_VIDEO_FRAME_WIDTH (in_frame);
+  } else {
+    job.src = GST_VIDEO_FRAME_PLANE_DATA (in_frame, 0);
+    job.sstride = GST_VIDEO_FRAME_PLANE_STRIDE (in_frame, 0) / 4;
   }
+  gst_video_bands_process_rows (&filter->bands, filter->n_threads, height, 1,
+      (GstVideoBandsRowsFunc) compose, &job);
 
   if (filter->mode == 1 || filter->mode == 2) {
     filter->snaptime--;
@@ -439,7 +493,7 @@ gst_radioactv_set_info (GstVideoFilter * vfilter, GstCaps * incaps,
   filter->buf_area = filter->buf_height * filter->buf_width;
   filter->buf_margin_left = (width - filter->buf_width) / 2;
   filter->buf_margin_right =
-      height - filter->buf_width - filter->buf_margin_left;
+      width - filter->buf_width - filter->buf_margin_left;
 
   g_free (filter->blurzoombuf);
   filter->blurzoombuf = g_new0 (guint8, filter->buf_area * 2);
@@ -504,6 +558,8 @@ gst_radioactv_finalize (GObject * object)
   g_free (filter->blurzoomy);
   filter->blurzoomy = NULL;
 
+  gst_video_bands_clear (&filter->bands);
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -529,6 +585,9 @@ gst_radioactv_set_property (GObject * object, guint prop_id,
     case PROP_TRIGGER:
       filter->trigger = g_value_get_boolean (value);
       break;
+    case PROP_N_THREADS:
+      filter->n_threads = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -555,6 +614,11 @@ gst_radioactv_get_property (GObject * object, guint prop_id,
     case PROP_TRIGGER:
       g_value_set_boolean (value, filter->trigger);
       break;
+    case PROP_N_THREADS:
+      GST_OBJECT_LOCK (filter);
+      g_value_set_uint (value, filter->n_threads);
+      GST_OBJECT_UNLOCK (filter);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -594,6 +658,20 @@ gst_radioactv_class_init (GstRadioacTVClass * klass)
           "Trigger (in trigger mode)", DEFAULT_TRIGGER,
           GST_PARAM_CONTROLLABLE | G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstRadioacTV:n-threads:
+   *
+   * Maximum number of threads used to process each frame, in bands of rows.
+   * 0 uses one thread per CPU.
+   *
+   * Since: 1.24
+   */
+  g_object_class_install_property (gobject_class, PROP_N_THREADS,
+      g_param_spec_uint ("n-threads", "Threads",
+          "Maximum number of threads to use (0 = number of CPUs)", 0,
+          G_MAXINT, DEFAULT_N_THREADS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_set_static_metadata (gstelement_class, "RadioacTV effect",
       "Filter/Effect/Video",
       "motion-enlightment effect",
@@ -624,4 +702,6 @@ gst_radioactv_init (GstRadioacTV * filter)
   filter->color = DEFAULT_COLOR;
   filter->interval = DEFAULT_INTERVAL;
   filter->trigger = DEFAULT_TRIGGER;
+  filter->n_threads = DEFAULT_N_THREADS;
+  gst_video_bands_init (&filter->bands);
 }
@@ -31,6 +31,7 @@
 
 #include <gst/video/video.h>
 #include <gst/video/gstvideofilter.h>
+#include <gst/video-bands-private.h>
 
 G_BEGIN_DECLS
 
@@ -73,6 +74,9 @@ struct _GstRadioacTV
   gint buf_area;
   gint buf_margin_right;
   gint buf_margin_left;
+
+  guint n_threads;
+  GstVideoBands bands;
 };
 
 struct _GstRadioacTVClass
@@ -67,12 +67,18 @@
 
 #define THE_COLOR 0xffffffff
 
+/* largest R + G + B as computed below */
+#define MAX_YVAL (2 * 255 + 4 * 255 + 255)
+
+#define DEFAULT_N_THREADS 1
+
 enum
 {
   PROP_0,
   PROP_DELAY,
   PROP_LINESPACE,
-  PROP_GAIN
+  PROP_GAIN,
+  PROP_N_THREADS
 };
 
 #define gst_revtv_parent_class parent_class
@@ -100,47 +106,42 @@ GST_STATIC_PAD_TEMPLATE ("sink",
     GST_STATIC_CAPS (CAPS_STR)
     );
 
-static GstFlowReturn
-gst_revtv_transform_frame (GstVideoFilter * vfilter, GstVideoFrame * in_frame,
-    GstVideoFrame * out_frame)
+typedef struct
+{
+  GstVideoFrame *in_frame, *out_frame;
+  gint linespace, vscale;
+} GstRevTVJob;
+
+/* Lines are drawn up to MAX_YVAL / vscale rows above their source row, so
+ * each band draws the parts of all lines from its first row up to that far
+ * below its last row that end up inside the band. */
+static void
+gst_revtv_rows (GstRevTVJob * job, gint y0, gint height)
 {
-  GstRevTV *filter = GST_REVTV (vfilter);
   guint32 *src, *dest;
-  gint width, height, sstride, dstride;
+  gint width, sstride, dstride, y_end, last;
   guint32 *nsrc;
   gint y, x, R, G, B, yval;
-  gint linespace, vscale;
-  GstClockTime timestamp, stream_time;
-
-  timestamp = GST_BUFFER_TIMESTAMP (in_frame->buffer);
-  stream_time =
-      gst_segment_to_stream_time (&GST_BASE_TRANSFORM (vfilter)->segment,
-      GST_FORMAT_TIME, timestamp);
-
-  GST_DEBUG_OBJECT (filter, "sync to %" GST_TIME_FORMAT,
-      GST_TIME_ARGS (timestamp));
-
-  if (GST_CLOCK_TIME_IS_VALID (stream_time))
-    gst_object_sync_values (GST_OBJECT (filter), stream_time);
+  gint linespace = job->linespace, vscale = job->vscale;
 
-  src = GST_VIDEO_FRAME_PLANE_DATA (in_frame, 0);
-  sstride = GST_VIDEO_FRAME_PLANE_STRIDE (in_frame, 0);
-  dest = GST_VIDEO_FRAME_PLANE_DATA (out_frame, 0);
-  dstride = GST_VIDEO_FRAME_PLANE_STRIDE (out_frame, 0);
+  src = GST_VIDEO_FRAME_PLANE_DATA (job->in_frame, 0);
+  sstride = GST_VIDEO_FRAME_PLANE_STRIDE (job->in_frame, 0);
+  dest = GST_VIDEO_FRAME_PLANE_DATA (job->out_frame, 0);
+  dstride = GST_VIDEO_FRAME_PLANE_STRIDE (job->out_frame, 0);
 
-  width = GST_VIDEO_FRAME_WIDTH (in_frame);
-  height = GST_VIDEO_FRAME_HEIGHT (in_frame);
+  width = GST_VIDEO_FRAME_WIDTH (job->in_frame);
+  y_end = y0 + height;
+  last = MIN (GST_VIDEO_FRAME_HEIGHT (job->in_frame),
+      y_end + MAX_YVAL / vscale);
 
-  /* Clear everything to black */
-  memset (dest, 0, dstride * height);
-
-  GST_OBJECT_LOCK (filter);
-  linespace = filter->linespace;
-  vscale = filter->vscale;
+  /* Clear the band to black */
+  for (y = y0; y < y_end; y++)
+    memset ((guint8 *) dest + y * dstride, 0, width * sizeof (guint32));
 
   /* draw the offset lines */
-  for (y = 0; y < height; y += linespace) {
-    for (x = 0; x <= width; x++) {
+  for (y = (y0 + linespace - 1) / linespace * linespace; y < last;
+      y += linespace) {
+    for (x = 0; x < width; x++) {
       nsrc = src + (y * sstride / 4) + x;
 
       /* Calc Y Value for curpix */
@@ -150,11 +151,39 @@ gst_revtv_transform_frame (GstVideoFilter * vfilter, GstVideoFrame * in_frame,
 
       yval = y - ((short) (R + G + B) / vscale);
 
-      if (yval > 0) {
+      if (yval > 0 && yval >= y0 && yval < y_end) {
         dest[x + (yval * dstride / 4)] = THE_COLOR;
       }
     }
   }
+}
+
+static GstFlowReturn
+gst_revtv_transform_frame (GstVideoFilter * vfilter, GstVideoFrame * in_frame,
+    GstVideoFrame * out_frame)
+{
+  GstRevTV *filter = GST_REVTV (vfilter);
+  GstRevTVJob job = { in_frame, out_frame };
+  GstClockTime timestamp, stream_time;
+
+  timestamp = GST_BUFFER_TIMESTAMP (in_frame->buffer);
+  stream_time =
+      gst_segment_to_stream_time (&GST_BASE_TRANSFORM (vfilter)->segment,
+      GST_FORMAT_TIME, timestamp);
+
+  GST_DEBUG_OBJECT (filter, "sync to %" GST_TIME_FORMAT,
+      GST_TIME_ARGS (timestamp));
+
+  if (GST_CLOCK_TIME_IS_VALID (stream_time))
+    gst_object_sync_values (GST_OBJECT (filter), stream_time);
+
+  GST_OBJECT_LOCK (filter);
+  job.linespace = filter->linespace;
+  job.vscale = filter->vscale;
+
+  gst_video_bands_process_rows (&filter->bands, filter->n_threads,
+      GST_VIDEO_FRAME_HEIGHT (in_frame), 1,
+      (GstVideoBandsRowsFunc) gst_revtv_rows, &job);
   GST_OBJECT_UNLOCK (filter);
 
   return GST_FLOW_OK;
@@ -177,6 +206,9 @@ gst_revtv_set_property (GObject * object, guint prop_id, const GValue * value,
     case PROP_GAIN:
       filter->vscale = g_value_get_int (value);
       break;
+    case PROP_N_THREADS:
+      filter->n_threads = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -200,12 +232,27 @@ gst_revtv_get_property (GObject * object, guint prop_id, GValue * value,
     case PROP_GAIN:
       g_value_set_int (value, filter->vscale);
       break;
+    case PROP_N_THREADS:
+      GST_OBJECT_LOCK (filter);
+      g_value_set_uint (value, filter->n_threads);
+      GST_OBJECT_UNLOCK (filter);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
   }
 }
 
+static void
+gst_revtv_finalize (GObject * object)
+{
+  GstRevTV *filter = GST_REVTV (object);
+
+  gst_video_bands_clear (&filter->bands);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
 static void
 gst_revtv_class_init (GstRevTVClass * klass)
 {
@@ -215,6 +262,7 @@ gst_revtv_class_init (GstRevTVClass * klass)
 
   gobject_class->set_property = gst_revtv_set_property;
   gobject_class->get_property = gst_revtv_get_property;
+  gobject_class->finalize = gst_revtv_finalize;
 
   g_object_class_install_property (G_OBJECT_CLASS (klass), PROP_DELAY,
       g_param_spec_int ("delay", "Delay", "Delay in frames between updates",
@@ -227,6 +275,19 @@ gst_revtv_class_init (GstRevTVClass * klass)
   g_object_class_install_property (G_OBJECT_CLASS (klass), PROP_GAIN,
       g_param_spec_int ("gain", "Gain", "Control gain", 1, 200, 50,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | GST_PARAM_CONTROLLABLE));
+  /**
+   * GstRevTV:n-threads:
+   *
+   * Maximum number of threads used to process each frame, in bands of rows.
+   * 0 uses one thread per CPU.
+   *
+   * Since: 1.24
+   */
+  g_object_class_install_property (G_OBJECT_CLASS (klass), PROP_N_THREADS,
+      g_param_spec_uint ("n-threads", "Threads",
+          "Maximum number of threads to use (0 = number of CPUs)", 0,
+          G_MAXINT, DEFAULT_N_THREADS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
   gst_element_class_set_static_metadata (gstelement_class, "RevTV effect",
       "Filter/Effect/Video",
@@ -249,4 +310,6 @@ gst_revtv_init (GstRevTV * restv)
   restv->vgrab = 0;
   restv->linespace = 6;
   restv->vscale = 50;
+  restv->n_threads = DEFAULT_N_THREADS;
+  gst_video_bands_init (&restv->bands);
 }
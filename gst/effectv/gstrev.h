@@ -47,6 +47,7 @@
 
 #include <gst/video/video.h>
 #include <gst/video/gstvideofilter.h>
+#include <gst/video-bands-private.h>
 
 G_BEGIN_DECLS
 
@@ -73,6 +74,9 @@ struct _GstRevTV
   gint vgrab;
   gint linespace;
   gint vscale;
+
+  guint n_threads;
+  GstVideoBands bands;
 };
 
 struct _GstRevTVClass
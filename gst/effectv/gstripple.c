@@ -53,12 +53,14 @@
 #include "gsteffectv.h"
 
 #define DEFAULT_MODE 0
+#define DEFAULT_N_THREADS 1
 
 enum
 {
   PROP_0,
   PROP_RESET,
-  PROP_MODE
+  PROP_MODE,
+  PROP_N_THREADS
 };
 
 static gint sqrtable[256];
@@ -118,12 +120,18 @@ setTable (void)
   }
 }
 
+typedef struct
+{
+  GstRippleTV *filter;
+  GstVideoFrame *in_frame, *out_frame;
+} GstRippleTVJob;
+
 static void
-image_bgset_y (guint32 * src, gint16 * background, gint video_area)
+image_bgset_y (const guint32 * src, gint16 * background, gint video_area)
 {
   gint i;
   gint R, G, B;
-  guint32 *p;
+  const guint32 *p;
   gint16 *q;
 
   p = src;
@@ -138,27 +146,13 @@ image_bgset_y (guint32 * src, gint16 * background, gint video_area)
   }
 }
 
-static gint
-setBackground (GstRippleTV * filter, guint32 * src)
-{
-  GstVideoInfo *info;
-
-  info = &GST_VIDEO_FILTER (filter)->in_info;
-
-  image_bgset_y (src, filter->background,
-      GST_VIDEO_INFO_WIDTH (info) * GST_VIDEO_INFO_HEIGHT (info));
-  filter->bg_is_set = TRUE;
-
-  return 0;
-}
-
 static void
-image_bgsubtract_update_y (guint32 * src, gint16 * background, guint8 * diff,
-    gint video_area)
+image_bgsubtract_update_y (const guint32 * src, gint16 * background,
+    guint8 * diff, gint video_area)
 {
   gint i;
   gint R, G, B;
-  guint32 *p;
+  const guint32 *p;
   gint16 *q;
   guint8 *r;
   gint v;
@@ -181,29 +175,40 @@ image_bgsubtract_update_y (guint32 * src, gint16 * background, guint8 * diff,
 }
 
 static void
-motiondetect (GstRippleTV * filter, guint32 * src)
+bgsubtract (GstRippleTVJob * job, gint y, gint height)
 {
-  guint8 *diff = filter->diff;
-  gint width, height;
-  gint *p, *q;
-  gint x, y, h;
-  GstVideoInfo *info;
-
-  info = &GST_VIDEO_FILTER (filter)->in_info;
+  GstRippleTV *filter = job->filter;
+  gint width = GST_VIDEO_FRAME_WIDTH (job->in_frame);
+
+  for (; height > 0; y++, height--) {
+    const guint32 *src =
+        (const guint32 *) ((guint8 *) GST_VIDEO_FRAME_PLANE_DATA (job->in_frame,
+            0) + y * GST_VIDEO_FRAME_PLANE_STRIDE (job->in_frame, 0));
+
+    if (!filter->bg_is_set)
+      image_bgset_y (src, filter->background + y * width, width);
+    image_bgsubtract_update_y (src, filter->background + y * width,
+        filter->diff + y * width, width);
+  }
+}
 
-  width = GST_VIDEO_INFO_WIDTH (info);
-  height = GST_VIDEO_INFO_HEIGHT (info);
+/* each map cell takes the motion of the 2x2 video pixels below it */
+static void
+motiondetect (GstRippleTVJob * job, gint y, gint height)
+{
+  GstRippleTV *filter = job->filter;
+  gint width = GST_VIDEO_FRAME_WIDTH (job->in_frame);
+  const guint8 *diff;
+  gint *p, *q;
+  gint x, h, end;
 
-  if (!filter->bg_is_set)
-    setBackground (filter, src);
+  end = MIN (y + height, filter->map_h - 1);
 
-  image_bgsubtract_update_y (src, filter->background, filter->diff,
-      width * height);
-  p = filter->map1 + filter->map_w + 1;
-  q = filter->map2 + filter->map_w + 1;
-  diff += width + 2;
+  for (y = MAX (y, 1); y < end; y++) {
+    p = filter->map1 + y * filter->map_w + 1;
+    q = filter->map2 + y * filter->map_w + 1;
+    diff = filter->diff + (2 * y - 1) * width + 2;
 
-  for (y = filter->map_h - 2; y > 0; y--) {
     for (x = filter->map_w - 2; x > 0; x--) {
       h = (gint) * diff + (gint) * (diff + 1) + (gint) * (diff + width) +
           (gint) * (diff + width + 1);
@@ -215,9 +220,6 @@ motiondetect (GstRippleTV * filter, guint32 * src)
       q++;
       diff += 2;
     }
-    diff += width + 2;
-    p += 2;
-    q += 2;
   }
 }
 
@@ -311,94 +313,70 @@ raindrop (GstRippleTV * filter)
   filter->period--;
 }
 
-static GstFlowReturn
-gst_rippletv_transform_frame (GstVideoFilter * vfilter,
-    GstVideoFrame * in_frame, GstVideoFrame * out_frame)
+/* wave simulation */
+static void
+wave (GstRippleTVJob * job, gint y, gint height)
 {
-  GstRippleTV *filter = GST_RIPPLETV (vfilter);
-  guint32 *src, *dest;
-  gint x, y, i;
-  gint dx, dy, o_dx;
-  gint h, v;
-  gint m_w, m_h, v_w, v_h;
+  GstRippleTV *filter = job->filter;
+  gint m_w = filter->map_w;
   gint *p, *q, *r;
-  gint8 *vp;
-  GstClockTime timestamp, stream_time;
-
-  timestamp = GST_BUFFER_TIMESTAMP (in_frame->buffer);
-  stream_time =
-      gst_segment_to_stream_time (&GST_BASE_TRANSFORM (vfilter)->segment,
-      GST_FORMAT_TIME, timestamp);
-
-  GST_DEBUG_OBJECT (filter, "sync to %" GST_TIME_FORMAT,
-      GST_TIME_ARGS (timestamp));
-
-  if (GST_CLOCK_TIME_IS_VALID (stream_time))
-    gst_object_sync_values (GST_OBJECT (filter), stream_time);
-
-  src = GST_VIDEO_FRAME_PLANE_DATA (in_frame, 0);
-  dest = GST_VIDEO_FRAME_PLANE_DATA (out_frame, 0);
-
-  GST_OBJECT_LOCK (filter);
-  /* impact from the motion or rain drop */
-  if (filter->mode)
-    raindrop (filter);
-  else
-    motiondetect (filter, src);
-
-  m_w = filter->map_w;
-  m_h = filter->map_h;
-  v_w = GST_VIDEO_FRAME_WIDTH (in_frame);
-  v_h = GST_VIDEO_FRAME_HEIGHT (in_frame);
+  gint x, h, v, end;
+
+  end = MIN (y + height, filter->map_h - 1);
+
+  for (y = MAX (y, 1); y < end; y++) {
+    p = filter->map1 + y * m_w + 1;
+    q = filter->map2 + y * m_w + 1;
+    r = filter->map3 + y * m_w + 1;
+    for (x = m_w - 2; x > 0; x--) {
+      h = *(p - m_w - 1) + *(p - m_w + 1) + *(p + m_w - 1) + *(p + m_w + 1)
+          + *(p - m_w) + *(p - 1) + *(p + 1) + *(p + m_w) - (*p) * 9;
+      h = h >> 3;
+      v = *p - *q;
+      v += h - (v >> decay);
+      *r = v + *p;
+      p++;
+      q++;
+      r++;
+    }
+  }
+}
 
-  /* simulate surface wave */
+/* low pass filter */
+static void
+low_pass (GstRippleTVJob * job, gint y, gint height)
+{
+  GstRippleTV *filter = job->filter;
+  gint m_w = filter->map_w;
+  gint *p, *q;
+  gint x, h, end;
 
-  /* This function is called only 30 times per second. To increase a speed
-   * of wave, iterates this loop several times. */
-  for (i = loopnum; i > 0; i--) {
-    /* wave simulation */
-    p = filter->map1 + m_w + 1;
-    q = filter->map2 + m_w + 1;
-    r = filter->map3 + m_w + 1;
-    for (y = m_h - 2; y > 0; y--) {
-      for (x = m_w - 2; x > 0; x--) {
-        h = *(p - m_w - 1) + *(p - m_w + 1) + *(p + m_w - 1) + *(p + m_w + 1)
-            + *(p - m_w) + *(p - 1) + *(p + 1) + *(p + m_w) - (*p) * 9;
-        h = h >> 3;
-        v = *p - *q;
-        v += h - (v >> decay);
-        *r = v + *p;
-        p++;
-        q++;
-        r++;
-      }
-      p += 2;
-      q += 2;
-      r += 2;
-    }
+  end = MIN (y + height, filter->map_h - 1);
 
-    /* low pass filter */
-    p = filter->map3 + m_w + 1;
-    q = filter->map2 + m_w + 1;
-    for (y = m_h - 2; y > 0; y--) {
-      for (x = m_w - 2; x > 0; x--) {
-        h = *(p - m_w) + *(p - 1) + *(p + 1) + *(p + m_w) + (*p) * 60;
-        *q = h >> 6;
-        p++;
-        q++;
-      }
-      p += 2;
-      q += 2;
+  for (y = MAX (y, 1); y < end; y++) {
+    p = filter->map3 + y * m_w + 1;
+    q = filter->map2 + y * m_w + 1;
+    for (x = m_w - 2; x > 0; x--) {
+      h = *(p - m_w) + *(p - 1) + *(p + 1) + *(p + m_w) + (*p) * 60;
+      *q = h >> 6;
+      p++;
+      q++;
     }
-
-    p = filter->map1;
-    filter->map1 = filter->map2;
-    filter->map2 = p;
   }
+}
+
+static void
+make_vtable (GstRippleTVJob * job, gint y, gint height)
+{
+  GstRippleTV *filter = job->filter;
+  gint m_w = filter->map_w;
+  gint8 *vp;
+  gint *p;
+  gint x;
 
-  vp = filter->vtable;
-  p = filter->map1;
-  for (y = m_h - 1; y > 0; y--) {
+  for (; height > 0; y++, height--) {
+    vp = filter->vtable + y * m_w * 2;
+    p = filter->map1 + y * m_w;
     for (x = m_w - 1; x > 0; x--) {
       /* difference of the height between two voxel. They are twiced to
        * emphasise the wave. */
@@ -407,14 +385,36 @@ gst_rippletv_transform_frame (GstVideoFilter * vfilter,
       p++;
       vp += 2;
     }
-    p++;
-    vp += 2;
   }
+}
+
+/* draw refracted image. The vector table is stretched, each entry covers
+ * 2x2 video pixels so the bands start on even rows. */
+static void
+draw (GstRippleTVJob * job, gint y, gint height)
+{
+  GstRippleTV *filter = job->filter;
+  gint m_w = filter->map_w;
+  gint v_w = GST_VIDEO_FRAME_WIDTH (job->in_frame);
+  gint v_h = GST_VIDEO_FRAME_HEIGHT (job->in_frame);
+  const guint8 *src = GST_VIDEO_FRAME_PLANE_DATA (job->in_frame, 0);
+  gint sstride = GST_VIDEO_FRAME_PLANE_STRIDE (job->in_frame, 0);
+  gint dstride = GST_VIDEO_FRAME_PLANE_STRIDE (job->out_frame, 0);
+  guint32 *dest, *dest1;
+  const gint8 *vp;
+  gint x, end;
+  gint dx, dy, o_dx;
+  gint h, v;
+
+  end = y + height;
 
-  vp = filter->vtable;
+  for (; y < end; y += 2) {
+    vp = filter->vtable + (y / 2) * m_w * 2;
+    dest = (guint32 *) ((guint8 *) GST_VIDEO_FRAME_PLANE_DATA (job->out_frame,
+            0) + y * dstride);
+    /* the last row and column of an odd sized frame have no pair */
+    dest1 = y + 1 < v_h ? (guint32 *) ((guint8 *) dest + dstride) : NULL;
 
-  /* draw refracted image. The vector table is stretched. */
-  for (y = 0; y < v_h; y += 2) {
     for (x = 0; x < v_w; x += 2) {
       h = (gint) vp[0];
       v = (gint) vp[1];
@@ -422,25 +422,82 @@ gst_rippletv_transform_frame (GstVideoFilter * vfilter,
       dy = y + v;
       dx = CLAMP (dx, 0, (v_w - 2));
       dy = CLAMP (dy, 0, (v_h - 2));
-      dest[0] = src[dy * v_w + dx];
+      dest[x] = ((const guint32 *) (src + dy * sstride))[dx];
 
       o_dx = dx;
 
       dx = x + 1 + (h + (gint) vp[2]) / 2;
       dx = CLAMP (dx, 0, (v_w - 2));
-      dest[1] = src[dy * v_w + dx];
-
-      dy = y + 1 + (v + (gint) vp[m_w * 2 + 1]) / 2;
-      dy = CLAMP (dy, 0, (v_h - 2));
-      dest[v_w] = src[dy * v_w + o_dx];
-
-      dest[v_w + 1] = src[dy * v_w + dx];
-      dest += 2;
+      if (x + 1 < v_w)
+        dest[x + 1] = ((const guint32 *) (src + dy * sstride))[dx];
+
+      if (dest1) {
+        dy = y + 1 + (v + (gint) vp[m_w * 2 + 1]) / 2;
+        dy = CLAMP (dy, 0, (v_h - 2));
+        dest1[x] = ((const guint32 *) (src + dy * sstride))[o_dx];
+        if (x + 1 < v_w)
+          dest1[x + 1] = ((const guint32 *) (src + dy * sstride))[dx];
+      }
       vp += 2;
     }
-    dest += v_w;
-    vp += 2;
   }
+}
+
+static GstFlowReturn
+gst_rippletv_transform_frame (GstVideoFilter * vfilter,
+    GstVideoFrame * in_frame, GstVideoFrame * out_frame)
+{
+  GstRippleTV *filter = GST_RIPPLETV (vfilter);
+  GstRippleTVJob job = { filter, in_frame, out_frame };
+  gint i;
+  gint *p;
+  GstClockTime timestamp, stream_time;
+
+  timestamp = GST_BUFFER_TIMESTAMP (in_frame->buffer);
+  stream_time =
+      gst_segment_to_stream_time (&GST_BASE_TRANSFORM (vfilter)->segment,
+      GST_FORMAT_TIME, timestamp);
+
+  GST_DEBUG_OBJECT (filter, "sync to %" GST_TIME_FORMAT,
+      GST_TIME_ARGS (timestamp));
+
+  if (GST_CLOCK_TIME_IS_VALID (stream_time))
+    gst_object_sync_values (GST_OBJECT (filter), stream_time);
+
+  GST_OBJECT_LOCK (filter);
+  /* impact from the motion or rain drop. Every step below reads rows of
+   * the previous one that other bands wrote. */
+  if (filter->mode) {
+    raindrop (filter);
+  } else {
+    gst_video_bands_process_rows (&filter->bands, filter->n_threads,
+        GST_VIDEO_FRAME_HEIGHT (in_frame), 1,
+        (GstVideoBandsRowsFunc) bgsubtract, &job);
+    filter->bg_is_set = TRUE;
+    gst_video_bands_process_rows (&filter->bands, filter->n_threads,
+        filter->map_h, 1, (GstVideoBandsRowsFunc) motiondetect, &job);
+  }
+
+  /* simulate surface wave */
+
+  /* This function is called only 30 times per second. To increase a speed
+   * of wave, iterates this loop several times. */
+  for (i = loopnum; i > 0; i--) {
+    gst_video_bands_process_rows (&filter->bands, filter->n_threads,
+        filter->map_h, 1, (GstVideoBandsRowsFunc) wave, &job);
+    gst_video_bands_process_rows (&filter->bands, filter->n_threads,
+        filter->map_h, 1, (GstVideoBandsRowsFunc) low_pass, &job);
+
+    p = filter->map1;
+    filter->map1 = filter->map2;
+    filter->map2 = p;
+  }
+
+  gst_video_bands_process_rows (&filter->bands, filter->n_threads,
+      filter->map_h - 1, 1, (GstVideoBandsRowsFunc) make_vtable, &job);
+  gst_video_bands_process_rows (&filter->bands, filter->n_threads,
+      GST_VIDEO_FRAME_HEIGHT (in_frame), 2, (GstVideoBandsRowsFunc) draw,
+      &job);
   GST_OBJECT_UNLOCK (filter);
 
   return GST_FLOW_OK;
@@ -517,6 +574,8 @@ gst_rippletv_finalize (GObject * object)
   g_free (filter->diff);
   filter->diff = NULL;
 
+  gst_video_bands_clear (&filter->bands);
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -536,6 +595,9 @@ gst_rippletv_set_property (GObject * object, guint prop_id,
     case PROP_MODE:
       filter->mode = g_value_get_enum (value);
       break;
+    case PROP_N_THREADS:
+      filter->n_threads = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -553,6 +615,11 @@ gst_rippletv_get_property (GObject * object, guint prop_id, GValue * value,
     case PROP_MODE:
       g_value_set_enum (value, filter->mode);
       break;
+    case PROP_N_THREADS:
+      GST_OBJECT_LOCK (filter);
+      g_value_set_uint (value, filter->n_threads);
+      GST_OBJECT_UNLOCK (filter);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -582,6 +649,20 @@ gst_rippletv_class_init (GstRippleTVClass * klass)
           "Mode", GST_TYPE_RIPPLETV_MODE, DEFAULT_MODE,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | GST_PARAM_CONTROLLABLE));
 
+  /**
+   * GstRippleTV:n-threads:
+   *
+   * Maximum number of threads used to process each frame, in bands of rows.
+   * 0 uses one thread per CPU.
+   *
+   * Since: 1.24
+   */
+  g_object_class_install_property (gobject_class, PROP_N_THREADS,
+      g_param_spec_uint ("n-threads", "Threads",
+          "Maximum number of threads to use (0 = number of CPUs)", 0,
+          G_MAXINT, DEFAULT_N_THREADS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_set_static_metadata (gstelement_class, "RippleTV effect",
       "Filter/Effect/Video",
       "RippleTV does ripple mark effect on the video input",
@@ -608,6 +689,8 @@ static void
 gst_rippletv_init (GstRippleTV * filter)
 {
   filter->mode = DEFAULT_MODE;
+  filter->n_threads = DEFAULT_N_THREADS;
+  gst_video_bands_init (&filter->bands);
 
   /* FIXME: remove this when memory corruption after resizes are fixed */
   gst_pad_use_fixed_caps (GST_BASE_TRANSFORM_SRC_PAD (filter));
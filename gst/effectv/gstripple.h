@@ -31,6 +31,7 @@
 
 #include <gst/video/video.h>
 #include <gst/video/gstvideofilter.h>
+#include <gst/video-bands-private.h>
 
 G_BEGIN_DECLS
 
@@ -72,6 +73,9 @@ struct _GstRippleTV
   gint drops_per_frame_max;
   gint drops_per_frame;
   gint drop_power;
+
+  guint n_threads;
+  GstVideoBands bands;
 };
 
 struct _GstRippleTVClass
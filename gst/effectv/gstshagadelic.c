@@ -49,6 +49,14 @@
 #define M_PI  3.14159265358979323846
 #endif
 
+enum
+{
+  PROP_0,
+  PROP_N_THREADS
+};
+
+#define DEFAULT_N_THREADS 1
+
 #define gst_shagadelictv_parent_class parent_class
 G_DEFINE_TYPE (GstShagadelicTV, gst_shagadelictv, GST_TYPE_VIDEO_FILTER);
 GST_ELEMENT_REGISTER_DEFINE (shagadelictv, "shagadelictv",
@@ -160,26 +168,32 @@ gst_shagadelic_initialize (GstShagadelicTV * filter, GstVideoInfo * info)
   filter->phase = 0;
 }
 
-static GstFlowReturn
-gst_shagadelictv_transform_frame (GstVideoFilter * vfilter,
-    GstVideoFrame * in_frame, GstVideoFrame * out_frame)
+typedef struct
 {
-  GstShagadelicTV *filter = GST_SHAGADELICTV (vfilter);
-  guint32 *src, *dest;
-  gint x, y;
+  GstShagadelicTV *filter;
+  GstVideoFrame *in_frame, *out_frame;
+} GstShagadelicTVJob;
+
+static void
+gst_shagadelictv_rows (GstShagadelicTVJob * job, gint y, gint height)
+{
+  GstShagadelicTV *filter = job->filter;
+  gint x, width = GST_VIDEO_FRAME_WIDTH (job->in_frame);
+  gint sstride = GST_VIDEO_FRAME_PLANE_STRIDE (job->in_frame, 0) / 4;
+  gint dstride = GST_VIDEO_FRAME_PLANE_STRIDE (job->out_frame, 0) / 4;
   guint32 v;
   guint8 r, g, b;
-  gint width, height;
 
-  src = GST_VIDEO_FRAME_PLANE_DATA (in_frame, 0);
-  dest = GST_VIDEO_FRAME_PLANE_DATA (out_frame, 0);
+  for (; height > 0; y++, height--) {
+    const guint32 *src =
+        (const guint32 *) GST_VIDEO_FRAME_PLANE_DATA (job->in_frame,
+        0) + y * sstride;
+    guint32 *dest =
+        (guint32 *) GST_VIDEO_FRAME_PLANE_DATA (job->out_frame,
+        0) + y * dstride;
 
-  width = GST_VIDEO_FRAME_WIDTH (in_frame);
-  height = GST_VIDEO_FRAME_HEIGHT (in_frame);
-
-  for (y = 0; y < height; y++) {
     for (x = 0; x < width; x++) {
-      v = *src++ | 0x1010100;
+      v = src[x] | 0x1010100;
       v = (v - 0x707060) & 0x1010100;
       v -= v >> 8;
 /* Try another Babe! 
@@ -191,9 +205,29 @@ gst_shagadelictv_transform_frame (GstVideoFilter * vfilter,
       g = ((gint8) (filter->spiral[y * width + x] + filter->phase * 3)) >> 7;
       b = ((gint8) (filter->ripple[(filter->by + y) * width * 2 + filter->bx +
                   x] - filter->phase)) >> 7;
-      *dest++ = v & ((r << 16) | (g << 8) | b);
+      dest[x] = v & ((r << 16) | (g << 8) | b);
     }
   }
+}
+
+static GstFlowReturn
+gst_shagadelictv_transform_frame (GstVideoFilter * vfilter,
+    GstVideoFrame * in_frame, GstVideoFrame * out_frame)
+{
+  GstShagadelicTV *filter = GST_SHAGADELICTV (vfilter);
+  GstShagadelicTVJob job = { filter, in_frame, out_frame };
+  gint width, height;
+  guint n_threads;
+
+  width = GST_VIDEO_FRAME_WIDTH (in_frame);
+  height = GST_VIDEO_FRAME_HEIGHT (in_frame);
+
+  GST_OBJECT_LOCK (filter);
+  n_threads = filter->n_threads;
+  GST_OBJECT_UNLOCK (filter);
+
+  gst_video_bands_process_rows (&filter->bands, n_threads, height, 1,
+      (GstVideoBandsRowsFunc) gst_shagadelictv_rows, &job);
 
   filter->phase -= 8;
   if ((filter->rx + filter->rvx) < 0 || (filter->rx + filter->rvx) >= width)
@@ -223,9 +257,47 @@ gst_shagadelictv_finalize (GObject * object)
   g_free (filter->spiral);
   filter->spiral = NULL;
 
+  gst_video_bands_clear (&filter->bands);
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
+static void
+gst_shagadelictv_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstShagadelicTV *filter = GST_SHAGADELICTV (object);
+
+  switch (prop_id) {
+    case PROP_N_THREADS:
+      GST_OBJECT_LOCK (filter);
+      filter->n_threads = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (filter);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_shagadelictv_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstShagadelicTV *filter = GST_SHAGADELICTV (object);
+
+  switch (prop_id) {
+    case PROP_N_THREADS:
+      GST_OBJECT_LOCK (filter);
+      g_value_set_uint (value, filter->n_threads);
+      GST_OBJECT_UNLOCK (filter);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
 static void
 gst_shagadelictv_class_init (GstShagadelicTVClass * klass)
 {
@@ -233,8 +305,24 @@ gst_shagadelictv_class_init (GstShagadelicTVClass * klass)
   GstElementClass *gstelement_class = (GstElementClass *) klass;
   GstVideoFilterClass *vfilter_class = (GstVideoFilterClass *) klass;
 
+  gobject_class->set_property = gst_shagadelictv_set_property;
+  gobject_class->get_property = gst_shagadelictv_get_property;
   gobject_class->finalize = gst_shagadelictv_finalize;
 
+  /**
+   * GstShagadelicTV:n-threads:
+   *
+   * Maximum number of threads used to process each frame, in bands of rows.
+   * 0 uses one thread per CPU.
+   *
+   * Since: 1.24
+   */
+  g_object_class_install_property (gobject_class, PROP_N_THREADS,
+      g_param_spec_uint ("n-threads", "Threads",
+          "Maximum number of threads to use (0 = number of CPUs)", 0,
+          G_MAXINT, DEFAULT_N_THREADS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_set_static_metadata (gstelement_class, "ShagadelicTV",
       "Filter/Effect/Video",
       "Oh behave, ShagedelicTV makes images shagadelic!",
@@ -255,4 +343,6 @@ gst_shagadelictv_init (GstShagadelicTV * filter)
 {
   filter->ripple = NULL;
   filter->spiral = NULL;
+  filter->n_threads = DEFAULT_N_THREADS;
+  gst_video_bands_init (&filter->bands);
 }
@@ -29,6 +29,7 @@
 
 #include <gst/video/video.h>
 #include <gst/video/gstvideofilter.h>
+#include <gst/video-bands-private.h>
 
 G_BEGIN_DECLS
 
@@ -58,6 +59,9 @@ struct _GstShagadelicTV
   gint bx, by;
   gint rvx, rvy;
   gint bvx, bvy;
+
+  guint n_threads;
+  GstVideoBands bands;
 };
 
 struct _GstShagadelicTVClass
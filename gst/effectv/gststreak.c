@@ -52,11 +52,13 @@
 #include "gsteffectv.h"
 
 #define DEFAULT_FEEDBACK FALSE
+#define DEFAULT_N_THREADS 1
 
 enum
 {
   PROP_0,
-  PROP_FEEDBACK
+  PROP_FEEDBACK,
+  PROP_N_THREADS
 };
 
 #define gst_streaktv_parent_class parent_class
@@ -79,62 +81,135 @@ GST_STATIC_PAD_TEMPLATE ("sink",
     );
 
 
+/* number of pixels handled at once by the inner loops */
+#define STREAK_BLOCK 64
+
+typedef struct
+{
+  GstVideoFrame *in_frame, *out_frame;
+  gboolean feedback;
+  guint32 mask;
+  guint shift;
+  /* the plane the current frame goes to, and the planes that are summed */
+  guint32 *current;
+  const guint32 *planes[8];
+} GstStreakTVJob;
+
+static inline guint32
+streak_pixel (GstStreakTVJob * job, guint32 src, gint o)
+{
+  const guint32 *const *planes = job->planes;
+  guint32 v;
+
+  job->current[o] = (src & job->mask) >> job->shift;
+
+  if (job->feedback) {
+    v = planes[0][o] + planes[1][o] + planes[2][o] + planes[3][o];
+    job->current[o] = (v & job->mask) >> job->shift;
+  } else {
+    v = planes[0][o] + planes[1][o] + planes[2][o] + planes[3][o] +
+        planes[4][o] + planes[5][o] + planes[6][o] + planes[7][o];
+  }
+
+  return v;
+}
+
+/* same as streak_pixel() for STREAK_BLOCK pixels at once, with the loops
+ * only touching local arrays or only reading from the planes so that they
+ * can be vectorized */
+static inline void
+streak_block (GstStreakTVJob * job, guint32 * dest, const guint32 * src,
+    gint o)
+{
+  guint32 t[STREAK_BLOCK], acc[STREAK_BLOCK];
+  guint32 mask = job->mask;
+  guint shift = job->shift;
+  gint i;
+
+  for (i = 0; i < STREAK_BLOCK; i++)
+    t[i] = (src[i] & mask) >> shift;
+  memcpy (job->current + o, t, sizeof (t));
+
+  if (job->feedback) {
+    const guint32 *p0 = job->planes[0] + o, *p1 = job->planes[1] + o;
+    const guint32 *p2 = job->planes[2] + o, *p3 = job->planes[3] + o;
+
+    for (i = 0; i < STREAK_BLOCK; i++)
+      acc[i] = p0[i] + p1[i] + p2[i] + p3[i];
+    for (i = 0; i < STREAK_BLOCK; i++)
+      t[i] = (acc[i] & mask) >> shift;
+    memcpy (job->current + o, t, sizeof (t));
+  } else {
+    const guint32 *p0 = job->planes[0] + o, *p1 = job->planes[1] + o;
+    const guint32 *p2 = job->planes[2] + o, *p3 = job->planes[3] + o;
+    const guint32 *p4 = job->planes[4] + o, *p5 = job->planes[5] + o;
+    const guint32 *p6 = job->planes[6] + o, *p7 = job->planes[7] + o;
+
+    for (i = 0; i < STREAK_BLOCK; i++)
+      acc[i] = p0[i] + p1[i] + p2[i] + p3[i] + p4[i] + p5[i] + p6[i] + p7[i];
+  }
+
+  memcpy (dest, acc, sizeof (acc));
+}
+
+static void
+gst_streaktv_rows (GstStreakTVJob * job, gint y, gint height)
+{
+  gint width = GST_VIDEO_FRAME_WIDTH (job->in_frame);
+  gint sstride = GST_VIDEO_FRAME_PLANE_STRIDE (job->in_frame, 0) / 4;
+  gint dstride = GST_VIDEO_FRAME_PLANE_STRIDE (job->out_frame, 0) / 4;
+  gint x;
+
+  for (; height > 0; y++, height--) {
+    const guint32 *src =
+        (const guint32 *) GST_VIDEO_FRAME_PLANE_DATA (job->in_frame,
+        0) + y * sstride;
+    guint32 *dest =
+        (guint32 *) GST_VIDEO_FRAME_PLANE_DATA (job->out_frame,
+        0) + y * dstride;
+
+    for (x = 0; x + STREAK_BLOCK <= width; x += STREAK_BLOCK)
+      streak_block (job, dest + x, src + x, y * width + x);
+    for (; x < width; x++)
+      dest[x] = streak_pixel (job, src[x], y * width + x);
+  }
+}
+
 static GstFlowReturn
 gst_streaktv_transform_frame (GstVideoFilter * vfilter,
     GstVideoFrame * in_frame, GstVideoFrame * out_frame)
 {
   GstStreakTV *filter = GST_STREAKTV (vfilter);
-  guint32 *src, *dest;
-  gint i, cf;
-  gint video_area, width, height;
+  GstStreakTVJob job = { in_frame, out_frame };
   guint32 **planetable = filter->planetable;
   gint plane = filter->plane;
-  guint stride_mask, stride_shift, stride;
-
-  src = GST_VIDEO_FRAME_PLANE_DATA (in_frame, 0);
-  dest = GST_VIDEO_FRAME_PLANE_DATA (out_frame, 0);
-
-  width = GST_VIDEO_FRAME_WIDTH (in_frame);
-  height = GST_VIDEO_FRAME_HEIGHT (in_frame);
-
-  video_area = width * height;
+  gint i, cf, n_planes;
+  guint stride;
 
   GST_OBJECT_LOCK (filter);
+  job.feedback = filter->feedback;
   if (filter->feedback) {
-    stride_mask = 0xfcfcfcfc;
+    job.mask = 0xfcfcfcfc;
     stride = 8;
-    stride_shift = 2;
+    job.shift = 2;
+    n_planes = 4;
   } else {
-    stride_mask = 0xf8f8f8f8;
+    job.mask = 0xf8f8f8f8;
     stride = 4;
-    stride_shift = 3;
-  }
-
-  for (i = 0; i < video_area; i++) {
-    planetable[plane][i] = (src[i] & stride_mask) >> stride_shift;
+    job.shift = 3;
+    n_planes = 8;
   }
 
+  /* every pixel only depends on the same pixel of the planes, so rows are
+   * independent even in feedback mode */
   cf = plane & (stride - 1);
-  if (filter->feedback) {
-    for (i = 0; i < video_area; i++) {
-      dest[i] = planetable[cf][i]
-          + planetable[cf + stride][i]
-          + planetable[cf + stride * 2][i]
-          + planetable[cf + stride * 3][i];
-      planetable[plane][i] = (dest[i] & stride_mask) >> stride_shift;
-    }
-  } else {
-    for (i = 0; i < video_area; i++) {
-      dest[i] = planetable[cf][i]
-          + planetable[cf + stride][i]
-          + planetable[cf + stride * 2][i]
-          + planetable[cf + stride * 3][i]
-          + planetable[cf + stride * 4][i]
-          + planetable[cf + stride * 5][i]
-          + planetable[cf + stride * 6][i]
-          + planetable[cf + stride * 7][i];
-    }
-  }
+  job.current = planetable[plane];
+  for (i = 0; i < n_planes; i++)
+    job.planes[i] = planetable[cf + stride * i];
+
+  gst_video_bands_process_rows (&filter->bands, filter->n_threads,
+      GST_VIDEO_FRAME_HEIGHT (in_frame), 1,
+      (GstVideoBandsRowsFunc) gst_streaktv_rows, &job);
 
   plane++;
   filter->plane = plane & (PLANES - 1);
@@ -155,7 +230,7 @@ gst_streaktv_set_info (GstVideoFilter * vfilter, GstCaps * incaps,
 
   g_free (filter->planebuffer);
 
-  filter->planebuffer = g_new0 (guint32, width * height * 4 * PLANES);
+  filter->planebuffer = g_new0 (guint32, width * height * PLANES);
 
   for (i = 0; i < PLANES; i++)
     filter->planetable[i] = &filter->planebuffer[width * height * i];
@@ -182,6 +257,7 @@ gst_streaktv_finalize (GObject * object)
     g_free (filter->planebuffer);
     filter->planebuffer = NULL;
   }
+  gst_video_bands_clear (&filter->bands);
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
@@ -202,6 +278,11 @@ gst_streaktv_set_property (GObject * object, guint prop_id,
 
       filter->feedback = g_value_get_boolean (value);
       break;
+    case PROP_N_THREADS:
+      GST_OBJECT_LOCK (filter);
+      filter->n_threads = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (filter);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -218,6 +299,11 @@ gst_streaktv_get_property (GObject * object, guint prop_id, GValue * value,
     case PROP_FEEDBACK:
       g_value_set_boolean (value, filter->feedback);
       break;
+    case PROP_N_THREADS:
+      GST_OBJECT_LOCK (filter);
+      g_value_set_uint (value, filter->n_threads);
+      GST_OBJECT_UNLOCK (filter);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -242,6 +328,20 @@ gst_streaktv_class_init (GstStreakTVClass * klass)
           "Feedback", DEFAULT_FEEDBACK,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstStreakTV:n-threads:
+   *
+   * Maximum number of threads used to process each frame, in bands of rows.
+   * 0 uses one thread per CPU.
+   *
+   * Since: 1.24
+   */
+  g_object_class_install_property (gobject_class, PROP_N_THREADS,
+      g_param_spec_uint ("n-threads", "Threads",
+          "Maximum number of threads to use (0 = number of CPUs)", 0,
+          G_MAXINT, DEFAULT_N_THREADS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_set_static_metadata (gstelement_class, "StreakTV effect",
       "Filter/Effect/Video",
       "StreakTV makes after images of moving objects",
@@ -264,4 +364,6 @@ static void
 gst_streaktv_init (GstStreakTV * filter)
 {
   filter->feedback = DEFAULT_FEEDBACK;
+  filter->n_threads = DEFAULT_N_THREADS;
+  gst_video_bands_init (&filter->bands);
 }
@@ -31,6 +31,7 @@
 
 #include <gst/video/video.h>
 #include <gst/video/gstvideofilter.h>
+#include <gst/video-bands-private.h>
 
 G_BEGIN_DECLS
 
@@ -60,6 +61,9 @@ struct _GstStreakTV
   guint32 *planebuffer;
   guint32 *planetable[PLANES];
   gint plane;
+
+  guint n_threads;
+  GstVideoBands bands;
 };
 
 struct _GstStreakTVClass
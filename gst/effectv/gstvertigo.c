@@ -54,9 +54,12 @@ enum
 {
   PROP_0,
   PROP_SPEED,
-  PROP_ZOOM_SPEED
+  PROP_ZOOM_SPEED,
+  PROP_N_THREADS
 };
 
+#define DEFAULT_N_THREADS 1
+
 #if G_BYTE_ORDER == G_LITTLE_ENDIAN
 #define CAPS_STR GST_VIDEO_CAPS_MAKE ("{ RGBx, BGRx }")
 #else
@@ -154,14 +157,75 @@ gst_vertigotv_set_parms (GstVertigoTV * filter)
     filter->phase = 0;
 }
 
+/* number of pixels handled at once by the inner loops */
+#define VERTIGO_BLOCK 64
+
+typedef struct
+{
+  GstVertigoTV *filter;
+  GstVideoFrame *in_frame, *out_frame;
+} GstVertigoTVJob;
+
+/* Each row only reads the previous frame from current_buffer and writes its
+ * own row of alt_buffer, so rows can be done in any order. */
+static void
+gst_vertigotv_rows (GstVertigoTVJob * job, gint y, gint height)
+{
+  GstVertigoTV *filter = job->filter;
+  const guint32 *current = filter->current_buffer;
+  gint width = GST_VIDEO_FRAME_WIDTH (job->in_frame);
+  gint area = width * GST_VIDEO_FRAME_HEIGHT (job->in_frame);
+  gint sstride = GST_VIDEO_FRAME_PLANE_STRIDE (job->in_frame, 0) / 4;
+  gint dstride = GST_VIDEO_FRAME_PLANE_STRIDE (job->out_frame, 0) / 4;
+  gint dx = filter->dx, dy = filter->dy;
+  guint32 v[VERTIGO_BLOCK] = { 0 }, s[VERTIGO_BLOCK] = { 0 };
+  guint32 out[VERTIGO_BLOCK];
+  gint index[VERTIGO_BLOCK];
+  gint x, i, n, ox, oy;
+
+  for (; height > 0; y++, height--) {
+    const guint32 *src =
+        (const guint32 *) GST_VIDEO_FRAME_PLANE_DATA (job->in_frame,
+        0) + y * sstride;
+    guint32 *dest =
+        (guint32 *) GST_VIDEO_FRAME_PLANE_DATA (job->out_frame,
+        0) + y * dstride;
+    guint32 *p = filter->alt_buffer + y * width;
+
+    ox = filter->sx - y * dy;
+    oy = filter->sy + y * dx;
+
+    for (x = 0; x < width; x += n) {
+      n = MIN (VERTIGO_BLOCK, width - x);
+
+      for (i = 0; i < VERTIGO_BLOCK; i++) {
+        gint px = (ox + (x + i) * dx) >> 16;
+        gint py = (oy + (x + i) * dy) >> 16;
+
+        index[i] = CLAMP (py * width + px, 0, area - 1);
+      }
+
+      for (i = 0; i < n; i++)
+        v[i] = current[index[i]];
+      memcpy (s, src + x, n * sizeof (guint32));
+
+      for (i = 0; i < VERTIGO_BLOCK; i++)
+        out[i] = ((v[i] & 0xfcfcff) * 3 + (s[i] & 0xfcfcff)) >> 2;
+
+      memcpy (dest + x, out, n * sizeof (guint32));
+      memcpy (p + x, out, n * sizeof (guint32));
+    }
+  }
+}
+
 static GstFlowReturn
 gst_vertigotv_transform_frame (GstVideoFilter * vfilter,
     GstVideoFrame * in_frame, GstVideoFrame * out_frame)
 {
   GstVertigoTV *filter = GST_VERTIGOTV (vfilter);
-  guint32 *src, *dest, *p;
-  guint32 v;
-  gint x, y, ox, oy, i, width, height, area, sstride, dstride;
+  GstVertigoTVJob job = { filter, in_frame, out_frame };
+  guint32 *p;
+  guint n_threads;
   GstClockTime timestamp, stream_time;
 
   timestamp = GST_BUFFER_TIMESTAMP (in_frame->buffer);
@@ -175,46 +239,15 @@ gst_vertigotv_transform_frame (GstVideoFilter * vfilter,
   if (GST_CLOCK_TIME_IS_VALID (stream_time))
     gst_object_sync_values (GST_OBJECT (filter), stream_time);
 
-  src = GST_VIDEO_FRAME_PLANE_DATA (in_frame, 0);
-  sstride = GST_VIDEO_FRAME_PLANE_STRIDE (in_frame, 0);
-  dest = GST_VIDEO_FRAME_PLANE_DATA (out_frame, 0);
-  dstride = GST_VIDEO_FRAME_PLANE_STRIDE (out_frame, 0);
-
-  width = GST_VIDEO_FRAME_WIDTH (in_frame);
-  height = GST_VIDEO_FRAME_HEIGHT (in_frame);
-
-  area = width * height;
-
-  sstride /= 4;
-  dstride /= 4;
+  GST_OBJECT_LOCK (filter);
+  n_threads = filter->n_threads;
+  GST_OBJECT_UNLOCK (filter);
 
   gst_vertigotv_set_parms (filter);
-  p = filter->alt_buffer;
-
-  for (y = 0; y < height; y++) {
-    ox = filter->sx;
-    oy = filter->sy;
-
-    for (x = 0; x < width; x++) {
-      i = (oy >> 16) * width + (ox >> 16);
-      if (i < 0)
-        i = 0;
-      if (i >= area)
-        i = area;
-
-      v = filter->current_buffer[i] & 0xfcfcff;
-      v = (v * 3) + (src[x] & 0xfcfcff);
 
-      *p++ = dest[x] = (v >> 2);
-      ox += filter->dx;
-      oy += filter->dy;
-    }
-    filter->sx -= filter->dy;
-    filter->sy += filter->dx;
-
-    src += sstride;
-    dest += dstride;
-  }
+  gst_video_bands_process_rows (&filter->bands, n_threads,
+      GST_VIDEO_FRAME_HEIGHT (in_frame), 1,
+      (GstVideoBandsRowsFunc) gst_vertigotv_rows, &job);
 
   p = filter->current_buffer;
   filter->current_buffer = filter->alt_buffer;
@@ -247,6 +280,9 @@ gst_vertigotv_set_property (GObject * object, guint prop_id,
     case PROP_ZOOM_SPEED:
       filter->zoomrate = g_value_get_float (value);
       break;
+    case PROP_N_THREADS:
+      filter->n_threads = g_value_get_uint (value);
+      break;
     default:
       break;
   }
@@ -266,6 +302,11 @@ gst_vertigotv_get_property (GObject * object, guint prop_id, GValue * value,
     case PROP_ZOOM_SPEED:
       g_value_set_float (value, filter->zoomrate);
       break;
+    case PROP_N_THREADS:
+      GST_OBJECT_LOCK (filter);
+      g_value_set_uint (value, filter->n_threads);
+      GST_OBJECT_UNLOCK (filter);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -279,6 +320,7 @@ gst_vertigotv_finalize (GObject * object)
 
   g_free (filter->buffer);
   filter->buffer = NULL;
+  gst_video_bands_clear (&filter->bands);
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
@@ -302,6 +344,19 @@ gst_vertigotv_class_init (GstVertigoTVClass * klass)
       g_param_spec_float ("zoom-speed", "Zoom Speed",
           "Control the rate of zooming", 1.01, 1.1, 1.01,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  /**
+   * GstVertigoTV:n-threads:
+   *
+   * Maximum number of threads used to process each frame, in bands of rows.
+   * 0 uses one thread per CPU.
+   *
+   * Since: 1.24
+   */
+  g_object_class_install_property (G_OBJECT_CLASS (klass), PROP_N_THREADS,
+      g_param_spec_uint ("n-threads", "Threads",
+          "Maximum number of threads to use (0 = number of CPUs)", 0,
+          G_MAXINT, DEFAULT_N_THREADS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
   gst_element_class_set_static_metadata (gstelement_class, "VertigoTV effect",
       "Filter/Effect/Video",
@@ -327,4 +382,6 @@ gst_vertigotv_init (GstVertigoTV * filter)
   filter->phase = 0.0;
   filter->phase_increment = 0.02;
   filter->zoomrate = 1.01;
+  filter->n_threads = DEFAULT_N_THREADS;
+  gst_video_bands_init (&filter->bands);
 }
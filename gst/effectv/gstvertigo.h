@@ -28,6 +28,7 @@
 
 #include <gst/video/video.h>
 #include <gst/video/gstvideofilter.h>
+#include <gst/video-bands-private.h>
 
 G_BEGIN_DECLS
 
@@ -57,6 +58,9 @@ struct _GstVertigoTV
   gdouble phase;
   gdouble phase_increment;
   gdouble zoomrate;
+
+  guint n_threads;
+  GstVideoBands bands;
 };
 
 struct _GstVertigoTVClass
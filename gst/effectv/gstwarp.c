@@ -62,6 +62,14 @@
 #define M_PI    3.14159265358979323846
 #endif
 
+enum
+{
+  PROP_0,
+  PROP_N_THREADS
+};
+
+#define DEFAULT_N_THREADS 1
+
 #define gst_warptv_parent_class parent_class
 G_DEFINE_TYPE (GstWarpTV, gst_warptv, GST_TYPE_VIDEO_FILTER);
 GST_ELEMENT_REGISTER_DEFINE (warptv, "warptv", GST_RANK_NONE, GST_TYPE_WARPTV);
@@ -131,8 +139,10 @@ initDistTable (GstWarpTV * filter, gint width, gint height)
 
   m = sqrt ((double) (halfw * halfw + halfh * halfh));
 
-  for (y = -halfh; y < halfh; y++)
-    for (x = -halfw; x < halfw; x++)
+  /* odd sizes get one more row and column than there are on the other side
+   * of the centre, so that every pixel has a distance */
+  for (y = -halfh; y < height - halfh; y++)
+    for (x = -halfw; x < width - halfw; x++)
 #ifdef PS2
       *distptr++ = ((int) ((sqrtf (x * x + y * y) * 511.9999) / m)) << 1;
 #else
@@ -140,27 +150,69 @@ initDistTable (GstWarpTV * filter, gint width, gint height)
 #endif
 }
 
+/* number of pixels handled at once by the inner loops */
+#define WARP_BLOCK 64
+
+typedef struct
+{
+  GstWarpTV *filter;
+  GstVideoFrame *in_frame, *out_frame;
+} GstWarpTVJob;
+
+static void
+gst_warptv_rows (GstWarpTVJob * job, gint y, gint height)
+{
+  const gint32 *ctable = job->filter->ctable;
+  const guint32 *src = GST_VIDEO_FRAME_PLANE_DATA (job->in_frame, 0);
+  gint sstride = GST_VIDEO_FRAME_PLANE_STRIDE (job->in_frame, 0) / 4;
+  gint dstride = GST_VIDEO_FRAME_PLANE_STRIDE (job->out_frame, 0) / 4;
+  gint width = GST_VIDEO_FRAME_WIDTH (job->in_frame);
+  gint maxx = width - 2;
+  gint maxy = GST_VIDEO_FRAME_HEIGHT (job->in_frame) - 2;
+  gint32 dx[WARP_BLOCK] = { 0 }, dy[WARP_BLOCK] = { 0 };
+  gint32 offset[WARP_BLOCK];
+  gint x, i, n;
+
+  for (; height > 0; y++, height--) {
+    const gint32 *distptr = job->filter->disttable + y * width;
+    guint32 *dest =
+        (guint32 *) GST_VIDEO_FRAME_PLANE_DATA (job->out_frame,
+        0) + y * dstride;
+
+    for (x = 0; x < width; x += n) {
+      n = MIN (WARP_BLOCK, width - x);
+
+      for (i = 0; i < n; i++) {
+        gint32 d = distptr[x + i];
+
+        dy[i] = ctable[d];
+        dx[i] = ctable[d + 1];
+      }
+
+      /* the displaced positions are computed for whole blocks at once */
+      for (i = 0; i < WARP_BLOCK; i++) {
+        gint32 sx = CLAMP (dx[i] + x + i, 0, maxx);
+        gint32 sy = CLAMP (dy[i] + y, 0, maxy);
+
+        offset[i] = sy * sstride + sx;
+      }
+
+      for (i = 0; i < n; i++)
+        dest[x + i] = src[offset[i]];
+    }
+  }
+}
+
 static GstFlowReturn
 gst_warptv_transform_frame (GstVideoFilter * filter, GstVideoFrame * in_frame,
     GstVideoFrame * out_frame)
 {
   GstWarpTV *warptv = GST_WARPTV (filter);
-  gint width, height;
+  GstWarpTVJob job = { warptv, in_frame, out_frame };
   gint xw, yw, cw;
-  gint32 c, i, x, y, dx, dy, maxx, maxy;
-  gint32 *ctptr, *distptr;
-  gint32 *ctable;
-  guint32 *src, *dest;
-  gint sstride, dstride;
-
-  src = GST_VIDEO_FRAME_PLANE_DATA (in_frame, 0);
-  dest = GST_VIDEO_FRAME_PLANE_DATA (out_frame, 0);
-
-  sstride = GST_VIDEO_FRAME_PLANE_STRIDE (in_frame, 0);
-  dstride = GST_VIDEO_FRAME_PLANE_STRIDE (out_frame, 0);
-
-  width = GST_VIDEO_FRAME_WIDTH (in_frame);
-  height = GST_VIDEO_FRAME_HEIGHT (in_frame);
+  gint32 c, i, x;
+  gint32 *ctptr;
+  guint n_threads;
 
   GST_OBJECT_LOCK (warptv);
   xw = (gint) (sin ((warptv->tval + 100) * M_PI / 128) * 30);
@@ -170,8 +222,6 @@ gst_warptv_transform_frame (GstVideoFilter * filter, GstVideoFrame * in_frame,
   yw += (gint) (sin ((warptv->tval + 30) * M_PI / 512) * 40);
 
   ctptr = warptv->ctable;
-  distptr = warptv->disttable;
-  ctable = warptv->ctable;
 
   c = 0;
 
@@ -181,33 +231,15 @@ gst_warptv_transform_frame (GstVideoFilter * filter, GstVideoFrame * in_frame,
     *ctptr++ = ((sintable[i + 256] * xw) >> 15);
     c += cw;
   }
-  maxx = width - 2;
-  maxy = height - 2;
-
-  for (y = 0; y < height - 1; y++) {
-    for (x = 0; x < width; x++) {
-      i = *distptr++;
-      dx = ctable[i + 1] + x;
-      dy = ctable[i] + y;
-
-      if (dx < 0)
-        dx = 0;
-      else if (dx > maxx)
-        dx = maxx;
-
-      if (dy < 0)
-        dy = 0;
-      else if (dy > maxy)
-        dy = maxy;
-
-      dest[x] = src[dy * sstride / 4 + dx];
-    }
-    dest += dstride / 4;
-  }
 
   warptv->tval = (warptv->tval + 1) & 511;
+  n_threads = warptv->n_threads;
   GST_OBJECT_UNLOCK (warptv);
 
+  gst_video_bands_process_rows (&warptv->bands, n_threads,
+      GST_VIDEO_FRAME_HEIGHT (in_frame), 1,
+      (GstVideoBandsRowsFunc) gst_warptv_rows, &job);
+
   return GST_FLOW_OK;
 }
 
@@ -228,10 +260,47 @@ gst_warptv_finalize (GObject * object)
 
   g_free (warptv->disttable);
   warptv->disttable = NULL;
+  gst_video_bands_clear (&warptv->bands);
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
+static void
+gst_warptv_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstWarpTV *warptv = GST_WARPTV (object);
+
+  switch (prop_id) {
+    case PROP_N_THREADS:
+      GST_OBJECT_LOCK (warptv);
+      warptv->n_threads = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (warptv);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_warptv_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstWarpTV *warptv = GST_WARPTV (object);
+
+  switch (prop_id) {
+    case PROP_N_THREADS:
+      GST_OBJECT_LOCK (warptv);
+      g_value_set_uint (value, warptv->n_threads);
+      GST_OBJECT_UNLOCK (warptv);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
 static void
 gst_warptv_class_init (GstWarpTVClass * klass)
 {
@@ -240,8 +309,24 @@ gst_warptv_class_init (GstWarpTVClass * klass)
   GstBaseTransformClass *trans_class = (GstBaseTransformClass *) klass;
   GstVideoFilterClass *vfilter_class = (GstVideoFilterClass *) klass;
 
+  gobject_class->set_property = gst_warptv_set_property;
+  gobject_class->get_property = gst_warptv_get_property;
   gobject_class->finalize = gst_warptv_finalize;
 
+  /**
+   * GstWarpTV:n-threads:
+   *
+   * Maximum number of threads used to process each frame, in bands of rows.
+   * 0 uses one thread per CPU.
+   *
+   * Since: 1.24
+   */
+  g_object_class_install_property (gobject_class, PROP_N_THREADS,
+      g_param_spec_uint ("n-threads", "Threads",
+          "Maximum number of threads to use (0 = number of CPUs)", 0,
+          G_MAXINT, DEFAULT_N_THREADS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_set_static_metadata (gstelement_class, "WarpTV effect",
       "Filter/Effect/Video",
       "WarpTV does realtime goo'ing of the video input",
@@ -264,5 +349,6 @@ gst_warptv_class_init (GstWarpTVClass * klass)
 static void
 gst_warptv_init (GstWarpTV * warptv)
 {
-  /* nothing to do */
+  warptv->n_threads = DEFAULT_N_THREADS;
+  gst_video_bands_init (&warptv->bands);
 }
@@ -28,6 +28,7 @@
 
 #include <gst/video/video.h>
 #include <gst/video/gstvideofilter.h>
+#include <gst/video-bands-private.h>
 
 G_BEGIN_DECLS
 
@@ -53,6 +54,9 @@ struct _GstWarpTV
   gint32 *disttable;
   gint32 ctable[1024];
   gint tval;
+
+  guint n_threads;
+  GstVideoBands bands;
 };
 
 struct _GstWarpTVClass
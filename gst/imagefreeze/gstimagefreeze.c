@@ -61,6 +61,7 @@ enum
 static void gst_image_freeze_finalize (GObject * object);
 
 static void gst_image_freeze_reset (GstImageFreeze * self);
+static void gst_image_freeze_clear_repeat_buffers (GstImageFreeze * self);
 
 static GstStateChangeReturn gst_image_freeze_change_state (GstElement * element,
     GstStateChange transition);
@@ -211,6 +212,7 @@ gst_image_freeze_reset (GstImageFreeze * self)
 
   g_mutex_lock (&self->lock);
   gst_buffer_replace (&self->buffer, NULL);
+  gst_image_freeze_clear_repeat_buffers (self);
   gst_caps_replace (&self->buffer_caps, NULL);
   gst_caps_replace (&self->current_caps, NULL);
   self->num_buffers_left = self->num_buffers;
@@ -849,6 +851,69 @@ gst_image_freeze_get_property (GObject * object, guint prop_id, GValue * value,
   }
 }
 
+/* Must be called with the lock */
+static void
+gst_image_freeze_clear_repeat_buffers (GstImageFreeze * self)
+{
+  guint i;
+
+  for (i = 0; i < GST_IMAGE_FREEZE_REPEAT_BUFFERS; i++)
+    gst_clear_buffer (&self->repeat_buffers[i]);
+  self->repeat_next = 0;
+  self->buffer_cookie++;
+}
+
+/* Returns a previously pushed buffer that downstream released, if any.
+ * Must be called with the lock */
+static GstBuffer *
+gst_image_freeze_take_repeat_buffer (GstImageFreeze * self)
+{
+  GstBuffer *buffer;
+  guint i;
+
+  for (i = 0; i < GST_IMAGE_FREEZE_REPEAT_BUFFERS; i++) {
+    buffer = self->repeat_buffers[i];
+    if (buffer && gst_buffer_is_writable (buffer)) {
+      self->repeat_buffers[i] = NULL;
+      return buffer;
+    }
+  }
+
+  return NULL;
+}
+
+/* Must be called with the lock */
+static void
+gst_image_freeze_keep_repeat_buffer (GstImageFreeze * self, GstBuffer * buffer)
+{
+  guint i;
+
+  for (i = 0; i < GST_IMAGE_FREEZE_REPEAT_BUFFERS; i++) {
+    if (!self->repeat_buffers[i]) {
+      self->repeat_buffers[i] = gst_buffer_ref (buffer);
+      return;
+    }
+  }
+
+  /* all still in use downstream, forget the oldest */
+  gst_buffer_replace (&self->repeat_buffers[self->repeat_next], buffer);
+  self->repeat_next = (self->repeat_next + 1) % GST_IMAGE_FREEZE_REPEAT_BUFFERS;
+}
+
+static gboolean
+gst_image_freeze_buffer_is_shareable (GstBuffer * buffer)
+{
+  guint i, n = gst_buffer_n_memory (buffer);
+
+  for (i = 0; i < n; i++) {
+    if (GST_MEMORY_FLAG_IS_SET (gst_buffer_peek_memory (buffer, i),
+            GST_MEMORY_FLAG_NO_SHARE))
+      return FALSE;
+  }
+
+  return TRUE;
+}
+
 static GstFlowReturn
 gst_image_freeze_sink_chain (GstPad * pad, GstObject * parent,
     GstBuffer * buffer)
@@ -870,7 +935,18 @@ gst_image_freeze_sink_chain (GstPad * pad, GstObject * parent,
     return GST_FLOW_NOT_NEGOTIATED;
   }
 
+  /* Copying a buffer copies the memory that may not be shared, which would
+   * make every repeated frame a full copy. Copy it only once here. */
+  if (!gst_image_freeze_buffer_is_shareable (buffer)) {
+    GstBuffer *copy = gst_buffer_copy_deep (buffer);
+
+    GST_DEBUG_OBJECT (pad, "Copying buffer with memory that can't be shared");
+    gst_buffer_unref (buffer);
+    buffer = copy;
+  }
+
   gst_buffer_replace (&self->buffer, buffer);
+  gst_image_freeze_clear_repeat_buffers (self);
   if (!self->buffer_caps
       || !gst_caps_is_equal (self->buffer_caps, self->current_caps))
     gst_pad_mark_reconfigure (self->srcpad);
@@ -888,7 +964,8 @@ static void
 gst_image_freeze_src_loop (GstPad * pad)
 {
   GstImageFreeze *self = GST_IMAGE_FREEZE (GST_PAD_PARENT (pad));
-  GstBuffer *buffer;
+  GstBuffer *buffer, *repeat;
+  guint cookie;
   guint64 offset;
   GstClockTime timestamp, timestamp_end;
   guint64 cstart, cstop;
@@ -942,7 +1019,17 @@ gst_image_freeze_src_loop (GstPad * pad)
       self->num_buffers_left--;
     }
   }
-  buffer = gst_buffer_make_writable (buffer);
+
+  /* Push a buffer again if downstream released it, otherwise make a new one
+   * sharing the memory. Neither copies the image. */
+  cookie = self->buffer_cookie;
+  repeat = gst_image_freeze_take_repeat_buffer (self);
+  if (repeat) {
+    gst_buffer_unref (buffer);
+    buffer = repeat;
+  } else {
+    buffer = gst_buffer_make_writable (buffer);
+  }
   g_mutex_unlock (&self->lock);
 
   if (self->need_segment) {
@@ -1111,6 +1198,12 @@ gst_image_freeze_src_loop (GstPad * pad)
       GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_DISCONT);
     else
       GST_BUFFER_FLAG_UNSET (buffer, GST_BUFFER_FLAG_DISCONT);
+
+    g_mutex_lock (&self->lock);
+    if (cookie == self->buffer_cookie)
+      gst_image_freeze_keep_repeat_buffer (self, buffer);
+    g_mutex_unlock (&self->lock);
+
     flow_ret = gst_pad_push (self->srcpad, buffer);
     GST_DEBUG_OBJECT (pad, "Pushing buffer resulted in %s",
         gst_flow_get_name (flow_ret));
@@ -36,6 +36,9 @@ G_BEGIN_DECLS
 #define GST_IS_IMAGE_FREEZE_CLASS(klass) \
   (G_TYPE_CHECK_CLASS_TYPE((klass),GST_TYPE_IMAGE_FREEZE))
 
+/* output buffers kept around to be pushed again */
+#define GST_IMAGE_FREEZE_REPEAT_BUFFERS 4
+
 typedef struct _GstImageFreeze GstImageFreeze;
 typedef struct _GstImageFreezeClass GstImageFreezeClass;
 
@@ -51,6 +54,12 @@ struct _GstImageFreeze
   GstBuffer *buffer;
   GstCaps *buffer_caps, *current_caps;
 
+  /* buffers pushed downstream that are re-timestamped and pushed again once
+   * downstream released them, and a counter of input buffer changes */
+  GstBuffer *repeat_buffers[GST_IMAGE_FREEZE_REPEAT_BUFFERS];
+  guint repeat_next;
+  guint buffer_cookie;
+
   gboolean negotiated_framerate;
   gint fps_n, fps_d;
 
@@ -215,6 +215,10 @@ gst_rtp_L16_depay_setcaps (GstRTPBaseDepayload * depayload, GstCaps * caps)
     info->flags |= GST_AUDIO_FLAG_UNPOSITIONED;
   }
 
+  rtpL16depay->reorder = order &&
+      gst_rtp_channels_get_reorder_map (channels, info->position, order->pos,
+      rtpL16depay->reorder_map);
+
   srccaps = gst_audio_info_to_caps (info);
   res = gst_pad_set_caps (depayload->srcpad, srccaps);
   gst_caps_unref (srccaps);
@@ -261,11 +265,12 @@ gst_rtp_L16_depay_process (GstRTPBaseDepayload * depayload, GstRTPBuffer * rtp)
   if (payload_len % info->bpf != 0)
     goto wrong_payload_size;
 
-  if (rtpL16depay->order &&
-      !gst_audio_buffer_reorder_channels (outbuf,
-          info->finfo->format, info->channels,
-          info->position, rtpL16depay->order->pos)) {
-    goto reorder_failed;
+  /* copy and reorder the samples in one pass */
+  if (rtpL16depay->reorder) {
+    outbuf = gst_rtp_channels_reorder_buffer (outbuf, 2, info->channels,
+        rtpL16depay->reorder_map);
+    if (outbuf == NULL)
+      goto reorder_failed;
   }
 
   gst_rtp_drop_non_audio_meta (rtpL16depay, outbuf);
@@ -290,7 +295,6 @@ reorder_failed:
   {
     GST_ELEMENT_ERROR (rtpL16depay, STREAM, DECODE,
         ("Channel reordering failed."), (NULL));
-    gst_buffer_unref (outbuf);
     return NULL;
   }
 }
@@ -193,6 +193,10 @@ gst_rtp_L24_depay_setcaps (GstRTPBaseDepayload * depayload, GstCaps * caps)
     info->flags |= GST_AUDIO_FLAG_UNPOSITIONED;
   }
 
+  rtpL24depay->reorder = order &&
+      gst_rtp_channels_get_reorder_map (channels, info->position, order->pos,
+      rtpL24depay->reorder_map);
+
   srccaps = gst_audio_info_to_caps (info);
   res = gst_pad_set_caps (depayload->srcpad, srccaps);
   gst_caps_unref (srccaps);
@@ -236,11 +240,12 @@ gst_rtp_L24_depay_process (GstRTPBaseDepayload * depayload, GstRTPBuffer * rtp)
   if (outbuf) {
     gst_rtp_drop_non_audio_meta (rtpL24depay, outbuf);
   }
-  if (rtpL24depay->order &&
-      !gst_audio_buffer_reorder_channels (outbuf,
-          rtpL24depay->info.finfo->format, rtpL24depay->info.channels,
-          rtpL24depay->info.position, rtpL24depay->order->pos)) {
-    goto reorder_failed;
+  /* copy and reorder the samples in one pass */
+  if (rtpL24depay->reorder) {
+    outbuf = gst_rtp_channels_reorder_buffer (outbuf, 3,
+        rtpL24depay->info.channels, rtpL24depay->reorder_map);
+    if (outbuf == NULL)
+      goto reorder_failed;
   }
 
   return outbuf;
@@ -308,3 +308,139 @@ gst_rtp_channels_create_default (gint channels, GstAudioChannelPosition * posn)
   for (i = 0; i < channels; i++)
     posn[i] = GST_AUDIO_CHANNEL_POSITION_NONE;
 }
+
+/**
+ * gst_rtp_channels_get_reorder_map:
+ * @channels: the amount of channels
+ * @from: the channel positions to reorder from
+ * @to: the channel positions to reorder to
+ * @reorder_map: (out): the reorder map for gst_rtp_channels_reorder()
+ *
+ * Get the map to reorder samples from @from to @to, see
+ * gst_audio_get_channel_reorder_map(). This is meant to be done once when
+ * the caps are set instead of for every buffer.
+ *
+ * Returns: %TRUE when the samples need to be reordered, %FALSE when the
+ * positions are in the same order or can't be mapped.
+ */
+gboolean
+gst_rtp_channels_get_reorder_map (gint channels,
+    const GstAudioChannelPosition * from, const GstAudioChannelPosition * to,
+    gint * reorder_map)
+{
+  gint i;
+
+  g_return_val_if_fail (channels > 0 && channels <= 64, FALSE);
+
+  if (!gst_audio_get_channel_reorder_map (channels, from, to, reorder_map))
+    return FALSE;
+
+  for (i = 0; i < channels; i++) {
+    if (reorder_map[i] != i)
+      return TRUE;
+  }
+  return FALSE;
+}
+
+/* the sample size is a constant in the inlined copies, so that they become
+ * plain loads and stores instead of calls to memcpy */
+static inline void
+reorder_frames (const guint8 * src, guint8 * dest, gsize n_frames, gint bps,
+    gint channels, const gint * offsets)
+{
+  gsize bpf = bps * channels;
+  gsize f;
+  gint i;
+
+  for (f = 0; f < n_frames; f++) {
+    for (i = 0; i < channels; i++)
+      memcpy (dest + offsets[i], src + i * bps, bps);
+    src += bpf;
+    dest += bpf;
+  }
+}
+
+/**
+ * gst_rtp_channels_reorder:
+ * @src: the interleaved samples to reorder
+ * @dest: the memory for the reordered samples, must not overlap with @src
+ * @n_frames: the number of frames in @src
+ * @bps: the bytes per sample
+ * @channels: the amount of channels
+ * @reorder_map: the map from gst_rtp_channels_get_reorder_map()
+ *
+ * Copy @n_frames frames from @src to @dest, moving sample i of each frame to
+ * the position @reorder_map[i]. Copying and reordering is done in one pass.
+ */
+void
+gst_rtp_channels_reorder (const guint8 * src, guint8 * dest, gsize n_frames,
+    gint bps, gint channels, const gint * reorder_map)
+{
+  gint offsets[64];
+  gint i;
+
+  g_return_if_fail (channels > 0 && channels <= 64);
+
+  for (i = 0; i < channels; i++)
+    offsets[i] = reorder_map[i] * bps;
+
+  switch (bps) {
+    case 2:
+      reorder_frames (src, dest, n_frames, 2, channels, offsets);
+      break;
+    case 3:
+      reorder_frames (src, dest, n_frames, 3, channels, offsets);
+      break;
+    case 4:
+      reorder_frames (src, dest, n_frames, 4, channels, offsets);
+      break;
+    default:
+      reorder_frames (src, dest, n_frames, bps, channels, offsets);
+      break;
+  }
+}
+
+/**
+ * gst_rtp_channels_reorder_buffer:
+ * @buffer: (transfer full): a buffer with interleaved samples
+ * @bps: the bytes per sample
+ * @channels: the amount of channels
+ * @reorder_map: the map from gst_rtp_channels_get_reorder_map()
+ *
+ * Reorder the samples of @buffer into a new buffer. @buffer is only read,
+ * so it does not need to be copied first when it is not writable.
+ *
+ * Returns: (transfer full): a new buffer with the reordered samples and the
+ * metadata of @buffer, or %NULL when @buffer could not be mapped.
+ */
+GstBuffer *
+gst_rtp_channels_reorder_buffer (GstBuffer * buffer, gint bps, gint channels,
+    const gint * reorder_map)
+{
+  GstBuffer *outbuf;
+  GstMapInfo inmap, outmap;
+  gsize n_frames;
+
+  if (!gst_buffer_map (buffer, &inmap, GST_MAP_READ)) {
+    gst_buffer_unref (buffer);
+    return NULL;
+  }
+
+  outbuf = gst_buffer_new_allocate (NULL, inmap.size, NULL);
+  gst_buffer_copy_into (outbuf, buffer, GST_BUFFER_COPY_METADATA, 0, -1);
+  gst_buffer_map (outbuf, &outmap, GST_MAP_WRITE);
+
+  n_frames = inmap.size / (bps * channels);
+  gst_rtp_channels_reorder (inmap.data, outmap.data, n_frames, bps, channels,
+      reorder_map);
+  /* a partial frame at the end is kept as it is */
+  memcpy (outmap.data + n_frames * bps * channels,
+      inmap.data + n_frames * bps * channels,
+      inmap.size - n_frames * bps * channels);
+
+  gst_buffer_unmap (outbuf, &outmap);
+  gst_buffer_unmap (buffer, &inmap);
+  gst_buffer_unref (buffer);
+
+  return outbuf;
+}
@@ -43,4 +43,16 @@ const GstRTPChannelOrder *   gst_rtp_channels_get_by_index   (gint channels, gui
 
 void                         gst_rtp_channels_create_default (gint channels, GstAudioChannelPosition *pos);
 
+gboolean                     gst_rtp_channels_get_reorder_map (gint channels,
+                                                               const GstAudioChannelPosition *from,
+                                                               const GstAudioChannelPosition *to,
+                                                               gint *reorder_map);
+void                         gst_rtp_channels_reorder        (const guint8 *src, guint8 *dest,
+                                                              gsize n_frames, gint bps,
+                                                              gint channels,
+                                                              const gint *reorder_map);
+GstBuffer *                  gst_rtp_channels_reorder_buffer (GstBuffer *buffer, gint bps,
+                                                              gint channels,
+                                                              const gint *reorder_map);
+
 #endif /* __GST_RTP_CHANNELS_H__ */
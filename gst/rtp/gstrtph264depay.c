@@ -41,12 +41,14 @@ GST_DEBUG_CATEGORY_STATIC (rtph264depay_debug);
 #define DEFAULT_ACCESS_UNIT   FALSE
 #define DEFAULT_WAIT_FOR_KEYFRAME FALSE
 #define DEFAULT_REQUEST_KEYFRAME FALSE
+#define DEFAULT_ZERO_COPY FALSE
 
 enum
 {
   PROP_0,
   PROP_WAIT_FOR_KEYFRAME,
   PROP_REQUEST_KEYFRAME,
+  PROP_ZERO_COPY,
 };
 
 
@@ -126,6 +128,9 @@ gst_rtp_h264_depay_set_property (GObject * object, guint prop_id,
     case PROP_REQUEST_KEYFRAME:
       self->request_keyframe = g_value_get_boolean (value);
       break;
+    case PROP_ZERO_COPY:
+      self->zero_copy = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -145,6 +150,9 @@ gst_rtp_h264_depay_get_property (GObject * object, guint prop_id,
     case PROP_REQUEST_KEYFRAME:
       g_value_set_boolean (value, self->request_keyframe);
       break;
+    case PROP_ZERO_COPY:
+      g_value_set_boolean (value, self->zero_copy);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -194,6 +202,23 @@ gst_rtp_h264_depay_class_init (GstRtpH264DepayClass * klass)
           DEFAULT_REQUEST_KEYFRAME,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstRtpH264Depay:zero-copy:
+   *
+   * Reference the RTP payloads from the output buffers instead of copying
+   * them. NAL units and access units are then made of several memories. If
+   * one is spread over more memories than a buffer can hold, the memories
+   * that don't fit are merged into one, which copies that part once. Every
+   * NAL unit or access unit is still pushed as a single buffer.
+   *
+   * Since: 1.24
+   */
+  g_object_class_install_property (gobject_class, PROP_ZERO_COPY,
+      g_param_spec_boolean ("zero-copy", "Zero Copy",
+          "Reference the RTP payloads from the output buffers instead of "
+          "copying them", DEFAULT_ZERO_COPY,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_add_static_pad_template (gstelement_class,
       &gst_rtp_h264_depay_src_template);
   gst_element_class_add_static_pad_template (gstelement_class,
@@ -223,6 +248,7 @@ gst_rtp_h264_depay_init (GstRtpH264Depay * rtph264depay)
       (GDestroyNotify) gst_buffer_unref);
   rtph264depay->wait_for_keyframe = DEFAULT_WAIT_FOR_KEYFRAME;
   rtph264depay->request_keyframe = DEFAULT_REQUEST_KEYFRAME;
+  rtph264depay->zero_copy = DEFAULT_ZERO_COPY;
 }
 
 static void
@@ -894,6 +920,70 @@ gst_rtp_h264_depay_allocate_output_buffer (GstRtpH264Depay * depay, gsize size)
   return buffer;
 }
 
+/* In zero-copy mode, get the first @size bytes of @adapter as one buffer
+ * that references the memories of the queued buffers. If there are more
+ * memories than fit in a buffer, the ones that don't fit are merged into
+ * one, so only that part is copied. */
+static GstBuffer *
+gst_rtp_h264_depay_take_memories (GstRtpH264Depay * rtph264depay,
+    GstAdapter * adapter, guint size)
+{
+  GstBufferList *list;
+  GstBuffer *outbuf = NULL, *buf;
+  guint b, n_bufs, n_mem = 0, max_memory;
+  gsize taken = 0;
+
+  if (!rtph264depay->zero_copy || size == 0)
+    return NULL;
+
+  list = gst_adapter_get_buffer_list (adapter, size);
+  n_bufs = gst_buffer_list_length (list);
+  for (b = 0; b < n_bufs; ++b)
+    n_mem += gst_buffer_n_memory (gst_buffer_list_get (list, b));
+
+  /* keep the last memory for the merged rest */
+  max_memory = gst_buffer_get_max_memory ();
+  if (n_mem > max_memory)
+    max_memory--;
+
+  n_mem = 0;
+  for (b = 0; b < n_bufs; ++b) {
+    buf = gst_buffer_list_get (list, b);
+
+    n_mem += gst_buffer_n_memory (buf);
+    if (n_mem > max_memory)
+      break;
+
+    if (outbuf == NULL) {
+      outbuf = gst_buffer_ref (buf);
+    } else {
+      outbuf = gst_buffer_append (outbuf, gst_buffer_ref (buf));
+      gst_rtp_copy_video_meta (rtph264depay, outbuf, buf);
+    }
+    taken += gst_buffer_get_size (buf);
+  }
+  gst_buffer_list_unref (list);
+  gst_adapter_flush (adapter, taken);
+
+  if (taken < size) {
+    GST_LOG_OBJECT (rtph264depay, "merging the last %" G_GSIZE_FORMAT
+        " bytes into one memory", size - taken);
+
+    buf = gst_adapter_take_buffer (adapter, size - taken);
+    if (outbuf == NULL) {
+      outbuf = gst_buffer_new ();
+      gst_buffer_copy_into (outbuf, buf, GST_BUFFER_COPY_METADATA, 0, -1);
+    } else {
+      outbuf = gst_buffer_make_writable (outbuf);
+      gst_rtp_copy_video_meta (rtph264depay, outbuf, buf);
+    }
+    gst_buffer_append_memory (outbuf, gst_buffer_get_all_memory (buf));
+    gst_buffer_unref (buf);
+  }
+
+  return outbuf;
+}
+
 static GstBuffer *
 gst_rtp_h264_complete_au (GstRtpH264Depay * rtph264depay,
     GstClockTime * out_timestamp, gboolean * out_keyframe)
@@ -908,6 +998,11 @@ gst_rtp_h264_complete_au (GstRtpH264Depay * rtph264depay,
   GST_DEBUG_OBJECT (rtph264depay, "taking completed AU");
   outsize = gst_adapter_available (rtph264depay->picture_adapter);
 
+  outbuf = gst_rtp_h264_depay_take_memories (rtph264depay,
+      rtph264depay->picture_adapter, outsize);
+  if (outbuf != NULL)
+    goto done;
+
   outbuf = gst_rtp_h264_depay_allocate_output_buffer (rtph264depay, outsize);
 
   if (outbuf == NULL)
@@ -942,6 +1037,7 @@ gst_rtp_h264_complete_au (GstRtpH264Depay * rtph264depay,
   gst_buffer_list_unref (list);
   gst_buffer_unmap (outbuf, &outmap);
 
+done:
   *out_timestamp = rtph264depay->last_ts;
   *out_keyframe = rtph264depay->last_keyframe;
 
@@ -990,16 +1086,17 @@ gst_rtp_h264_depay_handle_nal (GstRtpH264Depay * rtph264depay, GstBuffer * nal,
 {
   GstRTPBaseDepayload *depayload = GST_RTP_BASE_DEPAYLOAD (rtph264depay);
   gint nal_type;
-  GstMapInfo map;
+  guint8 header[6] = { 0, };
   GstBuffer *outbuf = NULL;
   GstClockTime out_timestamp;
   gboolean keyframe, out_keyframe;
 
-  gst_buffer_map (nal, &map, GST_MAP_READ);
-  if (G_UNLIKELY (map.size < 5))
+  /* only look at the start of the NAL, it can be made of several memories
+   * that we don't want to merge */
+  if (G_UNLIKELY (gst_buffer_extract (nal, 0, header, sizeof (header)) < 5))
     goto short_nal;
 
-  nal_type = map.data[4] & 0x1f;
+  nal_type = header[4] & 0x1f;
   GST_DEBUG_OBJECT (rtph264depay, "handle NAL type %d", nal_type);
 
   keyframe = NAL_TYPE_IS_KEY (nal_type);
@@ -1012,7 +1109,6 @@ gst_rtp_h264_depay_handle_nal (GstRtpH264Depay * rtph264depay, GstBuffer * nal,
       gst_rtp_h264_depay_add_sps_pps (rtph264depay,
           gst_buffer_copy_region (nal, GST_BUFFER_COPY_ALL,
               4, gst_buffer_get_size (nal) - 4));
-      gst_buffer_unmap (nal, &map);
       gst_buffer_unref (nal);
       return;
     } else if (rtph264depay->sps->len == 0 || rtph264depay->pps->len == 0) {
@@ -1023,7 +1119,6 @@ gst_rtp_h264_depay_handle_nal (GstRtpH264Depay * rtph264depay, GstBuffer * nal,
           gst_event_new_custom (GST_EVENT_CUSTOM_UPSTREAM,
               gst_structure_new ("GstForceKeyUnit",
                   "all-headers", G_TYPE_BOOLEAN, TRUE, NULL)));
-      gst_buffer_unmap (nal, &map);
       gst_buffer_unref (nal);
       return;
     }
@@ -1049,7 +1144,7 @@ gst_rtp_h264_depay_handle_nal (GstRtpH264Depay * rtph264depay, GstBuffer * nal,
     if (nal_type == 1 || nal_type == 2 || nal_type == 5) {
       /* we have a picture start */
       start = TRUE;
-      if (map.data[5] & 0x80) {
+      if (header[5] & 0x80) {
         /* first_mb_in_slice == 0 completes a picture */
         complete = TRUE;
       }
@@ -1067,8 +1162,6 @@ gst_rtp_h264_depay_handle_nal (GstRtpH264Depay * rtph264depay, GstBuffer * nal,
             &out_keyframe);
     }
     /* add to adapter */
-    gst_buffer_unmap (nal, &map);
-
     if (!rtph264depay->picture_start && start && out_keyframe)
       rtph264depay->waiting_for_keyframe = FALSE;
 
@@ -1085,7 +1178,6 @@ gst_rtp_h264_depay_handle_nal (GstRtpH264Depay * rtph264depay, GstBuffer * nal,
     /* no merge, output is input nal */
     GST_DEBUG_OBJECT (depayload, "using NAL as output");
     outbuf = nal;
-    gst_buffer_unmap (nal, &map);
   }
 
   if (outbuf) {
@@ -1106,7 +1198,6 @@ gst_rtp_h264_depay_handle_nal (GstRtpH264Depay * rtph264depay, GstBuffer * nal,
 short_nal:
   {
     GST_WARNING_OBJECT (depayload, "dropping short NAL");
-    gst_buffer_unmap (nal, &map);
     gst_buffer_unref (nal);
     return;
   }
@@ -1116,25 +1207,26 @@ static void
 gst_rtp_h264_finish_fragmentation_unit (GstRtpH264Depay * rtph264depay)
 {
   guint outsize;
-  GstMapInfo map;
+  guint8 prefix[4];
   GstBuffer *outbuf;
 
   outsize = gst_adapter_available (rtph264depay->adapter);
-  outbuf = gst_adapter_take_buffer (rtph264depay->adapter, outsize);
+  outbuf = gst_rtp_h264_depay_take_memories (rtph264depay,
+      rtph264depay->adapter, outsize);
+  if (outbuf == NULL)
+    outbuf = gst_adapter_take_buffer (rtph264depay->adapter, outsize);
 
-  gst_buffer_map (outbuf, &map, GST_MAP_WRITE);
   GST_DEBUG_OBJECT (rtph264depay, "output %d bytes", outsize);
 
   if (rtph264depay->byte_stream) {
-    memcpy (map.data, sync_bytes, sizeof (sync_bytes));
+    memcpy (prefix, sync_bytes, sizeof (sync_bytes));
   } else {
     outsize -= 4;
-    map.data[0] = (outsize >> 24);
-    map.data[1] = (outsize >> 16);
-    map.data[2] = (outsize >> 8);
-    map.data[3] = (outsize);
+    GST_WRITE_UINT32_BE (prefix, outsize);
   }
-  gst_buffer_unmap (outbuf, &map);
+  /* only the first memory is written to */
+  outbuf = gst_buffer_make_writable (outbuf);
+  gst_buffer_fill (outbuf, 0, prefix, sizeof (prefix));
 
   rtph264depay->current_fu_type = 0;
 
@@ -1142,6 +1234,49 @@ gst_rtp_h264_finish_fragmentation_unit (GstRtpH264Depay * rtph264depay)
       rtph264depay->fu_timestamp, rtph264depay->fu_marker);
 }
 
+/* Make a NAL buffer with @prefix followed by @size bytes of the RTP payload,
+ * starting at @offset. In zero-copy mode the payload is referenced instead of
+ * copied. */
+static GstBuffer *
+gst_rtp_h264_depay_new_nal (GstRtpH264Depay * rtph264depay, GstRTPBuffer * rtp,
+    const guint8 * prefix, guint prefix_len, guint offset, guint size)
+{
+  GstBuffer *nal;
+
+  if (rtph264depay->zero_copy) {
+    GstBuffer *payload;
+
+    payload = gst_buffer_copy_region (rtp->buffer, GST_BUFFER_COPY_MEMORY,
+        gst_rtp_buffer_get_header_len (rtp) + offset, size);
+
+    if (prefix_len == 0) {
+      nal = payload;
+    } else {
+      if (prefix == sync_bytes)
+        nal = gst_buffer_new_wrapped_full (GST_MEMORY_FLAG_READONLY,
+            (gpointer) sync_bytes, sizeof (sync_bytes), 0,
+            sizeof (sync_bytes), NULL, NULL);
+      else
+        nal = gst_buffer_new_memdup (prefix, prefix_len);
+      nal = gst_buffer_append (nal, payload);
+    }
+  } else {
+    guint8 *payload = gst_rtp_buffer_get_payload (rtp);
+    GstMapInfo map;
+
+    nal = gst_buffer_new_and_alloc (prefix_len + size);
+    gst_buffer_map (nal, &map, GST_MAP_WRITE);
+    if (prefix_len)
+      memcpy (map.data, prefix, prefix_len);
+    memcpy (map.data + prefix_len, payload + offset, size);
+    gst_buffer_unmap (nal, &map);
+  }
+
+  gst_rtp_copy_video_meta (rtph264depay, nal, rtp->buffer);
+
+  return nal;
+}
+
 static GstBuffer *
 gst_rtp_h264_depay_process (GstRTPBaseDepayload * depayload, GstRTPBuffer * rtp)
 {
@@ -1174,10 +1309,10 @@ gst_rtp_h264_depay_process (GstRTPBaseDepayload * depayload, GstRTPBuffer * rtp)
 
   {
     gint payload_len;
-    guint8 *payload;
+    guint8 *payload, *payload_start;
     guint header_len;
     guint8 nal_ref_idc;
-    GstMapInfo map;
+    guint8 prefix[5];
     guint outsize, nalu_size;
     GstClockTime timestamp;
     gboolean marker;
@@ -1185,7 +1320,7 @@ gst_rtp_h264_depay_process (GstRTPBaseDepayload * depayload, GstRTPBuffer * rtp)
     timestamp = GST_BUFFER_PTS (rtp->buffer);
 
     payload_len = gst_rtp_buffer_get_payload_len (rtp);
-    payload = gst_rtp_buffer_get_payload (rtp);
+    payload = payload_start = gst_rtp_buffer_get_payload (rtp);
     marker = gst_rtp_buffer_get_marker (rtp);
 
     GST_DEBUG_OBJECT (rtph264depay, "receiving %d bytes", payload_len);
@@ -1253,26 +1388,19 @@ gst_rtp_h264_depay_process (GstRTPBaseDepayload * depayload, GstRTPBuffer * rtp)
           if (nalu_size > (payload_len - 2))
             nalu_size = payload_len - 2;
 
-          outsize = nalu_size + sizeof (sync_bytes);
-          outbuf = gst_buffer_new_and_alloc (outsize);
-
-          gst_buffer_map (outbuf, &map, GST_MAP_WRITE);
-          if (rtph264depay->byte_stream) {
-            memcpy (map.data, sync_bytes, sizeof (sync_bytes));
-          } else {
-            map.data[0] = map.data[1] = 0;
-            map.data[2] = payload[0];
-            map.data[3] = payload[1];
+          if (!rtph264depay->byte_stream) {
+            prefix[0] = prefix[1] = 0;
+            prefix[2] = payload[0];
+            prefix[3] = payload[1];
           }
 
           /* strip NALU size */
           payload += 2;
           payload_len -= 2;
 
-          memcpy (map.data + sizeof (sync_bytes), payload, nalu_size);
-          gst_buffer_unmap (outbuf, &map);
-
-          gst_rtp_copy_video_meta (rtph264depay, outbuf, rtp->buffer);
+          outbuf = gst_rtp_h264_depay_new_nal (rtph264depay, rtp,
+              rtph264depay->byte_stream ? sync_bytes : prefix,
+              sizeof (sync_bytes), payload - payload_start, nalu_size);
 
           if (payload_len - nalu_size <= 2)
             last = TRUE;
@@ -1336,21 +1464,15 @@ gst_rtp_h264_depay_process (GstRTPBaseDepayload * depayload, GstRTPBuffer * rtp)
           /* reconstruct NAL header */
           nal_header = (payload[0] & 0xe0) | (payload[1] & 0x1f);
 
-          /* strip type header, keep FU header, we'll reuse it to reconstruct
-           * the NAL header. */
-          payload += 1;
-          payload_len -= 1;
-
-          nalu_size = payload_len;
-          outsize = nalu_size + sizeof (sync_bytes);
-          outbuf = gst_buffer_new_and_alloc (outsize);
-
-          gst_buffer_map (outbuf, &map, GST_MAP_WRITE);
-          memcpy (map.data + sizeof (sync_bytes), payload, nalu_size);
-          map.data[sizeof (sync_bytes)] = nal_header;
-          gst_buffer_unmap (outbuf, &map);
+          /* leave room for the sync bytes or NAL size, followed by the
+           * reconstructed NAL header. Strip the FU indicator and header. */
+          memset (prefix, 0, sizeof (sync_bytes));
+          prefix[sizeof (sync_bytes)] = nal_header;
 
-          gst_rtp_copy_video_meta (rtph264depay, outbuf, rtp->buffer);
+          nalu_size = payload_len - 2;
+          outsize = nalu_size + sizeof (prefix);
+          outbuf = gst_rtp_h264_depay_new_nal (rtph264depay, rtp, prefix,
+              sizeof (prefix), payload - payload_start + 2, nalu_size);
 
           GST_DEBUG_OBJECT (rtph264depay, "queueing %d bytes", outsize);
 
@@ -1381,10 +1503,8 @@ gst_rtp_h264_depay_process (GstRTPBaseDepayload * depayload, GstRTPBuffer * rtp)
           payload_len -= 2;
 
           outsize = payload_len;
-          outbuf = gst_buffer_new_and_alloc (outsize);
-          gst_buffer_fill (outbuf, 0, payload, outsize);
-
-          gst_rtp_copy_video_meta (rtph264depay, outbuf, rtp->buffer);
+          outbuf = gst_rtp_h264_depay_new_nal (rtph264depay, rtp, NULL, 0,
+              payload - payload_start, outsize);
 
           GST_DEBUG_OBJECT (rtph264depay, "queueing %d bytes", outsize);
 
@@ -1407,21 +1527,14 @@ gst_rtp_h264_depay_process (GstRTPBaseDepayload * depayload, GstRTPBuffer * rtp)
         /* 1-23   NAL unit  Single NAL unit packet per H.264   5.6 */
         /* the entire payload is the output buffer */
         nalu_size = payload_len;
-        outsize = nalu_size + sizeof (sync_bytes);
-        outbuf = gst_buffer_new_and_alloc (outsize);
-
-        gst_buffer_map (outbuf, &map, GST_MAP_WRITE);
-        if (rtph264depay->byte_stream) {
-          memcpy (map.data, sync_bytes, sizeof (sync_bytes));
-        } else {
-          map.data[0] = map.data[1] = 0;
-          map.data[2] = nalu_size >> 8;
-          map.data[3] = nalu_size & 0xff;
+        if (!rtph264depay->byte_stream) {
+          prefix[0] = prefix[1] = 0;
+          prefix[2] = nalu_size >> 8;
+          prefix[3] = nalu_size & 0xff;
         }
-        memcpy (map.data + sizeof (sync_bytes), payload, nalu_size);
-        gst_buffer_unmap (outbuf, &map);
-
-        gst_rtp_copy_video_meta (rtph264depay, outbuf, rtp->buffer);
+        outbuf = gst_rtp_h264_depay_new_nal (rtph264depay, rtp,
+            rtph264depay->byte_stream ? sync_bytes : prefix,
+            sizeof (sync_bytes), 0, nalu_size);
 
         gst_rtp_h264_depay_handle_nal (rtph264depay, outbuf, timestamp, marker);
         break;
@@ -75,6 +75,9 @@ struct _GstRtpH264Depay
   gboolean wait_for_keyframe;
   gboolean request_keyframe;
   gboolean waiting_for_keyframe;
+
+  /* reference RTP payloads instead of copying them */
+  gboolean zero_copy;
 };
 
 struct _GstRtpH264DepayClass
@@ -35,6 +35,7 @@
 #include "gstrtph264pay.h"
 #include "gstrtputils.h"
 #include "gstbuffermemory.h"
+#include "gstrtpheaderpool.h"
 
 
 #define IDR_TYPE_ID    5
@@ -101,6 +102,7 @@ GST_STATIC_PAD_TEMPLATE ("src",
 #define DEFAULT_SPROP_PARAMETER_SETS    NULL
 #define DEFAULT_CONFIG_INTERVAL         0
 #define DEFAULT_AGGREGATE_MODE          GST_RTP_H264_AGGREGATE_NONE
+#define DEFAULT_BUFFER_LIST             FALSE
 
 enum
 {
@@ -108,6 +110,7 @@ enum
   PROP_SPROP_PARAMETER_SETS,
   PROP_CONFIG_INTERVAL,
   PROP_AGGREGATE_MODE,
+  PROP_BUFFER_LIST,
 };
 
 static void gst_rtp_h264_pay_finalize (GObject * object);
@@ -193,6 +196,25 @@ gst_rtp_h264_pay_class_init (GstRtpH264PayClass * klass)
           DEFAULT_AGGREGATE_MODE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)
       );
 
+  /**
+   * GstRtpH264Pay:buffer-list
+   *
+   * Push all RTP packets made from one input buffer, a whole access unit
+   * for au aligned input, downstream as a single buffer list. The FU-A
+   * headers are then taken from a pool instead of being allocated for every
+   * packet.
+   *
+   * This lets sinks that handle buffer lists, like multiudpsink, send a full
+   * frame at once.
+   *
+   * Since: 1.24
+   */
+  g_object_class_install_property (G_OBJECT_CLASS (klass),
+      PROP_BUFFER_LIST,
+      g_param_spec_boolean ("buffer-list", "Buffer List",
+          "Push the packets of an input buffer as one buffer list",
+          DEFAULT_BUFFER_LIST, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gobject_class->finalize = gst_rtp_h264_pay_finalize;
 
   gst_element_class_add_static_pad_template (gstelement_class,
@@ -231,6 +253,7 @@ gst_rtp_h264_pay_init (GstRtpH264Pay * rtph264pay)
   rtph264pay->last_spspps = -1;
   rtph264pay->spspps_interval = DEFAULT_CONFIG_INTERVAL;
   rtph264pay->aggregate_mode = DEFAULT_AGGREGATE_MODE;
+  rtph264pay->buffer_list = DEFAULT_BUFFER_LIST;
   rtph264pay->delta_unit = FALSE;
   rtph264pay->discont = FALSE;
 
@@ -263,6 +286,8 @@ gst_rtp_h264_pay_finalize (GObject * object)
 
   g_object_unref (rtph264pay->adapter);
   gst_rtp_h264_pay_reset_bundle (rtph264pay);
+  g_clear_pointer (&rtph264pay->au_list, gst_buffer_list_unref);
+  gst_rtp_header_pool_clear (&rtph264pay->header_pool);
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
@@ -1025,6 +1050,38 @@ gst_rtp_h264_pay_payload_nal (GstRTPBasePayload * basepayload,
       end_of_au, delta_unit, discont, nal_header);
 }
 
+/* Push @outbuf, or add it to the list of the current input buffer in
+ * buffer-list mode */
+static GstFlowReturn
+gst_rtp_h264_pay_push (GstRtpH264Pay * rtph264pay, GstBuffer * outbuf)
+{
+  if (rtph264pay->buffer_list) {
+    if (rtph264pay->au_list == NULL)
+      rtph264pay->au_list = gst_buffer_list_new ();
+    gst_buffer_list_add (rtph264pay->au_list, outbuf);
+    return GST_FLOW_OK;
+  }
+
+  return gst_rtp_base_payload_push (GST_RTP_BASE_PAYLOAD (rtph264pay), outbuf);
+}
+
+static GstFlowReturn
+gst_rtp_h264_pay_send_au_list (GstRtpH264Pay * rtph264pay)
+{
+  GstBufferList *list = rtph264pay->au_list;
+
+  if (list == NULL)
+    return GST_FLOW_OK;
+
+  rtph264pay->au_list = NULL;
+
+  GST_DEBUG_OBJECT (rtph264pay, "sending list of %u packets",
+      gst_buffer_list_length (list));
+
+  return gst_rtp_base_payload_push_list (GST_RTP_BASE_PAYLOAD (rtph264pay),
+      list);
+}
+
 static GstFlowReturn
 gst_rtp_h264_pay_payload_nal_fragment (GstRTPBasePayload * basepayload,
     GstBuffer * paybuf, GstClockTime dts, GstClockTime pts, gboolean end_of_au,
@@ -1032,7 +1089,7 @@ gst_rtp_h264_pay_payload_nal_fragment (GstRTPBasePayload * basepayload,
 {
   GstRtpH264Pay *rtph264pay;
   guint mtu, size, max_fragment_size, max_fragments, ii, pos;
-  GstBuffer *outbuf;
+  GstBuffer *outbuf, *header = NULL;
   guint8 *payload;
   GstBufferList *list = NULL;
   GstRTPBuffer rtp = { NULL };
@@ -1055,7 +1112,17 @@ gst_rtp_h264_pay_payload_nal_fragment (GstRTPBasePayload * basepayload,
   /* We keep 2 bytes for FU indicator and FU Header */
   max_fragment_size = gst_rtp_buffer_calc_payload_len (mtu - 2, 0, 0);
   max_fragments = (size + max_fragment_size - 2) / max_fragment_size;
-  list = gst_buffer_list_new_sized (max_fragments);
+
+  if (rtph264pay->buffer_list) {
+    if (rtph264pay->au_list == NULL)
+      rtph264pay->au_list = gst_buffer_list_new_sized (max_fragments);
+    list = rtph264pay->au_list;
+    /* all fragments start from a copy of this header */
+    header =
+        gst_rtp_base_payload_allocate_output_buffer (basepayload, 2, 0, 0);
+  } else {
+    list = gst_buffer_list_new_sized (max_fragments);
+  }
 
   /* Start at the NALU payload */
   for (pos = 1, ii = 0; pos < size; pos += max_fragment_size, ii++) {
@@ -1074,7 +1141,12 @@ gst_rtp_h264_pay_payload_nal_fragment (GstRTPBasePayload * basepayload,
     /* use buffer lists
      * create buffer without payload containing only the RTP header
      * (memory block at index 0) */
-    outbuf = gst_rtp_base_payload_allocate_output_buffer (basepayload, 2, 0, 0);
+    outbuf = NULL;
+    if (header)
+      outbuf = gst_rtp_header_pool_acquire (&rtph264pay->header_pool, header);
+    if (outbuf == NULL)
+      outbuf =
+          gst_rtp_base_payload_allocate_output_buffer (basepayload, 2, 0, 0);
 
     gst_rtp_buffer_map (outbuf, GST_MAP_WRITE, &rtp);
 
@@ -1121,7 +1193,13 @@ gst_rtp_h264_pay_payload_nal_fragment (GstRTPBasePayload * basepayload,
   GST_DEBUG_OBJECT (rtph264pay,
       "sending FU-A fragments: n=%u datasize=%u mtu=%u", ii, size, mtu);
 
+  gst_clear_buffer (&header);
   gst_buffer_unref (paybuf);
+
+  /* sent together with the rest of the input buffer */
+  if (list == rtph264pay->au_list)
+    return GST_FLOW_OK;
+
   return gst_rtp_base_payload_push_list (basepayload, list);
 }
 
@@ -1164,7 +1242,7 @@ gst_rtp_h264_pay_payload_nal_single (GstRTPBasePayload * basepayload,
   outbuf = gst_buffer_append (outbuf, paybuf);
 
   /* push the buffer to the next element */
-  return gst_rtp_base_payload_push (basepayload, outbuf);
+  return gst_rtp_h264_pay_push (rtph264pay, outbuf);
 }
 
 static void
@@ -1682,6 +1760,8 @@ gst_rtp_h264_pay_handle_buffer (GstRTPBasePayload * basepayload,
     ret = gst_rtp_h264_pay_send_bundle (rtph264pay, FALSE);
   }
 
+  if (ret == GST_FLOW_OK)
+    ret = gst_rtp_h264_pay_send_au_list (rtph264pay);
 
 done:
   if (!avc) {
@@ -1711,6 +1791,7 @@ gst_rtp_h264_pay_sink_event (GstRTPBasePayload * payload, GstEvent * event)
     case GST_EVENT_FLUSH_STOP:
       gst_adapter_clear (rtph264pay->adapter);
       gst_rtp_h264_pay_reset_bundle (rtph264pay);
+      g_clear_pointer (&rtph264pay->au_list, gst_buffer_list_unref);
       break;
     case GST_EVENT_CUSTOM_DOWNSTREAM:
       s = gst_event_get_structure (event);
@@ -1729,12 +1810,16 @@ gst_rtp_h264_pay_sink_event (GstRTPBasePayload * payload, GstEvent * event)
        */
       gst_rtp_h264_pay_handle_buffer (payload, NULL);
       ret = gst_rtp_h264_pay_send_bundle (rtph264pay, TRUE);
+      if (ret == GST_FLOW_OK)
+        ret = gst_rtp_h264_pay_send_au_list (rtph264pay);
       break;
     }
     case GST_EVENT_STREAM_START:
       GST_DEBUG_OBJECT (rtph264pay, "New stream detected => Clear SPS and PPS");
       gst_rtp_h264_pay_clear_sps_pps (rtph264pay);
       ret = gst_rtp_h264_pay_send_bundle (rtph264pay, TRUE);
+      if (ret == GST_FLOW_OK)
+        ret = gst_rtp_h264_pay_send_au_list (rtph264pay);
       break;
     default:
       break;
@@ -1759,6 +1844,7 @@ gst_rtp_h264_pay_change_state (GstElement * element, GstStateChange transition)
       rtph264pay->send_spspps = FALSE;
       gst_adapter_clear (rtph264pay->adapter);
       gst_rtp_h264_pay_reset_bundle (rtph264pay);
+      g_clear_pointer (&rtph264pay->au_list, gst_buffer_list_unref);
       break;
     default:
       break;
@@ -1770,6 +1856,7 @@ gst_rtp_h264_pay_change_state (GstElement * element, GstStateChange transition)
     case GST_STATE_CHANGE_PAUSED_TO_READY:
       rtph264pay->last_spspps = -1;
       gst_rtp_h264_pay_clear_sps_pps (rtph264pay);
+      gst_rtp_header_pool_clear (&rtph264pay->header_pool);
       break;
     default:
       break;
@@ -1798,6 +1885,9 @@ gst_rtp_h264_pay_set_property (GObject * object, guint prop_id,
     case PROP_AGGREGATE_MODE:
       rtph264pay->aggregate_mode = g_value_get_enum (value);
       break;
+    case PROP_BUFFER_LIST:
+      rtph264pay->buffer_list = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1822,6 +1912,9 @@ gst_rtp_h264_pay_get_property (GObject * object, guint prop_id,
     case PROP_AGGREGATE_MODE:
       g_value_set_enum (value, rtph264pay->aggregate_mode);
       break;
+    case PROP_BUFFER_LIST:
+      g_value_set_boolean (value, rtph264pay->buffer_list);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
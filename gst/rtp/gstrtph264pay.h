@@ -95,6 +95,12 @@ struct _GstRtpH264Pay
   guint bundle_size;
   gboolean bundle_contains_vcl;
   GstRTPH264AggregateMode aggregate_mode;
+
+  /* collect the packets of an input buffer in one list, with the FU-A
+   * headers taken from a pool */
+  gboolean buffer_list;
+  GstBufferList *au_list;
+  GstBufferPool *header_pool;
 };
 
 struct _GstRtpH264PayClass
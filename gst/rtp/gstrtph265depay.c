@@ -39,6 +39,13 @@ GST_DEBUG_CATEGORY_STATIC (rtph265depay_debug);
  * expressed a restriction or preference via caps */
 #define DEFAULT_STREAM_FORMAT GST_H265_STREAM_FORMAT_BYTESTREAM
 #define DEFAULT_ACCESS_UNIT   FALSE
+#define DEFAULT_ZERO_COPY     FALSE
+
+enum
+{
+  PROP_0,
+  PROP_ZERO_COPY,
+};
 
 /* 3 zero bytes syncword */
 static const guint8 sync_bytes[] = { 0, 0, 0, 1 };
@@ -119,6 +126,37 @@ static void gst_rtp_h265_depay_push (GstRtpH265Depay * rtph265depay,
     GstBuffer * outbuf, gboolean keyframe, GstClockTime timestamp,
     gboolean marker);
 
+static void
+gst_rtp_h265_depay_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstRtpH265Depay *self = GST_RTP_H265_DEPAY (object);
+
+  switch (prop_id) {
+    case PROP_ZERO_COPY:
+      self->zero_copy = g_value_get_boolean (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_rtp_h265_depay_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstRtpH265Depay *self = GST_RTP_H265_DEPAY (object);
+
+  switch (prop_id) {
+    case PROP_ZERO_COPY:
+      g_value_set_boolean (value, self->zero_copy);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
 
 static void
 gst_rtp_h265_depay_class_init (GstRtpH265DepayClass * klass)
@@ -132,6 +170,25 @@ gst_rtp_h265_depay_class_init (GstRtpH265DepayClass * klass)
   gstrtpbasedepayload_class = (GstRTPBaseDepayloadClass *) klass;
 
   gobject_class->finalize = gst_rtp_h265_depay_finalize;
+  gobject_class->set_property = gst_rtp_h265_depay_set_property;
+  gobject_class->get_property = gst_rtp_h265_depay_get_property;
+
+  /**
+   * GstRtpH265Depay:zero-copy:
+   *
+   * Reference the RTP payloads from the output buffers instead of copying
+   * them. NAL units and access units are then made of several memories. If
+   * one is spread over more memories than a buffer can hold, the memories
+   * that don't fit are merged into one, which copies that part once. Every
+   * NAL unit or access unit is still pushed as a single buffer.
+   *
+   * Since: 1.24
+   */
+  g_object_class_install_property (gobject_class, PROP_ZERO_COPY,
+      g_param_spec_boolean ("zero-copy", "Zero Copy",
+          "Reference the RTP payloads from the output buffers instead of "
+          "copying them", DEFAULT_ZERO_COPY,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
   gst_element_class_add_static_pad_template (gstelement_class,
       &gst_rtp_h265_depay_src_template);
@@ -165,6 +222,7 @@ gst_rtp_h265_depay_init (GstRtpH265Depay * rtph265depay)
       (GDestroyNotify) gst_buffer_unref);
   rtph265depay->pps = g_ptr_array_new_with_free_func (
       (GDestroyNotify) gst_buffer_unref);
+  rtph265depay->zero_copy = DEFAULT_ZERO_COPY;
 }
 
 static void
@@ -965,6 +1023,70 @@ gst_rtp_h265_depay_allocate_output_buffer (GstRtpH265Depay * depay, gsize size)
   return buffer;
 }
 
+/* In zero-copy mode, get the first @size bytes of @adapter as one buffer
+ * that references the memories of the queued buffers. If there are more
+ * memories than fit in a buffer, the ones that don't fit are merged into
+ * one, so only that part is copied. */
+static GstBuffer *
+gst_rtp_h265_depay_take_memories (GstRtpH265Depay * rtph265depay,
+    GstAdapter * adapter, guint size)
+{
+  GstBufferList *list;
+  GstBuffer *outbuf = NULL, *buf;
+  guint b, n_bufs, n_mem = 0, max_memory;
+  gsize taken = 0;
+
+  if (!rtph265depay->zero_copy || size == 0)
+    return NULL;
+
+  list = gst_adapter_get_buffer_list (adapter, size);
+  n_bufs = gst_buffer_list_length (list);
+  for (b = 0; b < n_bufs; ++b)
+    n_mem += gst_buffer_n_memory (gst_buffer_list_get (list, b));
+
+  /* keep the last memory for the merged rest */
+  max_memory = gst_buffer_get_max_memory ();
+  if (n_mem > max_memory)
+    max_memory--;
+
+  n_mem = 0;
+  for (b = 0; b < n_bufs; ++b) {
+    buf = gst_buffer_list_get (list, b);
+
+    n_mem += gst_buffer_n_memory (buf);
+    if (n_mem > max_memory)
+      break;
+
+    if (outbuf == NULL) {
+      outbuf = gst_buffer_ref (buf);
+    } else {
+      outbuf = gst_buffer_append (outbuf, gst_buffer_ref (buf));
+      gst_rtp_copy_video_meta (rtph265depay, outbuf, buf);
+    }
+    taken += gst_buffer_get_size (buf);
+  }
+  gst_buffer_list_unref (list);
+  gst_adapter_flush (adapter, taken);
+
+  if (taken < size) {
+    GST_LOG_OBJECT (rtph265depay, "merging the last %" G_GSIZE_FORMAT
+        " bytes into one memory", size - taken);
+
+    buf = gst_adapter_take_buffer (adapter, size - taken);
+    if (outbuf == NULL) {
+      outbuf = gst_buffer_new ();
+      gst_buffer_copy_into (outbuf, buf, GST_BUFFER_COPY_METADATA, 0, -1);
+    } else {
+      outbuf = gst_buffer_make_writable (outbuf);
+      gst_rtp_copy_video_meta (rtph265depay, outbuf, buf);
+    }
+    gst_buffer_append_memory (outbuf, gst_buffer_get_all_memory (buf));
+    gst_buffer_unref (buf);
+  }
+
+  return outbuf;
+}
+
 static GstBuffer *
 gst_rtp_h265_complete_au (GstRtpH265Depay * rtph265depay,
     GstClockTime * out_timestamp, gboolean * out_keyframe)
@@ -979,6 +1101,11 @@ gst_rtp_h265_complete_au (GstRtpH265Depay * rtph265depay,
   GST_DEBUG_OBJECT (rtph265depay, "taking completed AU");
   outsize = gst_adapter_available (rtph265depay->picture_adapter);
 
+  outbuf = gst_rtp_h265_depay_take_memories (rtph265depay,
+      rtph265depay->picture_adapter, outsize);
+  if (outbuf != NULL)
+    goto done;
+
   outbuf = gst_rtp_h265_depay_allocate_output_buffer (rtph265depay, outsize);
 
   if (outbuf == NULL)
@@ -1013,6 +1140,7 @@ gst_rtp_h265_complete_au (GstRtpH265Depay * rtph265depay,
   gst_buffer_list_unref (list);
   gst_buffer_unmap (outbuf, &outmap);
 
+done:
   *out_timestamp = rtph265depay->last_ts;
   *out_keyframe = rtph265depay->last_keyframe;
 
@@ -1089,16 +1217,17 @@ gst_rtp_h265_depay_handle_nal (GstRtpH265Depay * rtph265depay, GstBuffer * nal,
 {
   GstRTPBaseDepayload *depayload = GST_RTP_BASE_DEPAYLOAD (rtph265depay);
   gint nal_type;
-  GstMapInfo map;
+  guint8 header[7] = { 0, };
   GstBuffer *outbuf = NULL;
   GstClockTime out_timestamp;
   gboolean keyframe, out_keyframe;
 
-  gst_buffer_map (nal, &map, GST_MAP_READ);
-  if (G_UNLIKELY (map.size < 5))
+  /* only look at the start of the NAL, it can be made of several memories
+   * that we don't want to merge */
+  if (G_UNLIKELY (gst_buffer_extract (nal, 0, header, sizeof (header)) < 5))
     goto short_nal;
 
-  nal_type = (map.data[4] >> 1) & 0x3f;
+  nal_type = (header[4] >> 1) & 0x3f;
   GST_DEBUG_OBJECT (rtph265depay, "handle NAL type %d (RTP marker bit %d)",
       nal_type, marker);
 
@@ -1112,7 +1241,6 @@ gst_rtp_h265_depay_handle_nal (GstRtpH265Depay * rtph265depay, GstBuffer * nal,
       gst_rtp_h265_depay_add_vps_sps_pps (rtph265depay,
           gst_buffer_copy_region (nal, GST_BUFFER_COPY_ALL,
               4, gst_buffer_get_size (nal) - 4));
-      gst_buffer_unmap (nal, &map);
       gst_buffer_unref (nal);
       return;
     } else if (rtph265depay->sps->len == 0 || rtph265depay->pps->len == 0) {
@@ -1123,7 +1251,6 @@ gst_rtp_h265_depay_handle_nal (GstRtpH265Depay * rtph265depay, GstBuffer * nal,
           gst_event_new_custom (GST_EVENT_CUSTOM_UPSTREAM,
               gst_structure_new ("GstForceKeyUnit",
                   "all-headers", G_TYPE_BOOLEAN, TRUE, NULL)));
-      gst_buffer_unmap (nal, &map);
       gst_buffer_unref (nal);
       return;
     }
@@ -1142,7 +1269,7 @@ gst_rtp_h265_depay_handle_nal (GstRtpH265Depay * rtph265depay, GstBuffer * nal,
       if (NAL_TYPE_IS_CODED_SLICE_SEGMENT (nal_type)) {
         /* A NAL unit (X) ends an access unit if the next-occurring VCL NAL unit (Y) has the high-order bit of the first byte after its NAL unit header equal to 1 */
         start = TRUE;
-        if (((map.data[6] >> 7) & 0x01) == 1) {
+        if (((header[6] >> 7) & 0x01) == 1) {
           complete = TRUE;
         }
       } else if ((nal_type >= 32 && nal_type <= 35)
@@ -1158,8 +1285,6 @@ gst_rtp_h265_depay_handle_nal (GstRtpH265Depay * rtph265depay, GstBuffer * nal,
             &out_keyframe);
     }
     /* add to adapter */
-    gst_buffer_unmap (nal, &map);
-
     GST_DEBUG_OBJECT (depayload, "adding NAL to picture adapter");
     gst_adapter_push (rtph265depay->picture_adapter, nal);
     rtph265depay->last_ts = in_timestamp;
@@ -1173,7 +1298,6 @@ gst_rtp_h265_depay_handle_nal (GstRtpH265Depay * rtph265depay, GstBuffer * nal,
     /* no merge, output is input nal */
     GST_DEBUG_OBJECT (depayload, "using NAL as output");
     outbuf = nal;
-    gst_buffer_unmap (nal, &map);
   }
 
   if (outbuf) {
@@ -1187,7 +1311,6 @@ gst_rtp_h265_depay_handle_nal (GstRtpH265Depay * rtph265depay, GstBuffer * nal,
 short_nal:
   {
     GST_WARNING_OBJECT (depayload, "dropping short NAL");
-    gst_buffer_unmap (nal, &map);
     gst_buffer_unref (nal);
     return;
   }
@@ -1197,23 +1320,27 @@ static void
 gst_rtp_h265_finish_fragmentation_unit (GstRtpH265Depay * rtph265depay)
 {
   guint outsize;
-  GstMapInfo map;
+  guint8 prefix[4];
   GstBuffer *outbuf;
 
   outsize = gst_adapter_available (rtph265depay->adapter);
   g_assert (outsize >= 4);
 
-  outbuf = gst_adapter_take_buffer (rtph265depay->adapter, outsize);
+  outbuf = gst_rtp_h265_depay_take_memories (rtph265depay,
+      rtph265depay->adapter, outsize);
+  if (outbuf == NULL)
+    outbuf = gst_adapter_take_buffer (rtph265depay->adapter, outsize);
 
-  gst_buffer_map (outbuf, &map, GST_MAP_WRITE);
   GST_DEBUG_OBJECT (rtph265depay, "output %d bytes", outsize);
 
   if (rtph265depay->byte_stream) {
-    memcpy (map.data, sync_bytes, sizeof (sync_bytes));
+    memcpy (prefix, sync_bytes, sizeof (sync_bytes));
   } else {
-    GST_WRITE_UINT32_BE (map.data, outsize - 4);
+    GST_WRITE_UINT32_BE (prefix, outsize - 4);
   }
-  gst_buffer_unmap (outbuf, &map);
+  /* only the first memory is written to */
+  outbuf = gst_buffer_make_writable (outbuf);
+  gst_buffer_fill (outbuf, 0, prefix, sizeof (prefix));
 
   rtph265depay->current_fu_type = 0;
 
@@ -1221,6 +1348,49 @@ gst_rtp_h265_finish_fragmentation_unit (GstRtpH265Depay * rtph265depay)
       rtph265depay->fu_timestamp, rtph265depay->fu_marker);
 }
 
+/* Make a NAL buffer with @prefix followed by @size bytes of the RTP payload,
+ * starting at @offset. In zero-copy mode the payload is referenced instead of
+ * copied. */
+static GstBuffer *
+gst_rtp_h265_depay_new_nal (GstRtpH265Depay * rtph265depay, GstRTPBuffer * rtp,
+    const guint8 * prefix, guint prefix_len, guint offset, guint size)
+{
+  GstBuffer *nal;
+
+  if (rtph265depay->zero_copy) {
+    GstBuffer *payload;
+
+    payload = gst_buffer_copy_region (rtp->buffer, GST_BUFFER_COPY_MEMORY,
+        gst_rtp_buffer_get_header_len (rtp) + offset, size);
+
+    if (prefix_len == 0) {
+      nal = payload;
+    } else {
+      if (prefix == sync_bytes)
+        nal = gst_buffer_new_wrapped_full (GST_MEMORY_FLAG_READONLY,
+            (gpointer) sync_bytes, sizeof (sync_bytes), 0,
+            sizeof (sync_bytes), NULL, NULL);
+      else
+        nal = gst_buffer_new_memdup (prefix, prefix_len);
+      nal = gst_buffer_append (nal, payload);
+    }
+  } else {
+    guint8 *payload = gst_rtp_buffer_get_payload (rtp);
+    GstMapInfo map;
+
+    nal = gst_buffer_new_and_alloc (prefix_len + size);
+    gst_buffer_map (nal, &map, GST_MAP_WRITE);
+    if (prefix_len)
+      memcpy (map.data, prefix, prefix_len);
+    memcpy (map.data + prefix_len, payload + offset, size);
+    gst_buffer_unmap (nal, &map);
+  }
+
+  gst_rtp_copy_video_meta (rtph265depay, nal, rtp->buffer);
+
+  return nal;
+}
+
 static GstBuffer *
 gst_rtp_h265_depay_process (GstRTPBaseDepayload * depayload, GstRTPBuffer * rtp)
 {
@@ -1240,9 +1410,9 @@ gst_rtp_h265_depay_process (GstRTPBaseDepayload * depayload, GstRTPBuffer * rtp)
 
   {
     gint payload_len;
-    guint8 *payload;
+    guint8 *payload, *payload_start;
     guint header_len;
-    GstMapInfo map;
+    guint8 prefix[6];
     guint outsize, nalu_size;
     GstClockTime timestamp;
     gboolean marker;
@@ -1256,7 +1426,7 @@ gst_rtp_h265_depay_process (GstRTPBaseDepayload * depayload, GstRTPBuffer * rtp)
     timestamp = GST_BUFFER_PTS (rtp->buffer);
 
     payload_len = gst_rtp_buffer_get_payload_len (rtp);
-    payload = gst_rtp_buffer_get_payload (rtp);
+    payload = payload_start = gst_rtp_buffer_get_payload (rtp);
     marker = gst_rtp_buffer_get_marker (rtp);
 
     GST_DEBUG_OBJECT (rtph265depay, "receiving %d bytes", payload_len);
@@ -1348,24 +1518,16 @@ gst_rtp_h265_depay_process (GstRTPBaseDepayload * depayload, GstRTPBuffer * rtp)
           if (nalu_size > (payload_len - 2))
             nalu_size = payload_len - 2;
 
-          outsize = nalu_size + sizeof (sync_bytes);
-          outbuf = gst_buffer_new_and_alloc (outsize);
-
-          gst_buffer_map (outbuf, &map, GST_MAP_WRITE);
-          if (rtph265depay->byte_stream) {
-            memcpy (map.data, sync_bytes, sizeof (sync_bytes));
-          } else {
-            GST_WRITE_UINT32_BE (map.data, nalu_size);
-          }
+          if (!rtph265depay->byte_stream)
+            GST_WRITE_UINT32_BE (prefix, nalu_size);
 
           /* strip NALU size */
           payload += 2;
           payload_len -= 2;
 
-          memcpy (map.data + sizeof (sync_bytes), payload, nalu_size);
-          gst_buffer_unmap (outbuf, &map);
-
-          gst_rtp_copy_video_meta (rtph265depay, outbuf, rtp->buffer);
+          outbuf = gst_rtp_h265_depay_new_nal (rtph265depay, rtp,
+              rtph265depay->byte_stream ? sync_bytes : prefix,
+              sizeof (sync_bytes), payload - payload_start, nalu_size);
 
           if (payload_len - nalu_size <= 2)
             last = TRUE;
@@ -1442,29 +1604,17 @@ gst_rtp_h265_depay_process (GstRTPBaseDepayload * depayload, GstRTPBuffer * rtp)
               ((payload[0] & 0x3f) << 9) | (nuh_layer_id << 3) |
               nuh_temporal_id_plus1;
 
-          /* go back one byte so we can copy the payload + two bytes more in the front which
-           * will be overwritten by the nal_header
-           */
-          payload -= 1;
-          payload_len += 1;
-
-          nalu_size = payload_len;
-          outsize = nalu_size + sizeof (sync_bytes);
-          outbuf = gst_buffer_new_and_alloc (outsize);
-
-          gst_buffer_map (outbuf, &map, GST_MAP_WRITE);
-          if (rtph265depay->byte_stream) {
-            GST_WRITE_UINT32_BE (map.data, 0x00000001);
-          } else {
-            /* will be fixed up in finish_fragmentation_unit() */
-            GST_WRITE_UINT32_BE (map.data, 0xffffffff);
-          }
-          memcpy (map.data + sizeof (sync_bytes), payload, nalu_size);
-          map.data[4] = nal_header >> 8;
-          map.data[5] = nal_header & 0xff;
-          gst_buffer_unmap (outbuf, &map);
+          /* the sync bytes or NAL size will be filled in by
+           * finish_fragmentation_unit(), followed by the reconstructed NAL
+           * header. Strip the FU header. */
+          memset (prefix, 0, sizeof (sync_bytes));
+          prefix[4] = nal_header >> 8;
+          prefix[5] = nal_header & 0xff;
 
-          gst_rtp_copy_video_meta (rtph265depay, outbuf, rtp->buffer);
+          nalu_size = payload_len - 1;
+          outsize = nalu_size + sizeof (prefix);
+          outbuf = gst_rtp_h265_depay_new_nal (rtph265depay, rtp, prefix,
+              sizeof (prefix), payload - payload_start + 1, nalu_size);
 
           GST_DEBUG_OBJECT (rtph265depay, "queueing %d bytes", outsize);
 
@@ -1498,10 +1648,8 @@ gst_rtp_h265_depay_process (GstRTPBaseDepayload * depayload, GstRTPBuffer * rtp)
           payload_len -= 1;
 
           outsize = payload_len;
-          outbuf = gst_buffer_new_and_alloc (outsize);
-          gst_buffer_fill (outbuf, 0, payload, outsize);
-
-          gst_rtp_copy_video_meta (rtph265depay, outbuf, rtp->buffer);
+          outbuf = gst_rtp_h265_depay_new_nal (rtph265depay, rtp, NULL, 0,
+              payload - payload_start, outsize);
 
           GST_DEBUG_OBJECT (rtph265depay, "queueing %d bytes", outsize);
 
@@ -1534,19 +1682,11 @@ gst_rtp_h265_depay_process (GstRTPBaseDepayload * depayload, GstRTPBuffer * rtp)
 #endif
 
         nalu_size = payload_len;
-        outsize = nalu_size + sizeof (sync_bytes);
-        outbuf = gst_buffer_new_and_alloc (outsize);
-
-        gst_buffer_map (outbuf, &map, GST_MAP_WRITE);
-        if (rtph265depay->byte_stream) {
-          memcpy (map.data, sync_bytes, sizeof (sync_bytes));
-        } else {
-          GST_WRITE_UINT32_BE (map.data, nalu_size);
-        }
-        memcpy (map.data + 4, payload, nalu_size);
-        gst_buffer_unmap (outbuf, &map);
-
-        gst_rtp_copy_video_meta (rtph265depay, outbuf, rtp->buffer);
+        if (!rtph265depay->byte_stream)
+          GST_WRITE_UINT32_BE (prefix, nalu_size);
+        outbuf = gst_rtp_h265_depay_new_nal (rtph265depay, rtp,
+            rtph265depay->byte_stream ? sync_bytes : prefix,
+            sizeof (sync_bytes), 0, nalu_size);
 
         gst_rtp_h265_depay_handle_nal (rtph265depay, outbuf, timestamp, marker);
         break;
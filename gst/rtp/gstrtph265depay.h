@@ -86,6 +86,9 @@ struct _GstRtpH265Depay
   /* downstream allocator */
   GstAllocator *allocator;
   GstAllocationParams params;
+
+  /* reference RTP payloads instead of copying them */
+  gboolean zero_copy;
 };
 
 struct _GstRtpH265DepayClass
@@ -36,6 +36,7 @@
 #include "gstrtph265pay.h"
 #include "gstrtputils.h"
 #include "gstbuffermemory.h"
+#include "gstrtpheaderpool.h"
 
 #define AP_TYPE_ID  48
 #define FU_TYPE_ID  49
@@ -135,12 +136,14 @@ GST_STATIC_PAD_TEMPLATE ("src",
 
 #define DEFAULT_CONFIG_INTERVAL         0
 #define DEFAULT_AGGREGATE_MODE          GST_RTP_H265_AGGREGATE_NONE
+#define DEFAULT_BUFFER_LIST             FALSE
 
 enum
 {
   PROP_0,
   PROP_CONFIG_INTERVAL,
   PROP_AGGREGATE_MODE,
+  PROP_BUFFER_LIST,
 };
 
 static void gst_rtp_h265_pay_finalize (GObject * object);
@@ -217,6 +220,22 @@ gst_rtp_h265_pay_class_init (GstRtpH265PayClass * klass)
           DEFAULT_AGGREGATE_MODE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)
       );
 
+  /**
+   * GstRtpH265Pay:buffer-list
+   *
+   * Push all RTP packets made from one input buffer, a whole access unit
+   * for au aligned input, downstream as a single buffer list. The FU
+   * headers are then taken from a pool instead of being allocated for every
+   * packet.
+   *
+   * Since: 1.24
+   */
+  g_object_class_install_property (G_OBJECT_CLASS (klass),
+      PROP_BUFFER_LIST,
+      g_param_spec_boolean ("buffer-list", "Buffer List",
+          "Push the packets of an input buffer as one buffer list",
+          DEFAULT_BUFFER_LIST, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gobject_class->finalize = gst_rtp_h265_pay_finalize;
 
   gst_element_class_add_static_pad_template (gstelement_class,
@@ -256,6 +275,7 @@ gst_rtp_h265_pay_init (GstRtpH265Pay * rtph265pay)
   rtph265pay->last_vps_sps_pps = -1;
   rtph265pay->vps_sps_pps_interval = DEFAULT_CONFIG_INTERVAL;
   rtph265pay->aggregate_mode = DEFAULT_AGGREGATE_MODE;
+  rtph265pay->buffer_list = DEFAULT_BUFFER_LIST;
 
   rtph265pay->adapter = gst_adapter_new ();
 
@@ -287,6 +307,8 @@ gst_rtp_h265_pay_finalize (GObject * object)
   g_object_unref (rtph265pay->adapter);
 
   gst_rtp_h265_pay_reset_bundle (rtph265pay);
+  g_clear_pointer (&rtph265pay->au_list, gst_buffer_list_unref);
+  gst_rtp_header_pool_clear (&rtph265pay->header_pool);
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
@@ -1128,11 +1150,52 @@ gst_rtp_h265_pay_payload_nal (GstRTPBasePayload * basepayload,
   return ret;
 }
 
+/* Push @outlist, or add its packets to the list of the current input buffer
+ * in buffer-list mode */
+static GstFlowReturn
+gst_rtp_h265_pay_push_list (GstRtpH265Pay * rtph265pay, GstBufferList * outlist)
+{
+  if (rtph265pay->buffer_list) {
+    if (rtph265pay->au_list == NULL) {
+      rtph265pay->au_list = outlist;
+    } else {
+      guint i, len = gst_buffer_list_length (outlist);
+
+      for (i = 0; i < len; i++)
+        gst_buffer_list_add (rtph265pay->au_list,
+            gst_buffer_ref (gst_buffer_list_get (outlist, i)));
+      gst_buffer_list_unref (outlist);
+    }
+    return GST_FLOW_OK;
+  }
+
+  return gst_rtp_base_payload_push_list (GST_RTP_BASE_PAYLOAD (rtph265pay),
+      outlist);
+}
+
+static GstFlowReturn
+gst_rtp_h265_pay_send_au_list (GstRtpH265Pay * rtph265pay)
+{
+  GstBufferList *list = rtph265pay->au_list;
+
+  if (list == NULL)
+    return GST_FLOW_OK;
+
+  rtph265pay->au_list = NULL;
+
+  GST_DEBUG_OBJECT (rtph265pay, "sending list of %u packets",
+      gst_buffer_list_length (list));
+
+  return gst_rtp_base_payload_push_list (GST_RTP_BASE_PAYLOAD (rtph265pay),
+      list);
+}
+
 static GstFlowReturn
 gst_rtp_h265_pay_payload_nal_single (GstRTPBasePayload * basepayload,
     GstBuffer * paybuf, GstClockTime dts, GstClockTime pts, gboolean marker,
     gboolean delta_unit)
 {
+  GstRtpH265Pay *rtph265pay = (GstRtpH265Pay *) basepayload;
   GstBufferList *outlist;
   GstBuffer *outbuf;
   GstRTPBuffer rtp = GST_RTP_BUFFER_INIT;
@@ -1167,7 +1230,7 @@ gst_rtp_h265_pay_payload_nal_single (GstRTPBasePayload * basepayload,
   gst_rtp_buffer_unmap (&rtp);
 
   /* push the list to the next element in the pipe */
-  return gst_rtp_base_payload_push_list (basepayload, outlist);
+  return gst_rtp_h265_pay_push_list (rtph265pay, outlist);
 }
 
 static GstFlowReturn
@@ -1179,7 +1242,7 @@ gst_rtp_h265_pay_payload_nal_fragment (GstRTPBasePayload * basepayload,
   GstRtpH265Pay *rtph265pay = (GstRtpH265Pay *) basepayload;
   GstFlowReturn ret;
   guint max_fragment_size, ii, pos;
-  GstBuffer *outbuf;
+  GstBuffer *outbuf, *header = NULL;
   GstBufferList *outlist = NULL;
   GstRTPBuffer rtp = GST_RTP_BUFFER_INIT;
   guint8 *payload;
@@ -1201,7 +1264,16 @@ gst_rtp_h265_pay_payload_nal_fragment (GstRTPBasePayload * basepayload,
   /* We keep 3 bytes for PayloadHdr and FU Header */
   max_fragment_size = gst_rtp_buffer_calc_payload_len (mtu - 3, 0, 0);
 
-  outlist = gst_buffer_list_new ();
+  if (rtph265pay->buffer_list) {
+    if (rtph265pay->au_list == NULL)
+      rtph265pay->au_list = gst_buffer_list_new ();
+    outlist = rtph265pay->au_list;
+    /* all fragments start from a copy of this header */
+    header =
+        gst_rtp_base_payload_allocate_output_buffer (basepayload, 3, 0, 0);
+  } else {
+    outlist = gst_buffer_list_new ();
+  }
 
   for (pos = 2, ii = 0; pos < size; pos += max_fragment_size, ii++) {
     guint remaining, fragment_size;
@@ -1220,7 +1292,12 @@ gst_rtp_h265_pay_payload_nal_fragment (GstRTPBasePayload * basepayload,
     /* use buffer lists
      * create buffer without payload containing only the RTP header
      * (memory block at index 0), and with space for PayloadHdr and FU header */
-    outbuf = gst_rtp_base_payload_allocate_output_buffer (basepayload, 3, 0, 0);
+    outbuf = NULL;
+    if (header)
+      outbuf = gst_rtp_header_pool_acquire (&rtph265pay->header_pool, header);
+    if (outbuf == NULL)
+      outbuf =
+          gst_rtp_base_payload_allocate_output_buffer (basepayload, 3, 0, 0);
 
     gst_rtp_buffer_map (outbuf, GST_MAP_WRITE, &rtp);
 
@@ -1258,7 +1335,13 @@ gst_rtp_h265_pay_payload_nal_fragment (GstRTPBasePayload * basepayload,
     gst_buffer_list_add (outlist, outbuf);
   }
 
-  ret = gst_rtp_base_payload_push_list (basepayload, outlist);
+  gst_clear_buffer (&header);
+
+  /* sent together with the rest of the input buffer */
+  if (outlist == rtph265pay->au_list)
+    ret = GST_FLOW_OK;
+  else
+    ret = gst_rtp_base_payload_push_list (basepayload, outlist);
   gst_buffer_unref (paybuf);
 
   return ret;
@@ -1739,6 +1822,9 @@ gst_rtp_h265_pay_handle_buffer (GstRTPBasePayload * basepayload,
     ret = gst_rtp_h265_pay_send_bundle (rtph265pay, FALSE);
   }
 
+  if (ret == GST_FLOW_OK)
+    ret = gst_rtp_h265_pay_send_au_list (rtph265pay);
+
 done:
   if (!hevc) {
     gst_adapter_unmap (rtph265pay->adapter);
@@ -1767,6 +1853,7 @@ gst_rtp_h265_pay_sink_event (GstRTPBasePayload * payload, GstEvent * event)
     case GST_EVENT_FLUSH_STOP:
       gst_adapter_clear (rtph265pay->adapter);
       gst_rtp_h265_pay_reset_bundle (rtph265pay);
+      g_clear_pointer (&rtph265pay->au_list, gst_buffer_list_unref);
       break;
     case GST_EVENT_CUSTOM_DOWNSTREAM:
       s = gst_event_get_structure (event);
@@ -1785,6 +1872,8 @@ gst_rtp_h265_pay_sink_event (GstRTPBasePayload * payload, GstEvent * event)
        */
       gst_rtp_h265_pay_handle_buffer (payload, NULL);
       ret = gst_rtp_h265_pay_send_bundle (rtph265pay, TRUE);
+      if (ret == GST_FLOW_OK)
+        ret = gst_rtp_h265_pay_send_au_list (rtph265pay);
 
       break;
     }
@@ -1816,6 +1905,7 @@ gst_rtp_h265_pay_change_state (GstElement * element, GstStateChange transition)
       rtph265pay->send_vps_sps_pps = FALSE;
       gst_adapter_clear (rtph265pay->adapter);
       gst_rtp_h265_pay_reset_bundle (rtph265pay);
+      g_clear_pointer (&rtph265pay->au_list, gst_buffer_list_unref);
       break;
     default:
       break;
@@ -1827,6 +1917,7 @@ gst_rtp_h265_pay_change_state (GstElement * element, GstStateChange transition)
     case GST_STATE_CHANGE_PAUSED_TO_READY:
       rtph265pay->last_vps_sps_pps = -1;
       gst_rtp_h265_pay_clear_vps_sps_pps (rtph265pay);
+      gst_rtp_header_pool_clear (&rtph265pay->header_pool);
       break;
     default:
       break;
@@ -1850,6 +1941,9 @@ gst_rtp_h265_pay_set_property (GObject * object, guint prop_id,
     case PROP_AGGREGATE_MODE:
       rtph265pay->aggregate_mode = g_value_get_enum (value);
       break;
+    case PROP_BUFFER_LIST:
+      rtph265pay->buffer_list = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1871,6 +1965,9 @@ gst_rtp_h265_pay_get_property (GObject * object, guint prop_id,
     case PROP_AGGREGATE_MODE:
       g_value_set_enum (value, rtph265pay->aggregate_mode);
       break;
+    case PROP_BUFFER_LIST:
+      g_value_set_boolean (value, rtph265pay->buffer_list);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -81,6 +81,12 @@ struct _GstRtpH265Pay
   guint bundle_size;
   gboolean bundle_contains_vcl_or_suffix;
   GstRTPH265AggregateMode aggregate_mode;
+
+  /* collect the packets of an input buffer in one list, with the FU
+   * headers taken from a pool */
+  gboolean buffer_list;
+  GstBufferList *au_list;
+  GstBufferPool *header_pool;
 };
 
 struct _GstRtpH265PayClass
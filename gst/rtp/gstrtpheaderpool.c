@@ -0,0 +1,168 @@
+/* GStreamer
+ * Copyright (C) 2026 GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include "gstrtpheaderpool.h"
+
+GST_DEBUG_CATEGORY_STATIC (rtpheaderpool_debug);
+#define GST_CAT_DEFAULT (rtpheaderpool_debug)
+
+/* set on the header memory of the buffers allocated by a pool, pointing to
+ * that pool */
+static GQuark header_memory_quark;
+
+#define gst_rtp_header_pool_parent_class parent_class
+G_DEFINE_TYPE (GstRtpHeaderPool, gst_rtp_header_pool, GST_TYPE_BUFFER_POOL);
+
+static gboolean
+gst_rtp_header_pool_set_config (GstBufferPool * pool, GstStructure * config)
+{
+  GstRtpHeaderPool *hpool = GST_RTP_HEADER_POOL (pool);
+  guint size;
+
+  if (!gst_buffer_pool_config_get_params (config, NULL, &size, NULL, NULL))
+    return FALSE;
+
+  hpool->header_size = size;
+
+  return GST_BUFFER_POOL_CLASS (parent_class)->set_config (pool, config);
+}
+
+static GstFlowReturn
+gst_rtp_header_pool_alloc_buffer (GstBufferPool * pool, GstBuffer ** buffer,
+    GstBufferPoolAcquireParams * params)
+{
+  GstFlowReturn ret;
+
+  ret = GST_BUFFER_POOL_CLASS (parent_class)->alloc_buffer (pool, buffer,
+      params);
+  if (ret != GST_FLOW_OK)
+    return ret;
+
+  gst_mini_object_set_qdata (GST_MINI_OBJECT_CAST (gst_buffer_peek_memory
+          (*buffer, 0)), header_memory_quark, pool, NULL);
+
+  return GST_FLOW_OK;
+}
+
+static void
+gst_rtp_header_pool_reset_buffer (GstBufferPool * pool, GstBuffer * buffer)
+{
+  guint n_mem = gst_buffer_n_memory (buffer);
+  GstMemory *mem = NULL;
+
+  if (n_mem > 0)
+    mem = gst_buffer_peek_memory (buffer, 0);
+
+  /* Drop the payload that was appended after the header. The header memory
+   * itself is only kept if it is still the one we allocated, otherwise the
+   * memory tag stays set and the base class discards the buffer. It also
+   * checks that the header is still large enough. */
+  if (mem != NULL && gst_mini_object_get_qdata (GST_MINI_OBJECT_CAST (mem),
+          header_memory_quark) == pool) {
+    if (n_mem > 1)
+      gst_buffer_remove_memory_range (buffer, 1, -1);
+    GST_BUFFER_FLAG_UNSET (buffer, GST_BUFFER_FLAG_TAG_MEMORY);
+  } else {
+    GST_DEBUG_OBJECT (pool, "header memory of %p was replaced", buffer);
+    GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_TAG_MEMORY);
+  }
+
+  GST_BUFFER_POOL_CLASS (parent_class)->reset_buffer (pool, buffer);
+}
+
+static void
+gst_rtp_header_pool_class_init (GstRtpHeaderPoolClass * klass)
+{
+  GstBufferPoolClass *pool_class = (GstBufferPoolClass *) klass;
+
+  pool_class->set_config = gst_rtp_header_pool_set_config;
+  pool_class->alloc_buffer = gst_rtp_header_pool_alloc_buffer;
+  pool_class->reset_buffer = gst_rtp_header_pool_reset_buffer;
+
+  GST_DEBUG_CATEGORY_INIT (rtpheaderpool_debug, "rtpheaderpool", 0,
+      "RTP header pool");
+
+  header_memory_quark = g_quark_from_static_string ("GstRtpHeaderPoolMemory");
+}
+
+static void
+gst_rtp_header_pool_init (GstRtpHeaderPool * pool)
+{
+}
+
+/* Get a buffer from *@pool with a copy of the RTP header in @header. The pool
+ * is (re)created when it doesn't exist yet or when the header size changed,
+ * for example because CSRCs or header extensions were added. Returns %NULL if
+ * no buffer could be acquired, the caller should allocate the header itself
+ * then. */
+GstBuffer *
+gst_rtp_header_pool_acquire (GstBufferPool ** pool, GstBuffer * header)
+{
+  GstBuffer *outbuf = NULL;
+  GstMapInfo map;
+  gsize size;
+
+  size = gst_buffer_get_size (header);
+
+  if (*pool == NULL || GST_RTP_HEADER_POOL (*pool)->header_size != size) {
+    GstStructure *config;
+
+    gst_rtp_header_pool_clear (pool);
+
+    *pool = g_object_new (GST_TYPE_RTP_HEADER_POOL, NULL);
+    gst_object_ref_sink (*pool);
+
+    config = gst_buffer_pool_get_config (*pool);
+    gst_buffer_pool_config_set_params (config, NULL, size, 0, 0);
+    if (!gst_buffer_pool_set_config (*pool, config) ||
+        !gst_buffer_pool_set_active (*pool, TRUE)) {
+      GST_WARNING_OBJECT (*pool, "could not activate pool");
+      gst_clear_object (pool);
+      return NULL;
+    }
+    GST_DEBUG_OBJECT (*pool, "pooling headers of %" G_GSIZE_FORMAT " bytes",
+        size);
+  }
+
+  if (gst_buffer_pool_acquire_buffer (*pool, &outbuf, NULL) != GST_FLOW_OK)
+    return NULL;
+
+  if (!gst_buffer_map (outbuf, &map, GST_MAP_WRITE)) {
+    gst_buffer_unref (outbuf);
+    return NULL;
+  }
+  gst_buffer_extract (header, 0, map.data, size);
+  gst_buffer_unmap (outbuf, &map);
+
+  return outbuf;
+}
+
+void
+gst_rtp_header_pool_clear (GstBufferPool ** pool)
+{
+  if (*pool == NULL)
+    return;
+
+  gst_buffer_pool_set_active (*pool, FALSE);
+  gst_clear_object (pool);
+}
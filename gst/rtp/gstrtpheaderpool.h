@@ -0,0 +1,64 @@
+/* GStreamer
+ * Copyright (C) 2026 GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_RTP_HEADER_POOL_H__
+#define __GST_RTP_HEADER_POOL_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+#define GST_TYPE_RTP_HEADER_POOL \
+  (gst_rtp_header_pool_get_type())
+#define GST_RTP_HEADER_POOL(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_RTP_HEADER_POOL,GstRtpHeaderPool))
+#define GST_IS_RTP_HEADER_POOL(obj) \
+  (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_RTP_HEADER_POOL))
+
+typedef struct _GstRtpHeaderPool GstRtpHeaderPool;
+typedef struct _GstRtpHeaderPoolClass GstRtpHeaderPoolClass;
+
+/* A pool of buffers holding only an RTP header. Payloaders append the
+ * payload memory to an acquired buffer and push it. When the packet is
+ * released the payload memory is removed again, so that the header memory
+ * is reused for the next packet instead of being allocated per packet. */
+struct _GstRtpHeaderPool
+{
+  GstBufferPool pool;
+
+  guint header_size;
+};
+
+struct _GstRtpHeaderPoolClass
+{
+  GstBufferPoolClass parent_class;
+};
+
+G_GNUC_INTERNAL
+GType gst_rtp_header_pool_get_type (void);
+
+G_GNUC_INTERNAL
+GstBuffer * gst_rtp_header_pool_acquire (GstBufferPool ** pool, GstBuffer * header);
+
+G_GNUC_INTERNAL
+void gst_rtp_header_pool_clear (GstBufferPool ** pool);
+
+G_END_DECLS
+
+#endif /* __GST_RTP_HEADER_POOL_H__ */
@@ -139,6 +139,7 @@ gst_rtp_jpeg_depay_reset (GstRtpJPEGDepay * depay)
     g_free (depay->qtables[i]);
     depay->qtables[i] = NULL;
   }
+  gst_buffer_replace (&depay->header, NULL);
 
   gst_adapter_clear (depay->adapter);
 }
@@ -624,7 +625,7 @@ gst_rtp_jpeg_depay_process (GstRTPBaseDepayload * depayload, GstRTPBuffer * rtp)
 
   if (frag_offset == 0) {
     GstMapInfo map;
-    guint size;
+    guint size, qtable_size;
 
     if (rtpjpegdepay->width != width || rtpjpegdepay->height != height) {
       GstCaps *outcaps;
@@ -671,14 +672,41 @@ gst_rtp_jpeg_depay_process (GstRTPBaseDepayload * depayload, GstRTPBuffer * rtp)
     if (!qtable)
       goto no_qtable;
 
-    /* max header length, should be big enough */
-    outbuf = gst_buffer_new_and_alloc (1000);
-    gst_buffer_map (outbuf, &map, GST_MAP_WRITE);
-    size = MakeHeaders (map.data, type, width, height, qtable, precision, dri);
-    gst_buffer_unmap (outbuf, &map);
-    gst_buffer_resize (outbuf, 0, size);
+    /* MakeHeaders reads 64 or 128 bytes per table depending on precision */
+    qtable_size = ((precision & 1) ? 128 : 64) + ((precision & 2) ? 128 : 64);
+
+    /* the headers only change with the tables or the frame layout, so when
+     * the previous frame had the same ones, push the same header memory */
+    if (rtpjpegdepay->header == NULL ||
+        ((rtpjpegdepay->header_type & 0x3f) == 0) != ((type & 0x3f) == 0) ||
+        rtpjpegdepay->header_width != width ||
+        rtpjpegdepay->header_height != height ||
+        rtpjpegdepay->header_precision != (precision & 3) ||
+        rtpjpegdepay->header_dri != dri ||
+        memcmp (rtpjpegdepay->header_qtable, qtable, qtable_size) != 0) {
+      /* max header length, should be big enough */
+      outbuf = gst_buffer_new_and_alloc (1000);
+      gst_buffer_map (outbuf, &map, GST_MAP_WRITE);
+      size =
+          MakeHeaders (map.data, type, width, height, qtable, precision, dri);
+      gst_buffer_unmap (outbuf, &map);
+      gst_buffer_resize (outbuf, 0, size);
+
+      GST_DEBUG_OBJECT (rtpjpegdepay, "made %u bytes of header", size);
+
+      gst_buffer_replace (&rtpjpegdepay->header, outbuf);
+      rtpjpegdepay->header_type = type;
+      rtpjpegdepay->header_width = width;
+      rtpjpegdepay->header_height = height;
+      rtpjpegdepay->header_precision = precision & 3;
+      rtpjpegdepay->header_dri = dri;
+      memcpy (rtpjpegdepay->header_qtable, qtable, qtable_size);
+    } else {
+      outbuf = gst_buffer_ref (rtpjpegdepay->header);
+    }
 
-    GST_DEBUG_OBJECT (rtpjpegdepay, "pushing %u bytes of header", size);
+    GST_DEBUG_OBJECT (rtpjpegdepay, "pushing %" G_GSIZE_FORMAT
+        " bytes of header", gst_buffer_get_size (outbuf));
 
     gst_adapter_push (rtpjpegdepay->adapter, outbuf);
   }
@@ -718,7 +746,9 @@ gst_rtp_jpeg_depay_process (GstRTPBaseDepayload * depayload, GstRTPBuffer * rtp)
       gst_adapter_push (rtpjpegdepay->adapter, outbuf);
       avail += 2;
     }
-    outbuf = gst_adapter_take_buffer (rtpjpegdepay->adapter, avail);
+    /* keep the header and the payloads as separate memories, the header is
+     * usually the same memory for every frame */
+    outbuf = gst_adapter_take_buffer_fast (rtpjpegdepay->adapter, avail);
 
     if (rtpjpegdepay->discont) {
       GST_BUFFER_FLAG_SET (outbuf, GST_BUFFER_FLAG_DISCONT);
@@ -54,6 +54,13 @@ struct _GstRtpJPEGDepay
   gint media_width;
   gint media_height;
   gint width, height;
+
+  /* last generated JPEG header and the fields it was made from */
+  GstBuffer *header;
+  guint header_type;
+  guint header_width, header_height;
+  guint16 header_precision, header_dri;
+  guint8 header_qtable[256];
 };
 
 struct _GstRtpJPEGDepayClass
@@ -694,10 +694,19 @@ wrong_size:
 static RtpJpegMarker
 gst_rtp_jpeg_pay_scan_marker (GstBufferMemoryMap * memory)
 {
-  guint8 marker = parse_mem_inc_offset_guint8 (memory);
+  guint8 marker;
 
-  while (marker != JPEG_MARKER && ((memory->offset) < memory->total_size)) {
-    marker = parse_mem_inc_offset_guint8 (memory);
+  /* look for the marker prefix with memchr() on each mapped memory, which
+   * checks many bytes at once, instead of reading the data byte by byte */
+  while (memory->offset < memory->total_size) {
+    const guint8 *prefix = memchr (memory->data, JPEG_MARKER, memory->size);
+
+    if (prefix) {
+      gst_buffer_memory_advance_bytes (memory, prefix - memory->data + 1);
+      break;
+    }
+    if (!gst_buffer_memory_advance_bytes (memory, memory->size))
+      break;
   }
 
   if (G_UNLIKELY ((memory->offset) >= memory->total_size)) {
@@ -27,8 +27,17 @@
 
 #include "gstrtpelements.h"
 #include "gstrtpmp2tpay.h"
+#include "gstrtpheaderpool.h"
 #include "gstrtputils.h"
 
+#define DEFAULT_BUFFER_LIST FALSE
+
+enum
+{
+  PROP_0,
+  PROP_BUFFER_LIST
+};
+
 static GstStaticPadTemplate gst_rtp_mp2t_pay_sink_template =
 GST_STATIC_PAD_TEMPLATE ("sink",
     GST_PAD_SINK,
@@ -57,6 +66,10 @@ static GstFlowReturn gst_rtp_mp2t_pay_handle_buffer (GstRTPBasePayload *
     payload, GstBuffer * buffer);
 static GstFlowReturn gst_rtp_mp2t_pay_flush (GstRTPMP2TPay * rtpmp2tpay);
 static void gst_rtp_mp2t_pay_finalize (GObject * object);
+static void gst_rtp_mp2t_pay_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec);
+static void gst_rtp_mp2t_pay_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec);
 
 #define gst_rtp_mp2t_pay_parent_class parent_class
 G_DEFINE_TYPE (GstRTPMP2TPay, gst_rtp_mp2t_pay, GST_TYPE_RTP_BASE_PAYLOAD);
@@ -75,6 +88,24 @@ gst_rtp_mp2t_pay_class_init (GstRTPMP2TPayClass * klass)
   gstrtpbasepayload_class = (GstRTPBasePayloadClass *) klass;
 
   gobject_class->finalize = gst_rtp_mp2t_pay_finalize;
+  gobject_class->set_property = gst_rtp_mp2t_pay_set_property;
+  gobject_class->get_property = gst_rtp_mp2t_pay_get_property;
+
+  /**
+   * GstRTPMP2TPay:buffer-list:
+   *
+   * Push all the RTP packets made from the queued transport stream packets
+   * as one buffer list. The RTP headers are then taken from a pool and the
+   * transport stream packets are referenced instead of copied, so that
+   * sinks that implement render_list, like multiudpsink, can send many
+   * packets at once.
+   *
+   * Since: 1.24
+   */
+  g_object_class_install_property (gobject_class, PROP_BUFFER_LIST,
+      g_param_spec_boolean ("buffer-list", "Buffer List",
+          "Push the RTP packets made from one input buffer as a buffer list",
+          DEFAULT_BUFFER_LIST, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
   gstrtpbasepayload_class->set_caps = gst_rtp_mp2t_pay_setcaps;
   gstrtpbasepayload_class->handle_buffer = gst_rtp_mp2t_pay_handle_buffer;
@@ -96,6 +127,7 @@ gst_rtp_mp2t_pay_init (GstRTPMP2TPay * rtpmp2tpay)
   GST_RTP_BASE_PAYLOAD_PT (rtpmp2tpay) = GST_RTP_PAYLOAD_MP2T;
 
   rtpmp2tpay->adapter = gst_adapter_new ();
+  rtpmp2tpay->buffer_list = DEFAULT_BUFFER_LIST;
 }
 
 static void
@@ -107,10 +139,43 @@ gst_rtp_mp2t_pay_finalize (GObject * object)
 
   g_object_unref (rtpmp2tpay->adapter);
   rtpmp2tpay->adapter = NULL;
+  gst_rtp_header_pool_clear (&rtpmp2tpay->header_pool);
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
+static void
+gst_rtp_mp2t_pay_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstRTPMP2TPay *rtpmp2tpay = GST_RTP_MP2T_PAY (object);
+
+  switch (prop_id) {
+    case PROP_BUFFER_LIST:
+      rtpmp2tpay->buffer_list = g_value_get_boolean (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_rtp_mp2t_pay_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstRTPMP2TPay *rtpmp2tpay = GST_RTP_MP2T_PAY (object);
+
+  switch (prop_id) {
+    case PROP_BUFFER_LIST:
+      g_value_set_boolean (value, rtpmp2tpay->buffer_list);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
 static gboolean
 gst_rtp_mp2t_pay_setcaps (GstRTPBasePayload * payload, GstCaps * caps)
 {
@@ -129,11 +194,22 @@ gst_rtp_mp2t_pay_flush (GstRTPMP2TPay * rtpmp2tpay)
   guint avail, mtu;
   GstFlowReturn ret = GST_FLOW_OK;
   GstBuffer *outbuf;
+  GstBufferList *list = NULL;
+  GstBuffer *header = NULL;
 
   avail = gst_adapter_available (rtpmp2tpay->adapter);
 
   mtu = GST_RTP_BASE_PAYLOAD_MTU (rtpmp2tpay);
 
+  if (rtpmp2tpay->buffer_list && avail > 0) {
+    list = gst_buffer_list_new_sized (avail /
+        MAX (gst_rtp_buffer_calc_payload_len (mtu, 0, 0), 188) + 1);
+    /* all packets start from a copy of this header */
+    header =
+        gst_rtp_base_payload_allocate_output_buffer (GST_RTP_BASE_PAYLOAD
+        (rtpmp2tpay), 0, 0, 0);
+  }
+
   while (avail > 0 && (ret == GST_FLOW_OK)) {
     guint towrite;
     guint payload_len;
@@ -154,10 +230,14 @@ gst_rtp_mp2t_pay_flush (GstRTPMP2TPay * rtpmp2tpay)
     if (!payload_len)
       break;
 
-    /* create buffer to hold the payload */
-    outbuf =
-        gst_rtp_base_payload_allocate_output_buffer (GST_RTP_BASE_PAYLOAD
-        (rtpmp2tpay), 0, 0, 0);
+    /* create buffer to hold the header, the payload is appended */
+    outbuf = NULL;
+    if (header)
+      outbuf = gst_rtp_header_pool_acquire (&rtpmp2tpay->header_pool, header);
+    if (outbuf == NULL)
+      outbuf =
+          gst_rtp_base_payload_allocate_output_buffer (GST_RTP_BASE_PAYLOAD
+          (rtpmp2tpay), 0, 0, 0);
 
     /* get payload */
     paybuf = gst_adapter_take_buffer_fast (rtpmp2tpay->adapter, payload_len);
@@ -171,7 +251,21 @@ gst_rtp_mp2t_pay_flush (GstRTPMP2TPay * rtpmp2tpay)
     GST_DEBUG_OBJECT (rtpmp2tpay, "pushing buffer of size %u",
         (guint) gst_buffer_get_size (outbuf));
 
-    ret = gst_rtp_base_payload_push (GST_RTP_BASE_PAYLOAD (rtpmp2tpay), outbuf);
+    if (list)
+      gst_buffer_list_add (list, outbuf);
+    else
+      ret = gst_rtp_base_payload_push (GST_RTP_BASE_PAYLOAD (rtpmp2tpay),
+          outbuf);
+  }
+
+  gst_clear_buffer (&header);
+
+  if (list) {
+    if (gst_buffer_list_length (list) > 0)
+      ret = gst_rtp_base_payload_push_list (GST_RTP_BASE_PAYLOAD (rtpmp2tpay),
+          list);
+    else
+      gst_buffer_list_unref (list);
   }
 
   return ret;
@@ -48,6 +48,9 @@ struct _GstRTPMP2TPay
   GstAdapter  *adapter;
   GstClockTime first_ts;
   GstClockTime duration;
+
+  gboolean buffer_list;
+  GstBufferPool *header_pool;
 };
 
 struct _GstRTPMP2TPayClass
@@ -323,6 +323,82 @@ no_bufferpool:
   }
 }
 
+/* The planar samplings are unpacked with 32 bit loads and stores, two
+ * pgroups at a time, which is a lot cheaper than copying every sample on its
+ * own. An odd last pgroup is unpacked byte by byte. */
+
+/* I420: Y00-Y01-Y10-Y11-Cb00-Cr00, 2 pgroups per iteration */
+static void
+gst_rtp_vraw_depay_unpack_i420 (guint8 * yd1p, guint8 * yd2p, guint8 * udp,
+    guint8 * vdp, const guint8 * p, guint pgroups)
+{
+  guint i;
+
+  for (i = 0; i + 2 <= pgroups; i += 2) {
+    guint32 i0, i1, i2;
+
+    i0 = GST_READ_UINT32_LE (p);
+    i1 = GST_READ_UINT32_LE (p + 4);
+    i2 = GST_READ_UINT32_LE (p + 8);
+
+    GST_WRITE_UINT32_LE (yd1p, (i0 & 0xffff) | (i1 & 0xffff0000));
+    GST_WRITE_UINT32_LE (yd2p, (i0 >> 16) | (i2 << 16));
+    GST_WRITE_UINT16_LE (udp, (i1 & 0xff) | ((i2 >> 8) & 0xff00));
+    GST_WRITE_UINT16_LE (vdp, ((i1 >> 8) & 0xff) | ((i2 >> 16) & 0xff00));
+    p += 12;
+    yd1p += 4;
+    yd2p += 4;
+    udp += 2;
+    vdp += 2;
+  }
+
+  for (; i < pgroups; i++) {
+    *yd1p++ = p[0];
+    *yd1p++ = p[1];
+    *yd2p++ = p[2];
+    *yd2p++ = p[3];
+    *udp++ = p[4];
+    *vdp++ = p[5];
+    p += 6;
+  }
+}
+
+/* Y41B: Cb0-Y0-Y1-Cr0-Y2-Y3, 2 pgroups per iteration */
+static void
+gst_rtp_vraw_depay_unpack_y41b (guint8 * ydp, guint8 * udp, guint8 * vdp,
+    const guint8 * p, guint pgroups)
+{
+  guint i;
+
+  for (i = 0; i + 2 <= pgroups; i += 2) {
+    guint32 i0, i1, i2;
+
+    i0 = GST_READ_UINT32_LE (p);
+    i1 = GST_READ_UINT32_LE (p + 4);
+    i2 = GST_READ_UINT32_LE (p + 8);
+
+    GST_WRITE_UINT32_LE (ydp, ((i0 >> 8) & 0xffff) | (i1 << 16));
+    GST_WRITE_UINT32_LE (ydp + 4,
+        (i1 >> 24) | ((i2 & 0xff) << 8) | (i2 & 0xffff0000));
+    GST_WRITE_UINT16_LE (udp, (i0 & 0xff) | ((i1 >> 8) & 0xff00));
+    GST_WRITE_UINT16_LE (vdp, (i0 >> 24) | (i2 & 0xff00));
+    p += 12;
+    ydp += 8;
+    udp += 2;
+    vdp += 2;
+  }
+
+  for (; i < pgroups; i++) {
+    *udp++ = p[0];
+    *ydp++ = p[1];
+    *ydp++ = p[2];
+    *vdp++ = p[3];
+    *ydp++ = p[4];
+    *ydp++ = p[5];
+    p += 6;
+  }
+}
+
 static GstBuffer *
 gst_rtp_vraw_depay_process_packet (GstRTPBaseDepayload * depayload,
     GstRTPBuffer * rtp)
@@ -505,54 +581,30 @@ gst_rtp_vraw_depay_process_packet (GstRTPBaseDepayload * depayload,
       }
       case GST_VIDEO_FORMAT_I420:
       {
-        gint i;
         guint uvoff;
-        guint8 *yd1p, *yd2p, *udp, *vdp, *p;
+        guint8 *yd1p, *yd2p;
 
         yd1p = yp + (line * ystride) + (offs);
         yd2p = yd1p + ystride;
         uvoff = (line / yinc * uvstride) + (offs / xinc);
 
-        udp = up + uvoff;
-        vdp = vp + uvoff;
-        p = payload;
-
         /* line 0/1: Y00-Y01-Y10-Y11-Cb00-Cr00 Y02-Y03-Y12-Y13-Cb01-Cr01 ...  */
-        for (i = 0; i < plen; i += pgroup) {
-          *yd1p++ = p[0];
-          *yd1p++ = p[1];
-          *yd2p++ = p[2];
-          *yd2p++ = p[3];
-          *udp++ = p[4];
-          *vdp++ = p[5];
-          p += pgroup;
-        }
+        gst_rtp_vraw_depay_unpack_i420 (yd1p, yd2p, up + uvoff, vp + uvoff,
+            payload, (plen + pgroup - 1) / pgroup);
         break;
       }
       case GST_VIDEO_FORMAT_Y41B:
       {
-        gint i;
         guint uvoff;
-        guint8 *ydp, *udp, *vdp, *p;
+        guint8 *ydp;
 
         ydp = yp + (line * ystride) + (offs);
         uvoff = (line / yinc * uvstride) + (offs / xinc);
 
-        udp = up + uvoff;
-        vdp = vp + uvoff;
-        p = payload;
-
         /* Samples are packed in order Cb0-Y0-Y1-Cr0-Y2-Y3 for both interlaced
          * and progressive scan lines */
-        for (i = 0; i < plen; i += pgroup) {
-          *udp++ = p[0];
-          *ydp++ = p[1];
-          *ydp++ = p[2];
-          *vdp++ = p[3];
-          *ydp++ = p[4];
-          *ydp++ = p[5];
-          p += pgroup;
-        }
+        gst_rtp_vraw_depay_unpack_y41b (ydp, up + uvoff, vp + uvoff, payload,
+            (plen + pgroup - 1) / pgroup);
         break;
       }
       default:
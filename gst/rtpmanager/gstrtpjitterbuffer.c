@@ -158,6 +158,21 @@ enum
 #define DEFAULT_ADD_REFERENCE_TIMESTAMP_META FALSE
 #define DEFAULT_FASTSTART_MIN_PACKETS 0
 #define DEFAULT_SYNC_INTERVAL 0
+#define DEFAULT_ADAPTIVE_LATENCY FALSE
+#define DEFAULT_ADAPTIVE_LATENCY_MIN 20
+#define DEFAULT_ADAPTIVE_LATENCY_MAX 1000
+#define DEFAULT_ADAPTIVE_LATENCY_LOSS 0.5
+
+/* arrival delays for the adaptive latency are collected in a histogram of
+ * ADAPTIVE_BIN_MS wide bins. Every ADAPTIVE_WINDOW_PACKETS packets a new
+ * latency is calculated and the histogram is halved to forget old network
+ * conditions */
+#define ADAPTIVE_BIN_MS 2
+#define ADAPTIVE_NUM_BINS 1024
+#define ADAPTIVE_MAX_LATENCY_MS (ADAPTIVE_BIN_MS * ADAPTIVE_NUM_BINS)
+#define ADAPTIVE_WINDOW_PACKETS 100
+/* don't bother changing the latency for differences smaller than this */
+#define ADAPTIVE_HYSTERESIS_MS 5
 
 #define DEFAULT_AUTO_RTX_DELAY (20 * GST_MSECOND)
 #define DEFAULT_AUTO_RTX_TIMEOUT (40 * GST_MSECOND)
@@ -193,6 +208,10 @@ enum
   PROP_ADD_REFERENCE_TIMESTAMP_META,
   PROP_FASTSTART_MIN_PACKETS,
   PROP_SYNC_INTERVAL,
+  PROP_ADAPTIVE_LATENCY,
+  PROP_ADAPTIVE_LATENCY_MIN,
+  PROP_ADAPTIVE_LATENCY_MAX,
+  PROP_ADAPTIVE_LATENCY_LOSS,
 };
 
 #define JBUF_LOCK(priv)   G_STMT_START {			\
@@ -430,6 +449,20 @@ struct _GstRtpJitterBufferPrivate
   GstClockTime last_ntpnstime;
   GstClockTime avg_jitter;
 
+  /* for the adaptive latency */
+  gboolean adaptive_latency;
+  guint adaptive_latency_min;
+  guint adaptive_latency_max;
+  gdouble adaptive_latency_loss;
+  guint64 adapt_ext_rtptime;
+  GstClockTimeDiff adapt_min_transit;
+  GstClockTimeDiff adapt_window_min_transit;
+  guint adapt_window_count;
+  guint adapt_hist_total;
+  guint adapt_hist[ADAPTIVE_NUM_BINS];
+  guint adapt_target_ms;
+  gboolean adapt_latency_changed;
+
   /* for dropped packet messages */
   GstClockTime last_drop_msg_timestamp;
   /* accumulators; reset every time a drop message is posted */
@@ -590,6 +623,8 @@ static void update_rtx_stats (GstRtpJitterBuffer * jitterbuffer,
 static GstClockTime get_current_running_time (GstRtpJitterBuffer *
     jitterbuffer);
 
+static void reset_adaptive_latency (GstRtpJitterBuffer * jitterbuffer);
+
 static void
 gst_rtp_jitter_buffer_class_init (GstRtpJitterBufferClass * klass)
 {
@@ -917,6 +952,10 @@ gst_rtp_jitter_buffer_class_init (GstRtpJitterBufferClass * klass)
    * * #guint64 `rtx-success-count`: the number of successful retransmissions.
    * * #gdouble `rtx-per-packet`: average number of RTX per packet.
    * * #guint64 `rtx-rtt`: average round trip time per RTX.
+   * * #guint64 `latency`: the current latency in nanoseconds (Since: 1.24)
+   * * #guint64 `adaptive-latency-target`: the latency in nanoseconds
+   *   estimated from the arrival delays when #GstRtpJitterBuffer:adaptive-latency
+   *   is enabled (Since: 1.24)
    *
    * Since: 1.4
    */
@@ -997,6 +1036,67 @@ gst_rtp_jitter_buffer_class_init (GstRtpJitterBufferClass * klass)
           0, G_MAXUINT, DEFAULT_SYNC_INTERVAL,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstRtpJitterBuffer:adaptive-latency:
+   *
+   * Adjust the latency from the measured arrival delays of the packets. The
+   * latency is set to the smallest value for which at most
+   * #GstRtpJitterBuffer:adaptive-latency-loss percent of the packets would
+   * arrive too late, within #GstRtpJitterBuffer:adaptive-latency-min and
+   * #GstRtpJitterBuffer:adaptive-latency-max. The latency is increased
+   * quickly and decreased slowly, and a latency message is posted every time
+   * it changes.
+   *
+   * Since: 1.24
+   */
+  g_object_class_install_property (gobject_class, PROP_ADAPTIVE_LATENCY,
+      g_param_spec_boolean ("adaptive-latency", "Adaptive latency",
+          "Adjust the latency to the measured network jitter",
+          DEFAULT_ADAPTIVE_LATENCY,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRtpJitterBuffer:adaptive-latency-min:
+   *
+   * The minimum latency in ms when #GstRtpJitterBuffer:adaptive-latency is
+   * enabled.
+   *
+   * Since: 1.24
+   */
+  g_object_class_install_property (gobject_class, PROP_ADAPTIVE_LATENCY_MIN,
+      g_param_spec_uint ("adaptive-latency-min", "Adaptive latency minimum",
+          "Minimum latency in ms for the adaptive latency", 0,
+          ADAPTIVE_MAX_LATENCY_MS, DEFAULT_ADAPTIVE_LATENCY_MIN,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRtpJitterBuffer:adaptive-latency-max:
+   *
+   * The maximum latency in ms when #GstRtpJitterBuffer:adaptive-latency is
+   * enabled.
+   *
+   * Since: 1.24
+   */
+  g_object_class_install_property (gobject_class, PROP_ADAPTIVE_LATENCY_MAX,
+      g_param_spec_uint ("adaptive-latency-max", "Adaptive latency maximum",
+          "Maximum latency in ms for the adaptive latency", 0,
+          ADAPTIVE_MAX_LATENCY_MS, DEFAULT_ADAPTIVE_LATENCY_MAX,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRtpJitterBuffer:adaptive-latency-loss:
+   *
+   * The percentage of packets that are allowed to arrive too late when
+   * #GstRtpJitterBuffer:adaptive-latency is enabled.
+   *
+   * Since: 1.24
+   */
+  g_object_class_install_property (gobject_class, PROP_ADAPTIVE_LATENCY_LOSS,
+      g_param_spec_double ("adaptive-latency-loss", "Adaptive latency loss",
+          "Percentage of packets allowed to arrive too late with the "
+          "adaptive latency", 0.0, 100.0, DEFAULT_ADAPTIVE_LATENCY_LOSS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   /**
    * GstRtpJitterBuffer::request-pt-map:
    * @buffer: the object which received the signal
@@ -1128,6 +1228,11 @@ gst_rtp_jitter_buffer_init (GstRtpJitterBuffer * jitterbuffer)
   priv->faststart_min_packets = DEFAULT_FASTSTART_MIN_PACKETS;
   priv->add_reference_timestamp_meta = DEFAULT_ADD_REFERENCE_TIMESTAMP_META;
   priv->sync_interval = DEFAULT_SYNC_INTERVAL;
+  priv->adaptive_latency = DEFAULT_ADAPTIVE_LATENCY;
+  priv->adaptive_latency_min = DEFAULT_ADAPTIVE_LATENCY_MIN;
+  priv->adaptive_latency_max = DEFAULT_ADAPTIVE_LATENCY_MAX;
+  priv->adaptive_latency_loss = DEFAULT_ADAPTIVE_LATENCY_LOSS;
+  reset_adaptive_latency (jitterbuffer);
 
   priv->ts_offset_remainder = 0;
   priv->last_dts = -1;
@@ -1755,6 +1860,7 @@ gst_rtp_jitter_buffer_flush_stop (GstRtpJitterBuffer * jitterbuffer)
   priv->last_drop_msg_timestamp = GST_CLOCK_TIME_NONE;
   priv->num_too_late = 0;
   priv->num_drop_on_latency = 0;
+  reset_adaptive_latency (jitterbuffer);
   g_list_free_full (priv->cname_ssrc_mappings,
       (GDestroyNotify) cname_ssrc_mapping_free);
   priv->cname_ssrc_mappings = NULL;
@@ -2788,6 +2894,103 @@ gst_rtp_jitter_buffer_handle_missing_packets (GstRtpJitterBuffer * jitterbuffer,
   }
 }
 
+static void
+reset_adaptive_latency (GstRtpJitterBuffer * jitterbuffer)
+{
+  GstRtpJitterBufferPrivate *priv = jitterbuffer->priv;
+
+  priv->adapt_ext_rtptime = -1;
+  priv->adapt_min_transit = GST_CLOCK_STIME_NONE;
+  priv->adapt_window_min_transit = GST_CLOCK_STIME_NONE;
+  priv->adapt_window_count = 0;
+  priv->adapt_hist_total = 0;
+  memset (priv->adapt_hist, 0, sizeof (priv->adapt_hist));
+  priv->adapt_target_ms = 0;
+}
+
+/* Collect the delay of the packet relative to the fastest packet seen and
+ * retune the latency at the end of each window so that at most
+ * adaptive_latency_loss percent of the packets would arrive late.
+ * MUST be called with the JBUF_LOCK */
+static void
+update_adaptive_latency (GstRtpJitterBuffer * jitterbuffer, GstClockTime dts,
+    guint32 rtptime)
+{
+  GstRtpJitterBufferPrivate *priv = jitterbuffer->priv;
+  guint64 ext_rtptime, allowed, above;
+  GstClockTimeDiff transit, delay;
+  guint i, bin, target_ms, latency_ms, min_ms, max_ms;
+
+  if (!priv->adaptive_latency || dts == GST_CLOCK_TIME_NONE
+      || priv->clock_rate <= 0)
+    return;
+
+  ext_rtptime = gst_rtp_buffer_ext_timestamp (&priv->adapt_ext_rtptime,
+      rtptime);
+  transit = (GstClockTimeDiff) dts -
+      (GstClockTimeDiff) gst_util_uint64_scale_int (ext_rtptime, GST_SECOND,
+      priv->clock_rate);
+
+  if (priv->adapt_min_transit == GST_CLOCK_STIME_NONE
+      || transit < priv->adapt_min_transit)
+    priv->adapt_min_transit = transit;
+  if (priv->adapt_window_min_transit == GST_CLOCK_STIME_NONE
+      || transit < priv->adapt_window_min_transit)
+    priv->adapt_window_min_transit = transit;
+
+  delay = transit - priv->adapt_min_transit;
+  bin = MIN (delay / (ADAPTIVE_BIN_MS * GST_MSECOND), ADAPTIVE_NUM_BINS - 1);
+  priv->adapt_hist[bin]++;
+  priv->adapt_hist_total++;
+
+  if (++priv->adapt_window_count < ADAPTIVE_WINDOW_PACKETS)
+    return;
+
+  /* find the smallest latency for which not more than the allowed amount of
+   * packets arrive later */
+  allowed = priv->adapt_hist_total * priv->adaptive_latency_loss / 100.0;
+  for (i = ADAPTIVE_NUM_BINS, above = 0; i > 0; i--) {
+    above += priv->adapt_hist[i - 1];
+    if (above > allowed)
+      break;
+  }
+  target_ms = i * ADAPTIVE_BIN_MS;
+
+  min_ms = priv->adaptive_latency_min;
+  max_ms = MAX (priv->adaptive_latency_max, min_ms);
+  target_ms = CLAMP (target_ms, min_ms, max_ms);
+  priv->adapt_target_ms = target_ms;
+
+  /* go up quickly to avoid losing more packets and come down slowly so that
+   * a short period of low jitter doesn't cause glitches when it comes back */
+  latency_ms = priv->latency_ms;
+  if (target_ms > latency_ms + ADAPTIVE_HYSTERESIS_MS)
+    latency_ms += (target_ms - latency_ms + 1) / 2;
+  else if (target_ms + ADAPTIVE_HYSTERESIS_MS < latency_ms)
+    latency_ms -= (latency_ms - target_ms + 3) / 4;
+  latency_ms = CLAMP (latency_ms, min_ms, max_ms);
+
+  GST_DEBUG_OBJECT (jitterbuffer, "adaptive latency target %u ms, "
+      "latency %u -> %u ms", target_ms, priv->latency_ms, latency_ms);
+
+  if (latency_ms != priv->latency_ms) {
+    priv->latency_ms = latency_ms;
+    priv->latency_ns = latency_ms * GST_MSECOND;
+    rtp_jitter_buffer_set_delay (priv->jbuf, priv->latency_ns);
+    priv->adapt_latency_changed = TRUE;
+  }
+
+  /* start a new window, halve the history and follow the minimum transit
+   * time of the last window to cope with clock drift */
+  for (i = 0, priv->adapt_hist_total = 0; i < ADAPTIVE_NUM_BINS; i++) {
+    priv->adapt_hist[i] >>= 1;
+    priv->adapt_hist_total += priv->adapt_hist[i];
+  }
+  priv->adapt_min_transit = priv->adapt_window_min_transit;
+  priv->adapt_window_min_transit = GST_CLOCK_STIME_NONE;
+  priv->adapt_window_count = 0;
+}
+
 static void
 calculate_jitter (GstRtpJitterBuffer * jitterbuffer, GstClockTime dts,
     guint32 rtptime)
@@ -3116,6 +3319,7 @@ gst_rtp_jitter_buffer_chain (GstPad * pad, GstObject * parent,
   gboolean do_next_seqnum = FALSE;
   GstMessage *msg = NULL;
   GstMessage *drop_msg = NULL;
+  gboolean latency_changed;
   gboolean estimated_dts = FALSE;
   gint32 packet_rate, max_dropout, max_misorder;
   RtpTimer *timer = NULL;
@@ -3216,14 +3420,18 @@ gst_rtp_jitter_buffer_chain (GstPad * pad, GstObject * parent,
     priv->last_ssrc = ssrc;
     priv->last_known_ext_rtptime = -1;
     priv->last_known_ntpnstime = -1;
+    /* the RTP timestamps of the new SSRC have no relation to the old ones */
+    reset_adaptive_latency (jitterbuffer);
   }
 
   /* don't accept more data on EOS */
   if (G_UNLIKELY (priv->eos))
     goto have_eos;
 
-  if (!is_rtx)
+  if (!is_rtx) {
     calculate_jitter (jitterbuffer, dts, rtptime);
+    update_adaptive_latency (jitterbuffer, dts, rtptime);
+  }
 
   if (priv->seqnum_base != -1) {
     gint gap;
@@ -3571,12 +3779,19 @@ gst_rtp_jitter_buffer_chain (GstPad * pad, GstObject * parent,
 
 finished:
   update_current_timer (jitterbuffer);
+  latency_changed = priv->adapt_latency_changed;
+  priv->adapt_latency_changed = FALSE;
   JBUF_UNLOCK (priv);
 
   if (msg)
     gst_element_post_message (GST_ELEMENT_CAST (jitterbuffer), msg);
   if (drop_msg)
     gst_element_post_message (GST_ELEMENT_CAST (jitterbuffer), drop_msg);
+  if (latency_changed) {
+    g_object_notify (G_OBJECT (jitterbuffer), "latency");
+    gst_element_post_message (GST_ELEMENT_CAST (jitterbuffer),
+        gst_message_new_latency (GST_OBJECT_CAST (jitterbuffer)));
+  }
 
   return ret;
 
@@ -5205,6 +5420,27 @@ gst_rtp_jitter_buffer_set_property (GObject * object,
       priv->sync_interval = g_value_get_uint (value);
       JBUF_UNLOCK (priv);
       break;
+    case PROP_ADAPTIVE_LATENCY:
+      JBUF_LOCK (priv);
+      priv->adaptive_latency = g_value_get_boolean (value);
+      reset_adaptive_latency (jitterbuffer);
+      JBUF_UNLOCK (priv);
+      break;
+    case PROP_ADAPTIVE_LATENCY_MIN:
+      JBUF_LOCK (priv);
+      priv->adaptive_latency_min = g_value_get_uint (value);
+      JBUF_UNLOCK (priv);
+      break;
+    case PROP_ADAPTIVE_LATENCY_MAX:
+      JBUF_LOCK (priv);
+      priv->adaptive_latency_max = g_value_get_uint (value);
+      JBUF_UNLOCK (priv);
+      break;
+    case PROP_ADAPTIVE_LATENCY_LOSS:
+      JBUF_LOCK (priv);
+      priv->adaptive_latency_loss = g_value_get_double (value);
+      JBUF_UNLOCK (priv);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -5371,6 +5607,26 @@ gst_rtp_jitter_buffer_get_property (GObject * object,
       g_value_set_uint (value, priv->sync_interval);
       JBUF_UNLOCK (priv);
       break;
+    case PROP_ADAPTIVE_LATENCY:
+      JBUF_LOCK (priv);
+      g_value_set_boolean (value, priv->adaptive_latency);
+      JBUF_UNLOCK (priv);
+      break;
+    case PROP_ADAPTIVE_LATENCY_MIN:
+      JBUF_LOCK (priv);
+      g_value_set_uint (value, priv->adaptive_latency_min);
+      JBUF_UNLOCK (priv);
+      break;
+    case PROP_ADAPTIVE_LATENCY_MAX:
+      JBUF_LOCK (priv);
+      g_value_set_uint (value, priv->adaptive_latency_max);
+      JBUF_UNLOCK (priv);
+      break;
+    case PROP_ADAPTIVE_LATENCY_LOSS:
+      JBUF_LOCK (priv);
+      g_value_set_double (value, priv->adaptive_latency_loss);
+      JBUF_UNLOCK (priv);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -5381,20 +5637,38 @@ static GstStructure *
 gst_rtp_jitter_buffer_create_stats (GstRtpJitterBuffer * jbuf)
 {
   GstRtpJitterBufferPrivate *priv = jbuf->priv;
-  GstStructure *s;
+  guint64 num_pushed, num_lost, num_late, num_duplicates;
+  guint64 num_rtx_requests, num_rtx_success, avg_rtx_rtt;
+  GstClockTime avg_jitter, latency_ns, adapt_target;
+  gdouble avg_rtx_num;
 
+  /* only take a copy of the counters with the lock, building the structure
+   * is left until after it is released so that polling the stats does not
+   * stall the streaming thread */
   JBUF_LOCK (priv);
-  s = gst_structure_new ("application/x-rtp-jitterbuffer-stats",
-      "num-pushed", G_TYPE_UINT64, priv->num_pushed,
-      "num-lost", G_TYPE_UINT64, priv->num_lost,
-      "num-late", G_TYPE_UINT64, priv->num_late,
-      "num-duplicates", G_TYPE_UINT64, priv->num_duplicates,
-      "avg-jitter", G_TYPE_UINT64, priv->avg_jitter,
-      "rtx-count", G_TYPE_UINT64, priv->num_rtx_requests,
-      "rtx-success-count", G_TYPE_UINT64, priv->num_rtx_success,
-      "rtx-per-packet", G_TYPE_DOUBLE, priv->avg_rtx_num,
-      "rtx-rtt", G_TYPE_UINT64, priv->avg_rtx_rtt, NULL);
+  num_pushed = priv->num_pushed;
+  num_lost = priv->num_lost;
+  num_late = priv->num_late;
+  num_duplicates = priv->num_duplicates;
+  avg_jitter = priv->avg_jitter;
+  num_rtx_requests = priv->num_rtx_requests;
+  num_rtx_success = priv->num_rtx_success;
+  avg_rtx_num = priv->avg_rtx_num;
+  avg_rtx_rtt = priv->avg_rtx_rtt;
+  latency_ns = priv->latency_ns;
+  adapt_target = (guint64) priv->adapt_target_ms * GST_MSECOND;
   JBUF_UNLOCK (priv);
 
-  return s;
+  return gst_structure_new ("application/x-rtp-jitterbuffer-stats",
+      "num-pushed", G_TYPE_UINT64, num_pushed,
+      "num-lost", G_TYPE_UINT64, num_lost,
+      "num-late", G_TYPE_UINT64, num_late,
+      "num-duplicates", G_TYPE_UINT64, num_duplicates,
+      "avg-jitter", G_TYPE_UINT64, avg_jitter,
+      "rtx-count", G_TYPE_UINT64, num_rtx_requests,
+      "rtx-success-count", G_TYPE_UINT64, num_rtx_success,
+      "rtx-per-packet", G_TYPE_DOUBLE, avg_rtx_num,
+      "rtx-rtt", G_TYPE_UINT64, avg_rtx_rtt,
+      "latency", G_TYPE_UINT64, latency_ns,
+      "adaptive-latency-target", G_TYPE_UINT64, adapt_target, NULL);
 }
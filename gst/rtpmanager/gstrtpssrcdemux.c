@@ -163,15 +163,7 @@ typedef struct
 static GstRtpSsrcDemuxPads *
 find_demux_pads_for_ssrc (GstRtpSsrcDemux * demux, guint32 ssrc)
 {
-  GSList *walk;
-
-  for (walk = demux->srcpads; walk; walk = g_slist_next (walk)) {
-    GstRtpSsrcDemuxPads *pad = (GstRtpSsrcDemuxPads *) walk->data;
-
-    if (pad->ssrc == ssrc)
-      return pad;
-  }
-  return NULL;
+  return g_hash_table_lookup (demux->ssrcpads, GUINT_TO_POINTER (ssrc));
 }
 
 /* returns a reference to the pad if found, %NULL otherwise */
@@ -310,8 +302,17 @@ find_or_create_demux_pad_for_ssrc (GstRtpSsrcDemux * demux, guint32 ssrc,
   GstPad *retpad;
   guint num_streams;
 
+  /* fast path, the SSRC is known already. Only the object lock is taken for
+   * the lookup so that packets of existing streams don't serialize on the
+   * stream lock */
+  retpad = get_demux_pad_for_ssrc (demux, ssrc, padtype);
+  if (retpad != NULL)
+    return retpad;
+
   INTERNAL_STREAM_LOCK (demux);
 
+  /* check again, another thread might have created the pads while we were
+   * waiting for the stream lock */
   retpad = get_demux_pad_for_ssrc (demux, ssrc, padtype);
   if (retpad != NULL) {
     INTERNAL_STREAM_UNLOCK (demux);
@@ -379,6 +380,13 @@ find_or_create_demux_pad_for_ssrc (GstRtpSsrcDemux * demux, guint32 ssrc,
   g_signal_emit (G_OBJECT (demux),
       gst_rtp_ssrc_demux_signals[SIGNAL_NEW_SSRC_PAD], 0, ssrc, rtp_pad);
 
+  /* only now make the pads visible to the lookup without the stream lock,
+   * the other streaming thread must not push on them before they are
+   * active, added and linked */
+  GST_OBJECT_LOCK (demux);
+  g_hash_table_insert (demux->ssrcpads, GUINT_TO_POINTER (ssrc), dpads);
+  GST_OBJECT_UNLOCK (demux);
+
   INTERNAL_STREAM_UNLOCK (demux);
 
   return retpad;
@@ -532,6 +540,8 @@ gst_rtp_ssrc_demux_init (GstRtpSsrcDemux * demux)
 
   demux->max_streams = DEFAULT_MAX_STREAMS;
 
+  demux->ssrcpads = g_hash_table_new (NULL, NULL);
+
   g_rec_mutex_init (&demux->padlock);
 }
 
@@ -550,6 +560,7 @@ gst_rtp_ssrc_demux_pads_free (GstRtpSsrcDemuxPads * dpads)
 static void
 gst_rtp_ssrc_demux_reset (GstRtpSsrcDemux * demux)
 {
+  g_hash_table_remove_all (demux->ssrcpads);
   g_slist_free_full (demux->srcpads,
       (GDestroyNotify) gst_rtp_ssrc_demux_pads_free);
   demux->srcpads = NULL;
@@ -573,6 +584,7 @@ gst_rtp_ssrc_demux_finalize (GObject * object)
   GstRtpSsrcDemux *demux;
 
   demux = GST_RTP_SSRC_DEMUX (object);
+  g_hash_table_destroy (demux->ssrcpads);
   g_rec_mutex_clear (&demux->padlock);
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
@@ -593,6 +605,7 @@ gst_rtp_ssrc_demux_clear_ssrc (GstRtpSsrcDemux * demux, guint32 ssrc)
   GST_DEBUG_OBJECT (demux, "clearing pad for SSRC %08x", ssrc);
 
   demux->srcpads = g_slist_remove (demux->srcpads, dpads);
+  g_hash_table_remove (demux->ssrcpads, GUINT_TO_POINTER (ssrc));
   GST_OBJECT_UNLOCK (demux);
 
   g_signal_emit (G_OBJECT (demux),
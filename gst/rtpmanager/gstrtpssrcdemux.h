@@ -40,6 +40,8 @@ struct _GstRtpSsrcDemux
 
   GRecMutex padlock;
   GSList *srcpads;
+  GHashTable *ssrcpads;         /* SSRC -> GstRtpSsrcDemuxPads, protected by
+                                 * the object lock */
   guint max_streams;
 };
 
@@ -82,6 +82,7 @@ enum
 #define DEFAULT_FAVOR_NEW            FALSE
 #define DEFAULT_TWCC_FEEDBACK_INTERVAL GST_CLOCK_TIME_NONE
 #define DEFAULT_UPDATE_NTP64_HEADER_EXT TRUE
+#define DEFAULT_NACK_COALESCING_WINDOW 0
 
 enum
 {
@@ -110,6 +111,7 @@ enum
   PROP_RTCP_DISABLE_SR_TIMESTAMP,
   PROP_TWCC_FEEDBACK_INTERVAL,
   PROP_UPDATE_NTP64_HEADER_EXT,
+  PROP_NACK_COALESCING_WINDOW,
   PROP_LAST,
 };
 
@@ -134,7 +136,9 @@ static void rtp_session_get_property (GObject * object, guint prop_id,
 static gboolean rtp_session_send_rtcp (RTPSession * sess,
     GstClockTime max_delay);
 static gboolean rtp_session_send_rtcp_with_deadline (RTPSession * sess,
-    GstClockTime deadline);
+    GstClockTime deadline, GstClockTime min_delay);
+static gboolean rtp_session_request_early_rtcp_full (RTPSession * sess,
+    GstClockTime current_time, GstClockTime max_delay, GstClockTime min_delay);
 
 static guint rtp_session_signals[LAST_SIGNAL] = { 0 };
 
@@ -660,6 +664,25 @@ rtp_session_class_init (RTPSessionClass * klass)
       DEFAULT_UPDATE_NTP64_HEADER_EXT,
       G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
 
+  /**
+   * RTPSession:nack-coalescing-window:
+   *
+   * Minimum time to hold back an early RTCP packet carrying NACK feedback so
+   * that losses detected shortly after each other are reported together.
+   * The delay is never extended past the deadline of the NACK request. With
+   * a burst of losses this sends one early feedback packet per window
+   * instead of one per lost packet. 0 disables coalescing.
+   *
+   * Since: 1.24
+   */
+  properties[PROP_NACK_COALESCING_WINDOW] =
+      g_param_spec_uint64 ("nack-coalescing-window",
+      "NACK Coalescing Window",
+      "Minimum time to hold back early RTCP with NACK feedback so that "
+      "further NACKs can be added to it (0 = disabled)",
+      0, G_MAXUINT64, DEFAULT_NACK_COALESCING_WINDOW,
+      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
   g_object_class_install_properties (gobject_class, PROP_LAST, properties);
 
   klass->get_source_by_ssrc =
@@ -706,6 +729,7 @@ rtp_session_init (RTPSession * sess)
   sess->mtu = DEFAULT_RTCP_MTU;
 
   sess->update_ntp64_header_ext = DEFAULT_UPDATE_NTP64_HEADER_EXT;
+  sess->nack_coalescing_window = DEFAULT_NACK_COALESCING_WINDOW;
 
   sess->probation = DEFAULT_PROBATION;
   sess->max_dropout_time = DEFAULT_MAX_DROPOUT_TIME;
@@ -775,6 +799,11 @@ rtp_session_finalize (GObject * object)
   g_object_unref (sess->twcc);
   rtp_twcc_stats_free (sess->twcc_stats);
 
+  if (sess->rtcp_pool) {
+    gst_buffer_pool_set_active (sess->rtcp_pool, FALSE);
+    gst_object_unref (sess->rtcp_pool);
+  }
+
   g_mutex_clear (&sess->lock);
 
   G_OBJECT_CLASS (rtp_session_parent_class)->finalize (object);
@@ -811,39 +840,61 @@ rtp_session_create_sources (RTPSession * sess)
 }
 
 static void
-create_source_stats (gpointer key, RTPSource * source, GValueArray * arr)
+snapshot_source_stats (gpointer key, RTPSource * source, GArray * snapshots)
 {
-  GValue *value;
-  GstStructure *s;
-
-  g_object_get (source, "stats", &s, NULL);
+  RTPSourceStatsSnapshot *snapshot;
 
-  g_value_array_append (arr, NULL);
-  value = g_value_array_get_nth (arr, arr->n_values - 1);
-  g_value_init (value, GST_TYPE_STRUCTURE);
-  g_value_take_boxed (value, s);
+  g_array_set_size (snapshots, snapshots->len + 1);
+  snapshot = &g_array_index (snapshots, RTPSourceStatsSnapshot,
+      snapshots->len - 1);
+  rtp_source_get_stats_snapshot (source, snapshot);
 }
 
 static GstStructure *
 rtp_session_create_stats (RTPSession * sess)
 {
   GstStructure *s;
+  GArray *snapshots;
   GValueArray *source_stats;
   GValue source_stats_v = G_VALUE_INIT;
-  guint size;
+  guint nacks_dropped, nacks_sent, nacks_received;
+  guint i, size;
 
+  /* only copy the plain values while holding the lock, the structures are
+   * built after releasing it so that streaming threads are not blocked by
+   * applications polling the stats */
   RTP_SESSION_LOCK (sess);
-  s = gst_structure_new ("application/x-rtp-session-stats",
-      "rtx-drop-count", G_TYPE_UINT, sess->stats.nacks_dropped,
-      "sent-nack-count", G_TYPE_UINT, sess->stats.nacks_sent,
-      "recv-nack-count", G_TYPE_UINT, sess->stats.nacks_received, NULL);
+  nacks_dropped = sess->stats.nacks_dropped;
+  nacks_sent = sess->stats.nacks_sent;
+  nacks_received = sess->stats.nacks_received;
 
   size = g_hash_table_size (sess->ssrcs[sess->mask_idx]);
-  source_stats = g_value_array_new (size);
+  snapshots = g_array_sized_new (FALSE, FALSE,
+      sizeof (RTPSourceStatsSnapshot), size);
   g_hash_table_foreach (sess->ssrcs[sess->mask_idx],
-      (GHFunc) create_source_stats, source_stats);
+      (GHFunc) snapshot_source_stats, snapshots);
   RTP_SESSION_UNLOCK (sess);
 
+  s = gst_structure_new ("application/x-rtp-session-stats",
+      "rtx-drop-count", G_TYPE_UINT, nacks_dropped,
+      "sent-nack-count", G_TYPE_UINT, nacks_sent,
+      "recv-nack-count", G_TYPE_UINT, nacks_received, NULL);
+
+  source_stats = g_value_array_new (snapshots->len);
+  for (i = 0; i < snapshots->len; i++) {
+    RTPSourceStatsSnapshot *snapshot =
+        &g_array_index (snapshots, RTPSourceStatsSnapshot, i);
+    GValue *value;
+
+    g_value_array_append (source_stats, NULL);
+    value = g_value_array_get_nth (source_stats, source_stats->n_values - 1);
+    g_value_init (value, GST_TYPE_STRUCTURE);
+    g_value_take_boxed (value,
+        rtp_source_stats_snapshot_to_structure (snapshot));
+    rtp_source_stats_snapshot_clear (snapshot);
+  }
+  g_array_free (snapshots, TRUE);
+
   g_value_init (&source_stats_v, G_TYPE_VALUE_ARRAY);
   g_value_take_boxed (&source_stats_v, source_stats);
   gst_structure_take_value (s, "source-stats", &source_stats_v);
@@ -950,6 +1001,11 @@ rtp_session_set_property (GObject * object, guint prop_id,
     case PROP_UPDATE_NTP64_HEADER_EXT:
       sess->update_ntp64_header_ext = g_value_get_boolean (value);
       break;
+    case PROP_NACK_COALESCING_WINDOW:
+      RTP_SESSION_LOCK (sess);
+      sess->nack_coalescing_window = g_value_get_uint64 (value);
+      RTP_SESSION_UNLOCK (sess);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1039,6 +1095,11 @@ rtp_session_get_property (GObject * object, guint prop_id,
     case PROP_UPDATE_NTP64_HEADER_EXT:
       g_value_set_boolean (value, sess->update_ntp64_header_ext);
       break;
+    case PROP_NACK_COALESCING_WINDOW:
+      RTP_SESSION_LOCK (sess);
+      g_value_set_uint64 (value, sess->nack_coalescing_window);
+      RTP_SESSION_UNLOCK (sess);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -3791,8 +3852,54 @@ typedef struct
   gboolean may_suppress;
   GQueue output;
   guint nacked_seqnums;
+  GPtrArray *report_sources;
 } ReportData;
 
+/* only remote senders with RTCP enabled get a report block, all other sources
+ * are skipped when building SR/RR packets */
+#define SOURCE_NEEDS_REPORT_BLOCK(src) \
+    (!(src)->internal && RTP_SOURCE_IS_SENDER (src) && !(src)->disable_rtcp)
+
+/* get an empty RTCP buffer of @sess->mtu bytes, recycled from a previous
+ * report when possible. MUST be called with the session lock */
+static GstBuffer *
+rtp_session_acquire_rtcp_buffer (RTPSession * sess)
+{
+  GstBuffer *buffer = NULL;
+
+  if (sess->rtcp_pool == NULL || sess->rtcp_pool_size != sess->mtu) {
+    GstStructure *config;
+
+    if (sess->rtcp_pool) {
+      gst_buffer_pool_set_active (sess->rtcp_pool, FALSE);
+      gst_object_unref (sess->rtcp_pool);
+    }
+
+    sess->rtcp_pool = gst_buffer_pool_new ();
+    config = gst_buffer_pool_get_config (sess->rtcp_pool);
+    gst_buffer_pool_config_set_params (config, NULL, sess->mtu, 0, 0);
+    if (!gst_buffer_pool_set_config (sess->rtcp_pool, config) ||
+        !gst_buffer_pool_set_active (sess->rtcp_pool, TRUE)) {
+      GST_WARNING ("could not activate RTCP buffer pool");
+      gst_clear_object (&sess->rtcp_pool);
+      return gst_rtcp_buffer_new (sess->mtu);
+    }
+    sess->rtcp_pool_size = sess->mtu;
+  }
+
+  if (gst_buffer_pool_acquire_buffer (sess->rtcp_pool, &buffer,
+          NULL) != GST_FLOW_OK)
+    return gst_rtcp_buffer_new (sess->mtu);
+
+  /* a recycled buffer still contains the packets of the previous report and
+   * the RTCP buffer API looks for the end of the compound packet by parsing
+   * the headers, so clear everything */
+  gst_buffer_memset (buffer, 0, 0, sess->mtu);
+  gst_buffer_resize (buffer, 0, 0);
+
+  return buffer;
+}
+
 static void
 session_start_rtcp (RTPSession * sess, ReportData * data)
 {
@@ -3800,7 +3907,7 @@ session_start_rtcp (RTPSession * sess, ReportData * data)
   RTPSource *own = data->source;
   GstRTCPBuffer *rtcp = &data->rtcpbuf;
 
-  data->rtcp = gst_rtcp_buffer_new (sess->mtu);
+  data->rtcp = rtp_session_acquire_rtcp_buffer (sess);
   data->has_sdes = FALSE;
 
   gst_rtcp_buffer_map (data->rtcp, GST_MAP_READWRITE, rtcp);
@@ -4250,8 +4357,10 @@ session_cleanup (const gchar * key, RTPSource * source, ReportData * data)
 
       on_sender_timeout (sess, source);
     }
-    /* count how many source to report in this generation */
-    if (((gint16) (source->generation - sess->generation)) <= 0)
+    /* count how many source to report in this generation, sources without
+     * report blocks are not tracked in generations */
+    if (SOURCE_NEEDS_REPORT_BLOCK (source) &&
+        ((gint16) (source->generation - sess->generation)) <= 0)
       data->num_to_report++;
   }
   source->closing = remove;
@@ -4446,9 +4555,22 @@ static gboolean
 remove_closing_sources (const gchar * key, RTPSource * source,
     ReportData * data)
 {
+  RTPSession *sess = data->sess;
+
   if (source->closing)
     return TRUE;
 
+  /* collect the sources that need report blocks so that generating the
+   * SR/RR does not have to walk all the idle sources again. The others are
+   * kept in the current generation and are never reported. */
+  if (SOURCE_NEEDS_REPORT_BLOCK (source)) {
+    g_ptr_array_add (data->report_sources, source);
+  } else {
+    source->generation = sess->generation;
+    if (g_hash_table_size (source->reported_in_sr_of) > 0)
+      g_hash_table_remove_all (source->reported_in_sr_of);
+  }
+
   if (source->send_fir)
     data->have_fir = TRUE;
   if (source->send_pli)
@@ -4524,10 +4646,13 @@ generate_rtcp (const gchar * key, RTPSource * source, ReportData * data)
     make_source_bye (sess, source, data);
     is_bye = TRUE;
   } else if (!data->is_early) {
-    /* loop over all known sources and add report blocks. If we are early, we
-     * just make a minimal RTCP packet and skip this step */
-    g_hash_table_foreach (sess->ssrcs[sess->mask_idx],
-        (GHFunc) session_report_blocks, data);
+    guint i;
+
+    /* loop over all sources that need a report and add report blocks. If we
+     * are early, we just make a minimal RTCP packet and skip this step */
+    for (i = 0; i < data->report_sources->len; i++)
+      session_report_blocks (NULL, g_ptr_array_index (data->report_sources, i),
+          data);
   }
   if (!data->has_sdes && (!data->is_early || !sess->reduced_size_rtcp
           || sr_req_pending))
@@ -4576,13 +4701,19 @@ update_generation (const gchar * key, RTPSource * source, ReportData * data)
   }
 }
 
+static void
+update_generation_func (RTPSource * source, ReportData * data)
+{
+  update_generation (NULL, source, data);
+}
+
 static void
 schedule_remaining_nacks (const gchar * key, RTPSource * source,
     ReportData * data)
 {
   RTPSession *sess = data->sess;
   GstClockTime *nack_deadlines;
-  GstClockTime deadline;
+  GstClockTime deadline, min_delay;
   guint n_nacks;
 
   if (!source->send_nack)
@@ -4593,8 +4724,9 @@ schedule_remaining_nacks (const gchar * key, RTPSource * source,
    * RTCP. */
   nack_deadlines = rtp_source_get_nack_deadlines (source, &n_nacks);
   deadline = nack_deadlines[n_nacks - 1];
+  min_delay = sess->nack_coalescing_window;
   RTP_SESSION_UNLOCK (sess);
-  rtp_session_send_rtcp_with_deadline (sess, deadline);
+  rtp_session_send_rtcp_with_deadline (sess, deadline, min_delay);
   RTP_SESSION_LOCK (sess);
 }
 
@@ -4658,6 +4790,7 @@ rtp_session_on_timeout (RTPSession * sess, GstClockTime current_time,
   data.num_to_report = 0;
   data.may_suppress = FALSE;
   data.nacked_seqnums = 0;
+  data.report_sources = g_ptr_array_new ();
   g_queue_init (&data.output);
 
   RTP_SESSION_LOCK (sess);
@@ -4722,8 +4855,8 @@ rtp_session_on_timeout (RTPSession * sess, GstClockTime current_time,
       (GHFunc) generate_twcc, &data);
 
   /* update the generation for all the sources that have been reported */
-  g_hash_table_foreach (sess->ssrcs[sess->mask_idx],
-      (GHFunc) update_generation, &data);
+  g_ptr_array_foreach (data.report_sources, (GFunc) update_generation_func,
+      &data);
 
   /* we keep track of the last report time in order to timeout inactive
    * receivers or senders */
@@ -4746,6 +4879,9 @@ rtp_session_on_timeout (RTPSession * sess, GstClockTime current_time,
   sess->scheduled_bye = FALSE;
 
 done:
+  /* the sources are only borrowed while the session lock is held */
+  g_ptr_array_unref (data.report_sources);
+  data.report_sources = NULL;
   RTP_SESSION_UNLOCK (sess);
 
   /* notify about updated statistics */
@@ -4824,6 +4960,18 @@ done:
 gboolean
 rtp_session_request_early_rtcp (RTPSession * sess, GstClockTime current_time,
     GstClockTime max_delay)
+{
+  return rtp_session_request_early_rtcp_full (sess, current_time, max_delay,
+      0);
+}
+
+/* like rtp_session_request_early_rtcp() but don't schedule the early RTCP
+ * packet before @current_time + @min_delay, unless that would miss
+ * @max_delay. Feedback requested in the meantime is then sent in the same
+ * packet. */
+static gboolean
+rtp_session_request_early_rtcp_full (RTPSession * sess,
+    GstClockTime current_time, GstClockTime max_delay, GstClockTime min_delay)
 {
   GstClockTime T_dither_max, T_rr, offset = 0;
   gboolean ret;
@@ -4959,6 +5107,17 @@ rtp_session_request_early_rtcp (RTPSession * sess, GstClockTime current_time,
     sess->next_early_rtcp_time = current_time + offset;
   }
 
+  if (min_delay > 0) {
+    GstClockTime earliest = current_time + MIN (min_delay, max_delay);
+
+    if (sess->next_early_rtcp_time < earliest) {
+      GST_LOG_OBJECT (sess, "holding back early RTCP by %" GST_TIME_FORMAT
+          " to coalesce feedback", GST_TIME_ARGS (earliest -
+              sess->next_early_rtcp_time));
+      sess->next_early_rtcp_time = earliest;
+    }
+  }
+
   GST_LOG_OBJECT (sess, "next early RTCP time %" GST_TIME_FORMAT
       ", next regular RTCP time %" GST_TIME_FORMAT,
       GST_TIME_ARGS (sess->next_early_rtcp_time),
@@ -4981,17 +5140,18 @@ end:
 
 static gboolean
 rtp_session_send_rtcp_internal (RTPSession * sess, GstClockTime now,
-    GstClockTime max_delay)
+    GstClockTime max_delay, GstClockTime min_delay)
 {
   /* notify the application that we intend to send early RTCP */
   if (sess->callbacks.notify_early_rtcp)
     sess->callbacks.notify_early_rtcp (sess, sess->notify_early_rtcp_user_data);
 
-  return rtp_session_request_early_rtcp (sess, now, max_delay);
+  return rtp_session_request_early_rtcp_full (sess, now, max_delay, min_delay);
 }
 
 static gboolean
-rtp_session_send_rtcp_with_deadline (RTPSession * sess, GstClockTime deadline)
+rtp_session_send_rtcp_with_deadline (RTPSession * sess, GstClockTime deadline,
+    GstClockTime min_delay)
 {
   GstClockTime now, max_delay;
 
@@ -5005,7 +5165,7 @@ rtp_session_send_rtcp_with_deadline (RTPSession * sess, GstClockTime deadline)
 
   max_delay = deadline - now;
 
-  return rtp_session_send_rtcp_internal (sess, now, max_delay);
+  return rtp_session_send_rtcp_internal (sess, now, max_delay, min_delay);
 }
 
 static gboolean
@@ -5018,7 +5178,7 @@ rtp_session_send_rtcp (RTPSession * sess, GstClockTime max_delay)
 
   now = sess->callbacks.request_time (sess, sess->request_time_user_data);
 
-  return rtp_session_send_rtcp_internal (sess, now, max_delay);
+  return rtp_session_send_rtcp_internal (sess, now, max_delay, 0);
 }
 
 gboolean
@@ -5074,7 +5234,7 @@ rtp_session_request_nack (RTPSession * sess, guint32 ssrc, guint16 seqnum,
     GstClockTime max_delay)
 {
   RTPSource *source;
-  GstClockTime now;
+  GstClockTime now, min_delay;
 
   if (!sess->callbacks.send_rtcp)
     return FALSE;
@@ -5089,9 +5249,10 @@ rtp_session_request_nack (RTPSession * sess, guint32 ssrc, guint16 seqnum,
   GST_DEBUG ("request NACK for SSRC %08x, #%u, deadline %" GST_TIME_FORMAT,
       ssrc, seqnum, GST_TIME_ARGS (now + max_delay));
   rtp_source_register_nack (source, seqnum, now + max_delay);
+  min_delay = sess->nack_coalescing_window;
   RTP_SESSION_UNLOCK (sess);
 
-  if (!rtp_session_send_rtcp_internal (sess, now, max_delay)) {
+  if (!rtp_session_send_rtcp_internal (sess, now, max_delay, min_delay)) {
     GST_DEBUG ("NACK not sent early, sending with next regular RTCP");
   }
 
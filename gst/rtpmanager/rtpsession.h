@@ -303,6 +303,7 @@ struct _RTPSession {
   gboolean      favor_new;
   GstClockTime  rtcp_feedback_retention_window;
   guint         rtcp_immediate_feedback_threshold;
+  GstClockTime  nack_coalescing_window;
 
   gboolean      is_doing_ptp;
 
@@ -318,6 +319,10 @@ struct _RTPSession {
   /* Transport-wide cc-extension */
   RTPTWCCManager *twcc;
   RTPTWCCStats *twcc_stats;
+
+  /* recycled buffers for outgoing RTCP packets */
+  GstBufferPool *rtcp_pool;
+  guint          rtcp_pool_size;
 };
 
 /**
@@ -365,113 +365,172 @@ rtp_source_finalize (GObject * object)
   G_OBJECT_CLASS (rtp_source_parent_class)->finalize (object);
 }
 
-static GstStructure *
-rtp_source_create_stats (RTPSource * src)
+/**
+ * rtp_source_get_stats_snapshot:
+ * @src: an #RTPSource
+ * @snapshot: (out caller-allocates): an #RTPSourceStatsSnapshot
+ *
+ * Copy the current statistics of @src into @snapshot. This only copies plain
+ * values so that it is cheap enough to be done while holding the session
+ * lock. Use rtp_source_stats_snapshot_to_structure() to turn the snapshot
+ * into a #GstStructure after the lock was released and
+ * rtp_source_stats_snapshot_clear() to release it.
+ */
+void
+rtp_source_get_stats_snapshot (RTPSource * src,
+    RTPSourceStatsSnapshot * snapshot)
+{
+  g_return_if_fail (RTP_IS_SOURCE (src));
+  g_return_if_fail (snapshot != NULL);
+
+  snapshot->ssrc = src->ssrc;
+  snapshot->internal = src->internal;
+  snapshot->validated = src->validated;
+  snapshot->marked_bye = src->marked_bye;
+  snapshot->is_csrc = src->is_csrc;
+  snapshot->is_sender = src->is_sender;
+  snapshot->seqnum_offset = src->seqnum_offset;
+  snapshot->clock_rate = src->clock_rate;
+  snapshot->rtp_from = src->rtp_from ? g_object_ref (src->rtp_from) : NULL;
+  snapshot->rtcp_from = src->rtcp_from ? g_object_ref (src->rtcp_from) : NULL;
+  snapshot->bitrate = src->bitrate;
+  snapshot->recv_packet_rate =
+      gst_rtp_packet_rate_ctx_get (&src->packet_rate_ctx);
+  snapshot->stats = src->stats;
+  snapshot->last_rr = src->last_rr;
+}
+
+/**
+ * rtp_source_stats_snapshot_clear:
+ * @snapshot: an #RTPSourceStatsSnapshot
+ *
+ * Release the resources held by @snapshot.
+ */
+void
+rtp_source_stats_snapshot_clear (RTPSourceStatsSnapshot * snapshot)
+{
+  g_clear_object (&snapshot->rtp_from);
+  g_clear_object (&snapshot->rtcp_from);
+}
+
+/**
+ * rtp_source_stats_snapshot_to_structure:
+ * @snapshot: an #RTPSourceStatsSnapshot
+ *
+ * Build the "application/x-rtp-source-stats" structure, as exposed by the
+ * stats property of #RTPSource, from @snapshot.
+ *
+ * Returns: (transfer full): a new #GstStructure
+ */
+GstStructure *
+rtp_source_stats_snapshot_to_structure (const RTPSourceStatsSnapshot *
+    snapshot)
 {
+  static const RTPSenderReport no_sr = { 0, };
+  static const RTPReceiverReport no_rr = { 0, };
+  const RTPSourceStats *stats = &snapshot->stats;
+  const RTPSenderReport *sr = &stats->sr[stats->curr_sr];
+  const RTPReceiverReport *rr = &stats->rr[stats->curr_rr];
+  const RTPReceiverReport *last_rr = &snapshot->last_rr;
   GstStructure *s;
-  gboolean is_sender = src->is_sender;
-  gboolean internal = src->internal;
   gchar *address_str;
-  gboolean have_rb;
-  guint32 ssrc = 0;
-  guint8 fractionlost = 0;
-  gint32 packetslost = 0;
-  guint32 exthighestseq = 0;
-  guint32 jitter = 0;
-  guint32 lsr = 0;
-  guint32 dlsr = 0;
-  guint32 round_trip = 0;
-  gboolean have_sr;
-  GstClockTime time = 0;
-  guint64 ntptime = 0;
-  guint32 rtptime = 0;
-  guint32 packet_count = 0;
-  guint32 octet_count = 0;
 
+  /* report zeroes for the SR and RB we don't have */
+  if (!sr->is_valid)
+    sr = &no_sr;
+  if (!rr->is_valid)
+    rr = &no_rr;
 
   /* common data for all types of sources */
   s = gst_structure_new ("application/x-rtp-source-stats",
-      "ssrc", G_TYPE_UINT, (guint) src->ssrc,
-      "internal", G_TYPE_BOOLEAN, internal,
-      "validated", G_TYPE_BOOLEAN, src->validated,
-      "received-bye", G_TYPE_BOOLEAN, src->marked_bye,
-      "is-csrc", G_TYPE_BOOLEAN, src->is_csrc,
-      "is-sender", G_TYPE_BOOLEAN, is_sender,
-      "seqnum-base", G_TYPE_INT, src->seqnum_offset,
-      "clock-rate", G_TYPE_INT, src->clock_rate, NULL);
+      "ssrc", G_TYPE_UINT, (guint) snapshot->ssrc,
+      "internal", G_TYPE_BOOLEAN, snapshot->internal,
+      "validated", G_TYPE_BOOLEAN, snapshot->validated,
+      "received-bye", G_TYPE_BOOLEAN, snapshot->marked_bye,
+      "is-csrc", G_TYPE_BOOLEAN, snapshot->is_csrc,
+      "is-sender", G_TYPE_BOOLEAN, snapshot->is_sender,
+      "seqnum-base", G_TYPE_INT, snapshot->seqnum_offset,
+      "clock-rate", G_TYPE_INT, snapshot->clock_rate, NULL);
 
   /* add address and port */
-  if (src->rtp_from) {
-    address_str = __g_socket_address_to_string (src->rtp_from);
+  if (snapshot->rtp_from) {
+    address_str = __g_socket_address_to_string (snapshot->rtp_from);
     gst_structure_set (s, "rtp-from", G_TYPE_STRING, address_str, NULL);
     g_free (address_str);
   }
-  if (src->rtcp_from) {
-    address_str = __g_socket_address_to_string (src->rtcp_from);
+  if (snapshot->rtcp_from) {
+    address_str = __g_socket_address_to_string (snapshot->rtcp_from);
     gst_structure_set (s, "rtcp-from", G_TYPE_STRING, address_str, NULL);
     g_free (address_str);
   }
 
   gst_structure_set (s,
-      "octets-sent", G_TYPE_UINT64, src->stats.octets_sent,
-      "packets-sent", G_TYPE_UINT64, src->stats.packets_sent,
-      "octets-received", G_TYPE_UINT64, src->stats.octets_received,
-      "packets-received", G_TYPE_UINT64, src->stats.packets_received,
-      "bytes-received", G_TYPE_UINT64, src->stats.bytes_received,
-      "bitrate", G_TYPE_UINT64, src->bitrate,
+      "octets-sent", G_TYPE_UINT64, stats->octets_sent,
+      "packets-sent", G_TYPE_UINT64, stats->packets_sent,
+      "octets-received", G_TYPE_UINT64, stats->octets_received,
+      "packets-received", G_TYPE_UINT64, stats->packets_received,
+      "bytes-received", G_TYPE_UINT64, stats->bytes_received,
+      "bitrate", G_TYPE_UINT64, snapshot->bitrate,
       "packets-lost", G_TYPE_INT,
-      (gint) rtp_stats_get_packets_lost (&src->stats), "jitter", G_TYPE_UINT,
-      (guint) (src->stats.jitter >> 4),
-      "sent-pli-count", G_TYPE_UINT, src->stats.sent_pli_count,
-      "recv-pli-count", G_TYPE_UINT, src->stats.recv_pli_count,
-      "sent-fir-count", G_TYPE_UINT, src->stats.sent_fir_count,
-      "recv-fir-count", G_TYPE_UINT, src->stats.recv_fir_count,
-      "sent-nack-count", G_TYPE_UINT, src->stats.sent_nack_count,
-      "recv-nack-count", G_TYPE_UINT, src->stats.recv_nack_count,
-      "recv-packet-rate", G_TYPE_UINT,
-      gst_rtp_packet_rate_ctx_get (&src->packet_rate_ctx), NULL);
-
-  /* get the last SR. */
-  have_sr = rtp_source_get_last_sr (src, &time, &ntptime, &rtptime,
-      &packet_count, &octet_count);
+      (gint) rtp_stats_get_packets_lost (stats), "jitter", G_TYPE_UINT,
+      (guint) (stats->jitter >> 4),
+      "sent-pli-count", G_TYPE_UINT, stats->sent_pli_count,
+      "recv-pli-count", G_TYPE_UINT, stats->recv_pli_count,
+      "sent-fir-count", G_TYPE_UINT, stats->sent_fir_count,
+      "recv-fir-count", G_TYPE_UINT, stats->recv_fir_count,
+      "sent-nack-count", G_TYPE_UINT, stats->sent_nack_count,
+      "recv-nack-count", G_TYPE_UINT, stats->recv_nack_count,
+      "recv-packet-rate", G_TYPE_UINT, snapshot->recv_packet_rate, NULL);
+
+  /* the last SR. */
   gst_structure_set (s,
-      "have-sr", G_TYPE_BOOLEAN, have_sr,
-      "sr-ntptime", G_TYPE_UINT64, ntptime,
-      "sr-rtptime", G_TYPE_UINT, (guint) rtptime,
-      "sr-octet-count", G_TYPE_UINT, (guint) octet_count,
-      "sr-packet-count", G_TYPE_UINT, (guint) packet_count, NULL);
-
-  if (!internal) {
-    /* get the last RB we sent */
+      "have-sr", G_TYPE_BOOLEAN, sr->is_valid,
+      "sr-ntptime", G_TYPE_UINT64, sr->ntptime,
+      "sr-rtptime", G_TYPE_UINT, (guint) sr->rtptime,
+      "sr-octet-count", G_TYPE_UINT, (guint) sr->octet_count,
+      "sr-packet-count", G_TYPE_UINT, (guint) sr->packet_count, NULL);
+
+  if (!snapshot->internal) {
+    /* the last RB we sent */
     gst_structure_set (s,
-        "sent-rb", G_TYPE_BOOLEAN, src->last_rr.is_valid,
-        "sent-rb-fractionlost", G_TYPE_UINT, (guint) src->last_rr.fractionlost,
-        "sent-rb-packetslost", G_TYPE_INT, (gint) src->last_rr.packetslost,
+        "sent-rb", G_TYPE_BOOLEAN, last_rr->is_valid,
+        "sent-rb-fractionlost", G_TYPE_UINT, (guint) last_rr->fractionlost,
+        "sent-rb-packetslost", G_TYPE_INT, (gint) last_rr->packetslost,
         "sent-rb-exthighestseq", G_TYPE_UINT,
-        (guint) src->last_rr.exthighestseq, "sent-rb-jitter", G_TYPE_UINT,
-        (guint) src->last_rr.jitter, "sent-rb-lsr", G_TYPE_UINT,
-        (guint) src->last_rr.lsr, "sent-rb-dlsr", G_TYPE_UINT,
-        (guint) src->last_rr.dlsr, NULL);
-
-    /* get the last RB */
-    have_rb = rtp_source_get_last_rb (src, &ssrc, &fractionlost,
-        &packetslost, &exthighestseq, &jitter, &lsr, &dlsr, &round_trip);
+        (guint) last_rr->exthighestseq, "sent-rb-jitter", G_TYPE_UINT,
+        (guint) last_rr->jitter, "sent-rb-lsr", G_TYPE_UINT,
+        (guint) last_rr->lsr, "sent-rb-dlsr", G_TYPE_UINT,
+        (guint) last_rr->dlsr, NULL);
 
+    /* the last RB */
     gst_structure_set (s,
-        "have-rb", G_TYPE_BOOLEAN, have_rb,
-        "rb-ssrc", G_TYPE_UINT, ssrc,
-        "rb-fractionlost", G_TYPE_UINT, (guint) fractionlost,
-        "rb-packetslost", G_TYPE_INT, (gint) packetslost,
-        "rb-exthighestseq", G_TYPE_UINT, (guint) exthighestseq,
-        "rb-jitter", G_TYPE_UINT, (guint) jitter,
-        "rb-lsr", G_TYPE_UINT, (guint) lsr,
-        "rb-dlsr", G_TYPE_UINT, (guint) dlsr,
-        "rb-round-trip", G_TYPE_UINT, (guint) round_trip, NULL);
+        "have-rb", G_TYPE_BOOLEAN, rr->is_valid,
+        "rb-ssrc", G_TYPE_UINT, rr->ssrc,
+        "rb-fractionlost", G_TYPE_UINT, (guint) rr->fractionlost,
+        "rb-packetslost", G_TYPE_INT, (gint) rr->packetslost,
+        "rb-exthighestseq", G_TYPE_UINT, (guint) rr->exthighestseq,
+        "rb-jitter", G_TYPE_UINT, (guint) rr->jitter,
+        "rb-lsr", G_TYPE_UINT, (guint) rr->lsr,
+        "rb-dlsr", G_TYPE_UINT, (guint) rr->dlsr,
+        "rb-round-trip", G_TYPE_UINT, (guint) rr->round_trip, NULL);
   }
 
   return s;
 }
 
+static GstStructure *
+rtp_source_create_stats (RTPSource * src)
+{
+  RTPSourceStatsSnapshot snapshot;
+  GstStructure *s;
+
+  rtp_source_get_stats_snapshot (src, &snapshot);
+  s = rtp_source_stats_snapshot_to_structure (&snapshot);
+  rtp_source_stats_snapshot_clear (&snapshot);
+
+  return s;
+}
+
 /**
  * rtp_source_get_sdes_struct:
  * @src: an #RTPSource
@@ -209,6 +209,29 @@ struct _RTPSource {
   gboolean      disable_rtcp;
 };
 
+/**
+ * RTPSourceStatsSnapshot:
+ *
+ * A copy of the statistics of an #RTPSource, see
+ * rtp_source_get_stats_snapshot().
+ */
+typedef struct {
+  guint32            ssrc;
+  gboolean           internal;
+  gboolean           validated;
+  gboolean           marked_bye;
+  gboolean           is_csrc;
+  gboolean           is_sender;
+  gint32             seqnum_offset;
+  gint               clock_rate;
+  GSocketAddress    *rtp_from;
+  GSocketAddress    *rtcp_from;
+  guint64            bitrate;
+  guint32            recv_packet_rate;
+  RTPSourceStats     stats;
+  RTPReceiverReport  last_rr;
+} RTPSourceStatsSnapshot;
+
 struct _RTPSourceClass {
   GObjectClass   parent_class;
 };
@@ -272,6 +295,11 @@ gboolean        rtp_source_get_last_rb         (RTPSource *src, guint32 * ssrc,
 
 void            rtp_source_reset               (RTPSource * src);
 
+/* statistics */
+void            rtp_source_get_stats_snapshot  (RTPSource * src, RTPSourceStatsSnapshot * snapshot);
+void            rtp_source_stats_snapshot_clear (RTPSourceStatsSnapshot * snapshot);
+GstStructure *  rtp_source_stats_snapshot_to_structure (const RTPSourceStatsSnapshot * snapshot);
+
 gboolean        rtp_source_find_conflicting_address (RTPSource * src,
                                                 GSocketAddress *address,
                                                 GstClockTime time);
@@ -116,6 +116,7 @@
 
 #include "gstrtspelements.h"
 #include "gstrtspsrc.h"
+#include "gstrtspsrcio.h"
 
 GST_DEBUG_CATEGORY_STATIC (rtspsrc_debug);
 #define GST_CAT_DEFAULT (rtspsrc_debug)
@@ -312,6 +313,9 @@ gst_rtsp_backchannel_get_type (void)
 #define DEFAULT_ONVIF_RATE_CONTROL TRUE
 #define DEFAULT_IS_LIVE TRUE
 #define DEFAULT_IGNORE_X_SERVER_REPLY FALSE
+#define DEFAULT_INTERLEAVED_READ_SIZE 65536
+#define DEFAULT_SHARED_IO_THREADS 0
+#define DEFAULT_PIPELINED_SETUP FALSE
 
 enum
 {
@@ -361,7 +365,10 @@ enum
   PROP_ONVIF_MODE,
   PROP_ONVIF_RATE_CONTROL,
   PROP_IS_LIVE,
-  PROP_IGNORE_X_SERVER_REPLY
+  PROP_IGNORE_X_SERVER_REPLY,
+  PROP_INTERLEAVED_READ_SIZE,
+  PROP_SHARED_IO_THREADS,
+  PROP_PIPELINED_SETUP
 };
 
 #define GST_TYPE_RTSP_NAT_METHOD (gst_rtsp_nat_method_get_type())
@@ -1093,6 +1100,69 @@ gst_rtspsrc_class_init (GstRTSPSrcClass * klass)
           DEFAULT_IGNORE_X_SERVER_REPLY,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstRTSPSrc:interleaved-read-size
+   *
+   * Maximum number of bytes to read from the socket at once when receiving
+   * RTP and RTCP interleaved in the RTSP connection (TCP). All complete
+   * packets of a read are pushed downstream as buffer lists, without
+   * allocating a message for each packet. This is not used for tunneled or
+   * TLS connections.
+   *
+   * When set to 0, the packets are received one message at a time.
+   *
+   * Since: 1.24
+   */
+  g_object_class_install_property (gobject_class, PROP_INTERLEAVED_READ_SIZE,
+      g_param_spec_uint ("interleaved-read-size", "Interleaved Read Size",
+          "Maximum number of bytes to read at once in interleaved mode "
+          "(0 = one message at a time)", 0, G_MAXINT,
+          DEFAULT_INTERLEAVED_READ_SIZE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRTSPSrc:shared-io-threads
+   *
+   * When receiving interleaved data (RTP over RTSP/TCP), wait for the data
+   * on one of this many process-wide I/O threads instead of on a thread of
+   * this element. The I/O threads are shared by all the elements that set
+   * this property, which saves one mostly sleeping thread per element when
+   * receiving many streams. The received packets are pushed from the I/O
+   * threads.
+   *
+   * This is not used for UDP, tunneled or TLS connections.
+   *
+   * When set to 0, each element receives on its own thread.
+   *
+   * Since: 1.24
+   */
+  g_object_class_install_property (gobject_class, PROP_SHARED_IO_THREADS,
+      g_param_spec_uint ("shared-io-threads", "Shared I/O Threads",
+          "Number of shared I/O threads to receive interleaved data on "
+          "(0 = use a thread of this element)", 0, 64,
+          DEFAULT_SHARED_IO_THREADS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRTSPSrc:pipelined-setup
+   *
+   * With RTSP 1.0, only wait for the response to the SETUP request of the
+   * first stream. The SETUP requests of the other streams are then sent
+   * back to back on the same connection, using the session and transport
+   * selected by the first response, and their responses are collected
+   * afterwards. This saves one round trip per additional stream.
+   *
+   * This requires a server that handles pipelined requests. RTSP 2.0
+   * always pipelines the SETUP requests.
+   *
+   * Since: 1.24
+   */
+  g_object_class_install_property (gobject_class, PROP_PIPELINED_SETUP,
+      g_param_spec_boolean ("pipelined-setup", "Pipelined SETUP",
+          "Send the SETUP requests of all streams after the first one "
+          "without waiting for the responses", DEFAULT_PIPELINED_SETUP,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   /**
    * GstRTSPSrc::handle-request:
    * @rtspsrc: a #GstRTSPSrc
@@ -1520,6 +1590,9 @@ gst_rtspsrc_init (GstRTSPSrc * src)
   src->onvif_mode = DEFAULT_ONVIF_MODE;
   src->onvif_rate_control = DEFAULT_ONVIF_RATE_CONTROL;
   src->is_live = DEFAULT_IS_LIVE;
+  src->interleaved_read_size = DEFAULT_INTERLEAVED_READ_SIZE;
+  src->shared_io_threads = DEFAULT_SHARED_IO_THREADS;
+  src->pipelined_setup = DEFAULT_PIPELINED_SETUP;
   src->seek_seqnum = GST_SEQNUM_INVALID;
   src->group_id = GST_GROUP_ID_INVALID;
 
@@ -1546,6 +1619,7 @@ gst_rtspsrc_init (GstRTSPSrc * src)
   g_cond_init (&src->cmd_cond);
 
   g_mutex_init (&src->group_lock);
+  g_mutex_init (&src->io_lock);
 
   GST_OBJECT_FLAG_SET (src, GST_ELEMENT_FLAG_SOURCE);
   gst_bin_set_suppressed_flags (GST_BIN (src),
@@ -1606,6 +1680,7 @@ gst_rtspsrc_finalize (GObject * object)
   g_cond_clear (&rtspsrc->cmd_cond);
 
   g_mutex_clear (&rtspsrc->group_lock);
+  g_mutex_clear (&rtspsrc->io_lock);
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
@@ -1867,6 +1942,15 @@ gst_rtspsrc_set_property (GObject * object, guint prop_id, const GValue * value,
     case PROP_IGNORE_X_SERVER_REPLY:
       rtspsrc->ignore_x_server_reply = g_value_get_boolean (value);
       break;
+    case PROP_INTERLEAVED_READ_SIZE:
+      rtspsrc->interleaved_read_size = g_value_get_uint (value);
+      break;
+    case PROP_SHARED_IO_THREADS:
+      rtspsrc->shared_io_threads = g_value_get_uint (value);
+      break;
+    case PROP_PIPELINED_SETUP:
+      rtspsrc->pipelined_setup = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -2040,6 +2124,15 @@ gst_rtspsrc_get_property (GObject * object, guint prop_id, GValue * value,
     case PROP_IGNORE_X_SERVER_REPLY:
       g_value_set_boolean (value, rtspsrc->ignore_x_server_reply);
       break;
+    case PROP_INTERLEAVED_READ_SIZE:
+      g_value_set_uint (value, rtspsrc->interleaved_read_size);
+      break;
+    case PROP_SHARED_IO_THREADS:
+      g_value_set_uint (value, rtspsrc->shared_io_threads);
+      break;
+    case PROP_PIPELINED_SETUP:
+      g_value_set_boolean (value, rtspsrc->pipelined_setup);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -5574,65 +5667,57 @@ send_error:
   }
 }
 
-static GstFlowReturn
-gst_rtspsrc_handle_data (GstRTSPSrc * src, GstRTSPMessage * message)
+/* Find the stream and the pad for data received on @channel. Returns %NULL
+ * when the data can't be associated with a stream. */
+static GstRTSPStream *
+gst_rtspsrc_get_data_stream (GstRTSPSrc * src, gint channel,
+    const guint8 * data, GstPad ** outpad, gboolean * is_rtcp)
 {
-  GstFlowReturn ret = GST_FLOW_OK;
-  gint channel;
   GstRTSPStream *stream;
-  GstPad *outpad = NULL;
-  guint8 *data;
-  guint size;
-  GstBuffer *buf;
-  gboolean is_rtcp;
-
-  channel = message->type_data.data.channel;
 
   stream = find_stream (src, &channel, (gpointer) find_stream_by_channel);
   if (!stream)
     goto unknown_stream;
 
   if (channel == stream->channel[0]) {
-    outpad = stream->channelpad[0];
-    is_rtcp = FALSE;
+    *outpad = stream->channelpad[0];
+    *is_rtcp = FALSE;
   } else if (channel == stream->channel[1]) {
-    outpad = stream->channelpad[1];
-    is_rtcp = TRUE;
+    *outpad = stream->channelpad[1];
+    *is_rtcp = TRUE;
   } else {
-    is_rtcp = FALSE;
+    *outpad = NULL;
+    *is_rtcp = FALSE;
   }
 
-  /* take a look at the body to figure out what we have */
-  gst_rtsp_message_get_body (message, &data, &size);
-  if (size < 2)
-    goto invalid_length;
-
   /* channels are not correct on some servers, do extra check */
   if (data[1] >= 200 && data[1] <= 204) {
     /* hmm RTCP message switch to the RTCP pad of the same stream. */
-    outpad = stream->channelpad[1];
-    is_rtcp = TRUE;
+    *outpad = stream->channelpad[1];
+    *is_rtcp = TRUE;
   }
 
   /* we have no clue what this is, just ignore then. */
-  if (outpad == NULL)
+  if (*outpad == NULL)
     goto unknown_stream;
 
-  /* take the message body for further processing */
-  gst_rtsp_message_steal_body (message, &data, &size);
-
-  /* strip the trailing \0 */
-  size -= 1;
-
-  buf = gst_buffer_new ();
-  gst_buffer_append_memory (buf,
-      gst_memory_new_wrapped (0, data, size, 0, size, data, g_free));
+  return stream;
 
-  /* don't need message anymore */
-  gst_rtsp_message_unset (message);
+  /* ERRORS */
+unknown_stream:
+  {
+    GST_DEBUG_OBJECT (src, "unknown stream on channel %d, ignored", channel);
+    return NULL;
+  }
+}
 
-  GST_DEBUG_OBJECT (src, "pushing data of size %d on channel %d", size,
-      channel);
+/* Push @buf or @list, which were received for @stream, on @outpad. The
+ * first data activates the streams and sends the pending events. */
+static GstFlowReturn
+gst_rtspsrc_push_data (GstRTSPSrc * src, GstRTSPStream * stream,
+    GstPad * outpad, gboolean is_rtcp, GstBuffer * buf, GstBufferList * list)
+{
+  GstFlowReturn ret;
 
   if (src->need_activate) {
     gchar *stream_id;
@@ -5771,36 +5856,87 @@ gst_rtspsrc_handle_data (GstRTSPSrc * src, GstRTSPMessage * message)
   }
 
   if (stream->discont && !is_rtcp) {
+    GstBuffer *first;
+
     /* mark first RTP buffer as discont */
-    GST_BUFFER_FLAG_SET (buf, GST_BUFFER_FLAG_DISCONT);
+    if (list)
+      first = gst_buffer_list_get_writable (list, 0);
+    else
+      first = buf;
+
+    GST_BUFFER_FLAG_SET (first, GST_BUFFER_FLAG_DISCONT);
     stream->discont = FALSE;
     /* first buffer gets the timestamp, other buffers are not timestamped and
      * their presentation time will be interpollated from the rtp timestamps. */
     GST_DEBUG_OBJECT (src, "setting timestamp %" GST_TIME_FORMAT,
         GST_TIME_ARGS (src->base_time));
 
-    GST_BUFFER_TIMESTAMP (buf) = src->base_time;
+    GST_BUFFER_TIMESTAMP (first) = src->base_time;
   }
 
   /* chain to the peer pad */
-  if (GST_PAD_IS_SINK (outpad))
-    ret = gst_pad_chain (outpad, buf);
-  else
-    ret = gst_pad_push (outpad, buf);
+  if (list) {
+    if (GST_PAD_IS_SINK (outpad))
+      ret = gst_pad_chain_list (outpad, list);
+    else
+      ret = gst_pad_push_list (outpad, list);
+  } else {
+    if (GST_PAD_IS_SINK (outpad))
+      ret = gst_pad_chain (outpad, buf);
+    else
+      ret = gst_pad_push (outpad, buf);
+  }
 
   if (!is_rtcp) {
     /* combine all stream flows for the data transport */
     ret = gst_rtspsrc_combine_flows (src, stream, ret);
   }
   return ret;
+}
 
-  /* ERRORS */
-unknown_stream:
-  {
-    GST_DEBUG_OBJECT (src, "unknown stream on channel %d, ignored", channel);
+static GstFlowReturn
+gst_rtspsrc_handle_data (GstRTSPSrc * src, GstRTSPMessage * message)
+{
+  gint channel;
+  GstRTSPStream *stream;
+  GstPad *outpad = NULL;
+  guint8 *data;
+  guint size;
+  GstBuffer *buf;
+  gboolean is_rtcp;
+
+  channel = message->type_data.data.channel;
+
+  /* take a look at the body to figure out what we have */
+  gst_rtsp_message_get_body (message, &data, &size);
+  if (size < 2)
+    goto invalid_length;
+
+  stream = gst_rtspsrc_get_data_stream (src, channel, data, &outpad, &is_rtcp);
+  if (!stream) {
     gst_rtsp_message_unset (message);
     return GST_FLOW_OK;
   }
+
+  /* take the message body for further processing */
+  gst_rtsp_message_steal_body (message, &data, &size);
+
+  /* strip the trailing \0 */
+  size -= 1;
+
+  buf = gst_buffer_new ();
+  gst_buffer_append_memory (buf,
+      gst_memory_new_wrapped (0, data, size, 0, size, data, g_free));
+
+  /* don't need message anymore */
+  gst_rtsp_message_unset (message);
+
+  GST_DEBUG_OBJECT (src, "pushing data of size %d on channel %d", size,
+      channel);
+
+  return gst_rtspsrc_push_data (src, stream, outpad, is_rtcp, buf, NULL);
+
+  /* ERRORS */
 invalid_length:
   {
     GST_ELEMENT_WARNING (src, RESOURCE, READ, (NULL),
@@ -5810,73 +5946,243 @@ invalid_length:
   }
 }
 
-static GstFlowReturn
-gst_rtspsrc_loop_interleaved (GstRTSPSrc * src)
+/* Read all complete interleaved data frames that are pending on the socket
+ * in one go and push them as buffer lists, one list for each run of frames
+ * on the same pad. The frames are sub-buffers of a single memory so no
+ * message or copy is needed per packet.
+ *
+ * The pending data is peeked first and only whole frames are consumed, RTSP
+ * messages and incomplete frames stay on the socket for
+ * gst_rtspsrc_connection_receive(). Returns the number of bytes consumed. */
+static gsize
+gst_rtspsrc_receive_interleaved (GstRTSPSrc * src, GstFlowReturn * ret)
 {
-  GstRTSPMessage message = { 0 };
-  GstRTSPResult res;
-  GstFlowReturn ret = GST_FLOW_OK;
+  GstRTSPConnection *conn;
+  GSocket *socket;
+  GstMemory *mem;
+  GstMapInfo map;
+  GInputVector vec;
+  GError *err = NULL;
+  gssize avail, len;
+  gsize offset, consumed;
+  gint flags;
+  GstRTSPStream *cur_stream = NULL;
+  GstPad *cur_pad = NULL;
+  gboolean cur_rtcp = FALSE;
+  GstBufferList *list = NULL;
+
+  *ret = GST_FLOW_OK;
+
+  g_mutex_lock (&src->conninfo.recv_lock);
+  conn = src->conninfo.connection;
+  /* we can only parse the raw socket data when it is not encrypted or
+   * tunneled over HTTP */
+  if (conn == NULL || gst_rtsp_connection_is_tunneled (conn) ||
+      (src->conninfo.url->transports & GST_RTSP_LOWER_TRANS_TLS))
+    goto no_data;
 
-  while (TRUE) {
-    gst_rtsp_message_unset (&message);
+  socket = gst_rtsp_connection_get_read_socket (conn);
+  if (socket == NULL)
+    goto no_data;
 
-    if (src->conninfo.flushing) {
-      /* do not attempt to receive if flushing */
-      res = GST_RTSP_EINTR;
-    } else {
-      /* protect the connection with the connection lock so that we can see when
-       * we are finished doing server communication */
-      res = gst_rtspsrc_connection_receive (src, &src->conninfo, &message,
-          src->tcp_timeout);
+  avail = g_socket_get_available_bytes (socket);
+  if (avail < 4 || src->interleaved_read_size < 4)
+    goto no_data;
+
+  avail = MIN (avail, src->interleaved_read_size);
+  mem = gst_allocator_alloc (NULL, avail, NULL);
+  gst_memory_map (mem, &map, GST_MAP_WRITE);
+
+  vec.buffer = map.data;
+  vec.size = avail;
+  flags = G_SOCKET_MSG_PEEK;
+  len = g_socket_receive_message (socket, NULL, &vec, 1, NULL, NULL, &flags,
+      NULL, &err);
+  if (len < 0)
+    goto receive_failed;
+
+  offset = 0;
+  while (offset + 4 <= (gsize) len && map.data[offset] == '$') {
+    guint size = GST_READ_UINT16_BE (map.data + offset + 2);
+
+    if (offset + 4 + size > (gsize) len)
+      break;
+    offset += 4 + size;
+  }
+  if (offset == 0)
+    goto no_frames;
+
+  /* now consume the complete frames, they end up where they were peeked */
+  for (consumed = 0; consumed < offset; consumed += len) {
+    len = g_socket_receive (socket, (gchar *) map.data + consumed,
+        offset - consumed, NULL, &err);
+    if (len <= 0)
+      goto receive_failed;
+  }
+  g_mutex_unlock (&src->conninfo.recv_lock);
+
+  gst_memory_unmap (mem, &map);
+  gst_memory_resize (mem, 0, offset);
+  gst_memory_map (mem, &map, GST_MAP_READ);
+
+  GST_LOG_OBJECT (src, "received %" G_GSIZE_FORMAT " bytes of data frames",
+      offset);
+
+  for (consumed = 0; consumed < offset;) {
+    GstRTSPStream *stream;
+    GstPad *outpad = NULL;
+    gboolean is_rtcp;
+    GstBuffer *buf;
+    guint8 channel = map.data[consumed + 1];
+    guint size = GST_READ_UINT16_BE (map.data + consumed + 2);
+
+    consumed += 4;
+
+    if (size < 2) {
+      GST_ELEMENT_WARNING (src, RESOURCE, READ, (NULL),
+          ("Short message received, ignoring."));
+      consumed += size;
+      continue;
     }
 
-    switch (res) {
-      case GST_RTSP_OK:
-        GST_DEBUG_OBJECT (src, "we received a server message");
-        break;
-      case GST_RTSP_EINTR:
-        /* we got interrupted this means we need to stop */
-        goto interrupt;
-      case GST_RTSP_ETIMEOUT:
-        /* no reply, send keep alive */
-        GST_DEBUG_OBJECT (src, "timeout, sending keep-alive");
-        if ((res = gst_rtspsrc_send_keep_alive (src)) == GST_RTSP_EINTR)
-          goto interrupt;
-        continue;
-      case GST_RTSP_EEOF:
-        /* go EOS when the server closed the connection */
-        goto server_eof;
-      default:
-        goto receive_error;
+    stream = gst_rtspsrc_get_data_stream (src, channel,
+        map.data + consumed, &outpad, &is_rtcp);
+    if (!stream) {
+      consumed += size;
+      continue;
     }
 
-    switch (message.type) {
-      case GST_RTSP_MESSAGE_REQUEST:
-        /* server sends us a request message, handle it */
-        res = gst_rtspsrc_handle_request (src, &src->conninfo, &message);
-        if (res == GST_RTSP_EEOF)
-          goto server_eof;
-        else if (res < 0)
-          goto handle_request_failed;
-        break;
-      case GST_RTSP_MESSAGE_RESPONSE:
-        /* we ignore response messages */
-        GST_DEBUG_OBJECT (src, "ignoring response message");
-        DEBUG_RTSP (src, &message);
-        break;
-      case GST_RTSP_MESSAGE_DATA:
-        GST_DEBUG_OBJECT (src, "got data message");
-        ret = gst_rtspsrc_handle_data (src, &message);
-        if (ret != GST_FLOW_OK)
-          goto handle_data_failed;
-        break;
-      default:
-        GST_WARNING_OBJECT (src, "ignoring unknown message type %d",
-            message.type);
+    if (list && outpad != cur_pad) {
+      GST_DEBUG_OBJECT (src, "pushing list of %u buffers",
+          gst_buffer_list_length (list));
+      *ret = gst_rtspsrc_push_data (src, cur_stream, cur_pad, cur_rtcp, NULL,
+          list);
+      list = NULL;
+      if (*ret != GST_FLOW_OK)
         break;
     }
+    if (!list) {
+      list = gst_buffer_list_new ();
+      cur_stream = stream;
+      cur_pad = outpad;
+      cur_rtcp = is_rtcp;
+    }
+
+    buf = gst_buffer_new ();
+    gst_buffer_append_memory (buf, gst_memory_share (mem, consumed, size));
+    gst_buffer_list_add (list, buf);
+
+    consumed += size;
   }
-  g_assert_not_reached ();
+
+  if (list) {
+    if (*ret == GST_FLOW_OK) {
+      GST_DEBUG_OBJECT (src, "pushing list of %u buffers",
+          gst_buffer_list_length (list));
+      *ret = gst_rtspsrc_push_data (src, cur_stream, cur_pad, cur_rtcp, NULL,
+          list);
+    } else {
+      gst_buffer_list_unref (list);
+    }
+  }
+
+  gst_memory_unmap (mem, &map);
+  gst_memory_unref (mem);
+
+  return offset;
+
+  /* ERRORS */
+no_data:
+  {
+    g_mutex_unlock (&src->conninfo.recv_lock);
+    return 0;
+  }
+no_frames:
+  {
+    g_mutex_unlock (&src->conninfo.recv_lock);
+    gst_memory_unmap (mem, &map);
+    gst_memory_unref (mem);
+    return 0;
+  }
+receive_failed:
+  {
+    /* leave the error handling to gst_rtspsrc_connection_receive() */
+    GST_DEBUG_OBJECT (src, "failed to receive data: %s",
+        err ? err->message : "connection closed");
+    g_clear_error (&err);
+    g_mutex_unlock (&src->conninfo.recv_lock);
+    gst_memory_unmap (mem, &map);
+    gst_memory_unref (mem);
+    return 0;
+  }
+}
+
+/* Receive and handle one message from the server */
+static GstFlowReturn
+gst_rtspsrc_receive_message (GstRTSPSrc * src)
+{
+  GstRTSPMessage message = { 0 };
+  GstRTSPResult res;
+  GstFlowReturn ret = GST_FLOW_OK;
+
+  if (src->conninfo.flushing) {
+    /* do not attempt to receive if flushing */
+    res = GST_RTSP_EINTR;
+  } else {
+    /* protect the connection with the connection lock so that we can see when
+     * we are finished doing server communication */
+    res = gst_rtspsrc_connection_receive (src, &src->conninfo, &message,
+        src->tcp_timeout);
+  }
+
+  switch (res) {
+    case GST_RTSP_OK:
+      GST_DEBUG_OBJECT (src, "we received a server message");
+      break;
+    case GST_RTSP_EINTR:
+      /* we got interrupted this means we need to stop */
+      goto interrupt;
+    case GST_RTSP_ETIMEOUT:
+      /* no reply, send keep alive */
+      GST_DEBUG_OBJECT (src, "timeout, sending keep-alive");
+      if ((res = gst_rtspsrc_send_keep_alive (src)) == GST_RTSP_EINTR)
+        goto interrupt;
+      return GST_FLOW_OK;
+    case GST_RTSP_EEOF:
+      /* go EOS when the server closed the connection */
+      goto server_eof;
+    default:
+      goto receive_error;
+  }
+
+  switch (message.type) {
+    case GST_RTSP_MESSAGE_REQUEST:
+      /* server sends us a request message, handle it */
+      res = gst_rtspsrc_handle_request (src, &src->conninfo, &message);
+      if (res == GST_RTSP_EEOF)
+        goto server_eof;
+      else if (res < 0)
+        goto handle_request_failed;
+      break;
+    case GST_RTSP_MESSAGE_RESPONSE:
+      /* we ignore response messages */
+      GST_DEBUG_OBJECT (src, "ignoring response message");
+      DEBUG_RTSP (src, &message);
+      break;
+    case GST_RTSP_MESSAGE_DATA:
+      GST_DEBUG_OBJECT (src, "got data message");
+      ret = gst_rtspsrc_handle_data (src, &message);
+      if (ret != GST_FLOW_OK)
+        goto handle_data_failed;
+      break;
+    default:
+      GST_WARNING_OBJECT (src, "ignoring unknown message type %d",
+          message.type);
+      break;
+  }
+  gst_rtsp_message_unset (&message);
+
+  return GST_FLOW_OK;
 
   /* ERRORS */
 server_eof:
@@ -5922,6 +6228,23 @@ handle_data_failed:
   }
 }
 
+static GstFlowReturn
+gst_rtspsrc_loop_interleaved (GstRTSPSrc * src)
+{
+  GstFlowReturn ret = GST_FLOW_OK;
+
+  while (ret == GST_FLOW_OK) {
+    if (src->interleaved_read_size > 0 && !src->conninfo.flushing) {
+      /* first take all the data frames that are already waiting */
+      if (gst_rtspsrc_receive_interleaved (src, &ret) > 0)
+        continue;
+    }
+    ret = gst_rtspsrc_receive_message (src);
+  }
+
+  return ret;
+}
+
 static GstFlowReturn
 gst_rtspsrc_loop_udp (GstRTSPSrc * src)
 {
@@ -6276,9 +6599,21 @@ gst_rtspsrc_loop_end_cmd (GstRTSPSrc * src, gint cmd, GstRTSPResult ret)
     gst_rtspsrc_loop_error_cmd (src, cmd);
 }
 
+/* Start @task, which stops itself while the I/O thread receives for us. It
+ * has to be finished before it is started again, and it takes the object
+ * lock on its way out, so this is called without that lock. */
+static void
+gst_rtspsrc_task_start (GstTask * task)
+{
+  if (gst_task_get_state (task) == GST_TASK_STOPPED)
+    gst_task_join (task);
+  gst_task_start (task);
+}
+
 static gboolean
 gst_rtspsrc_loop_send_cmd (GstRTSPSrc * src, gint cmd, gint mask)
 {
+  GstTask *task = NULL;
   gint old;
   gboolean flushed = FALSE;
 
@@ -6326,9 +6661,14 @@ gst_rtspsrc_loop_send_cmd (GstRTSPSrc * src, gint cmd, gint mask)
         cmd_to_string (src->busy_cmd));
   }
   if (src->task)
-    gst_task_start (src->task);
+    task = gst_object_ref (src->task);
   GST_OBJECT_UNLOCK (src);
 
+  if (task) {
+    gst_rtspsrc_task_start (task);
+    gst_object_unref (task);
+  }
+
   return flushed;
 }
 
@@ -6354,6 +6694,332 @@ gst_rtspsrc_loop_send_cmd_and_wait (GstRTSPSrc * src, gint cmd, gint mask,
   return flushed;
 }
 
+static void
+gst_rtspsrc_loop_pause (GstRTSPSrc * src, GstFlowReturn ret)
+{
+  const gchar *reason = gst_flow_get_name (ret);
+
+  GST_DEBUG_OBJECT (src, "pausing task, reason %s", reason);
+  src->running = FALSE;
+  if (ret == GST_FLOW_EOS) {
+    /* perform EOS logic */
+    if (src->segment.flags & GST_SEEK_FLAG_SEGMENT) {
+      gst_element_post_message (GST_ELEMENT_CAST (src),
+          gst_message_new_segment_done (GST_OBJECT_CAST (src),
+              src->segment.format, src->segment.position));
+      gst_rtspsrc_push_event (src,
+          gst_event_new_segment_done (src->segment.format,
+              src->segment.position));
+    } else {
+      gst_rtspsrc_push_event (src, gst_event_new_eos ());
+    }
+  } else if (ret == GST_FLOW_NOT_LINKED || ret < GST_FLOW_EOS) {
+    /* for fatal errors we post an error message, post the error before the
+     * EOS so the app knows about the error first. */
+    GST_ELEMENT_FLOW_ERROR (src, ret);
+    gst_rtspsrc_push_event (src, gst_event_new_eos ());
+  }
+  gst_rtspsrc_loop_send_cmd (src, CMD_WAIT, CMD_LOOP);
+}
+
+/* Push the data frame in @mem that was received on @channel */
+static GstFlowReturn
+gst_rtspsrc_push_frame (GstRTSPSrc * src, guint8 channel, GstMemory * mem)
+{
+  GstRTSPStream *stream;
+  GstPad *outpad = NULL;
+  gboolean is_rtcp;
+  GstMapInfo map;
+  GstBuffer *buf;
+
+  gst_memory_map (mem, &map, GST_MAP_READ);
+  if (map.size < 2)
+    goto invalid_length;
+
+  stream = gst_rtspsrc_get_data_stream (src, channel, map.data, &outpad,
+      &is_rtcp);
+  gst_memory_unmap (mem, &map);
+  if (!stream) {
+    gst_memory_unref (mem);
+    return GST_FLOW_OK;
+  }
+
+  buf = gst_buffer_new ();
+  gst_buffer_append_memory (buf, mem);
+
+  return gst_rtspsrc_push_data (src, stream, outpad, is_rtcp, buf, NULL);
+
+  /* ERRORS */
+invalid_length:
+  {
+    GST_ELEMENT_WARNING (src, RESOURCE, READ, (NULL),
+        ("Short message received, ignoring."));
+    gst_memory_unmap (mem, &map);
+    gst_memory_unref (mem);
+    return GST_FLOW_OK;
+  }
+}
+
+/* Read what is available of the data frame that starts or continues at the
+ * current position of the socket, without blocking. The frame is pushed
+ * once it is complete. */
+static GstFlowReturn
+gst_rtspsrc_io_receive_frame (GstRTSPSrc * src, GSocket * socket)
+{
+  GError *err = NULL;
+  GstMapInfo map;
+  gssize len;
+  guint size;
+
+  g_mutex_lock (&src->conninfo.recv_lock);
+  if (src->io_header_fill < 4) {
+    len = g_socket_receive_with_blocking (socket,
+        (gchar *) src->io_header + src->io_header_fill,
+        4 - src->io_header_fill, FALSE, NULL, &err);
+    if (len <= 0)
+      goto receive_failed;
+
+    src->io_header_fill += len;
+    if (src->io_header_fill < 4)
+      goto incomplete;
+
+    size = GST_READ_UINT16_BE (src->io_header + 2);
+    src->io_frame = gst_allocator_alloc (NULL, size, NULL);
+    src->io_frame_fill = 0;
+  }
+
+  size = GST_READ_UINT16_BE (src->io_header + 2);
+  if (src->io_frame_fill < size) {
+    gst_memory_map (src->io_frame, &map, GST_MAP_WRITE);
+    len = g_socket_receive_with_blocking (socket,
+        (gchar *) map.data + src->io_frame_fill, size - src->io_frame_fill,
+        FALSE, NULL, &err);
+    gst_memory_unmap (src->io_frame, &map);
+    if (len <= 0)
+      goto receive_failed;
+
+    src->io_frame_fill += len;
+    if (src->io_frame_fill < size)
+      goto incomplete;
+  }
+  g_mutex_unlock (&src->conninfo.recv_lock);
+
+  GST_LOG_OBJECT (src, "received data frame of %u bytes", size);
+
+  src->io_header_fill = 0;
+  return gst_rtspsrc_push_frame (src, src->io_header[1],
+      g_steal_pointer (&src->io_frame));
+
+incomplete:
+  {
+    g_mutex_unlock (&src->conninfo.recv_lock);
+    return GST_FLOW_OK;
+  }
+receive_failed:
+  {
+    g_mutex_unlock (&src->conninfo.recv_lock);
+    if (len == 0) {
+      GST_DEBUG_OBJECT (src, "we got an eof from the server");
+      GST_ELEMENT_WARNING (src, RESOURCE, READ, (NULL),
+          ("The server closed the connection."));
+      src->conninfo.connected = FALSE;
+      return GST_FLOW_EOS;
+    }
+    if (g_error_matches (err, G_IO_ERROR, G_IO_ERROR_WOULD_BLOCK)) {
+      g_clear_error (&err);
+      return GST_FLOW_OK;
+    }
+    GST_ELEMENT_ERROR (src, RESOURCE, READ, (NULL),
+        ("Could not receive message. (%s)", err->message));
+    g_clear_error (&err);
+    return GST_FLOW_ERROR;
+  }
+}
+
+/* Check without blocking whether the server sent something else than a data
+ * frame: a message, the end of the stream or an error. Those are received
+ * with gst_rtspsrc_receive_message(), which waits for all of it. */
+static gboolean
+gst_rtspsrc_io_message_pending (GSocket * socket)
+{
+  guint8 first = 0;
+  GInputVector vec = { &first, 1 };
+  gint flags = G_SOCKET_MSG_PEEK;
+
+  if (g_socket_condition_check (socket, G_IO_IN | G_IO_ERR | G_IO_HUP) == 0)
+    return FALSE;
+
+  return g_socket_receive_message (socket, NULL, &vec, 1, NULL, NULL, &flags,
+      NULL, NULL) != 1 || first != '$';
+}
+
+/* Let the task receive what the I/O thread can't receive without blocking */
+static void
+gst_rtspsrc_io_wake_task (GstRTSPSrc * src)
+{
+  GstTask *task = NULL;
+
+  GST_OBJECT_LOCK (src);
+  /* a pending command takes the connection back by itself */
+  if (src->pending_cmd == CMD_WAIT && src->task) {
+    GST_DEBUG_OBJECT (src, "handing the connection back to the task");
+    src->pending_cmd = CMD_LOOP;
+    task = gst_object_ref (src->task);
+  }
+  GST_OBJECT_UNLOCK (src);
+
+  if (task) {
+    gst_rtspsrc_task_start (task);
+    gst_object_unref (task);
+  }
+}
+
+/* Called from a shared I/O thread when the connection is readable */
+static gboolean
+gst_rtspsrc_io_dispatch (GSocket * socket, GIOCondition condition,
+    GstRTSPSrc * src)
+{
+  GstFlowReturn ret = GST_FLOW_OK;
+  gboolean message = FALSE;
+
+  g_mutex_lock (&src->io_lock);
+  /* we were detached while waiting for the lock, or the connection is
+   * being handed to the task for a keep-alive */
+  if (g_source_is_destroyed (g_main_current_source ()) || src->io_keep_alive) {
+    g_mutex_unlock (&src->io_lock);
+    return FALSE;
+  }
+
+  src->io_last_activity = g_get_monotonic_time ();
+
+  if (src->io_header_fill > 0) {
+    /* continue the data frame we are in the middle of */
+    ret = gst_rtspsrc_io_receive_frame (src, socket);
+  } else if (gst_rtspsrc_receive_interleaved (src, &ret) == 0) {
+    /* no complete data frames, a data frame is received in parts so that we
+     * don't have to wait for it */
+    message = gst_rtspsrc_io_message_pending (socket);
+    if (!message)
+      ret = gst_rtspsrc_io_receive_frame (src, socket);
+  }
+  g_mutex_unlock (&src->io_lock);
+
+  /* the task is started without the I/O lock, it takes that lock to detach
+   * the connection from here */
+  if (ret != GST_FLOW_OK) {
+    gst_rtspsrc_loop_pause (src, ret);
+    return FALSE;
+  }
+  if (message) {
+    gst_rtspsrc_io_wake_task (src);
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+static gboolean
+gst_rtspsrc_io_timeout (GstRTSPSrc * src)
+{
+  gboolean keep_alive = FALSE;
+
+  g_mutex_lock (&src->io_lock);
+  if (g_source_is_destroyed (g_main_current_source ())) {
+    g_mutex_unlock (&src->io_lock);
+    return FALSE;
+  }
+
+  /* sending the keep-alive blocks, it is handed to the task like the server
+   * messages. A partial data frame is finished first, the connection can't
+   * be handed over in the middle of one. */
+  if (src->io_header_fill == 0 &&
+      g_get_monotonic_time () - src->io_last_activity >= src->tcp_timeout) {
+    GST_DEBUG_OBJECT (src, "timeout, letting the task send a keep-alive");
+    src->io_keep_alive = TRUE;
+    keep_alive = TRUE;
+  }
+  g_mutex_unlock (&src->io_lock);
+
+  if (keep_alive) {
+    gst_rtspsrc_io_wake_task (src);
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+/* Get the socket a shared I/O thread can receive the interleaved data from,
+ * or %NULL when the connection can't be used from there */
+static GSocket *
+gst_rtspsrc_io_get_socket (GstRTSPSrc * src)
+{
+  GstRTSPConnection *conn = src->conninfo.connection;
+
+  if (src->shared_io_threads == 0)
+    return NULL;
+
+  /* we can only parse the raw socket data when it is not encrypted or
+   * tunneled over HTTP */
+  if (gst_rtsp_connection_is_tunneled (conn) ||
+      (src->conninfo.url->transports & GST_RTSP_LOWER_TRANS_TLS))
+    return NULL;
+
+  return gst_rtsp_connection_get_read_socket (conn);
+}
+
+/* Let a shared I/O thread receive the interleaved data from @socket */
+static void
+gst_rtspsrc_io_attach (GstRTSPSrc * src, GSocket * socket)
+{
+  if (src->io_context == NULL)
+    src->io_context = gst_rtspsrc_io_context_acquire (src->shared_io_threads);
+
+  GST_DEBUG_OBJECT (src, "receiving on shared I/O thread");
+
+  g_mutex_lock (&src->io_lock);
+  src->io_last_activity = g_get_monotonic_time ();
+
+  src->io_source = g_socket_create_source (socket,
+      G_IO_IN | G_IO_ERR | G_IO_HUP, NULL);
+  g_source_set_callback (src->io_source,
+      (GSourceFunc) gst_rtspsrc_io_dispatch, src, NULL);
+  g_source_attach (src->io_source, src->io_context);
+
+  if (src->tcp_timeout > 0) {
+    src->io_timeout = g_timeout_source_new (MAX (src->tcp_timeout / 1000, 1));
+    g_source_set_callback (src->io_timeout,
+        (GSourceFunc) gst_rtspsrc_io_timeout, src, NULL);
+    g_source_attach (src->io_timeout, src->io_context);
+  }
+  g_mutex_unlock (&src->io_lock);
+}
+
+/* Stop receiving on the shared I/O thread, when this returns the I/O thread
+ * is not using the connection anymore */
+static void
+gst_rtspsrc_io_detach (GstRTSPSrc * src)
+{
+  g_mutex_lock (&src->io_lock);
+  if (src->io_source) {
+    GST_DEBUG_OBJECT (src, "stop receiving on shared I/O thread");
+    g_source_destroy (src->io_source);
+    g_source_unref (src->io_source);
+    src->io_source = NULL;
+  }
+  if (src->io_timeout) {
+    g_source_destroy (src->io_timeout);
+    g_source_unref (src->io_timeout);
+    src->io_timeout = NULL;
+  }
+  /* a partial data frame can't be continued after other communication */
+  src->io_header_fill = 0;
+  if (src->io_frame) {
+    gst_memory_unref (src->io_frame);
+    src->io_frame = NULL;
+  }
+  g_mutex_unlock (&src->io_lock);
+}
+
 static gboolean
 gst_rtspsrc_loop (GstRTSPSrc * src)
 {
@@ -6362,10 +7028,45 @@ gst_rtspsrc_loop (GstRTSPSrc * src)
   if (!src->conninfo.connection || !src->conninfo.connected)
     goto no_connection;
 
-  if (src->interleaved)
+  if (src->interleaved) {
+    GSocket *socket = gst_rtspsrc_io_get_socket (src);
+    gboolean keep_alive;
+
+    if (socket) {
+      /* the I/O thread only receives data frames, messages from the server
+       * are received here */
+      while (gst_rtspsrc_io_message_pending (socket)) {
+        ret = gst_rtspsrc_receive_message (src);
+        if (ret != GST_FLOW_OK)
+          goto pause;
+      }
+
+      g_mutex_lock (&src->io_lock);
+      keep_alive = src->io_keep_alive;
+      src->io_keep_alive = FALSE;
+      g_mutex_unlock (&src->io_lock);
+      if (keep_alive) {
+        GST_DEBUG_OBJECT (src, "sending keep-alive for the I/O thread");
+        if (gst_rtspsrc_send_keep_alive (src) == GST_RTSP_EINTR) {
+          ret = GST_FLOW_FLUSHING;
+          goto pause;
+        }
+      }
+
+      /* the data is received on the I/O thread now, let the task sleep. This
+       * is done before attaching so that the I/O thread can wake us up again
+       * right away. */
+      GST_OBJECT_LOCK (src);
+      if (src->pending_cmd == CMD_LOOP)
+        src->pending_cmd = CMD_WAIT;
+      GST_OBJECT_UNLOCK (src);
+      gst_rtspsrc_io_attach (src, socket);
+      return TRUE;
+    }
     ret = gst_rtspsrc_loop_interleaved (src);
-  else
+  } else {
     ret = gst_rtspsrc_loop_udp (src);
+  }
 
   if (ret != GST_FLOW_OK)
     goto pause;
@@ -6381,29 +7082,7 @@ no_connection:
   }
 pause:
   {
-    const gchar *reason = gst_flow_get_name (ret);
-
-    GST_DEBUG_OBJECT (src, "pausing task, reason %s", reason);
-    src->running = FALSE;
-    if (ret == GST_FLOW_EOS) {
-      /* perform EOS logic */
-      if (src->segment.flags & GST_SEEK_FLAG_SEGMENT) {
-        gst_element_post_message (GST_ELEMENT_CAST (src),
-            gst_message_new_segment_done (GST_OBJECT_CAST (src),
-                src->segment.format, src->segment.position));
-        gst_rtspsrc_push_event (src,
-            gst_event_new_segment_done (src->segment.format,
-                src->segment.position));
-      } else {
-        gst_rtspsrc_push_event (src, gst_event_new_eos ());
-      }
-    } else if (ret == GST_FLOW_NOT_LINKED || ret < GST_FLOW_EOS) {
-      /* for fatal errors we post an error message, post the error before the
-       * EOS so the app knows about the error first. */
-      GST_ELEMENT_FLOW_ERROR (src, ret);
-      gst_rtspsrc_push_event (src, gst_event_new_eos ());
-    }
-    gst_rtspsrc_loop_send_cmd (src, CMD_WAIT, CMD_LOOP);
+    gst_rtspsrc_loop_pause (src, ret);
     return FALSE;
   }
 }
@@ -7439,13 +8118,13 @@ gst_rtspsrc_setup_streams_end (GstRTSPSrc * src, gboolean async)
 {
   GList *tmp;
   GstRTSPConnInfo *conninfo;
-
-  g_assert (src->version >= GST_RTSP_VERSION_2_0);
+  GstRTSPResult res = GST_RTSP_OK;
 
   conninfo = &src->conninfo;
   for (tmp = src->streams; tmp; tmp = tmp->next) {
     GstRTSPStream *stream = (GstRTSPStream *) tmp->data;
     GstRTSPMessage response = { 0, };
+    GstRTSPStatusCode code = GST_RTSP_STS_OK;
 
     if (!stream->waiting_setup_response)
       continue;
@@ -7453,13 +8132,34 @@ gst_rtspsrc_setup_streams_end (GstRTSPSrc * src, gboolean async)
     if (!src->conninfo.connection)
       conninfo = &((GstRTSPStream *) tmp->data)->conninfo;
 
-    gst_rtsp_src_receive_response (src, conninfo, &response, NULL);
+    if (gst_rtsp_src_receive_response (src, conninfo, &response, &code) < 0) {
+      stream->waiting_setup_response = FALSE;
+      res = GST_RTSP_ERROR;
+      break;
+    }
+
+    /* keep reading the responses after an error response so that none of
+     * them is left on the connection */
+
+    if (code != GST_RTSP_STS_OK) {
+      const gchar *str = gst_rtsp_status_as_text (code);
+
+      stream->waiting_setup_response = FALSE;
+      gst_rtspsrc_stream_free_udp (stream);
+      gst_rtsp_message_unset (&response);
+      if (res == GST_RTSP_OK)
+        GST_ELEMENT_ERROR (src, RESOURCE, WRITE, (NULL),
+            ("Error (%d): %s", code, GST_STR_NULL (str)));
+      res = GST_RTSP_ERROR;
+      continue;
+    }
 
-    gst_rtsp_src_setup_stream_from_response (src, stream,
-        &response, NULL, 0, NULL, NULL);
+    if (gst_rtsp_src_setup_stream_from_response (src, stream,
+            &response, NULL, 0, NULL, NULL) < 0)
+      res = GST_RTSP_ERROR;
   }
 
-  return GST_RTSP_OK;
+  return res;
 }
 
 /* Perform the SETUP request for all the streams.
@@ -7476,6 +8176,11 @@ gst_rtspsrc_setup_streams_end (GstRTSPSrc * src, gboolean async)
  * Otherwise, the first stream is setup right away from the reply and a
  * CMD_FINALIZE_SETUP command is set for the stream pipelines to happen on the
  * remaining streams from the RTSP thread.
+ *
+ * With RTSP 1.0 and the pipelined-setup property, the first request is
+ * always handled synchronously so that the session and the transport are
+ * known, the requests for the other streams are then sent without waiting
+ * and their responses are handled at the end.
  */
 static GstRTSPResult
 gst_rtspsrc_setup_streams_start (GstRTSPSrc * src, gboolean async)
@@ -7492,6 +8197,7 @@ gst_rtspsrc_setup_streams_start (GstRTSPSrc * src, gboolean async)
   GstRTSPUrl *url;
   gchar *hval;
   gchar *pipelined_request_id = NULL;
+  gboolean pipelined = FALSE;
 
   if (src->conninfo.connection) {
     url = gst_rtsp_connection_get_url (src->conninfo.connection);
@@ -7528,6 +8234,7 @@ gst_rtspsrc_setup_streams_start (GstRTSPSrc * src, gboolean async)
     gboolean tried_non_compliant_url = FALSE;
     guint mask = 0;
     gboolean selected;
+    gboolean pipeline;
     GstCaps *caps;
 
     stream = (GstRTSPStream *) walk->data;
@@ -7681,10 +8388,17 @@ gst_rtspsrc_setup_streams_start (GstRTSPSrc * src, gboolean async)
       GST_ELEMENT_PROGRESS (src, CONTINUE, "request", ("SETUP stream %d",
               stream->id));
 
+    /* with RTSP 1.0 we can only pipeline once a previous stream was set up
+     * on the aggregate connection, that is, when the session exists */
+    pipeline = pipelined_request_id != NULL || (src->pipelined_setup
+        && src->need_activate && conninfo == &src->conninfo);
+    if (pipeline && !pipelined_request_id)
+      GST_DEBUG_OBJECT (src, "pipelining SETUP of stream %p", stream);
+
     /* handle the code ourselves */
     res =
         gst_rtspsrc_send (src, conninfo, &request,
-        pipelined_request_id ? NULL : &response, &code, NULL);
+        pipeline ? NULL : &response, &code, NULL);
     if (res < 0)
       goto send_error;
 
@@ -7767,7 +8481,7 @@ gst_rtspsrc_setup_streams_start (GstRTSPSrc * src, gboolean async)
     }
 
 
-    if (!pipelined_request_id) {
+    if (!pipeline) {
       /* parse response transport */
       res = gst_rtsp_src_setup_stream_from_response (src, stream,
           &response, &protocols, retry, &rtpport, &rtcpport);
@@ -7783,6 +8497,7 @@ gst_rtspsrc_setup_streams_start (GstRTSPSrc * src, gboolean async)
       stream->waiting_setup_response = TRUE;
       /* we need to activate at least one stream when we detect activity */
       src->need_activate = TRUE;
+      pipelined = TRUE;
     }
 
     {
@@ -7808,8 +8523,9 @@ gst_rtspsrc_setup_streams_start (GstRTSPSrc * src, gboolean async)
     gst_rtsp_message_unset (&request);
   }
 
-  if (pipelined_request_id) {
-    gst_rtspsrc_setup_streams_end (src, TRUE);
+  if (pipelined) {
+    if ((res = gst_rtspsrc_setup_streams_end (src, TRUE)) < 0)
+      goto cleanup_error;
   }
 
   /* store the transport protocol that was configured */
@@ -9356,6 +10072,9 @@ gst_rtspsrc_thread (GstRTSPSrc * src)
   src->busy_cmd = cmd;
   GST_OBJECT_UNLOCK (src);
 
+  /* and take the connection back from the I/O thread */
+  gst_rtspsrc_io_detach (src);
+
   switch (cmd) {
     case CMD_OPEN:
       gst_rtspsrc_open (src, TRUE);
@@ -9388,10 +10107,15 @@ gst_rtspsrc_thread (GstRTSPSrc * src)
   GST_OBJECT_LOCK (src);
   /* No more cmds, wake any waiters */
   g_cond_broadcast (&src->cmd_cond);
-  /* and go back to sleep */
+  /* and go back to sleep, when the I/O thread receives for us the task
+   * is stopped so that the thread can be reused */
   if (src->pending_cmd == CMD_WAIT) {
-    if (src->task)
-      gst_task_pause (src->task);
+    if (src->task) {
+      if (src->io_source)
+        gst_task_stop (src->task);
+      else
+        gst_task_pause (src->task);
+    }
   }
   /* reset waiting */
   src->busy_cmd = CMD_WAIT;
@@ -9458,6 +10182,12 @@ gst_rtspsrc_stop (GstRTSPSrc * src)
   }
   GST_OBJECT_UNLOCK (src);
 
+  gst_rtspsrc_io_detach (src);
+  if (src->io_context) {
+    gst_rtspsrc_io_context_release (src->io_context);
+    src->io_context = NULL;
+  }
+
   /* ensure synchronously all is closed and clean */
   gst_rtspsrc_close (src, FALSE, TRUE);
 
@@ -280,6 +280,9 @@ struct _GstRTSPSrc {
   gboolean          onvif_rate_control;
   gboolean          is_live;
   gboolean          ignore_x_server_reply;
+  guint             interleaved_read_size;
+  guint             shared_io_threads;
+  gboolean          pipelined_setup;
 
   /* state */
   GstRTSPState       state;
@@ -329,6 +332,20 @@ struct _GstRTSPSrc {
 
   guint group_id;
   GMutex group_lock;
+
+  /* shared I/O mode, protected by io_lock */
+  GMutex            io_lock;
+  GMainContext     *io_context;
+  GSource          *io_source;
+  GSource          *io_timeout;
+  gint64            io_last_activity;
+  /* the task has to send a keep-alive before attaching again */
+  gboolean          io_keep_alive;
+  /* data frame that is partially received */
+  guint8            io_header[4];
+  guint             io_header_fill;
+  GstMemory        *io_frame;
+  gsize             io_frame_fill;
 };
 
 struct _GstRTSPSrcClass {
@@ -0,0 +1,146 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* A process-wide set of I/O threads, each running a #GMainContext, that
+ * rtspsrc instances share to wait for their connections instead of keeping
+ * a thread of their own blocked in a receive call. The threads are started
+ * when the first instance needs them and stopped again when the last one
+ * releases its context. */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gstrtspsrcio.h"
+
+GST_DEBUG_CATEGORY_STATIC (rtspsrc_io_debug);
+#define GST_CAT_DEFAULT (rtspsrc_io_debug)
+
+typedef struct
+{
+  GMainContext *context;
+  GMainLoop *loop;
+  GThread *thread;
+  guint users;
+} GstRTSPSrcIOThread;
+
+static GMutex io_lock;
+static GPtrArray *io_threads;
+static guint io_users;
+
+static gpointer
+gst_rtspsrc_io_thread_func (gpointer data)
+{
+  GstRTSPSrcIOThread *thread = data;
+
+  g_main_context_push_thread_default (thread->context);
+  g_main_loop_run (thread->loop);
+  g_main_context_pop_thread_default (thread->context);
+
+  return NULL;
+}
+
+static void
+gst_rtspsrc_io_thread_free (GstRTSPSrcIOThread * thread)
+{
+  g_main_loop_quit (thread->loop);
+  g_thread_join (thread->thread);
+  g_main_loop_unref (thread->loop);
+  g_main_context_unref (thread->context);
+  g_free (thread);
+}
+
+/* Get a ref to the context of the least used of the first @n_threads I/O
+ * threads, starting threads as needed. */
+GMainContext *
+gst_rtspsrc_io_context_acquire (guint n_threads)
+{
+  GstRTSPSrcIOThread *best = NULL;
+  guint i;
+
+  g_return_val_if_fail (n_threads > 0, NULL);
+
+  g_mutex_lock (&io_lock);
+  if (io_threads == NULL) {
+    GST_DEBUG_CATEGORY_INIT (rtspsrc_io_debug, "rtspsrcio", 0,
+        "rtspsrc shared I/O");
+    io_threads = g_ptr_array_new ();
+  }
+
+  while (io_threads->len < n_threads) {
+    GstRTSPSrcIOThread *thread = g_new0 (GstRTSPSrcIOThread, 1);
+    gchar *name = g_strdup_printf ("rtspsrc-io-%u", io_threads->len);
+
+    thread->context = g_main_context_new ();
+    thread->loop = g_main_loop_new (thread->context, FALSE);
+    thread->thread = g_thread_new (name, gst_rtspsrc_io_thread_func, thread);
+    g_free (name);
+
+    GST_DEBUG ("started I/O thread %u", io_threads->len);
+    g_ptr_array_add (io_threads, thread);
+  }
+
+  for (i = 0; i < n_threads; i++) {
+    GstRTSPSrcIOThread *thread = g_ptr_array_index (io_threads, i);
+
+    if (best == NULL || thread->users < best->users)
+      best = thread;
+  }
+  best->users++;
+  io_users++;
+  g_mutex_unlock (&io_lock);
+
+  return g_main_context_ref (best->context);
+}
+
+/* Release a context from gst_rtspsrc_io_context_acquire(), the sources
+ * attached to it must have been destroyed. The I/O threads are stopped
+ * when the last context is released. */
+void
+gst_rtspsrc_io_context_release (GMainContext * context)
+{
+  GPtrArray *stopped = NULL;
+  guint i;
+
+  g_return_if_fail (context != NULL);
+
+  g_mutex_lock (&io_lock);
+  for (i = 0; i < io_threads->len; i++) {
+    GstRTSPSrcIOThread *thread = g_ptr_array_index (io_threads, i);
+
+    if (thread->context == context) {
+      thread->users--;
+      break;
+    }
+  }
+  g_main_context_unref (context);
+
+  if (--io_users == 0) {
+    GST_DEBUG ("stopping %u I/O threads", io_threads->len);
+    stopped = io_threads;
+    io_threads = g_ptr_array_new ();
+  }
+  g_mutex_unlock (&io_lock);
+
+  /* join the threads without the lock, new threads can be started in the
+   * meantime */
+  if (stopped) {
+    g_ptr_array_foreach (stopped, (GFunc) gst_rtspsrc_io_thread_free, NULL);
+    g_ptr_array_unref (stopped);
+  }
+}
@@ -0,0 +1,31 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_RTSPSRC_IO_H__
+#define __GST_RTSPSRC_IO_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+GMainContext *  gst_rtspsrc_io_context_acquire  (guint n_threads);
+void            gst_rtspsrc_io_context_release  (GMainContext *context);
+
+G_END_DECLS
+
+#endif /* __GST_RTSPSRC_IO_H__ */
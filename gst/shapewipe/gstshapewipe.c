@@ -94,11 +94,13 @@ enum
 {
   PROP_0,
   PROP_POSITION,
-  PROP_BORDER
+  PROP_BORDER,
+  PROP_N_THREADS
 };
 
 #define DEFAULT_POSITION 0.0
 #define DEFAULT_BORDER 0.0
+#define DEFAULT_N_THREADS 1
 
 static GstStaticPadTemplate video_sink_pad_template =
 GST_STATIC_PAD_TEMPLATE ("video_sink",
@@ -149,6 +151,19 @@ gst_shape_wipe_class_init (GstShapeWipeClass * klass)
       g_param_spec_float ("border", "Border", "Border of the mask",
           0.0, 1.0, DEFAULT_BORDER,
           G_PARAM_STATIC_STRINGS | G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE));
+  /**
+   * GstShapeWipe:n-threads:
+   *
+   * Maximum number of threads used to blend each frame, in bands of rows.
+   * 0 uses one thread per CPU.
+   *
+   * Since: 1.24
+   */
+  g_object_class_install_property (gobject_class, PROP_N_THREADS,
+      g_param_spec_uint ("n-threads", "Threads",
+          "Maximum number of threads to use (0 = number of CPUs)", 0,
+          G_MAXINT, DEFAULT_N_THREADS,
+          G_PARAM_STATIC_STRINGS | G_PARAM_READWRITE));
 
   gstelement_class->change_state =
       GST_DEBUG_FUNCPTR (gst_shape_wipe_change_state);
@@ -200,6 +215,9 @@ gst_shape_wipe_init (GstShapeWipe * self)
   g_mutex_init (&self->mask_mutex);
   g_cond_init (&self->mask_cond);
 
+  self->n_threads = DEFAULT_N_THREADS;
+  gst_video_bands_init (&self->bands);
+
   gst_shape_wipe_reset (self);
 }
 
@@ -216,6 +234,9 @@ gst_shape_wipe_get_property (GObject * object, guint prop_id,
     case PROP_BORDER:
       g_value_set_float (value, self->mask_border);
       break;
+    case PROP_N_THREADS:
+      g_value_set_uint (value, self->n_threads);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -243,6 +264,9 @@ gst_shape_wipe_set_property (GObject * object, guint prop_id,
       self->mask_border = f;
       break;
     }
+    case PROP_N_THREADS:
+      self->n_threads = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -259,6 +283,8 @@ gst_shape_wipe_finalize (GObject * object)
   g_cond_clear (&self->mask_cond);
   g_mutex_clear (&self->mask_mutex);
 
+  gst_video_bands_clear (&self->bands);
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -279,6 +305,10 @@ gst_shape_wipe_reset (GstShapeWipe * self)
   gst_video_info_init (&self->minfo);
   self->mask_bpp = 0;
 
+  g_free (self->lut);
+  self->lut = NULL;
+  self->lut_bpp = 0;
+
   gst_segment_init (&self->segment, GST_FORMAT_TIME);
 
   gst_shape_wipe_reset_qos (self);
@@ -760,77 +790,102 @@ gst_shape_wipe_do_qos (GstShapeWipe * self, GstClockTime timestamp)
   return TRUE;
 }
 
-#define CREATE_ARGB_FUNCTIONS(depth, name, shift, a, r, g, b) \
-static void \
-gst_shape_wipe_blend_##name##_##depth (GstShapeWipe * self, GstVideoFrame * inframe, \
-    GstVideoFrame * maskframe, GstVideoFrame * outframe) \
-{ \
-  const guint##depth *mask = (const guint##depth *) GST_VIDEO_FRAME_PLANE_DATA (maskframe, 0); \
-  const guint8 *input = (const guint8 *) GST_VIDEO_FRAME_PLANE_DATA (inframe, 0); \
-  guint8 *output = (guint8 *) GST_VIDEO_FRAME_PLANE_DATA (outframe, 0); \
-  guint i, j; \
-  gint width = GST_VIDEO_FRAME_WIDTH (inframe); \
-  gint height = GST_VIDEO_FRAME_HEIGHT (inframe); \
-  guint mask_increment = ((depth == 16) ? GST_ROUND_UP_2 (width) : \
-                           GST_ROUND_UP_4 (width)) - width; \
-  gfloat position = self->mask_position; \
-  gfloat low = position - (self->mask_border / 2.0f); \
-  gfloat high = position + (self->mask_border / 2.0f); \
-  guint32 low_i, high_i, round_i; \
-  \
-  if (low < 0.0f) { \
-    high = 0.0f; \
-    low = 0.0f; \
-  } \
-  \
-  if (high > 1.0f) { \
-    low = 1.0f; \
-    high = 1.0f; \
-  } \
-  \
-  low_i = low * 65536; \
-  high_i = high * 65536; \
-  round_i = (high_i - low_i) >> 1; \
-  \
-  for (i = 0; i < height; i++) { \
-    for (j = 0; j < width; j++) { \
-      guint32 in = *mask << shift; \
-      \
-      if (in < low_i) { \
-        output[a] = 0x00;       /* A */ \
-        output[r] = input[r];   /* R */ \
-        output[g] = input[g];   /* G */ \
-        output[b] = input[b];   /* B */ \
-      } else if (in >= high_i) { \
-        output[a] = input[a];   /* A */ \
-        output[r] = input[r];   /* R */ \
-        output[g] = input[g];   /* G */ \
-        output[b] = input[b];   /* B */ \
-      } else { \
-        guint32 val; \
-        /* Note: This will never overflow or be larger than 255! */ \
-        val = (((in - low_i) << 16) + round_i) / (high_i - low_i); \
-        val = (val * input[a] + 32768) >> 16; \
-        \
-        output[a] = val;        /* A */ \
-        output[r] = input[r];   /* R */ \
-        output[g] = input[g];   /* G */ \
-        output[b] = input[b];   /* B */ \
-      } \
-      \
-      mask++; \
-      input += 4; \
-      output += 4; \
-    } \
-    mask += mask_increment; \
-  } \
+/* The alpha of a pixel only depends on its mask value and on the position
+ * and border, so the scale of every mask value is only computed again when
+ * those change instead of with a division per pixel */
+static void
+gst_shape_wipe_update_lut (GstShapeWipe * self, gfloat position,
+    gfloat border)
+{
+  gint bpp = self->mask_bpp;
+  guint32 shift = (bpp == 16) ? 0 : 8;
+  guint32 n_values = 1 << bpp;
+  gfloat low = position - (border / 2.0f);
+  gfloat high = position + (border / 2.0f);
+  guint32 low_i, high_i, round_i, v;
+
+  if (self->lut && self->lut_bpp == bpp && self->lut_position == position &&
+      self->lut_border == border)
+    return;
+
+  if (!self->lut || self->lut_bpp != bpp)
+    self->lut = g_renew (guint32, self->lut, n_values);
+
+  self->lut_bpp = bpp;
+  self->lut_position = position;
+  self->lut_border = border;
+
+  if (low < 0.0f) {
+    high = 0.0f;
+    low = 0.0f;
+  }
+
+  if (high > 1.0f) {
+    low = 1.0f;
+    high = 1.0f;
+  }
+
+  low_i = low * 65536;
+  high_i = high * 65536;
+  round_i = (high_i - low_i) >> 1;
+
+  for (v = 0; v < n_values; v++) {
+    guint32 in = v << shift;
+
+    if (in < low_i) {
+      self->lut[v] = 0;
+    } else if (in >= high_i) {
+      /* keeps the alpha of the input unchanged */
+      self->lut[v] = 65536;
+    } else {
+      /* Note: This will never overflow or be larger than 65535! */
+      self->lut[v] = (((in - low_i) << 16) + round_i) / (high_i - low_i);
+    }
+  }
 }
 
-CREATE_ARGB_FUNCTIONS (16, argb, 0, 0, 1, 2, 3);
-CREATE_ARGB_FUNCTIONS (8, argb, 8, 0, 1, 2, 3);
+typedef struct
+{
+  GstShapeWipe *self;
+  GstVideoFrame *inframe, *maskframe, *outframe;
+  /* offset of the alpha component */
+  gint a;
+} GstShapeWipeJob;
 
-CREATE_ARGB_FUNCTIONS (16, bgra, 0, 3, 2, 1, 0);
-CREATE_ARGB_FUNCTIONS (8, bgra, 8, 3, 2, 1, 0);
+static void
+gst_shape_wipe_blend_rows (GstShapeWipeJob * job, gint y, gint height)
+{
+  const guint32 *lut = job->self->lut;
+  gint bpp = job->self->lut_bpp;
+  gint width = GST_VIDEO_FRAME_WIDTH (job->inframe);
+  gint a = job->a;
+  gint i, j;
+
+  for (i = y; i < y + height; i++) {
+    const guint8 *mask = (const guint8 *)
+        GST_VIDEO_FRAME_PLANE_DATA (job->maskframe, 0) +
+        i * GST_VIDEO_FRAME_PLANE_STRIDE (job->maskframe, 0);
+    const guint8 *input = (const guint8 *)
+        GST_VIDEO_FRAME_PLANE_DATA (job->inframe, 0) +
+        i * GST_VIDEO_FRAME_PLANE_STRIDE (job->inframe, 0);
+    guint8 *output = (guint8 *) GST_VIDEO_FRAME_PLANE_DATA (job->outframe, 0) +
+        i * GST_VIDEO_FRAME_PLANE_STRIDE (job->outframe, 0);
+
+    /* only the alpha changes, nothing to copy when blending inplace */
+    if (output != input)
+      memcpy (output, input, 4 * width);
+
+    if (bpp == 16) {
+      const guint16 *mask16 = (const guint16 *) mask;
+
+      for (j = 0; j < width; j++)
+        output[4 * j + a] = (lut[mask16[j]] * input[4 * j + a] + 32768) >> 16;
+    } else {
+      for (j = 0; j < width; j++)
+        output[4 * j + a] = (lut[mask[j]] * input[4 * j + a] + 32768) >> 16;
+    }
+  }
+}
 
 static GstFlowReturn
 gst_shape_wipe_video_sink_chain (GstPad * pad, GstObject * parent,
@@ -841,6 +896,7 @@ gst_shape_wipe_video_sink_chain (GstPad * pad, GstObject * parent,
   GstBuffer *mask = NULL, *outbuf = NULL;
   GstClockTime timestamp;
   GstVideoFrame inframe, outframe, maskframe;
+  GstShapeWipeJob job;
 
   if (G_UNLIKELY (GST_VIDEO_INFO_FORMAT (&self->vinfo) ==
           GST_VIDEO_FORMAT_UNKNOWN))
@@ -881,27 +937,32 @@ gst_shape_wipe_video_sink_chain (GstPad * pad, GstObject * parent,
 
   gst_video_frame_map (&maskframe, &self->minfo, mask, GST_MAP_READ);
 
+  gst_shape_wipe_update_lut (self, self->mask_position, self->mask_border);
+
+  job.self = self;
+  job.inframe = &inframe;
+  job.maskframe = &maskframe;
+  job.outframe = &outframe;
+
   switch (GST_VIDEO_INFO_FORMAT (&self->vinfo)) {
     case GST_VIDEO_FORMAT_AYUV:
     case GST_VIDEO_FORMAT_ARGB:
     case GST_VIDEO_FORMAT_ABGR:
-      if (self->mask_bpp == 16)
-        gst_shape_wipe_blend_argb_16 (self, &inframe, &maskframe, &outframe);
-      else
-        gst_shape_wipe_blend_argb_8 (self, &inframe, &maskframe, &outframe);
+      job.a = 0;
       break;
     case GST_VIDEO_FORMAT_BGRA:
     case GST_VIDEO_FORMAT_RGBA:
-      if (self->mask_bpp == 16)
-        gst_shape_wipe_blend_bgra_16 (self, &inframe, &maskframe, &outframe);
-      else
-        gst_shape_wipe_blend_bgra_8 (self, &inframe, &maskframe, &outframe);
+      job.a = 3;
       break;
     default:
       g_assert_not_reached ();
       break;
   }
 
+  gst_video_bands_process_rows (&self->bands, self->n_threads,
+      GST_VIDEO_FRAME_HEIGHT (&inframe), 1,
+      (GstVideoBandsRowsFunc) gst_shape_wipe_blend_rows, &job);
+
   gst_video_frame_unmap (&outframe);
   gst_video_frame_unmap (&inframe);
 
@@ -22,6 +22,7 @@
 
 #include <gst/gst.h>
 #include <gst/video/video.h>
+#include <gst/video-bands-private.h>
 
 G_BEGIN_DECLS
 
@@ -59,6 +60,16 @@ struct _GstShapeWipe
   GCond mask_cond;
   gint mask_bpp;
 
+  /* alpha scale of each mask value, in 1/65536, for the position, border
+   * and depth it was computed for */
+  guint32 *lut;
+  gfloat lut_position;
+  gfloat lut_border;
+  gint lut_bpp;
+
+  guint n_threads;
+  GstVideoBands bands;
+
   GstVideoInfo vinfo;
   GstVideoInfo minfo;
 
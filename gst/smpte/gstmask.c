@@ -21,11 +21,19 @@
 #include "config.h"
 #endif
 
+#include <string.h>
+
 #include "gstmask.h"
 #include "paint.h"
 
 static GList *masks = NULL;
 
+/* Drawn masks only depend on their parameters and are never modified, so they
+ * are shared by all elements while they are in use. A mask is freed as soon as
+ * the last element using it releases it, so nothing outlives the elements. */
+static GMutex cache_lock;
+static GList *cache = NULL;
+
 void
 _gst_mask_init (void)
 {
@@ -68,6 +76,24 @@ gst_mask_find_definition (gint type)
   return NULL;
 }
 
+static GstMask *
+gst_mask_cache_lookup (gint type, gboolean invert, gint bpp, gint width,
+    gint height)
+{
+  GList *walk;
+
+  for (walk = cache; walk; walk = g_list_next (walk)) {
+    GstMask *mask = (GstMask *) walk->data;
+
+    if (mask->type == type && mask->invert == invert && mask->bpp == bpp &&
+        mask->width == width && mask->height == height) {
+      mask->refcount++;
+      return mask;
+    }
+  }
+  return NULL;
+}
+
 GstMask *
 gst_mask_factory_new (gint type, gboolean invert, gint bpp, gint width,
     gint height)
@@ -75,6 +101,15 @@ gst_mask_factory_new (gint type, gboolean invert, gint bpp, gint width,
   GstMaskDefinition *definition;
   GstMask *mask = NULL;
 
+  g_mutex_lock (&cache_lock);
+  mask = gst_mask_cache_lookup (type, invert, bpp, width, height);
+  g_mutex_unlock (&cache_lock);
+
+  if (mask) {
+    GST_DEBUG ("reusing mask %d of %dx%d", type, width, height);
+    return mask;
+  }
+
   definition = gst_mask_find_definition (type);
   if (definition) {
     mask = g_new0 (GstMask, 1);
@@ -85,6 +120,8 @@ gst_mask_factory_new (gint type, gboolean invert, gint bpp, gint width,
     mask->height = height;
     mask->destroy_func = definition->destroy_func;
     mask->user_data = definition->user_data;
+    mask->invert = invert;
+    mask->refcount = 1;
 
     if (((guint64) width * (guint64) height * sizeof (guint32)) > G_MAXUINT) {
       GST_WARNING ("width x height overflows");
@@ -108,6 +145,12 @@ gst_mask_factory_new (gint type, gboolean invert, gint bpp, gint width,
         }
       }
     }
+
+    /* drawing happens unlocked, so another element might have added the same
+     * mask in the meantime, which is harmless */
+    g_mutex_lock (&cache_lock);
+    cache = g_list_prepend (cache, mask);
+    g_mutex_unlock (&cache_lock);
   }
 
   return mask;
@@ -123,6 +166,101 @@ _gst_mask_default_destroy (GstMask * mask)
 void
 gst_mask_destroy (GstMask * mask)
 {
+  g_mutex_lock (&cache_lock);
+  if (--mask->refcount > 0) {
+    g_mutex_unlock (&cache_lock);
+    return;
+  }
+  cache = g_list_remove (cache, mask);
+  g_mutex_unlock (&cache_lock);
+
   if (mask->destroy_func)
     mask->destroy_func (mask);
 }
+
+/* Mask values up to this depth are looked up in a table, deeper masks have
+ * their weights computed for each pixel */
+#define WEIGHTS_TABLE_MAX_BPP 16
+
+void
+gst_mask_weights_init (GstMaskWeights * weights)
+{
+  memset (weights, 0, sizeof (GstMaskWeights));
+}
+
+void
+gst_mask_weights_clear (GstMaskWeights * weights)
+{
+  g_free (weights->table);
+  gst_mask_weights_init (weights);
+}
+
+static inline guint32
+gst_mask_weight (const GstMaskWeights * weights, guint32 value)
+{
+  gint64 t = CLAMP ((gint64) value, weights->min, weights->pos) - weights->min;
+
+  return (t << 16) / weights->border;
+}
+
+/* Makes @weights describe the transition at @pos, with a @border wide ramp,
+ * for masks of depth @bpp. The table is only rebuilt when these change. */
+void
+gst_mask_weights_update (GstMaskWeights * weights, gint bpp, gint border,
+    gint pos)
+{
+  guint32 v, n_values, ramp_start, ramp_end;
+
+  if (border == 0)
+    border++;
+
+  if (weights->valid && weights->bpp == bpp && weights->border == border &&
+      weights->pos == pos)
+    return;
+
+  if (bpp > WEIGHTS_TABLE_MAX_BPP) {
+    g_free (weights->table);
+    weights->table = NULL;
+  } else if (!weights->table || weights->bpp != bpp) {
+    weights->table = g_renew (guint32, weights->table, (1 << bpp) + 1);
+  }
+
+  weights->bpp = bpp;
+  weights->border = border;
+  weights->pos = pos;
+  weights->min = (gint64) pos - border;
+  weights->valid = TRUE;
+
+  if (!weights->table)
+    return;
+
+  /* only the ramp needs a division per entry */
+  n_values = (1 << bpp) + 1;
+  ramp_start = CLAMP (weights->min, 0, n_values);
+  ramp_end = CLAMP ((gint64) pos, ramp_start, n_values);
+
+  for (v = 0; v < ramp_start; v++)
+    weights->table[v] = 0;
+  for (; v < ramp_end; v++)
+    weights->table[v] = gst_mask_weight (weights, v);
+  for (; v < n_values; v++)
+    weights->table[v] = 65536;
+}
+
+/* Looks up the weights of @n mask values */
+void
+gst_mask_weights_get (const GstMaskWeights * weights, const guint32 * mask,
+    guint32 * dest, gint n)
+{
+  gint i;
+
+  if (weights->table) {
+    guint32 last = 1 << weights->bpp;
+
+    for (i = 0; i < n; i++)
+      dest[i] = weights->table[MIN (mask[i], last)];
+  } else {
+    for (i = 0; i < n; i++)
+      dest[i] = gst_mask_weight (weights, mask[i]);
+  }
+}
@@ -48,8 +48,31 @@ struct _GstMask {
   gint                   bpp;
 
   GstMaskDestroyFunc     destroy_func;
+
+  /*< private >*/
+  gboolean               invert;
+  gint                   refcount;
+};
+
+/* Weight of the first input of a transition at each mask value, from 0 to
+ * 65536: 0 up to pos - border, 65536 from pos on and a linear ramp in
+ * between. */
+typedef struct _GstMaskWeights GstMaskWeights;
+
+struct _GstMaskWeights {
+  gint                   bpp;
+  gint                   border;
+  gint                   pos;
+  gint64                 min;
+
+  /* one entry per mask value, NULL if bpp is too large for a table */
+  guint32               *table;
+  gboolean               valid;
 };
 
+/* Number of pixels the blend functions process per block */
+#define GST_MASK_BLOCK 64
+
 void                    _gst_mask_init                  (void);
 void                    _gst_mask_register              (const GstMaskDefinition *definition);
 
@@ -59,6 +82,11 @@ const GList*            gst_mask_get_definitions        (void);
 GstMask*                gst_mask_factory_new            (gint type, gboolean invert, gint bpp, gint width, gint height);
 void                    gst_mask_destroy                (GstMask *mask);
 
+void                    gst_mask_weights_init           (GstMaskWeights *weights);
+void                    gst_mask_weights_clear          (GstMaskWeights *weights);
+void                    gst_mask_weights_update         (GstMaskWeights *weights, gint bpp, gint border, gint pos);
+void                    gst_mask_weights_get            (const GstMaskWeights *weights, const guint32 *mask, guint32 *dest, gint n);
+
 void _gst_barboxwipes_register (void);
 
 #endif /* __GST_MASK_H__ */
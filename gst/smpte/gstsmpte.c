@@ -86,6 +86,7 @@ enum
 #define DEFAULT_PROP_DEPTH	16
 #define DEFAULT_PROP_DURATION	GST_SECOND
 #define DEFAULT_PROP_INVERT   FALSE
+#define DEFAULT_PROP_N_THREADS 1
 
 enum
 {
@@ -94,7 +95,8 @@ enum
   PROP_BORDER,
   PROP_DEPTH,
   PROP_DURATION,
-  PROP_INVERT
+  PROP_INVERT,
+  PROP_N_THREADS
 };
 
 #define GST_TYPE_SMPTE_TRANSITION_TYPE (gst_smpte_transition_type_get_type())
@@ -189,6 +191,19 @@ gst_smpte_class_init (GstSMPTEClass * klass)
       g_param_spec_boolean ("invert", "Invert",
           "Invert transition mask", DEFAULT_PROP_INVERT,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  /**
+   * GstSMPTE:n-threads:
+   *
+   * Maximum number of threads used to blend each frame, in bands of rows.
+   * 0 uses one thread per CPU.
+   *
+   * Since: 1.24
+   */
+  g_object_class_install_property (G_OBJECT_CLASS (klass), PROP_N_THREADS,
+      g_param_spec_uint ("n-threads", "Threads",
+          "Maximum number of threads to use (0 = number of CPUs)", 0,
+          G_MAXINT, DEFAULT_PROP_N_THREADS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
   gstelement_class->change_state = GST_DEBUG_FUNCPTR (gst_smpte_change_state);
 
@@ -358,8 +373,12 @@ gst_smpte_init (GstSMPTE * smpte)
   smpte->depth = DEFAULT_PROP_DEPTH;
   smpte->duration = DEFAULT_PROP_DURATION;
   smpte->invert = DEFAULT_PROP_INVERT;
+  smpte->n_threads = DEFAULT_PROP_N_THREADS;
   smpte->fps_num = 0;
   smpte->fps_denom = 1;
+
+  gst_mask_weights_init (&smpte->weights);
+  gst_video_bands_init (&smpte->bands);
 }
 
 static void
@@ -371,6 +390,8 @@ gst_smpte_finalize (GstSMPTE * smpte)
   if (smpte->mask) {
     gst_mask_destroy (smpte->mask);
   }
+  gst_mask_weights_clear (&smpte->weights);
+  gst_video_bands_clear (&smpte->bands);
 
   G_OBJECT_CLASS (parent_class)->finalize ((GObject *) smpte);
 }
@@ -385,64 +406,89 @@ gst_smpte_reset (GstSMPTE * smpte)
   smpte->send_stream_start = TRUE;
 }
 
+#define COMP_ROW(frame, c, row) \
+    ((guint8 *) GST_VIDEO_FRAME_COMP_DATA (frame, c) + \
+    (row) * GST_VIDEO_FRAME_COMP_STRIDE (frame, c))
+
+typedef struct
+{
+  GstVideoFrame *frame1, *frame2, *oframe;
+  const GstMask *mask;
+  const GstMaskWeights *weights;
+} GstSMPTEJob;
+
+/* Blends @n pixels. The result goes through a local buffer and, for full
+ * blocks, @n is a constant after inlining, so that the compiler can vectorize
+ * the loop without aliasing checks. */
+static inline void
+gst_smpte_blend_pixels (guint8 * out, const guint8 * in1, const guint8 * in2,
+    const guint32 * weights, gint n)
+{
+  guint8 tmp[GST_MASK_BLOCK];
+  gint j;
+
+  for (j = 0; j < n; j++) {
+    guint32 value = weights[j] >> 8;
+
+    tmp[j] = ((in1[j] * value) + (in2[j] * (256 - value))) >> 8;
+  }
+  memcpy (out, tmp, n);
+}
+
+static inline void
+gst_smpte_blend_block (guint8 * out, const guint8 * in1, const guint8 * in2,
+    const guint32 * weights, gint n)
+{
+  /* full blocks of luma and chroma */
+  if (n == GST_MASK_BLOCK)
+    gst_smpte_blend_pixels (out, in1, in2, weights, GST_MASK_BLOCK);
+  else if (n == GST_MASK_BLOCK / 2)
+    gst_smpte_blend_pixels (out, in1, in2, weights, GST_MASK_BLOCK / 2);
+  else
+    gst_smpte_blend_pixels (out, in1, in2, weights, n);
+}
+
 static void
-gst_smpte_blend_i420 (GstVideoFrame * frame1, GstVideoFrame * frame2,
-    GstVideoFrame * oframe, GstMask * mask, gint border, gint pos)
+gst_smpte_blend_i420 (GstSMPTEJob * job, gint y, gint height)
 {
-  guint32 *maskp;
-  gint value;
-  gint i, j;
-  gint min, max;
-  guint8 *in1, *in2, *out, *in1u, *in1v, *in2u, *in2v, *outu, *outv;
-  gint width, height;
-
-  if (border == 0)
-    border++;
-
-  min = pos - border;
-  max = pos;
-
-  width = GST_VIDEO_FRAME_WIDTH (frame1);
-  height = GST_VIDEO_FRAME_HEIGHT (frame1);
-
-  in1 = GST_VIDEO_FRAME_COMP_DATA (frame1, 0);
-  in2 = GST_VIDEO_FRAME_COMP_DATA (frame2, 0);
-  out = GST_VIDEO_FRAME_COMP_DATA (oframe, 0);
-
-  in1u = GST_VIDEO_FRAME_COMP_DATA (frame1, 1);
-  in1v = GST_VIDEO_FRAME_COMP_DATA (frame1, 2);
-  in2u = GST_VIDEO_FRAME_COMP_DATA (frame2, 1);
-  in2v = GST_VIDEO_FRAME_COMP_DATA (frame2, 2);
-  outu = GST_VIDEO_FRAME_COMP_DATA (oframe, 1);
-  outv = GST_VIDEO_FRAME_COMP_DATA (oframe, 2);
-
-  maskp = mask->data;
-
-  for (i = 0; i < height; i++) {
-    for (j = 0; j < width; j++) {
-      value = *maskp++;
-      value = ((CLAMP (value, min, max) - min) << 8) / border;
-
-      out[j] = ((in1[j] * value) + (in2[j] * (256 - value))) >> 8;
-      if (!(i & 1) && !(j & 1)) {
-        outu[j / 2] =
-            ((in1u[j / 2] * value) + (in2u[j / 2] * (256 - value))) >> 8;
-        outv[j / 2] =
-            ((in1v[j / 2] * value) + (in2v[j / 2] * (256 - value))) >> 8;
-      }
-    }
+  guint32 weights[GST_MASK_BLOCK], cweights[GST_MASK_BLOCK / 2];
+  gint i, j, x, width;
 
-    in1 += GST_VIDEO_FRAME_COMP_STRIDE (frame1, 0);
-    in2 += GST_VIDEO_FRAME_COMP_STRIDE (frame2, 0);
-    out += GST_VIDEO_FRAME_COMP_STRIDE (oframe, 0);
-
-    if (!(i & 1)) {
-      in1u += GST_VIDEO_FRAME_COMP_STRIDE (frame1, 1);
-      in2u += GST_VIDEO_FRAME_COMP_STRIDE (frame2, 1);
-      in1v += GST_VIDEO_FRAME_COMP_STRIDE (frame1, 2);
-      in2v += GST_VIDEO_FRAME_COMP_STRIDE (frame1, 2);
-      outu += GST_VIDEO_FRAME_COMP_STRIDE (oframe, 1);
-      outv += GST_VIDEO_FRAME_COMP_STRIDE (oframe, 2);
+  width = GST_VIDEO_FRAME_WIDTH (job->frame1);
+
+  for (i = y; i < y + height; i++) {
+    const guint32 *maskp = job->mask->data + i * width;
+    guint8 *in1, *in2, *out, *in1u, *in1v, *in2u, *in2v, *outu, *outv;
+
+    in1 = COMP_ROW (job->frame1, 0, i);
+    in2 = COMP_ROW (job->frame2, 0, i);
+    out = COMP_ROW (job->oframe, 0, i);
+
+    in1u = COMP_ROW (job->frame1, 1, i / 2);
+    in1v = COMP_ROW (job->frame1, 2, i / 2);
+    in2u = COMP_ROW (job->frame2, 1, i / 2);
+    in2v = COMP_ROW (job->frame2, 2, i / 2);
+    outu = COMP_ROW (job->oframe, 1, i / 2);
+    outv = COMP_ROW (job->oframe, 2, i / 2);
+
+    for (x = 0; x < width; x += GST_MASK_BLOCK) {
+      gint n = MIN (GST_MASK_BLOCK, width - x);
+      gint cn = (n + 1) / 2;
+
+      gst_mask_weights_get (job->weights, maskp + x, weights, n);
+      gst_smpte_blend_block (out + x, in1 + x, in2 + x, weights, n);
+
+      /* chroma uses the weights of the even rows and columns */
+      if (i & 1)
+        continue;
+
+      for (j = 0; j < cn; j++)
+        cweights[j] = weights[2 * j];
+
+      gst_smpte_blend_block (outu + x / 2, in1u + x / 2, in2u + x / 2,
+          cweights, cn);
+      gst_smpte_blend_block (outv + x / 2, in1v + x / 2, in2v + x / 2,
+          cweights, cn);
     }
   }
 }
@@ -456,6 +502,7 @@ gst_smpte_collected (GstCollectPads * pads, GstSMPTE * smpte)
   GSList *collected;
   GstMapInfo map;
   GstVideoFrame frame1, frame2, oframe;
+  GstSMPTEJob job;
 
   if (G_UNLIKELY (smpte->fps_num == 0))
     goto not_negotiated;
@@ -526,9 +573,22 @@ gst_smpte_collected (GstCollectPads * pads, GstSMPTE * smpte)
     gst_video_frame_map (&frame2, &smpte->vinfo2, in2, GST_MAP_READ);
     /* re-use either info, now know they are essentially identical */
     gst_video_frame_map (&oframe, &smpte->vinfo1, outbuf, GST_MAP_WRITE);
-    gst_smpte_blend_i420 (&frame1, &frame2, &oframe, smpte->mask, smpte->border,
+
+    /* the weights of all mask values only change with the position */
+    gst_mask_weights_update (&smpte->weights, smpte->mask->bpp, smpte->border,
         ((1 << smpte->depth) + smpte->border) *
         smpte->position / smpte->end_position);
+
+    job.frame1 = &frame1;
+    job.frame2 = &frame2;
+    job.oframe = &oframe;
+    job.mask = smpte->mask;
+    job.weights = &smpte->weights;
+
+    /* bands start on even rows so they split the chroma planes too */
+    gst_video_bands_process_rows (&smpte->bands, smpte->n_threads,
+        GST_VIDEO_FRAME_HEIGHT (&frame1), 2,
+        (GstVideoBandsRowsFunc) gst_smpte_blend_i420, &job);
     gst_video_frame_unmap (&frame1);
     gst_video_frame_unmap (&frame2);
     gst_video_frame_unmap (&oframe);
@@ -596,6 +656,9 @@ gst_smpte_set_property (GObject * object, guint prop_id,
     case PROP_INVERT:
       smpte->invert = g_value_get_boolean (value);
       break;
+    case PROP_N_THREADS:
+      smpte->n_threads = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -626,6 +689,9 @@ gst_smpte_get_property (GObject * object, guint prop_id,
     case PROP_INVERT:
       g_value_set_boolean (value, smpte->invert);
       break;
+    case PROP_N_THREADS:
+      g_value_set_uint (value, smpte->n_threads);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -24,6 +24,7 @@
 #include <gst/gst.h>
 #include <gst/base/gstcollectpads.h>
 #include <gst/video/video.h>
+#include <gst/video-bands-private.h>
 
 G_BEGIN_DECLS
 
@@ -59,6 +60,7 @@ struct _GstSMPTE {
   gint           depth;
   guint64        duration;
   gboolean       invert;
+  guint          n_threads;
 
   /* negotiated format */
   gint           width;
@@ -72,6 +74,8 @@ struct _GstSMPTE {
   gint           position;
   gint           end_position;
   GstMask       *mask;
+  GstMaskWeights weights;
+  GstVideoBands  bands;
 };
 
 struct _GstSMPTEClass {
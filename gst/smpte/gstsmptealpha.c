@@ -85,6 +85,7 @@ static GstStaticPadTemplate gst_smpte_alpha_sink_template =
 #define DEFAULT_PROP_DEPTH	16
 #define DEFAULT_PROP_POSITION	0.0
 #define DEFAULT_PROP_INVERT   FALSE
+#define DEFAULT_PROP_N_THREADS 1
 
 enum
 {
@@ -93,7 +94,8 @@ enum
   PROP_BORDER,
   PROP_DEPTH,
   PROP_POSITION,
-  PROP_INVERT
+  PROP_INVERT,
+  PROP_N_THREADS
 };
 
 #define AYUV_SIZE(w,h)     ((w) * (h) * 4)
@@ -197,6 +199,19 @@ gst_smpte_alpha_class_init (GstSMPTEAlphaClass * klass)
       g_param_spec_boolean ("invert", "Invert",
           "Invert transition mask", DEFAULT_PROP_POSITION,
           GST_PARAM_CONTROLLABLE | G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  /**
+   * GstSMPTEAlpha:n-threads:
+   *
+   * Maximum number of threads used to process each frame, in bands of rows.
+   * 0 uses one thread per CPU.
+   *
+   * Since: 1.24
+   */
+  g_object_class_install_property (G_OBJECT_CLASS (klass), PROP_N_THREADS,
+      g_param_spec_uint ("n-threads", "Threads",
+          "Maximum number of threads to use (0 = number of CPUs)", 0,
+          G_MAXINT, DEFAULT_PROP_N_THREADS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
   trans_class->before_transform =
       GST_DEBUG_FUNCPTR (gst_smpte_alpha_before_transform);
@@ -273,189 +288,114 @@ gst_smpte_alpha_init (GstSMPTEAlpha * smpte)
   smpte->depth = DEFAULT_PROP_DEPTH;
   smpte->position = DEFAULT_PROP_POSITION;
   smpte->invert = DEFAULT_PROP_INVERT;
-}
+  smpte->n_threads = DEFAULT_PROP_N_THREADS;
 
-#define CREATE_ARGB_FUNC(name, A, R, G, B) \
-static void \
-gst_smpte_alpha_process_##name##_##name (GstSMPTEAlpha * smpte, \
-    const GstVideoFrame * in_frame, GstVideoFrame * out_frame, GstMask * mask, \
-    gint border, gint pos) \
-{ \
-  gint i, j; \
-  const guint32 *maskp; \
-  gint value; \
-  gint min, max; \
-  gint width, height; \
-  guint8 *in, *out; \
-  gint src_wrap, dest_wrap; \
-  \
-  if (border == 0) \
-    border++; \
-  \
-  min = pos - border; \
-  max = pos; \
-  GST_DEBUG_OBJECT (smpte, "pos %d, min %d, max %d, border %d", pos, min, max, \
-      border); \
-  \
-  maskp = mask->data; \
-  \
-  width = GST_VIDEO_FRAME_WIDTH (out_frame); \
-  height = GST_VIDEO_FRAME_HEIGHT (out_frame); \
-  \
-  in = GST_VIDEO_FRAME_PLANE_DATA (in_frame, 0); \
-  out = GST_VIDEO_FRAME_PLANE_DATA (out_frame, 0); \
-  src_wrap = GST_VIDEO_FRAME_PLANE_STRIDE (in_frame, 0) - (width << 2); \
-  dest_wrap = GST_VIDEO_FRAME_PLANE_STRIDE (out_frame, 0) - (width << 2); \
-  \
-  /* we basically copy the source to dest but we scale the alpha channel with \
-   * the mask */ \
-  for (i = 0; i < height; i++) { \
-    for (j = 0; j < width; j++) { \
-      value = *maskp++; \
-      out[A] = (in[A] * ((CLAMP (value, min, max) - min) << 8) / border) >> 8; \
-      out[R] = in[R]; \
-      out[G] = in[G]; \
-      out[B] = in[B]; \
-      out += 4; \
-      in += 4; \
-    } \
-    in += src_wrap; \
-    out += dest_wrap; \
-  } \
+  gst_mask_weights_init (&smpte->weights);
+  gst_video_bands_init (&smpte->bands);
 }
 
-CREATE_ARGB_FUNC (argb, 0, 1, 2, 3);
-CREATE_ARGB_FUNC (bgra, 3, 2, 1, 0);
-CREATE_ARGB_FUNC (abgr, 0, 3, 2, 1);
-CREATE_ARGB_FUNC (rgba, 3, 0, 1, 2);
+#define PLANE_ROW(frame, p, row) \
+    ((guint8 *) GST_VIDEO_FRAME_PLANE_DATA (frame, p) + \
+    (row) * GST_VIDEO_FRAME_PLANE_STRIDE (frame, p))
 
-static void
-gst_smpte_alpha_process_ayuv_ayuv (GstSMPTEAlpha * smpte,
-    const GstVideoFrame * in_frame, GstVideoFrame * out_frame, GstMask * mask,
-    gint border, gint pos)
+/* the 16.16 weights are cut to the 8 fractional bits this element always
+ * scaled alpha with, so the output stays bit-exact with earlier versions */
+#define W8(w) ((w) & ~0xffu)
+
+typedef struct
 {
-  gint i, j;
-  const guint32 *maskp;
-  gint value;
-  gint min, max;
-  gint width, height;
-  guint8 *in, *out;
-  gint src_wrap, dest_wrap;
+  GstSMPTEAlpha *smpte;
+  const GstVideoFrame *in_frame;
+  GstVideoFrame *out_frame;
+  const GstMask *mask;
+  const GstMaskWeights *weights;
+} GstSMPTEAlphaJob;
+
+/* we basically copy the source to dest but we scale the alpha channel with
+ * the mask */
+static inline void
+gst_smpte_alpha_process_packed (const GstVideoFrame * in_frame,
+    GstVideoFrame * out_frame, const GstMask * mask,
+    const GstMaskWeights * weights, gint y, gint height, gint A)
+{
+  guint32 w[GST_MASK_BLOCK];
+  gint i, j, x, width;
 
-  if (border == 0)
-    border++;
+  width = GST_VIDEO_FRAME_WIDTH (out_frame);
 
-  min = pos - border;
-  max = pos;
-  GST_DEBUG_OBJECT (smpte, "pos %d, min %d, max %d, border %d", pos, min, max,
-      border);
+  for (i = y; i < y + height; i++) {
+    const guint32 *maskp = mask->data + i * width;
+    const guint8 *in = PLANE_ROW (in_frame, 0, i);
+    guint8 *out = PLANE_ROW (out_frame, 0, i);
 
-  maskp = mask->data;
+    for (x = 0; x < width; x += GST_MASK_BLOCK) {
+      gint n = MIN (GST_MASK_BLOCK, width - x);
 
-  width = GST_VIDEO_FRAME_WIDTH (out_frame);
-  height = GST_VIDEO_FRAME_HEIGHT (out_frame);
-
-  in = GST_VIDEO_FRAME_PLANE_DATA (in_frame, 0);
-  out = GST_VIDEO_FRAME_PLANE_DATA (out_frame, 0);
-  src_wrap = GST_VIDEO_FRAME_PLANE_STRIDE (in_frame, 0) - (width << 2);
-  dest_wrap = GST_VIDEO_FRAME_PLANE_STRIDE (out_frame, 0) - (width << 2);
-
-  /* we basically copy the source to dest but we scale the alpha channel with
-   * the mask */
-  for (i = 0; i < height; i++) {
-    for (j = 0; j < width; j++) {
-      value = *maskp++;
-      *out++ = (*in++ * ((CLAMP (value, min, max) - min) << 8) / border) >> 8;
-      *out++ = *in++;
-      *out++ = *in++;
-      *out++ = *in++;
+      gst_mask_weights_get (weights, maskp + x, w, n);
+
+      memcpy (out + 4 * x, in + 4 * x, 4 * n);
+      for (j = 0; j < n; j++)
+        out[4 * (x + j) + A] = (in[4 * (x + j) + A] * W8 (w[j])) >> 16;
     }
-    in += src_wrap;
-    out += dest_wrap;
   }
 }
 
+#define CREATE_PACKED_FUNC(name, A) \
+static void \
+gst_smpte_alpha_process_##name##_##name (GstSMPTEAlpha * smpte, \
+    const GstVideoFrame * in_frame, GstVideoFrame * out_frame, \
+    const GstMask * mask, const GstMaskWeights * weights, gint y, \
+    gint height) \
+{ \
+  gst_smpte_alpha_process_packed (in_frame, out_frame, mask, weights, y, \
+      height, A); \
+}
+
+CREATE_PACKED_FUNC (argb, 0);
+CREATE_PACKED_FUNC (bgra, 3);
+CREATE_PACKED_FUNC (abgr, 0);
+CREATE_PACKED_FUNC (rgba, 3);
+CREATE_PACKED_FUNC (ayuv, 0);
+
 static void
 gst_smpte_alpha_process_i420_ayuv (GstSMPTEAlpha * smpte,
-    const GstVideoFrame * in_frame, GstVideoFrame * out_frame, GstMask * mask,
-    gint border, gint pos)
+    const GstVideoFrame * in_frame, GstVideoFrame * out_frame,
+    const GstMask * mask, const GstMaskWeights * weights, gint y, gint height)
 {
-  const guint8 *srcY;
-  const guint8 *srcU;
-  const guint8 *srcV;
-  guint8 *out;
-  gint i, j;
-  gint src_wrap, src_u_wrap, src_v_wrap, dest_wrap;
-  gint y_stride, u_stride, v_stride;
-  gboolean odd_width;
-  const guint32 *maskp;
-  gint value;
-  gint min, max;
-  gint width, height;
+  guint32 w[GST_MASK_BLOCK];
+  gint i, j, x, width;
 
-  if (border == 0)
-    border++;
+  width = GST_VIDEO_FRAME_WIDTH (out_frame);
 
-  min = pos - border;
-  max = pos;
-  GST_DEBUG_OBJECT (smpte, "pos %d, min %d, max %d, border %d", pos, min, max,
-      border);
+  for (i = y; i < y + height; i++) {
+    const guint32 *maskp = mask->data + i * width;
+    const guint8 *srcY = PLANE_ROW (in_frame, 0, i);
+    const guint8 *srcU = PLANE_ROW (in_frame, 1, i / 2);
+    const guint8 *srcV = PLANE_ROW (in_frame, 2, i / 2);
+    guint8 *out = PLANE_ROW (out_frame, 0, i);
 
-  maskp = mask->data;
+    for (x = 0; x < width; x += GST_MASK_BLOCK) {
+      gint n = MIN (GST_MASK_BLOCK, width - x);
 
-  width = GST_VIDEO_FRAME_WIDTH (out_frame);
-  height = GST_VIDEO_FRAME_HEIGHT (out_frame);
-
-  y_stride = GST_VIDEO_FRAME_COMP_STRIDE (in_frame, 0);
-  u_stride = GST_VIDEO_FRAME_COMP_STRIDE (in_frame, 1);
-  v_stride = GST_VIDEO_FRAME_COMP_STRIDE (in_frame, 2);
-
-  src_wrap = y_stride - width;
-  src_u_wrap = u_stride - (width / 2);
-  src_v_wrap = v_stride - (width / 2);
-
-  srcY = GST_VIDEO_FRAME_COMP_DATA (in_frame, 0);
-  srcU = GST_VIDEO_FRAME_COMP_DATA (in_frame, 1);
-  srcV = GST_VIDEO_FRAME_COMP_DATA (in_frame, 2);
-
-  out = GST_VIDEO_FRAME_PLANE_DATA (out_frame, 0);
-  dest_wrap = GST_VIDEO_FRAME_PLANE_STRIDE (out_frame, 0) - (width << 2);
-
-  odd_width = (width % 2 != 0);
-
-  for (i = 0; i < height; i++) {
-    for (j = 0; j < width / 2; j++) {
-      value = *maskp++;
-      *out++ = (0xff * ((CLAMP (value, min, max) - min) << 8) / border) >> 8;
-      *out++ = *srcY++;
-      *out++ = *srcU;
-      *out++ = *srcV;
-      value = *maskp++;
-      *out++ = (0xff * ((CLAMP (value, min, max) - min) << 8) / border) >> 8;
-      *out++ = *srcY++;
-      *out++ = *srcU++;
-      *out++ = *srcV++;
-    }
-    /* Might have one odd column left to do */
-    if (odd_width) {
-      value = *maskp++;
-      *out++ = (0xff * ((CLAMP (value, min, max) - min) << 8) / border) >> 8;
-      *out++ = *srcY++;
-      *out++ = *srcU;
-      *out++ = *srcV;
-    }
-    if (i % 2 == 0) {
-      srcU -= width / 2;
-      srcV -= width / 2;
-    } else {
-      srcU += src_u_wrap;
-      srcV += src_v_wrap;
+      gst_mask_weights_get (weights, maskp + x, w, n);
+
+      for (j = x; j < x + n; j++) {
+        out[4 * j] = (0xff * W8 (w[j - x])) >> 16;
+        out[4 * j + 1] = srcY[j];
+        out[4 * j + 2] = srcU[j / 2];
+        out[4 * j + 3] = srcV[j / 2];
+      }
     }
-    srcY += src_wrap;
-    out += dest_wrap;
   }
 }
 
+static void
+gst_smpte_alpha_process_rows (GstSMPTEAlphaJob * job, gint y, gint height)
+{
+  job->smpte->process (job->smpte, job->in_frame, job->out_frame, job->mask,
+      job->weights, y, height);
+}
+
 static void
 gst_smpte_alpha_before_transform (GstBaseTransform * trans, GstBuffer * buf)
 {
@@ -479,8 +419,9 @@ gst_smpte_alpha_transform_frame (GstVideoFilter * vfilter,
     GstVideoFrame * in_frame, GstVideoFrame * out_frame)
 {
   GstSMPTEAlpha *smpte = GST_SMPTE_ALPHA (vfilter);
+  GstSMPTEAlphaJob job;
   gdouble position;
-  gint border;
+  gint border, pos;
 
   if (G_UNLIKELY (!smpte->process))
     goto not_negotiated;
@@ -488,10 +429,24 @@ gst_smpte_alpha_transform_frame (GstVideoFilter * vfilter,
   GST_OBJECT_LOCK (smpte);
   position = smpte->position;
   border = smpte->border;
+  pos = ((1 << smpte->depth) + border) * position;
+
+  GST_DEBUG_OBJECT (smpte, "pos %d, border %d", pos, border);
 
-  /* run the type specific filter code */
-  smpte->process (smpte, in_frame, out_frame,
-      smpte->mask, border, ((1 << smpte->depth) + border) * position);
+  /* the weights of all mask values only change with the position */
+  gst_mask_weights_update (&smpte->weights, smpte->mask->bpp, border, pos);
+
+  job.smpte = smpte;
+  job.in_frame = in_frame;
+  job.out_frame = out_frame;
+  job.mask = smpte->mask;
+  job.weights = &smpte->weights;
+
+  /* run the type specific filter code, bands start on even rows so they
+   * split the chroma planes of I420 too */
+  gst_video_bands_process_rows (&smpte->bands, smpte->n_threads,
+      GST_VIDEO_FRAME_HEIGHT (out_frame), 2,
+      (GstVideoBandsRowsFunc) gst_smpte_alpha_process_rows, &job);
   GST_OBJECT_UNLOCK (smpte);
 
   return GST_FLOW_OK;
@@ -705,6 +660,8 @@ gst_smpte_alpha_finalize (GstSMPTEAlpha * smpte)
   if (smpte->mask)
     gst_mask_destroy (smpte->mask);
   smpte->mask = NULL;
+  gst_mask_weights_clear (&smpte->weights);
+  gst_video_bands_clear (&smpte->bands);
 
   G_OBJECT_CLASS (parent_class)->finalize ((GObject *) smpte);
 }
@@ -758,6 +715,11 @@ gst_smpte_alpha_set_property (GObject * object, guint prop_id,
       GST_OBJECT_UNLOCK (smpte);
       break;
     }
+    case PROP_N_THREADS:
+      GST_OBJECT_LOCK (smpte);
+      smpte->n_threads = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (smpte);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -798,6 +760,11 @@ gst_smpte_alpha_get_property (GObject * object, guint prop_id,
       g_value_set_boolean (value, smpte->invert);
       GST_OBJECT_UNLOCK (smpte);
       break;
+    case PROP_N_THREADS:
+      GST_OBJECT_LOCK (smpte);
+      g_value_set_uint (value, smpte->n_threads);
+      GST_OBJECT_UNLOCK (smpte);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
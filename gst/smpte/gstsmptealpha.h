@@ -24,6 +24,7 @@
 #include <gst/gst.h>
 #include <gst/video/video.h>
 #include <gst/video/gstvideofilter.h>
+#include <gst/video-bands-private.h>
 
 
 G_BEGIN_DECLS
@@ -53,6 +54,7 @@ struct _GstSMPTEAlpha {
   gint           depth;
   gdouble        position;
   gboolean       invert;
+  guint          n_threads;
 
   /* negotiated format */
   GstVideoFormat in_format, out_format;
@@ -61,10 +63,12 @@ struct _GstSMPTEAlpha {
 
   /* state of the effect */
   GstMask       *mask;
+  GstMaskWeights weights;
+  GstVideoBands  bands;
 
-  /* processing function */
+  /* processing function, for rows @y to @y + @height */
   void (*process) (GstSMPTEAlpha * smpte, const GstVideoFrame * in, GstVideoFrame * out,
-    GstMask * mask, gint border, gint pos);
+    const GstMask * mask, const GstMaskWeights * weights, gint y, gint height);
 };
 
 struct _GstSMPTEAlphaClass {
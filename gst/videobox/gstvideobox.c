@@ -48,6 +48,10 @@
  * properties manually because they will be overridden if the caps change,
  * but nothing stops you from doing so.
  *
+ * When only cropping a format without alpha channel and downstream supports
+ * #GstVideoCropMeta, the input buffers are passed on with a crop meta instead
+ * of being copied.
+ *
  * Sample pipeline:
  * |[
  * gst-launch-1.0 videotestsrc ! videobox autocrop=true ! \
@@ -135,6 +139,17 @@ static const gint cog_identity_matrix_8bit[] = {
 
 #define APPLY_MATRIX(m,o,v1,v2,v3) ((m[o*4] * v1 + m[o*4+1] * v2 + m[o*4+2] * v3 + m[o*4+3]) >> 8)
 
+/* Copies the first of @height rows of @row_size bytes to all the others,
+ * for fills that can't be done with a memset or a splat */
+static void
+fill_replicate_row (guint8 * dest, gint stride, gint row_size, gint height)
+{
+  gint i;
+
+  for (i = 1; i < height; i++)
+    memcpy (dest + i * stride, dest, row_size);
+}
+
 static void
 fill_ayuv (GstVideoBoxFill fill_type, guint b_alpha,
     GstVideoFrame * frame, gboolean sdtv)
@@ -171,6 +186,28 @@ fill_ayuv (GstVideoBoxFill fill_type, guint b_alpha,
   }
 }
 
+/* Copies @n 32 bit pixels, scaling the alpha byte at byte offset @a_offset
+ * by @i_alpha. Working on whole pixels instead of bytes lets the compiler
+ * vectorize this. */
+static inline void
+copy_scale_alpha_u32 (guint32 * dest, const guint32 * src, gint n,
+    guint i_alpha, gint a_offset)
+{
+#if G_BYTE_ORDER == G_LITTLE_ENDIAN
+  const guint shift = a_offset * 8;
+#else
+  const guint shift = (3 - a_offset) * 8;
+#endif
+  const guint32 mask = 0xffu << shift;
+  gint i;
+
+  for (i = 0; i < n; i++) {
+    guint32 p = src[i];
+
+    dest[i] = (p & ~mask) | (((((p >> shift) & 0xff) * i_alpha) >> 8) << shift);
+  }
+}
+
 static void
 copy_ayuv_ayuv (guint i_alpha, GstVideoFrame * dest_frame,
     gboolean dest_sdtv, gint dest_x, gint dest_y, GstVideoFrame * src_frame,
@@ -216,13 +253,8 @@ copy_ayuv_ayuv (guint i_alpha, GstVideoFrame * dest_frame,
     }
   } else {
     for (i = 0; i < h; i++) {
-      for (j = 0; j < w; j += 4) {
-        /* ORC FIXME */
-        dest[j] = (src[j] * i_alpha) >> 8;
-        dest[j + 1] = src[j + 1];
-        dest[j + 2] = src[j + 2];
-        dest[j + 3] = src[j + 3];
-      }
+      copy_scale_alpha_u32 ((guint32 *) dest, (const guint32 *) src, w / 4,
+          i_alpha, 0);
       dest += dest_stride;
       src += src_stride;
     }
@@ -1809,7 +1841,7 @@ fill_rgb24 (GstVideoBoxFill fill_type, guint b_alpha,
 {
   gint dest_stride;
   gint p[4];
-  gint i, j;
+  gint j;
   guint8 *dest;
   gint width, height;
 
@@ -1823,14 +1855,15 @@ fill_rgb24 (GstVideoBoxFill fill_type, guint b_alpha,
   p[2] = GST_VIDEO_FRAME_COMP_OFFSET (frame, 1);
   p[3] = GST_VIDEO_FRAME_COMP_OFFSET (frame, 2);
 
-  for (i = 0; i < height; i++) {
-    for (j = 0; j < width; j++) {
-      dest[3 * j + p[1]] = rgb_colors_R[fill_type];
-      dest[3 * j + p[2]] = rgb_colors_G[fill_type];
-      dest[3 * j + p[3]] = rgb_colors_B[fill_type];
-    }
-    dest += dest_stride;
+  if (height == 0)
+    return;
+
+  for (j = 0; j < width; j++) {
+    dest[3 * j + p[1]] = rgb_colors_R[fill_type];
+    dest[3 * j + p[2]] = rgb_colors_G[fill_type];
+    dest[3 * j + p[3]] = rgb_colors_B[fill_type];
   }
+  fill_replicate_row (dest, dest_stride, 3 * width, height);
 }
 
 static void
@@ -1872,7 +1905,14 @@ copy_rgb32 (guint i_alpha, GstVideoFrame * dest_frame,
   src = GST_VIDEO_FRAME_PLANE_DATA (src_frame, 0);
   src = src + src_y * src_stride + src_x * in_bpp;
 
-  if (in_alpha && out_alpha) {
+  if (in_alpha && out_alpha && !memcmp (p_in, p_out, sizeof (p_in))) {
+    for (i = 0; i < h; i++) {
+      copy_scale_alpha_u32 ((guint32 *) dest, (const guint32 *) src, w,
+          i_alpha, p_in[0]);
+      dest += dest_stride;
+      src += src_stride;
+    }
+  } else if (in_alpha && out_alpha) {
     w *= 4;
     for (i = 0; i < h; i++) {
       for (j = 0; j < w; j += 4) {
@@ -1911,6 +1951,14 @@ copy_rgb32 (guint i_alpha, GstVideoFrame * dest_frame,
       dest += dest_stride;
       src += src_stride;
     }
+  } else if (in_bpp == out_bpp && !memcmp (p_in + 1, p_out + 1,
+          3 * sizeof (gint))) {
+    w *= in_bpp;
+    for (i = 0; i < h; i++) {
+      memcpy (dest, src, w);
+      dest += dest_stride;
+      src += src_stride;
+    }
   } else if (!packed_out && !packed_in) {
     w *= 4;
     for (i = 0; i < h; i++) {
@@ -2164,24 +2212,19 @@ fill_gray (GstVideoBoxFill fill_type, guint b_alpha,
       memset (dest, val, width);
       dest += dest_stride;
     }
-  } else {
+  } else if (height) {
     guint16 val = yuv_sdtv_colors_Y[fill_type] << 8;
 
     if (format == GST_VIDEO_FORMAT_GRAY16_BE) {
-      for (i = 0; i < height; i++) {
-        for (j = 0; j < width; j++) {
-          GST_WRITE_UINT16_BE (dest + 2 * j, val);
-        }
-        dest += dest_stride;
+      for (j = 0; j < width; j++) {
+        GST_WRITE_UINT16_BE (dest + 2 * j, val);
       }
     } else {
-      for (i = 0; i < height; i++) {
-        for (j = 0; j < width; j++) {
-          GST_WRITE_UINT16_LE (dest + 2 * j, val);
-        }
-        dest += dest_stride;
+      for (j = 0; j < width; j++) {
+        GST_WRITE_UINT16_LE (dest + 2 * j, val);
       }
     }
+    fill_replicate_row (dest, dest_stride, 2 * width, height);
   }
 }
 
@@ -2217,7 +2260,7 @@ fill_yuy2 (GstVideoBoxFill fill_type, guint b_alpha,
     GstVideoFrame * frame, gboolean sdtv)
 {
   guint8 y, u, v;
-  gint i, j;
+  gint j;
   gint stride;
   gint width, height;
   guint8 *dest;
@@ -2237,40 +2280,32 @@ fill_yuy2 (GstVideoBoxFill fill_type, guint b_alpha,
 
   width = width + (width % 2);
 
-  if (format == GST_VIDEO_FORMAT_YUY2) {
-    for (i = 0; i < height; i++) {
-      for (j = 0; j < width; j += 2) {
-        dest[j * 2 + 0] = y;
-        dest[j * 2 + 1] = u;
-        dest[j * 2 + 2] = y;
-        dest[j * 2 + 3] = v;
-      }
+  if (height == 0)
+    return;
 
-      dest += stride;
+  if (format == GST_VIDEO_FORMAT_YUY2) {
+    for (j = 0; j < width; j += 2) {
+      dest[j * 2 + 0] = y;
+      dest[j * 2 + 1] = u;
+      dest[j * 2 + 2] = y;
+      dest[j * 2 + 3] = v;
     }
   } else if (format == GST_VIDEO_FORMAT_YVYU) {
-    for (i = 0; i < height; i++) {
-      for (j = 0; j < width; j += 2) {
-        dest[j * 2 + 0] = y;
-        dest[j * 2 + 1] = v;
-        dest[j * 2 + 2] = y;
-        dest[j * 2 + 3] = u;
-      }
-
-      dest += stride;
+    for (j = 0; j < width; j += 2) {
+      dest[j * 2 + 0] = y;
+      dest[j * 2 + 1] = v;
+      dest[j * 2 + 2] = y;
+      dest[j * 2 + 3] = u;
     }
   } else {
-    for (i = 0; i < height; i++) {
-      for (j = 0; j < width; j += 2) {
-        dest[j * 2 + 0] = u;
-        dest[j * 2 + 1] = y;
-        dest[j * 2 + 2] = v;
-        dest[j * 2 + 3] = y;
-      }
-
-      dest += stride;
+    for (j = 0; j < width; j += 2) {
+      dest[j * 2 + 0] = u;
+      dest[j * 2 + 1] = y;
+      dest[j * 2 + 2] = v;
+      dest[j * 2 + 3] = y;
     }
   }
+  fill_replicate_row (dest, stride, 2 * width, height);
 }
 
 static void
@@ -2426,6 +2461,13 @@ static void gst_video_box_before_transform (GstBaseTransform * trans,
 static gboolean gst_video_box_src_event (GstBaseTransform * trans,
     GstEvent * event);
 
+static gboolean gst_video_box_decide_allocation (GstBaseTransform * trans,
+    GstQuery * query);
+static gboolean gst_video_box_propose_allocation (GstBaseTransform * trans,
+    GstQuery * decide_query, GstQuery * query);
+static GstFlowReturn gst_video_box_transform_ip (GstBaseTransform * trans,
+    GstBuffer * buf);
+
 static gboolean gst_video_box_set_info (GstVideoFilter * vfilter, GstCaps * in,
     GstVideoInfo * in_info, GstCaps * out, GstVideoInfo * out_info);
 static GstFlowReturn gst_video_box_transform_frame (GstVideoFilter * vfilter,
@@ -2522,6 +2564,12 @@ gst_video_box_class_init (GstVideoBoxClass * klass)
   trans_class->transform_caps =
       GST_DEBUG_FUNCPTR (gst_video_box_transform_caps);
   trans_class->src_event = GST_DEBUG_FUNCPTR (gst_video_box_src_event);
+  trans_class->decide_allocation =
+      GST_DEBUG_FUNCPTR (gst_video_box_decide_allocation);
+  trans_class->propose_allocation =
+      GST_DEBUG_FUNCPTR (gst_video_box_propose_allocation);
+  trans_class->transform_ip = GST_DEBUG_FUNCPTR (gst_video_box_transform_ip);
+  trans_class->transform_ip_on_passthrough = FALSE;
 
   vfilter_class->set_info = GST_DEBUG_FUNCPTR (gst_video_box_set_info);
   vfilter_class->transform_frame =
@@ -2992,6 +3040,20 @@ bail:
   }
 }
 
+/* Only cropping without any conversion selects a part of the input frame
+ * as is, which downstream can do itself when it supports the crop meta. The
+ * alpha of alpha formats is scaled by the copy, so those are excluded. */
+static gboolean
+gst_video_box_is_crop_only (GstVideoBox * video_box)
+{
+  return video_box->in_format == video_box->out_format &&
+      video_box->in_sdtv == video_box->out_sdtv &&
+      video_box->box_left >= 0 && video_box->box_right >= 0 &&
+      video_box->box_top >= 0 && video_box->box_bottom >= 0 &&
+      !GST_VIDEO_FORMAT_INFO_HAS_ALPHA (gst_video_format_get_info
+      (video_box->in_format));
+}
+
 static gboolean
 gst_video_box_recalc_transform (GstVideoBox * video_box)
 {
@@ -3007,10 +3069,20 @@ gst_video_box_recalc_transform (GstVideoBox * video_box)
     GST_LOG_OBJECT (video_box, "we are using passthrough");
     gst_base_transform_set_passthrough (GST_BASE_TRANSFORM_CAST (video_box),
         TRUE);
+  } else if (video_box->use_crop_meta
+      && gst_video_box_is_crop_only (video_box)) {
+    GST_LOG_OBJECT (video_box, "we are doing in-place transform using crop "
+        "meta");
+    gst_base_transform_set_passthrough (GST_BASE_TRANSFORM_CAST (video_box),
+        FALSE);
+    gst_base_transform_set_in_place (GST_BASE_TRANSFORM_CAST (video_box),
+        TRUE);
   } else {
     GST_LOG_OBJECT (video_box, "we are not using passthrough");
     gst_base_transform_set_passthrough (GST_BASE_TRANSFORM_CAST (video_box),
         FALSE);
+    gst_base_transform_set_in_place (GST_BASE_TRANSFORM_CAST (video_box),
+        FALSE);
   }
   return res;
 }
@@ -3178,6 +3250,10 @@ gst_video_box_set_info (GstVideoFilter * vfilter, GstCaps * in,
   /* recalc the transformation strategy */
   ret = gst_video_box_recalc_transform (video_box);
 
+  /* Ensure our decide_allocation will be called again when needed */
+  if (!gst_base_transform_is_passthrough (GST_BASE_TRANSFORM (video_box)))
+    gst_base_transform_set_in_place (GST_BASE_TRANSFORM (video_box), FALSE);
+
   if (ret)
     ret = gst_video_box_select_processing_functions (video_box);
   g_mutex_unlock (&video_box->mutex);
@@ -3214,6 +3290,137 @@ gst_video_box_src_event (GstBaseTransform * trans, GstEvent * event)
   return GST_BASE_TRANSFORM_CLASS (parent_class)->src_event (trans, event);
 }
 
+static gboolean
+gst_video_box_decide_allocation (GstBaseTransform * trans, GstQuery * query)
+{
+  GstVideoBox *video_box = GST_VIDEO_BOX (trans);
+
+  g_mutex_lock (&video_box->mutex);
+  video_box->use_crop_meta = (gst_query_find_allocation_meta (query,
+          GST_VIDEO_CROP_META_API_TYPE, NULL) &&
+      gst_query_find_allocation_meta (query, GST_VIDEO_META_API_TYPE, NULL));
+  gst_video_box_recalc_transform (video_box);
+  g_mutex_unlock (&video_box->mutex);
+
+  return GST_BASE_TRANSFORM_CLASS (parent_class)->decide_allocation (trans,
+      query);
+}
+
+static gboolean
+gst_video_box_propose_allocation (GstBaseTransform * trans,
+    GstQuery * decide_query, GstQuery * query)
+{
+  /* when cropping in place, upstream crop meta is simply adjusted */
+  if (decide_query && gst_base_transform_is_in_place (trans)) {
+    GST_DEBUG_OBJECT (trans, "Advertising crop meta support");
+    gst_query_add_allocation_meta (query, GST_VIDEO_CROP_META_API_TYPE, NULL);
+  }
+
+  return GST_BASE_TRANSFORM_CLASS (parent_class)->propose_allocation (trans,
+      decide_query, query);
+}
+
+static GstFlowReturn
+gst_video_box_transform_ip (GstBaseTransform * trans, GstBuffer * buf)
+{
+  GstVideoBox *video_box = GST_VIDEO_BOX (trans);
+  GstVideoCropMeta *crop_meta;
+
+  GST_LOG_OBJECT (trans, "Cropping in-place");
+
+  g_mutex_lock (&video_box->mutex);
+
+  /* The video meta is required since the caps describe the smaller output
+   * frame, which would not allow mapping the buffer */
+  if (!gst_buffer_get_video_meta (buf)) {
+    gst_buffer_add_video_meta (buf, GST_VIDEO_FRAME_FLAG_NONE,
+        video_box->in_format, video_box->in_width, video_box->in_height);
+  }
+
+  crop_meta = gst_buffer_get_video_crop_meta (buf);
+  if (!crop_meta)
+    crop_meta = gst_buffer_add_video_crop_meta (buf);
+
+  crop_meta->x += video_box->crop_left;
+  crop_meta->y += video_box->crop_top;
+  crop_meta->width = video_box->out_width;
+  crop_meta->height = video_box->out_height;
+
+  g_mutex_unlock (&video_box->mutex);
+
+  return GST_FLOW_OK;
+}
+
+/* make @rect describe the @w x @h pixels at @x, @y of @frame */
+static void
+gst_video_box_slice_frame (const GstVideoFrame * frame, GstVideoFrame * rect,
+    gint x, gint y, gint w, gint h)
+{
+  const GstVideoFormatInfo *finfo = frame->info.finfo;
+  guint c;
+
+  *rect = *frame;
+  GST_VIDEO_INFO_WIDTH (&rect->info) = w;
+  GST_VIDEO_INFO_HEIGHT (&rect->info) = h;
+
+  for (c = 0; c < GST_VIDEO_FRAME_N_COMPONENTS (frame); c++) {
+    gint plane = GST_VIDEO_FRAME_COMP_PLANE (frame, c);
+
+    rect->data[plane] = (guint8 *) frame->data[plane] +
+        GST_VIDEO_FORMAT_INFO_SCALE_HEIGHT (finfo, c, y) *
+        GST_VIDEO_FRAME_PLANE_STRIDE (frame, plane) +
+        GST_VIDEO_FORMAT_INFO_SCALE_WIDTH (finfo, c, x) *
+        GST_VIDEO_FRAME_COMP_PSTRIDE (frame, c);
+  }
+}
+
+static void
+gst_video_box_fill_rect (GstVideoBox * video_box, GstVideoBoxFill fill_type,
+    guint b_alpha, GstVideoFrame * out, gint x, gint y, gint w, gint h)
+{
+  GstVideoFrame rect;
+
+  if (w <= 0 || h <= 0)
+    return;
+
+  gst_video_box_slice_frame (out, &rect, x, y, w, h);
+  video_box->fill (fill_type, b_alpha, &rect, video_box->out_sdtv);
+}
+
+/* Fills everything around the @w x @h frame at @x, @y that the copy will
+ * not overwrite. The borders are extended to whole macro pixels, as the
+ * copy blends partially covered ones with the background. */
+static void
+gst_video_box_fill_borders (GstVideoBox * video_box, GstVideoBoxFill fill_type,
+    guint b_alpha, GstVideoFrame * out, gint x, gint y, gint w, gint h)
+{
+  const GstVideoFormatInfo *finfo = out->info.finfo;
+  gint width = GST_VIDEO_FRAME_WIDTH (out);
+  gint height = GST_VIDEO_FRAME_HEIGHT (out);
+  gint walign = 1, halign = 1;
+  gint top, bottom, left, right;
+  guint c;
+
+  for (c = 0; c < GST_VIDEO_FRAME_N_COMPONENTS (out); c++) {
+    walign = MAX (walign, 1 << GST_VIDEO_FORMAT_INFO_W_SUB (finfo, c));
+    halign = MAX (halign, 1 << GST_VIDEO_FORMAT_INFO_H_SUB (finfo, c));
+  }
+
+  top = MIN (GST_ROUND_UP_N (y, halign), height);
+  bottom = MAX (GST_ROUND_DOWN_N (y + h, halign), top);
+  left = MIN (GST_ROUND_UP_N (x, walign), width);
+  right = MAX (GST_ROUND_DOWN_N (x + w, walign), left);
+
+  gst_video_box_fill_rect (video_box, fill_type, b_alpha, out, 0, 0, width,
+      top);
+  gst_video_box_fill_rect (video_box, fill_type, b_alpha, out, 0, top, left,
+      bottom - top);
+  gst_video_box_fill_rect (video_box, fill_type, b_alpha, out, right, top,
+      width - right, bottom - top);
+  gst_video_box_fill_rect (video_box, fill_type, b_alpha, out, 0, bottom,
+      width, height - bottom);
+}
+
 static void
 gst_video_box_process (GstVideoBox * video_box, GstVideoFrame * in,
     GstVideoFrame * out)
@@ -3265,10 +3472,6 @@ gst_video_box_process (GstVideoBox * video_box, GstVideoFrame * in,
     gint src_x = 0, src_y = 0;
     gint dest_x = 0, dest_y = 0;
 
-    /* Fill everything if a border should be added somewhere */
-    if (bt < 0 || bb < 0 || br < 0 || bl < 0)
-      video_box->fill (fill_type, b_alpha, out, video_box->out_sdtv);
-
     /* Top border */
     if (bt < 0) {
       dest_y += -bt;
@@ -3283,6 +3486,11 @@ gst_video_box_process (GstVideoBox * video_box, GstVideoFrame * in,
       src_x += bl;
     }
 
+    /* Fill the borders if they should be added somewhere */
+    if (bt < 0 || bb < 0 || br < 0 || bl < 0)
+      gst_video_box_fill_borders (video_box, fill_type, b_alpha, out, dest_x,
+          dest_y, crop_w, crop_h);
+
     /* Frame */
     video_box->copy (i_alpha, out, video_box->out_sdtv, dest_x, dest_y,
         in, video_box->in_sdtv, src_x, src_y, crop_w, crop_h);
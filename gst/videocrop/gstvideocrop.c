@@ -40,10 +40,19 @@
  * #GstVideoCrop:top property is set to an odd number. This doesn't matter for
  * most use cases, but it might matter for yours.
  *
+ * With #GstVideoCrop:tile-columns and #GstVideoCrop:tile-rows the cropped
+ * picture is split into tiles of equal size, and every tile is pushed as
+ * its own frame. If downstream supports crop meta, the tiles share the
+ * memory of the input frame. Otherwise they are all copied in one go, which
+ * #GstVideoCrop:n-threads can spread over several threads.
+ *
  * ## Example launch line
  * |[
  * gst-launch-1.0 -v videotestsrc ! videocrop top=42 left=1 right=4 bottom=0 ! ximagesink
  * ]|
+ * |[
+ * gst-launch-1.0 -v videotestsrc ! video/x-raw,width=1280,height=720 ! videocrop tile-columns=4 tile-rows=4 n-threads=0 ! fakesink
+ * ]| This pipeline outputs 16 frames of 320x180 for every input frame.
  *
  */
 
@@ -76,9 +85,16 @@ enum
   PROP_LEFT,
   PROP_RIGHT,
   PROP_TOP,
-  PROP_BOTTOM
+  PROP_BOTTOM,
+  PROP_TILE_COLUMNS,
+  PROP_TILE_ROWS,
+  PROP_N_THREADS
 };
 
+#define DEFAULT_TILE_COLUMNS 1
+#define DEFAULT_TILE_ROWS 1
+#define DEFAULT_N_THREADS 1
+
 static GstStaticPadTemplate src_template = GST_STATIC_PAD_TEMPLATE ("src",
     GST_PAD_SRC,
     GST_PAD_ALWAYS,
@@ -96,6 +112,7 @@ G_DEFINE_TYPE (GstVideoCrop, gst_video_crop, GST_TYPE_VIDEO_FILTER);
 GST_ELEMENT_REGISTER_DEFINE (videocrop, "videocrop", GST_RANK_NONE,
     GST_TYPE_VIDEO_CROP);
 
+static void gst_video_crop_finalize (GObject * object);
 static void gst_video_crop_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec);
 static void gst_video_crop_get_property (GObject * object, guint prop_id,
@@ -119,6 +136,9 @@ static gboolean gst_video_crop_propose_allocation (GstBaseTransform * trans,
     GstQuery * decide_query, GstQuery * query);
 static GstFlowReturn gst_video_crop_transform_ip (GstBaseTransform * trans,
     GstBuffer * buf);
+static GstFlowReturn gst_video_crop_generate_output (GstBaseTransform * trans,
+    GstBuffer ** outbuf);
+static gboolean gst_video_crop_stop (GstBaseTransform * trans);
 
 static gboolean
 gst_video_crop_src_event (GstBaseTransform * trans, GstEvent * event)
@@ -164,6 +184,7 @@ gst_video_crop_class_init (GstVideoCropClass * klass)
   basetransform_class = (GstBaseTransformClass *) klass;
   vfilter_class = (GstVideoFilterClass *) klass;
 
+  gobject_class->finalize = gst_video_crop_finalize;
   gobject_class->set_property = gst_video_crop_set_property;
   gobject_class->get_property = gst_video_crop_get_property;
 
@@ -188,6 +209,52 @@ gst_video_crop_class_init (GstVideoCropClass * klass)
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
           GST_PARAM_MUTABLE_PLAYING | GST_PARAM_CONTROLLABLE));
 
+  /**
+   * GstVideoCrop:tile-columns:
+   *
+   * Number of columns the cropped picture is split into. Each input frame
+   * gives one output frame per tile, in raster order and with the
+   * timestamps of the input frame. Pixels that don't fill a whole tile on
+   * the right are dropped.
+   *
+   * Since: 1.24
+   */
+  g_object_class_install_property (gobject_class, PROP_TILE_COLUMNS,
+      g_param_spec_int ("tile-columns", "Tile columns",
+          "Number of columns of tiles to split the cropped picture into", 1,
+          G_MAXINT, DEFAULT_TILE_COLUMNS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_PLAYING));
+
+  /**
+   * GstVideoCrop:tile-rows:
+   *
+   * Number of rows the cropped picture is split into, see
+   * #GstVideoCrop:tile-columns.
+   *
+   * Since: 1.24
+   */
+  g_object_class_install_property (gobject_class, PROP_TILE_ROWS,
+      g_param_spec_int ("tile-rows", "Tile rows",
+          "Number of rows of tiles to split the cropped picture into", 1,
+          G_MAXINT, DEFAULT_TILE_ROWS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_PLAYING));
+
+  /**
+   * GstVideoCrop:n-threads:
+   *
+   * Maximum number of threads used to copy the cropped picture when
+   * downstream doesn't support crop meta. 0 uses one thread per CPU.
+   *
+   * Since: 1.24
+   */
+  g_object_class_install_property (gobject_class, PROP_N_THREADS,
+      g_param_spec_uint ("n-threads", "Threads",
+          "Maximum number of threads to use (0 = number of CPUs)", 0,
+          G_MAXINT, DEFAULT_N_THREADS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_add_static_pad_template (element_class, &sink_template);
   gst_element_class_add_static_pad_template (element_class, &src_template);
   gst_element_class_set_static_metadata (element_class, "Crop",
@@ -207,6 +274,9 @@ gst_video_crop_class_init (GstVideoCropClass * klass)
       GST_DEBUG_FUNCPTR (gst_video_crop_propose_allocation);
   basetransform_class->transform_ip =
       GST_DEBUG_FUNCPTR (gst_video_crop_transform_ip);
+  basetransform_class->generate_output =
+      GST_DEBUG_FUNCPTR (gst_video_crop_generate_output);
+  basetransform_class->stop = GST_DEBUG_FUNCPTR (gst_video_crop_stop);
 
   vfilter_class->set_info = GST_DEBUG_FUNCPTR (gst_video_crop_set_info);
   vfilter_class->transform_frame =
@@ -222,20 +292,43 @@ gst_video_crop_init (GstVideoCrop * vcrop)
   vcrop->crop_left = 0;
   vcrop->crop_top = 0;
   vcrop->crop_bottom = 0;
+  vcrop->prop_tile_columns = DEFAULT_TILE_COLUMNS;
+  vcrop->prop_tile_rows = DEFAULT_TILE_ROWS;
+  vcrop->tile_columns = DEFAULT_TILE_COLUMNS;
+  vcrop->tile_rows = DEFAULT_TILE_ROWS;
+  vcrop->n_threads = DEFAULT_N_THREADS;
+
+  g_queue_init (&vcrop->tiles);
+  gst_video_bands_init (&vcrop->bands);
 }
 
+static void
+gst_video_crop_finalize (GObject * object)
+{
+  GstVideoCrop *vcrop = GST_VIDEO_CROP (object);
+
+  g_queue_clear_full (&vcrop->tiles, (GDestroyNotify) gst_buffer_unref);
+  gst_video_bands_clear (&vcrop->bands);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+/* The copy functions copy the rows @out_y to @out_y + @out_height of
+ * @out_frame. @x and @y are added to the crop position. */
 static void
 gst_video_crop_transform_packed_yvyu (GstVideoCrop * vcrop,
-    GstVideoFrame * in_frame, GstVideoFrame * out_frame, gint x, gint y)
+    GstVideoFrame * in_frame, GstVideoFrame * out_frame, gint x, gint y,
+    gint out_y, gint out_height)
 {
   guint8 *in_data, *out_data;
   guint i, dx;
-  gint width, height;
+  gint width;
   gint in_stride;
   gint out_stride;
+  gint crop_left;
 
   width = GST_VIDEO_FRAME_WIDTH (out_frame);
-  height = GST_VIDEO_FRAME_HEIGHT (out_frame);
+  crop_left = vcrop->crop_left + x;
 
   in_data = GST_VIDEO_FRAME_PLANE_DATA (in_frame, 0);
   out_data = GST_VIDEO_FRAME_PLANE_DATA (out_frame, 0);
@@ -243,19 +336,20 @@ gst_video_crop_transform_packed_yvyu (GstVideoCrop * vcrop,
   in_stride = GST_VIDEO_FRAME_PLANE_STRIDE (in_frame, 0);
   out_stride = GST_VIDEO_FRAME_PLANE_STRIDE (out_frame, 0);
 
-  in_data += vcrop->crop_top * in_stride;
+  in_data += (vcrop->crop_top + y + out_y) * in_stride;
+  out_data += out_y * out_stride;
 
   /* rounding down here so we end up at the start of a macro-pixel and not
    * in the middle of one */
-  in_data += GST_ROUND_DOWN_2 (vcrop->crop_left) *
+  in_data += GST_ROUND_DOWN_2 (crop_left) *
       GST_VIDEO_FRAME_COMP_PSTRIDE (in_frame, 0);
 
   dx = width * GST_VIDEO_FRAME_COMP_PSTRIDE (out_frame, 0);
 
   /* UYVY = 4:2:2 - [U0 Y0 V0 Y1] [U2 Y2 V2 Y3] [U4 Y4 V4 Y5]
    * YUYV = 4:2:2 - [Y0 U0 Y1 V0] [Y2 U2 Y3 V2] [Y4 U4 Y5 V4] = YUY2 */
-  if ((vcrop->crop_left % 2) != 0) {
-    for (i = 0; i < height; ++i) {
+  if ((crop_left % 2) != 0) {
+    for (i = 0; i < out_height; ++i) {
       gint j;
 
       memcpy (out_data, in_data, dx);
@@ -269,7 +363,7 @@ gst_video_crop_transform_packed_yvyu (GstVideoCrop * vcrop,
       out_data += out_stride;
     }
   } else {
-    for (i = 0; i < height; ++i) {
+    for (i = 0; i < out_height; ++i) {
       memcpy (out_data, in_data, dx);
       in_data += in_stride;
       out_data += out_stride;
@@ -279,16 +373,16 @@ gst_video_crop_transform_packed_yvyu (GstVideoCrop * vcrop,
 
 static void
 gst_video_crop_transform_packed_v210 (GstVideoCrop * vcrop,
-    GstVideoFrame * in_frame, GstVideoFrame * out_frame, gint x, gint y)
+    GstVideoFrame * in_frame, GstVideoFrame * out_frame, gint x, gint y,
+    gint out_y, gint out_height)
 {
   guint8 *in_data, *out_data;
   guint i, dx;
-  gint width, height;
+  gint width;
   gint in_stride;
   gint out_stride;
 
   width = GST_VIDEO_FRAME_WIDTH (out_frame);
-  height = GST_VIDEO_FRAME_HEIGHT (out_frame);
 
   in_data = GST_VIDEO_FRAME_PLANE_DATA (in_frame, 0);
   out_data = GST_VIDEO_FRAME_PLANE_DATA (out_frame, 0);
@@ -296,16 +390,17 @@ gst_video_crop_transform_packed_v210 (GstVideoCrop * vcrop,
   in_stride = GST_VIDEO_FRAME_PLANE_STRIDE (in_frame, 0);
   out_stride = GST_VIDEO_FRAME_PLANE_STRIDE (out_frame, 0);
 
-  in_data += vcrop->crop_top * in_stride;
+  in_data += (vcrop->crop_top + y + out_y) * in_stride;
+  out_data += out_y * out_stride;
 
   /* rounding down here so we end up at the start of a macro-pixel and not
    * in the middle of one */
-  in_data += (vcrop->crop_left / 6) * 16;
+  in_data += ((vcrop->crop_left + x) / 6) * 16;
 
   /* copy a whole set of macro-pixels */
   dx = ((width + 5) / 6) * 16;
 
-  for (i = 0; i < height; ++i) {
+  for (i = 0; i < out_height; ++i) {
     memcpy (out_data, in_data, dx);
     in_data += in_stride;
     out_data += out_stride;
@@ -314,15 +409,15 @@ gst_video_crop_transform_packed_v210 (GstVideoCrop * vcrop,
 
 static void
 gst_video_crop_transform_packed_simple (GstVideoCrop * vcrop,
-    GstVideoFrame * in_frame, GstVideoFrame * out_frame, gint x, gint y)
+    GstVideoFrame * in_frame, GstVideoFrame * out_frame, gint x, gint y,
+    gint out_y, gint out_height)
 {
   guint8 *in_data, *out_data;
-  gint width, height;
+  gint width;
   guint i, dx;
   gint in_stride, out_stride;
 
   width = GST_VIDEO_FRAME_WIDTH (out_frame);
-  height = GST_VIDEO_FRAME_HEIGHT (out_frame);
 
   in_data = GST_VIDEO_FRAME_PLANE_DATA (in_frame, 0);
   out_data = GST_VIDEO_FRAME_PLANE_DATA (out_frame, 0);
@@ -330,13 +425,14 @@ gst_video_crop_transform_packed_simple (GstVideoCrop * vcrop,
   in_stride = GST_VIDEO_FRAME_PLANE_STRIDE (in_frame, 0);
   out_stride = GST_VIDEO_FRAME_PLANE_STRIDE (out_frame, 0);
 
-  in_data += (vcrop->crop_top + y) * in_stride;
+  in_data += (vcrop->crop_top + y + out_y) * in_stride;
   in_data +=
       (vcrop->crop_left + x) * GST_VIDEO_FRAME_COMP_PSTRIDE (in_frame, 0);
+  out_data += out_y * out_stride;
 
   dx = width * GST_VIDEO_FRAME_COMP_PSTRIDE (out_frame, 0);
 
-  for (i = 0; i < height; ++i) {
+  for (i = 0; i < out_height; ++i) {
     memcpy (out_data, in_data, dx);
     in_data += in_stride;
     out_data += out_stride;
@@ -345,7 +441,8 @@ gst_video_crop_transform_packed_simple (GstVideoCrop * vcrop,
 
 static void
 gst_video_crop_transform_planar (GstVideoCrop * vcrop,
-    GstVideoFrame * in_frame, GstVideoFrame * out_frame, gint x, gint y)
+    GstVideoFrame * in_frame, GstVideoFrame * out_frame, gint x, gint y,
+    gint out_y, gint out_height)
 {
   const GstVideoFormatInfo *format_info;
   gint crop_top, crop_left;
@@ -360,7 +457,7 @@ gst_video_crop_transform_planar (GstVideoCrop * vcrop,
     guint sub_w_factor, sub_h_factor;
     guint subsampled_crop_left, subsampled_crop_top;
     guint copy_width;
-    gint i;
+    gint i, first, last;
     gsize bytes_per_pixel;
 
     /* plane */
@@ -381,16 +478,23 @@ gst_video_crop_transform_planar (GstVideoCrop * vcrop,
     subsampled_crop_left = GST_ROUND_DOWN_N ((guint) crop_left, sub_w_factor);
     subsampled_crop_top = GST_ROUND_DOWN_N ((guint) crop_top, sub_h_factor);
 
+    /* the subsampled rows of a range of rows. Rounding up on both ends
+     * gives every subsampled row to exactly one range. */
+    first = GST_VIDEO_FORMAT_INFO_SCALE_HEIGHT (format_info, p, out_y);
+    last = GST_VIDEO_FORMAT_INFO_SCALE_HEIGHT (format_info, p,
+        out_y + out_height);
+
     plane_in +=
-        GST_VIDEO_FORMAT_INFO_SCALE_HEIGHT (format_info, p,
-        subsampled_crop_top) * GST_VIDEO_FRAME_PLANE_STRIDE (in_frame, p);
+        (GST_VIDEO_FORMAT_INFO_SCALE_HEIGHT (format_info, p,
+            subsampled_crop_top) + first) *
+        GST_VIDEO_FRAME_PLANE_STRIDE (in_frame, p);
     plane_in +=
         GST_VIDEO_FORMAT_INFO_SCALE_WIDTH (format_info, p,
         subsampled_crop_left) * bytes_per_pixel;
+    plane_out += first * GST_VIDEO_FRAME_PLANE_STRIDE (out_frame, p);
     copy_width = GST_VIDEO_FRAME_COMP_WIDTH (out_frame, p) * bytes_per_pixel;
 
-
-    for (i = 0; i < GST_VIDEO_FRAME_COMP_HEIGHT (out_frame, p); ++i) {
+    for (i = first; i < last; ++i) {
       memcpy (plane_out, plane_in, copy_width);
       plane_in += GST_VIDEO_FRAME_PLANE_STRIDE (in_frame, p);
       plane_out += GST_VIDEO_FRAME_PLANE_STRIDE (out_frame, p);
@@ -400,16 +504,16 @@ gst_video_crop_transform_planar (GstVideoCrop * vcrop,
 
 static void
 gst_video_crop_transform_semi_planar (GstVideoCrop * vcrop,
-    GstVideoFrame * in_frame, GstVideoFrame * out_frame, gint x, gint y)
+    GstVideoFrame * in_frame, GstVideoFrame * out_frame, gint x, gint y,
+    gint out_y, gint out_height)
 {
-  gint width, height;
+  gint width;
   gint crop_top, crop_left;
   guint8 *y_out, *uv_out;
   guint8 *y_in, *uv_in;
-  guint i, dx;
+  guint i, dx, first, last;
 
   width = GST_VIDEO_FRAME_WIDTH (out_frame);
-  height = GST_VIDEO_FRAME_HEIGHT (out_frame);
   crop_left = vcrop->crop_left + x;
   crop_top = vcrop->crop_top + y;
 
@@ -421,33 +525,117 @@ gst_video_crop_transform_semi_planar (GstVideoCrop * vcrop,
   uv_in = GST_VIDEO_FRAME_PLANE_DATA (in_frame, 1);
   uv_out = GST_VIDEO_FRAME_PLANE_DATA (out_frame, 1);
 
-  y_in += crop_top * GST_VIDEO_FRAME_PLANE_STRIDE (in_frame, 0) + crop_left;
+  y_in += (crop_top + out_y) * GST_VIDEO_FRAME_PLANE_STRIDE (in_frame, 0) +
+      crop_left;
+  y_out += out_y * GST_VIDEO_FRAME_PLANE_STRIDE (out_frame, 0);
   dx = width;
 
-  for (i = 0; i < height; ++i) {
+  for (i = 0; i < out_height; ++i) {
     memcpy (y_out, y_in, dx);
     y_in += GST_VIDEO_FRAME_PLANE_STRIDE (in_frame, 0);
     y_out += GST_VIDEO_FRAME_PLANE_STRIDE (out_frame, 0);
   }
 
-  uv_in += (crop_top / 2) * GST_VIDEO_FRAME_PLANE_STRIDE (in_frame, 1);
+  /* as for the planar formats, round up on both ends of the range */
+  first = GST_ROUND_UP_2 (out_y) / 2;
+  last = GST_ROUND_UP_2 (out_y + out_height) / 2;
+
+  uv_in += (crop_top / 2 + first) * GST_VIDEO_FRAME_PLANE_STRIDE (in_frame, 1);
   uv_in += GST_ROUND_DOWN_2 (crop_left);
+  uv_out += first * GST_VIDEO_FRAME_PLANE_STRIDE (out_frame, 1);
   dx = GST_ROUND_UP_2 (width);
 
-  for (i = 0; i < GST_ROUND_UP_2 (height) / 2; i++) {
+  for (i = first; i < last; i++) {
     memcpy (uv_out, uv_in, dx);
     uv_in += GST_VIDEO_FRAME_PLANE_STRIDE (in_frame, 1);
     uv_out += GST_VIDEO_FRAME_PLANE_STRIDE (out_frame, 1);
   }
 }
 
+typedef struct
+{
+  GstVideoCrop *vcrop;
+  GstVideoFrame *in_frame;
+  /* one frame per tile, in raster order */
+  GstVideoFrame *out_frames;
+  /* position of the crop meta of the input */
+  gint x, y;
+} GstVideoCropJob;
+
+/* The rows of all tiles are counted one tile after the other, so that the
+ * tiles of a frame are split over the threads like the rows of one frame */
+static void
+gst_video_crop_transform_rows (GstVideoCropJob * job, gint row, gint height)
+{
+  GstVideoCrop *vcrop = job->vcrop;
+  gint tile_width = GST_VIDEO_INFO_WIDTH (&vcrop->out_info);
+  gint tile_height = GST_VIDEO_INFO_HEIGHT (&vcrop->out_info);
+
+  while (height > 0) {
+    gint tile = row / tile_height;
+    gint out_y = row % tile_height;
+    gint out_height = MIN (height, tile_height - out_y);
+    GstVideoFrame *out_frame = &job->out_frames[tile];
+    gint x = job->x + (tile % vcrop->tile_columns) * tile_width;
+    gint y = job->y + (tile / vcrop->tile_columns) * tile_height;
+
+    switch (vcrop->packing) {
+      case VIDEO_CROP_PIXEL_FORMAT_PACKED_SIMPLE:
+        gst_video_crop_transform_packed_simple (vcrop, job->in_frame,
+            out_frame, x, y, out_y, out_height);
+        break;
+      case VIDEO_CROP_PIXEL_FORMAT_PACKED_YVYU:
+        gst_video_crop_transform_packed_yvyu (vcrop, job->in_frame, out_frame,
+            x, y, out_y, out_height);
+        break;
+      case VIDEO_CROP_PIXEL_FORMAT_PACKED_v210:
+        gst_video_crop_transform_packed_v210 (vcrop, job->in_frame, out_frame,
+            x, y, out_y, out_height);
+        break;
+      case VIDEO_CROP_PIXEL_FORMAT_PLANAR:
+        gst_video_crop_transform_planar (vcrop, job->in_frame, out_frame, x,
+            y, out_y, out_height);
+        break;
+      case VIDEO_CROP_PIXEL_FORMAT_SEMI_PLANAR:
+        gst_video_crop_transform_semi_planar (vcrop, job->in_frame, out_frame,
+            x, y, out_y, out_height);
+        break;
+      default:
+        g_assert_not_reached ();
+    }
+
+    row += out_height;
+    height -= out_height;
+  }
+}
+
+static void
+gst_video_crop_transform_tiles (GstVideoCrop * vcrop, GstVideoFrame * in_frame,
+    GstVideoFrame * out_frames, guint n_tiles)
+{
+  GstVideoCropMeta *meta = gst_buffer_get_video_crop_meta (in_frame->buffer);
+  GstVideoCropJob job = { vcrop, in_frame, out_frames, 0, 0 };
+  guint n_threads;
+
+  if (meta) {
+    job.x = meta->x;
+    job.y = meta->y;
+  }
+
+  GST_OBJECT_LOCK (vcrop);
+  n_threads = vcrop->n_threads;
+  GST_OBJECT_UNLOCK (vcrop);
+
+  gst_video_bands_process_rows (&vcrop->bands, n_threads,
+      n_tiles * GST_VIDEO_INFO_HEIGHT (&vcrop->out_info), 1,
+      (GstVideoBandsRowsFunc) gst_video_crop_transform_rows, &job);
+}
+
 static GstFlowReturn
 gst_video_crop_transform_frame (GstVideoFilter * vfilter,
     GstVideoFrame * in_frame, GstVideoFrame * out_frame)
 {
   GstVideoCrop *vcrop = GST_VIDEO_CROP (vfilter);
-  GstVideoCropMeta *meta = gst_buffer_get_video_crop_meta (in_frame->buffer);
-  gint x = 0, y = 0;
 
   if (G_UNLIKELY (vcrop->need_update)) {
     if (!gst_video_crop_set_info (vfilter, NULL, &vcrop->in_info, NULL,
@@ -456,32 +644,167 @@ gst_video_crop_transform_frame (GstVideoFilter * vfilter,
     }
   }
 
-  if (meta) {
-    x = meta->x;
-    y = meta->y;
+  gst_video_crop_transform_tiles (vcrop, in_frame, out_frame, 1);
+
+  return GST_FLOW_OK;
+}
+
+/* in tile mode every input buffer gives one output buffer per tile. They
+ * are made all at once and then handed out one by one. */
+static GstFlowReturn
+gst_video_crop_make_tiles (GstVideoCrop * vcrop, GstBuffer * inbuf)
+{
+  GstBaseTransform *trans = GST_BASE_TRANSFORM (vcrop);
+  GstVideoFrame in_frame, *out_frames;
+  GstFlowReturn ret = GST_FLOW_OK;
+  gint tile_width, tile_height;
+  guint n_tiles, i;
+
+  n_tiles = vcrop->tile_columns * vcrop->tile_rows;
+  tile_width = GST_VIDEO_INFO_WIDTH (&vcrop->out_info);
+  tile_height = GST_VIDEO_INFO_HEIGHT (&vcrop->out_info);
+
+  if (vcrop->use_crop_meta) {
+    /* the tiles share the memory of the input */
+    for (i = 0; i < n_tiles; i++) {
+      GstBuffer *tile = gst_buffer_copy (inbuf);
+      GstVideoCropMeta *crop_meta;
+
+      if (!gst_buffer_get_video_meta (tile)) {
+        gst_buffer_add_video_meta (tile, GST_VIDEO_FRAME_FLAG_NONE,
+            GST_VIDEO_INFO_FORMAT (&vcrop->in_info), vcrop->in_info.width,
+            vcrop->in_info.height);
+      }
+
+      crop_meta = gst_buffer_get_video_crop_meta (tile);
+      if (!crop_meta)
+        crop_meta = gst_buffer_add_video_crop_meta (tile);
+
+      crop_meta->x += vcrop->crop_left + (i % vcrop->tile_columns) * tile_width;
+      crop_meta->y += vcrop->crop_top + (i / vcrop->tile_columns) * tile_height;
+      crop_meta->width = tile_width;
+      crop_meta->height = tile_height;
+
+      g_queue_push_tail (&vcrop->tiles, tile);
+    }
+
+    return GST_FLOW_OK;
   }
 
-  switch (vcrop->packing) {
-    case VIDEO_CROP_PIXEL_FORMAT_PACKED_SIMPLE:
-      gst_video_crop_transform_packed_simple (vcrop, in_frame, out_frame, x, y);
-      break;
-    case VIDEO_CROP_PIXEL_FORMAT_PACKED_YVYU:
-      gst_video_crop_transform_packed_yvyu (vcrop, in_frame, out_frame, x, y);
-      break;
-    case VIDEO_CROP_PIXEL_FORMAT_PACKED_v210:
-      gst_video_crop_transform_packed_v210 (vcrop, in_frame, out_frame, x, y);
-      break;
-    case VIDEO_CROP_PIXEL_FORMAT_PLANAR:
-      gst_video_crop_transform_planar (vcrop, in_frame, out_frame, x, y);
+  if (GST_BUFFER_FLAG_IS_SET (inbuf, GST_BUFFER_FLAG_GAP)) {
+    /* there is nothing to crop in a gap, it gives tiles that are gaps too */
+    for (i = 0; i < n_tiles; i++) {
+      GstBuffer *tile = NULL;
+
+      ret = GST_BASE_TRANSFORM_CLASS (parent_class)->prepare_output_buffer
+          (trans, inbuf, &tile);
+      if (ret != GST_FLOW_OK) {
+        g_queue_clear_full (&vcrop->tiles, (GDestroyNotify) gst_buffer_unref);
+        return ret;
+      }
+
+      GST_BUFFER_FLAG_SET (tile, GST_BUFFER_FLAG_GAP);
+      g_queue_push_tail (&vcrop->tiles, tile);
+    }
+
+    return GST_FLOW_OK;
+  }
+
+  if (!gst_video_frame_map (&in_frame, &vcrop->in_info, inbuf, GST_MAP_READ))
+    goto invalid_buffer;
+
+  out_frames = g_new0 (GstVideoFrame, n_tiles);
+  for (i = 0; i < n_tiles; i++) {
+    GstBuffer *tile = NULL;
+
+    ret = GST_BASE_TRANSFORM_CLASS (parent_class)->prepare_output_buffer (trans,
+        inbuf, &tile);
+    if (ret != GST_FLOW_OK)
       break;
-    case VIDEO_CROP_PIXEL_FORMAT_SEMI_PLANAR:
-      gst_video_crop_transform_semi_planar (vcrop, in_frame, out_frame, x, y);
+
+    if (!gst_video_frame_map (&out_frames[i], &vcrop->out_info, tile,
+            GST_MAP_WRITE)) {
+      gst_buffer_unref (tile);
+      GST_ELEMENT_ERROR (vcrop, CORE, NOT_IMPLEMENTED, (NULL),
+          ("invalid video buffer received"));
+      ret = GST_FLOW_ERROR;
       break;
-    default:
-      g_assert_not_reached ();
+    }
   }
 
-  return GST_FLOW_OK;
+  if (ret == GST_FLOW_OK)
+    gst_video_crop_transform_tiles (vcrop, &in_frame, out_frames, n_tiles);
+
+  for (i = 0; i < n_tiles && out_frames[i].buffer; i++) {
+    GstBuffer *tile = out_frames[i].buffer;
+
+    gst_video_frame_unmap (&out_frames[i]);
+    if (ret == GST_FLOW_OK)
+      g_queue_push_tail (&vcrop->tiles, tile);
+    else
+      gst_buffer_unref (tile);
+  }
+  g_free (out_frames);
+  gst_video_frame_unmap (&in_frame);
+
+  return ret;
+
+  /* ERRORS */
+invalid_buffer:
+  {
+    GST_ELEMENT_ERROR (vcrop, CORE, NOT_IMPLEMENTED, (NULL),
+        ("invalid video buffer received"));
+    return GST_FLOW_ERROR;
+  }
+}
+
+static GstFlowReturn
+gst_video_crop_generate_output (GstBaseTransform * trans, GstBuffer ** outbuf)
+{
+  GstBaseTransformClass *bclass = GST_BASE_TRANSFORM_GET_CLASS (trans);
+  GstVideoCrop *vcrop = GST_VIDEO_CROP (trans);
+  GstVideoFilter *vfilter = GST_VIDEO_FILTER (trans);
+  GstFlowReturn ret = GST_FLOW_OK;
+  GstBuffer *inbuf;
+
+  if (vcrop->tile_columns * vcrop->tile_rows == 1
+      && g_queue_is_empty (&vcrop->tiles))
+    return GST_BASE_TRANSFORM_CLASS (parent_class)->generate_output (trans,
+        outbuf);
+
+  inbuf = trans->queued_buf;
+  trans->queued_buf = NULL;
+
+  if (inbuf) {
+    /* tiles left over from a failed push are dropped */
+    g_queue_clear_full (&vcrop->tiles, (GDestroyNotify) gst_buffer_unref);
+
+    if (G_UNLIKELY (!vfilter->negotiated)) {
+      gst_buffer_unref (inbuf);
+      GST_ELEMENT_ERROR (vcrop, CORE, NEGOTIATION, (NULL), ("not negotiated"));
+      return GST_FLOW_NOT_NEGOTIATED;
+    }
+
+    /* as the default generate_output does, this syncs the controlled
+     * properties to the input, so it has to come before the update */
+    if (bclass->before_transform)
+      bclass->before_transform (trans, inbuf);
+
+    if (G_UNLIKELY (vcrop->need_update)) {
+      if (!gst_video_crop_set_info (vfilter, NULL, &vcrop->in_info, NULL,
+              &vcrop->out_info)) {
+        gst_buffer_unref (inbuf);
+        return GST_FLOW_ERROR;
+      }
+    }
+
+    ret = gst_video_crop_make_tiles (vcrop, inbuf);
+    gst_buffer_unref (inbuf);
+  }
+
+  *outbuf = g_queue_pop_head (&vcrop->tiles);
+
+  return ret;
 }
 
 static gboolean
@@ -494,8 +817,10 @@ gst_video_crop_decide_allocation (GstBaseTransform * trans, GstQuery * query)
           GST_VIDEO_CROP_META_API_TYPE, NULL) &&
       gst_query_find_allocation_meta (query, GST_VIDEO_META_API_TYPE, NULL));
 
+  crop->use_crop_meta = use_crop_meta;
+
   if ((crop->crop_left | crop->crop_right | crop->crop_top | crop->
-          crop_bottom) == 0) {
+          crop_bottom) == 0 && crop->tile_columns * crop->tile_rows == 1) {
     GST_INFO_OBJECT (crop, "we are using passthrough");
     gst_base_transform_set_passthrough (GST_BASE_TRANSFORM (crop), TRUE);
     gst_base_transform_set_in_place (GST_BASE_TRANSFORM (crop), FALSE);
@@ -513,6 +838,21 @@ gst_video_crop_decide_allocation (GstBaseTransform * trans, GstQuery * query)
     return FALSE;
   }
 
+  if (crop->tile_columns * crop->tile_rows > 1 && !use_crop_meta &&
+      gst_query_get_n_allocation_pools (query) > 0) {
+    GstBufferPool *pool;
+    guint size, min, max;
+
+    /* all tiles of a frame are copied before the first one is pushed */
+    gst_query_parse_nth_allocation_pool (query, 0, &pool, &size, &min, &max);
+    min = MAX (min, crop->tile_columns * crop->tile_rows);
+    if (max != 0 && max < min)
+      max = min;
+    gst_query_set_nth_allocation_pool (query, 0, pool, size, min, max);
+    if (pool)
+      gst_object_unref (pool);
+  }
+
   return GST_BASE_TRANSFORM_CLASS (parent_class)->decide_allocation (trans,
       query);
 }
@@ -549,6 +889,16 @@ gst_video_crop_before_transform (GstBaseTransform * trans, GstBuffer * in)
     gst_object_sync_values (GST_OBJECT (video_crop), stream_time);
 }
 
+static gboolean
+gst_video_crop_stop (GstBaseTransform * trans)
+{
+  GstVideoCrop *vcrop = GST_VIDEO_CROP (trans);
+
+  g_queue_clear_full (&vcrop->tiles, (GDestroyNotify) gst_buffer_unref);
+
+  return TRUE;
+}
+
 static GstFlowReturn
 gst_video_crop_transform_ip (GstBaseTransform * trans, GstBuffer * buf)
 {
@@ -588,10 +938,17 @@ gst_video_crop_transform_ip (GstBaseTransform * trans, GstBuffer * buf)
   return GST_FLOW_OK;
 }
 
+/* the sink side is @tiles tiles of the src side plus the crop @delta */
 static gint
-gst_video_crop_transform_dimension (gint val, gint delta)
+gst_video_crop_transform_dimension (gint val, gint delta, gint tiles,
+    GstPadDirection direction)
 {
-  gint64 new_val = (gint64) val + (gint64) delta;
+  gint64 new_val;
+
+  if (direction == GST_PAD_SRC)
+    new_val = (gint64) val * tiles + (gint64) delta;
+  else
+    new_val = ((gint64) val + (gint64) delta) / tiles;
 
   new_val = CLAMP (new_val, 1, G_MAXINT);
 
@@ -600,13 +957,14 @@ gst_video_crop_transform_dimension (gint val, gint delta)
 
 static gboolean
 gst_video_crop_transform_dimension_value (const GValue * src_val,
-    gint delta, GValue * dest_val, GstPadDirection direction, gboolean dynamic)
+    gint delta, gint tiles, GValue * dest_val, GstPadDirection direction,
+    gboolean dynamic)
 {
   gboolean ret = TRUE;
 
   if (G_VALUE_HOLDS_INT (src_val)) {
     gint ival = g_value_get_int (src_val);
-    ival = gst_video_crop_transform_dimension (ival, delta);
+    ival = gst_video_crop_transform_dimension (ival, delta, tiles, direction);
 
     if (dynamic) {
       if (direction == GST_PAD_SRC) {
@@ -634,8 +992,8 @@ gst_video_crop_transform_dimension_value (const GValue * src_val,
     gint min = gst_value_get_int_range_min (src_val);
     gint max = gst_value_get_int_range_max (src_val);
 
-    min = gst_video_crop_transform_dimension (min, delta);
-    max = gst_video_crop_transform_dimension (max, delta);
+    min = gst_video_crop_transform_dimension (min, delta, tiles, direction);
+    max = gst_video_crop_transform_dimension (max, delta, tiles, direction);
 
     if (dynamic) {
       if (direction == GST_PAD_SRC)
@@ -661,8 +1019,8 @@ gst_video_crop_transform_dimension_value (const GValue * src_val,
       GValue newval = G_VALUE_INIT;
 
       list_val = gst_value_list_get_value (src_val, i);
-      if (gst_video_crop_transform_dimension_value (list_val, delta, &newval,
-              direction, dynamic))
+      if (gst_video_crop_transform_dimension_value (list_val, delta, tiles,
+              &newval, direction, dynamic))
         gst_value_list_append_value (dest_val, &newval);
       g_value_unset (&newval);
     }
@@ -684,7 +1042,7 @@ gst_video_crop_transform_caps (GstBaseTransform * trans,
 {
   GstVideoCrop *vcrop;
   GstCaps *other_caps;
-  gint dy, dx, i, left, right, bottom, top;
+  gint dy, dx, i, left, right, bottom, top, columns, rows;
   gboolean w_dynamic, h_dynamic;
 
   vcrop = GST_VIDEO_CROP (trans);
@@ -701,6 +1059,8 @@ gst_video_crop_transform_caps (GstBaseTransform * trans,
   right = (vcrop->prop_right == -1) ? 0 : vcrop->prop_right;
   bottom = (vcrop->prop_bottom == -1) ? 0 : vcrop->prop_bottom;
   top = (vcrop->prop_top == -1) ? 0 : vcrop->prop_top;
+  columns = vcrop->prop_tile_columns;
+  rows = vcrop->prop_tile_rows;
 
   GST_OBJECT_UNLOCK (vcrop);
 
@@ -726,16 +1086,16 @@ gst_video_crop_transform_caps (GstBaseTransform * trans,
     features = gst_caps_get_features (caps, i);
 
     v = gst_structure_get_value (structure, "width");
-    if (!gst_video_crop_transform_dimension_value (v, dx, &w_val, direction,
-            w_dynamic)) {
+    if (!gst_video_crop_transform_dimension_value (v, dx, columns, &w_val,
+            direction, w_dynamic)) {
       GST_WARNING_OBJECT (vcrop, "could not transform width value with dx=%d"
           ", caps structure=%" GST_PTR_FORMAT, dx, structure);
       continue;
     }
 
     v = gst_structure_get_value (structure, "height");
-    if (!gst_video_crop_transform_dimension_value (v, dy, &h_val, direction,
-            h_dynamic)) {
+    if (!gst_video_crop_transform_dimension_value (v, dy, rows, &h_val,
+            direction, h_dynamic)) {
       g_value_unset (&w_val);
       GST_WARNING_OBJECT (vcrop, "could not transform height value with dy=%d"
           ", caps structure=%" GST_PTR_FORMAT, dy, structure);
@@ -780,10 +1140,14 @@ gst_video_crop_set_info (GstVideoFilter * vfilter, GstCaps * in,
   crop->crop_right = crop->prop_right;
   crop->crop_top = crop->prop_top;
   crop->crop_bottom = crop->prop_bottom;
+  crop->tile_columns = crop->prop_tile_columns;
+  crop->tile_rows = crop->prop_tile_rows;
   GST_OBJECT_UNLOCK (crop);
 
-  dx = GST_VIDEO_INFO_WIDTH (in_info) - GST_VIDEO_INFO_WIDTH (out_info);
-  dy = GST_VIDEO_INFO_HEIGHT (in_info) - GST_VIDEO_INFO_HEIGHT (out_info);
+  dx = GST_VIDEO_INFO_WIDTH (in_info) -
+      GST_VIDEO_INFO_WIDTH (out_info) * crop->tile_columns;
+  dy = GST_VIDEO_INFO_HEIGHT (in_info) -
+      GST_VIDEO_INFO_HEIGHT (out_info) * crop->tile_rows;
 
   if (crop->crop_left == -1 && crop->crop_right == -1) {
     crop->crop_left = dx / 2;
@@ -817,6 +1181,11 @@ gst_video_crop_set_info (GstVideoFilter * vfilter, GstCaps * in,
           GST_VIDEO_INFO_HEIGHT (in_info)))
     goto cropping_too_much;
 
+  if (crop->tile_columns * crop->tile_rows > 1 &&
+      (G_UNLIKELY (dx < crop->crop_left + crop->crop_right
+              || dy < crop->crop_top + crop->crop_bottom)))
+    goto cropping_too_much;
+
   if (in && out)
     GST_LOG_OBJECT (crop, "incaps = %" GST_PTR_FORMAT ", outcaps = %"
         GST_PTR_FORMAT, in, out);
@@ -969,6 +1338,17 @@ gst_video_crop_set_property (GObject * object, guint prop_id,
       gst_video_crop_set_crop (video_crop, g_value_get_int (value),
           &video_crop->prop_bottom);
       break;
+    case PROP_TILE_COLUMNS:
+      gst_video_crop_set_crop (video_crop, g_value_get_int (value),
+          &video_crop->prop_tile_columns);
+      break;
+    case PROP_TILE_ROWS:
+      gst_video_crop_set_crop (video_crop, g_value_get_int (value),
+          &video_crop->prop_tile_rows);
+      break;
+    case PROP_N_THREADS:
+      video_crop->n_threads = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1004,6 +1384,15 @@ gst_video_crop_get_property (GObject * object, guint prop_id, GValue * value,
     case PROP_BOTTOM:
       g_value_set_int (value, video_crop->prop_bottom);
       break;
+    case PROP_TILE_COLUMNS:
+      g_value_set_int (value, video_crop->prop_tile_columns);
+      break;
+    case PROP_TILE_ROWS:
+      g_value_set_int (value, video_crop->prop_tile_rows);
+      break;
+    case PROP_N_THREADS:
+      g_value_set_uint (value, video_crop->n_threads);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -21,6 +21,7 @@
 #define __GST_VIDEO_CROP_H__
 
 #include <gst/video/gstvideofilter.h>
+#include <gst/video-bands-private.h>
 
 G_BEGIN_DECLS
 #define GST_TYPE_VIDEO_CROP \
@@ -70,6 +71,8 @@ struct _GstVideoCrop
   gint prop_right;
   gint prop_top;
   gint prop_bottom;
+  gint prop_tile_columns;
+  gint prop_tile_rows;
   gboolean need_update;
 
   GstVideoInfo in_info;
@@ -79,11 +82,20 @@ struct _GstVideoCrop
   gint crop_right;
   gint crop_top;
   gint crop_bottom;
+  gint tile_columns;
+  gint tile_rows;
 
   VideoCropPixelFormat packing;
   gint macro_y_off;
 
   gboolean raw_caps;
+  gboolean use_crop_meta;
+
+  /* tiles of the current input buffer that are still to be pushed */
+  GQueue tiles;
+
+  guint n_threads;
+  GstVideoBands bands;
 };
 
 struct _GstVideoCropClass
@@ -61,11 +61,23 @@ GST_DEBUG_CATEGORY_STATIC (gamma_debug);
 enum
 {
   PROP_0,
-  PROP_GAMMA
+  PROP_GAMMA,
+  PROP_N_THREADS
       /* FILL ME */
 };
 
 #define DEFAULT_PROP_GAMMA  1
+#define DEFAULT_PROP_N_THREADS  1
+
+#if G_BYTE_ORDER == G_LITTLE_ENDIAN
+#define HIGH_DEPTH_FORMATS \
+  "I420_10LE, I420_12LE, I422_10LE, I422_12LE, Y444_10LE, Y444_12LE, " \
+  "Y444_16LE, P010_10LE, P012_LE, P016_LE"
+#else
+#define HIGH_DEPTH_FORMATS \
+  "I420_10BE, I420_12BE, I422_10BE, I422_12BE, Y444_10BE, Y444_12BE, " \
+  "Y444_16BE, P010_10BE, P012_BE, P016_BE"
+#endif
 
 static GstStaticPadTemplate gst_gamma_src_template =
 GST_STATIC_PAD_TEMPLATE ("src",
@@ -74,7 +86,8 @@ GST_STATIC_PAD_TEMPLATE ("src",
     GST_STATIC_CAPS (GST_VIDEO_CAPS_MAKE ("{ AYUV, "
             "ARGB, BGRA, ABGR, RGBA, Y444, "
             "xRGB, RGBx, xBGR, BGRx, RGB, BGR, Y42B, NV12, "
-            "NV21, YUY2, UYVY, YVYU, I420, YV12, IYUV, Y41B }"))
+            "NV21, YUY2, UYVY, YVYU, I420, YV12, IYUV, Y41B, "
+            HIGH_DEPTH_FORMATS " }"))
     );
 
 static GstStaticPadTemplate gst_gamma_sink_template =
@@ -84,9 +97,11 @@ GST_STATIC_PAD_TEMPLATE ("sink",
     GST_STATIC_CAPS (GST_VIDEO_CAPS_MAKE ("{ AYUV, "
             "ARGB, BGRA, ABGR, RGBA, Y444, "
             "xRGB, RGBx, xBGR, BGRx, RGB, BGR, Y42B, NV12, "
-            "NV21, YUY2, UYVY, YVYU, I420, YV12, IYUV, Y41B }"))
+            "NV21, YUY2, UYVY, YVYU, I420, YV12, IYUV, Y41B, "
+            HIGH_DEPTH_FORMATS " }"))
     );
 
+static void gst_gamma_finalize (GObject * object);
 static void gst_gamma_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec);
 static void gst_gamma_get_property (GObject * object, guint prop_id,
@@ -114,6 +129,7 @@ gst_gamma_class_init (GstGammaClass * g_class)
 
   GST_DEBUG_CATEGORY_INIT (gamma_debug, "gamma", 0, "gamma");
 
+  gobject_class->finalize = gst_gamma_finalize;
   gobject_class->set_property = gst_gamma_set_property;
   gobject_class->get_property = gst_gamma_get_property;
 
@@ -122,6 +138,20 @@ gst_gamma_class_init (GstGammaClass * g_class)
           0.01, 10, DEFAULT_PROP_GAMMA,
           GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS | G_PARAM_READWRITE));
 
+  /**
+   * GstGamma:n-threads:
+   *
+   * Maximum number of threads used to process each frame, in bands of rows.
+   * 0 uses one thread per CPU.
+   *
+   * Since: 1.24
+   */
+  g_object_class_install_property (gobject_class, PROP_N_THREADS,
+      g_param_spec_uint ("n-threads", "Threads",
+          "Maximum number of threads to use (0 = number of CPUs)", 0,
+          G_MAXINT, DEFAULT_PROP_N_THREADS,
+          G_PARAM_STATIC_STRINGS | G_PARAM_READWRITE));
+
   gst_element_class_set_static_metadata (gstelement_class,
       "Video gamma correction", "Filter/Effect/Video",
       "Adjusts gamma on a video stream", "Arwed v. Merkatz <v.merkatz@gmx.net");
@@ -145,9 +175,23 @@ gst_gamma_init (GstGamma * gamma)
 {
   /* properties */
   gamma->gamma = DEFAULT_PROP_GAMMA;
+  gamma->n_threads = DEFAULT_PROP_N_THREADS;
+  gamma->depth = 8;
+  gst_video_bands_init (&gamma->bands);
   gst_gamma_calculate_tables (gamma);
 }
 
+static void
+gst_gamma_finalize (GObject * object)
+{
+  GstGamma *gamma = GST_GAMMA (object);
+
+  g_free (gamma->gamma_table16);
+  gst_video_bands_clear (&gamma->bands);
+
+  G_OBJECT_CLASS (gst_gamma_parent_class)->finalize (object);
+}
+
 static void
 gst_gamma_set_property (GObject * object, guint prop_id, const GValue * value,
     GParamSpec * pspec)
@@ -166,6 +210,11 @@ gst_gamma_set_property (GObject * object, guint prop_id, const GValue * value,
       gst_gamma_calculate_tables (gamma);
       break;
     }
+    case PROP_N_THREADS:
+      GST_OBJECT_LOCK (gamma);
+      gamma->n_threads = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (gamma);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -182,6 +231,9 @@ gst_gamma_get_property (GObject * object, guint prop_id, GValue * value,
     case PROP_GAMMA:
       g_value_set_double (value, gamma->gamma);
       break;
+    case PROP_N_THREADS:
+      g_value_set_uint (value, gamma->n_threads);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -207,6 +259,18 @@ gst_gamma_calculate_tables (GstGamma * gamma)
       val = 255.0 * val;
       gamma->gamma_table[n] = (guint8) floor (val + 0.5);
     }
+
+    /* pow() per pixel is far too slow, a table of 1 << depth entries still
+     * fits in the L2 cache for up to 16 bits */
+    if (gamma->depth > 8) {
+      gint max = (1 << gamma->depth) - 1;
+
+      gamma->gamma_table16 = g_renew (guint16, gamma->gamma_table16, max + 1);
+      for (n = 0; n <= max; n++) {
+        val = pow ((gdouble) n / max, exp);
+        gamma->gamma_table16[n] = (guint16) floor (max * val + 0.5);
+      }
+    }
   }
   GST_OBJECT_UNLOCK (gamma);
 
@@ -261,6 +325,29 @@ gst_gamma_packed_yuv_ip (GstGamma * gamma, GstVideoFrame * frame)
   }
 }
 
+/* luma of planar and semi-planar YUV with 16 bit containers */
+static void
+gst_gamma_yuv16_ip (GstGamma * gamma, GstVideoFrame * frame)
+{
+  gint i, j, height;
+  gint width, stride, shift;
+  const guint16 *table = gamma->gamma_table16;
+  guint8 *data;
+  guint16 *row;
+
+  data = GST_VIDEO_FRAME_COMP_DATA (frame, 0);
+  stride = GST_VIDEO_FRAME_COMP_STRIDE (frame, 0);
+  width = GST_VIDEO_FRAME_COMP_WIDTH (frame, 0);
+  height = GST_VIDEO_FRAME_COMP_HEIGHT (frame, 0);
+  shift = GST_VIDEO_FORMAT_INFO_SHIFT (frame->info.finfo, 0);
+
+  for (i = 0; i < height; i++) {
+    row = (guint16 *) (data + i * stride);
+    for (j = 0; j < width; j++)
+      row[j] = table[row[j] >> shift] << shift;
+  }
+}
+
 static const int cog_ycbcr_to_rgb_matrix_8bit_sdtv[] = {
   298, 0, 409, -57068,
   298, -100, -208, 34707,
@@ -361,10 +448,38 @@ gst_gamma_set_info (GstVideoFilter * vfilter, GstCaps * incaps,
     case GST_VIDEO_FORMAT_BGR:
       gamma->process = gst_gamma_packed_rgb_ip;
       break;
+    case GST_VIDEO_FORMAT_I420_10LE:
+    case GST_VIDEO_FORMAT_I420_10BE:
+    case GST_VIDEO_FORMAT_I420_12LE:
+    case GST_VIDEO_FORMAT_I420_12BE:
+    case GST_VIDEO_FORMAT_I422_10LE:
+    case GST_VIDEO_FORMAT_I422_10BE:
+    case GST_VIDEO_FORMAT_I422_12LE:
+    case GST_VIDEO_FORMAT_I422_12BE:
+    case GST_VIDEO_FORMAT_Y444_10LE:
+    case GST_VIDEO_FORMAT_Y444_10BE:
+    case GST_VIDEO_FORMAT_Y444_12LE:
+    case GST_VIDEO_FORMAT_Y444_12BE:
+    case GST_VIDEO_FORMAT_Y444_16LE:
+    case GST_VIDEO_FORMAT_Y444_16BE:
+    case GST_VIDEO_FORMAT_P010_10LE:
+    case GST_VIDEO_FORMAT_P010_10BE:
+    case GST_VIDEO_FORMAT_P012_LE:
+    case GST_VIDEO_FORMAT_P012_BE:
+    case GST_VIDEO_FORMAT_P016_LE:
+    case GST_VIDEO_FORMAT_P016_BE:
+      gamma->process = gst_gamma_yuv16_ip;
+      break;
     default:
       goto invalid_caps;
       break;
   }
+
+  GST_OBJECT_LOCK (gamma);
+  gamma->depth = GST_VIDEO_INFO_COMP_DEPTH (in_info, 0);
+  GST_OBJECT_UNLOCK (gamma);
+  gst_gamma_calculate_tables (gamma);
+
   return TRUE;
 
   /* ERRORS */
@@ -401,7 +516,8 @@ gst_gamma_transform_frame_ip (GstVideoFilter * vfilter, GstVideoFrame * frame)
     goto not_negotiated;
 
   GST_OBJECT_LOCK (gamma);
-  gamma->process (gamma, frame);
+  gst_video_bands_process (&gamma->bands, gamma->n_threads, frame,
+      (GstVideoBandsFunc) gamma->process, gamma);
   GST_OBJECT_UNLOCK (gamma);
 
   return GST_FLOW_OK;
@@ -28,6 +28,8 @@
 #include <gst/video/video.h>
 #include <gst/video/gstvideofilter.h>
 
+#include <gst/video-bands-private.h>
+
 G_BEGIN_DECLS
 
 #define GST_TYPE_GAMMA \
@@ -56,9 +58,17 @@ struct _GstGamma
   /* < private > */
   /* properties */
   gdouble gamma;
+  guint n_threads;
+
+  /* luma bit depth of the negotiated format */
+  gint depth;
 
   /* tables */
   guint8 gamma_table[256];
+  /* for formats with more than 8 bits, 1 << depth entries */
+  guint16 *gamma_table16;
+
+  GstVideoBands bands;
 
   void (*process) (GstGamma *gamma, GstVideoFrame *frame);
 };
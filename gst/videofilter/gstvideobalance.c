@@ -57,6 +57,7 @@ GST_DEBUG_CATEGORY_STATIC (videobalance_debug);
 #define DEFAULT_PROP_BRIGHTNESS		0.0
 #define DEFAULT_PROP_HUE		0.0
 #define DEFAULT_PROP_SATURATION		1.0
+#define DEFAULT_PROP_N_THREADS		1
 
 enum
 {
@@ -64,13 +65,24 @@ enum
   PROP_CONTRAST,
   PROP_BRIGHTNESS,
   PROP_HUE,
-  PROP_SATURATION
+  PROP_SATURATION,
+  PROP_N_THREADS
 };
 
+#if G_BYTE_ORDER == G_LITTLE_ENDIAN
+#define HIGH_DEPTH_FORMATS \
+  "I420_10LE, I420_12LE, I422_10LE, I422_12LE, Y444_10LE, Y444_12LE, " \
+  "Y444_16LE, P010_10LE, P012_LE, P016_LE"
+#else
+#define HIGH_DEPTH_FORMATS \
+  "I420_10BE, I420_12BE, I422_10BE, I422_12BE, Y444_10BE, Y444_12BE, " \
+  "Y444_16BE, P010_10BE, P012_BE, P016_BE"
+#endif
+
 #define PROCESSING_CAPS \
   "{ AYUV, ARGB, BGRA, ABGR, RGBA, Y444, xRGB, RGBx, " \
   "xBGR, BGRx, RGB, BGR, Y42B, YUY2, UYVY, YVYU, " \
-  "I420, YV12, IYUV, Y41B, NV12, NV21 }"
+  "I420, YV12, IYUV, Y41B, NV12, NV21, " HIGH_DEPTH_FORMATS " }"
 
 static GstStaticPadTemplate gst_video_balance_src_template =
     GST_STATIC_PAD_TEMPLATE ("src",
@@ -144,6 +156,12 @@ gst_video_balance_update_tables (GstVideoBalance * vb)
       vb->tablev[i + 128][j + 128] = rint (v);
     }
   }
+
+  /* the same transform in fixed point, for any bit depth */
+  vb->contrast_fp = rint (vb->contrast * 4096);
+  vb->luma_offset = 16 * (1 - vb->contrast) + vb->brightness * 255;
+  vb->hue_cos_fp = rint (hue_cos * vb->saturation * 4096);
+  vb->hue_sin_fp = rint (hue_sin * vb->saturation * 4096);
 }
 
 static gboolean
@@ -339,6 +357,86 @@ gst_video_balance_packed_yuv (GstVideoBalance * videobalance,
   }
 }
 
+/* Formats with more than 8 bits are processed with arithmetic instead of
+ * tables: a 2D chroma table would not fit in the caches. The loops are
+ * branch-free so the compiler can vectorize them. */
+static inline void
+gst_video_balance_luma16 (guint16 * data, gint width, gint shift, gint max,
+    gint scale, gint offset)
+{
+  gint x, y;
+
+  for (x = 0; x < width; x++) {
+    y = ((data[x] >> shift) * scale + offset) >> 12;
+    data[x] = CLAMP (y, 0, max) << shift;
+  }
+}
+
+static inline void
+gst_video_balance_chroma16 (guint16 * udata, guint16 * vdata, gint step,
+    gint width, gint shift, gint max, gint hue_cos, gint hue_sin)
+{
+  gint center = (max + 1) / 2;
+  gint x, u, v, u1, v1;
+
+  for (x = 0; x < width; x++) {
+    u1 = (udata[x * step] >> shift) - center;
+    v1 = (vdata[x * step] >> shift) - center;
+
+    u = ((u1 * hue_cos + v1 * hue_sin + 2048) >> 12) + center;
+    v = ((v1 * hue_cos - u1 * hue_sin + 2048) >> 12) + center;
+
+    udata[x * step] = CLAMP (u, 0, max) << shift;
+    vdata[x * step] = CLAMP (v, 0, max) << shift;
+  }
+}
+
+/* planar and semi-planar YUV with 16 bit containers */
+static void
+gst_video_balance_yuv16 (GstVideoBalance * videobalance, GstVideoFrame * frame)
+{
+  const GstVideoFormatInfo *finfo = frame->info.finfo;
+  gint depth = GST_VIDEO_FORMAT_INFO_DEPTH (finfo, 0);
+  gint shift = GST_VIDEO_FORMAT_INFO_SHIFT (finfo, 0);
+  gint max = (1 << depth) - 1;
+  gint scale = videobalance->contrast_fp;
+  gint offset;
+  gint y, width, height, ystride, ustride, vstride, step;
+  guint8 *ydata, *udata, *vdata;
+
+  offset = rint (videobalance->luma_offset * (1 << (depth - 8)) * 4096) + 2048;
+
+  width = GST_VIDEO_FRAME_COMP_WIDTH (frame, 0);
+  height = GST_VIDEO_FRAME_COMP_HEIGHT (frame, 0);
+  ydata = GST_VIDEO_FRAME_COMP_DATA (frame, 0);
+  ystride = GST_VIDEO_FRAME_COMP_STRIDE (frame, 0);
+
+  for (y = 0; y < height; y++)
+    gst_video_balance_luma16 ((guint16 *) (ydata + y * ystride), width, shift,
+        max, scale, offset);
+
+  width = GST_VIDEO_FRAME_COMP_WIDTH (frame, 1);
+  height = GST_VIDEO_FRAME_COMP_HEIGHT (frame, 1);
+  udata = GST_VIDEO_FRAME_COMP_DATA (frame, 1);
+  vdata = GST_VIDEO_FRAME_COMP_DATA (frame, 2);
+  ustride = GST_VIDEO_FRAME_COMP_STRIDE (frame, 1);
+  vstride = GST_VIDEO_FRAME_COMP_STRIDE (frame, 2);
+  step = GST_VIDEO_FRAME_COMP_PSTRIDE (frame, 1) / 2;
+
+  for (y = 0; y < height; y++) {
+    guint16 *uptr = (guint16 *) (udata + y * ustride);
+    guint16 *vptr = (guint16 *) (vdata + y * vstride);
+
+    /* constant steps let the compiler specialize the loop */
+    if (step == 1)
+      gst_video_balance_chroma16 (uptr, vptr, 1, width, shift, max,
+          videobalance->hue_cos_fp, videobalance->hue_sin_fp);
+    else
+      gst_video_balance_chroma16 (uptr, vptr, 2, width, shift, max,
+          videobalance->hue_cos_fp, videobalance->hue_sin_fp);
+  }
+}
+
 static const int cog_ycbcr_to_rgb_matrix_8bit_sdtv[] = {
   298, 0, 409, -57068,
   298, -100, -208, 34707,
@@ -455,6 +553,28 @@ gst_video_balance_set_info (GstVideoFilter * vfilter, GstCaps * incaps,
     case GST_VIDEO_FORMAT_BGR:
       videobalance->process = gst_video_balance_packed_rgb;
       break;
+    case GST_VIDEO_FORMAT_I420_10LE:
+    case GST_VIDEO_FORMAT_I420_10BE:
+    case GST_VIDEO_FORMAT_I420_12LE:
+    case GST_VIDEO_FORMAT_I420_12BE:
+    case GST_VIDEO_FORMAT_I422_10LE:
+    case GST_VIDEO_FORMAT_I422_10BE:
+    case GST_VIDEO_FORMAT_I422_12LE:
+    case GST_VIDEO_FORMAT_I422_12BE:
+    case GST_VIDEO_FORMAT_Y444_10LE:
+    case GST_VIDEO_FORMAT_Y444_10BE:
+    case GST_VIDEO_FORMAT_Y444_12LE:
+    case GST_VIDEO_FORMAT_Y444_12BE:
+    case GST_VIDEO_FORMAT_Y444_16LE:
+    case GST_VIDEO_FORMAT_Y444_16BE:
+    case GST_VIDEO_FORMAT_P010_10LE:
+    case GST_VIDEO_FORMAT_P010_10BE:
+    case GST_VIDEO_FORMAT_P012_LE:
+    case GST_VIDEO_FORMAT_P012_BE:
+    case GST_VIDEO_FORMAT_P016_LE:
+    case GST_VIDEO_FORMAT_P016_BE:
+      videobalance->process = gst_video_balance_yuv16;
+      break;
     default:
       if (!gst_video_balance_is_passthrough (videobalance))
         goto unknown_format;
@@ -528,7 +648,8 @@ gst_video_balance_transform_frame_ip (GstVideoFilter * vfilter,
     goto not_negotiated;
 
   GST_OBJECT_LOCK (videobalance);
-  videobalance->process (videobalance, frame);
+  gst_video_bands_process (&videobalance->bands, videobalance->n_threads,
+      frame, (GstVideoBandsFunc) videobalance->process, videobalance);
   GST_OBJECT_UNLOCK (videobalance);
 
   return GST_FLOW_OK;
@@ -548,6 +669,7 @@ gst_video_balance_finalize (GObject * object)
   GstVideoBalance *balance = GST_VIDEO_BALANCE (object);
 
   g_free (balance->tableu[0]);
+  gst_video_bands_clear (&balance->bands);
 
   channels = balance->channels;
   while (channels) {
@@ -595,6 +717,20 @@ gst_video_balance_class_init (GstVideoBalanceClass * klass)
           DEFAULT_PROP_SATURATION,
           GST_PARAM_CONTROLLABLE | G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstVideoBalance:n-threads:
+   *
+   * Maximum number of threads used to process each frame, in bands of rows.
+   * 0 uses one thread per CPU.
+   *
+   * Since: 1.24
+   */
+  g_object_class_install_property (gobject_class, PROP_N_THREADS,
+      g_param_spec_uint ("n-threads", "Threads",
+          "Maximum number of threads to use (0 = number of CPUs)", 0,
+          G_MAXINT, DEFAULT_PROP_N_THREADS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_set_static_metadata (gstelement_class, "Video balance",
       "Filter/Effect/Video",
       "Adjusts brightness, contrast, hue, saturation on a video stream",
@@ -629,6 +765,8 @@ gst_video_balance_init (GstVideoBalance * videobalance)
   videobalance->brightness = DEFAULT_PROP_BRIGHTNESS;
   videobalance->hue = DEFAULT_PROP_HUE;
   videobalance->saturation = DEFAULT_PROP_SATURATION;
+  videobalance->n_threads = DEFAULT_PROP_N_THREADS;
+  gst_video_bands_init (&videobalance->bands);
 
   videobalance->tableu[0] = g_new (guint8, 256 * 256 * 2);
   for (i = 0; i < 256; i++) {
@@ -802,6 +940,9 @@ gst_video_balance_set_property (GObject * object, guint prop_id,
         label = "SATURATION";
       balance->saturation = d;
       break;
+    case PROP_N_THREADS:
+      balance->n_threads = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -837,6 +978,9 @@ gst_video_balance_get_property (GObject * object, guint prop_id, GValue * value,
     case PROP_SATURATION:
       g_value_set_double (value, balance->saturation);
       break;
+    case PROP_N_THREADS:
+      g_value_set_uint (value, balance->n_threads);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -25,6 +25,8 @@
 #include <gst/video/video.h>
 #include <gst/video/gstvideofilter.h>
 
+#include <gst/video-bands-private.h>
+
 G_BEGIN_DECLS
 
 #define GST_TYPE_VIDEO_BALANCE \
@@ -65,6 +67,15 @@ struct _GstVideoBalance {
   guint8 *tableu[256];
   guint8 *tablev[256];
 
+  /* fixed point factors for formats with more than 8 bits, in 1/4096 */
+  gint contrast_fp;
+  gint hue_cos_fp, hue_sin_fp;
+  /* luma offset in 8 bit units */
+  gdouble luma_offset;
+
+  guint n_threads;
+  GstVideoBands bands;
+
   void (*process) (GstVideoBalance *balance, GstVideoFrame *frame);
 };
 
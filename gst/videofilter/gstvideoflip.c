@@ -53,11 +53,13 @@ enum
 {
   PROP_0,
   PROP_METHOD,
-  PROP_VIDEO_DIRECTION
+  PROP_VIDEO_DIRECTION,
+  PROP_N_THREADS
       /* FILL ME */
 };
 
 #define PROP_METHOD_DEFAULT GST_VIDEO_FLIP_METHOD_IDENTITY
+#define PROP_N_THREADS_DEFAULT 1
 
 GST_DEBUG_CATEGORY_STATIC (video_flip_debug);
 #define GST_CAT_DEFAULT video_flip_debug
@@ -220,6 +222,134 @@ gst_video_flip_transform_caps (GstBaseTransform * trans,
   return ret;
 }
 
+/* Rotating by 90 degrees and flipping along a diagonal are transposes: the
+ * destination rows are read from the source columns. Doing that pixel by
+ * pixel over a whole row reads one pixel per source row and misses the cache
+ * on every read for large frames, so the plane is transposed in tiles that
+ * fit in the L1 cache together with their destination. */
+#define TRANSPOSE_TILE_SIZE 32
+
+/* dest pixel (x, y) is the source pixel at @src + x * @row_step +
+ * y * @col_step. Inlined with a constant @pstride so that the compiler turns
+ * the memcpy() into a single load and store */
+static inline void
+transpose_tiles (guint8 * dest, gint dest_stride, const guint8 * src,
+    gint row_step, gint col_step, gint width, gint height, gint pstride)
+{
+  gint tx, ty, x, y;
+
+  for (ty = 0; ty < height; ty += TRANSPOSE_TILE_SIZE) {
+    gint tile_height = MIN (TRANSPOSE_TILE_SIZE, height - ty);
+
+    for (tx = 0; tx < width; tx += TRANSPOSE_TILE_SIZE) {
+      gint tile_width = MIN (TRANSPOSE_TILE_SIZE, width - tx);
+
+      for (y = ty; y < ty + tile_height; y++) {
+        guint8 *d = dest + y * dest_stride + tx * pstride;
+        const guint8 *s = src + tx * row_step + y * col_step;
+
+        for (x = 0; x < tile_width; x++) {
+          memcpy (d, s, pstride);
+          d += pstride;
+          s += row_step;
+        }
+      }
+    }
+  }
+}
+
+typedef struct
+{
+  guint8 *dest;
+  gint dest_stride;
+  const guint8 *src;
+  gint row_step, col_step;
+  gint width;
+  gint pstride;
+} GstVideoFlipTranspose;
+
+static void
+gst_video_flip_transpose_rows (GstVideoFlipTranspose * t, gint y, gint height)
+{
+  guint8 *d = t->dest + y * t->dest_stride;
+  const guint8 *s = t->src + y * t->col_step;
+
+  switch (t->pstride) {
+    case 1:
+      transpose_tiles (d, t->dest_stride, s, t->row_step, t->col_step,
+          t->width, height, 1);
+      break;
+    case 2:
+      transpose_tiles (d, t->dest_stride, s, t->row_step, t->col_step,
+          t->width, height, 2);
+      break;
+    case 3:
+      transpose_tiles (d, t->dest_stride, s, t->row_step, t->col_step,
+          t->width, height, 3);
+      break;
+    case 4:
+      transpose_tiles (d, t->dest_stride, s, t->row_step, t->col_step,
+          t->width, height, 4);
+      break;
+    default:
+      transpose_tiles (d, t->dest_stride, s, t->row_step, t->col_step,
+          t->width, height, t->pstride);
+      break;
+  }
+}
+
+static void
+gst_video_flip_transpose_plane (GstVideoFlip * videoflip, GstVideoFrame * dest,
+    const GstVideoFrame * src, gint plane, gint pstride)
+{
+  const guint8 *s = GST_VIDEO_FRAME_PLANE_DATA (src, plane);
+  gint src_stride = GST_VIDEO_FRAME_PLANE_STRIDE (src, plane);
+  gint src_width = GST_VIDEO_FRAME_COMP_WIDTH (src, plane);
+  gint src_height = GST_VIDEO_FRAME_COMP_HEIGHT (src, plane);
+  GstVideoFlipTranspose t;
+
+  switch (videoflip->active_method) {
+    case GST_VIDEO_ORIENTATION_90R:
+      /* dest (x, y) = src (y, src_height - 1 - x) */
+      s += (src_height - 1) * src_stride;
+      t.row_step = -src_stride;
+      t.col_step = pstride;
+      break;
+    case GST_VIDEO_ORIENTATION_90L:
+      /* dest (x, y) = src (src_width - 1 - y, x) */
+      s += (src_width - 1) * pstride;
+      t.row_step = src_stride;
+      t.col_step = -pstride;
+      break;
+    case GST_VIDEO_ORIENTATION_UL_LR:
+      /* dest (x, y) = src (y, x) */
+      t.row_step = src_stride;
+      t.col_step = pstride;
+      break;
+    case GST_VIDEO_ORIENTATION_UR_LL:
+      /* dest (x, y) = src (src_width - 1 - y, src_height - 1 - x) */
+      s += (src_height - 1) * src_stride + (src_width - 1) * pstride;
+      t.row_step = -src_stride;
+      t.col_step = -pstride;
+      break;
+    default:
+      g_assert_not_reached ();
+      return;
+  }
+
+  t.dest = GST_VIDEO_FRAME_PLANE_DATA (dest, plane);
+  t.dest_stride = GST_VIDEO_FRAME_PLANE_STRIDE (dest, plane);
+  t.src = s;
+  t.width = GST_VIDEO_FRAME_COMP_WIDTH (dest, plane);
+  t.pstride = pstride;
+
+  /* each thread writes its own band of destination rows, made of whole rows
+   * of tiles */
+  gst_video_bands_process_rows (&videoflip->bands, videoflip->n_threads,
+      GST_VIDEO_FRAME_COMP_HEIGHT (dest, plane), TRANSPOSE_TILE_SIZE,
+      (GstVideoBandsRowsFunc) gst_video_flip_transpose_rows, &t);
+}
+
 static void
 gst_video_flip_planar_yuv (GstVideoFlip * videoflip, GstVideoFrame * dest,
     const GstVideoFrame * src)
@@ -259,64 +389,6 @@ gst_video_flip_planar_yuv (GstVideoFlip * videoflip, GstVideoFrame * dest,
   dest_v_height = GST_VIDEO_FRAME_COMP_HEIGHT (dest, 2);
 
   switch (videoflip->active_method) {
-    case GST_VIDEO_ORIENTATION_90R:
-      /* Flip Y */
-      s = GST_VIDEO_FRAME_PLANE_DATA (src, 0);
-      d = GST_VIDEO_FRAME_PLANE_DATA (dest, 0);
-      for (y = 0; y < dest_y_height; y++) {
-        for (x = 0; x < dest_y_width; x++) {
-          d[y * dest_y_stride + x] =
-              s[(src_y_height - 1 - x) * src_y_stride + y];
-        }
-      }
-      /* Flip U */
-      s = GST_VIDEO_FRAME_PLANE_DATA (src, 1);
-      d = GST_VIDEO_FRAME_PLANE_DATA (dest, 1);
-      for (y = 0; y < dest_u_height; y++) {
-        for (x = 0; x < dest_u_width; x++) {
-          d[y * dest_u_stride + x] =
-              s[(src_u_height - 1 - x) * src_u_stride + y];
-        }
-      }
-      /* Flip V */
-      s = GST_VIDEO_FRAME_PLANE_DATA (src, 2);
-      d = GST_VIDEO_FRAME_PLANE_DATA (dest, 2);
-      for (y = 0; y < dest_v_height; y++) {
-        for (x = 0; x < dest_v_width; x++) {
-          d[y * dest_v_stride + x] =
-              s[(src_v_height - 1 - x) * src_v_stride + y];
-        }
-      }
-      break;
-    case GST_VIDEO_ORIENTATION_90L:
-      /* Flip Y */
-      s = GST_VIDEO_FRAME_PLANE_DATA (src, 0);
-      d = GST_VIDEO_FRAME_PLANE_DATA (dest, 0);
-      for (y = 0; y < dest_y_height; y++) {
-        for (x = 0; x < dest_y_width; x++) {
-          d[y * dest_y_stride + x] =
-              s[x * src_y_stride + (src_y_width - 1 - y)];
-        }
-      }
-      /* Flip U */
-      s = GST_VIDEO_FRAME_PLANE_DATA (src, 1);
-      d = GST_VIDEO_FRAME_PLANE_DATA (dest, 1);
-      for (y = 0; y < dest_u_height; y++) {
-        for (x = 0; x < dest_u_width; x++) {
-          d[y * dest_u_stride + x] =
-              s[x * src_u_stride + (src_u_width - 1 - y)];
-        }
-      }
-      /* Flip V */
-      s = GST_VIDEO_FRAME_PLANE_DATA (src, 2);
-      d = GST_VIDEO_FRAME_PLANE_DATA (dest, 2);
-      for (y = 0; y < dest_v_height; y++) {
-        for (x = 0; x < dest_v_width; x++) {
-          d[y * dest_v_stride + x] =
-              s[x * src_v_stride + (src_v_width - 1 - y)];
-        }
-      }
-      break;
     case GST_VIDEO_ORIENTATION_180:
       /* Flip Y */
       s = GST_VIDEO_FRAME_PLANE_DATA (src, 0);
@@ -404,60 +476,13 @@ gst_video_flip_planar_yuv (GstVideoFlip * videoflip, GstVideoFrame * dest,
         }
       }
       break;
+    case GST_VIDEO_ORIENTATION_90R:
+    case GST_VIDEO_ORIENTATION_90L:
     case GST_VIDEO_ORIENTATION_UL_LR:
-      /* Flip Y */
-      s = GST_VIDEO_FRAME_PLANE_DATA (src, 0);
-      d = GST_VIDEO_FRAME_PLANE_DATA (dest, 0);
-      for (y = 0; y < dest_y_height; y++) {
-        for (x = 0; x < dest_y_width; x++) {
-          d[y * dest_y_stride + x] = s[x * src_y_stride + y];
-        }
-      }
-      /* Flip U */
-      s = GST_VIDEO_FRAME_PLANE_DATA (src, 1);
-      d = GST_VIDEO_FRAME_PLANE_DATA (dest, 1);
-      for (y = 0; y < dest_u_height; y++) {
-        for (x = 0; x < dest_u_width; x++) {
-          d[y * dest_u_stride + x] = s[x * src_u_stride + y];
-        }
-      }
-      /* Flip V */
-      s = GST_VIDEO_FRAME_PLANE_DATA (src, 2);
-      d = GST_VIDEO_FRAME_PLANE_DATA (dest, 2);
-      for (y = 0; y < dest_v_height; y++) {
-        for (x = 0; x < dest_v_width; x++) {
-          d[y * dest_v_stride + x] = s[x * src_v_stride + y];
-        }
-      }
-      break;
     case GST_VIDEO_ORIENTATION_UR_LL:
-      /* Flip Y */
-      s = GST_VIDEO_FRAME_PLANE_DATA (src, 0);
-      d = GST_VIDEO_FRAME_PLANE_DATA (dest, 0);
-      for (y = 0; y < dest_y_height; y++) {
-        for (x = 0; x < dest_y_width; x++) {
-          d[y * dest_y_stride + x] =
-              s[(src_y_height - 1 - x) * src_y_stride + (src_y_width - 1 - y)];
-        }
-      }
-      /* Flip U */
-      s = GST_VIDEO_FRAME_PLANE_DATA (src, 1);
-      d = GST_VIDEO_FRAME_PLANE_DATA (dest, 1);
-      for (y = 0; y < dest_u_height; y++) {
-        for (x = 0; x < dest_u_width; x++) {
-          d[y * dest_u_stride + x] =
-              s[(src_u_height - 1 - x) * src_u_stride + (src_u_width - 1 - y)];
-        }
-      }
-      /* Flip V */
-      s = GST_VIDEO_FRAME_PLANE_DATA (src, 2);
-      d = GST_VIDEO_FRAME_PLANE_DATA (dest, 2);
-      for (y = 0; y < dest_v_height; y++) {
-        for (x = 0; x < dest_v_width; x++) {
-          d[y * dest_v_stride + x] =
-              s[(src_v_height - 1 - x) * src_v_stride + (src_v_width - 1 - y)];
-        }
-      }
+      gst_video_flip_transpose_plane (videoflip, dest, src, 0, 1);
+      gst_video_flip_transpose_plane (videoflip, dest, src, 1, 1);
+      gst_video_flip_transpose_plane (videoflip, dest, src, 2, 1);
       break;
     case GST_VIDEO_ORIENTATION_IDENTITY:
       gst_video_frame_copy (dest, src);
@@ -508,64 +533,6 @@ gst_video_flip_planar_yuv_16bit (GstVideoFlip * videoflip, GstVideoFrame * dest,
   dest_v_height = GST_VIDEO_FRAME_COMP_HEIGHT (dest, 2);
 
   switch (videoflip->active_method) {
-    case GST_VIDEO_ORIENTATION_90R:
-      /* Flip Y */
-      s = GST_VIDEO_FRAME_PLANE_DATA (src, 0);
-      d = GST_VIDEO_FRAME_PLANE_DATA (dest, 0);
-      for (y = 0; y < dest_y_height; y++) {
-        for (x = 0; x < dest_y_width; x++) {
-          d[y * dest_y_stride + x] =
-              s[(src_y_height - 1 - x) * src_y_stride + y];
-        }
-      }
-      /* Flip U */
-      s = GST_VIDEO_FRAME_PLANE_DATA (src, 1);
-      d = GST_VIDEO_FRAME_PLANE_DATA (dest, 1);
-      for (y = 0; y < dest_u_height; y++) {
-        for (x = 0; x < dest_u_width; x++) {
-          d[y * dest_u_stride + x] =
-              s[(src_u_height - 1 - x) * src_u_stride + y];
-        }
-      }
-      /* Flip V */
-      s = GST_VIDEO_FRAME_PLANE_DATA (src, 2);
-      d = GST_VIDEO_FRAME_PLANE_DATA (dest, 2);
-      for (y = 0; y < dest_v_height; y++) {
-        for (x = 0; x < dest_v_width; x++) {
-          d[y * dest_v_stride + x] =
-              s[(src_v_height - 1 - x) * src_v_stride + y];
-        }
-      }
-      break;
-    case GST_VIDEO_ORIENTATION_90L:
-      /* Flip Y */
-      s = GST_VIDEO_FRAME_PLANE_DATA (src, 0);
-      d = GST_VIDEO_FRAME_PLANE_DATA (dest, 0);
-      for (y = 0; y < dest_y_height; y++) {
-        for (x = 0; x < dest_y_width; x++) {
-          d[y * dest_y_stride + x] =
-              s[x * src_y_stride + (src_y_width - 1 - y)];
-        }
-      }
-      /* Flip U */
-      s = GST_VIDEO_FRAME_PLANE_DATA (src, 1);
-      d = GST_VIDEO_FRAME_PLANE_DATA (dest, 1);
-      for (y = 0; y < dest_u_height; y++) {
-        for (x = 0; x < dest_u_width; x++) {
-          d[y * dest_u_stride + x] =
-              s[x * src_u_stride + (src_u_width - 1 - y)];
-        }
-      }
-      /* Flip V */
-      s = GST_VIDEO_FRAME_PLANE_DATA (src, 2);
-      d = GST_VIDEO_FRAME_PLANE_DATA (dest, 2);
-      for (y = 0; y < dest_v_height; y++) {
-        for (x = 0; x < dest_v_width; x++) {
-          d[y * dest_v_stride + x] =
-              s[x * src_v_stride + (src_v_width - 1 - y)];
-        }
-      }
-      break;
     case GST_VIDEO_ORIENTATION_180:
       /* Flip Y */
       s = GST_VIDEO_FRAME_PLANE_DATA (src, 0);
@@ -653,60 +620,13 @@ gst_video_flip_planar_yuv_16bit (GstVideoFlip * videoflip, GstVideoFrame * dest,
         }
       }
       break;
+    case GST_VIDEO_ORIENTATION_90R:
+    case GST_VIDEO_ORIENTATION_90L:
     case GST_VIDEO_ORIENTATION_UL_LR:
-      /* Flip Y */
-      s = GST_VIDEO_FRAME_PLANE_DATA (src, 0);
-      d = GST_VIDEO_FRAME_PLANE_DATA (dest, 0);
-      for (y = 0; y < dest_y_height; y++) {
-        for (x = 0; x < dest_y_width; x++) {
-          d[y * dest_y_stride + x] = s[x * src_y_stride + y];
-        }
-      }
-      /* Flip U */
-      s = GST_VIDEO_FRAME_PLANE_DATA (src, 1);
-      d = GST_VIDEO_FRAME_PLANE_DATA (dest, 1);
-      for (y = 0; y < dest_u_height; y++) {
-        for (x = 0; x < dest_u_width; x++) {
-          d[y * dest_u_stride + x] = s[x * src_u_stride + y];
-        }
-      }
-      /* Flip V */
-      s = GST_VIDEO_FRAME_PLANE_DATA (src, 2);
-      d = GST_VIDEO_FRAME_PLANE_DATA (dest, 2);
-      for (y = 0; y < dest_v_height; y++) {
-        for (x = 0; x < dest_v_width; x++) {
-          d[y * dest_v_stride + x] = s[x * src_v_stride + y];
-        }
-      }
-      break;
     case GST_VIDEO_ORIENTATION_UR_LL:
-      /* Flip Y */
-      s = GST_VIDEO_FRAME_PLANE_DATA (src, 0);
-      d = GST_VIDEO_FRAME_PLANE_DATA (dest, 0);
-      for (y = 0; y < dest_y_height; y++) {
-        for (x = 0; x < dest_y_width; x++) {
-          d[y * dest_y_stride + x] =
-              s[(src_y_height - 1 - x) * src_y_stride + (src_y_width - 1 - y)];
-        }
-      }
-      /* Flip U */
-      s = GST_VIDEO_FRAME_PLANE_DATA (src, 1);
-      d = GST_VIDEO_FRAME_PLANE_DATA (dest, 1);
-      for (y = 0; y < dest_u_height; y++) {
-        for (x = 0; x < dest_u_width; x++) {
-          d[y * dest_u_stride + x] =
-              s[(src_u_height - 1 - x) * src_u_stride + (src_u_width - 1 - y)];
-        }
-      }
-      /* Flip V */
-      s = GST_VIDEO_FRAME_PLANE_DATA (src, 2);
-      d = GST_VIDEO_FRAME_PLANE_DATA (dest, 2);
-      for (y = 0; y < dest_v_height; y++) {
-        for (x = 0; x < dest_v_width; x++) {
-          d[y * dest_v_stride + x] =
-              s[(src_v_height - 1 - x) * src_v_stride + (src_v_width - 1 - y)];
-        }
-      }
+      gst_video_flip_transpose_plane (videoflip, dest, src, 0, 2);
+      gst_video_flip_transpose_plane (videoflip, dest, src, 1, 2);
+      gst_video_flip_transpose_plane (videoflip, dest, src, 2, 2);
       break;
     case GST_VIDEO_ORIENTATION_IDENTITY:
       gst_video_frame_copy (dest, src);
@@ -718,10 +638,11 @@ gst_video_flip_planar_yuv_16bit (GstVideoFlip * videoflip, GstVideoFrame * dest,
 }
 
 static inline void
-rotate_yuv422_plane (GstVideoFrame * dest, const GstVideoFrame * src,
-    gint plane_index, GstVideoOrientationMethod method,
-    gboolean is_chroma, gboolean is_le)
+rotate_yuv422_plane (GstVideoFlip * videoflip, GstVideoFrame * dest,
+    const GstVideoFrame * src, gint plane_index, gboolean is_chroma,
+    gboolean is_le)
 {
+  GstVideoOrientationMethod method = videoflip->active_method;
   gint src_stride, src_height, src_width;
   gint dest_stride, dest_height, dest_width;
   gint x, y;
@@ -744,6 +665,15 @@ rotate_yuv422_plane (GstVideoFrame * dest, const GstVideoFrame * src,
 
   scale = is_chroma ? 2 : 1;
 
+  /* only the chroma planes need averaging, luma is a plain transpose */
+  if (!is_chroma && (method == GST_VIDEO_ORIENTATION_90R ||
+          method == GST_VIDEO_ORIENTATION_90L ||
+          method == GST_VIDEO_ORIENTATION_UL_LR ||
+          method == GST_VIDEO_ORIENTATION_UR_LL)) {
+    gst_video_flip_transpose_plane (videoflip, dest, src, plane_index, 2);
+    return;
+  }
+
   switch (method) {
     case GST_VIDEO_ORIENTATION_90R:
       if (is_le) {
@@ -929,13 +859,13 @@ gst_video_flip_planar_yuv_422_16bit (GstVideoFlip * videoflip,
   /* Attempt to get the compiler to inline specialized variants of this function 
    * to avoid too much branching due to endianness checks */
   if (format_is_le) {
-    rotate_yuv422_plane (dest, src, 0, videoflip->active_method, FALSE, TRUE);
-    rotate_yuv422_plane (dest, src, 1, videoflip->active_method, TRUE, TRUE);
-    rotate_yuv422_plane (dest, src, 2, videoflip->active_method, TRUE, TRUE);
+    rotate_yuv422_plane (videoflip, dest, src, 0, FALSE, TRUE);
+    rotate_yuv422_plane (videoflip, dest, src, 1, TRUE, TRUE);
+    rotate_yuv422_plane (videoflip, dest, src, 2, TRUE, TRUE);
   } else {
-    rotate_yuv422_plane (dest, src, 0, videoflip->active_method, FALSE, FALSE);
-    rotate_yuv422_plane (dest, src, 1, videoflip->active_method, TRUE, FALSE);
-    rotate_yuv422_plane (dest, src, 2, videoflip->active_method, TRUE, FALSE);
+    rotate_yuv422_plane (videoflip, dest, src, 0, FALSE, FALSE);
+    rotate_yuv422_plane (videoflip, dest, src, 1, TRUE, FALSE);
+    rotate_yuv422_plane (videoflip, dest, src, 2, TRUE, FALSE);
   }
 }
 
@@ -974,50 +904,6 @@ gst_video_flip_semi_planar_yuv (GstVideoFlip * videoflip, GstVideoFrame * dest,
   dest_uv_height = GST_VIDEO_FRAME_COMP_HEIGHT (dest, 1);
 
   switch (videoflip->active_method) {
-    case GST_VIDEO_ORIENTATION_90R:
-      /* Flip Y */
-      s = GST_VIDEO_FRAME_PLANE_DATA (src, 0);
-      d = GST_VIDEO_FRAME_PLANE_DATA (dest, 0);
-      for (y = 0; y < dest_y_height; y++) {
-        for (x = 0; x < dest_y_width; x++) {
-          d[y * dest_y_stride + x] =
-              s[(src_y_height - 1 - x) * src_y_stride + y];
-        }
-      }
-      /* Flip UV */
-      s = GST_VIDEO_FRAME_PLANE_DATA (src, 1);
-      d = GST_VIDEO_FRAME_PLANE_DATA (dest, 1);
-      for (y = 0; y < dest_uv_height; y++) {
-        for (x = 0; x < dest_uv_width; x++) {
-          d_off = y * dest_uv_stride + x * 2;
-          s_off = (src_uv_height - 1 - x) * src_uv_stride + y * 2;
-          d[d_off] = s[s_off];
-          d[d_off + 1] = s[s_off + 1];
-        }
-      }
-      break;
-    case GST_VIDEO_ORIENTATION_90L:
-      /* Flip Y */
-      s = GST_VIDEO_FRAME_PLANE_DATA (src, 0);
-      d = GST_VIDEO_FRAME_PLANE_DATA (dest, 0);
-      for (y = 0; y < dest_y_height; y++) {
-        for (x = 0; x < dest_y_width; x++) {
-          d[y * dest_y_stride + x] =
-              s[x * src_y_stride + (src_y_width - 1 - y)];
-        }
-      }
-      /* Flip UV */
-      s = GST_VIDEO_FRAME_PLANE_DATA (src, 1);
-      d = GST_VIDEO_FRAME_PLANE_DATA (dest, 1);
-      for (y = 0; y < dest_uv_height; y++) {
-        for (x = 0; x < dest_uv_width; x++) {
-          d_off = y * dest_uv_stride + x * 2;
-          s_off = x * src_uv_stride + (src_uv_width - 1 - y) * 2;
-          d[d_off] = s[s_off];
-          d[d_off + 1] = s[s_off + 1];
-        }
-      }
-      break;
     case GST_VIDEO_ORIENTATION_180:
       /* Flip Y */
       s = GST_VIDEO_FRAME_PLANE_DATA (src, 0);
@@ -1085,49 +971,12 @@ gst_video_flip_semi_planar_yuv (GstVideoFlip * videoflip, GstVideoFrame * dest,
         }
       }
       break;
+    case GST_VIDEO_ORIENTATION_90R:
+    case GST_VIDEO_ORIENTATION_90L:
     case GST_VIDEO_ORIENTATION_UL_LR:
-      /* Flip Y */
-      s = GST_VIDEO_FRAME_PLANE_DATA (src, 0);
-      d = GST_VIDEO_FRAME_PLANE_DATA (dest, 0);
-      for (y = 0; y < dest_y_height; y++) {
-        for (x = 0; x < dest_y_width; x++) {
-          d[y * dest_y_stride + x] = s[x * src_y_stride + y];
-        }
-      }
-      /* Flip UV */
-      s = GST_VIDEO_FRAME_PLANE_DATA (src, 1);
-      d = GST_VIDEO_FRAME_PLANE_DATA (dest, 1);
-      for (y = 0; y < dest_uv_height; y++) {
-        for (x = 0; x < dest_uv_width; x++) {
-          d_off = y * dest_uv_stride + x * 2;
-          s_off = x * src_uv_stride + y * 2;
-          d[d_off] = s[s_off];
-          d[d_off + 1] = s[s_off + 1];
-        }
-      }
-      break;
     case GST_VIDEO_ORIENTATION_UR_LL:
-      /* Flip Y */
-      s = GST_VIDEO_FRAME_PLANE_DATA (src, 0);
-      d = GST_VIDEO_FRAME_PLANE_DATA (dest, 0);
-      for (y = 0; y < dest_y_height; y++) {
-        for (x = 0; x < dest_y_width; x++) {
-          d[y * dest_y_stride + x] =
-              s[(src_y_height - 1 - x) * src_y_stride + (src_y_width - 1 - y)];
-        }
-      }
-      /* Flip UV */
-      s = GST_VIDEO_FRAME_PLANE_DATA (src, 1);
-      d = GST_VIDEO_FRAME_PLANE_DATA (dest, 1);
-      for (y = 0; y < dest_uv_height; y++) {
-        for (x = 0; x < dest_uv_width; x++) {
-          d_off = y * dest_uv_stride + x * 2;
-          s_off = (src_uv_height - 1 - x) * src_uv_stride + (src_uv_width - 1 -
-              y) * 2;
-          d[d_off] = s[s_off];
-          d[d_off + 1] = s[s_off + 1];
-        }
-      }
+      gst_video_flip_transpose_plane (videoflip, dest, src, 0, 1);
+      gst_video_flip_transpose_plane (videoflip, dest, src, 1, 2);
       break;
     case GST_VIDEO_ORIENTATION_IDENTITY:
       gst_video_frame_copy (dest, src);
@@ -1161,26 +1010,6 @@ gst_video_flip_packed_simple (GstVideoFlip * videoflip, GstVideoFrame * dest,
   bpp = GST_VIDEO_FRAME_COMP_PSTRIDE (src, 0);
 
   switch (videoflip->active_method) {
-    case GST_VIDEO_ORIENTATION_90R:
-      for (y = 0; y < dh; y++) {
-        for (x = 0; x < dw; x++) {
-          for (z = 0; z < bpp; z++) {
-            d[y * dest_stride + x * bpp + z] =
-                s[(sh - 1 - x) * src_stride + y * bpp + z];
-          }
-        }
-      }
-      break;
-    case GST_VIDEO_ORIENTATION_90L:
-      for (y = 0; y < dh; y++) {
-        for (x = 0; x < dw; x++) {
-          for (z = 0; z < bpp; z++) {
-            d[y * dest_stride + x * bpp + z] =
-                s[x * src_stride + (sw - 1 - y) * bpp + z];
-          }
-        }
-      }
-      break;
     case GST_VIDEO_ORIENTATION_180:
       for (y = 0; y < dh; y++) {
         for (x = 0; x < dw; x++) {
@@ -1211,24 +1040,11 @@ gst_video_flip_packed_simple (GstVideoFlip * videoflip, GstVideoFrame * dest,
         }
       }
       break;
+    case GST_VIDEO_ORIENTATION_90R:
+    case GST_VIDEO_ORIENTATION_90L:
     case GST_VIDEO_ORIENTATION_UL_LR:
-      for (y = 0; y < dh; y++) {
-        for (x = 0; x < dw; x++) {
-          for (z = 0; z < bpp; z++) {
-            d[y * dest_stride + x * bpp + z] = s[x * src_stride + y * bpp + z];
-          }
-        }
-      }
-      break;
     case GST_VIDEO_ORIENTATION_UR_LL:
-      for (y = 0; y < dh; y++) {
-        for (x = 0; x < dw; x++) {
-          for (z = 0; z < bpp; z++) {
-            d[y * dest_stride + x * bpp + z] =
-                s[(sh - 1 - x) * src_stride + (sw - 1 - y) * bpp + z];
-          }
-        }
-      }
+      gst_video_flip_transpose_plane (videoflip, dest, src, 0, bpp);
       break;
     case GST_VIDEO_ORIENTATION_IDENTITY:
       gst_video_frame_copy (dest, src);
@@ -1810,6 +1626,11 @@ gst_video_flip_set_property (GObject * object, guint prop_id,
     case PROP_VIDEO_DIRECTION:
       gst_video_flip_set_method (videoflip, g_value_get_enum (value), FALSE);
       break;
+    case PROP_N_THREADS:
+      GST_OBJECT_LOCK (videoflip);
+      videoflip->n_threads = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (videoflip);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1827,12 +1648,27 @@ gst_video_flip_get_property (GObject * object, guint prop_id, GValue * value,
     case PROP_VIDEO_DIRECTION:
       g_value_set_enum (value, videoflip->method);
       break;
+    case PROP_N_THREADS:
+      GST_OBJECT_LOCK (videoflip);
+      g_value_set_uint (value, videoflip->n_threads);
+      GST_OBJECT_UNLOCK (videoflip);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
   }
 }
 
+static void
+gst_video_flip_finalize (GObject * object)
+{
+  GstVideoFlip *videoflip = GST_VIDEO_FLIP (object);
+
+  gst_video_bands_clear (&videoflip->bands);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
 static void
 gst_video_flip_class_init (GstVideoFlipClass * klass)
 {
@@ -1844,6 +1680,7 @@ gst_video_flip_class_init (GstVideoFlipClass * klass)
 
   GST_DEBUG_CATEGORY_INIT (video_flip_debug, "videoflip", 0, "videoflip");
 
+  gobject_class->finalize = gst_video_flip_finalize;
   gobject_class->set_property = gst_video_flip_set_property;
   gobject_class->get_property = gst_video_flip_get_property;
 
@@ -1860,6 +1697,20 @@ gst_video_flip_class_init (GstVideoFlipClass * klass)
   pspec = g_object_class_find_property (gobject_class, "video-direction");
   pspec->flags |= GST_PARAM_MUTABLE_PLAYING;
 
+  /**
+   * GstVideoFlip:n-threads:
+   *
+   * Maximum number of threads used to rotate each plane by 90 degrees or
+   * flip it along a diagonal, in bands of rows. 0 uses one thread per CPU.
+   *
+   * Since: 1.24
+   */
+  g_object_class_install_property (gobject_class, PROP_N_THREADS,
+      g_param_spec_uint ("n-threads", "Threads",
+          "Maximum number of threads to use (0 = number of CPUs)", 0,
+          G_MAXINT, PROP_N_THREADS_DEFAULT,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_set_static_metadata (gstelement_class, "Video flipper",
       "Filter/Effect/Video",
       "Flips and rotates video", "David Schleef <ds@schleef.org>");
@@ -1891,4 +1742,6 @@ gst_video_flip_init (GstVideoFlip * videoflip)
   videoflip->active_method = GST_VIDEO_ORIENTATION_AUTO;
   videoflip->proposed_method = GST_VIDEO_ORIENTATION_IDENTITY;
   videoflip->configuring_method = GST_VIDEO_ORIENTATION_IDENTITY;
+  videoflip->n_threads = PROP_N_THREADS_DEFAULT;
+  gst_video_bands_init (&videoflip->bands);
 }
@@ -24,6 +24,8 @@
 #include <gst/video/video.h>
 #include <gst/video/gstvideofilter.h>
 
+#include <gst/video-bands-private.h>
+
 G_BEGIN_DECLS
 
 /**
@@ -84,6 +86,9 @@ struct _GstVideoFlip {
   GstVideoOrientationMethod configuring_method;
   GstVideoOrientationMethod active_method;
   void (*process) (GstVideoFlip *videoflip, GstVideoFrame *dest, const GstVideoFrame *src);
+
+  guint n_threads;
+  GstVideoBands bands;
 };
 
 struct _GstVideoFlipClass {
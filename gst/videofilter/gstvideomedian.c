@@ -47,11 +47,13 @@ enum
 
 #define DEFAULT_FILTERSIZE   5
 #define DEFAULT_LUM_ONLY     TRUE
+#define DEFAULT_N_THREADS    1
 enum
 {
   PROP_0,
   PROP_FILTERSIZE,
-  PROP_LUM_ONLY
+  PROP_LUM_ONLY,
+  PROP_N_THREADS
 };
 
 #define GST_TYPE_VIDEO_MEDIAN_SIZE (gst_video_median_size_get_type())
@@ -59,6 +61,9 @@ enum
 static const GEnumValue video_median_sizes[] = {
   {GST_VIDEO_MEDIAN_SIZE_5, "Median of 5 neighbour pixels", "5"},
   {GST_VIDEO_MEDIAN_SIZE_9, "Median of 9 neighbour pixels", "9"},
+  {GST_VIDEO_MEDIAN_SIZE_25, "Median of 5x5 neighbour pixels", "25"},
+  {GST_VIDEO_MEDIAN_SIZE_49, "Median of 7x7 neighbour pixels", "49"},
+  {GST_VIDEO_MEDIAN_SIZE_81, "Median of 9x9 neighbour pixels", "81"},
   {0, NULL, NULL},
 };
 
@@ -82,6 +87,7 @@ GST_ELEMENT_REGISTER_DEFINE (videomedian, "videomedian",
 static GstFlowReturn gst_video_median_transform_frame (GstVideoFilter * filter,
     GstVideoFrame * in_frame, GstVideoFrame * out_frame);
 
+static void gst_video_median_finalize (GObject * object);
 static void gst_video_median_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec);
 static void gst_video_median_get_property (GObject * object, guint prop_id,
@@ -98,6 +104,7 @@ gst_video_median_class_init (GstVideoMedianClass * klass)
   gstelement_class = (GstElementClass *) klass;
   vfilter_class = (GstVideoFilterClass *) klass;
 
+  gobject_class->finalize = gst_video_median_finalize;
   gobject_class->set_property = gst_video_median_set_property;
   gobject_class->get_property = gst_video_median_get_property;
 
@@ -111,6 +118,20 @@ gst_video_median_class_init (GstVideoMedianClass * klass)
           "luminance", DEFAULT_LUM_ONLY,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstVideoMedian:n-threads:
+   *
+   * Maximum number of threads used to filter each frame, in bands of rows.
+   * 0 uses one thread per CPU.
+   *
+   * Since: 1.24
+   */
+  g_object_class_install_property (G_OBJECT_CLASS (klass), PROP_N_THREADS,
+      g_param_spec_uint ("n-threads", "Threads",
+          "Maximum number of threads to use (0 = number of CPUs)", 0,
+          G_MAXINT, DEFAULT_N_THREADS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_add_static_pad_template (gstelement_class,
       &video_median_sink_factory);
   gst_element_class_add_static_pad_template (gstelement_class,
@@ -130,157 +151,348 @@ gst_video_median_init (GstVideoMedian * median)
 {
   median->filtersize = DEFAULT_FILTERSIZE;
   median->lum_only = DEFAULT_LUM_ONLY;
+  median->n_threads = DEFAULT_N_THREADS;
+  gst_video_bands_init (&median->bands);
+}
+
+static void
+gst_video_median_finalize (GObject * object)
+{
+  GstVideoMedian *median = GST_VIDEO_MEDIAN (object);
+
+  gst_video_bands_clear (&median->bands);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+/* branch-free, so the compiler can vectorize the loops using it */
+#define PIX_SORT(a,b) { guint8 temp = MIN ((a), (b)); (b) = MAX ((a), (b)); (a) = temp; }
+
+/* copies the pixels of a row the window does not fit around */
+static inline void
+median_copy_edges (guint8 * dest, const guint8 * src, gint width, gint radius)
+{
+  if (width <= 2 * radius) {
+    memcpy (dest, src, width);
+  } else {
+    memcpy (dest, src, radius);
+    memcpy (dest + width - radius, src + width - radius, radius);
+  }
+}
+
+static inline void
+median_5_pixels (guint8 * out, const guint8 * src, gint sstride, gint n)
+{
+  gint i;
+
+  for (i = 0; i < n; i++) {
+    guint8 p0 = src[i - sstride];
+    guint8 p1 = src[i - 1];
+    guint8 p2 = src[i];
+    guint8 p3 = src[i + 1];
+    guint8 p4 = src[i + sstride];
+
+    PIX_SORT (p0, p1);
+    PIX_SORT (p3, p4);
+    PIX_SORT (p0, p3);
+    PIX_SORT (p1, p4);
+    PIX_SORT (p1, p2);
+    PIX_SORT (p2, p3);
+    PIX_SORT (p1, p2);
+    out[i] = p2;
+  }
 }
 
-#define PIX_SORT(a,b) { if ((a)>(b)) PIX_SWAP((a),(b)); }
-#define PIX_SWAP(a,b) { unsigned char temp=(a);(a)=(b);(b)=temp; }
+/* Rows are filtered in blocks of a constant number of pixels, written to a
+ * local buffer first, so the compiler can vectorize them without alias
+ * checks or epilogues */
+#define MEDIAN_BLOCK 32
 
 static void
-median_5 (guint8 * dest, gint dstride, const guint8 * src, gint sstride,
-    gint width, gint height)
+median_5_row (guint8 * dest, const guint8 * src, gint sstride, gint width)
 {
-  unsigned char p[5];
-  int i, j, k;
+  guint8 out[MEDIAN_BLOCK];
+  gint i, n;
+
+  for (i = 1; i < width - 1; i += n) {
+    n = MIN (MEDIAN_BLOCK, width - 1 - i);
+    if (n == MEDIAN_BLOCK)
+      median_5_pixels (out, src + i, sstride, MEDIAN_BLOCK);
+    else
+      median_5_pixels (out, src + i, sstride, n);
+    memcpy (dest + i, out, n);
+  }
+}
 
-  /* copy the top and bottom rows into the result array */
-  for (i = 0; i < width; i++) {
-    dest[i] = src[i];
-    dest[(height - 1) * dstride + i] = src[(height - 1) * sstride + i];
+static inline void
+median_9_columns (guint8 * lo, guint8 * mid, guint8 * hi, const guint8 * src,
+    gint sstride, gint n)
+{
+  gint i;
+
+  for (i = 0; i < n; i++) {
+    guint8 a = src[i - sstride];
+    guint8 b = src[i];
+    guint8 c = src[i + sstride];
+
+    PIX_SORT (a, b);
+    PIX_SORT (b, c);
+    PIX_SORT (a, b);
+    lo[i] = a;
+    mid[i] = b;
+    hi[i] = c;
   }
+}
 
-  /* process the interior pixels */
-  for (k = 2; k < height; k++) {
-    dest += dstride;
-    src += sstride;
-
-    dest[0] = src[0];
-    for (j = 2, i = 1; j < width; j++, i++) {
-      p[0] = src[i - sstride];
-      p[1] = src[i - 1];
-      p[2] = src[i];
-      p[3] = src[i + 1];
-      p[4] = src[i + sstride];
-      PIX_SORT (p[0], p[1]);
-      PIX_SORT (p[3], p[4]);
-      PIX_SORT (p[0], p[3]);
-      PIX_SORT (p[1], p[4]);
-      PIX_SORT (p[1], p[2]);
-      PIX_SORT (p[2], p[3]);
-      PIX_SORT (p[1], p[2]);
-      dest[i] = p[2];
-    }
-    dest[i] = src[i];
+/* The median of a 3x3 window is the median of the largest of the column
+ * minimums, the median of the column medians and the smallest of the column
+ * maximums. Each column is sorted once for the three windows sharing it. */
+static inline void
+median_9_pixels (guint8 * out, const guint8 * lo, const guint8 * mid,
+    const guint8 * hi, gint n)
+{
+  gint i;
+
+  for (i = 0; i < n; i++) {
+    guint8 l = MAX (MAX (lo[i], lo[i + 1]), lo[i + 2]);
+    guint8 h = MIN (MIN (hi[i], hi[i + 1]), hi[i + 2]);
+    guint8 a = mid[i];
+    guint8 m = mid[i + 1];
+    guint8 c = mid[i + 2];
+
+    PIX_SORT (a, m);
+    PIX_SORT (m, c);
+    PIX_SORT (a, m);
+    PIX_SORT (l, m);
+    PIX_SORT (m, h);
+    PIX_SORT (l, m);
+    out[i] = m;
   }
 }
 
 static void
-median_9 (guint8 * dest, gint dstride, const guint8 * src, gint sstride,
-    gint width, gint height)
+median_9_row (guint8 * dest, const guint8 * src, gint sstride, gint width)
+{
+  guint8 lo[MEDIAN_BLOCK + 2], mid[MEDIAN_BLOCK + 2], hi[MEDIAN_BLOCK + 2];
+  guint8 out[MEDIAN_BLOCK];
+  gint i, n;
+
+  for (i = 1; i < width - 1; i += n) {
+    n = MIN (MEDIAN_BLOCK, width - 1 - i);
+    if (n == MEDIAN_BLOCK) {
+      median_9_columns (lo, mid, hi, src + i - 1, sstride, MEDIAN_BLOCK);
+      median_9_columns (lo + MEDIAN_BLOCK, mid + MEDIAN_BLOCK,
+          hi + MEDIAN_BLOCK, src + i - 1 + MEDIAN_BLOCK, sstride, 2);
+      median_9_pixels (out, lo, mid, hi, MEDIAN_BLOCK);
+    } else {
+      median_9_columns (lo, mid, hi, src + i - 1, sstride, n + 2);
+      median_9_pixels (out, lo, mid, hi, n);
+    }
+    memcpy (dest + i, out, n);
+  }
+}
+
+/* returns the first of 16 bins where the running count exceeds @half, and
+ * in @below the count before it. Branch-free, as the bin is unpredictable. */
+static inline gint
+median_hist_find (const guint8 * hist, gint half, gint * below)
 {
-  unsigned char p[9];
-  int i, j, k;
+  gint i, bin = 0, sum = 0, prev = 0;
 
-  /*copy the top and bottom rows into the result array */
-  for (i = 0; i < width; i++) {
-    dest[i] = src[i];
-    dest[(height - 1) * dstride + i] = src[(height - 1) * sstride + i];
+  for (i = 0; i < 16; i++) {
+    sum += hist[i];
+    bin += sum <= half;
+    prev = sum <= half ? sum : prev;
   }
-  /* process the interior pixels */
-  for (k = 2; k < height; k++) {
-    dest += dstride;
-    src += sstride;
-
-    dest[0] = src[0];
-    for (j = 2, i = 1; j < width; j++, i++) {
-      p[0] = src[i - sstride - 1];
-      p[1] = src[i - sstride];
-      p[2] = src[i - sstride + 1];
-      p[3] = src[i - 1];
-      p[4] = src[i];
-      p[5] = src[i + 1];
-      p[6] = src[i + sstride - 1];
-      p[7] = src[i + sstride];
-      p[8] = src[i + sstride + 1];
-      PIX_SORT (p[1], p[2]);
-      PIX_SORT (p[4], p[5]);
-      PIX_SORT (p[7], p[8]);
-      PIX_SORT (p[0], p[1]);
-      PIX_SORT (p[3], p[4]);
-      PIX_SORT (p[6], p[7]);
-      PIX_SORT (p[1], p[2]);
-      PIX_SORT (p[4], p[5]);
-      PIX_SORT (p[7], p[8]);
-      PIX_SORT (p[0], p[3]);
-      PIX_SORT (p[5], p[8]);
-      PIX_SORT (p[4], p[7]);
-      PIX_SORT (p[3], p[6]);
-      PIX_SORT (p[1], p[4]);
-      PIX_SORT (p[2], p[5]);
-      PIX_SORT (p[4], p[7]);
-      PIX_SORT (p[4], p[2]);
-      PIX_SORT (p[6], p[4]);
-      PIX_SORT (p[4], p[2]);
-      dest[i] = p[4];
+  *below = prev;
+
+  return bin;
+}
+
+static void
+median_hist (guint8 * dest, gint dstride, const guint8 * src, gint sstride,
+    gint width, gint height, gint radius, gint y0, gint y1)
+{
+  guint8 (*cols)[256], (*coarse_cols)[16];
+  guint8 fine[16][16], coarse[16];
+  gint last[16];
+  gint size = 2 * radius + 1;
+  gint half = size * size / 2;
+  gint i, x, y, v, b, p, sum, below;
+
+  cols = g_new0 (guint8[256], width);
+  coarse_cols = g_new0 (guint8[16], width);
+
+  for (y = y0 - radius; y < y0 + radius; y++) {
+    for (x = 0; x < width; x++) {
+      v = src[y * sstride + x];
+      cols[x][v]++;
+      coarse_cols[x][v >> 4]++;
     }
-    dest[i] = src[i];
   }
+
+  for (y = y0; y < y1; y++) {
+    const guint8 *add = src + (y + radius) * sstride;
+    guint8 *d = dest + y * dstride;
+
+    /* slide the column histograms down to cover this row */
+    for (x = 0; x < width; x++) {
+      v = add[x];
+      cols[x][v]++;
+      coarse_cols[x][v >> 4]++;
+    }
+    if (y > y0) {
+      const guint8 *remove = src + (y - radius - 1) * sstride;
+
+      for (x = 0; x < width; x++) {
+        v = remove[x];
+        cols[x][v]--;
+        coarse_cols[x][v >> 4]--;
+      }
+    }
+
+    median_copy_edges (d, src + y * sstride, width, radius);
+
+    memset (coarse, 0, sizeof (coarse));
+    for (x = 0; x < size - 1; x++)
+      for (i = 0; i < 16; i++)
+        coarse[i] += coarse_cols[x][i];
+    for (b = 0; b < 16; b++)
+      last[b] = -size;
+
+    for (x = radius; x < width - radius; x++) {
+      for (i = 0; i < 16; i++)
+        coarse[i] += coarse_cols[x + radius][i];
+
+      b = median_hist_find (coarse, half, &sum);
+
+      if (x - last[b] >= size) {
+        memset (fine[b], 0, 16);
+        for (p = x - radius; p <= x + radius; p++)
+          for (i = 0; i < 16; i++)
+            fine[b][i] += cols[p][b * 16 + i];
+      } else {
+        for (p = last[b] + 1; p <= x; p++) {
+          for (i = 0; i < 16; i++)
+            fine[b][i] += cols[p + radius][b * 16 + i] -
+                cols[p - radius - 1][b * 16 + i];
+        }
+      }
+      last[b] = x;
+
+      d[x] = b * 16 + median_hist_find (fine[b], half - sum, &below);
+
+      for (i = 0; i < 16; i++)
+        coarse[i] -= coarse_cols[x - radius][i];
+    }
+  }
+
+  g_free (cols);
+  g_free (coarse_cols);
 }
 
-static GstFlowReturn
-gst_video_median_transform_frame (GstVideoFilter * filter,
-    GstVideoFrame * in_frame, GstVideoFrame * out_frame)
+/* Filters rows @y0 to @y1 of a plane. Rows and columns the window does not
+ * fit around are copied. */
+static void
+median_plane (GstVideoMedianSize filtersize, guint8 * dest, gint dstride,
+    const guint8 * src, gint sstride, gint width, gint height, gint y0, gint y1)
 {
-  GstVideoMedian *median = GST_VIDEO_MEDIAN (filter);
+  gint radius, y, start, end;
 
-  if (median->filtersize == 5) {
-    median_5 (GST_VIDEO_FRAME_PLANE_DATA (out_frame, 0),
-        GST_VIDEO_FRAME_PLANE_STRIDE (out_frame, 0),
-        GST_VIDEO_FRAME_PLANE_DATA (in_frame, 0),
-        GST_VIDEO_FRAME_PLANE_STRIDE (in_frame, 0),
-        GST_VIDEO_FRAME_WIDTH (in_frame), GST_VIDEO_FRAME_HEIGHT (in_frame));
+  switch (filtersize) {
+    case GST_VIDEO_MEDIAN_SIZE_25:
+      radius = 2;
+      break;
+    case GST_VIDEO_MEDIAN_SIZE_49:
+      radius = 3;
+      break;
+    case GST_VIDEO_MEDIAN_SIZE_81:
+      radius = 4;
+      break;
+    default:
+      radius = 1;
+      break;
+  }
 
-    if (median->lum_only) {
-      gst_video_frame_copy_plane (out_frame, in_frame, 1);
-      gst_video_frame_copy_plane (out_frame, in_frame, 2);
-    } else {
-      median_5 (GST_VIDEO_FRAME_PLANE_DATA (out_frame, 1),
-          GST_VIDEO_FRAME_PLANE_STRIDE (out_frame, 1),
-          GST_VIDEO_FRAME_PLANE_DATA (in_frame, 1),
-          GST_VIDEO_FRAME_PLANE_STRIDE (in_frame, 1),
-          GST_VIDEO_FRAME_WIDTH (in_frame) / 2,
-          GST_VIDEO_FRAME_HEIGHT (in_frame) / 2);
-      median_5 (GST_VIDEO_FRAME_PLANE_DATA (out_frame, 2),
-          GST_VIDEO_FRAME_PLANE_STRIDE (out_frame, 2),
-          GST_VIDEO_FRAME_PLANE_DATA (in_frame, 2),
-          GST_VIDEO_FRAME_PLANE_STRIDE (in_frame, 2),
-          GST_VIDEO_FRAME_WIDTH (in_frame) / 2,
-          GST_VIDEO_FRAME_HEIGHT (in_frame) / 2);
+  start = CLAMP (radius, y0, y1);
+  end = CLAMP (height - radius, start, y1);
+
+  for (y = y0; y < start; y++)
+    memcpy (dest + y * dstride, src + y * sstride, width);
+  for (y = end; y < y1; y++)
+    memcpy (dest + y * dstride, src + y * sstride, width);
+
+  if (start == end)
+    return;
+
+  if (filtersize == GST_VIDEO_MEDIAN_SIZE_5 ||
+      filtersize == GST_VIDEO_MEDIAN_SIZE_9) {
+    for (y = start; y < end; y++) {
+      guint8 *d = dest + y * dstride;
+      const guint8 *s = src + y * sstride;
+
+      median_copy_edges (d, s, width, radius);
+      if (filtersize == GST_VIDEO_MEDIAN_SIZE_9)
+        median_9_row (d, s, sstride, width);
+      else
+        median_5_row (d, s, sstride, width);
     }
   } else {
-    median_9 (GST_VIDEO_FRAME_PLANE_DATA (out_frame, 0),
-        GST_VIDEO_FRAME_PLANE_STRIDE (out_frame, 0),
-        GST_VIDEO_FRAME_PLANE_DATA (in_frame, 0),
-        GST_VIDEO_FRAME_PLANE_STRIDE (in_frame, 0),
-        GST_VIDEO_FRAME_WIDTH (in_frame), GST_VIDEO_FRAME_HEIGHT (in_frame));
-
-    if (median->lum_only) {
-      gst_video_frame_copy_plane (out_frame, in_frame, 1);
-      gst_video_frame_copy_plane (out_frame, in_frame, 2);
+    median_hist (dest, dstride, src, sstride, width, height, radius, start,
+        end);
+  }
+}
+
+typedef struct
+{
+  GstVideoFrame *in_frame, *out_frame;
+  GstVideoMedianSize filtersize;
+  gboolean lum_only;
+} GstVideoMedianJob;
+
+static void
+gst_video_median_process_rows (GstVideoMedianJob * job, gint y, gint height)
+{
+  GstVideoFrame *in_frame = job->in_frame, *out_frame = job->out_frame;
+  const GstVideoFormatInfo *finfo = in_frame->info.finfo;
+  gint c, y0, y1, row;
+
+  for (c = 0; c < 3; c++) {
+    guint8 *dest = GST_VIDEO_FRAME_COMP_DATA (out_frame, c);
+    const guint8 *src = GST_VIDEO_FRAME_COMP_DATA (in_frame, c);
+    gint dstride = GST_VIDEO_FRAME_COMP_STRIDE (out_frame, c);
+    gint sstride = GST_VIDEO_FRAME_COMP_STRIDE (in_frame, c);
+    gint width = GST_VIDEO_FRAME_COMP_WIDTH (in_frame, c);
+
+    y0 = GST_VIDEO_FORMAT_INFO_SCALE_HEIGHT (finfo, c, y);
+    y1 = GST_VIDEO_FORMAT_INFO_SCALE_HEIGHT (finfo, c, y + height);
+
+    if (c > 0 && job->lum_only) {
+      for (row = y0; row < y1; row++)
+        memcpy (dest + row * dstride, src + row * sstride, width);
     } else {
-      median_9 (GST_VIDEO_FRAME_PLANE_DATA (out_frame, 1),
-          GST_VIDEO_FRAME_PLANE_STRIDE (out_frame, 1),
-          GST_VIDEO_FRAME_PLANE_DATA (in_frame, 1),
-          GST_VIDEO_FRAME_PLANE_STRIDE (in_frame, 1),
-          GST_VIDEO_FRAME_WIDTH (in_frame) / 2,
-          GST_VIDEO_FRAME_HEIGHT (in_frame) / 2);
-      median_9 (GST_VIDEO_FRAME_PLANE_DATA (out_frame, 2),
-          GST_VIDEO_FRAME_PLANE_STRIDE (out_frame, 2),
-          GST_VIDEO_FRAME_PLANE_DATA (in_frame, 2),
-          GST_VIDEO_FRAME_PLANE_STRIDE (in_frame, 2),
-          GST_VIDEO_FRAME_WIDTH (in_frame) / 2,
-          GST_VIDEO_FRAME_HEIGHT (in_frame) / 2);
+      median_plane (job->filtersize, dest, dstride, src, sstride, width,
+          GST_VIDEO_FRAME_COMP_HEIGHT (in_frame, c), y0, y1);
     }
   }
+}
+
+static GstFlowReturn
+gst_video_median_transform_frame (GstVideoFilter * filter,
+    GstVideoFrame * in_frame, GstVideoFrame * out_frame)
+{
+  GstVideoMedian *median = GST_VIDEO_MEDIAN (filter);
+  GstVideoMedianJob job;
+
+  job.in_frame = in_frame;
+  job.out_frame = out_frame;
+  job.filtersize = median->filtersize;
+  job.lum_only = median->lum_only;
+
+  /* bands start on even rows so they split the chroma planes too */
+  gst_video_bands_process_rows (&median->bands, median->n_threads,
+      GST_VIDEO_FRAME_HEIGHT (in_frame), 2,
+      (GstVideoBandsRowsFunc) gst_video_median_process_rows, &job);
 
   return GST_FLOW_OK;
 }
@@ -300,6 +512,9 @@ gst_video_median_set_property (GObject * object, guint prop_id,
     case PROP_LUM_ONLY:
       median->lum_only = g_value_get_boolean (value);
       break;
+    case PROP_N_THREADS:
+      median->n_threads = g_value_get_uint (value);
+      break;
     default:
       break;
   }
@@ -320,6 +535,9 @@ gst_video_median_get_property (GObject * object, guint prop_id, GValue * value,
     case PROP_LUM_ONLY:
       g_value_set_boolean (value, median->lum_only);
       break;
+    case PROP_N_THREADS:
+      g_value_set_uint (value, median->n_threads);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -26,6 +26,8 @@
 #include <gst/video/video.h>
 #include <gst/video/gstvideofilter.h>
 
+#include <gst/video-bands-private.h>
+
 G_BEGIN_DECLS
 
 #define GST_TYPE_VIDEO_MEDIAN \
@@ -45,7 +47,10 @@ typedef struct _GstVideoMedianClass GstVideoMedianClass;
 typedef enum
 {
   GST_VIDEO_MEDIAN_SIZE_5 = 5,
-  GST_VIDEO_MEDIAN_SIZE_9 = 9
+  GST_VIDEO_MEDIAN_SIZE_9 = 9,
+  GST_VIDEO_MEDIAN_SIZE_25 = 25,
+  GST_VIDEO_MEDIAN_SIZE_49 = 49,
+  GST_VIDEO_MEDIAN_SIZE_81 = 81
 } GstVideoMedianSize;
 
 struct _GstVideoMedian {
@@ -53,6 +58,9 @@ struct _GstVideoMedian {
 
   GstVideoMedianSize filtersize;
   gboolean lum_only;
+  guint n_threads;
+
+  GstVideoBands bands;
 };
 
 struct _GstVideoMedianClass {
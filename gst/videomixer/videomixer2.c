@@ -421,6 +421,7 @@ gst_videomixer2_update_converters (GstVideoMixer2 * mix)
   }
 
   mix->info = best_info;
+  mix->damaged = TRUE;
 
   GST_DEBUG_OBJECT (mix,
       "The output format will now be : %d with colorimetry : %s and chroma : %s",
@@ -443,6 +444,7 @@ gst_videomixer2_update_converters (GstVideoMixer2 * mix)
       gst_video_converter_free (pad->convert);
 
     pad->convert = NULL;
+    gst_buffer_replace (&pad->converted_buf, NULL);
 
     colorimetry = gst_video_colorimetry_to_string (&(pad->info.colorimetry));
     chroma = gst_video_chroma_to_string (pad->info.chroma_site);
@@ -710,17 +712,40 @@ gst_videomixer2_pad_set_property (GObject * object, guint prop_id,
 
       mix->sinkpads = g_slist_sort (mix->sinkpads,
           (GCompareFunc) pad_zorder_compare);
+      mix->damaged = TRUE;
       GST_VIDEO_MIXER2_UNLOCK (mix);
       break;
     case PROP_PAD_XPOS:
-      pad->xpos = g_value_get_int (value);
+    {
+      gint xpos = g_value_get_int (value);
+
+      /* the controller sets values on every frame, only changes count */
+      if (pad->xpos != xpos) {
+        pad->xpos = xpos;
+        pad->damaged = TRUE;
+      }
       break;
+    }
     case PROP_PAD_YPOS:
-      pad->ypos = g_value_get_int (value);
+    {
+      gint ypos = g_value_get_int (value);
+
+      if (pad->ypos != ypos) {
+        pad->ypos = ypos;
+        pad->damaged = TRUE;
+      }
       break;
+    }
     case PROP_PAD_ALPHA:
-      pad->alpha = g_value_get_double (value);
+    {
+      gdouble alpha = g_value_get_double (value);
+
+      if (pad->alpha != alpha) {
+        pad->alpha = alpha;
+        pad->damaged = TRUE;
+      }
       break;
+    }
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -764,14 +789,18 @@ gst_videomixer2_pad_init (GstVideoMixer2Pad * mixerpad)
   mixerpad->alpha = DEFAULT_PAD_ALPHA;
   mixerpad->convert = NULL;
   mixerpad->need_conversion_update = FALSE;
+  mixerpad->converted_buf = NULL;
+  mixerpad->damaged = TRUE;
 }
 
 /* GstVideoMixer2 */
 #define DEFAULT_BACKGROUND VIDEO_MIXER2_BACKGROUND_CHECKER
+#define DEFAULT_N_THREADS 1
 enum
 {
   PROP_0,
-  PROP_BACKGROUND
+  PROP_BACKGROUND,
+  PROP_N_THREADS
 };
 
 #define GST_TYPE_VIDEO_MIXER2_BACKGROUND (gst_videomixer2_background_get_type())
@@ -865,9 +894,15 @@ gst_videomixer2_reset (GstVideoMixer2 * mix)
     mixcol->start_time = -1;
     mixcol->end_time = -1;
 
+    gst_buffer_replace (&p->converted_buf, NULL);
+    p->damaged = TRUE;
+
     gst_video_info_init (&p->info);
   }
 
+  gst_buffer_replace (&mix->last_outbuf, NULL);
+  mix->damaged = TRUE;
+
   mix->newseg_pending = TRUE;
 }
 
@@ -993,6 +1028,9 @@ gst_videomixer2_fill_queues (GstVideoMixer2 * mix,
             GST_TIME_ARGS (start_time));
         gst_buffer_replace (&mixcol->buffer, buf);
         mixcol->buffer_vinfo = *vinfo;
+        /* a new input invalidates the converted copy of the previous one */
+        gst_buffer_replace (&pad->converted_buf, NULL);
+        pad->damaged = TRUE;
         mixcol->start_time = start_time;
         mixcol->end_time = end_time;
 
@@ -1028,6 +1066,8 @@ gst_videomixer2_fill_queues (GstVideoMixer2 * mix,
       if (mixcol->end_time != -1) {
         if (mixcol->end_time <= output_start_time) {
           gst_buffer_replace (&mixcol->buffer, NULL);
+          gst_buffer_replace (&pad->converted_buf, NULL);
+          pad->damaged = TRUE;
           mixcol->start_time = mixcol->end_time = -1;
           if (!GST_COLLECT_PADS_STATE_IS_SET (mixcol,
                   GST_COLLECT_PADS_STATE_EOS))
@@ -1048,6 +1088,211 @@ gst_videomixer2_fill_queues (GstVideoMixer2 * mix,
   return 1;
 }
 
+/* A pad taking part in the current output frame */
+typedef struct
+{
+  GstVideoMixer2Pad *pad;
+
+  /* area of the output frame touched when blending the pad */
+  gint x0, y0, x1, y1;
+  /* area completely overwritten by the pad, only meaningful if opaque */
+  gint cx0, cy0, cx1, cy1;
+  gboolean opaque;
+
+  /* pads of the same wave don't overlap and can be blended in parallel */
+  guint wave;
+} GstVideoMixer2Layer;
+
+typedef struct
+{
+  GstVideoMixer2Layer **layers;
+  guint n_layers;
+  gint next;
+
+  BlendFunction composite;
+  GstVideoFrame *outframe;
+} GstVideoMixer2BlendJob;
+
+/* blend.c rounds positions up to the chroma subsampling and always writes
+ * whole chroma samples, so the areas touched by a pad are aligned to it */
+static void
+gst_videomixer2_blend_alignment (const GstVideoInfo * info, gint * xalign,
+    gint * yalign)
+{
+  guint i, w_sub = 0, h_sub = 0;
+
+  for (i = 0; i < GST_VIDEO_INFO_N_COMPONENTS (info); i++) {
+    w_sub = MAX (w_sub, GST_VIDEO_FORMAT_INFO_W_SUB (info->finfo, i));
+    h_sub = MAX (h_sub, GST_VIDEO_FORMAT_INFO_H_SUB (info->finfo, i));
+  }
+
+  *xalign = 1 << w_sub;
+  *yalign = 1 << h_sub;
+}
+
+/* Returns FALSE if blending @pad would not change the output frame */
+static gboolean
+gst_videomixer2_layer_init (GstVideoMixer2 * mix, GstVideoMixer2Layer * layer,
+    GstVideoMixer2Pad * pad, gint xalign, gint yalign)
+{
+  gint out_width = GST_VIDEO_INFO_WIDTH (&mix->info);
+  gint out_height = GST_VIDEO_INFO_HEIGHT (&mix->info);
+  const GstVideoInfo *info = pad->convert ? &pad->conversion_info :
+      &pad->mixcol->buffer_vinfo;
+  gint width = GST_VIDEO_INFO_WIDTH (info);
+  gint height = GST_VIDEO_INFO_HEIGHT (info);
+  gint x = GST_ROUND_UP_N (pad->xpos, xalign);
+  gint y = GST_ROUND_UP_N (pad->ypos, yalign);
+
+  layer->pad = pad;
+  layer->x0 = MAX (x, 0);
+  layer->y0 = MAX (y, 0);
+  layer->x1 = MIN (x + GST_ROUND_UP_N (width, xalign), out_width);
+  layer->y1 = MIN (y + GST_ROUND_UP_N (height, yalign), out_height);
+
+  /* With alpha 1.0 and no alpha channel blend.c copies the pixels. Partial
+   * chroma samples at the right and bottom edges only count as covered if
+   * they are clipped by the output frame. */
+  layer->opaque = pad->alpha >= 1.0 && !GST_VIDEO_INFO_HAS_ALPHA (&mix->info);
+  layer->cx0 = layer->x0;
+  layer->cy0 = layer->y0;
+  layer->cx1 = x + width >= out_width ? out_width :
+      x + GST_ROUND_DOWN_N (width, xalign);
+  layer->cy1 = y + height >= out_height ? out_height :
+      y + GST_ROUND_DOWN_N (height, yalign);
+
+  layer->wave = 0;
+
+  return pad->alpha > 0.0 && layer->x0 < layer->x1 && layer->y0 < layer->y1;
+}
+
+static inline gboolean
+gst_videomixer2_layer_overlaps (const GstVideoMixer2Layer * a,
+    const GstVideoMixer2Layer * b)
+{
+  return a->x0 < b->x1 && b->x0 < a->x1 && a->y0 < b->y1 && b->y0 < a->y1;
+}
+
+/* TRUE if @upper overwrites everything @lower would touch */
+static inline gboolean
+gst_videomixer2_layer_occludes (const GstVideoMixer2Layer * upper,
+    const GstVideoMixer2Layer * lower)
+{
+  return upper->opaque && upper->cx0 <= lower->x0 && upper->cy0 <= lower->y0
+      && upper->cx1 >= lower->x1 && upper->cy1 >= lower->y1;
+}
+
+static void
+gst_videomixer2_blend_layer (GstVideoMixer2Layer * layer,
+    BlendFunction composite, GstVideoFrame * outframe)
+{
+  GstVideoMixer2Pad *pad = layer->pad;
+  GstVideoMixer2Collect *mixcol = pad->mixcol;
+  GstVideoFrame frame, converted_frame;
+
+  if (pad->convert) {
+    if (!pad->converted_buf) {
+      static GstAllocationParams params = { 0, 15, 0, 0, };
+      gint converted_size;
+
+      gst_video_frame_map (&frame, &mixcol->buffer_vinfo, mixcol->buffer,
+          GST_MAP_READ);
+
+      converted_size = pad->conversion_info.size;
+      converted_size = MAX (converted_size, outframe->info.size);
+      pad->converted_buf =
+          gst_buffer_new_allocate (NULL, converted_size, &params);
+
+      gst_video_frame_map (&converted_frame, &(pad->conversion_info),
+          pad->converted_buf, GST_MAP_WRITE);
+      gst_video_converter_frame (pad->convert, &frame, &converted_frame);
+      gst_video_frame_unmap (&converted_frame);
+      gst_video_frame_unmap (&frame);
+    } else {
+      GST_LOG_OBJECT (pad, "reusing converted input");
+    }
+
+    gst_video_frame_map (&converted_frame, &(pad->conversion_info),
+        pad->converted_buf, GST_MAP_READ);
+  } else {
+    gst_video_frame_map (&converted_frame, &mixcol->buffer_vinfo,
+        mixcol->buffer, GST_MAP_READ);
+  }
+
+  composite (&converted_frame, pad->xpos, pad->ypos, pad->alpha, outframe);
+
+  gst_video_frame_unmap (&converted_frame);
+}
+
+static void
+gst_videomixer2_run_blend_job (GstVideoMixer2BlendJob * job)
+{
+  gint i;
+
+  while ((i = g_atomic_int_add (&job->next, 1)) < (gint) job->n_layers)
+    gst_videomixer2_blend_layer (job->layers[i], job->composite,
+        job->outframe);
+}
+
+static void
+gst_videomixer2_blend_worker (GstVideoMixer2BlendJob * job,
+    GstVideoMixer2 * mix)
+{
+  gst_videomixer2_run_blend_job (job);
+
+  g_mutex_lock (&mix->blend_lock);
+  if (--mix->blends_pending == 0)
+    g_cond_signal (&mix->blend_cond);
+  g_mutex_unlock (&mix->blend_lock);
+}
+
+/* blend @n_layers non-overlapping layers, on the worker pool if there are
+ * several of them */
+static void
+gst_videomixer2_blend_wave (GstVideoMixer2 * mix, GstVideoMixer2Layer ** layers,
+    guint n_layers, BlendFunction composite, GstVideoFrame * outframe)
+{
+  GstVideoMixer2BlendJob job;
+  guint n_threads, n_workers, i;
+
+  job.layers = layers;
+  job.n_layers = n_layers;
+  job.next = 0;
+  job.composite = composite;
+  job.outframe = outframe;
+
+  n_threads = mix->n_threads;
+  if (n_threads == 0)
+    n_threads = g_get_num_processors ();
+  n_workers = MIN (n_threads, n_layers) - 1;
+
+  if (n_workers == 0) {
+    gst_videomixer2_run_blend_job (&job);
+    return;
+  }
+
+  if (!mix->blend_pool) {
+    mix->blend_pool =
+        g_thread_pool_new ((GFunc) gst_videomixer2_blend_worker, mix,
+        n_workers, FALSE, NULL);
+  } else if (g_thread_pool_get_max_threads (mix->blend_pool) <
+      (gint) n_workers) {
+    g_thread_pool_set_max_threads (mix->blend_pool, n_workers, NULL);
+  }
+
+  mix->blends_pending = n_workers;
+  for (i = 0; i < n_workers; i++)
+    g_thread_pool_push (mix->blend_pool, &job, NULL);
+
+  /* the streaming thread picks up layers too */
+  gst_videomixer2_run_blend_job (&job);
+
+  g_mutex_lock (&mix->blend_lock);
+  while (mix->blends_pending > 0)
+    g_cond_wait (&mix->blend_cond, &mix->blend_lock);
+  g_mutex_unlock (&mix->blend_lock);
+}
+
 static GstFlowReturn
 gst_videomixer2_blend_buffers (GstVideoMixer2 * mix,
     GstClockTime output_start_time, GstClockTime output_end_time,
@@ -1058,53 +1303,19 @@ gst_videomixer2_blend_buffers (GstVideoMixer2 * mix,
   BlendFunction composite;
   GstVideoFrame outframe;
   static GstAllocationParams params = { 0, 15, 0, 0, };
+  GstVideoMixer2Layer *layers, **wave_layers, **batch;
+  guint n_layers, n_visible, n_waves, i, j, wave;
+  gint xalign, yalign;
+  gboolean damaged, fill_background = TRUE;
 
-  outsize = GST_VIDEO_INFO_SIZE (&mix->info);
-
-  *outbuf = gst_buffer_new_allocate (NULL, outsize, &params);
-  GST_BUFFER_TIMESTAMP (*outbuf) = output_start_time;
-  GST_BUFFER_DURATION (*outbuf) = output_end_time - output_start_time;
-
-  gst_video_frame_map (&outframe, &mix->info, *outbuf, GST_MAP_READWRITE);
-
-  /* default to blending */
-  composite = mix->blend;
-  switch (mix->background) {
-    case VIDEO_MIXER2_BACKGROUND_CHECKER:
-      mix->fill_checker (&outframe);
-      break;
-    case VIDEO_MIXER2_BACKGROUND_BLACK:
-      mix->fill_color (&outframe, 16, 128, 128);
-      break;
-    case VIDEO_MIXER2_BACKGROUND_WHITE:
-      mix->fill_color (&outframe, 240, 128, 128);
-      break;
-    case VIDEO_MIXER2_BACKGROUND_TRANSPARENT:
-    {
-      guint i, plane, num_planes, height;
-
-      num_planes = GST_VIDEO_FRAME_N_PLANES (&outframe);
-      for (plane = 0; plane < num_planes; ++plane) {
-        guint8 *pdata;
-        gsize rowsize, plane_stride;
-
-        pdata = GST_VIDEO_FRAME_PLANE_DATA (&outframe, plane);
-        plane_stride = GST_VIDEO_FRAME_PLANE_STRIDE (&outframe, plane);
-        rowsize = GST_VIDEO_FRAME_COMP_WIDTH (&outframe, plane)
-            * GST_VIDEO_FRAME_COMP_PSTRIDE (&outframe, plane);
-        height = GST_VIDEO_FRAME_COMP_HEIGHT (&outframe, plane);
-        for (i = 0; i < height; ++i) {
-          memset (pdata, 0, rowsize);
-          pdata += plane_stride;
-        }
-      }
+  layers = g_newa (GstVideoMixer2Layer, mix->numpads);
+  wave_layers = g_newa (GstVideoMixer2Layer *, mix->numpads);
+  batch = g_newa (GstVideoMixer2Layer *, mix->numpads);
+  gst_videomixer2_blend_alignment (&mix->info, &xalign, &yalign);
 
-      /* use overlay to keep background transparent */
-      composite = mix->overlay;
-      break;
-    }
-  }
+  damaged = mix->damaged || mix->background != mix->last_background;
 
+  n_layers = 0;
   for (l = mix->sinkpads; l; l = l->next) {
     GstVideoMixer2Pad *pad = l->data;
     GstVideoMixer2Collect *mixcol = pad->mixcol;
@@ -1113,9 +1324,6 @@ gst_videomixer2_blend_buffers (GstVideoMixer2 * mix,
       GstClockTime timestamp;
       gint64 stream_time;
       GstSegment *seg;
-      GstVideoFrame converted_frame;
-      GstBuffer *converted_buf = NULL;
-      GstVideoFrame frame;
 
       seg = &mixcol->collect.segment;
 
@@ -1128,43 +1336,143 @@ gst_videomixer2_blend_buffers (GstVideoMixer2 * mix,
       if (GST_CLOCK_TIME_IS_VALID (stream_time))
         gst_object_sync_values (GST_OBJECT (pad), stream_time);
 
-      gst_video_frame_map (&frame, &mixcol->buffer_vinfo, mixcol->buffer,
-          GST_MAP_READ);
+      /* We wait until here to set the conversion infos, in case mix->info changed */
+      if (pad->convert && pad->need_conversion_update) {
+        pad->conversion_info = mix->info;
+        gst_video_info_set_format (&(pad->conversion_info),
+            GST_VIDEO_INFO_FORMAT (&mix->info), pad->info.width,
+            pad->info.height);
+        pad->need_conversion_update = FALSE;
+        gst_buffer_replace (&pad->converted_buf, NULL);
+      }
 
-      if (pad->convert) {
-        gint converted_size;
+      if (gst_videomixer2_layer_init (mix, &layers[n_layers], pad, xalign,
+              yalign))
+        n_layers++;
+    }
 
-        /* We wait until here to set the conversion infos, in case mix->info changed */
-        if (pad->need_conversion_update) {
-          pad->conversion_info = mix->info;
-          gst_video_info_set_format (&(pad->conversion_info),
-              GST_VIDEO_INFO_FORMAT (&mix->info), pad->info.width,
-              pad->info.height);
-          pad->need_conversion_update = FALSE;
-        }
+    if (pad->damaged) {
+      damaged = TRUE;
+      pad->damaged = FALSE;
+    }
+  }
+  mix->damaged = FALSE;
+  mix->last_background = mix->background;
+
+  /* Nothing changed since the last frame: share its memory. The previous
+   * frame is only kept once a frame was found to be identical to its
+   * predecessor, so changing content doesn't pay for the shared memory. */
+  if (damaged) {
+    gst_buffer_replace (&mix->last_outbuf, NULL);
+  } else if (mix->last_outbuf) {
+    GST_LOG_OBJECT (mix, "inputs unchanged, reusing previous frame");
+    *outbuf = gst_buffer_copy (mix->last_outbuf);
+    GST_BUFFER_TIMESTAMP (*outbuf) = output_start_time;
+    GST_BUFFER_DURATION (*outbuf) = output_end_time - output_start_time;
+    return GST_FLOW_OK;
+  }
 
-        converted_size = pad->conversion_info.size;
-        converted_size = converted_size > outsize ? converted_size : outsize;
-        converted_buf = gst_buffer_new_allocate (NULL, converted_size, &params);
+  /* Drop layers hidden behind an opaque layer above them, and sort the others
+   * into waves: a layer goes one wave after the last layer below it that it
+   * overlaps with */
+  n_visible = 0;
+  n_waves = 0;
+  for (i = 0; i < n_layers; i++) {
+    GstVideoMixer2Layer *layer = &layers[i];
 
-        gst_video_frame_map (&converted_frame, &(pad->conversion_info),
-            converted_buf, GST_MAP_READWRITE);
-        gst_video_converter_frame (pad->convert, &frame, &converted_frame);
-        gst_video_frame_unmap (&frame);
-      } else {
-        converted_frame = frame;
+    for (j = i + 1; j < n_layers; j++) {
+      if (gst_videomixer2_layer_occludes (&layers[j], layer))
+        break;
+    }
+    if (j < n_layers) {
+      GST_LOG_OBJECT (layer->pad, "occluded by %s",
+          GST_PAD_NAME (layers[j].pad));
+      continue;
+    }
+
+    for (j = 0; j < n_visible; j++) {
+      if (gst_videomixer2_layer_overlaps (wave_layers[j], layer))
+        layer->wave = MAX (layer->wave, wave_layers[j]->wave + 1);
+    }
+    n_waves = MAX (n_waves, layer->wave + 1);
+    wave_layers[n_visible++] = layer;
+
+    if (layer->opaque && layer->cx0 == 0 && layer->cy0 == 0
+        && layer->cx1 == GST_VIDEO_INFO_WIDTH (&mix->info)
+        && layer->cy1 == GST_VIDEO_INFO_HEIGHT (&mix->info))
+      fill_background = FALSE;
+  }
+
+  outsize = GST_VIDEO_INFO_SIZE (&mix->info);
+
+  *outbuf = gst_buffer_new_allocate (NULL, outsize, &params);
+  GST_BUFFER_TIMESTAMP (*outbuf) = output_start_time;
+  GST_BUFFER_DURATION (*outbuf) = output_end_time - output_start_time;
+
+  gst_video_frame_map (&outframe, &mix->info, *outbuf, GST_MAP_READWRITE);
+
+  /* default to blending, use overlay to keep background transparent */
+  if (mix->background == VIDEO_MIXER2_BACKGROUND_TRANSPARENT)
+    composite = mix->overlay;
+  else
+    composite = mix->blend;
+
+  if (!fill_background) {
+    GST_LOG_OBJECT (mix, "background completely covered");
+  } else {
+    switch (mix->background) {
+      case VIDEO_MIXER2_BACKGROUND_CHECKER:
+        mix->fill_checker (&outframe);
+        break;
+      case VIDEO_MIXER2_BACKGROUND_BLACK:
+        mix->fill_color (&outframe, 16, 128, 128);
+        break;
+      case VIDEO_MIXER2_BACKGROUND_WHITE:
+        mix->fill_color (&outframe, 240, 128, 128);
+        break;
+      case VIDEO_MIXER2_BACKGROUND_TRANSPARENT:
+      {
+        guint i, plane, num_planes, height;
+
+        num_planes = GST_VIDEO_FRAME_N_PLANES (&outframe);
+        for (plane = 0; plane < num_planes; ++plane) {
+          guint8 *pdata;
+          gsize rowsize, plane_stride;
+
+          pdata = GST_VIDEO_FRAME_PLANE_DATA (&outframe, plane);
+          plane_stride = GST_VIDEO_FRAME_PLANE_STRIDE (&outframe, plane);
+          rowsize = GST_VIDEO_FRAME_COMP_WIDTH (&outframe, plane)
+              * GST_VIDEO_FRAME_COMP_PSTRIDE (&outframe, plane);
+          height = GST_VIDEO_FRAME_COMP_HEIGHT (&outframe, plane);
+          for (i = 0; i < height; ++i) {
+            memset (pdata, 0, rowsize);
+            pdata += plane_stride;
+          }
+        }
+        break;
       }
+    }
+  }
 
-      composite (&converted_frame, pad->xpos, pad->ypos, pad->alpha, &outframe);
+  GST_LOG_OBJECT (mix, "blending %u of %u pads in %u waves", n_visible,
+      n_layers, n_waves);
 
-      if (pad->convert)
-        gst_buffer_unref (converted_buf);
+  for (wave = 0; wave < n_waves; wave++) {
+    guint n_batch = 0;
 
-      gst_video_frame_unmap (&converted_frame);
+    for (i = 0; i < n_visible; i++) {
+      if (wave_layers[i]->wave == wave)
+        batch[n_batch++] = wave_layers[i];
     }
+
+    gst_videomixer2_blend_wave (mix, batch, n_batch, composite, &outframe);
   }
+
   gst_video_frame_unmap (&outframe);
 
+  if (!damaged)
+    mix->last_outbuf = gst_buffer_copy (*outbuf);
+
   return GST_FLOW_OK;
 }
 
@@ -1603,6 +1911,7 @@ gst_videomixer2_src_setcaps (GstPad * pad, GstVideoMixer2 * mix, GstCaps * caps)
   }
 
   mix->info = info;
+  mix->damaged = TRUE;
 
   switch (GST_VIDEO_INFO_FORMAT (&mix->info)) {
     case GST_VIDEO_FORMAT_AYUV:
@@ -2058,8 +2367,10 @@ gst_videomixer2_release_pad (GstElement * element, GstPad * pad)
   if (mixpad->convert)
     gst_video_converter_free (mixpad->convert);
   mixpad->convert = NULL;
+  gst_buffer_replace (&mixpad->converted_buf, NULL);
 
   mix->sinkpads = g_slist_remove (mix->sinkpads, pad);
+  mix->damaged = TRUE;
   gst_child_proxy_child_removed (GST_CHILD_PROXY (mix), G_OBJECT (mixpad),
       GST_OBJECT_NAME (mixpad));
   mix->numpads--;
@@ -2088,9 +2399,14 @@ gst_videomixer2_finalize (GObject * o)
 {
   GstVideoMixer2 *mix = GST_VIDEO_MIXER2 (o);
 
+  if (mix->blend_pool)
+    g_thread_pool_free (mix->blend_pool, FALSE, TRUE);
+
   gst_object_unref (mix->collect);
   g_mutex_clear (&mix->lock);
   g_mutex_clear (&mix->setcaps_lock);
+  g_mutex_clear (&mix->blend_lock);
+  g_cond_clear (&mix->blend_cond);
 
   G_OBJECT_CLASS (parent_class)->finalize (o);
 }
@@ -2107,8 +2423,11 @@ gst_videomixer2_dispose (GObject * o)
     if (mixpad->convert)
       gst_video_converter_free (mixpad->convert);
     mixpad->convert = NULL;
+    gst_buffer_replace (&mixpad->converted_buf, NULL);
   }
 
+  gst_buffer_replace (&mix->last_outbuf, NULL);
+
   if (mix->pending_tags) {
     gst_tag_list_unref (mix->pending_tags);
     mix->pending_tags = NULL;
@@ -2129,6 +2448,9 @@ gst_videomixer2_get_property (GObject * object,
     case PROP_BACKGROUND:
       g_value_set_enum (value, mix->background);
       break;
+    case PROP_N_THREADS:
+      g_value_set_uint (value, mix->n_threads);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -2145,6 +2467,9 @@ gst_videomixer2_set_property (GObject * object,
     case PROP_BACKGROUND:
       mix->background = g_value_get_enum (value);
       break;
+    case PROP_N_THREADS:
+      mix->n_threads = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -2221,6 +2546,21 @@ gst_videomixer2_class_init (GstVideoMixer2Class * klass)
           GST_TYPE_VIDEO_MIXER2_BACKGROUND,
           DEFAULT_BACKGROUND, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstVideoMixer2:n-threads:
+   *
+   * Maximum number of threads used to blend each frame. Pads that don't
+   * overlap each other are converted and blended in parallel. 0 uses one
+   * thread per CPU.
+   *
+   * Since: 1.24
+   */
+  g_object_class_install_property (gobject_class, PROP_N_THREADS,
+      g_param_spec_uint ("n-threads", "Threads",
+          "Maximum number of threads to use (0 = number of CPUs)", 0,
+          G_MAXINT, DEFAULT_N_THREADS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gstelement_class->request_new_pad =
       GST_DEBUG_FUNCPTR (gst_videomixer2_request_new_pad);
   gstelement_class->release_pad =
@@ -2261,8 +2601,10 @@ gst_videomixer2_init (GstVideoMixer2 * mix)
   gst_collect_pads_set_flush_function (mix->collect,
       (GstCollectPadsFlushFunction) gst_videomixer2_flush, mix);
   mix->background = DEFAULT_BACKGROUND;
+  mix->n_threads = DEFAULT_N_THREADS;
   mix->current_caps = NULL;
   mix->pending_tags = NULL;
+  mix->last_outbuf = NULL;
 
   gst_collect_pads_set_function (mix->collect,
       (GstCollectPadsFunction) GST_DEBUG_FUNCPTR (gst_videomixer2_collected),
@@ -2276,6 +2618,8 @@ gst_videomixer2_init (GstVideoMixer2 * mix)
 
   g_mutex_init (&mix->lock);
   g_mutex_init (&mix->setcaps_lock);
+  g_mutex_init (&mix->blend_lock);
+  g_cond_init (&mix->blend_cond);
   /* initialize variables */
   gst_videomixer2_reset (mix);
 }
@@ -120,6 +120,19 @@ struct _GstVideoMixer2
   gboolean live;
 
   GstTagList *pending_tags;
+
+  /* parallel blending of non-overlapping pads */
+  guint n_threads;
+  GThreadPool *blend_pool;
+  GMutex blend_lock;
+  GCond blend_cond;
+  guint blends_pending;
+
+  /* TRUE when pads, caps or zorder changed since the last output frame */
+  gboolean damaged;
+  GstVideoMixer2Background last_background;
+  /* last output frame, reused while none of the inputs change */
+  GstBuffer *last_outbuf;
 };
 
 struct _GstVideoMixer2Class
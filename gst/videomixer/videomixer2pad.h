@@ -70,6 +70,14 @@ struct _GstVideoMixer2Pad
   GstVideoConverter *convert;
 
   gboolean need_conversion_update;
+
+  /* converted copy of mixcol->buffer, kept while the same input buffer is
+   * mixed into consecutive output frames */
+  GstBuffer *converted_buf;
+
+  /* TRUE when the input buffer or the position/alpha changed since the
+   * last output frame */
+  gboolean damaged;
 };
 
 struct _GstVideoMixer2PadClass
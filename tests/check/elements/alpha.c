@@ -18,6 +18,10 @@
  * Boston, MA 02110-1301, USA.
  */
 
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
 #include <gst/check/gstcheck.h>
 #include <gst/video/video.h>
 
@@ -255,6 +259,342 @@ GST_START_TEST (test_alpha)
 
 GST_END_TEST;
 
+static const GstVideoFormat slice_formats[] = {
+  GST_VIDEO_FORMAT_AYUV, GST_VIDEO_FORMAT_ARGB, GST_VIDEO_FORMAT_RGB,
+  GST_VIDEO_FORMAT_I420, GST_VIDEO_FORMAT_Y41B, GST_VIDEO_FORMAT_YUY2
+};
+
+static GstBuffer *
+run_alpha (GstVideoInfo * info, GstBuffer * inbuffer, const gchar * method,
+    guint n_threads, GstClockTime * elapsed)
+{
+  GstHarness *h = gst_harness_new ("alpha");
+  GstClockTime start;
+  GstBuffer *outbuffer;
+
+  gst_util_set_object_arg (G_OBJECT (h->element), "method", method);
+  g_object_set (h->element, "alpha", 0.75, "n-threads", n_threads, NULL);
+  gst_harness_set_src_caps (h, gst_video_info_to_caps (info));
+
+  start = gst_util_get_timestamp ();
+  outbuffer = gst_harness_push_and_pull (h, gst_buffer_ref (inbuffer));
+  if (elapsed)
+    *elapsed = gst_util_get_timestamp () - start;
+  fail_unless (outbuffer != NULL);
+
+  gst_harness_teardown (h);
+
+  return outbuffer;
+}
+
+static GstBuffer *
+create_buffer_random (GstVideoInfo * info)
+{
+  GstBuffer *buf = gst_buffer_new_and_alloc (GST_VIDEO_INFO_SIZE (info));
+  GstMapInfo map;
+  gsize i;
+
+  gst_buffer_map (buf, &map, GST_MAP_WRITE);
+  for (i = 0; i < map.size; i++)
+    map.data[i] = g_random_int ();
+  gst_buffer_unmap (buf, &map);
+
+  return buf;
+}
+
+/* processing a frame in row bands must give exactly the same output as
+ * processing it in one go, including for subsampled formats and a height
+ * that doesn't divide evenly */
+GST_START_TEST (test_n_threads)
+{
+  static const gchar *methods[] = { "set", "green", "custom" };
+  guint f, m;
+
+  for (f = 0; f < G_N_ELEMENTS (slice_formats); f++) {
+    for (m = 0; m < G_N_ELEMENTS (methods); m++) {
+      GstVideoInfo info;
+      GstBuffer *inbuffer, *ref, *outbuffer;
+      GstMapInfo map;
+
+      gst_video_info_set_format (&info, slice_formats[f], 320, 238);
+      inbuffer = create_buffer_random (&info);
+
+      ref = run_alpha (&info, inbuffer, methods[m], 1, NULL);
+      outbuffer = run_alpha (&info, inbuffer, methods[m], 5, NULL);
+
+      GST_DEBUG ("checking %s %s",
+          gst_video_format_to_string (slice_formats[f]), methods[m]);
+      fail_unless_equals_int (gst_buffer_get_size (outbuffer),
+          gst_buffer_get_size (ref));
+      gst_buffer_map (ref, &map, GST_MAP_READ);
+      fail_unless (gst_buffer_memcmp (outbuffer, 0, map.data, map.size) == 0);
+      gst_buffer_unmap (ref, &map);
+
+      gst_buffer_unref (inbuffer);
+      gst_buffer_unref (ref);
+      gst_buffer_unref (outbuffer);
+    }
+  }
+}
+
+GST_END_TEST;
+
+typedef struct
+{
+  const gchar *method;
+  guint target_r, target_g, target_b;
+  gfloat angle;
+  gfloat noise_level;
+  guint black_sensitivity, white_sensitivity;
+} ChromaKeySettings;
+
+/* chroma_keying_yuv() as it was before it became branch-free */
+static gint
+chroma_keying_yuv_reference (gint a, gint * y, gint * u,
+    gint * v, gint cr, gint cb, gint smin, gint smax, guint8 accept_angle_tg,
+    guint8 accept_angle_ctg, guint8 one_over_kc, guint8 kfgy_scale, gint8 kg,
+    guint noise_level2)
+{
+  gint tmp, tmp1;
+  gint x1, y1;
+  gint x, z;
+  gint b_alpha;
+
+  if (*y < smin || *y > smax)
+    return a;
+
+  tmp = ((*u) * cb + (*v) * cr) >> 7;
+  x = CLAMP (tmp, -128, 127);
+  tmp = ((*v) * cb - (*u) * cr) >> 7;
+  z = CLAMP (tmp, -128, 127);
+
+  tmp = (x * accept_angle_tg) >> 4;
+  tmp = MIN (tmp, 127);
+
+  if (abs (z) > tmp)
+    return a;
+
+  tmp = (z * accept_angle_ctg) >> 4;
+  tmp = CLAMP (tmp, -128, 127);
+  x1 = abs (tmp);
+  y1 = z;
+
+  tmp1 = x - x1;
+  tmp1 = MAX (tmp1, 0);
+  b_alpha = (tmp1 * one_over_kc) / 2;
+  b_alpha = 255 - CLAMP (b_alpha, 0, 255);
+  b_alpha = (a * b_alpha) >> 8;
+
+  tmp = (tmp1 * kfgy_scale) >> 4;
+  tmp1 = MIN (tmp, 255);
+
+  *y = (*y < tmp1) ? 0 : *y - tmp1;
+
+  tmp = (x1 * cb - y1 * cr) >> 7;
+  *u = CLAMP (tmp, -128, 127);
+
+  tmp = (x1 * cr + y1 * cb) >> 7;
+  *v = CLAMP (tmp, -128, 127);
+
+  tmp = z * z + (x - kg) * (x - kg);
+  tmp = MIN (tmp, 0xffff);
+
+  if (tmp < noise_level2)
+    b_alpha = 0;
+
+  return b_alpha;
+}
+
+/* keys SDTV AYUV into AYUV with the parameters the element derives from
+ * @settings, with alpha 0.75 */
+static void
+chroma_key_ayuv_reference (const ChromaKeySettings * settings,
+    const guint8 * src, guint8 * dest, gsize n_pixels)
+{
+  static const gint matrix[] = {
+    66, 129, 25, 4096,
+    -38, -74, 112, 32768,
+    112, -94, -18, 32768,
+  };
+  guint target_r = settings->target_r;
+  guint target_g = settings->target_g;
+  guint target_b = settings->target_b;
+  gint smin = 128 - settings->black_sensitivity;
+  gint smax = 128 + settings->white_sensitivity;
+  gint pa = 192;
+  gfloat kgl, tmp, tmp1, tmp2, fy;
+  gint8 cb, cr, kg;
+  guint8 accept_angle_tg, accept_angle_ctg, one_over_kc, kfgy_scale;
+  guint noise_level2;
+  gsize i;
+
+  if (g_str_equal (settings->method, "green")) {
+    target_r = 0;
+    target_g = 255;
+    target_b = 0;
+  } else if (g_str_equal (settings->method, "blue")) {
+    target_r = 0;
+    target_g = 0;
+    target_b = 255;
+  }
+
+  fy = (matrix[0] * ((gint) target_r) + matrix[1] * ((gint) target_g) +
+      matrix[2] * ((gint) target_b) + matrix[3]) >> 8;
+  tmp1 = (matrix[4] * ((gint) target_r) + matrix[5] * ((gint) target_g) +
+      matrix[6] * ((gint) target_b)) >> 8;
+  tmp2 = (matrix[8] * ((gint) target_r) + matrix[9] * ((gint) target_g) +
+      matrix[10] * ((gint) target_b)) >> 8;
+
+  kgl = sqrt (tmp1 * tmp1 + tmp2 * tmp2);
+  cb = 127 * (tmp1 / kgl);
+  cr = 127 * (tmp2 / kgl);
+
+  tmp = 15 * tan (M_PI * settings->angle / 180);
+  tmp = MIN (tmp, 255);
+  accept_angle_tg = tmp;
+  tmp = 15 / tan (M_PI * settings->angle / 180);
+  tmp = MIN (tmp, 255);
+  accept_angle_ctg = tmp;
+  tmp = 1 / (kgl);
+  one_over_kc = (gint) (255 * 2 * tmp - 255);
+  tmp = 15 * fy / kgl;
+  tmp = MIN (tmp, 255);
+  kfgy_scale = tmp;
+  kg = MIN (kgl, 127);
+
+  noise_level2 = settings->noise_level * settings->noise_level;
+
+  for (i = 0; i < n_pixels; i++) {
+    gint a = (src[0] * pa) >> 8;
+    gint y = src[1];
+    gint u = src[2] - 128;
+    gint v = src[3] - 128;
+
+    a = chroma_keying_yuv_reference (a, &y, &u, &v, cr, cb, smin, smax,
+        accept_angle_tg, accept_angle_ctg, one_over_kc, kfgy_scale, kg,
+        noise_level2);
+
+    dest[0] = a;
+    dest[1] = y;
+    dest[2] = u + 128;
+    dest[3] = v + 128;
+
+    src += 4;
+    dest += 4;
+  }
+}
+
+/* the branch-free chroma keying must give exactly the output of the
+ * version with early returns, for every U/V pair and a random luma and
+ * alpha */
+GST_START_TEST (test_chromakeying_bit_exact)
+{
+  static const ChromaKeySettings settings[] = {
+    {"green", 0, 255, 0, 20.0, 2.0, 100, 100},
+    {"blue", 0, 255, 0, 20.0, 2.0, 100, 100},
+    {"custom", 200, 30, 60, 45.0, 8.0, 50, 30},
+    {"custom", 10, 90, 250, 80.0, 64.0, 128, 127},
+    {"custom", 128, 128, 255, 5.0, 0.0, 0, 0},
+  };
+  GstVideoInfo info;
+  GstBuffer *inbuffer, *outbuffer;
+  GstMapInfo in_map, out_map;
+  guint8 *ref;
+  guint s, u, v;
+
+  gst_video_info_set_format (&info, GST_VIDEO_FORMAT_AYUV, 256, 256);
+  fail_unless_equals_int (info.colorimetry.matrix,
+      GST_VIDEO_COLOR_MATRIX_BT601);
+
+  inbuffer = gst_buffer_new_and_alloc (GST_VIDEO_INFO_SIZE (&info));
+  gst_buffer_map (inbuffer, &in_map, GST_MAP_WRITE);
+  for (v = 0; v < 256; v++) {
+    for (u = 0; u < 256; u++) {
+      guint8 *p = in_map.data + v * GST_VIDEO_INFO_PLANE_STRIDE (&info, 0) +
+          u * 4;
+
+      p[0] = g_random_int ();
+      p[1] = g_random_int ();
+      p[2] = u;
+      p[3] = v;
+    }
+  }
+  gst_buffer_unmap (inbuffer, &in_map);
+
+  ref = g_malloc (GST_VIDEO_INFO_SIZE (&info));
+
+  for (s = 0; s < G_N_ELEMENTS (settings); s++) {
+    GstHarness *h = gst_harness_new ("alpha");
+
+    gst_util_set_object_arg (G_OBJECT (h->element), "method",
+        settings[s].method);
+    g_object_set (h->element, "alpha", 0.75,
+        "target-r", settings[s].target_r, "target-g", settings[s].target_g,
+        "target-b", settings[s].target_b, "angle", settings[s].angle,
+        "noise-level", settings[s].noise_level,
+        "black-sensitivity", settings[s].black_sensitivity,
+        "white-sensitivity", settings[s].white_sensitivity, NULL);
+    gst_harness_set_src_caps (h, gst_video_info_to_caps (&info));
+    gst_harness_set_sink_caps (h, gst_video_info_to_caps (&info));
+
+    outbuffer = gst_harness_push_and_pull (h, gst_buffer_ref (inbuffer));
+    fail_unless (outbuffer != NULL);
+
+    gst_buffer_map (inbuffer, &in_map, GST_MAP_READ);
+    chroma_key_ayuv_reference (&settings[s], in_map.data, ref,
+        GST_VIDEO_INFO_WIDTH (&info) * GST_VIDEO_INFO_HEIGHT (&info));
+    gst_buffer_unmap (inbuffer, &in_map);
+
+    GST_DEBUG ("checking setting %u", s);
+    gst_buffer_map (outbuffer, &out_map, GST_MAP_READ);
+    fail_unless_equals_int (out_map.size, GST_VIDEO_INFO_SIZE (&info));
+    fail_unless (memcmp (out_map.data, ref, out_map.size) == 0);
+    gst_buffer_unmap (outbuffer, &out_map);
+
+    gst_buffer_unref (outbuffer);
+    gst_harness_teardown (h);
+  }
+
+  g_free (ref);
+  gst_buffer_unref (inbuffer);
+}
+
+GST_END_TEST;
+
+#define PERF_FRAMES 20
+
+/* key 1080p frames with one thread and with one thread per CPU */
+GST_START_TEST (test_chromakeying_perf)
+{
+  guint f, i;
+
+  for (f = 0; f < G_N_ELEMENTS (slice_formats); f++) {
+    GstClockTime elapsed, single = 0, threaded = 0;
+    GstVideoInfo info;
+    GstBuffer *inbuffer;
+
+    gst_video_info_set_format (&info, slice_formats[f], 1920, 1080);
+    inbuffer = create_buffer_random (&info);
+
+    for (i = 0; i < PERF_FRAMES; i++) {
+      gst_buffer_unref (run_alpha (&info, inbuffer, "green", 1, &elapsed));
+      single += elapsed;
+      gst_buffer_unref (run_alpha (&info, inbuffer, "green", 0, &elapsed));
+      threaded += elapsed;
+    }
+
+    GST_INFO ("%s: %.2f ms per frame, %.2f ms with %u threads",
+        gst_video_format_to_string (slice_formats[f]),
+        (gdouble) single / GST_MSECOND / PERF_FRAMES,
+        (gdouble) threaded / GST_MSECOND / PERF_FRAMES,
+        g_get_num_processors ());
+
+    gst_buffer_unref (inbuffer);
+  }
+}
+
+GST_END_TEST;
+
 
 static Suite *
 alpha_suite (void)
@@ -265,6 +605,16 @@ alpha_suite (void)
   suite_add_tcase (s, tc_chain);
   tcase_add_test (tc_chain, test_alpha);
   tcase_add_test (tc_chain, test_chromakeying);
+  tcase_add_test (tc_chain, test_n_threads);
+  tcase_add_test (tc_chain, test_chromakeying_bit_exact);
+
+  /* benchmarks only log their timings, run them with GST_CHECK_PERF=1 */
+  if (g_getenv ("GST_CHECK_PERF")) {
+    TCase *tc_perf = tcase_create ("perf");
+
+    suite_add_tcase (s, tc_perf);
+    tcase_add_test (tc_perf, test_chromakeying_perf);
+  }
 
   return s;
 }
@@ -0,0 +1,719 @@
+/* GStreamer
+ *
+ * unit test for the effectv elements
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <string.h>
+
+#include <gst/video/video.h>
+#include <gst/check/gstcheck.h>
+#include <gst/check/gstharness.h>
+
+#if G_BYTE_ORDER == G_LITTLE_ENDIAN
+#define FORMAT GST_VIDEO_FORMAT_BGRx
+#else
+#define FORMAT GST_VIDEO_FORMAT_xRGB
+#endif
+
+/* elements whose output only depends on their input, with their properties */
+static const struct
+{
+  const gchar *name;
+  const gchar *prop;
+  gint value;
+} deterministic[] = {
+  {"edgetv", NULL, 0},
+  {"warptv", NULL, 0},
+  {"vertigotv", NULL, 0},
+  {"streaktv", "feedback", FALSE},
+  {"streaktv", "feedback", TRUE},
+  {"optv", NULL, 0},
+  {"revtv", NULL, 0},
+  {"radioactv", NULL, 0},
+  {"rippletv", "mode", 0},
+  {"agingtv", NULL, 0},
+  {"quarktv", NULL, 0},
+};
+
+/* elements that use a random number generator shared by all instances */
+static const gchar *random_elements[] = {
+  "dicetv", "shagadelictv",
+};
+
+#define N_INBUFS 4
+
+/* allocator proposed to the elements that fills its memory with a pattern,
+ * so that output pixels an element doesn't write are noticed */
+#define GARBAGE 0xa5
+
+typedef struct
+{
+  GstAllocator allocator;
+} GarbageAllocator;
+
+typedef struct
+{
+  GstAllocatorClass allocator_class;
+} GarbageAllocatorClass;
+
+GType garbage_allocator_get_type (void);
+G_DEFINE_TYPE (GarbageAllocator, garbage_allocator, GST_TYPE_ALLOCATOR);
+
+static GstMemory *
+garbage_allocator_alloc (GstAllocator * allocator, gsize size,
+    GstAllocationParams * params)
+{
+  GstMemory *mem = gst_allocator_alloc (NULL, size, params);
+  GstMapInfo map;
+
+  gst_memory_map (mem, &map, GST_MAP_WRITE);
+  memset (map.data, GARBAGE, map.size);
+  gst_memory_unmap (mem, &map);
+
+  return mem;
+}
+
+static void
+garbage_allocator_free (GstAllocator * allocator, GstMemory * mem)
+{
+  /* the memory belongs to the system allocator */
+  g_return_if_reached ();
+}
+
+static void
+garbage_allocator_class_init (GarbageAllocatorClass * klass)
+{
+  GstAllocatorClass *allocator_class = (GstAllocatorClass *) klass;
+
+  allocator_class->alloc = garbage_allocator_alloc;
+  allocator_class->free = garbage_allocator_free;
+}
+
+static void
+garbage_allocator_init (GarbageAllocator * allocator)
+{
+}
+
+static GstBuffer *
+create_random_frame (GstVideoInfo * info, GRand * rand)
+{
+  GstBuffer *buffer = gst_buffer_new_and_alloc (GST_VIDEO_INFO_SIZE (info));
+  GstMapInfo map;
+  gsize i;
+
+  gst_buffer_map (buffer, &map, GST_MAP_WRITE);
+  for (i = 0; i < map.size; i++)
+    map.data[i] = g_rand_int (rand);
+  gst_buffer_unmap (buffer, &map);
+
+  return buffer;
+}
+
+/* frame in two halves of colour @a and @b, left and right or, if @vertical,
+ * top and bottom */
+static GstBuffer *
+create_split_frame (GstVideoInfo * info, gboolean vertical, guint32 a,
+    guint32 b)
+{
+  GstBuffer *buffer = gst_buffer_new_and_alloc (GST_VIDEO_INFO_SIZE (info));
+  gint width = GST_VIDEO_INFO_WIDTH (info);
+  gint height = GST_VIDEO_INFO_HEIGHT (info);
+  GstMapInfo map;
+  guint32 *p;
+  gint x, y;
+
+  gst_buffer_map (buffer, &map, GST_MAP_WRITE);
+  for (y = 0; y < height; y++) {
+    p = (guint32 *) (map.data + y * GST_VIDEO_INFO_PLANE_STRIDE (info, 0));
+    for (x = 0; x < width; x++) {
+      if (vertical)
+        p[x] = y < height / 2 ? a : b;
+      else
+        p[x] = x < width / 2 ? a : b;
+    }
+  }
+  gst_buffer_unmap (buffer, &map);
+
+  return buffer;
+}
+
+/* copy of @buffer with @padding bytes of garbage after each row */
+static GstBuffer *
+create_padded_frame (GstVideoInfo * info, GstBuffer * buffer, gint padding)
+{
+  gint row_size = GST_VIDEO_INFO_WIDTH (info) * 4;
+  gint height = GST_VIDEO_INFO_HEIGHT (info);
+  gsize offset[GST_VIDEO_MAX_PLANES] = { 0, };
+  gint stride[GST_VIDEO_MAX_PLANES] = { row_size + padding, };
+  GstBuffer *padded = gst_buffer_new_and_alloc (stride[0] * height);
+  GstMapInfo map, padded_map;
+  gint y;
+
+  gst_buffer_map (buffer, &map, GST_MAP_READ);
+  gst_buffer_map (padded, &padded_map, GST_MAP_WRITE);
+  memset (padded_map.data, GARBAGE, padded_map.size);
+  for (y = 0; y < height; y++) {
+    memcpy (padded_map.data + y * stride[0],
+        map.data + y * GST_VIDEO_INFO_PLANE_STRIDE (info, 0), row_size);
+  }
+  gst_buffer_unmap (padded, &padded_map);
+  gst_buffer_unmap (buffer, &map);
+
+  gst_buffer_add_video_meta_full (padded, GST_VIDEO_FRAME_FLAG_NONE,
+      GST_VIDEO_INFO_FORMAT (info), GST_VIDEO_INFO_WIDTH (info), height, 1,
+      offset, stride);
+
+  return padded;
+}
+
+/* pushes @n_frames frames cycling through @inbufs and returns the last
+ * output. The properties are set before the element starts as some of them
+ * can't be changed later. */
+static GstBuffer *
+process_frames (const gchar * name, GstVideoInfo * info, GstBuffer ** inbufs,
+    guint n_frames, const gchar * prop, ...)
+{
+  GstElement *element = gst_element_factory_make (name, NULL);
+  GstHarness *h;
+  GstBuffer *outbuf = NULL;
+  va_list varargs;
+  guint i;
+
+  fail_unless (element != NULL);
+
+  va_start (varargs, prop);
+  g_object_set_valist (G_OBJECT (element), prop, varargs);
+  va_end (varargs);
+
+  h = gst_harness_new_with_element (element, "sink", "src");
+  gst_harness_set_propose_allocator (h,
+      gst_object_ref_sink (g_object_new (garbage_allocator_get_type (), NULL)),
+      NULL);
+  gst_harness_set_caps (h, gst_video_info_to_caps (info),
+      gst_video_info_to_caps (info));
+
+  for (i = 0; i < n_frames; i++) {
+    GstBuffer *inbuf = gst_buffer_copy (inbufs[i % N_INBUFS]);
+
+    GST_BUFFER_PTS (inbuf) = i * GST_SECOND / 30;
+    fail_unless_equals_int (gst_harness_push (h, inbuf), GST_FLOW_OK);
+    if (outbuf)
+      gst_buffer_unref (outbuf);
+    outbuf = gst_harness_pull (h);
+  }
+
+  gst_harness_teardown (h);
+  gst_object_unref (element);
+
+  return outbuf;
+}
+
+static void
+check_same_buffer (GstBuffer * a, GstBuffer * b)
+{
+  GstMapInfo map_a, map_b;
+
+  gst_buffer_map (a, &map_a, GST_MAP_READ);
+  gst_buffer_map (b, &map_b, GST_MAP_READ);
+  fail_unless_equals_int (map_a.size, map_b.size);
+  fail_unless (memcmp (map_a.data, map_b.data, map_a.size) == 0);
+  gst_buffer_unmap (a, &map_a);
+  gst_buffer_unmap (b, &map_b);
+}
+
+/* checks that the @width x @height rectangle at @x, @y is the same in
+ * frames @a and @b */
+static void
+check_same_rect (GstVideoInfo * info, GstBuffer * a, GstBuffer * b, gint x,
+    gint y, gint width, gint height)
+{
+  gint stride = GST_VIDEO_INFO_PLANE_STRIDE (info, 0);
+  GstMapInfo map_a, map_b;
+
+  gst_buffer_map (a, &map_a, GST_MAP_READ);
+  gst_buffer_map (b, &map_b, GST_MAP_READ);
+  for (; height > 0; y++, height--) {
+    fail_unless (memcmp (map_a.data + y * stride + x * 4,
+            map_b.data + y * stride + x * 4, width * 4) == 0,
+        "row %d differs", y);
+  }
+  gst_buffer_unmap (a, &map_a);
+  gst_buffer_unmap (b, &map_b);
+}
+
+static gboolean
+buffer_is_filled (GstBuffer * buffer, guint32 value)
+{
+  GstMapInfo map;
+  gboolean ret = TRUE;
+  gsize i;
+
+  gst_buffer_map (buffer, &map, GST_MAP_READ);
+  for (i = 0; i < map.size / 4 && ret; i++)
+    ret = ((guint32 *) map.data)[i] == value;
+  gst_buffer_unmap (buffer, &map);
+
+  return ret;
+}
+
+static void
+create_inbufs (GstVideoInfo * info, GstBuffer ** inbufs)
+{
+  GRand *rand = g_rand_new_with_seed (0);
+  guint i;
+
+  for (i = 0; i < N_INBUFS; i++)
+    inbufs[i] = create_random_frame (info, rand);
+
+  g_rand_free (rand);
+}
+
+static void
+create_padded_inbufs (GstVideoInfo * info, GstBuffer ** inbufs,
+    GstBuffer ** padded)
+{
+  guint i;
+
+  for (i = 0; i < N_INBUFS; i++)
+    padded[i] = create_padded_frame (info, inbufs[i], 64);
+}
+
+/* flat frames of a different colour each */
+static const guint32 colors[N_INBUFS] = {
+  0x102030, 0x405060, 0x708090, 0xa0b0c0
+};
+
+static void
+create_flat_inbufs (GstVideoInfo * info, GstBuffer ** inbufs)
+{
+  guint i;
+
+  for (i = 0; i < N_INBUFS; i++)
+    inbufs[i] = create_split_frame (info, FALSE, colors[i], colors[i]);
+}
+
+static void
+free_inbufs (GstBuffer ** inbufs)
+{
+  guint i;
+
+  for (i = 0; i < N_INBUFS; i++)
+    gst_buffer_unref (inbufs[i]);
+}
+
+GST_START_TEST (test_effectv_threads)
+{
+  GstBuffer *inbufs[N_INBUFS];
+  GstVideoInfo info;
+  guint i;
+
+  /* odd height so the last band is a short one */
+  gst_video_info_set_format (&info, FORMAT, 320, 243);
+  create_inbufs (&info, inbufs);
+
+  for (i = 0; i < G_N_ELEMENTS (deterministic); i++) {
+    GstBuffer *single, *threaded;
+
+    GST_DEBUG ("checking %s", deterministic[i].name);
+
+    single = process_frames (deterministic[i].name, &info, inbufs, 8,
+        "n-threads", 1, deterministic[i].prop, deterministic[i].value, NULL);
+    threaded = process_frames (deterministic[i].name, &info, inbufs, 8,
+        "n-threads", 4, deterministic[i].prop, deterministic[i].value, NULL);
+    check_same_buffer (single, threaded);
+
+    gst_buffer_unref (single);
+    gst_buffer_unref (threaded);
+  }
+
+  free_inbufs (inbufs);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_effectv_random_threads)
+{
+  GstBuffer *inbufs[N_INBUFS];
+  GstVideoInfo info;
+  guint i;
+
+  gst_video_info_set_format (&info, FORMAT, 320, 243);
+  create_inbufs (&info, inbufs);
+
+  for (i = 0; i < G_N_ELEMENTS (random_elements); i++) {
+    GST_DEBUG ("running %s", random_elements[i]);
+
+    gst_buffer_unref (process_frames (random_elements[i], &info, inbufs, 8,
+            "n-threads", 4, NULL));
+  }
+
+  free_inbufs (inbufs);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_edgetv_signed_diffs)
+{
+  GstBuffer *up, *down, *outbuf_up, *outbuf_down;
+  GstVideoInfo info;
+  gboolean vertical;
+
+  gst_video_info_set_format (&info, FORMAT, 64, 48);
+
+  for (vertical = FALSE; vertical <= TRUE; vertical++) {
+    up = create_split_frame (&info, vertical, 0x000000, 0x404040);
+    down = create_split_frame (&info, vertical, 0x404040, 0x000000);
+
+    outbuf_up = process_frames ("edgetv", &info, &up, 1, NULL);
+    outbuf_down = process_frames ("edgetv", &info, &down, 1, NULL);
+
+    /* the edge only depends on the size of the step, not on its direction */
+    fail_if (buffer_is_filled (outbuf_up, 0));
+    check_same_buffer (outbuf_up, outbuf_down);
+
+    gst_buffer_unref (up);
+    gst_buffer_unref (down);
+    gst_buffer_unref (outbuf_up);
+    gst_buffer_unref (outbuf_down);
+  }
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_edgetv_borders)
+{
+  GstBuffer *inbuf, *outbuf;
+  GstVideoInfo info;
+
+  /* a size that is not a multiple of the 4x4 blocks */
+  gst_video_info_set_format (&info, FORMAT, 66, 50);
+  inbuf = create_split_frame (&info, FALSE, 0x808080, 0x808080);
+
+  /* no edges, and the blocks on the borders are black too */
+  outbuf = process_frames ("edgetv", &info, &inbuf, 1, NULL);
+  fail_unless (buffer_is_filled (outbuf, 0));
+
+  gst_buffer_unref (inbuf);
+  gst_buffer_unref (outbuf);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_quarktv_first_frame)
+{
+  GstBuffer *inbuf, *outbuf;
+  GstVideoInfo info;
+  GRand *rand = g_rand_new_with_seed (0);
+
+  gst_video_info_set_format (&info, FORMAT, 64, 48);
+  inbuf = create_random_frame (&info, rand);
+
+  /* with only one frame in the plane table every pixel, the first one
+   * included, comes from the input */
+  outbuf = process_frames ("quarktv", &info, &inbuf, 1, NULL);
+  check_same_buffer (inbuf, outbuf);
+
+  gst_buffer_unref (inbuf);
+  gst_buffer_unref (outbuf);
+  g_rand_free (rand);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_revtv_black_frame)
+{
+  GstBuffer *inbuf, *outbuf;
+  GstVideoInfo info;
+  GstMapInfo map;
+  guint32 *p;
+  gint x, y;
+
+  gst_video_info_set_format (&info, FORMAT, 64, 48);
+  inbuf = create_split_frame (&info, FALSE, 0, 0);
+
+  /* black doesn't move the lines, so every 6th row but the first one is
+   * white and nothing spills into the row below it */
+  outbuf = process_frames ("revtv", &info, &inbuf, 1, "linespace", 6, NULL);
+
+  gst_buffer_map (outbuf, &map, GST_MAP_READ);
+  for (y = 0; y < 48; y++) {
+    p = (guint32 *) (map.data + y * GST_VIDEO_INFO_PLANE_STRIDE (&info, 0));
+    for (x = 0; x < 64; x++) {
+      if (y > 0 && y % 6 == 0)
+        fail_unless_equals_int (p[x], 0xffffffff);
+      else
+        fail_unless_equals_int (p[x], 0);
+    }
+  }
+  gst_buffer_unmap (outbuf, &map);
+
+  gst_buffer_unref (inbuf);
+  gst_buffer_unref (outbuf);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_dicetv_portrait)
+{
+  GstBuffer *inbuf, *outbuf;
+  GstVideoInfo info;
+  GRand *rand = g_rand_new_with_seed (0);
+
+  /* taller than wide, so a map of width * width entries is too small */
+  gst_video_info_set_format (&info, FORMAT, 16, 64);
+  inbuf = create_random_frame (&info, rand);
+
+  /* turning 1x1 squares in any direction leaves the frame unchanged */
+  outbuf = process_frames ("dicetv", &info, &inbuf, 1, "square-bits", 0,
+      NULL);
+  check_same_buffer (inbuf, outbuf);
+
+  gst_buffer_unref (inbuf);
+  gst_buffer_unref (outbuf);
+  g_rand_free (rand);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_dicetv_borders)
+{
+  GstBuffer *inbuf, *outbuf;
+  GstVideoInfo info;
+  GRand *rand = g_rand_new_with_seed (0);
+
+  /* 16x16 squares leave 6 columns on the right and 13 rows at the bottom */
+  gst_video_info_set_format (&info, FORMAT, 70, 45);
+  inbuf = create_random_frame (&info, rand);
+
+  outbuf = process_frames ("dicetv", &info, &inbuf, 1, "square-bits", 4,
+      NULL);
+  check_same_rect (&info, inbuf, outbuf, 64, 0, 6, 45);
+  check_same_rect (&info, inbuf, outbuf, 0, 32, 70, 13);
+
+  gst_buffer_unref (inbuf);
+  gst_buffer_unref (outbuf);
+  g_rand_free (rand);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_radioactv_margins)
+{
+  GstBuffer *inbufs[N_INBUFS], *outbuf;
+  GstVideoInfo info;
+
+  /* the effect covers the middle 320 columns, leaving 8 on each side */
+  gst_video_info_set_format (&info, FORMAT, 336, 48);
+  create_inbufs (&info, inbufs);
+
+  outbuf = process_frames ("radioactv", &info, inbufs, 8, NULL);
+  check_same_rect (&info, inbufs[7 % N_INBUFS], outbuf, 0, 0, 8, 48);
+  check_same_rect (&info, inbufs[7 % N_INBUFS], outbuf, 328, 0, 8, 48);
+
+  gst_buffer_unref (outbuf);
+  free_inbufs (inbufs);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_rippletv_strides)
+{
+  GstBuffer *inbufs[N_INBUFS], *padded[N_INBUFS];
+  GstBuffer *outbuf, *padded_outbuf;
+  GstVideoInfo info;
+
+  /* odd sizes leave a last row and column without a pair */
+  gst_video_info_set_format (&info, FORMAT, 321, 243);
+  create_inbufs (&info, inbufs);
+  create_padded_inbufs (&info, inbufs, padded);
+
+  outbuf = process_frames ("rippletv", &info, inbufs, 8, "mode", 0, NULL);
+  padded_outbuf = process_frames ("rippletv", &info, padded, 8, "mode", 0,
+      NULL);
+  check_same_buffer (outbuf, padded_outbuf);
+
+  gst_buffer_unref (outbuf);
+  gst_buffer_unref (padded_outbuf);
+  free_inbufs (padded);
+  free_inbufs (inbufs);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_warptv_flat_frames)
+{
+  GstBuffer *inbufs[N_INBUFS], *outbuf;
+  GstVideoInfo info;
+
+  gst_video_info_set_format (&info, FORMAT, 65, 49);
+  create_flat_inbufs (&info, inbufs);
+
+  /* however the frame is warped, every pixel, the last row and column
+   * included, has the colour of the current frame */
+  outbuf = process_frames ("warptv", &info, inbufs, 7, NULL);
+  fail_unless (buffer_is_filled (outbuf, colors[6 % N_INBUFS]));
+
+  gst_buffer_unref (outbuf);
+  free_inbufs (inbufs);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_vertigotv_flat_frames)
+{
+  GstBuffer *inbufs[N_INBUFS], *outbuf;
+  GstVideoInfo info;
+  GstMapInfo map;
+  guint32 first;
+  guint n_frames;
+
+  gst_video_info_set_format (&info, FORMAT, 64, 48);
+  create_flat_inbufs (&info, inbufs);
+
+  /* the zoomed previous frame is flat as well, so every output is flat,
+   * also where the zoom reaches past the last pixel */
+  for (n_frames = 1; n_frames <= 8; n_frames++) {
+    outbuf = process_frames ("vertigotv", &info, inbufs, n_frames, NULL);
+
+    gst_buffer_map (outbuf, &map, GST_MAP_READ);
+    first = *(guint32 *) map.data;
+    gst_buffer_unmap (outbuf, &map);
+    fail_unless (buffer_is_filled (outbuf, first), "frame %u is not flat",
+        n_frames);
+
+    gst_buffer_unref (outbuf);
+  }
+
+  free_inbufs (inbufs);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_streaktv_strides)
+{
+  GstBuffer *inbufs[N_INBUFS], *padded[N_INBUFS];
+  GstBuffer *outbuf, *padded_outbuf;
+  GstVideoInfo info;
+  gboolean feedback;
+
+  /* not a multiple of the 64 pixel blocks, to cover the leftover pixels */
+  gst_video_info_set_format (&info, FORMAT, 100, 30);
+  create_inbufs (&info, inbufs);
+  create_padded_inbufs (&info, inbufs, padded);
+
+  for (feedback = FALSE; feedback <= TRUE; feedback++) {
+    outbuf = process_frames ("streaktv", &info, inbufs, 12, "feedback",
+        feedback, NULL);
+    padded_outbuf = process_frames ("streaktv", &info, padded, 12,
+        "feedback", feedback, NULL);
+    check_same_buffer (outbuf, padded_outbuf);
+
+    gst_buffer_unref (outbuf);
+    gst_buffer_unref (padded_outbuf);
+  }
+
+  free_inbufs (padded);
+  free_inbufs (inbufs);
+}
+
+GST_END_TEST;
+
+#define PERF_FRAMES 10
+
+static GstClockTime
+time_frames (const gchar * name, GstVideoInfo * info, GstBuffer ** inbufs,
+    guint n_threads)
+{
+  GstClockTime start = gst_util_get_timestamp ();
+
+  gst_buffer_unref (process_frames (name, info, inbufs, PERF_FRAMES,
+          "n-threads", n_threads, NULL));
+
+  return gst_util_get_timestamp () - start;
+}
+
+static void
+log_perf (const gchar * name, GstVideoInfo * info, GstBuffer ** inbufs)
+{
+  GstClockTime single, threaded;
+
+  single = time_frames (name, info, inbufs, 1);
+  threaded = time_frames (name, info, inbufs, 0);
+
+  GST_INFO ("%s: %.2f ms per frame, %.2f ms with %u threads", name,
+      (gdouble) single / GST_MSECOND / PERF_FRAMES,
+      (gdouble) threaded / GST_MSECOND / PERF_FRAMES,
+      g_get_num_processors ());
+}
+
+GST_START_TEST (test_effectv_perf)
+{
+  GstBuffer *inbufs[N_INBUFS];
+  GstVideoInfo info;
+  guint i;
+
+  gst_video_info_set_format (&info, FORMAT, 1920, 1080);
+  create_inbufs (&info, inbufs);
+
+  for (i = 0; i < G_N_ELEMENTS (deterministic); i++) {
+    if (i > 0 && !g_strcmp0 (deterministic[i].name, deterministic[i - 1].name))
+      continue;
+    log_perf (deterministic[i].name, &info, inbufs);
+  }
+  for (i = 0; i < G_N_ELEMENTS (random_elements); i++)
+    log_perf (random_elements[i], &info, inbufs);
+
+  free_inbufs (inbufs);
+}
+
+GST_END_TEST;
+
+static Suite *
+effectv_suite (void)
+{
+  Suite *s = suite_create ("effectv");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_effectv_threads);
+  tcase_add_test (tc_chain, test_effectv_random_threads);
+  tcase_add_test (tc_chain, test_edgetv_signed_diffs);
+  tcase_add_test (tc_chain, test_edgetv_borders);
+  tcase_add_test (tc_chain, test_quarktv_first_frame);
+  tcase_add_test (tc_chain, test_revtv_black_frame);
+  tcase_add_test (tc_chain, test_dicetv_portrait);
+  tcase_add_test (tc_chain, test_dicetv_borders);
+  tcase_add_test (tc_chain, test_radioactv_margins);
+  tcase_add_test (tc_chain, test_rippletv_strides);
+  tcase_add_test (tc_chain, test_warptv_flat_frames);
+  tcase_add_test (tc_chain, test_vertigotv_flat_frames);
+  tcase_add_test (tc_chain, test_streaktv_strides);
+
+  /* benchmarks only log their timings, run them with GST_CHECK_PERF=1 */
+  if (g_getenv ("GST_CHECK_PERF")) {
+    TCase *tc_perf = tcase_create ("perf");
+
+    suite_add_tcase (s, tc_perf);
+    tcase_set_timeout (tc_perf, 180);
+    tcase_add_test (tc_perf, test_effectv_perf);
+  }
+
+  return s;
+}
+
+GST_CHECK_MAIN (effectv);
@@ -707,6 +707,157 @@ GST_START_TEST (test_imagefreeze_25_1_live)
 
 GST_END_TEST;
 
+typedef struct
+{
+  guint n_buffers;
+  GstMemory *memory;
+  guint n_copies;
+  guint n_repeated;
+} OutputStats;
+
+static GQuark output_quark;
+
+static void
+sink_handoff_cb_output_stats (GstElement * object, GstBuffer * buffer,
+    GstPad * pad, gpointer user_data)
+{
+  OutputStats *stats = user_data;
+  GstMemory *memory = gst_buffer_peek_memory (buffer, 0);
+
+  /* the memory is only compared, the first one is kept alive by imagefreeze */
+  if (!stats->memory)
+    stats->memory = memory;
+  else if (memory != stats->memory)
+    stats->n_copies++;
+
+  /* mark buffers to count the ones that are pushed again */
+  if (gst_mini_object_get_qdata (GST_MINI_OBJECT (buffer), output_quark))
+    stats->n_repeated++;
+  else
+    gst_mini_object_set_qdata (GST_MINI_OBJECT (buffer), output_quark,
+        GINT_TO_POINTER (1), NULL);
+  stats->n_buffers++;
+}
+
+/* Runs @n_buffers frames of @width x @height through imagefreeze and returns
+ * the time it took */
+static GstClockTime
+run_output_stats (gint width, gint height, gint n_buffers,
+    OutputStats * stats)
+{
+  GstElement *pipeline, *imagefreeze, *sink;
+  GstCaps *caps;
+  GstBus *bus;
+  GMainLoop *loop;
+  guint bus_watch;
+  GstClockTime start;
+  GstVideoInfo info;
+
+  gst_video_info_init (&info);
+  gst_video_info_set_format (&info, GST_VIDEO_FORMAT_xRGB, width, height);
+  info.fps_n = 60;
+  info.fps_d = 1;
+  caps = gst_video_info_to_caps (&info);
+
+  pipeline = setup_imagefreeze (caps, caps,
+      G_CALLBACK (sink_handoff_cb_output_stats), stats);
+
+  imagefreeze = gst_bin_get_by_name (GST_BIN (pipeline), "freeze");
+  g_object_set (imagefreeze, "num-buffers", n_buffers, NULL);
+  sink = gst_bin_get_by_name (GST_BIN (pipeline), "sink");
+  g_object_set (sink, "sync", FALSE, NULL);
+
+  loop = g_main_loop_new (NULL, TRUE);
+  bus = gst_element_get_bus (pipeline);
+  bus_watch = gst_bus_add_watch (bus, bus_handler, loop);
+  gst_object_unref (bus);
+
+  memset (stats, 0, sizeof (*stats));
+  output_quark = g_quark_from_static_string ("imagefreeze-test-output");
+
+  start = gst_util_get_timestamp ();
+  fail_unless_equals_int (gst_element_set_state (pipeline, GST_STATE_PLAYING),
+      GST_STATE_CHANGE_SUCCESS);
+  g_main_loop_run (loop);
+  start = gst_util_get_timestamp () - start;
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+
+  gst_object_unref (imagefreeze);
+  gst_object_unref (sink);
+  gst_object_unref (pipeline);
+  g_main_loop_unref (loop);
+  gst_caps_unref (caps);
+  g_source_remove (bus_watch);
+
+  return start;
+}
+
+GST_START_TEST (test_imagefreeze_repeat_buffers)
+{
+  OutputStats stats;
+
+  run_output_stats (640, 480, 100, &stats);
+
+  fail_unless_equals_int (stats.n_buffers, 100);
+  /* every frame shares the memory of the frozen image */
+  fail_unless_equals_int (stats.n_copies, 0);
+  /* and buffers released by the sink are pushed again */
+  fail_unless (stats.n_repeated > stats.n_buffers / 2);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_imagefreeze_no_share_memory)
+{
+  GstHarness *h = gst_harness_new_parse ("imagefreeze num-buffers=10");
+  GstBuffer *buffer;
+  GstMemory *input, *output = NULL;
+  guint i;
+
+  gst_harness_set_src_caps_str (h,
+      "video/x-raw, format=xRGB, width=64, height=48, framerate=25/1");
+
+  buffer = gst_buffer_new_allocate (NULL, 64 * 48 * 4, NULL);
+  input = gst_buffer_peek_memory (buffer, 0);
+  GST_MINI_OBJECT_FLAG_SET (input, GST_MEMORY_FLAG_NO_SHARE);
+  fail_unless_equals_int (gst_harness_push (h, buffer), GST_FLOW_EOS);
+
+  /* the memory is copied once, not for every frame */
+  for (i = 0; i < 10; i++) {
+    buffer = gst_harness_pull (h);
+    fail_unless (buffer != NULL);
+    if (!output)
+      output = gst_buffer_peek_memory (buffer, 0);
+    fail_unless (gst_buffer_peek_memory (buffer, 0) == output);
+    fail_unless (output != input);
+    gst_buffer_unref (buffer);
+  }
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+#define PERF_BUFFERS 600
+
+GST_START_TEST (test_imagefreeze_perf)
+{
+  OutputStats stats;
+  GstClockTime elapsed;
+
+  elapsed = run_output_stats (3840, 2160, PERF_BUFFERS, &stats);
+
+  fail_unless_equals_int (stats.n_buffers, PERF_BUFFERS);
+  fail_unless_equals_int (stats.n_copies, 0);
+
+  GST_INFO ("2160p: %.3f ms per frame, %u buffers pushed again, %u copies",
+      (gdouble) elapsed / GST_MSECOND / PERF_BUFFERS, stats.n_repeated,
+      stats.n_copies);
+}
+
+GST_END_TEST;
+
 static Suite *
 imagefreeze_suite (void)
 {
@@ -728,6 +879,17 @@ imagefreeze_suite (void)
 
   tcase_add_test (tc_chain, test_imagefreeze_25_1_live);
 
+  tcase_add_test (tc_chain, test_imagefreeze_repeat_buffers);
+  tcase_add_test (tc_chain, test_imagefreeze_no_share_memory);
+
+  /* benchmarks only log their timings, run them with GST_CHECK_PERF=1 */
+  if (g_getenv ("GST_CHECK_PERF")) {
+    TCase *tc_perf = tcase_create ("perf");
+
+    suite_add_tcase (s, tc_perf);
+    tcase_add_test (tc_perf, test_imagefreeze_perf);
+  }
+
   return s;
 }
 
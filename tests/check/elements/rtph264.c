@@ -665,6 +665,233 @@ GST_START_TEST (test_rtph264depay_stap_a_marker)
 
 GST_END_TEST;
 
+static GBytes *
+depay_stap_a_and_fu_a (gboolean zero_copy, guint * max_n_memory)
+{
+  GstHarness *h = gst_harness_new ("rtph264depay");
+  GByteArray *data = g_byte_array_new ();
+  GstBuffer *buffer;
+  GstRTPBuffer rtp = GST_RTP_BUFFER_INIT;
+
+  g_object_set (h->element, "zero-copy", zero_copy, NULL);
+  gst_harness_set_caps_str (h,
+      "application/x-rtp,media=video,clock-rate=90000,encoding-name=H264",
+      "video/x-h264,alignment=au,stream-format=byte-stream");
+
+  fail_unless_equals_int (gst_harness_push (h,
+          wrap_static_buffer (rtp_stapa_pps_sps, sizeof (rtp_stapa_pps_sps))),
+      GST_FLOW_OK);
+
+  buffer = gst_buffer_new_memdup (rtp_stapa_slices_marker,
+      sizeof (rtp_stapa_slices_marker));
+  fail_unless (gst_rtp_buffer_map (buffer, GST_MAP_WRITE, &rtp));
+  gst_rtp_buffer_set_seq (&rtp, 2);
+  gst_rtp_buffer_unmap (&rtp);
+  fail_unless_equals_int (gst_harness_push (h, buffer), GST_FLOW_OK);
+
+  fail_unless_equals_int (gst_harness_push (h,
+          wrap_static_buffer (rtp_h264_idr_fu_start,
+              sizeof (rtp_h264_idr_fu_start))), GST_FLOW_OK);
+  fail_unless_equals_int (gst_harness_push (h,
+          wrap_static_buffer (rtp_h264_idr_fu_middle,
+              sizeof (rtp_h264_idr_fu_middle))), GST_FLOW_OK);
+  fail_unless_equals_int (gst_harness_push (h,
+          wrap_static_buffer (rtp_h264_idr_fu_end,
+              sizeof (rtp_h264_idr_fu_end))), GST_FLOW_OK);
+
+  fail_unless_equals_int (gst_harness_buffers_in_queue (h), 2);
+
+  *max_n_memory = 0;
+  while ((buffer = gst_harness_try_pull (h))) {
+    GstMapInfo map;
+
+    *max_n_memory = MAX (*max_n_memory, gst_buffer_n_memory (buffer));
+    fail_unless (gst_buffer_map (buffer, &map, GST_MAP_READ));
+    g_byte_array_append (data, map.data, map.size);
+    gst_buffer_unmap (buffer, &map);
+    gst_buffer_unref (buffer);
+  }
+
+  gst_harness_teardown (h);
+
+  return g_byte_array_free_to_bytes (data);
+}
+
+GST_START_TEST (test_rtph264depay_zero_copy)
+{
+  GBytes *copied, *referenced;
+  guint n_memory;
+
+  copied = depay_stap_a_and_fu_a (FALSE, &n_memory);
+  fail_unless_equals_int (n_memory, 1);
+
+  referenced = depay_stap_a_and_fu_a (TRUE, &n_memory);
+  fail_unless (n_memory > 1);
+
+  /* Referencing the payload memories must not change the bitstream */
+  fail_unless (g_bytes_equal (copied, referenced));
+
+  g_bytes_unref (copied);
+  g_bytes_unref (referenced);
+}
+
+GST_END_TEST;
+
+/* Returns the number of bytes of @buffer that reference the memory of
+ * another buffer instead of having been copied */
+static gsize
+get_shared_size (GstBuffer * buffer)
+{
+  guint i, n_memory = gst_buffer_n_memory (buffer);
+  gsize size = 0;
+
+  for (i = 0; i < n_memory; i++) {
+    GstMemory *mem = gst_buffer_peek_memory (buffer, i);
+
+    if (mem->parent != NULL)
+      size += mem->size;
+  }
+
+  return size;
+}
+
+#define FU_SIZE 1400
+
+/* Returns how many bytes of a NAL of @n_fu fragments are referenced in
+ * zero-copy mode. The first fragment comes with a copied prefix, and if the
+ * fragments don't fit in a buffer the ones that don't are merged into one
+ * copied memory. */
+static gsize
+get_expected_shared_size (guint n_fu)
+{
+  guint max_memory = gst_buffer_get_max_memory ();
+
+  if (n_fu + 1 > max_memory)
+    n_fu = max_memory - 2;
+
+  return n_fu * (FU_SIZE - 2);
+}
+
+/* Depayloads @n_frames frames of @n_fu FU-A packets each, and returns the
+ * time it took. Appends the output to @data if not %NULL and stores the
+ * number of output bytes that were not copied in @shared_size. */
+static GstClockTime
+depay_fu_a_stream (gboolean zero_copy, guint n_frames, guint n_fu,
+    GByteArray * data, gsize * shared_size)
+{
+  GstHarness *h = gst_harness_new ("rtph264depay");
+  GstClockTime start;
+  guint16 seq = 0;
+  guint i, j;
+
+  g_object_set (h->element, "zero-copy", zero_copy, NULL);
+  gst_harness_set_caps_str (h,
+      "application/x-rtp,media=video,clock-rate=90000,encoding-name=H264",
+      "video/x-h264,alignment=au,stream-format=byte-stream");
+
+  *shared_size = 0;
+  start = gst_util_get_timestamp ();
+  for (i = 0; i < n_frames; i++) {
+    GstBuffer *buffer;
+
+    for (j = 0; j < n_fu; j++) {
+      GstRTPBuffer rtp = GST_RTP_BUFFER_INIT;
+      guint8 *payload;
+
+      buffer = gst_rtp_buffer_new_allocate (FU_SIZE, 0, 0);
+      fail_unless (gst_rtp_buffer_map (buffer, GST_MAP_WRITE, &rtp));
+      gst_rtp_buffer_set_seq (&rtp, seq++);
+      gst_rtp_buffer_set_timestamp (&rtp, i * 1500);
+      gst_rtp_buffer_set_marker (&rtp, j == n_fu - 1);
+      payload = gst_rtp_buffer_get_payload (&rtp);
+      memset (payload, j, FU_SIZE);
+      /* FU indicator (NRI 3, type 28) and FU header for a non-IDR slice */
+      payload[0] = 0x7c;
+      payload[1] = 0x01;
+      if (j == 0)
+        payload[1] |= 0x80;
+      if (j == n_fu - 1)
+        payload[1] |= 0x40;
+      /* first_mb_in_slice == 0 */
+      payload[2] = 0x80;
+      gst_rtp_buffer_unmap (&rtp);
+      GST_BUFFER_PTS (buffer) = i * GST_SECOND / 60;
+
+      fail_unless_equals_int (gst_harness_push (h, buffer), GST_FLOW_OK);
+    }
+
+    /* every AU is pushed as one timestamped buffer with the marker */
+    fail_unless_equals_int (gst_harness_buffers_in_queue (h), 1);
+    buffer = gst_harness_pull (h);
+    fail_unless (gst_buffer_n_memory (buffer) <= gst_buffer_get_max_memory ());
+    fail_unless_equals_uint64 (GST_BUFFER_PTS (buffer), i * GST_SECOND / 60);
+    fail_unless (GST_BUFFER_FLAG_IS_SET (buffer, GST_BUFFER_FLAG_MARKER));
+    *shared_size += get_shared_size (buffer);
+    if (data) {
+      GstMapInfo map;
+
+      fail_unless (gst_buffer_map (buffer, &map, GST_MAP_READ));
+      g_byte_array_append (data, map.data, map.size);
+      gst_buffer_unmap (buffer, &map);
+    }
+    gst_buffer_unref (buffer);
+  }
+
+  start = gst_util_get_timestamp () - start;
+  gst_harness_teardown (h);
+
+  return start;
+}
+
+GST_START_TEST (test_rtph264depay_zero_copy_many_fragments)
+{
+  GByteArray *copied = g_byte_array_new ();
+  GByteArray *referenced = g_byte_array_new ();
+  gsize shared_size;
+
+  /* more fragments than memories fit in a buffer */
+  depay_fu_a_stream (FALSE, 2, 40, copied, &shared_size);
+  fail_unless_equals_int (shared_size, 0);
+
+  /* the fragments that don't fit are merged, the AU stays one buffer */
+  depay_fu_a_stream (TRUE, 2, 40, referenced, &shared_size);
+  fail_unless_equals_uint64 (shared_size, 2 * get_expected_shared_size (40));
+
+  fail_unless_equals_int (copied->len, referenced->len);
+  fail_unless (memcmp (copied->data, referenced->data, copied->len) == 0);
+
+  g_byte_array_unref (copied);
+  g_byte_array_unref (referenced);
+}
+
+GST_END_TEST;
+
+#define PERF_FRAMES 250
+#define PERF_FU_PER_FRAME 60
+
+GST_START_TEST (test_rtph264depay_zero_copy_perf)
+{
+  GstClockTime copied, referenced;
+  guint64 bits = (guint64) PERF_FRAMES * PERF_FU_PER_FRAME * FU_SIZE * 8;
+  gsize shared_size;
+
+  /* about 80 kB per frame, an intra frame of a 1080p stream */
+  copied = depay_fu_a_stream (FALSE, PERF_FRAMES, PERF_FU_PER_FRAME, NULL,
+      &shared_size);
+  fail_unless_equals_int (shared_size, 0);
+
+  referenced = depay_fu_a_stream (TRUE, PERF_FRAMES, PERF_FU_PER_FRAME, NULL,
+      &shared_size);
+  fail_unless_equals_uint64 (shared_size,
+      PERF_FRAMES * get_expected_shared_size (PERF_FU_PER_FRAME));
+
+  GST_INFO ("depayloaded %" G_GUINT64_FORMAT " Mbit: copying %"
+      GST_TIME_FORMAT ", zero-copy %" GST_TIME_FORMAT, bits / 1000000,
+      GST_TIME_ARGS (copied), GST_TIME_ARGS (referenced));
+}
+
+GST_END_TEST;
+
 
 /* AUD */
 static guint8 h264_aud[] = {
@@ -978,6 +1205,230 @@ GST_START_TEST (test_rtph264pay_marker_for_fragmented_au)
 
 GST_END_TEST;
 
+static GstPadProbeReturn
+count_buffer_lists (GstPad * pad, GstPadProbeInfo * info, gpointer user_data)
+{
+  guint *n_lists = user_data;
+
+  *n_lists += 1;
+
+  return GST_PAD_PROBE_OK;
+}
+
+static GPtrArray *
+pay_two_slices (GstHarness * h, guint * n_lists)
+{
+  GPtrArray *packets = g_ptr_array_new_with_free_func (
+      (GDestroyNotify) gst_buffer_unref);
+  GstBuffer *slice1, *slice2, *buffer;
+
+  slice1 = wrap_static_buffer (h264_idr_slice_1, sizeof (h264_idr_slice_1));
+  slice2 = wrap_static_buffer (h264_idr_slice_2, sizeof (h264_idr_slice_2));
+  buffer = gst_buffer_append (slice1, slice2);
+
+  *n_lists = 0;
+  fail_unless_equals_int (gst_harness_push (h, buffer), GST_FLOW_OK);
+
+  while ((buffer = gst_harness_try_pull (h)))
+    g_ptr_array_add (packets, buffer);
+
+  return packets;
+}
+
+GST_START_TEST (test_rtph264pay_buffer_list)
+{
+  GstHarness *h, *h_list;
+  GPtrArray *packets, *list_packets;
+  GHashTable *headers;
+  guint i, n_lists, n_pooled = 0;
+
+  h = gst_harness_new_parse ("rtph264pay timestamp-offset=123 mtu=40");
+  h_list = gst_harness_new_parse ("rtph264pay timestamp-offset=123 mtu=40"
+      " buffer-list=true");
+  gst_harness_set_src_caps_str (h,
+      "video/x-h264,alignment=au,stream-format=byte-stream");
+  gst_harness_set_src_caps_str (h_list,
+      "video/x-h264,alignment=au,stream-format=byte-stream");
+  gst_pad_add_probe (h->sinkpad, GST_PAD_PROBE_TYPE_BUFFER_LIST,
+      count_buffer_lists, &n_lists, NULL);
+  gst_pad_add_probe (h_list->sinkpad, GST_PAD_PROBE_TYPE_BUFFER_LIST,
+      count_buffer_lists, &n_lists, NULL);
+
+  /* one list per NAL unit without, one list for the whole AU with */
+  packets = pay_two_slices (h, &n_lists);
+  fail_unless_equals_int (n_lists, 2);
+  list_packets = pay_two_slices (h_list, &n_lists);
+  fail_unless_equals_int (n_lists, 1);
+
+  /* the packets themselves are the same */
+  fail_unless_equals_int (list_packets->len, packets->len);
+  fail_unless (packets->len > 2);
+  for (i = 0; i < packets->len; i++) {
+    GstRTPBuffer rtp = GST_RTP_BUFFER_INIT;
+    GstRTPBuffer list_rtp = GST_RTP_BUFFER_INIT;
+    GBytes *payload, *list_payload;
+
+    fail_unless (gst_rtp_buffer_map (g_ptr_array_index (packets, i),
+            GST_MAP_READ, &rtp));
+    fail_unless (gst_rtp_buffer_map (g_ptr_array_index (list_packets, i),
+            GST_MAP_READ, &list_rtp));
+    fail_unless_equals_int (gst_rtp_buffer_get_marker (&list_rtp),
+        gst_rtp_buffer_get_marker (&rtp));
+    fail_unless_equals_int (gst_rtp_buffer_get_timestamp (&list_rtp),
+        gst_rtp_buffer_get_timestamp (&rtp));
+    payload = gst_rtp_buffer_get_payload_bytes (&rtp);
+    list_payload = gst_rtp_buffer_get_payload_bytes (&list_rtp);
+    fail_unless (g_bytes_equal (payload, list_payload));
+    g_bytes_unref (payload);
+    g_bytes_unref (list_payload);
+    gst_rtp_buffer_unmap (&rtp);
+    gst_rtp_buffer_unmap (&list_rtp);
+  }
+
+  /* the FU-A headers go back to the pool and are reused for the next AU */
+  headers = g_hash_table_new (NULL, NULL);
+  for (i = 0; i < list_packets->len; i++) {
+    GstBuffer *buffer = g_ptr_array_index (list_packets, i);
+
+    if (buffer->pool)
+      g_hash_table_add (headers, gst_buffer_peek_memory (buffer, 0));
+  }
+  fail_unless (g_hash_table_size (headers) > 0);
+  g_ptr_array_unref (list_packets);
+
+  list_packets = pay_two_slices (h_list, &n_lists);
+  for (i = 0; i < list_packets->len; i++) {
+    GstBuffer *buffer = g_ptr_array_index (list_packets, i);
+
+    if (buffer->pool) {
+      fail_unless_equals_int (gst_buffer_n_memory (buffer), 2);
+      fail_unless (g_hash_table_contains (headers,
+              gst_buffer_peek_memory (buffer, 0)));
+      n_pooled++;
+    }
+  }
+  fail_unless_equals_int (n_pooled, g_hash_table_size (headers));
+
+  g_hash_table_unref (headers);
+  g_ptr_array_unref (packets);
+  g_ptr_array_unref (list_packets);
+  gst_harness_teardown (h);
+  gst_harness_teardown (h_list);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_rtph264pay_header_pool_replaced_memory)
+{
+  GstHarness *h;
+  GPtrArray *packets;
+  GstMemory *replacement = NULL;
+  guint i, n_lists;
+
+  h = gst_harness_new_parse ("rtph264pay timestamp-offset=123 mtu=40"
+      " buffer-list=true");
+  gst_harness_set_src_caps_str (h,
+      "video/x-h264,alignment=au,stream-format=byte-stream");
+  gst_pad_add_probe (h->sinkpad, GST_PAD_PROBE_TYPE_BUFFER_LIST,
+      count_buffer_lists, &n_lists, NULL);
+
+  /* replace the header memory of a pooled packet by a copy of it */
+  packets = pay_two_slices (h, &n_lists);
+  for (i = 0; i < packets->len && replacement == NULL; i++) {
+    GstBuffer *buffer = g_ptr_array_index (packets, i);
+
+    if (buffer->pool) {
+      replacement = gst_memory_copy (gst_buffer_peek_memory (buffer, 0), 0,
+          -1);
+      gst_buffer_replace_memory (buffer, 0, gst_memory_ref (replacement));
+    }
+  }
+  fail_unless (replacement != NULL);
+  g_ptr_array_unref (packets);
+
+  /* the packet was discarded instead of putting that memory in the pool */
+  packets = pay_two_slices (h, &n_lists);
+  for (i = 0; i < packets->len; i++) {
+    GstBuffer *buffer = g_ptr_array_index (packets, i);
+
+    fail_unless (gst_buffer_peek_memory (buffer, 0) != replacement);
+  }
+
+  gst_memory_unref (replacement);
+  g_ptr_array_unref (packets);
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+static GstPadProbeReturn
+count_packets (GstPad * pad, GstPadProbeInfo * info, gpointer user_data)
+{
+  guint64 *n_packets = user_data;
+
+  if (GST_PAD_PROBE_INFO_TYPE (info) & GST_PAD_PROBE_TYPE_BUFFER_LIST)
+    *n_packets +=
+        gst_buffer_list_length (GST_PAD_PROBE_INFO_BUFFER_LIST (info));
+  else
+    *n_packets += 1;
+
+  return GST_PAD_PROBE_OK;
+}
+
+static void
+pay_frames_perf (gsize frame_size, guint n_frames, gboolean buffer_list)
+{
+  GstHarness *h = gst_harness_new ("rtph264pay");
+  GstBuffer *frame;
+  GstMapInfo map;
+  GstClockTime start, elapsed;
+  guint64 n_packets = 0;
+  guint i;
+
+  g_object_set (h->element, "mtu", 1400, "buffer-list", buffer_list, NULL);
+  gst_harness_set_src_caps_str (h,
+      "video/x-h264,alignment=au,stream-format=byte-stream");
+  gst_harness_set_drop_buffers (h, TRUE);
+  gst_pad_add_probe (h->sinkpad,
+      GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_BUFFER_LIST,
+      count_packets, &n_packets, NULL);
+
+  /* a single IDR slice covering the whole frame */
+  frame = gst_buffer_new_and_alloc (frame_size);
+  gst_buffer_map (frame, &map, GST_MAP_WRITE);
+  memset (map.data, 0xab, map.size);
+  memcpy (map.data, h264_idr_slice_1, 6);
+  gst_buffer_unmap (frame, &map);
+
+  start = gst_util_get_timestamp ();
+  for (i = 0; i < n_frames; i++) {
+    GstBuffer *buffer = gst_buffer_copy (frame);
+
+    GST_BUFFER_PTS (buffer) = i * GST_SECOND / 30;
+    fail_unless_equals_int (gst_harness_push (h, buffer), GST_FLOW_OK);
+  }
+  elapsed = gst_util_get_timestamp () - start;
+
+  GST_INFO ("%" G_GSIZE_FORMAT " byte frames, buffer-list=%d: %"
+      G_GUINT64_FORMAT " packets in %" GST_TIME_FORMAT ", %.0f packets/s",
+      frame_size, buffer_list, n_packets, GST_TIME_ARGS (elapsed),
+      n_packets / ((gdouble) elapsed / GST_SECOND));
+
+  gst_buffer_unref (frame);
+  gst_harness_teardown (h);
+}
+
+GST_START_TEST (test_rtph264pay_buffer_list_perf)
+{
+  /* roughly 1080p at 25 Mbit/s and 4K at 100 Mbit/s, 30 fps */
+  pay_frames_perf (100000, 300, FALSE);
+  pay_frames_perf (100000, 300, TRUE);
+  pay_frames_perf (400000, 300, FALSE);
+  pay_frames_perf (400000, 300, TRUE);
+}
+
+GST_END_TEST;
+
 GST_START_TEST (test_rtph264pay_aggregate_two_slices_per_buffer)
 {
   GstHarness *h = gst_harness_new_parse ("rtph264pay timestamp-offset=123"
@@ -1469,6 +1920,8 @@ rtph264_suite (void)
   tcase_add_test (tc_chain, test_rtph264depay_stap_a_marker);
   tcase_add_test (tc_chain, test_rtph264depay_fu_a);
   tcase_add_test (tc_chain, test_rtph264depay_fu_a_missing_start);
+  tcase_add_test (tc_chain, test_rtph264depay_zero_copy);
+  tcase_add_test (tc_chain, test_rtph264depay_zero_copy_many_fragments);
 
   tc_chain = tcase_create ("rtph264pay");
   suite_add_tcase (s, tc_chain);
@@ -1477,6 +1930,8 @@ rtph264_suite (void)
   tcase_add_test (tc_chain, test_rtph264pay_marker_for_flag);
   tcase_add_test (tc_chain, test_rtph264pay_marker_for_au);
   tcase_add_test (tc_chain, test_rtph264pay_marker_for_fragmented_au);
+  tcase_add_test (tc_chain, test_rtph264pay_buffer_list);
+  tcase_add_test (tc_chain, test_rtph264pay_header_pool_replaced_memory);
   tcase_add_test (tc_chain, test_rtph264pay_aggregate_two_slices_per_buffer);
   tcase_add_test (tc_chain, test_rtph264pay_aggregate_with_aud);
   tcase_add_test (tc_chain, test_rtph264pay_aggregate_with_ts_change);
@@ -1487,6 +1942,15 @@ rtph264_suite (void)
   tcase_add_test (tc_chain, test_rtph264pay_avc_two_slices_per_buffer);
   tcase_add_test (tc_chain, test_rtph264pay_avc_incomplete_nal);
 
+  /* benchmarks only log their timings, run them with GST_CHECK_PERF=1 */
+  if (g_getenv ("GST_CHECK_PERF")) {
+    TCase *tc_perf = tcase_create ("perf");
+
+    suite_add_tcase (s, tc_perf);
+    tcase_add_test (tc_perf, test_rtph264depay_zero_copy_perf);
+    tcase_add_test (tc_perf, test_rtph264pay_buffer_list_perf);
+  }
+
   return s;
 }
 
@@ -413,6 +413,115 @@ GST_START_TEST (test_rtph265depay_marker_to_flag)
 
 GST_END_TEST;
 
+/* Returns the number of bytes of @buffer that reference the memory of
+ * another buffer instead of having been copied */
+static gsize
+get_shared_size (GstBuffer * buffer)
+{
+  guint i, n_memory = gst_buffer_n_memory (buffer);
+  gsize size = 0;
+
+  for (i = 0; i < n_memory; i++) {
+    GstMemory *mem = gst_buffer_peek_memory (buffer, i);
+
+    if (mem->parent != NULL)
+      size += mem->size;
+  }
+
+  return size;
+}
+
+#define FU_SIZE 1400
+
+/* Depayloads a frame of @n_fu FU packets and returns its content. Stores the
+ * number of output bytes that were not copied in @shared_size. */
+static GBytes *
+depay_fu_frame (gboolean zero_copy, guint n_fu, gsize * shared_size)
+{
+  GstHarness *h = gst_harness_new ("rtph265depay");
+  GByteArray *data = g_byte_array_new ();
+  GstMapInfo map;
+  GstBuffer *buffer;
+  guint j;
+
+  g_object_set (h->element, "zero-copy", zero_copy, NULL);
+  gst_harness_set_caps_str (h,
+      "application/x-rtp,media=video,clock-rate=90000,encoding-name=H265",
+      "video/x-h265,alignment=au,stream-format=byte-stream");
+
+  for (j = 0; j < n_fu; j++) {
+    GstRTPBuffer rtp = GST_RTP_BUFFER_INIT;
+    guint8 *payload;
+
+    buffer = gst_rtp_buffer_new_allocate (FU_SIZE, 0, 0);
+    fail_unless (gst_rtp_buffer_map (buffer, GST_MAP_WRITE, &rtp));
+    gst_rtp_buffer_set_seq (&rtp, j);
+    gst_rtp_buffer_set_marker (&rtp, j == n_fu - 1);
+    payload = gst_rtp_buffer_get_payload (&rtp);
+    memset (payload, j, FU_SIZE);
+    /* payload header (type 49) and FU header for a TRAIL_R slice */
+    payload[0] = 49 << 1;
+    payload[1] = 0x01;
+    payload[2] = GST_H265_NAL_SLICE_TRAIL_R;
+    if (j == 0)
+      payload[2] |= 0x80;
+    if (j == n_fu - 1)
+      payload[2] |= 0x40;
+    /* first_slice_segment_in_pic_flag */
+    payload[3] = 0x80;
+    gst_rtp_buffer_unmap (&rtp);
+    GST_BUFFER_PTS (buffer) = 0;
+
+    fail_unless_equals_int (gst_harness_push (h, buffer), GST_FLOW_OK);
+  }
+
+  /* the AU is pushed as one timestamped buffer with the marker */
+  fail_unless_equals_int (gst_harness_buffers_in_queue (h), 1);
+  buffer = gst_harness_pull (h);
+  fail_unless (gst_buffer_n_memory (buffer) <= gst_buffer_get_max_memory ());
+  fail_unless_equals_uint64 (GST_BUFFER_PTS (buffer), 0);
+  fail_unless (GST_BUFFER_FLAG_IS_SET (buffer, GST_BUFFER_FLAG_MARKER));
+  *shared_size = get_shared_size (buffer);
+  fail_unless (gst_buffer_map (buffer, &map, GST_MAP_READ));
+  g_byte_array_append (data, map.data, map.size);
+  gst_buffer_unmap (buffer, &map);
+  gst_buffer_unref (buffer);
+
+  gst_harness_teardown (h);
+
+  return g_byte_array_free_to_bytes (data);
+}
+
+GST_START_TEST (test_rtph265depay_zero_copy)
+{
+  GBytes *copied, *referenced;
+  gsize shared_size, expected_size;
+  guint n_fu;
+
+  /* with less and more fragments than memories fit in a buffer */
+  for (n_fu = 4; n_fu <= 40; n_fu += 36) {
+    copied = depay_fu_frame (FALSE, n_fu, &shared_size);
+    fail_unless_equals_uint64 (shared_size, 0);
+
+    /* the start code and NAL header are copied, and so are the fragments
+     * that don't fit next to them in a buffer */
+    referenced = depay_fu_frame (TRUE, n_fu, &shared_size);
+    if (n_fu + 1 > gst_buffer_get_max_memory ())
+      expected_size = (gst_buffer_get_max_memory () - 2) * (FU_SIZE - 3);
+    else
+      expected_size = n_fu * (FU_SIZE - 3);
+    fail_unless_equals_uint64 (shared_size, expected_size);
+
+    /* Referencing the payload memories must not change the bitstream */
+    fail_unless (g_bytes_equal (copied, referenced));
+
+    g_bytes_unref (copied);
+    g_bytes_unref (referenced);
+  }
+}
+
+GST_END_TEST;
+
 /* These were generated using pipeline:
  * gst-launch-1.0 videotestsrc num-buffers=1 pattern=green \
  *     ! video/x-raw,width=256,height=256 \
@@ -1289,6 +1398,7 @@ rtph265_suite (void)
   tcase_add_test (tc_chain, test_rtph265depay_with_downstream_allocator);
   tcase_add_test (tc_chain, test_rtph265depay_eos);
   tcase_add_test (tc_chain, test_rtph265depay_marker_to_flag);
+  tcase_add_test (tc_chain, test_rtph265depay_zero_copy);
   /* TODO We need a sample to test with */
   /* tcase_add_test (tc_chain, test_rtph265depay_aggregate_marker); */
 
@@ -3498,6 +3498,66 @@ GST_START_TEST (test_gap_using_rtx_does_not_stall)
 
 GST_END_TEST;
 
+static void
+push_jitter_trace (GstHarness * h, guint * seqnum, guint num_packets,
+    GRand * rand, guint max_jitter_ms)
+{
+  guint i;
+
+  for (i = 0; i < num_packets; i++, (*seqnum)++) {
+    GstClockTime jitter =
+        g_rand_int_range (rand, 0, max_jitter_ms + 1) * GST_MSECOND;
+
+    fail_unless_equals_int (GST_FLOW_OK, gst_harness_push (h,
+            generate_test_buffer_full (*seqnum * TEST_BUF_DURATION + jitter,
+                *seqnum, *seqnum * TEST_RTP_TS_DURATION)));
+  }
+}
+
+GST_START_TEST (test_adaptive_latency)
+{
+  GstHarness *h = gst_harness_new ("rtpjitterbuffer");
+  GRand *rand = g_rand_new_with_seed (0x5eed);
+  guint seqnum = 0;
+  guint low_latency, high_latency, latency;
+  guint64 target;
+  GstStructure *stats;
+
+  g_object_set (h->element, "latency", 200, "adaptive-latency", TRUE,
+      "adaptive-latency-min", 20, "adaptive-latency-max", 500,
+      "adaptive-latency-loss", 1.0, NULL);
+  gst_harness_set_src_caps (h, generate_caps ());
+  gst_harness_set_drop_buffers (h, TRUE);
+
+  /* a quiet network, the latency comes down from the configured value */
+  push_jitter_trace (h, &seqnum, 1000, rand, 4);
+  g_object_get (h->element, "latency", &low_latency, NULL);
+  fail_unless (low_latency < 200, "latency %u", low_latency);
+
+  /* jitter of up to 150 ms, the latency must cover it */
+  push_jitter_trace (h, &seqnum, 1000, rand, 150);
+  g_object_get (h->element, "latency", &high_latency, NULL);
+  fail_unless (high_latency >= 140, "latency %u", high_latency);
+  fail_unless (high_latency <= 200, "latency %u", high_latency);
+
+  g_object_get (h->element, "stats", &stats, NULL);
+  fail_unless (gst_structure_get_uint64 (stats, "adaptive-latency-target",
+          &target));
+  fail_unless (target >= 140 * GST_MSECOND);
+  gst_structure_free (stats);
+
+  /* and it comes back down slowly when the network calms down */
+  push_jitter_trace (h, &seqnum, 1000, rand, 4);
+  g_object_get (h->element, "latency", &latency, NULL);
+  fail_unless (latency < high_latency, "latency %u", latency);
+  fail_unless (latency >= 20, "latency %u", latency);
+
+  g_rand_free (rand);
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
 static Suite *
 rtpjitterbuffer_suite (void)
 {
@@ -3577,6 +3637,7 @@ rtpjitterbuffer_suite (void)
   tcase_add_test (tc_chain, test_multiple_lost_do_not_stall);
   tcase_add_test (tc_chain, test_reset_using_rtx_packets_does_not_stall);
   tcase_add_test (tc_chain, test_gap_using_rtx_does_not_stall);
+  tcase_add_test (tc_chain, test_adaptive_latency);
 
 
   return s;
@@ -22,6 +22,8 @@
 #include <gst/app/app.h>
 #include <gst/rtp/gstrtpbuffer.h>
 
+#include <string.h>
+
 
 /* one complete blank jpeg 1x1 */
 static const guint8 rtp_jpeg_frame_data[] =
@@ -208,6 +210,110 @@ static const guint8 rtp_jpeg_frame_data_s5[] = {
 };
 
 
+/* a 4:2:0 JPEG with both quant tables filled with @q, a restart interval
+ * of @dri MCUs if not 0, and a scan of @scan_size bytes, with a stuffed
+ * 0xff every 256 bytes */
+static GstBuffer *
+make_jpeg_frame (guint width, guint height, guint8 q, guint16 dri,
+    gsize scan_size)
+{
+  static const guint8 jfif[] = {
+    /* SOI */ 0xff, 0xd8,
+    /* APP0 */ 0xff, 0xe0, 0x00, 0x10, 0x4a, 0x46, 0x49, 0x46, 0x00, 0x01,
+    0x01, 0x01, 0x00, 0x60, 0x00, 0x60, 0x00, 0x00
+  };
+  static const guint8 sos[] = {
+    /* SOS */ 0xff, 0xda, 0x00, 0x0c, 0x03, 0x01, 0x00, 0x02, 0x11, 0x03,
+    0x11, 0x00, 0x3f, 0x00
+  };
+  GstBuffer *buffer;
+  GstMapInfo map;
+  guint8 *p;
+  gsize i;
+  gint t;
+
+  buffer = gst_buffer_new_allocate (NULL,
+      sizeof (jfif) + 2 * 69 + (dri ? 6 : 0) + 19 + sizeof (sos) +
+      scan_size + 2, NULL);
+  gst_buffer_map (buffer, &map, GST_MAP_WRITE);
+  p = map.data;
+
+  memcpy (p, jfif, sizeof (jfif));
+  p += sizeof (jfif);
+
+  for (t = 0; t < 2; t++) {
+    /* DQT */
+    *p++ = 0xff;
+    *p++ = 0xdb;
+    *p++ = 0x00;
+    *p++ = 0x43;
+    *p++ = t;
+    memset (p, q, 64);
+    p += 64;
+  }
+
+  if (dri) {
+    /* DRI */
+    *p++ = 0xff;
+    *p++ = 0xdd;
+    *p++ = 0x00;
+    *p++ = 0x04;
+    *p++ = dri >> 8;
+    *p++ = dri;
+  }
+
+  /* SOF */
+  *p++ = 0xff;
+  *p++ = 0xc0;
+  *p++ = 0x00;
+  *p++ = 0x11;
+  *p++ = 0x08;
+  *p++ = height >> 8;
+  *p++ = height;
+  *p++ = width >> 8;
+  *p++ = width;
+  *p++ = 0x03;
+  *p++ = 0x01;
+  *p++ = 0x22;
+  *p++ = 0x00;
+  *p++ = 0x02;
+  *p++ = 0x11;
+  *p++ = 0x01;
+  *p++ = 0x03;
+  *p++ = 0x11;
+  *p++ = 0x01;
+
+  memcpy (p, sos, sizeof (sos));
+  p += sizeof (sos);
+
+  for (i = 0; i < scan_size; i++)
+    p[i] = (i % 256) == 254 ? 0xff : (i % 256) == 255 ? 0x00 : i & 0x7f;
+  p += scan_size;
+
+  *p++ = 0xff;
+  *p++ = 0xd9;
+  gst_buffer_unmap (buffer, &map);
+
+  return buffer;
+}
+
+/* payload @frame and depayload all of its packets into one JPEG */
+static GstBuffer *
+jpeg_roundtrip (GstHarness * pay, GstHarness * depay, GstBuffer * frame)
+{
+  GstBuffer *buffer;
+
+  fail_unless_equals_int (gst_harness_push (pay, frame), GST_FLOW_OK);
+  if (!gst_pad_has_current_caps (depay->srcpad))
+    gst_harness_set_src_caps (depay, gst_pad_get_current_caps (pay->sinkpad));
+
+  while ((buffer = gst_harness_try_pull (pay)))
+    fail_unless_equals_int (gst_harness_push (depay, buffer), GST_FLOW_OK);
+
+  fail_unless_equals_int (gst_harness_buffers_in_queue (depay), 1);
+  return gst_harness_pull (depay);
+}
+
 /*
  * rfc2435 3.1.  JPEG header
  *
@@ -335,6 +441,81 @@ GST_START_TEST (test_rtpjpegpay_5_slices)
 GST_END_TEST;
 
 
+/* the memory holding the JPEG header that the depayloader put in front of
+ * the scan data */
+static GstMemory *
+peek_header_memory (GstBuffer * buffer)
+{
+  GstMemory *mem = gst_buffer_peek_memory (buffer, 0);
+
+  return mem->parent ? mem->parent : mem;
+}
+
+/* the depayloader reuses the JPEG header of the previous frame as long as
+ * the quant tables, the restart interval and the size stay the same */
+GST_START_TEST (test_rtpjpegdepay_header_cache)
+{
+  GstHarness *pay = gst_harness_new ("rtpjpegpay");
+  GstHarness *depay = gst_harness_new ("rtpjpegdepay");
+  GstBuffer *first, *second, *tables, *restart, *size, *same;
+  gsize header_size;
+  GstMapInfo map;
+
+  gst_harness_set_src_caps_str (pay,
+      "image/jpeg,width=1280,height=720,framerate=30/1");
+
+  first = jpeg_roundtrip (pay, depay, make_jpeg_frame (1280, 720, 4, 0, 4096));
+  second = jpeg_roundtrip (pay, depay,
+      make_jpeg_frame (1280, 720, 4, 0, 4096));
+
+  fail_unless (gst_buffer_n_memory (first) > 1);
+  fail_unless (peek_header_memory (first) == peek_header_memory (second));
+  fail_unless (gst_buffer_get_size (first) == gst_buffer_get_size (second));
+  gst_buffer_map (first, &map, GST_MAP_READ);
+  fail_unless (gst_buffer_memcmp (second, 0, map.data, map.size) == 0);
+
+  /* SOI, then the DQT marker, length and table id of the first table */
+  fail_unless_equals_int (map.data[0], 0xff);
+  fail_unless_equals_int (map.data[1], 0xd8);
+  fail_unless_equals_int (map.data[7], 4);
+  gst_buffer_unmap (first, &map);
+
+  /* other quant tables */
+  tables = jpeg_roundtrip (pay, depay, make_jpeg_frame (1280, 720, 9, 0, 4096));
+  fail_unless (peek_header_memory (tables) != peek_header_memory (second));
+  gst_buffer_map (tables, &map, GST_MAP_READ);
+  fail_unless_equals_int (map.data[7], 9);
+  gst_buffer_unmap (tables, &map);
+
+  /* a restart interval adds a DRI marker */
+  restart = jpeg_roundtrip (pay, depay,
+      make_jpeg_frame (1280, 720, 9, 16, 4096));
+  fail_unless (peek_header_memory (restart) != peek_header_memory (tables));
+  header_size = gst_memory_get_sizes (peek_header_memory (tables), NULL, NULL);
+  fail_unless_equals_int (gst_memory_get_sizes (peek_header_memory (restart),
+          NULL, NULL), header_size + 6);
+
+  /* other dimensions */
+  size = jpeg_roundtrip (pay, depay, make_jpeg_frame (640, 480, 9, 16, 4096));
+  fail_unless (peek_header_memory (size) != peek_header_memory (restart));
+
+  /* and the new header is reused again */
+  same = jpeg_roundtrip (pay, depay, make_jpeg_frame (640, 480, 9, 16, 4096));
+  fail_unless (peek_header_memory (same) == peek_header_memory (size));
+
+  gst_buffer_unref (first);
+  gst_buffer_unref (second);
+  gst_buffer_unref (tables);
+  gst_buffer_unref (restart);
+  gst_buffer_unref (size);
+  gst_buffer_unref (same);
+  gst_harness_teardown (pay);
+  gst_harness_teardown (depay);
+}
+
+GST_END_TEST;
+
+
 static Suite *
 rtpjpeg_suite (void)
 {
@@ -347,6 +528,11 @@ rtpjpeg_suite (void)
   tcase_add_test (tc_chain, test_rtpjpegpay_1_slice);
   tcase_add_test (tc_chain, test_rtpjpegpay_5_slices);
 
+  tc_chain = tcase_create ("rtpjpegdepay");
+  suite_add_tcase (s, tc_chain);
+
+  tcase_add_test (tc_chain, test_rtpjpegdepay_header_cache);
+
   return s;
 }
 
@@ -0,0 +1,217 @@
+/* GStreamer RTP MPEG-TS unit test
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/check/check.h>
+
+#define TS_PACKET_SIZE 188
+#define TS_CAPS "video/mpegts,packetsize=188,systemstream=true"
+
+static GstBuffer *
+make_ts (guint n_packets, guint seed)
+{
+  GstBuffer *buffer;
+  GstMapInfo map;
+  guint i, j;
+
+  buffer = gst_buffer_new_allocate (NULL, n_packets * TS_PACKET_SIZE, NULL);
+  gst_buffer_map (buffer, &map, GST_MAP_WRITE);
+  for (i = 0; i < n_packets; i++) {
+    guint8 *packet = map.data + i * TS_PACKET_SIZE;
+
+    packet[0] = 0x47;
+    for (j = 1; j < TS_PACKET_SIZE; j++)
+      packet[j] = (i * 3 + j + seed) & 0xff;
+  }
+  gst_buffer_unmap (buffer, &map);
+
+  return buffer;
+}
+
+static GstPadProbeReturn
+count_lists (GstPad * pad, GstPadProbeInfo * info, gpointer user_data)
+{
+  guint *n_lists = user_data;
+
+  (*n_lists)++;
+
+  return GST_PAD_PROBE_OK;
+}
+
+/* Payload the same data with and without buffer lists, the packets must be
+ * the same */
+GST_START_TEST (test_rtpmp2t_pay_buffer_list)
+{
+  GstHarness *h = gst_harness_new ("rtpmp2tpay");
+  GstHarness *hl = gst_harness_new_parse ("rtpmp2tpay buffer-list=true");
+  guint n_lists = 0, n_packets = 0;
+  GstBuffer *out, *outl;
+  guint i;
+
+  gst_harness_set_src_caps_str (h, TS_CAPS);
+  gst_harness_set_src_caps_str (hl, TS_CAPS);
+  gst_pad_add_probe (hl->sinkpad, GST_PAD_PROBE_TYPE_BUFFER_LIST, count_lists,
+      &n_lists, NULL);
+
+  for (i = 0; i < 3; i++) {
+    GstBuffer *in = make_ts (70, i);
+
+    GST_BUFFER_PTS (in) = i * GST_SECOND;
+    fail_unless_equals_int (gst_harness_push (h, gst_buffer_ref (in)),
+        GST_FLOW_OK);
+    fail_unless_equals_int (gst_harness_push (hl, in), GST_FLOW_OK);
+  }
+
+  while ((out = gst_harness_try_pull (h))) {
+    GstMapInfo map, mapl;
+
+    outl = gst_harness_pull (hl);
+    fail_unless (gst_buffer_map (out, &map, GST_MAP_READ));
+    fail_unless (gst_buffer_map (outl, &mapl, GST_MAP_READ));
+    fail_unless_equals_int (map.size, mapl.size);
+    /* the sequence numbers and ssrc are random */
+    fail_unless (memcmp (map.data + 12, mapl.data + 12, map.size - 12) == 0);
+    fail_unless_equals_uint64 (GST_BUFFER_PTS (out), GST_BUFFER_PTS (outl));
+    gst_buffer_unmap (out, &map);
+    gst_buffer_unmap (outl, &mapl);
+    gst_buffer_unref (out);
+    gst_buffer_unref (outl);
+    n_packets++;
+  }
+  fail_unless (gst_harness_try_pull (hl) == NULL);
+
+  /* 70 packets per buffer, 7 per RTP packet */
+  fail_unless_equals_int (n_packets, 30);
+  fail_unless_equals_int (n_lists, 3);
+
+  gst_harness_teardown (h);
+  gst_harness_teardown (hl);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_rtpmp2t_roundtrip)
+{
+  GstHarness *h =
+      gst_harness_new_parse ("rtpmp2tpay buffer-list=true ! rtpmp2tdepay");
+  GstBuffer *in, *out;
+  GstMapInfo inmap;
+  gsize offset = 0;
+
+  gst_harness_set_src_caps_str (h, TS_CAPS);
+
+  in = make_ts (100, 0);
+  fail_unless_equals_int (gst_harness_push (h, gst_buffer_ref (in)),
+      GST_FLOW_OK);
+
+  gst_buffer_map (in, &inmap, GST_MAP_READ);
+  while ((out = gst_harness_try_pull (h))) {
+    gsize size = gst_buffer_get_size (out);
+
+    fail_unless (offset + size <= inmap.size);
+    fail_unless (gst_buffer_memcmp (out, 0, inmap.data + offset, size) == 0);
+    offset += size;
+    gst_buffer_unref (out);
+  }
+  fail_unless_equals_int (offset, inmap.size);
+  gst_buffer_unmap (in, &inmap);
+  gst_buffer_unref (in);
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+/* about one second of a 20 Mbit/s stream, in buffers of 70 TS packets */
+#define PERF_BUFFERS 190
+#define PERF_BUFFER_PACKETS 70
+
+GST_START_TEST (test_rtpmp2t_perf)
+{
+  gboolean buffer_list[] = { FALSE, TRUE };
+  guint i, b;
+
+  for (i = 0; i < G_N_ELEMENTS (buffer_list); i++) {
+    GstHarness *pay = gst_harness_new ("rtpmp2tpay");
+    GstHarness *depay = gst_harness_new ("rtpmp2tdepay");
+    GPtrArray *packets = g_ptr_array_new ();
+    GstClockTime start, pay_time, depay_time;
+    GstBuffer *in, *packet;
+    gdouble bits;
+
+    g_object_set (pay->element, "buffer-list", buffer_list[i], NULL);
+    gst_harness_set_src_caps_str (pay, TS_CAPS);
+    in = make_ts (PERF_BUFFER_PACKETS, 0);
+
+    start = gst_util_get_timestamp ();
+    for (b = 0; b < PERF_BUFFERS; b++) {
+      GstBuffer *buffer = gst_buffer_copy (in);
+
+      GST_BUFFER_PTS (buffer) = b * GST_SECOND / PERF_BUFFERS;
+      fail_unless_equals_int (gst_harness_push (pay, buffer), GST_FLOW_OK);
+    }
+    pay_time = gst_util_get_timestamp () - start;
+
+    while ((packet = gst_harness_try_pull (pay)))
+      g_ptr_array_add (packets, packet);
+
+    gst_harness_set_src_caps (depay,
+        gst_pad_get_current_caps (pay->sinkpad));
+    gst_harness_set_drop_buffers (depay, TRUE);
+
+    start = gst_util_get_timestamp ();
+    for (b = 0; b < packets->len; b++)
+      gst_harness_push (depay, g_ptr_array_index (packets, b));
+    depay_time = gst_util_get_timestamp () - start;
+
+    bits = (gdouble) gst_buffer_get_size (in) * 8 * PERF_BUFFERS;
+    GST_INFO ("buffer-list %d: %u packets, pay %.0f Mbit/s, "
+        "depay %.0f Mbit/s per stream", buffer_list[i], packets->len,
+        bits * 1000 / pay_time, bits * 1000 / depay_time);
+
+    g_ptr_array_unref (packets);
+    gst_buffer_unref (in);
+    gst_harness_teardown (pay);
+    gst_harness_teardown (depay);
+  }
+}
+
+GST_END_TEST;
+
+static Suite *
+rtpmp2t_suite (void)
+{
+  Suite *s = suite_create ("rtpmp2t");
+  TCase *tc_chain;
+
+  tc_chain = tcase_create ("general");
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_rtpmp2t_pay_buffer_list);
+  tcase_add_test (tc_chain, test_rtpmp2t_roundtrip);
+
+  /* benchmarks only log their timings, run them with GST_CHECK_PERF=1 */
+  if (g_getenv ("GST_CHECK_PERF")) {
+    TCase *tc_perf = tcase_create ("perf");
+
+    suite_add_tcase (s, tc_perf);
+    tcase_add_test (tc_perf, test_rtpmp2t_perf);
+  }
+
+  return s;
+}
+
+GST_CHECK_MAIN (rtpmp2t);
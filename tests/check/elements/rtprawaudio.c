@@ -0,0 +1,215 @@
+/* GStreamer RTP L16/L24 unit test
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/check/check.h>
+#include <gst/rtp/gstrtpbuffer.h>
+
+/* FL FR FC LFE1 SL SR */
+#define MASK_6 G_GUINT64_CONSTANT (0xc0f)
+/* FL FR FC LFE1 RL RR SL SR */
+#define MASK_8 G_GUINT64_CONSTANT (0xc3f)
+
+static GstCaps *
+make_caps (gint bps, gint rate, gint channels)
+{
+  GstCaps *caps;
+
+  caps = gst_caps_new_simple ("audio/x-raw",
+      "format", G_TYPE_STRING, bps == 2 ? "S16BE" : "S24BE",
+      "rate", G_TYPE_INT, rate, "channels", G_TYPE_INT, channels,
+      "layout", G_TYPE_STRING, "interleaved", NULL);
+
+  if (channels == 6)
+    gst_caps_set_simple (caps, "channel-mask", GST_TYPE_BITMASK, MASK_6, NULL);
+  else if (channels == 8)
+    gst_caps_set_simple (caps, "channel-mask", GST_TYPE_BITMASK, MASK_8, NULL);
+  else if (channels > 2)
+    gst_caps_set_simple (caps, "channel-mask", GST_TYPE_BITMASK,
+        G_GUINT64_CONSTANT (0), NULL);
+
+  return caps;
+}
+
+/* each sample holds the index of its channel in the low byte and the frame
+ * number in the upper bytes */
+static GstBuffer *
+make_samples (gint bps, gint channels, guint n_frames)
+{
+  GstBuffer *buffer;
+  GstMapInfo map;
+  guint f, c;
+
+  buffer = gst_buffer_new_allocate (NULL, n_frames * channels * bps, NULL);
+  gst_buffer_map (buffer, &map, GST_MAP_WRITE);
+  for (f = 0; f < n_frames; f++) {
+    for (c = 0; c < channels; c++) {
+      guint8 *sample = map.data + (f * channels + c) * bps;
+
+      sample[0] = f >> 8;
+      sample[1] = f;
+      if (bps == 3)
+        sample[2] = 0;
+      sample[bps - 1] = c;
+    }
+  }
+  gst_buffer_unmap (buffer, &map);
+
+  return buffer;
+}
+
+static void
+check_channel_order (GstBuffer * buffer, gint bps, gint channels,
+    const guint8 * order)
+{
+  GstMapInfo map;
+  gsize i;
+
+  gst_buffer_map (buffer, &map, GST_MAP_READ);
+  fail_unless_equals_int (map.size % (bps * channels), 0);
+  for (i = 0; i < map.size / bps; i++)
+    fail_unless_equals_int (map.data[i * bps + bps - 1], order[i % channels]);
+  gst_buffer_unmap (buffer, &map);
+}
+
+/* 5.1 is sent in the DV.LRLsRsCS order */
+GST_START_TEST (test_rtp_raw_audio_reorder)
+{
+  static const guint8 gst_order[] = { 0, 1, 2, 3, 4, 5 };
+  static const guint8 rtp_order[] = { 0, 1, 4, 5, 2, 3 };
+  gint bps;
+
+  for (bps = 2; bps <= 3; bps++) {
+    GstHarness *pay = gst_harness_new (bps == 2 ? "rtpL16pay" : "rtpL24pay");
+    GstHarness *depay =
+        gst_harness_new (bps == 2 ? "rtpL16depay" : "rtpL24depay");
+    GstBuffer *buffer;
+    GstRTPBuffer rtp = GST_RTP_BUFFER_INIT;
+
+    gst_harness_set_src_caps (pay, make_caps (bps, 48000, 6));
+    fail_unless_equals_int (gst_harness_push (pay, make_samples (bps, 6, 48)),
+        GST_FLOW_OK);
+    gst_harness_set_src_caps (depay, gst_pad_get_current_caps (pay->sinkpad));
+
+    while ((buffer = gst_harness_try_pull (pay))) {
+      GstBuffer *payload;
+
+      fail_unless (gst_rtp_buffer_map (buffer, GST_MAP_READ, &rtp));
+      payload = gst_rtp_buffer_get_payload_buffer (&rtp);
+      gst_rtp_buffer_unmap (&rtp);
+      check_channel_order (payload, bps, 6, rtp_order);
+      gst_buffer_unref (payload);
+
+      fail_unless_equals_int (gst_harness_push (depay, buffer), GST_FLOW_OK);
+      buffer = gst_harness_pull (depay);
+      check_channel_order (buffer, bps, 6, gst_order);
+      gst_buffer_unref (buffer);
+    }
+
+    gst_harness_teardown (pay);
+    gst_harness_teardown (depay);
+  }
+}
+
+GST_END_TEST;
+
+/* one second of 96 kHz audio in 1 ms packets */
+#define PERF_RATE 96000
+#define PERF_PACKETS 1000
+
+GST_START_TEST (test_rtp_raw_audio_perf)
+{
+  static const gint channels[] = { 2, 6, 8, 16, 32, 64 };
+  gint bps;
+  guint i, p;
+
+  for (bps = 2; bps <= 3; bps++) {
+    for (i = 0; i < G_N_ELEMENTS (channels); i++) {
+      GstHarness *pay = gst_harness_new (bps == 2 ? "rtpL16pay" : "rtpL24pay");
+      GstHarness *depay =
+          gst_harness_new (bps == 2 ? "rtpL16depay" : "rtpL24depay");
+      guint n_frames = PERF_RATE / 1000;
+      GstClockTime start, pay_time, depay_time;
+      GPtrArray *packets = g_ptr_array_new ();
+      GstBuffer *in, *packet;
+      gdouble samples;
+
+      /* one packet per ms, even for 64 channels */
+      g_object_set (pay->element, "mtu", 12 + n_frames * channels[i] * bps,
+          "min-ptime", GST_MSECOND, "max-ptime", GST_MSECOND, NULL);
+      gst_harness_set_src_caps (pay, make_caps (bps, PERF_RATE, channels[i]));
+      in = make_samples (bps, channels[i], n_frames);
+
+      start = gst_util_get_timestamp ();
+      for (p = 0; p < PERF_PACKETS; p++) {
+        GstBuffer *buffer = gst_buffer_copy (in);
+
+        GST_BUFFER_PTS (buffer) = p * GST_MSECOND;
+        GST_BUFFER_DURATION (buffer) = GST_MSECOND;
+        fail_unless_equals_int (gst_harness_push (pay, buffer), GST_FLOW_OK);
+      }
+      pay_time = gst_util_get_timestamp () - start;
+
+      while ((packet = gst_harness_try_pull (pay)))
+        g_ptr_array_add (packets, packet);
+
+      gst_harness_set_src_caps (depay,
+          gst_pad_get_current_caps (pay->sinkpad));
+      gst_harness_set_drop_buffers (depay, TRUE);
+
+      start = gst_util_get_timestamp ();
+      for (p = 0; p < packets->len; p++)
+        gst_harness_push (depay, g_ptr_array_index (packets, p));
+      depay_time = gst_util_get_timestamp () - start;
+
+      samples = (gdouble) PERF_PACKETS * n_frames * channels[i];
+      GST_INFO ("L%d %d channels: %u packets, pay %.1f Msamples/s, "
+          "depay %.1f Msamples/s", bps * 8, channels[i], packets->len,
+          samples * 1000 / pay_time, samples * 1000 / depay_time);
+
+      g_ptr_array_unref (packets);
+      gst_buffer_unref (in);
+      gst_harness_teardown (pay);
+      gst_harness_teardown (depay);
+    }
+  }
+}
+
+GST_END_TEST;
+
+static Suite *
+rtprawaudio_suite (void)
+{
+  Suite *s = suite_create ("rtprawaudio");
+  TCase *tc_chain;
+
+  tc_chain = tcase_create ("general");
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_rtp_raw_audio_reorder);
+
+  /* benchmarks only log their timings, run them with GST_CHECK_PERF=1 */
+  if (g_getenv ("GST_CHECK_PERF")) {
+    TCase *tc_perf = tcase_create ("perf");
+
+    suite_add_tcase (s, tc_perf);
+    tcase_add_test (tc_perf, test_rtp_raw_audio_perf);
+  }
+
+  return s;
+}
+
+GST_CHECK_MAIN (rtprawaudio);
@@ -507,6 +507,167 @@ GST_START_TEST (test_multiple_senders_roundrobin_rbs)
 
 GST_END_TEST;
 
+static GstBuffer *
+generate_rr_compound (guint32 first_ssrc, guint num_ssrcs)
+{
+  GstBuffer *buf = gst_rtcp_buffer_new (num_ssrcs * 8);
+  GstRTCPBuffer rtcp = GST_RTCP_BUFFER_INIT;
+  GstRTCPPacket packet;
+  guint i;
+
+  gst_rtcp_buffer_map (buf, GST_MAP_READWRITE, &rtcp);
+  for (i = 0; i < num_ssrcs; i++) {
+    fail_unless (gst_rtcp_buffer_add_packet (&rtcp, GST_RTCP_TYPE_RR,
+            &packet));
+    gst_rtcp_packet_rr_set_ssrc (&packet, first_ssrc + i);
+  }
+  gst_rtcp_buffer_unmap (&rtcp);
+
+  return buf;
+}
+
+/* Many idle remote receivers and a few remote senders. Only the senders get
+ * report blocks, but every timeout still visits all sources to check them
+ * for timeouts, so the time per report grows with the number of sources.
+ * This measures how much of it is left */
+GST_START_TEST (test_many_idle_sources_rtcp_perf)
+{
+  const guint num_idle[] = { 0, 100, 1000, 5000 };
+  guint rounds = 20;
+  guint n;
+
+  for (n = 0; n < G_N_ELEMENTS (num_idle); n++) {
+    SessionHarness *h = session_harness_new ();
+    gdouble elapsed = 0.0;
+    GTimer *timer;
+    guint i, k;
+
+    g_object_set (h->internal_session, "internal-ssrc", 0xDEADBEEF, NULL);
+
+    for (i = 0; i < rounds; i++) {
+      GstBuffer *buf;
+      GstRTCPBuffer rtcp = GST_RTCP_BUFFER_INIT;
+      GstRTCPPacket rtcp_packet;
+
+      /* keep the senders and the idle receivers alive */
+      for (k = 0; k < 2; k++)
+        fail_unless_equals_int (GST_FLOW_OK,
+            session_harness_recv_rtp (h, generate_test_buffer (i, 10000 + k)));
+      if (num_idle[n] > 0)
+        fail_unless_equals_int (GST_FLOW_OK, session_harness_recv_rtcp (h,
+                generate_rr_compound (20000, num_idle[n])));
+
+      timer = g_timer_new ();
+      session_harness_produce_rtcp (h, 1);
+      elapsed += g_timer_elapsed (timer, NULL);
+      g_timer_destroy (timer);
+
+      while (gst_harness_buffers_in_queue (h->rtcp_h) > 0) {
+        buf = session_harness_pull_rtcp (h);
+        fail_unless (gst_rtcp_buffer_validate (buf));
+        gst_rtcp_buffer_map (buf, GST_MAP_READ, &rtcp);
+        fail_unless (gst_rtcp_buffer_get_first_packet (&rtcp, &rtcp_packet));
+        fail_unless_equals_int (GST_RTCP_TYPE_RR,
+            gst_rtcp_packet_get_type (&rtcp_packet));
+        /* only the remote senders are reported */
+        fail_unless (gst_rtcp_packet_get_rb_count (&rtcp_packet) <= 2);
+        gst_rtcp_buffer_unmap (&rtcp);
+        gst_buffer_unref (buf);
+      }
+    }
+
+    GST_INFO ("%u idle sources: %u reports in %.3f s (%.1f us per report)",
+        num_idle[n], rounds, elapsed, elapsed * G_USEC_PER_SEC / rounds);
+
+    session_harness_free (h);
+  }
+}
+
+GST_END_TEST;
+
+typedef struct
+{
+  GstElement *session;
+  volatile gint running;
+  guint polls;
+} StatsPoller;
+
+static gpointer
+_poll_stats (gpointer user_data)
+{
+  StatsPoller *poller = user_data;
+
+  while (g_atomic_int_get (&poller->running)) {
+    GstStructure *stats;
+
+    g_object_get (poller->session, "stats", &stats, NULL);
+    gst_structure_free (stats);
+    poller->polls++;
+  }
+
+  return NULL;
+}
+
+/* Packets from many sources are received while another thread keeps polling
+ * the stats. The stats structures are built without holding the session lock,
+ * so the polling should barely show up in the time spent per packet */
+GST_START_TEST (test_stats_polling_perf)
+{
+  const guint num_sources = 500;
+  const guint rounds = 20;
+  guint poll;
+
+  for (poll = 0; poll < 2; poll++) {
+    SessionHarness *h = session_harness_new ();
+    StatsPoller poller = { h->session, 1, 0 };
+    GThread *thread = NULL;
+    gint64 start, elapsed, total = 0, max = 0;
+    guint i, k;
+
+    /* let every packet through right away */
+    g_object_set (h->internal_session, "probation", 0, NULL);
+
+    /* create all the sources first */
+    for (k = 0; k < num_sources; k++) {
+      fail_unless_equals_int (GST_FLOW_OK,
+          session_harness_recv_rtp (h, generate_test_buffer (0, 10000 + k)));
+      gst_buffer_unref (gst_harness_pull (h->recv_rtp_h));
+    }
+
+    if (poll)
+      thread = g_thread_new ("stats-poller", _poll_stats, &poller);
+
+    for (i = 1; i <= rounds; i++) {
+      for (k = 0; k < num_sources; k++) {
+        GstBuffer *buf = generate_test_buffer (i, 10000 + k);
+
+        start = g_get_monotonic_time ();
+        fail_unless_equals_int (GST_FLOW_OK,
+            session_harness_recv_rtp (h, buf));
+        elapsed = g_get_monotonic_time () - start;
+
+        total += elapsed;
+        max = MAX (max, elapsed);
+        gst_buffer_unref (gst_harness_pull (h->recv_rtp_h));
+      }
+    }
+
+    if (thread) {
+      g_atomic_int_set (&poller.running, 0);
+      g_thread_join (thread);
+    }
+
+    GST_INFO ("%u sources, %s stats polling (%u polls): avg %.2f us, "
+        "max %" G_GINT64_FORMAT " us per packet", num_sources,
+        poll ? "with" : "without", poller.polls,
+        (gdouble) total / (rounds * num_sources), max);
+
+    session_harness_free (h);
+  }
+}
+
+GST_END_TEST;
+
 GST_START_TEST (test_no_rbs_for_internal_senders)
 {
   SessionHarness *h = session_harness_new ();
@@ -2547,6 +2708,156 @@ GST_START_TEST (test_request_late_nack)
 
 GST_END_TEST;
 
+/* returns the number of NACKed seqnums in @buf, 0 if it holds no NACK */
+static guint
+rtcp_buffer_count_nacked_seqnums (GstBuffer * buf)
+{
+  GstRTCPBuffer rtcp = GST_RTCP_BUFFER_INIT;
+  GstRTCPPacket rtcp_packet;
+  gboolean more;
+  guint n = 0;
+
+  fail_unless (gst_rtcp_buffer_validate (buf));
+  gst_rtcp_buffer_map (buf, GST_MAP_READ, &rtcp);
+  for (more = gst_rtcp_buffer_get_first_packet (&rtcp, &rtcp_packet); more;
+      more = gst_rtcp_packet_move_to_next (&rtcp_packet)) {
+    guint8 *fci_data;
+    guint i, fci_length;
+
+    if (gst_rtcp_packet_get_type (&rtcp_packet) != GST_RTCP_TYPE_RTPFB ||
+        gst_rtcp_packet_fb_get_type (&rtcp_packet) != GST_RTCP_RTPFB_TYPE_NACK)
+      continue;
+
+    fci_data = gst_rtcp_packet_fb_get_fci (&rtcp_packet);
+    fci_length = gst_rtcp_packet_fb_get_fci_length (&rtcp_packet);
+    for (i = 0; i < fci_length; i++) {
+      guint16 blp = GST_READ_UINT16_BE (fci_data + i * 4 + 2);
+
+      n += 1 + g_bit_count (blp);
+    }
+  }
+  gst_rtcp_buffer_unmap (&rtcp);
+
+  return n;
+}
+
+GST_START_TEST (test_request_nack_coalescing)
+{
+  SessionHarness *h = session_harness_new ();
+  GstClockTime start, window = 20 * GST_MSECOND;
+  GstClockID pending;
+  GstBuffer *buf;
+  GstRTCPBuffer rtcp = GST_RTCP_BUFFER_INIT;
+  GstRTCPPacket rtcp_packet;
+  guint8 *fci_data;
+
+  g_object_set (h->internal_session, "internal-ssrc", 0xDEADBEEF,
+      "nack-coalescing-window", window, NULL);
+
+  /* Receive a RTP buffer from the wire */
+  fail_unless_equals_int (GST_FLOW_OK,
+      session_harness_recv_rtp (h, generate_test_buffer (0, 0x12345678)));
+
+  /* Wait for first regular RTCP to be sent so that we are clear to send early RTCP */
+  session_harness_produce_rtcp (h, 1);
+  gst_buffer_unref (session_harness_pull_rtcp (h));
+
+  /* a burst of losses, all with a 100ms deadline */
+  start = gst_clock_get_time (GST_CLOCK_CAST (h->testclock));
+  session_harness_rtp_retransmission_request (h, 0x12345678, 1234, 0, 100, 0);
+  session_harness_rtp_retransmission_request (h, 0x12345678, 1236, 0, 100, 0);
+  session_harness_rtp_retransmission_request (h, 0x12345678, 1238, 0, 100, 0);
+
+  /* the early RTCP is held back for the window and not sent right away */
+  gst_test_clock_wait_for_next_pending_id (h->testclock, &pending);
+  fail_unless_equals_uint64 (start + window, gst_clock_id_get_time (pending));
+  gst_clock_id_unref (pending);
+  fail_unless_equals_int (0, gst_harness_buffers_in_queue (h->rtcp_h));
+
+  /* then all three NACKs go out in a single early RTCP packet */
+  session_harness_crank_clock (h);
+  buf = session_harness_pull_rtcp (h);
+
+  fail_unless (gst_rtcp_buffer_validate (buf));
+  gst_rtcp_buffer_map (buf, GST_MAP_READ, &rtcp);
+  fail_unless_equals_int (3, gst_rtcp_buffer_get_packet_count (&rtcp));
+  fail_unless (gst_rtcp_buffer_get_first_packet (&rtcp, &rtcp_packet));
+  fail_unless (gst_rtcp_packet_move_to_next (&rtcp_packet));
+  fail_unless (gst_rtcp_packet_move_to_next (&rtcp_packet));
+
+  fail_unless_equals_int (GST_RTCP_TYPE_RTPFB,
+      gst_rtcp_packet_get_type (&rtcp_packet));
+  fail_unless_equals_int (GST_RTCP_RTPFB_TYPE_NACK,
+      gst_rtcp_packet_fb_get_type (&rtcp_packet));
+  fail_unless_equals_int (1, gst_rtcp_packet_fb_get_fci_length (&rtcp_packet));
+  fci_data = gst_rtcp_packet_fb_get_fci (&rtcp_packet);
+  fail_unless_equals_int (GST_READ_UINT32_BE (fci_data),
+      1234L << 16 | 1 << 1 | 1 << 3);
+
+  gst_rtcp_buffer_unmap (&rtcp);
+  gst_buffer_unref (buf);
+
+  session_harness_free (h);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_request_nack_coalescing_overhead)
+{
+  static const guint16 lost[] = { 100, 101, 103, 107, 110, 111, 115 };
+  GstClockTime windows[] = { 0, 20 * GST_MSECOND };
+  gsize bytes_per_nack[G_N_ELEMENTS (windows)];
+  GstBuffer *buf;
+  guint w, i;
+
+  for (w = 0; w < G_N_ELEMENTS (windows); w++) {
+    SessionHarness *h = session_harness_new ();
+    gsize nack_bytes = 0;
+    guint nacked = 0;
+
+    g_object_set (h->internal_session, "internal-ssrc", 0xDEADBEEF,
+        "nack-coalescing-window", windows[w], NULL);
+
+    fail_unless_equals_int (GST_FLOW_OK,
+        session_harness_recv_rtp (h, generate_test_buffer (0, 0x12345678)));
+    session_harness_produce_rtcp (h, 1);
+    gst_buffer_unref (session_harness_pull_rtcp (h));
+
+    for (i = 0; i < G_N_ELEMENTS (lost); i++) {
+      session_harness_rtp_retransmission_request (h, 0x12345678, lost[i],
+          0, 100, 0);
+
+      /* without a window each loss is reported as soon as it is detected */
+      if (windows[w] == 0 || i == G_N_ELEMENTS (lost) - 1) {
+        session_harness_produce_rtcp (h, 1);
+        while (gst_harness_buffers_in_queue (h->rtcp_h) > 0) {
+          guint n;
+
+          buf = session_harness_pull_rtcp (h);
+          n = rtcp_buffer_count_nacked_seqnums (buf);
+          if (n > 0) {
+            nacked += n;
+            nack_bytes += gst_buffer_get_size (buf);
+          }
+          gst_buffer_unref (buf);
+        }
+      }
+    }
+
+    fail_unless_equals_int (G_N_ELEMENTS (lost), nacked);
+    bytes_per_nack[w] = nack_bytes / nacked;
+    GST_INFO ("nack-coalescing-window %" GST_TIME_FORMAT ": %" G_GSIZE_FORMAT
+        " RTCP bytes for %u NACKed packets, %" G_GSIZE_FORMAT " per packet",
+        GST_TIME_ARGS (windows[w]), nack_bytes, nacked, bytes_per_nack[w]);
+
+    session_harness_free (h);
+  }
+
+  fail_unless (bytes_per_nack[1] < bytes_per_nack[0]);
+}
+
+GST_END_TEST;
+
 static gpointer
 _push_caps_events (gpointer user_data)
 {
@@ -4344,6 +4655,8 @@ rtpsession_suite (void)
   tcase_add_test (tc_chain, test_on_sending_nacks);
   tcase_add_test (tc_chain, test_disable_probation);
   tcase_add_test (tc_chain, test_request_late_nack);
+  tcase_add_test (tc_chain, test_request_nack_coalescing);
+  tcase_add_test (tc_chain, test_request_nack_coalescing_overhead);
   tcase_add_test (tc_chain, test_clear_pt_map_stress);
   tcase_add_test (tc_chain, test_packet_rate);
   tcase_add_test (tc_chain, test_stepped_packet_rate);
@@ -4383,6 +4696,15 @@ rtpsession_suite (void)
   tcase_add_test (tc_chain, test_twcc_feedback_count_wrap);
   tcase_add_test (tc_chain, test_twcc_feedback_old_seqnum);
 
+  /* benchmarks only log their timings, run them with GST_CHECK_PERF=1 */
+  if (g_getenv ("GST_CHECK_PERF")) {
+    TCase *tc_perf = tcase_create ("perf");
+
+    suite_add_tcase (s, tc_perf);
+    tcase_add_test (tc_perf, test_many_idle_sources_rtcp_perf);
+    tcase_add_test (tc_perf, test_stats_polling_perf);
+  }
+
   return s;
 }
 
@@ -453,6 +453,204 @@ GST_START_TEST (test_rtp_and_rtcp_arrives_simultaneously)
 
 GST_END_TEST;
 
+typedef struct
+{
+  GstHarness *rtp_h;
+  GstHarness *rtcp_h;
+  GMutex lock;
+  GSList *sinkpads;
+  gint received;
+  guint n_ssrcs;
+} ConcurrentCtx;
+
+static GstFlowReturn
+_concurrent_sink_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
+{
+  ConcurrentCtx *ctx = g_object_get_data (G_OBJECT (pad), "ctx");
+
+  g_atomic_int_inc (&ctx->received);
+  gst_buffer_unref (buf);
+
+  return GST_FLOW_OK;
+}
+
+static void
+_concurrent_link (ConcurrentCtx * ctx, GstPad * srcpad)
+{
+  GstPad *sinkpad = gst_pad_new ("sink", GST_PAD_SINK);
+
+  g_object_set_data (G_OBJECT (sinkpad), "ctx", ctx);
+  gst_pad_set_chain_function (sinkpad, _concurrent_sink_chain);
+  gst_pad_set_active (sinkpad, TRUE);
+  fail_unless_equals_int (gst_pad_link (srcpad, sinkpad), GST_PAD_LINK_OK);
+
+  g_mutex_lock (&ctx->lock);
+  ctx->sinkpads = g_slist_prepend (ctx->sinkpads, sinkpad);
+  g_mutex_unlock (&ctx->lock);
+}
+
+static void
+_concurrent_new_ssrc_pad_cb (GstElement * element, guint ssrc,
+    GstPad * rtp_pad, ConcurrentCtx * ctx)
+{
+  GstPad *rtcp_pad;
+  gchar *name;
+
+  _concurrent_link (ctx, rtp_pad);
+
+  name = g_strdup_printf ("rtcp_src_%u", ssrc);
+  rtcp_pad = gst_element_get_static_pad (element, name);
+  _concurrent_link (ctx, rtcp_pad);
+  gst_object_unref (rtcp_pad);
+  g_free (name);
+}
+
+static gpointer
+_concurrent_push_rtp (gpointer user_data)
+{
+  ConcurrentCtx *ctx = user_data;
+  guint i;
+
+  for (i = 0; i < ctx->n_ssrcs; i++) {
+    fail_unless_equals_int (gst_harness_push (ctx->rtp_h, create_buffer (0,
+                i)), GST_FLOW_OK);
+  }
+
+  return NULL;
+}
+
+static gpointer
+_concurrent_push_rtcp (gpointer user_data)
+{
+  ConcurrentCtx *ctx = user_data;
+  guint i;
+
+  for (i = 0; i < ctx->n_ssrcs; i++) {
+    fail_unless_equals_int (gst_harness_push (ctx->rtcp_h,
+            generate_rtcp_sr_buffer (i)), GST_FLOW_OK);
+  }
+
+  return NULL;
+}
+
+/* The RTP and RTCP streaming threads both see new SSRCs. Whichever creates
+ * the pads, the other one must only find them once they are active and
+ * linked. */
+GST_START_TEST (test_rtp_and_rtcp_new_ssrcs_concurrently)
+{
+  guint r;
+  guint repeats = 20;
+
+  if (RUNNING_ON_VALGRIND)
+    repeats = 1;
+
+  for (r = 0; r < repeats; r++) {
+    ConcurrentCtx ctx = { NULL, };
+    GThread *t0, *t1;
+
+    g_mutex_init (&ctx.lock);
+    ctx.n_ssrcs = 200;
+    ctx.rtp_h = gst_harness_new_with_padnames ("rtpssrcdemux", "sink", NULL);
+    ctx.rtcp_h =
+        gst_harness_new_with_element (ctx.rtp_h->element, "rtcp_sink", NULL);
+    g_object_set (ctx.rtp_h->element, "max-streams", ctx.n_ssrcs, NULL);
+
+    g_signal_connect (ctx.rtp_h->element,
+        "new-ssrc-pad", (GCallback) _concurrent_new_ssrc_pad_cb, &ctx);
+
+    gst_harness_set_src_caps_str (ctx.rtp_h, "application/x-rtp");
+    gst_harness_set_src_caps_str (ctx.rtcp_h, "application/x-rtcp");
+
+    t0 = g_thread_new ("push rtp", _concurrent_push_rtp, &ctx);
+    t1 = g_thread_new ("push rtcp", _concurrent_push_rtcp, &ctx);
+
+    g_thread_join (t0);
+    g_thread_join (t1);
+
+    fail_unless_equals_int (g_slist_length (ctx.sinkpads), 2 * ctx.n_ssrcs);
+    fail_unless_equals_int (g_atomic_int_get (&ctx.received),
+        2 * ctx.n_ssrcs);
+
+    gst_harness_teardown (ctx.rtp_h);
+    gst_harness_teardown (ctx.rtcp_h);
+    g_slist_free_full (ctx.sinkpads, gst_object_unref);
+    g_mutex_clear (&ctx.lock);
+  }
+}
+
+GST_END_TEST;
+
+static GstFlowReturn
+_perf_sink_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
+{
+  gst_buffer_unref (buf);
+  return GST_FLOW_OK;
+}
+
+static void
+_perf_new_ssrc_pad_cb (GstElement * element, G_GNUC_UNUSED guint ssrc,
+    GstPad * pad, GSList ** sinkpads)
+{
+  GstPad *sinkpad = gst_pad_new ("sink", GST_PAD_SINK);
+
+  gst_pad_set_chain_function (sinkpad, _perf_sink_chain);
+  gst_pad_set_active (sinkpad, TRUE);
+  fail_unless_equals_int (gst_pad_link (pad, sinkpad), GST_PAD_LINK_OK);
+  *sinkpads = g_slist_prepend (*sinkpads, sinkpad);
+}
+
+GST_START_TEST (test_rtpssrcdemux_many_ssrcs_perf)
+{
+  const guint num_ssrcs[] = { 1, 10, 100, 1000 };
+  guint packets = 100000;
+  guint i;
+
+  if (RUNNING_ON_VALGRIND)
+    packets = 100;
+
+  for (i = 0; i < G_N_ELEMENTS (num_ssrcs); i++) {
+    GstHarness *h =
+        gst_harness_new_with_padnames ("rtpssrcdemux", "sink", NULL);
+    GSList *sinkpads = NULL;
+    GPtrArray *bufs = g_ptr_array_new_with_free_func (
+        (GDestroyNotify) gst_buffer_unref);
+    GTimer *timer;
+    gdouble elapsed;
+    guint n;
+
+    g_signal_connect (h->element, "new-ssrc-pad",
+        (GCallback) _perf_new_ssrc_pad_cb, &sinkpads);
+    gst_harness_set_src_caps_str (h, "application/x-rtp");
+    gst_harness_play (h);
+
+    /* create all the pads up front so only the lookup path is measured */
+    for (n = 0; n < num_ssrcs[i]; n++) {
+      g_ptr_array_add (bufs, create_buffer (0, n));
+      fail_unless_equals_int (GST_FLOW_OK,
+          gst_harness_push (h, gst_buffer_ref (g_ptr_array_index (bufs, n))));
+    }
+    fail_unless_equals_int (g_slist_length (sinkpads), num_ssrcs[i]);
+
+    timer = g_timer_new ();
+    for (n = 0; n < packets; n++) {
+      GstBuffer *buf = g_ptr_array_index (bufs, n % num_ssrcs[i]);
+      fail_unless_equals_int (GST_FLOW_OK,
+          gst_harness_push (h, gst_buffer_ref (buf)));
+    }
+    elapsed = g_timer_elapsed (timer, NULL);
+    g_timer_destroy (timer);
+
+    GST_INFO ("%u SSRCs: %u packets in %.3f s (%.0f packets/s)",
+        num_ssrcs[i], packets, elapsed, packets / MAX (elapsed, 1e-9));
+
+    gst_harness_teardown (h);
+    g_slist_free_full (sinkpads, gst_object_unref);
+    g_ptr_array_unref (bufs);
+  }
+}
+
+GST_END_TEST;
+
 static Suite *
 rtpssrcdemux_suite (void)
 {
@@ -467,6 +665,15 @@ rtpssrcdemux_suite (void)
   tcase_add_test (tc_chain, test_rtpssrcdemux_invalid_rtp);
   tcase_add_test (tc_chain, test_rtpssrcdemux_invalid_rtcp);
   tcase_add_test (tc_chain, test_rtp_and_rtcp_arrives_simultaneously);
+  tcase_add_test (tc_chain, test_rtp_and_rtcp_new_ssrcs_concurrently);
+
+  /* benchmarks only log their timings, run them with GST_CHECK_PERF=1 */
+  if (g_getenv ("GST_CHECK_PERF")) {
+    TCase *tc_perf = tcase_create ("perf");
+
+    suite_add_tcase (s, tc_perf);
+    tcase_add_test (tc_perf, test_rtpssrcdemux_many_ssrcs_perf);
+  }
 
   return s;
 }
@@ -0,0 +1,219 @@
+/* GStreamer RTP raw video unit test
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/check/check.h>
+#include <gst/video/video.h>
+
+static const gchar *vraw_formats[] = {
+  "RGB", "RGBA", "BGR", "BGRA", "AYUV", "UYVY", "I420", "Y41B", "UYVP"
+};
+
+static GstBuffer *
+make_frame (const GstVideoInfo * info, guint seed)
+{
+  GstBuffer *buffer;
+  GstVideoFrame frame;
+  guint plane, x, y;
+
+  buffer = gst_buffer_new_allocate (NULL, GST_VIDEO_INFO_SIZE (info), NULL);
+  fail_unless (gst_video_frame_map (&frame, info, buffer, GST_MAP_WRITE));
+
+  for (plane = 0; plane < GST_VIDEO_FRAME_N_PLANES (&frame); plane++) {
+    guint8 *data = GST_VIDEO_FRAME_PLANE_DATA (&frame, plane);
+    guint stride = GST_VIDEO_FRAME_PLANE_STRIDE (&frame, plane);
+    guint height = GST_VIDEO_FRAME_COMP_HEIGHT (&frame, plane);
+
+    for (y = 0; y < height; y++) {
+      for (x = 0; x < stride; x++)
+        data[y * stride + x] = (x * 7 + y * 13 + plane + seed) & 0xff;
+
+      /* alpha is not transmitted, the depayloader sets it to 0 */
+      if (GST_VIDEO_FRAME_FORMAT (&frame) == GST_VIDEO_FORMAT_AYUV) {
+        for (x = 0; x < GST_VIDEO_FRAME_WIDTH (&frame); x++)
+          data[y * stride + x * 4] = 0;
+      }
+    }
+  }
+
+  gst_video_frame_unmap (&frame);
+
+  return buffer;
+}
+
+/* bytes of a line that are transmitted, without the stride padding */
+static guint
+line_size (const GstVideoInfo * info, guint plane)
+{
+  switch (GST_VIDEO_INFO_FORMAT (info)) {
+    case GST_VIDEO_FORMAT_I420:
+    case GST_VIDEO_FORMAT_Y41B:
+      return GST_VIDEO_INFO_COMP_WIDTH (info, plane);
+    case GST_VIDEO_FORMAT_UYVP:
+      return GST_VIDEO_INFO_WIDTH (info) * 5 / 2;
+    default:
+      return GST_VIDEO_INFO_WIDTH (info) * GST_VIDEO_INFO_COMP_PSTRIDE (info,
+          0);
+  }
+}
+
+static void
+check_frames_equal (const GstVideoInfo * info, GstBuffer * in, GstBuffer * out)
+{
+  GstVideoFrame inframe, outframe;
+  guint plane, y;
+
+  fail_unless (gst_video_frame_map (&inframe, info, in, GST_MAP_READ));
+  fail_unless (gst_video_frame_map (&outframe, info, out, GST_MAP_READ));
+
+  for (plane = 0; plane < GST_VIDEO_FRAME_N_PLANES (&inframe); plane++) {
+    guint8 *indata = GST_VIDEO_FRAME_PLANE_DATA (&inframe, plane);
+    guint8 *outdata = GST_VIDEO_FRAME_PLANE_DATA (&outframe, plane);
+    guint instride = GST_VIDEO_FRAME_PLANE_STRIDE (&inframe, plane);
+    guint outstride = GST_VIDEO_FRAME_PLANE_STRIDE (&outframe, plane);
+
+    for (y = 0; y < GST_VIDEO_FRAME_COMP_HEIGHT (&inframe, plane); y++) {
+      if (memcmp (indata + y * instride, outdata + y * outstride,
+              line_size (info, plane)) != 0)
+        fail ("%s: plane %u line %u differs",
+            gst_video_format_to_string (GST_VIDEO_INFO_FORMAT (info)), plane,
+            y);
+    }
+  }
+
+  gst_video_frame_unmap (&inframe);
+  gst_video_frame_unmap (&outframe);
+}
+
+static GstCaps *
+make_caps (const gchar * format, guint width, guint height)
+{
+  return gst_caps_new_simple ("video/x-raw",
+      "format", G_TYPE_STRING, format,
+      "width", G_TYPE_INT, width, "height", G_TYPE_INT, height,
+      "framerate", GST_TYPE_FRACTION, 30, 1, NULL);
+}
+
+GST_START_TEST (test_rtpvraw_roundtrip)
+{
+  guint i, f;
+
+  for (i = 0; i < G_N_ELEMENTS (vraw_formats); i++) {
+    GstHarness *h = gst_harness_new_parse ("rtpvrawpay ! rtpvrawdepay");
+    GstCaps *caps = make_caps (vraw_formats[i], 320, 240);
+    GstVideoInfo info;
+
+    fail_unless (gst_video_info_from_caps (&info, caps));
+    gst_harness_set_src_caps (h, caps);
+
+    for (f = 0; f < 2; f++) {
+      GstBuffer *in, *out;
+
+      in = make_frame (&info, f);
+      GST_BUFFER_PTS (in) = f * GST_SECOND / 30;
+      GST_BUFFER_DURATION (in) = GST_SECOND / 30;
+      fail_unless_equals_int (gst_harness_push (h, gst_buffer_ref (in)),
+          GST_FLOW_OK);
+
+      out = gst_harness_pull (h);
+      check_frames_equal (&info, in, out);
+      gst_buffer_unref (in);
+      gst_buffer_unref (out);
+    }
+
+    gst_harness_teardown (h);
+  }
+}
+
+GST_END_TEST;
+
+#define PERF_FRAMES 10
+
+GST_START_TEST (test_rtpvraw_perf)
+{
+  guint i, f;
+
+  for (i = 0; i < G_N_ELEMENTS (vraw_formats); i++) {
+    GstHarness *pay = gst_harness_new ("rtpvrawpay");
+    GstHarness *depay = gst_harness_new ("rtpvrawdepay");
+    GstCaps *caps = make_caps (vraw_formats[i], 1920, 1080);
+    GPtrArray *packets = g_ptr_array_new ();
+    GstClockTime start, pay_time, depay_time;
+    GstVideoInfo info;
+    GstBuffer *frame, *packet;
+    gdouble bits;
+
+    fail_unless (gst_video_info_from_caps (&info, caps));
+    gst_harness_set_src_caps (pay, caps);
+    frame = make_frame (&info, 0);
+
+    start = gst_util_get_timestamp ();
+    for (f = 0; f < PERF_FRAMES; f++) {
+      GstBuffer *buffer = gst_buffer_copy (frame);
+
+      GST_BUFFER_PTS (buffer) = f * GST_SECOND / 30;
+      fail_unless_equals_int (gst_harness_push (pay, buffer), GST_FLOW_OK);
+    }
+    pay_time = gst_util_get_timestamp () - start;
+
+    while ((packet = gst_harness_try_pull (pay)))
+      g_ptr_array_add (packets, packet);
+
+    gst_harness_set_src_caps (depay,
+        gst_pad_get_current_caps (pay->sinkpad));
+    gst_harness_set_drop_buffers (depay, TRUE);
+
+    start = gst_util_get_timestamp ();
+    for (f = 0; f < packets->len; f++)
+      gst_harness_push (depay, g_ptr_array_index (packets, f));
+    depay_time = gst_util_get_timestamp () - start;
+
+    bits = (gdouble) GST_VIDEO_INFO_SIZE (&info) * 8 * PERF_FRAMES;
+    GST_INFO ("%s 1080p: %u packets, pay %.2f Gbit/s, depay %.2f Gbit/s",
+        vraw_formats[i], packets->len, bits / pay_time, bits / depay_time);
+
+    g_ptr_array_unref (packets);
+    gst_buffer_unref (frame);
+    gst_harness_teardown (pay);
+    gst_harness_teardown (depay);
+  }
+}
+
+GST_END_TEST;
+
+static Suite *
+rtpvraw_suite (void)
+{
+  Suite *s = suite_create ("rtpvraw");
+  TCase *tc_chain;
+
+  tc_chain = tcase_create ("general");
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_rtpvraw_roundtrip);
+
+  /* benchmarks only log their timings, run them with GST_CHECK_PERF=1 */
+  if (g_getenv ("GST_CHECK_PERF")) {
+    TCase *tc_perf = tcase_create ("perf");
+
+    suite_add_tcase (s, tc_perf);
+    tcase_add_test (tc_perf, test_rtpvraw_perf);
+  }
+
+  return s;
+}
+
+GST_CHECK_MAIN (rtpvraw);
@@ -0,0 +1,722 @@
+/* GStreamer unit tests for rtspsrc
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <gio/gio.h>
+#include <gst/check/gstcheck.h>
+#include <gst/rtp/gstrtpbuffer.h>
+
+/* A minimal RTSP server that answers the requests of rtspsrc and streams
+ * MP2T RTP packets interleaved in the RTSP connection after PLAY. Requests
+ * are read on one thread and the responses and the stream are written on
+ * another one, so that pipelined requests are answered together. */
+typedef struct
+{
+  GSocketListener *listener;
+  guint16 port;
+  GThread *thread;
+  GAsyncQueue *responses;
+  GOutputStream *out;
+
+  guint n_packets;
+  guint payload_size;
+  /* number of streams in the SDP, the packets are sent on the first one */
+  guint n_streams;
+  /* write the stream in slices of this size, 0 for large writes */
+  guint write_size;
+  /* send a server request and RTCP after this many packets, 0 for never */
+  guint request_interval;
+  /* time between receiving a request and sending its response */
+  GTimeSpan response_delay;
+
+  /* interleaved channel of the first stream */
+  guint channel;
+  guint n_setups;
+  /* SETUP requests that wait for their response */
+  gint pending_setups;
+  gint max_pending_setups;
+
+  /* keep-alive requests received after PLAY */
+  gboolean playing;
+  gint n_keep_alives;
+} TestServer;
+
+typedef struct
+{
+  gint64 due;
+  gchar *data;
+  gboolean setup;
+  gboolean play;
+} ServerResponse;
+
+#define TEST_SSRC 0x12345678
+
+static void
+server_write (GOutputStream * out, const guint8 * data, gsize size,
+    guint write_size)
+{
+  gsize offset, len;
+
+  if (write_size == 0)
+    write_size = size;
+
+  for (offset = 0; offset < size; offset += len) {
+    len = MIN (write_size, size - offset);
+    if (!g_output_stream_write_all (out, data + offset, len, NULL, NULL,
+            NULL))
+      return;
+  }
+}
+
+static void
+server_send_rtcp (TestServer * server, GOutputStream * out)
+{
+  guint8 sr[4 + 28] = { '$', 1, 0, 28, 0x80, 200, 0, 6 };
+
+  sr[1] = server->channel + 1;
+  GST_WRITE_UINT32_BE (sr + 8, TEST_SSRC);
+  server_write (out, sr, sizeof (sr), 0);
+}
+
+static void
+server_send_request (TestServer * server, GOutputStream * out, guint cseq)
+{
+  gchar *req;
+
+  req = g_strdup_printf ("SET_PARAMETER rtsp://127.0.0.1:%u/test RTSP/1.0\r\n"
+      "CSeq: %u\r\nSession: 12345678\r\nContent-Length: 0\r\n\r\n",
+      server->port, cseq);
+  server_write (out, (guint8 *) req, strlen (req), 0);
+  g_free (req);
+}
+
+#define PACKETS_PER_WRITE 64
+
+static void
+server_stream (TestServer * server, GOutputStream * out)
+{
+  guint frame_size = 4 + 12 + server->payload_size;
+  guint8 *data = g_malloc0 (frame_size * PACKETS_PER_WRITE);
+  guint i, n, cseq = 1000;
+
+  for (i = 0; i < server->n_packets; i += n) {
+    guint j;
+
+    n = MIN (PACKETS_PER_WRITE, server->n_packets - i);
+    if (server->request_interval)
+      n = MIN (n, server->request_interval - i % server->request_interval);
+
+    for (j = 0; j < n; j++) {
+      guint8 *frame = data + j * frame_size;
+      guint seq = i + j;
+
+      frame[0] = '$';
+      frame[1] = server->channel;
+      GST_WRITE_UINT16_BE (frame + 2, frame_size - 4);
+      frame[4] = 0x80;
+      frame[5] = 33;
+      GST_WRITE_UINT16_BE (frame + 6, seq);
+      GST_WRITE_UINT32_BE (frame + 8, seq * 90);
+      GST_WRITE_UINT32_BE (frame + 12, TEST_SSRC);
+      memset (frame + 16, seq & 0xff, server->payload_size);
+    }
+    server_write (out, data, n * frame_size, server->write_size);
+
+    if (server->request_interval && (i + n) % server->request_interval == 0) {
+      server_send_request (server, out, cseq++);
+      server_send_rtcp (server, out);
+    }
+  }
+
+  g_free (data);
+}
+
+static gpointer
+server_writer_thread (gpointer user_data)
+{
+  TestServer *server = user_data;
+  ServerResponse *response;
+
+  while ((response = g_async_queue_pop (server->responses))->data) {
+    gint64 delay = response->due - g_get_monotonic_time ();
+
+    if (delay > 0)
+      g_usleep (delay);
+
+    server_write (server->out, (guint8 *) response->data,
+        strlen (response->data), 0);
+    if (response->setup)
+      g_atomic_int_add (&server->pending_setups, -1);
+    if (response->play)
+      server_stream (server, server->out);
+
+    g_free (response->data);
+    g_free (response);
+  }
+  g_free (response);
+
+  return NULL;
+}
+
+static gchar *
+server_describe (TestServer * server, guint cseq)
+{
+  GString *sdp = g_string_new ("v=0\r\n"
+      "o=- 0 0 IN IP4 127.0.0.1\r\n"
+      "s=test\r\n" "c=IN IP4 0.0.0.0\r\n" "t=0 0\r\n");
+  gchar *response;
+  guint i;
+
+  for (i = 0; i < MAX (server->n_streams, 1); i++)
+    g_string_append_printf (sdp, "m=video 0 RTP/AVP 33\r\n"
+        "a=control:stream=%u\r\n", i);
+
+  response = g_strdup_printf ("RTSP/1.0 200 OK\r\nCSeq: %u\r\n"
+      "Content-Base: rtsp://127.0.0.1:%u/test/\r\n"
+      "Content-Type: application/sdp\r\nContent-Length: %u\r\n\r\n%s",
+      cseq, server->port, (guint) sdp->len, sdp->str);
+  g_string_free (sdp, TRUE);
+
+  return response;
+}
+
+static gpointer
+server_thread (gpointer user_data)
+{
+  TestServer *server = user_data;
+  GSocketConnection *conn;
+  GDataInputStream *in;
+  GThread *writer;
+
+  conn = g_socket_listener_accept (server->listener, NULL, NULL, NULL);
+  if (conn == NULL)
+    return NULL;
+
+  in = g_data_input_stream_new (g_io_stream_get_input_stream (G_IO_STREAM
+          (conn)));
+  server->out = g_io_stream_get_output_stream (G_IO_STREAM (conn));
+  server->responses = g_async_queue_new ();
+  writer = g_thread_new ("rtsp-server-writer", server_writer_thread, server);
+
+  while (TRUE) {
+    gchar *line, *method = NULL;
+    guint cseq = 0, content_length = 0;
+    guint rtp_channel = 0, rtcp_channel = 1;
+    ServerResponse *response;
+    gint pending;
+
+    /* read a request, responses to our own requests are skipped */
+    while ((line = g_data_input_stream_read_line (in, NULL, NULL, NULL))) {
+      const gchar *interleaved;
+
+      g_strchomp (line);
+      if (*line == '\0') {
+        g_free (line);
+        break;
+      }
+      if (method == NULL)
+        method = g_strdup (line);
+      else if (g_ascii_strncasecmp (line, "CSeq:", 5) == 0)
+        cseq = atoi (line + 5);
+      else if (g_ascii_strncasecmp (line, "Content-Length:", 15) == 0)
+        content_length = atoi (line + 15);
+      else if (g_ascii_strncasecmp (line, "Transport:", 10) == 0 &&
+          (interleaved = strstr (line, "interleaved=")))
+        sscanf (interleaved, "interleaved=%u-%u", &rtp_channel, &rtcp_channel);
+      g_free (line);
+    }
+    if (method == NULL)
+      break;
+
+    if (content_length > 0)
+      g_input_stream_skip (G_INPUT_STREAM (in), content_length, NULL, NULL);
+
+    if (g_str_has_prefix (method, "RTSP/")) {
+      g_free (method);
+      continue;
+    }
+
+    if (server->playing && (g_str_has_prefix (method, "GET_PARAMETER") ||
+            g_str_has_prefix (method, "OPTIONS")))
+      g_atomic_int_inc (&server->n_keep_alives);
+
+    response = g_new0 (ServerResponse, 1);
+    response->due = g_get_monotonic_time () + server->response_delay;
+
+    if (g_str_has_prefix (method, "DESCRIBE")) {
+      response->data = server_describe (server, cseq);
+    } else if (g_str_has_prefix (method, "SETUP")) {
+      response->data = g_strdup_printf ("RTSP/1.0 200 OK\r\nCSeq: %u\r\n"
+          "Transport: RTP/AVP/TCP;unicast;interleaved=%u-%u\r\n"
+          "Session: 12345678\r\n\r\n", cseq, rtp_channel, rtcp_channel);
+      if (server->n_setups++ == 0)
+        server->channel = rtp_channel;
+      response->setup = TRUE;
+      pending = g_atomic_int_add (&server->pending_setups, 1) + 1;
+      server->max_pending_setups = MAX (server->max_pending_setups, pending);
+    } else if (g_str_has_prefix (method, "PLAY")) {
+      response->data = g_strdup_printf ("RTSP/1.0 200 OK\r\nCSeq: %u\r\n"
+          "Session: 12345678\r\nRange: npt=0-\r\n\r\n", cseq);
+      response->play = TRUE;
+      server->playing = TRUE;
+    } else if (g_str_has_prefix (method, "OPTIONS")) {
+      response->data = g_strdup_printf ("RTSP/1.0 200 OK\r\nCSeq: %u\r\n"
+          "Public: OPTIONS, DESCRIBE, SETUP, PLAY, TEARDOWN, GET_PARAMETER\r\n"
+          "\r\n", cseq);
+    } else {
+      response->data = g_strdup_printf ("RTSP/1.0 200 OK\r\nCSeq: %u\r\n"
+          "Session: 12345678\r\n\r\n", cseq);
+    }
+    g_async_queue_push (server->responses, response);
+
+    g_free (method);
+  }
+
+  /* a response without data stops the writer */
+  g_async_queue_push (server->responses, g_new0 (ServerResponse, 1));
+  g_thread_join (writer);
+  g_async_queue_unref (server->responses);
+
+  g_object_unref (in);
+  g_object_unref (conn);
+
+  return NULL;
+}
+
+static TestServer *
+test_server_new (guint n_packets, guint payload_size)
+{
+  TestServer *server = g_new0 (TestServer, 1);
+  GInetAddress *inet;
+  GSocketAddress *addr, *effective = NULL;
+
+  server->n_packets = n_packets;
+  server->payload_size = payload_size;
+
+  server->listener = g_socket_listener_new ();
+  inet = g_inet_address_new_loopback (G_SOCKET_FAMILY_IPV4);
+  addr = g_inet_socket_address_new (inet, 0);
+  fail_unless (g_socket_listener_add_address (server->listener, addr,
+          G_SOCKET_TYPE_STREAM, G_SOCKET_PROTOCOL_TCP, NULL, &effective,
+          NULL));
+  server->port =
+      g_inet_socket_address_get_port (G_INET_SOCKET_ADDRESS (effective));
+
+  g_object_unref (effective);
+  g_object_unref (addr);
+  g_object_unref (inet);
+
+  return server;
+}
+
+static void
+test_server_start (TestServer * server)
+{
+  server->thread = g_thread_new ("rtsp-server", server_thread, server);
+}
+
+static void
+test_server_free (TestServer * server)
+{
+  g_socket_listener_close (server->listener);
+  g_thread_join (server->thread);
+  g_object_unref (server->listener);
+  g_free (server);
+}
+
+typedef struct
+{
+  GstElement *pipeline;
+
+  GMutex lock;
+  GCond cond;
+  guint n_buffers;
+  guint expected;
+  gint last_seq;
+  gboolean in_order;
+  GstClockTime start, first, last;
+} TestClient;
+
+static gboolean
+count_buffer (GstBuffer ** buffer, guint idx, gpointer user_data)
+{
+  TestClient *client = user_data;
+  GstRTPBuffer rtp = GST_RTP_BUFFER_INIT;
+  guint seq;
+
+  fail_unless (gst_rtp_buffer_map (*buffer, GST_MAP_READ, &rtp));
+  seq = gst_rtp_buffer_get_seq (&rtp);
+  gst_rtp_buffer_unmap (&rtp);
+
+  if (client->last_seq != -1 && seq != ((client->last_seq + 1) & 0xffff))
+    client->in_order = FALSE;
+  client->last_seq = seq;
+  client->n_buffers++;
+
+  return TRUE;
+}
+
+static GstPadProbeReturn
+count_probe (GstPad * pad, GstPadProbeInfo * info, gpointer user_data)
+{
+  TestClient *client = user_data;
+
+  g_mutex_lock (&client->lock);
+  if (client->n_buffers == 0)
+    client->first = gst_util_get_timestamp ();
+
+  if (GST_PAD_PROBE_INFO_TYPE (info) & GST_PAD_PROBE_TYPE_BUFFER) {
+    GstBuffer *buffer = GST_PAD_PROBE_INFO_BUFFER (info);
+
+    count_buffer (&buffer, 0, client);
+  } else {
+    gst_buffer_list_foreach (GST_PAD_PROBE_INFO_BUFFER_LIST (info),
+        count_buffer, client);
+  }
+
+  if (client->n_buffers >= client->expected) {
+    client->last = gst_util_get_timestamp ();
+    g_cond_signal (&client->cond);
+  }
+  g_mutex_unlock (&client->lock);
+
+  return GST_PAD_PROBE_OK;
+}
+
+static void
+pad_added (GstElement * src, GstPad * pad, GstElement * sink)
+{
+  GstPad *sinkpad = gst_element_get_static_pad (sink, "sink");
+
+  fail_unless_equals_int (gst_pad_link (pad, sinkpad), GST_PAD_LINK_OK);
+  gst_object_unref (sinkpad);
+}
+
+/* Start playing the stream of @server with rtspsrc. @tcp_timeout is only
+ * set when it is not 0. */
+static TestClient *
+test_client_new (TestServer * server, guint read_size, guint io_threads,
+    gboolean pipelined_setup, guint64 tcp_timeout)
+{
+  TestClient *client = g_new0 (TestClient, 1);
+  GstElement *src, *sink;
+  GstPad *sinkpad;
+  gchar *location;
+
+  g_mutex_init (&client->lock);
+  g_cond_init (&client->cond);
+  client->expected = server->n_packets;
+  client->last_seq = -1;
+  client->in_order = TRUE;
+
+  client->pipeline = gst_pipeline_new (NULL);
+  src = gst_element_factory_make ("rtspsrc", NULL);
+  sink = gst_element_factory_make ("fakesink", NULL);
+  fail_unless (src != NULL && sink != NULL);
+
+  location = g_strdup_printf ("rtsp://127.0.0.1:%u/test", server->port);
+  g_object_set (src, "location", location, "protocols", 4 /* TCP */ ,
+      "latency", 0, "interleaved-read-size", read_size,
+      "shared-io-threads", io_threads, "pipelined-setup", pipelined_setup,
+      NULL);
+  if (tcp_timeout > 0)
+    g_object_set (src, "tcp-timeout", tcp_timeout, NULL);
+  g_object_set (sink, "sync", FALSE, NULL);
+  g_free (location);
+
+  gst_bin_add_many (GST_BIN (client->pipeline), src, sink, NULL);
+  g_signal_connect (src, "pad-added", G_CALLBACK (pad_added), sink);
+
+  sinkpad = gst_element_get_static_pad (sink, "sink");
+  gst_pad_add_probe (sinkpad,
+      GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_BUFFER_LIST,
+      count_probe, client, NULL);
+  gst_object_unref (sinkpad);
+
+  test_server_start (server);
+  client->start = gst_util_get_timestamp ();
+  gst_element_set_state (client->pipeline, GST_STATE_PLAYING);
+
+  return client;
+}
+
+/* Wait until all packets have arrived in order */
+static void
+test_client_wait (TestClient * client, gint64 deadline)
+{
+  g_mutex_lock (&client->lock);
+  while (client->n_buffers < client->expected) {
+    if (!g_cond_wait_until (&client->cond, &client->lock, deadline))
+      break;
+  }
+  g_mutex_unlock (&client->lock);
+
+  fail_unless_equals_int (client->n_buffers, client->expected);
+  fail_unless (client->in_order);
+}
+
+static void
+test_client_free (TestClient * client)
+{
+  gst_element_set_state (client->pipeline, GST_STATE_NULL);
+  gst_object_unref (client->pipeline);
+  g_mutex_clear (&client->lock);
+  g_cond_clear (&client->cond);
+  g_free (client);
+}
+
+/* Play the stream of @server with rtspsrc and wait until all packets have
+ * arrived. Returns the time it took to receive them. */
+static GstClockTime
+receive_stream (TestServer * server, guint read_size, guint io_threads)
+{
+  TestClient *client;
+  GstClockTime elapsed;
+
+  client = test_client_new (server, read_size, io_threads, FALSE, 0);
+  test_client_wait (client,
+      g_get_monotonic_time () + 15 * G_TIME_SPAN_SECOND);
+  elapsed = client->last - client->first;
+  test_client_free (client);
+
+  return elapsed;
+}
+
+GST_START_TEST (test_rtspsrc_interleaved)
+{
+  guint read_sizes[] = { 0, 65536, 4096 };
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (read_sizes); i++) {
+    TestServer *server = test_server_new (2000, 1000);
+
+    /* frames are split over writes and mixed with RTSP messages and RTCP */
+    server->write_size = 777;
+    server->request_interval = 300;
+
+    receive_stream (server, read_sizes[i], 0);
+    test_server_free (server);
+  }
+}
+
+GST_END_TEST;
+
+#define PERF_PACKETS 100000
+#define PERF_PAYLOAD_SIZE 1200
+#define DEFAULT_READ_SIZE 65536
+
+GST_START_TEST (test_rtspsrc_interleaved_perf)
+{
+  guint read_sizes[] = { 0, DEFAULT_READ_SIZE };
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (read_sizes); i++) {
+    TestServer *server = test_server_new (PERF_PACKETS, PERF_PAYLOAD_SIZE);
+    GstClockTime elapsed;
+
+    elapsed = receive_stream (server, read_sizes[i], 0);
+    test_server_free (server);
+
+    GST_INFO ("interleaved-read-size %u: %u packets in %" GST_TIME_FORMAT
+        " (%.0f packets/s)", read_sizes[i], PERF_PACKETS,
+        GST_TIME_ARGS (elapsed),
+        (gdouble) PERF_PACKETS * GST_SECOND / MAX (elapsed, 1));
+  }
+}
+
+GST_END_TEST;
+
+#define N_CLIENTS 16
+
+/* Receive a stream from each of @servers, returns the time between the
+ * first packet and the last one of all streams */
+static GstClockTime
+receive_streams (TestServer ** servers, guint n_servers, guint read_size,
+    guint io_threads)
+{
+  TestClient **clients = g_new0 (TestClient *, n_servers);
+  GstClockTime first = GST_CLOCK_TIME_NONE, last = 0;
+  gint64 deadline;
+  guint i;
+
+  for (i = 0; i < n_servers; i++)
+    clients[i] = test_client_new (servers[i], read_size, io_threads, FALSE,
+        0);
+
+  deadline = g_get_monotonic_time () + 15 * G_TIME_SPAN_SECOND;
+  for (i = 0; i < n_servers; i++) {
+    test_client_wait (clients[i], deadline);
+    first = MIN (first, clients[i]->first);
+    last = MAX (last, clients[i]->last);
+  }
+
+  for (i = 0; i < n_servers; i++)
+    test_client_free (clients[i]);
+  g_free (clients);
+
+  return last - first;
+}
+
+GST_START_TEST (test_rtspsrc_shared_io)
+{
+  guint read_sizes[] = { 0, 65536 };
+  TestServer *servers[N_CLIENTS];
+  guint i, j;
+
+  for (i = 0; i < G_N_ELEMENTS (read_sizes); i++) {
+    for (j = 0; j < N_CLIENTS; j++) {
+      servers[j] = test_server_new (2000, 1000);
+      /* frames are split over reads and mixed with RTSP messages and RTCP */
+      servers[j]->write_size = 777;
+      servers[j]->request_interval = 300;
+    }
+
+    receive_streams (servers, N_CLIENTS, read_sizes[i], 2);
+
+    for (j = 0; j < N_CLIENTS; j++)
+      test_server_free (servers[j]);
+  }
+}
+
+GST_END_TEST;
+
+#define KEEP_ALIVE_TIMEOUT (100 * G_TIME_SPAN_MILLISECOND)
+
+/* Once the stream is received the connection is idle, the keep-alives are
+ * sent by the task and the connection is then handed back to the I/O
+ * thread, which times out again */
+GST_START_TEST (test_rtspsrc_shared_io_keep_alive)
+{
+  TestServer *server = test_server_new (100, 188);
+  TestClient *client;
+  gint64 deadline;
+
+  client = test_client_new (server, DEFAULT_READ_SIZE, 1, FALSE,
+      KEEP_ALIVE_TIMEOUT);
+  deadline = g_get_monotonic_time () + 15 * G_TIME_SPAN_SECOND;
+  test_client_wait (client, deadline);
+
+  while (g_atomic_int_get (&server->n_keep_alives) < 2 &&
+      g_get_monotonic_time () < deadline)
+    g_usleep (10 * G_TIME_SPAN_MILLISECOND);
+  fail_unless (g_atomic_int_get (&server->n_keep_alives) >= 2);
+
+  test_client_free (client);
+  test_server_free (server);
+}
+
+GST_END_TEST;
+
+#define PERF_STREAMS 32
+#define PERF_STREAM_PACKETS 3000
+
+GST_START_TEST (test_rtspsrc_shared_io_perf)
+{
+  guint io_threads[] = { 0, 1, 4 };
+  TestServer *servers[PERF_STREAMS];
+  guint i, j;
+
+  for (i = 0; i < G_N_ELEMENTS (io_threads); i++) {
+    GstClockTime elapsed;
+
+    for (j = 0; j < PERF_STREAMS; j++)
+      servers[j] = test_server_new (PERF_STREAM_PACKETS, PERF_PAYLOAD_SIZE);
+
+    elapsed = receive_streams (servers, PERF_STREAMS,
+        DEFAULT_READ_SIZE, io_threads[i]);
+
+    for (j = 0; j < PERF_STREAMS; j++)
+      test_server_free (servers[j]);
+
+    GST_INFO ("shared-io-threads %u: %u streams of %u packets in %"
+        GST_TIME_FORMAT " (%.0f packets/s)", io_threads[i], PERF_STREAMS,
+        PERF_STREAM_PACKETS, GST_TIME_ARGS (elapsed),
+        (gdouble) PERF_STREAMS * PERF_STREAM_PACKETS * GST_SECOND /
+        MAX (elapsed, 1));
+  }
+}
+
+GST_END_TEST;
+
+#define SETUP_STREAMS 4
+#define SETUP_DELAY (20 * G_TIME_SPAN_MILLISECOND)
+
+/* The server answers each request after a delay, which stands for the
+ * round trip time. With pipelined SETUP requests the first packet arrives
+ * SETUP_STREAMS - 2 round trips earlier. */
+GST_START_TEST (test_rtspsrc_pipelined_setup)
+{
+  gboolean pipelined[] = { FALSE, TRUE };
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (pipelined); i++) {
+    TestServer *server = test_server_new (100, 188);
+    TestClient *client;
+    GstClockTime elapsed;
+
+    server->n_streams = SETUP_STREAMS;
+    server->response_delay = SETUP_DELAY;
+
+    client = test_client_new (server, DEFAULT_READ_SIZE, 0, pipelined[i], 0);
+    test_client_wait (client,
+        g_get_monotonic_time () + 15 * G_TIME_SPAN_SECOND);
+    elapsed = client->first - client->start;
+    test_client_free (client);
+
+    fail_unless_equals_int (server->n_setups, SETUP_STREAMS);
+    if (pipelined[i])
+      fail_unless_equals_int (server->max_pending_setups, SETUP_STREAMS - 1);
+    else
+      fail_unless_equals_int (server->max_pending_setups, 1);
+    test_server_free (server);
+
+    GST_INFO ("pipelined-setup %d: first packet of %u streams after %"
+        GST_TIME_FORMAT, pipelined[i], SETUP_STREAMS, GST_TIME_ARGS (elapsed));
+  }
+}
+
+GST_END_TEST;
+
+static Suite *
+rtspsrc_suite (void)
+{
+  Suite *s = suite_create ("rtspsrc");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_rtspsrc_interleaved);
+  tcase_add_test (tc_chain, test_rtspsrc_shared_io);
+  tcase_add_test (tc_chain, test_rtspsrc_shared_io_keep_alive);
+  tcase_add_test (tc_chain, test_rtspsrc_pipelined_setup);
+
+  /* benchmarks only log their timings, run them with GST_CHECK_PERF=1 */
+  if (g_getenv ("GST_CHECK_PERF")) {
+    TCase *tc_perf = tcase_create ("perf");
+
+    suite_add_tcase (s, tc_perf);
+    tcase_add_test (tc_perf, test_rtspsrc_interleaved_perf);
+    tcase_add_test (tc_perf, test_rtspsrc_shared_io_perf);
+  }
+
+  return s;
+}
+
+GST_CHECK_MAIN (rtspsrc);
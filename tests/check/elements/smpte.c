@@ -0,0 +1,291 @@
+/* GStreamer
+ *
+ * unit test for the smptealpha element
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <string.h>
+
+#include <gst/video/video.h>
+#include <gst/check/gstcheck.h>
+#include <gst/check/gstharness.h>
+
+/* input and output formats */
+static const gchar *alpha_formats[][2] = {
+  {"AYUV", "AYUV"},
+  {"I420", "AYUV"},
+  {"ARGB", "ARGB"},
+  {"BGRA", "BGRA"},
+  {"ABGR", "ABGR"},
+  {"RGBA", "RGBA"},
+};
+
+static GstBuffer *
+create_random_frame (GstVideoInfo * info, GRand * rand)
+{
+  GstBuffer *buffer = gst_buffer_new_and_alloc (GST_VIDEO_INFO_SIZE (info));
+  GstMapInfo map;
+  gsize i;
+
+  gst_buffer_map (buffer, &map, GST_MAP_WRITE);
+  for (i = 0; i < map.size; i++)
+    map.data[i] = g_rand_int (rand);
+  gst_buffer_unmap (buffer, &map);
+
+  return buffer;
+}
+
+static GstBuffer *
+process_frames (GstVideoInfo * in_info, GstVideoInfo * out_info,
+    GstBuffer * inbuf, guint n_frames, GstClockTime * elapsed,
+    const gchar * prop, ...)
+{
+  GstHarness *h = gst_harness_new ("smptealpha");
+  GstBuffer *outbuf = NULL;
+  GstClockTime start;
+  va_list varargs;
+  guint i;
+
+  va_start (varargs, prop);
+  g_object_set_valist (G_OBJECT (h->element), prop, varargs);
+  va_end (varargs);
+
+  gst_harness_set_caps (h, gst_video_info_to_caps (in_info),
+      gst_video_info_to_caps (out_info));
+
+  start = gst_util_get_timestamp ();
+  for (i = 0; i < n_frames; i++) {
+    fail_unless_equals_int (gst_harness_push (h, gst_buffer_ref (inbuf)),
+        GST_FLOW_OK);
+    if (outbuf)
+      gst_buffer_unref (outbuf);
+    outbuf = gst_harness_pull (h);
+  }
+  if (elapsed)
+    *elapsed = gst_util_get_timestamp () - start;
+
+  gst_harness_teardown (h);
+
+  return outbuf;
+}
+
+/* the alpha of @out is @alpha, or that of @in if -1, and all other
+ * components are those of @in */
+static void
+check_alpha (GstBuffer * in, GstBuffer * out, GstVideoInfo * in_info,
+    GstVideoInfo * out_info, gint alpha)
+{
+  GstVideoFrame in_frame, out_frame;
+  gint a = GST_VIDEO_INFO_COMP_POFFSET (out_info, GST_VIDEO_COMP_A);
+  gint x, y, c;
+
+  gst_video_frame_map (&in_frame, in_info, in, GST_MAP_READ);
+  gst_video_frame_map (&out_frame, out_info, out, GST_MAP_READ);
+
+  for (y = 0; y < GST_VIDEO_INFO_HEIGHT (out_info); y++) {
+    const guint8 *o = (const guint8 *) GST_VIDEO_FRAME_PLANE_DATA (&out_frame,
+        0) + y * GST_VIDEO_FRAME_PLANE_STRIDE (&out_frame, 0);
+
+    for (x = 0; x < GST_VIDEO_INFO_WIDTH (out_info); x++) {
+      for (c = 0; c < 4; c++) {
+        gint expected;
+
+        if (GST_VIDEO_INFO_FORMAT (in_info) == GST_VIDEO_FORMAT_I420) {
+          if (c == a) {
+            expected = alpha == -1 ? 255 : alpha;
+          } else {
+            gint comp = c == 1 ? 0 : c == 2 ? 1 : 2;
+            gint sub = comp > 0;
+            const guint8 *i = (const guint8 *)
+                GST_VIDEO_FRAME_COMP_DATA (&in_frame, comp) +
+                (y >> sub) * GST_VIDEO_FRAME_COMP_STRIDE (&in_frame, comp);
+
+            expected = i[x >> sub];
+          }
+        } else {
+          const guint8 *i = (const guint8 *)
+              GST_VIDEO_FRAME_PLANE_DATA (&in_frame, 0) +
+              y * GST_VIDEO_FRAME_PLANE_STRIDE (&in_frame, 0);
+
+          expected = (c == a && alpha != -1) ? alpha : i[4 * x + c];
+        }
+
+        fail_unless_equals_int (o[4 * x + c], expected);
+      }
+    }
+  }
+
+  gst_video_frame_unmap (&in_frame);
+  gst_video_frame_unmap (&out_frame);
+}
+
+static void
+check_same_buffer (GstBuffer * a, GstBuffer * b)
+{
+  GstMapInfo map_a, map_b;
+
+  gst_buffer_map (a, &map_a, GST_MAP_READ);
+  gst_buffer_map (b, &map_b, GST_MAP_READ);
+  fail_unless_equals_int (map_a.size, map_b.size);
+  fail_unless (memcmp (map_a.data, map_b.data, map_a.size) == 0);
+  gst_buffer_unmap (a, &map_a);
+  gst_buffer_unmap (b, &map_b);
+}
+
+GST_START_TEST (test_smptealpha_positions)
+{
+  GRand *rand = g_rand_new_with_seed (0);
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (alpha_formats); i++) {
+    GstVideoInfo in_info, out_info;
+    GstBuffer *inbuf, *outbuf;
+
+    gst_video_info_set_format (&in_info,
+        gst_video_format_from_string (alpha_formats[i][0]), 97, 61);
+    gst_video_info_set_format (&out_info,
+        gst_video_format_from_string (alpha_formats[i][1]), 97, 61);
+    inbuf = create_random_frame (&in_info, rand);
+
+    GST_DEBUG ("checking %s to %s", alpha_formats[i][0], alpha_formats[i][1]);
+
+    /* at the start everything is visible, at the end nothing is */
+    outbuf = process_frames (&in_info, &out_info, inbuf, 1, NULL,
+        "type", 41, "border", 1000, "position", 0.0, NULL);
+    check_alpha (inbuf, outbuf, &in_info, &out_info, -1);
+    gst_buffer_unref (outbuf);
+
+    outbuf = process_frames (&in_info, &out_info, inbuf, 1, NULL,
+        "type", 41, "border", 1000, "position", 1.0, NULL);
+    check_alpha (inbuf, outbuf, &in_info, &out_info, 0);
+    gst_buffer_unref (outbuf);
+
+    gst_buffer_unref (inbuf);
+  }
+
+  g_rand_free (rand);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_smptealpha_threads)
+{
+  GRand *rand = g_rand_new_with_seed (0);
+  const gint depths[] = { 8, 16, 20 };
+  guint i, j;
+
+  for (i = 0; i < G_N_ELEMENTS (alpha_formats); i++) {
+    for (j = 0; j < G_N_ELEMENTS (depths); j++) {
+      GstVideoInfo in_info, out_info;
+      GstBuffer *inbuf, *single, *threaded;
+
+      /* odd height so the last band is a short one */
+      gst_video_info_set_format (&in_info,
+          gst_video_format_from_string (alpha_formats[i][0]), 320, 243);
+      gst_video_info_set_format (&out_info,
+          gst_video_format_from_string (alpha_formats[i][1]), 320, 243);
+      inbuf = create_random_frame (&in_info, rand);
+
+      single = process_frames (&in_info, &out_info, inbuf, 1, NULL,
+          "type", 101, "depth", depths[j], "border", 1 << (depths[j] - 2),
+          "position", 0.4, "n-threads", 1, NULL);
+      threaded = process_frames (&in_info, &out_info, inbuf, 1, NULL,
+          "type", 101, "depth", depths[j], "border", 1 << (depths[j] - 2),
+          "position", 0.4, "n-threads", 4, NULL);
+
+      GST_DEBUG ("checking %s to %s, depth %d", alpha_formats[i][0],
+          alpha_formats[i][1], depths[j]);
+      check_same_buffer (single, threaded);
+
+      gst_buffer_unref (inbuf);
+      gst_buffer_unref (single);
+      gst_buffer_unref (threaded);
+    }
+  }
+
+  g_rand_free (rand);
+}
+
+GST_END_TEST;
+
+#define PERF_FRAMES 10
+
+GST_START_TEST (test_smptealpha_perf)
+{
+  GRand *rand = g_rand_new_with_seed (0);
+  GstElement *smptealpha = gst_element_factory_make ("smptealpha", NULL);
+  GParamSpec *pspec;
+  GEnumClass *types;
+  GstVideoInfo info;
+  GstBuffer *inbuf;
+  guint i;
+
+  pspec = g_object_class_find_property (G_OBJECT_GET_CLASS (smptealpha),
+      "type");
+  types = g_type_class_ref (pspec->value_type);
+
+  gst_video_info_set_format (&info, GST_VIDEO_FORMAT_ARGB, 1920, 1080);
+  inbuf = create_random_frame (&info, rand);
+
+  for (i = 0; i < types->n_values; i++) {
+    GstClockTime single, threaded;
+
+    gst_buffer_unref (process_frames (&info, &info, inbuf, PERF_FRAMES,
+            &single, "type", types->values[i].value, "border", 20000,
+            "position", 0.5, "n-threads", 1, NULL));
+    gst_buffer_unref (process_frames (&info, &info, inbuf, PERF_FRAMES,
+            &threaded, "type", types->values[i].value, "border", 20000,
+            "position", 0.5, "n-threads", 0, NULL));
+
+    GST_INFO ("%s: %.2f ms per frame, %.2f ms with %u threads",
+        types->values[i].value_nick,
+        (gdouble) single / GST_MSECOND / PERF_FRAMES,
+        (gdouble) threaded / GST_MSECOND / PERF_FRAMES,
+        g_get_num_processors ());
+  }
+
+  gst_buffer_unref (inbuf);
+  g_type_class_unref (types);
+  gst_object_unref (smptealpha);
+  g_rand_free (rand);
+}
+
+GST_END_TEST;
+
+static Suite *
+smpte_suite (void)
+{
+  Suite *s = suite_create ("smpte");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_set_timeout (tc_chain, 180);
+  tcase_add_test (tc_chain, test_smptealpha_positions);
+  tcase_add_test (tc_chain, test_smptealpha_threads);
+
+  /* benchmarks only log their timings, run them with GST_CHECK_PERF=1 */
+  if (g_getenv ("GST_CHECK_PERF")) {
+    TCase *tc_perf = tcase_create ("perf");
+
+    suite_add_tcase (s, tc_perf);
+    tcase_add_test (tc_perf, test_smptealpha_perf);
+  }
+
+  return s;
+}
+
+GST_CHECK_MAIN (smpte);
@@ -23,7 +23,9 @@
 # include "config.h"
 #endif
 
+#include <gst/video/video.h>
 #include <gst/check/gstcheck.h>
+#include <gst/check/gstharness.h>
 
 typedef struct _GstVideoBoxTestContext
 {
@@ -207,6 +209,272 @@ GST_START_TEST (test_caps_transform)
 GST_END_TEST;
 
 
+/* left, right, top, bottom */
+static const gint box_table[][4] = {
+  {-5, -8, -3, -2},
+  {6, -7, -3, 5},
+  {0, 0, -140, -140},
+  {-240, -240, 0, 0},
+};
+
+static const gchar *fill_formats[] = {
+  "AYUV", "I420", "YV12", "Y444", "Y42B", "Y41B", "YUY2", "UYVY", "xRGB",
+  "BGRA", "RGB", "GRAY8",
+};
+
+static GstHarness *
+videobox_harness_new (GstVideoInfo * in_info, GstVideoInfo * out_info,
+    const gint box[4], gboolean crop_meta)
+{
+  GstHarness *h = gst_harness_new ("videobox");
+
+  g_object_set (h->element, "left", box[0], "right", box[1], "top", box[2],
+      "bottom", box[3], "fill", 5, NULL);
+
+  gst_video_info_set_format (out_info, GST_VIDEO_INFO_FORMAT (in_info),
+      GST_VIDEO_INFO_WIDTH (in_info) - box[0] - box[1],
+      GST_VIDEO_INFO_HEIGHT (in_info) - box[2] - box[3]);
+
+  if (crop_meta) {
+    gst_harness_add_propose_allocation_meta (h, GST_VIDEO_META_API_TYPE, NULL);
+    gst_harness_add_propose_allocation_meta (h, GST_VIDEO_CROP_META_API_TYPE,
+        NULL);
+  }
+
+  gst_harness_set_caps (h, gst_video_info_to_caps (in_info),
+      gst_video_info_to_caps (out_info));
+
+  return h;
+}
+
+/* a frame of a single color, (Y, U, V) or (R, G, B) */
+static GstBuffer *
+create_solid_frame (GstVideoInfo * info)
+{
+  const GstVideoFormatInfo *finfo = info->finfo;
+  GstBuffer *buffer = gst_buffer_new_and_alloc (GST_VIDEO_INFO_SIZE (info));
+  guint8 *line = g_malloc (4 * GST_VIDEO_INFO_WIDTH (info));
+  GstVideoFrame frame;
+  gint x, y;
+
+  for (x = 0; x < GST_VIDEO_INFO_WIDTH (info); x++) {
+    line[4 * x + 0] = 255;
+    line[4 * x + 1] = GST_VIDEO_FORMAT_INFO_IS_RGB (finfo) ? 200 : 100;
+    line[4 * x + 2] = GST_VIDEO_FORMAT_INFO_IS_RGB (finfo) ? 100 : 50;
+    line[4 * x + 3] = GST_VIDEO_FORMAT_INFO_IS_RGB (finfo) ? 50 : 200;
+  }
+
+  gst_video_frame_map (&frame, info, buffer, GST_MAP_WRITE);
+  for (y = 0; y < GST_VIDEO_INFO_HEIGHT (info); y++)
+    finfo->pack_func (finfo, GST_VIDEO_PACK_FLAG_NONE, line, 0, frame.data,
+        frame.info.stride, GST_VIDEO_CHROMA_SITE_UNKNOWN, y,
+        GST_VIDEO_INFO_WIDTH (info));
+  gst_video_frame_unmap (&frame);
+  g_free (line);
+
+  return buffer;
+}
+
+/* the unpacked color of the first pixel of @buffer */
+static void
+get_color (GstVideoInfo * info, GstBuffer * buffer, guint8 color[4])
+{
+  guint8 *line = g_malloc (4 * GST_VIDEO_INFO_WIDTH (info));
+  GstVideoFrame frame;
+
+  gst_video_frame_map (&frame, info, buffer, GST_MAP_READ);
+  info->finfo->unpack_func (info->finfo, GST_VIDEO_PACK_FLAG_NONE, line,
+      frame.data, frame.info.stride, 0, 0, GST_VIDEO_INFO_WIDTH (info));
+  gst_video_frame_unmap (&frame);
+
+  memcpy (color, line, 4);
+  g_free (line);
+}
+
+/* the white border around a copy of the input at @x, @y, ignoring alpha and
+ * the macro pixels that mix border and input */
+static void
+check_box (GstVideoInfo * out_info, GstBuffer * out, const guint8 in_color[4],
+    gint x, gint y, gint w, gint h)
+{
+  const GstVideoFormatInfo *finfo = out_info->finfo;
+  guint8 *line = g_malloc (4 * GST_VIDEO_INFO_WIDTH (out_info));
+  guint8 white[4] = { 255, 235, 128, 128 };
+  gint walign = 1, halign = 1;
+  GstVideoFrame frame;
+  gint i, j, c;
+
+  if (GST_VIDEO_FORMAT_INFO_IS_RGB (finfo))
+    white[1] = white[2] = white[3] = 255;
+
+  for (c = 0; c < GST_VIDEO_FORMAT_INFO_N_COMPONENTS (finfo); c++) {
+    walign = MAX (walign, 1 << GST_VIDEO_FORMAT_INFO_W_SUB (finfo, c));
+    halign = MAX (halign, 1 << GST_VIDEO_FORMAT_INFO_H_SUB (finfo, c));
+  }
+
+  gst_video_frame_map (&frame, out_info, out, GST_MAP_READ);
+  for (j = 0; j < GST_VIDEO_INFO_HEIGHT (out_info); j++) {
+    gint mj = j / halign * halign;
+    gboolean row_inside = mj >= y && mj + halign <= y + h;
+    gboolean row_outside = mj >= y + h || mj + halign <= y;
+
+    finfo->unpack_func (finfo, GST_VIDEO_PACK_FLAG_NONE, line, frame.data,
+        frame.info.stride, 0, j, GST_VIDEO_INFO_WIDTH (out_info));
+
+    for (i = 0; i < GST_VIDEO_INFO_WIDTH (out_info); i++) {
+      gint mi = i / walign * walign;
+      gboolean inside = row_inside && mi >= x && mi + walign <= x + w;
+      gboolean outside = row_outside || mi >= x + w || mi + walign <= x;
+
+      if (!inside && !outside)
+        continue;
+
+      for (c = 1; c < 4; c++)
+        fail_unless_equals_int (line[4 * i + c],
+            inside ? in_color[c] : white[c]);
+    }
+  }
+  gst_video_frame_unmap (&frame);
+  g_free (line);
+}
+
+GST_START_TEST (test_borders)
+{
+  guint i, j;
+
+  for (i = 0; i < G_N_ELEMENTS (fill_formats); i++) {
+    for (j = 0; j < 2; j++) {
+      const gint *box = box_table[j];
+      GstVideoInfo in_info, out_info;
+      GstBuffer *inbuf, *outbuf;
+      guint8 in_color[4];
+      GstHarness *h;
+
+      GST_DEBUG ("checking %s with box %d %d %d %d", fill_formats[i], box[0],
+          box[1], box[2], box[3]);
+
+      gst_video_info_set_format (&in_info,
+          gst_video_format_from_string (fill_formats[i]), 64, 48);
+      h = videobox_harness_new (&in_info, &out_info, box, FALSE);
+      inbuf = create_solid_frame (&in_info);
+      get_color (&in_info, inbuf, in_color);
+
+      fail_unless_equals_int (gst_harness_push (h, gst_buffer_ref (inbuf)),
+          GST_FLOW_OK);
+      outbuf = gst_harness_pull (h);
+      fail_unless (gst_buffer_get_video_crop_meta (outbuf) == NULL);
+
+      check_box (&out_info, outbuf, in_color, MAX (-box[0], 0),
+          MAX (-box[2], 0), 64 - MAX (box[0], 0) - MAX (box[1], 0),
+          48 - MAX (box[2], 0) - MAX (box[3], 0));
+
+      gst_buffer_unref (outbuf);
+      gst_buffer_unref (inbuf);
+      gst_harness_teardown (h);
+    }
+  }
+}
+
+GST_END_TEST;
+
+static void
+check_crop_meta (const gchar * format, const gint box[4], gboolean expected)
+{
+  GstVideoInfo in_info, out_info;
+  GstBuffer *inbuf, *outbuf;
+  GstVideoCropMeta *crop_meta;
+  GstHarness *h;
+
+  gst_video_info_set_format (&in_info, gst_video_format_from_string (format),
+      320, 240);
+  h = videobox_harness_new (&in_info, &out_info, box, TRUE);
+  inbuf = gst_buffer_new_and_alloc (GST_VIDEO_INFO_SIZE (&in_info));
+
+  fail_unless_equals_int (gst_harness_push (h, gst_buffer_ref (inbuf)),
+      GST_FLOW_OK);
+  outbuf = gst_harness_pull (h);
+  crop_meta = gst_buffer_get_video_crop_meta (outbuf);
+
+  if (expected) {
+    fail_unless (crop_meta != NULL);
+    fail_unless_equals_int (crop_meta->x, box[0]);
+    fail_unless_equals_int (crop_meta->y, box[2]);
+    fail_unless_equals_int (crop_meta->width,
+        GST_VIDEO_INFO_WIDTH (&out_info));
+    fail_unless_equals_int (crop_meta->height,
+        GST_VIDEO_INFO_HEIGHT (&out_info));
+    fail_unless (gst_buffer_get_video_meta (outbuf) != NULL);
+    /* no copy was made */
+    fail_unless (gst_buffer_peek_memory (outbuf, 0) ==
+        gst_buffer_peek_memory (inbuf, 0));
+  } else {
+    fail_unless (crop_meta == NULL);
+    fail_unless_equals_int (gst_buffer_get_size (outbuf),
+        GST_VIDEO_INFO_SIZE (&out_info));
+  }
+
+  gst_buffer_unref (outbuf);
+  gst_buffer_unref (inbuf);
+  gst_harness_teardown (h);
+}
+
+GST_START_TEST (test_crop_meta)
+{
+  const gint crop[4] = { 10, 20, 6, 8 };
+  const gint border[4] = { 10, -20, 6, 8 };
+
+  check_crop_meta ("I420", crop, TRUE);
+  check_crop_meta ("YUY2", crop, TRUE);
+  check_crop_meta ("xRGB", crop, TRUE);
+  /* alpha is scaled by the copy, borders need to be filled */
+  check_crop_meta ("ARGB", crop, FALSE);
+  check_crop_meta ("I420", border, FALSE);
+}
+
+GST_END_TEST;
+
+#define PERF_FRAMES 20
+
+GST_START_TEST (test_borders_perf)
+{
+  const gchar *formats[] = { "I420", "YUY2", "xRGB", "AYUV" };
+  const gchar *names[] = { "letterbox", "pillarbox" };
+  guint i, j;
+
+  for (i = 0; i < G_N_ELEMENTS (formats); i++) {
+    for (j = 0; j < 2; j++) {
+      const gint *box = box_table[j + 2];
+      GstVideoInfo in_info, out_info;
+      GstClockTime start, elapsed;
+      GstBuffer *inbuf;
+      GstHarness *h;
+      guint n;
+
+      gst_video_info_set_format (&in_info,
+          gst_video_format_from_string (formats[i]), 1920 + box[0] + box[1],
+          1080 + box[2] + box[3]);
+      h = videobox_harness_new (&in_info, &out_info, box, FALSE);
+      inbuf = create_solid_frame (&in_info);
+
+      start = gst_util_get_timestamp ();
+      for (n = 0; n < PERF_FRAMES; n++) {
+        fail_unless_equals_int (gst_harness_push (h, gst_buffer_ref (inbuf)),
+            GST_FLOW_OK);
+        gst_buffer_unref (gst_harness_pull (h));
+      }
+      elapsed = gst_util_get_timestamp () - start;
+
+      GST_INFO ("%s %s to 1920x1080: %.2f ms per frame", formats[i], names[j],
+          (gdouble) elapsed / GST_MSECOND / PERF_FRAMES);
+
+      gst_buffer_unref (inbuf);
+      gst_harness_teardown (h);
+    }
+  }
+}
+
+GST_END_TEST;
+
 static Suite *
 videobox_suite (void)
 {
@@ -215,6 +483,16 @@ videobox_suite (void)
 
   suite_add_tcase (s, tc_chain);
   tcase_add_test (tc_chain, test_caps_transform);
+  tcase_add_test (tc_chain, test_borders);
+  tcase_add_test (tc_chain, test_crop_meta);
+
+  /* benchmarks only log their timings, run them with GST_CHECK_PERF=1 */
+  if (g_getenv ("GST_CHECK_PERF")) {
+    TCase *tc_perf = tcase_create ("perf");
+
+    suite_add_tcase (s, tc_perf);
+    tcase_add_test (tc_perf, test_borders_perf);
+  }
 
   return s;
 }
@@ -25,9 +25,14 @@
 # include <valgrind/valgrind.h>
 #endif
 
+#include <string.h>
+
 #include <gst/check/gstcheck.h>
+#include <gst/check/gstharness.h>
 #include <gst/video/video.h>
 #include <gst/base/gstbasetransform.h>
+#include <gst/controller/gstinterpolationcontrolsource.h>
+#include <gst/controller/gstdirectcontrolbinding.h>
 
 /* return a list of caps where we only need to set
  * width and height to get fixed caps */
@@ -897,6 +902,417 @@ GST_START_TEST (test_passthrough_featured)
 
 GST_END_TEST;
 
+static GstBuffer *
+create_random_frame (GstVideoInfo * info, GRand * rand)
+{
+  GstBuffer *buffer = gst_buffer_new_and_alloc (GST_VIDEO_INFO_SIZE (info));
+  GstMapInfo map;
+  gsize i;
+
+  gst_buffer_map (buffer, &map, GST_MAP_WRITE);
+  for (i = 0; i < map.size; i++)
+    map.data[i] = g_rand_int (rand);
+  gst_buffer_unmap (buffer, &map);
+
+  return buffer;
+}
+
+/* a harness around a videocrop with the given properties. With @crop_meta
+ * downstream supports crop meta. */
+static GstHarness *
+videocrop_harness_new (GstVideoInfo * in_info, GstVideoInfo * out_info,
+    gboolean crop_meta, const gchar * prop, ...)
+{
+  GstElement *crop = gst_element_factory_make ("videocrop", NULL);
+  GstHarness *h;
+  va_list varargs;
+
+  va_start (varargs, prop);
+  g_object_set_valist (G_OBJECT (crop), prop, varargs);
+  va_end (varargs);
+
+  h = gst_harness_new_with_element (crop, "sink", "src");
+  gst_object_unref (crop);
+
+  if (crop_meta) {
+    gst_harness_add_propose_allocation_meta (h, GST_VIDEO_META_API_TYPE, NULL);
+    gst_harness_add_propose_allocation_meta (h, GST_VIDEO_CROP_META_API_TYPE,
+        NULL);
+  }
+
+  gst_harness_set_caps (h, gst_video_info_to_caps (in_info),
+      gst_video_info_to_caps (out_info));
+
+  return h;
+}
+
+static void
+check_same_buffer (GstBuffer * a, GstBuffer * b)
+{
+  GstMapInfo map_a, map_b;
+
+  gst_buffer_map (a, &map_a, GST_MAP_READ);
+  gst_buffer_map (b, &map_b, GST_MAP_READ);
+  fail_unless_equals_int (map_a.size, map_b.size);
+  fail_unless (memcmp (map_a.data, map_b.data, map_a.size) == 0);
+  gst_buffer_unmap (a, &map_a);
+  gst_buffer_unmap (b, &map_b);
+}
+
+#define TILE_COLUMNS 4
+#define TILE_ROWS 3
+#define TILE_WIDTH 64
+#define TILE_HEIGHT 32
+#define TILES_LEFT 4
+#define TILES_RIGHT 8
+#define TILES_TOP 2
+#define TILES_BOTTOM 6
+#define TILES_WIDTH (TILES_LEFT + TILE_COLUMNS * TILE_WIDTH + TILES_RIGHT)
+#define TILES_HEIGHT (TILES_TOP + TILE_ROWS * TILE_HEIGHT + TILES_BOTTOM)
+
+/* pulls the tiles of @inbuf from @h, which crops @left and @top, and checks
+ * that every tile is the same as cropping its area on its own */
+static void
+pull_and_check_tiles (GstHarness * h, GstBuffer * inbuf,
+    GstVideoInfo * in_info, GstVideoInfo * out_info, gint columns, gint rows,
+    gint left, gint top)
+{
+  gint tile_width = GST_VIDEO_INFO_WIDTH (out_info);
+  gint tile_height = GST_VIDEO_INFO_HEIGHT (out_info);
+  gint t;
+
+  fail_unless_equals_int (gst_harness_buffers_in_queue (h), columns * rows);
+
+  for (t = 0; t < columns * rows; t++) {
+    gint x = left + (t % columns) * tile_width;
+    gint y = top + (t / columns) * tile_height;
+    GstBuffer *tile, *expected;
+    GstHarness *single;
+
+    single = videocrop_harness_new (in_info, out_info, FALSE,
+        "left", x, "right", GST_VIDEO_INFO_WIDTH (in_info) - x - tile_width,
+        "top", y, "bottom", GST_VIDEO_INFO_HEIGHT (in_info) - y - tile_height,
+        NULL);
+    fail_unless_equals_int (gst_harness_push (single, gst_buffer_ref (inbuf)),
+        GST_FLOW_OK);
+    expected = gst_harness_pull (single);
+
+    tile = gst_harness_pull (h);
+    check_same_buffer (tile, expected);
+
+    gst_buffer_unref (tile);
+    gst_buffer_unref (expected);
+    gst_harness_teardown (single);
+  }
+}
+
+/* crops @left and @top off a frame of @format that holds @columns by @rows
+ * tiles plus a few pixels on each side, and checks the tiles */
+static void
+check_tiles (const gchar * format, gint tile_width, gint tile_height,
+    gint columns, gint rows, gint left, gint top, GRand * rand)
+{
+  GstVideoFormat fmt = gst_video_format_from_string (format);
+  gint right = TILES_RIGHT, bottom = TILES_BOTTOM;
+  GstVideoInfo in_info, out_info;
+  GstBuffer *inbuf;
+  GstHarness *h;
+
+  GST_DEBUG ("checking %s, %dx%d tiles of %dx%d at %d,%d", format, columns,
+      rows, tile_width, tile_height, left, top);
+
+  gst_video_info_set_format (&in_info, fmt,
+      left + columns * tile_width + right, top + rows * tile_height + bottom);
+  gst_video_info_set_format (&out_info, fmt, tile_width, tile_height);
+  inbuf = create_random_frame (&in_info, rand);
+
+  h = videocrop_harness_new (&in_info, &out_info, FALSE, "left", left,
+      "right", right, "top", top, "bottom", bottom, "tile-columns", columns,
+      "tile-rows", rows, "n-threads", 4, NULL);
+  fail_unless_equals_int (gst_harness_push (h, gst_buffer_ref (inbuf)),
+      GST_FLOW_OK);
+  pull_and_check_tiles (h, inbuf, &in_info, &out_info, columns, rows, left,
+      top);
+
+  gst_harness_teardown (h);
+  gst_buffer_unref (inbuf);
+}
+
+/* every tile is the same as cropping its area on its own */
+GST_START_TEST (test_tiles)
+{
+  const gchar *formats[] = {
+    "I420", "NV12", "BGRx", "YUY2", "GRAY8", "Y444_10LE"
+  };
+  GRand *rand = g_rand_new_with_seed (0);
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (formats); i++)
+    check_tiles (formats[i], TILE_WIDTH, TILE_HEIGHT, TILE_COLUMNS, TILE_ROWS,
+        TILES_LEFT, TILES_TOP, rand);
+
+  g_rand_free (rand);
+}
+
+GST_END_TEST;
+
+/* tiles that don't start on a macro-pixel or a subsampled row */
+GST_START_TEST (test_tiles_odd)
+{
+  GRand *rand = g_rand_new_with_seed (0);
+
+  /* odd crop_left shifts the luma of every YUY2 tile */
+  check_tiles ("YUY2", TILE_WIDTH, TILE_HEIGHT, TILE_COLUMNS, TILE_ROWS, 5,
+      TILES_TOP, rand);
+  /* v210 tiles start on a whole group of 6 pixels */
+  check_tiles ("v210", 48, TILE_HEIGHT, TILE_COLUMNS, TILE_ROWS, 12, TILES_TOP,
+      rand);
+  /* every other NV12 tile starts in the middle of a chroma row */
+  check_tiles ("NV12", TILE_WIDTH, 31, TILE_COLUMNS, TILE_ROWS, TILES_LEFT,
+      TILES_TOP, rand);
+  check_tiles ("NV12", TILE_WIDTH, 31, TILE_COLUMNS, TILE_ROWS, TILES_LEFT, 3,
+      rand);
+
+  g_rand_free (rand);
+}
+
+GST_END_TEST;
+
+/* controlled properties follow the timestamps of the input in tile mode
+ * too */
+GST_START_TEST (test_tiles_control_binding)
+{
+  GRand *rand = g_rand_new_with_seed (0);
+  GstControlSource *left_cs, *right_cs;
+  GstVideoInfo in_info, out_info;
+  GstBuffer *inbuf;
+  GstHarness *h;
+
+  gst_video_info_set_format (&in_info, GST_VIDEO_FORMAT_I420, TILES_WIDTH,
+      TILES_HEIGHT);
+  gst_video_info_set_format (&out_info, GST_VIDEO_FORMAT_I420, TILE_WIDTH,
+      TILE_HEIGHT);
+  inbuf = create_random_frame (&in_info, rand);
+
+  h = videocrop_harness_new (&in_info, &out_info, FALSE, "left", TILES_LEFT,
+      "right", TILES_RIGHT, "top", TILES_TOP, "bottom", TILES_BOTTOM,
+      "tile-columns", TILE_COLUMNS, "tile-rows", TILE_ROWS, NULL);
+
+  /* the tiles move 2 pixels to the right after one second */
+  left_cs = gst_interpolation_control_source_new ();
+  g_object_set (left_cs, "mode", GST_INTERPOLATION_MODE_NONE, NULL);
+  gst_timed_value_control_source_set (GST_TIMED_VALUE_CONTROL_SOURCE (left_cs),
+      0, TILES_LEFT);
+  gst_timed_value_control_source_set (GST_TIMED_VALUE_CONTROL_SOURCE (left_cs),
+      GST_SECOND, TILES_LEFT + 2);
+  right_cs = gst_interpolation_control_source_new ();
+  g_object_set (right_cs, "mode", GST_INTERPOLATION_MODE_NONE, NULL);
+  gst_timed_value_control_source_set (GST_TIMED_VALUE_CONTROL_SOURCE
+      (right_cs), 0, TILES_RIGHT);
+  gst_timed_value_control_source_set (GST_TIMED_VALUE_CONTROL_SOURCE
+      (right_cs), GST_SECOND, TILES_RIGHT - 2);
+  gst_object_add_control_binding (GST_OBJECT (h->element),
+      gst_direct_control_binding_new_absolute (GST_OBJECT (h->element), "left",
+          left_cs));
+  gst_object_add_control_binding (GST_OBJECT (h->element),
+      gst_direct_control_binding_new_absolute (GST_OBJECT (h->element),
+          "right", right_cs));
+
+  inbuf = gst_buffer_make_writable (inbuf);
+  GST_BUFFER_PTS (inbuf) = 0;
+  fail_unless_equals_int (gst_harness_push (h, gst_buffer_ref (inbuf)),
+      GST_FLOW_OK);
+  pull_and_check_tiles (h, inbuf, &in_info, &out_info, TILE_COLUMNS,
+      TILE_ROWS, TILES_LEFT, TILES_TOP);
+
+  inbuf = gst_buffer_make_writable (inbuf);
+  GST_BUFFER_PTS (inbuf) = GST_SECOND;
+  fail_unless_equals_int (gst_harness_push (h, gst_buffer_ref (inbuf)),
+      GST_FLOW_OK);
+  pull_and_check_tiles (h, inbuf, &in_info, &out_info, TILE_COLUMNS,
+      TILE_ROWS, TILES_LEFT + 2, TILES_TOP);
+
+  gst_harness_teardown (h);
+  gst_object_unref (left_cs);
+  gst_object_unref (right_cs);
+  gst_buffer_unref (inbuf);
+  g_rand_free (rand);
+}
+
+GST_END_TEST;
+
+/* a gap gives one gap per tile, even when it has no data */
+GST_START_TEST (test_tiles_gap)
+{
+  GstVideoInfo in_info, out_info;
+  GstBuffer *gap;
+  GstHarness *h;
+  guint t;
+
+  gst_video_info_set_format (&in_info, GST_VIDEO_FORMAT_I420, TILES_WIDTH,
+      TILES_HEIGHT);
+  gst_video_info_set_format (&out_info, GST_VIDEO_FORMAT_I420, TILE_WIDTH,
+      TILE_HEIGHT);
+
+  h = videocrop_harness_new (&in_info, &out_info, FALSE, "left", TILES_LEFT,
+      "right", TILES_RIGHT, "top", TILES_TOP, "bottom", TILES_BOTTOM,
+      "tile-columns", TILE_COLUMNS, "tile-rows", TILE_ROWS, NULL);
+
+  gap = gst_buffer_new ();
+  GST_BUFFER_FLAG_SET (gap, GST_BUFFER_FLAG_GAP);
+  GST_BUFFER_PTS (gap) = 0;
+  GST_BUFFER_DURATION (gap) = GST_SECOND / 30;
+  fail_unless_equals_int (gst_harness_push (h, gap), GST_FLOW_OK);
+
+  for (t = 0; t < TILE_COLUMNS * TILE_ROWS; t++) {
+    GstBuffer *tile = gst_harness_pull (h);
+
+    fail_unless (GST_BUFFER_FLAG_IS_SET (tile, GST_BUFFER_FLAG_GAP));
+    fail_unless_equals_uint64 (GST_BUFFER_PTS (tile), 0);
+    fail_unless_equals_uint64 (GST_BUFFER_DURATION (tile), GST_SECOND / 30);
+    gst_buffer_unref (tile);
+  }
+  fail_unless_equals_int (gst_harness_buffers_in_queue (h), 0);
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+/* with crop meta the tiles share the memory of the input */
+GST_START_TEST (test_tiles_crop_meta)
+{
+  GRand *rand = g_rand_new_with_seed (0);
+  GstVideoInfo in_info, out_info;
+  GstBuffer *inbuf;
+  GstHarness *h;
+  guint t;
+
+  gst_video_info_set_format (&in_info, GST_VIDEO_FORMAT_I420, TILES_WIDTH,
+      TILES_HEIGHT);
+  gst_video_info_set_format (&out_info, GST_VIDEO_FORMAT_I420, TILE_WIDTH,
+      TILE_HEIGHT);
+  inbuf = create_random_frame (&in_info, rand);
+
+  h = videocrop_harness_new (&in_info, &out_info, TRUE, "left", TILES_LEFT,
+      "right", TILES_RIGHT, "top", TILES_TOP, "bottom", TILES_BOTTOM,
+      "tile-columns", TILE_COLUMNS, "tile-rows", TILE_ROWS, NULL);
+  fail_unless_equals_int (gst_harness_push (h, gst_buffer_ref (inbuf)),
+      GST_FLOW_OK);
+
+  for (t = 0; t < TILE_COLUMNS * TILE_ROWS; t++) {
+    GstBuffer *tile = gst_harness_pull (h);
+    GstVideoCropMeta *meta = gst_buffer_get_video_crop_meta (tile);
+
+    fail_unless (tile != NULL);
+    fail_unless (gst_buffer_peek_memory (tile, 0) ==
+        gst_buffer_peek_memory (inbuf, 0));
+    fail_unless (meta != NULL);
+    fail_unless_equals_int (meta->x,
+        TILES_LEFT + (t % TILE_COLUMNS) * TILE_WIDTH);
+    fail_unless_equals_int (meta->y,
+        TILES_TOP + (t / TILE_COLUMNS) * TILE_HEIGHT);
+    fail_unless_equals_int (meta->width, TILE_WIDTH);
+    fail_unless_equals_int (meta->height, TILE_HEIGHT);
+
+    gst_buffer_unref (tile);
+  }
+  fail_unless_equals_int (gst_harness_buffers_in_queue (h), 0);
+
+  gst_harness_teardown (h);
+  gst_buffer_unref (inbuf);
+  g_rand_free (rand);
+}
+
+GST_END_TEST;
+
+#define PERF_FRAMES 10
+#define PERF_TILES 4
+
+/* pushes PERF_FRAMES frames and pulls all the tiles */
+static GstClockTime
+time_tiles (GstVideoInfo * in_info, GstVideoInfo * out_info,
+    GstBuffer * inbuf, gboolean crop_meta, guint n_threads)
+{
+  GstHarness *h;
+  GstClockTime start, elapsed;
+  guint i, t;
+
+  h = videocrop_harness_new (in_info, out_info, crop_meta,
+      "tile-columns", PERF_TILES, "tile-rows", PERF_TILES,
+      "n-threads", n_threads, NULL);
+
+  start = gst_util_get_timestamp ();
+  for (i = 0; i < PERF_FRAMES; i++) {
+    fail_unless_equals_int (gst_harness_push (h, gst_buffer_ref (inbuf)),
+        GST_FLOW_OK);
+    for (t = 0; t < PERF_TILES * PERF_TILES; t++)
+      gst_buffer_unref (gst_harness_pull (h));
+  }
+  elapsed = gst_util_get_timestamp () - start;
+
+  gst_harness_teardown (h);
+
+  return elapsed;
+}
+
+/* 16 tiles of an 8K frame, against one videocrop per tile */
+GST_START_TEST (test_tiles_perf)
+{
+  GRand *rand = g_rand_new_with_seed (0);
+  GstHarness *singles[PERF_TILES * PERF_TILES];
+  GstVideoInfo in_info, out_info;
+  GstClockTime start, single, tiles, threaded, meta;
+  GstBuffer *inbuf;
+  gint tile_width, tile_height;
+  guint i, t;
+
+  gst_video_info_set_format (&in_info, GST_VIDEO_FORMAT_I420, 7680, 4320);
+  tile_width = 7680 / PERF_TILES;
+  tile_height = 4320 / PERF_TILES;
+  gst_video_info_set_format (&out_info, GST_VIDEO_FORMAT_I420, tile_width,
+      tile_height);
+  inbuf = create_random_frame (&in_info, rand);
+
+  for (t = 0; t < PERF_TILES * PERF_TILES; t++) {
+    gint left = (t % PERF_TILES) * tile_width;
+    gint top = (t / PERF_TILES) * tile_height;
+
+    singles[t] = videocrop_harness_new (&in_info, &out_info, FALSE,
+        "left", left, "right", 7680 - left - tile_width,
+        "top", top, "bottom", 4320 - top - tile_height, NULL);
+  }
+
+  start = gst_util_get_timestamp ();
+  for (i = 0; i < PERF_FRAMES; i++) {
+    for (t = 0; t < PERF_TILES * PERF_TILES; t++) {
+      fail_unless_equals_int (gst_harness_push (singles[t],
+              gst_buffer_ref (inbuf)), GST_FLOW_OK);
+      gst_buffer_unref (gst_harness_pull (singles[t]));
+    }
+  }
+  single = gst_util_get_timestamp () - start;
+
+  for (t = 0; t < PERF_TILES * PERF_TILES; t++)
+    gst_harness_teardown (singles[t]);
+
+  tiles = time_tiles (&in_info, &out_info, inbuf, FALSE, 1);
+  threaded = time_tiles (&in_info, &out_info, inbuf, FALSE, 0);
+  meta = time_tiles (&in_info, &out_info, inbuf, TRUE, 1);
+
+  GST_INFO ("%u tiles of 8K: %.2f ms per frame with one videocrop per tile, "
+      "%.2f ms with tiles, %.2f ms with %u threads, %.2f ms with crop meta",
+      PERF_TILES * PERF_TILES, (gdouble) single / GST_MSECOND / PERF_FRAMES,
+      (gdouble) tiles / GST_MSECOND / PERF_FRAMES,
+      (gdouble) threaded / GST_MSECOND / PERF_FRAMES,
+      g_get_num_processors (), (gdouble) meta / GST_MSECOND / PERF_FRAMES);
+
+  gst_buffer_unref (inbuf);
+  g_rand_free (rand);
+}
+
+GST_END_TEST;
+
 static Suite *
 videocrop_suite (void)
 {
@@ -923,6 +1339,19 @@ videocrop_suite (void)
   tcase_add_test (tc_chain, test_passthrough_featured);
   tcase_add_test (tc_chain, test_unit_sizes);
   tcase_add_loop_test (tc_chain, test_cropping, 0, 25);
+  tcase_add_test (tc_chain, test_tiles);
+  tcase_add_test (tc_chain, test_tiles_odd);
+  tcase_add_test (tc_chain, test_tiles_crop_meta);
+  tcase_add_test (tc_chain, test_tiles_control_binding);
+  tcase_add_test (tc_chain, test_tiles_gap);
+
+  /* benchmarks only log their timings, run them with GST_CHECK_PERF=1 */
+  if (g_getenv ("GST_CHECK_PERF")) {
+    TCase *tc_perf = tcase_create ("perf");
+
+    suite_add_tcase (s, tc_perf);
+    tcase_add_test (tc_perf, test_tiles_perf);
+  }
 
   return s;
 }
@@ -21,9 +21,12 @@
  */
 
 #include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include <gst/video/video.h>
 #include <gst/check/gstcheck.h>
+#include <gst/check/gstharness.h>
 
 gboolean have_eos = FALSE;
 
@@ -247,6 +250,396 @@ GST_START_TEST (test_gamma)
 
 GST_END_TEST;
 
+#if G_BYTE_ORDER == G_LITTLE_ENDIAN
+#define NE(f) f "LE"
+#else
+#define NE(f) f "BE"
+#endif
+
+static const gchar *process_formats[] = {
+  "I420", "NV12", "YUY2", "AYUV", "xRGB",
+  NE ("I420_10"), NE ("I422_12"), NE ("Y444_16"), NE ("P010_10"),
+};
+
+/* Random frame with every sample in the range of the format */
+static GstBuffer *
+create_random_frame (GstVideoInfo * info, GRand * rand)
+{
+  GstBuffer *buffer = gst_buffer_new_and_alloc (GST_VIDEO_INFO_SIZE (info));
+  gint depth = GST_VIDEO_INFO_COMP_DEPTH (info, 0);
+  gint shift = GST_VIDEO_FORMAT_INFO_SHIFT (info->finfo, 0);
+  GstMapInfo map;
+  gsize i;
+
+  gst_buffer_map (buffer, &map, GST_MAP_WRITE);
+  if (depth > 8) {
+    guint16 *data = (guint16 *) map.data;
+
+    for (i = 0; i < map.size / 2; i++)
+      data[i] = g_rand_int_range (rand, 0, 1 << depth) << shift;
+  } else {
+    for (i = 0; i < map.size; i++)
+      map.data[i] = g_rand_int (rand);
+  }
+  gst_buffer_unmap (buffer, &map);
+
+  return buffer;
+}
+
+/* Runs @n_frames copies of @inbuf through @name and returns the last output
+ * buffer, with the time spent in @elapsed if not NULL */
+static GstBuffer *
+process_frames (const gchar * name, const GstVideoInfo * info,
+    GstBuffer * inbuf, guint n_frames, GstClockTime * elapsed,
+    const gchar * prop, ...)
+{
+  GstHarness *h = gst_harness_new (name);
+  GstCaps *caps = gst_video_info_to_caps (info);
+  GstBuffer *outbuf = NULL;
+  GstClockTime start;
+  va_list varargs;
+  guint i;
+
+  va_start (varargs, prop);
+  g_object_set_valist (G_OBJECT (h->element), prop, varargs);
+  va_end (varargs);
+
+  gst_harness_set_caps (h, gst_caps_ref (caps), caps);
+
+  start = gst_util_get_timestamp ();
+  for (i = 0; i < n_frames; i++) {
+    fail_unless_equals_int (gst_harness_push (h, gst_buffer_copy (inbuf)),
+        GST_FLOW_OK);
+    if (outbuf)
+      gst_buffer_unref (outbuf);
+    outbuf = gst_harness_pull (h);
+  }
+  if (elapsed)
+    *elapsed = gst_util_get_timestamp () - start;
+
+  gst_harness_teardown (h);
+
+  return outbuf;
+}
+
+static void
+check_same_buffer (GstBuffer * a, GstBuffer * b)
+{
+  GstMapInfo map_a, map_b;
+
+  gst_buffer_map (a, &map_a, GST_MAP_READ);
+  gst_buffer_map (b, &map_b, GST_MAP_READ);
+  fail_unless_equals_int (map_a.size, map_b.size);
+  fail_unless (memcmp (map_a.data, map_b.data, map_a.size) == 0);
+  gst_buffer_unmap (a, &map_a);
+  gst_buffer_unmap (b, &map_b);
+}
+
+static void
+check_threads (const gchar * name, const gchar * prop, gdouble value)
+{
+  GRand *rand = g_rand_new_with_seed (0);
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (process_formats); i++) {
+    GstVideoInfo info;
+    GstBuffer *inbuf, *single, *threaded;
+
+    /* odd height so the last band is a short one */
+    gst_video_info_set_format (&info,
+        gst_video_format_from_string (process_formats[i]), 320, 243);
+    inbuf = create_random_frame (&info, rand);
+
+    single = process_frames (name, &info, inbuf, 1, NULL, prop, value,
+        "n-threads", 1, NULL);
+    threaded = process_frames (name, &info, inbuf, 1, NULL, prop, value,
+        "n-threads", 4, NULL);
+
+    GST_DEBUG ("checking %s", process_formats[i]);
+    check_same_buffer (single, threaded);
+
+    gst_buffer_unref (inbuf);
+    gst_buffer_unref (single);
+    gst_buffer_unref (threaded);
+  }
+
+  g_rand_free (rand);
+}
+
+GST_START_TEST (test_videobalance_threads)
+{
+  check_threads ("videobalance", "hue", 0.3);
+  check_threads ("videobalance", "contrast", 1.4);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_gamma_threads)
+{
+  check_threads ("gamma", "gamma", 2.0);
+}
+
+GST_END_TEST;
+
+/* Processes the same random I420 content as 8 and 10 bit and checks the
+ * results agree within @tolerance 10 bit units */
+static void
+check_high_depth (const gchar * name, gint tolerance, const gchar * prop,
+    gdouble value)
+{
+  GRand *rand = g_rand_new_with_seed (0);
+  GstVideoInfo info8, info10;
+  GstVideoFrame frame8, frame10;
+  GstBuffer *in8, *in10, *out8, *out10;
+  gint c, x, y;
+
+  gst_video_info_set_format (&info8, GST_VIDEO_FORMAT_I420, 320, 240);
+  gst_video_info_set_format (&info10,
+      gst_video_format_from_string (NE ("I420_10")), 320, 240);
+  in8 = create_random_frame (&info8, rand);
+  in10 = gst_buffer_new_and_alloc (GST_VIDEO_INFO_SIZE (&info10));
+
+  gst_video_frame_map (&frame8, &info8, in8, GST_MAP_READ);
+  gst_video_frame_map (&frame10, &info10, in10, GST_MAP_WRITE);
+  for (c = 0; c < 3; c++) {
+    for (y = 0; y < GST_VIDEO_FRAME_COMP_HEIGHT (&frame8, c); y++) {
+      guint8 *src = GST_VIDEO_FRAME_COMP_DATA (&frame8, c) +
+          y * GST_VIDEO_FRAME_COMP_STRIDE (&frame8, c);
+      guint16 *dest = (guint16 *) ((guint8 *)
+          GST_VIDEO_FRAME_COMP_DATA (&frame10, c) +
+          y * GST_VIDEO_FRAME_COMP_STRIDE (&frame10, c));
+
+      for (x = 0; x < GST_VIDEO_FRAME_COMP_WIDTH (&frame8, c); x++)
+        dest[x] = src[x] << 2;
+    }
+  }
+  gst_video_frame_unmap (&frame8);
+  gst_video_frame_unmap (&frame10);
+
+  out8 = process_frames (name, &info8, in8, 1, NULL, prop, value, NULL);
+  out10 = process_frames (name, &info10, in10, 1, NULL, prop, value, NULL);
+
+  gst_video_frame_map (&frame8, &info8, out8, GST_MAP_READ);
+  gst_video_frame_map (&frame10, &info10, out10, GST_MAP_READ);
+  for (c = 0; c < 3; c++) {
+    for (y = 0; y < GST_VIDEO_FRAME_COMP_HEIGHT (&frame8, c); y++) {
+      guint8 *ref = GST_VIDEO_FRAME_COMP_DATA (&frame8, c) +
+          y * GST_VIDEO_FRAME_COMP_STRIDE (&frame8, c);
+      guint16 *res = (guint16 *) ((guint8 *)
+          GST_VIDEO_FRAME_COMP_DATA (&frame10, c) +
+          y * GST_VIDEO_FRAME_COMP_STRIDE (&frame10, c));
+
+      for (x = 0; x < GST_VIDEO_FRAME_COMP_WIDTH (&frame8, c); x++)
+        fail_unless (ABS (res[x] - (ref[x] << 2)) <= tolerance,
+            "component %d at %d,%d: %d vs %d", c, x, y, res[x], ref[x] << 2);
+    }
+  }
+  gst_video_frame_unmap (&frame8);
+  gst_video_frame_unmap (&frame10);
+
+  gst_buffer_unref (in8);
+  gst_buffer_unref (in10);
+  gst_buffer_unref (out8);
+  gst_buffer_unref (out10);
+  g_rand_free (rand);
+}
+
+GST_START_TEST (test_videobalance_high_depth)
+{
+  check_high_depth ("videobalance", 4, "contrast", 1.4);
+  check_high_depth ("videobalance", 4, "brightness", -0.2);
+  check_high_depth ("videobalance", 4, "hue", 0.3);
+  check_high_depth ("videobalance", 4, "saturation", 1.7);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_gamma_high_depth)
+{
+  check_high_depth ("gamma", 4, "gamma", 2.0);
+  check_high_depth ("gamma", 4, "gamma", 0.8);
+}
+
+GST_END_TEST;
+
+#define PERF_FRAMES 10
+
+GST_START_TEST (test_videofilter_perf)
+{
+  const struct
+  {
+    const gchar *name, *prop;
+    gdouble value;
+  } filters[] = {
+    {"videobalance", "hue", 0.3},
+    {"gamma", "gamma", 2.0},
+  };
+  GRand *rand = g_rand_new_with_seed (0);
+  guint i, j;
+
+  for (i = 0; i < G_N_ELEMENTS (filters); i++) {
+    for (j = 0; j < G_N_ELEMENTS (process_formats); j++) {
+      GstVideoInfo info;
+      GstBuffer *inbuf;
+      GstClockTime single, threaded;
+
+      gst_video_info_set_format (&info,
+          gst_video_format_from_string (process_formats[j]), 3840, 2160);
+      inbuf = create_random_frame (&info, rand);
+
+      gst_buffer_unref (process_frames (filters[i].name, &info, inbuf,
+              PERF_FRAMES, &single, filters[i].prop, filters[i].value,
+              "n-threads", 1, NULL));
+      gst_buffer_unref (process_frames (filters[i].name, &info, inbuf,
+              PERF_FRAMES, &threaded, filters[i].prop, filters[i].value,
+              "n-threads", 0, NULL));
+
+      GST_INFO ("%s %s: %.2f ms per frame, %.2f ms with %u threads",
+          filters[i].name, process_formats[j],
+          (gdouble) single / GST_MSECOND / PERF_FRAMES,
+          (gdouble) threaded / GST_MSECOND / PERF_FRAMES,
+          g_get_num_processors ());
+
+      gst_buffer_unref (inbuf);
+    }
+  }
+
+  g_rand_free (rand);
+}
+
+GST_END_TEST;
+
+static gint
+compare_uint8 (gconstpointer a, gconstpointer b)
+{
+  return *(const guint8 *) a - *(const guint8 *) b;
+}
+
+/* checks @out against a sorted window median of @in, on all components */
+static void
+check_median (GstBuffer * in, GstBuffer * out, GstVideoInfo * info,
+    gint filtersize)
+{
+  GstVideoFrame in_frame, out_frame;
+  gint radius = 1;
+  gint c, x, y, i, j, n, expected;
+  guint8 window[81];
+
+  while ((2 * radius + 1) * (2 * radius + 1) < filtersize)
+    radius++;
+
+  gst_video_frame_map (&in_frame, info, in, GST_MAP_READ);
+  gst_video_frame_map (&out_frame, info, out, GST_MAP_READ);
+
+  for (c = 0; c < 3; c++) {
+    gint width = GST_VIDEO_FRAME_COMP_WIDTH (&in_frame, c);
+    gint height = GST_VIDEO_FRAME_COMP_HEIGHT (&in_frame, c);
+    gint sstride = GST_VIDEO_FRAME_COMP_STRIDE (&in_frame, c);
+    gint dstride = GST_VIDEO_FRAME_COMP_STRIDE (&out_frame, c);
+    const guint8 *src = GST_VIDEO_FRAME_COMP_DATA (&in_frame, c);
+    const guint8 *dest = GST_VIDEO_FRAME_COMP_DATA (&out_frame, c);
+
+    for (y = 0; y < height; y++) {
+      for (x = 0; x < width; x++) {
+        if (y < radius || y >= height - radius || x < radius
+            || x >= width - radius) {
+          expected = src[y * sstride + x];
+        } else if (filtersize == 5) {
+          window[0] = src[(y - 1) * sstride + x];
+          window[1] = src[y * sstride + x - 1];
+          window[2] = src[y * sstride + x];
+          window[3] = src[y * sstride + x + 1];
+          window[4] = src[(y + 1) * sstride + x];
+          qsort (window, 5, 1, compare_uint8);
+          expected = window[2];
+        } else {
+          for (j = -radius, n = 0; j <= radius; j++)
+            for (i = -radius; i <= radius; i++)
+              window[n++] = src[(y + j) * sstride + x + i];
+          qsort (window, n, 1, compare_uint8);
+          expected = window[n / 2];
+        }
+        fail_unless_equals_int (dest[y * dstride + x], expected);
+      }
+    }
+  }
+
+  gst_video_frame_unmap (&in_frame);
+  gst_video_frame_unmap (&out_frame);
+}
+
+static const gint median_sizes[] = { 5, 9, 25, 49, 81 };
+
+GST_START_TEST (test_videomedian)
+{
+  GRand *rand = g_rand_new_with_seed (0);
+  GstVideoInfo info;
+  GstBuffer *in, *single, *threaded;
+  guint i;
+
+  /* odd sizes so the chroma planes get partial bands and blocks */
+  gst_video_info_set_format (&info, GST_VIDEO_FORMAT_I420, 183, 97);
+  in = create_random_frame (&info, rand);
+
+  for (i = 0; i < G_N_ELEMENTS (median_sizes); i++) {
+    GST_DEBUG ("checking filtersize %d", median_sizes[i]);
+
+    single = process_frames ("videomedian", &info, in, 1, NULL,
+        "filtersize", median_sizes[i], "lum-only", FALSE, "n-threads", 1,
+        NULL);
+    check_median (in, single, &info, median_sizes[i]);
+
+    threaded = process_frames ("videomedian", &info, in, 1, NULL,
+        "filtersize", median_sizes[i], "lum-only", FALSE, "n-threads", 5,
+        NULL);
+    check_same_buffer (single, threaded);
+
+    gst_buffer_unref (single);
+    gst_buffer_unref (threaded);
+  }
+
+  gst_buffer_unref (in);
+  g_rand_free (rand);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_videomedian_perf)
+{
+  GRand *rand = g_rand_new_with_seed (0);
+  const gint heights[] = { 1080, 2160 };
+  guint i, j;
+
+  for (i = 0; i < G_N_ELEMENTS (heights); i++) {
+    GstVideoInfo info;
+    GstBuffer *in;
+
+    gst_video_info_set_format (&info, GST_VIDEO_FORMAT_I420,
+        heights[i] * 16 / 9, heights[i]);
+    in = create_random_frame (&info, rand);
+
+    for (j = 0; j < G_N_ELEMENTS (median_sizes); j++) {
+      GstClockTime single, threaded;
+
+      gst_buffer_unref (process_frames ("videomedian", &info, in, PERF_FRAMES,
+              &single, "filtersize", median_sizes[j], "n-threads", 1, NULL));
+      gst_buffer_unref (process_frames ("videomedian", &info, in, PERF_FRAMES,
+              &threaded, "filtersize", median_sizes[j], "n-threads", 0, NULL));
+
+      GST_INFO ("%dp filtersize %d: %.2f ms per frame, %.2f ms with %u "
+          "threads", heights[i], median_sizes[j],
+          (gdouble) single / GST_MSECOND / PERF_FRAMES,
+          (gdouble) threaded / GST_MSECOND / PERF_FRAMES,
+          g_get_num_processors ());
+    }
+
+    gst_buffer_unref (in);
+  }
+
+  g_rand_free (rand);
+}
+
+GST_END_TEST;
 
 static Suite *
 videofilter_suite (void)
@@ -258,6 +651,20 @@ videofilter_suite (void)
   tcase_add_test (tc_chain, test_videobalance);
   tcase_add_test (tc_chain, test_videoflip);
   tcase_add_test (tc_chain, test_gamma);
+  tcase_add_test (tc_chain, test_videobalance_threads);
+  tcase_add_test (tc_chain, test_gamma_threads);
+  tcase_add_test (tc_chain, test_videobalance_high_depth);
+  tcase_add_test (tc_chain, test_gamma_high_depth);
+  tcase_add_test (tc_chain, test_videomedian);
+
+  /* benchmarks only log their timings, run them with GST_CHECK_PERF=1 */
+  if (g_getenv ("GST_CHECK_PERF")) {
+    TCase *tc_perf = tcase_create ("perf");
+
+    suite_add_tcase (s, tc_perf);
+    tcase_add_test (tc_perf, test_videofilter_perf);
+    tcase_add_test (tc_perf, test_videomedian_perf);
+  }
 
   return s;
 }
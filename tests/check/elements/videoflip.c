@@ -21,6 +21,7 @@
  */
 
 #include <stdarg.h>
+#include <string.h>
 
 #include <gst/video/video.h>
 #include <gst/check/gstcheck.h>
@@ -268,6 +269,220 @@ GST_START_TEST (test_stress_change_method)
 
 GST_END_TEST;
 
+static const GstVideoFormat transpose_formats[] = {
+  GST_VIDEO_FORMAT_I420, GST_VIDEO_FORMAT_Y444_10LE, GST_VIDEO_FORMAT_NV12,
+  GST_VIDEO_FORMAT_RGB, GST_VIDEO_FORMAT_BGRA, GST_VIDEO_FORMAT_GRAY16_LE
+};
+
+static const gchar *transpose_methods[] = { "90r", "90l", "ul-lr", "ur-ll" };
+
+static GstBuffer *
+create_test_video_buffer_random (GstVideoInfo * info)
+{
+  guint8 *data = g_malloc (info->size);
+  gsize i;
+
+  for (i = 0; i < info->size; i++)
+    data[i] = g_random_int ();
+
+  return gst_buffer_new_wrapped (data, info->size);
+}
+
+/* per-pixel transpose of every plane of @src, as videoflip used to do it */
+static void
+transpose_reference (const gchar * method, GstVideoFrame * dest,
+    GstVideoFrame * src)
+{
+  guint p;
+
+  for (p = 0; p < GST_VIDEO_FRAME_N_PLANES (src); p++) {
+    const guint8 *s = GST_VIDEO_FRAME_PLANE_DATA (src, p);
+    guint8 *d = GST_VIDEO_FRAME_PLANE_DATA (dest, p);
+    gint ss = GST_VIDEO_FRAME_PLANE_STRIDE (src, p);
+    gint ds = GST_VIDEO_FRAME_PLANE_STRIDE (dest, p);
+    gint sw = GST_VIDEO_FRAME_COMP_WIDTH (src, p);
+    gint sh = GST_VIDEO_FRAME_COMP_HEIGHT (src, p);
+    gint ps = GST_VIDEO_FRAME_COMP_PSTRIDE (src, p);
+    gint x, y, z;
+
+    for (y = 0; y < GST_VIDEO_FRAME_COMP_HEIGHT (dest, p); y++) {
+      for (x = 0; x < GST_VIDEO_FRAME_COMP_WIDTH (dest, p); x++) {
+        gint sx, sy;
+
+        if (g_str_equal (method, "90r")) {
+          sx = y;
+          sy = sh - 1 - x;
+        } else if (g_str_equal (method, "90l")) {
+          sx = sw - 1 - y;
+          sy = x;
+        } else if (g_str_equal (method, "ul-lr")) {
+          sx = y;
+          sy = x;
+        } else {
+          sx = sw - 1 - y;
+          sy = sh - 1 - x;
+        }
+
+        for (z = 0; z < ps; z++)
+          d[y * ds + x * ps + z] = s[sy * ss + sx * ps + z];
+      }
+    }
+  }
+}
+
+static void
+check_frames_equal (GstVideoFrame * frame, GstVideoFrame * ref)
+{
+  guint p;
+  gint y;
+
+  for (p = 0; p < GST_VIDEO_FRAME_N_PLANES (ref); p++) {
+    const guint8 *d = GST_VIDEO_FRAME_PLANE_DATA (frame, p);
+    const guint8 *r = GST_VIDEO_FRAME_PLANE_DATA (ref, p);
+    gint row_size = GST_VIDEO_FRAME_COMP_WIDTH (ref, p) *
+        GST_VIDEO_FRAME_COMP_PSTRIDE (ref, p);
+
+    for (y = 0; y < GST_VIDEO_FRAME_COMP_HEIGHT (ref, p); y++) {
+      fail_unless (memcmp (d, r, row_size) == 0, "plane %u row %d differs",
+          p, y);
+      d += GST_VIDEO_FRAME_PLANE_STRIDE (frame, p);
+      r += GST_VIDEO_FRAME_PLANE_STRIDE (ref, p);
+    }
+  }
+}
+
+static GstBuffer *
+transpose_buffer (const gchar * method, guint n_threads,
+    GstVideoInfo * in_info, GstBuffer * in, GstClockTime * elapsed)
+{
+  GstHarness *flip = gst_harness_new ("videoflip");
+  GstClockTime start;
+  GstBuffer *out;
+
+  gst_util_set_object_arg (G_OBJECT (flip->element), "video-direction",
+      method);
+  g_object_set (flip->element, "n-threads", n_threads, NULL);
+  gst_harness_set_src_caps (flip, gst_video_info_to_caps (in_info));
+
+  start = gst_util_get_timestamp ();
+  out = gst_harness_push_and_pull (flip, in);
+  if (elapsed)
+    *elapsed = gst_util_get_timestamp () - start;
+  fail_unless (out != NULL);
+
+  gst_harness_teardown (flip);
+
+  return out;
+}
+
+/* the rotations and diagonal flips must match the per-pixel transpose for
+ * sizes that are not a multiple of the tile size, with one thread and with
+ * bands that end in a partial row of tiles */
+GST_START_TEST (test_transpose_formats)
+{
+  static const guint n_threads[] = { 1, 4 };
+  guint f, m, t;
+
+  for (f = 0; f < G_N_ELEMENTS (transpose_formats); f++) {
+    for (m = 0; m < G_N_ELEMENTS (transpose_methods); m++) {
+      GstVideoInfo in_info, out_info;
+      GstVideoFrame in_frame, out_frame, ref_frame;
+      GstBuffer *in, *out, *ref;
+
+      gst_video_info_set_format (&in_info, transpose_formats[f], 98, 70);
+      gst_video_info_set_format (&out_info, transpose_formats[f], 70, 98);
+
+      in = create_test_video_buffer_random (&in_info);
+      ref = gst_buffer_new_allocate (NULL, out_info.size, NULL);
+
+      fail_unless (gst_video_frame_map (&in_frame, &in_info, in,
+              GST_MAP_READ));
+      fail_unless (gst_video_frame_map (&ref_frame, &out_info, ref,
+              GST_MAP_WRITE));
+      transpose_reference (transpose_methods[m], &ref_frame, &in_frame);
+      gst_video_frame_unmap (&ref_frame);
+      gst_video_frame_unmap (&in_frame);
+
+      for (t = 0; t < G_N_ELEMENTS (n_threads); t++) {
+        GST_DEBUG ("checking %s %s with %u threads",
+            gst_video_format_to_string (transpose_formats[f]),
+            transpose_methods[m], n_threads[t]);
+
+        out = transpose_buffer (transpose_methods[m], n_threads[t], &in_info,
+            gst_buffer_ref (in), NULL);
+        fail_unless (gst_video_frame_map (&out_frame, &out_info, out,
+                GST_MAP_READ));
+        fail_unless (gst_video_frame_map (&ref_frame, &out_info, ref,
+                GST_MAP_READ));
+        check_frames_equal (&out_frame, &ref_frame);
+        gst_video_frame_unmap (&ref_frame);
+        gst_video_frame_unmap (&out_frame);
+        gst_buffer_unref (out);
+      }
+
+      gst_buffer_unref (in);
+      gst_buffer_unref (ref);
+    }
+  }
+}
+
+GST_END_TEST;
+
+#define PERF_FRAMES 10
+
+/* time each transposing method on 4K frames with one thread and with one
+ * thread per CPU, next to the per-pixel transpose the element used before */
+GST_START_TEST (test_transpose_perf)
+{
+  static const guint n_threads[] = { 1, 0 };
+  guint f, m, t, i;
+
+  for (f = 0; f < G_N_ELEMENTS (transpose_formats); f++) {
+    for (m = 0; m < G_N_ELEMENTS (transpose_methods); m++) {
+      GstVideoInfo in_info, out_info;
+      GstVideoFrame in_frame, ref_frame;
+      GstClockTime elapsed, flip_time[G_N_ELEMENTS (n_threads)] = { 0, };
+      GstClockTime ref_time = 0, start;
+      GstBuffer *in, *out, *ref;
+
+      gst_video_info_set_format (&in_info, transpose_formats[f], 3840, 2160);
+      gst_video_info_set_format (&out_info, transpose_formats[f], 2160, 3840);
+      in = create_test_video_buffer_random (&in_info);
+      ref = gst_buffer_new_allocate (NULL, out_info.size, NULL);
+
+      for (i = 0; i < PERF_FRAMES; i++) {
+        for (t = 0; t < G_N_ELEMENTS (n_threads); t++) {
+          out = transpose_buffer (transpose_methods[m], n_threads[t],
+              &in_info, gst_buffer_ref (in), &elapsed);
+          flip_time[t] += elapsed;
+          gst_buffer_unref (out);
+        }
+
+        gst_video_frame_map (&in_frame, &in_info, in, GST_MAP_READ);
+        gst_video_frame_map (&ref_frame, &out_info, ref, GST_MAP_WRITE);
+        start = gst_util_get_timestamp ();
+        transpose_reference (transpose_methods[m], &ref_frame, &in_frame);
+        ref_time += gst_util_get_timestamp () - start;
+        gst_video_frame_unmap (&ref_frame);
+        gst_video_frame_unmap (&in_frame);
+      }
+
+      GST_INFO ("%s %s: %.2f ms per frame, %.2f ms with a thread per CPU, "
+          "per-pixel %.2f ms per frame",
+          gst_video_format_to_string (transpose_formats[f]),
+          transpose_methods[m],
+          (gdouble) flip_time[0] / GST_MSECOND / PERF_FRAMES,
+          (gdouble) flip_time[1] / GST_MSECOND / PERF_FRAMES,
+          (gdouble) ref_time / GST_MSECOND / PERF_FRAMES);
+
+      gst_buffer_unref (in);
+      gst_buffer_unref (ref);
+    }
+  }
+}
+
+GST_END_TEST;
+
 static Suite *
 videoflip_suite (void)
 {
@@ -280,6 +495,15 @@ videoflip_suite (void)
   tcase_add_test (tc_chain,
       test_change_method_twice_same_caps_different_method);
   tcase_add_test (tc_chain, test_stress_change_method);
+  tcase_add_test (tc_chain, test_transpose_formats);
+
+  /* benchmarks only log their timings, run them with GST_CHECK_PERF=1 */
+  if (g_getenv ("GST_CHECK_PERF")) {
+    TCase *tc_perf = tcase_create ("perf");
+
+    suite_add_tcase (s, tc_perf);
+    tcase_add_test (tc_perf, test_transpose_perf);
+  }
 
   return s;
 }
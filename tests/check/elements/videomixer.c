@@ -32,6 +32,8 @@
 #include <gst/check/gstcheck.h>
 #include <gst/check/gstconsistencychecker.h>
 #include <gst/base/gstbasesrc.h>
+#include <gst/app/gstapp.h>
+#include <gst/video/video.h>
 
 #define VIDEO_CAPS_STRING               \
     "video/x-raw, "                 \
@@ -971,6 +973,310 @@ GST_START_TEST (test_loop)
 
 GST_END_TEST;
 
+typedef struct
+{
+  gint xpos, ypos;
+  gint width, height;
+  gdouble alpha;
+  GstVideoFormat format;
+} TestLayer;
+
+#define MIX_FPS 25
+
+/* content only depends on the layer, so the same layer mixed with different
+ * pads below or above it gets the same input */
+static guint32
+layer_seed (const TestLayer * layer)
+{
+  return (layer->xpos * 31 + layer->ypos) * 31 + layer->width * 7 +
+      layer->height + layer->format;
+}
+
+static GstBuffer *
+create_random_frame (GstVideoInfo * info, GRand * rand)
+{
+  GstBuffer *buffer = gst_buffer_new_and_alloc (GST_VIDEO_INFO_SIZE (info));
+  GstMapInfo map;
+  gsize i;
+
+  gst_buffer_map (buffer, &map, GST_MAP_WRITE);
+  for (i = 0; i + 4 <= map.size; i += 4)
+    GST_WRITE_UINT32_LE (map.data + i, g_rand_int (rand));
+  for (; i < map.size; i++)
+    map.data[i] = g_rand_int (rand);
+  gst_buffer_unmap (buffer, &map);
+
+  return buffer;
+}
+
+/* Mixes @n_frames frames of random content on @n_layers pads and returns the
+ * output buffers. With @static_inputs every pad gets a single buffer lasting
+ * all frames. */
+static GList *
+mix_layers (const TestLayer * layers, guint n_layers, guint n_frames,
+    gboolean static_inputs, guint n_threads, GstClockTime * elapsed)
+{
+  GstElement *pipeline, *videomixer, *sink;
+  GstElement **srcs = g_newa (GstElement *, n_layers);
+  GstClockTime start;
+  GstSample *sample;
+  GList *buffers = NULL;
+  guint i, f;
+
+  pipeline = gst_pipeline_new ("pipeline");
+  videomixer = gst_element_factory_make ("videomixer", NULL);
+  sink = gst_element_factory_make ("appsink", NULL);
+  g_object_set (videomixer, "n-threads", n_threads, NULL);
+  g_object_set (sink, "sync", FALSE, NULL);
+  gst_bin_add_many (GST_BIN (pipeline), videomixer, sink, NULL);
+  fail_unless (gst_element_link (videomixer, sink));
+
+  for (i = 0; i < n_layers; i++) {
+    GRand *rand = g_rand_new_with_seed (layer_seed (&layers[i]));
+    GstVideoInfo info;
+    GstCaps *caps;
+    GstPad *srcpad, *sinkpad;
+
+    gst_video_info_set_format (&info, layers[i].format, layers[i].width,
+        layers[i].height);
+    GST_VIDEO_INFO_FPS_N (&info) = MIX_FPS;
+    GST_VIDEO_INFO_FPS_D (&info) = 1;
+
+    caps = gst_video_info_to_caps (&info);
+    srcs[i] = gst_element_factory_make ("appsrc", NULL);
+    g_object_set (srcs[i], "format", GST_FORMAT_TIME, "caps", caps, NULL);
+    gst_caps_unref (caps);
+    gst_bin_add (GST_BIN (pipeline), srcs[i]);
+
+    sinkpad = gst_element_request_pad_simple (videomixer, "sink_%u");
+    g_object_set (sinkpad, "xpos", layers[i].xpos, "ypos", layers[i].ypos,
+        "alpha", layers[i].alpha, NULL);
+    srcpad = gst_element_get_static_pad (srcs[i], "src");
+    fail_unless_equals_int (gst_pad_link (srcpad, sinkpad), GST_PAD_LINK_OK);
+    gst_object_unref (srcpad);
+    gst_object_unref (sinkpad);
+
+    for (f = 0; f < n_frames; f++) {
+      GstBuffer *buffer = create_random_frame (&info, rand);
+
+      GST_BUFFER_PTS (buffer) = f * GST_SECOND / MIX_FPS;
+      GST_BUFFER_DURATION (buffer) = GST_SECOND / MIX_FPS;
+      if (static_inputs)
+        GST_BUFFER_DURATION (buffer) *= n_frames;
+      gst_app_src_push_buffer (GST_APP_SRC (srcs[i]), buffer);
+      if (static_inputs)
+        break;
+    }
+    gst_app_src_end_of_stream (GST_APP_SRC (srcs[i]));
+    g_rand_free (rand);
+  }
+
+  start = gst_util_get_timestamp ();
+  fail_unless (gst_element_set_state (pipeline, GST_STATE_PLAYING) !=
+      GST_STATE_CHANGE_FAILURE);
+
+  while ((sample = gst_app_sink_pull_sample (GST_APP_SINK (sink)))) {
+    buffers = g_list_append (buffers,
+        gst_buffer_ref (gst_sample_get_buffer (sample)));
+    gst_sample_unref (sample);
+  }
+  if (elapsed)
+    *elapsed = gst_util_get_timestamp () - start;
+
+  fail_unless_equals_int (g_list_length (buffers), n_frames);
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+
+  return buffers;
+}
+
+static void
+check_same_frame (GstBuffer * a, GstBuffer * b)
+{
+  GstMapInfo map;
+
+  fail_unless_equals_int (gst_buffer_get_size (a), gst_buffer_get_size (b));
+  gst_buffer_map (a, &map, GST_MAP_READ);
+  fail_unless (gst_buffer_memcmp (b, 0, map.data, map.size) == 0);
+  gst_buffer_unmap (a, &map);
+}
+
+static void
+check_same_frames (GList * a, GList * b)
+{
+  for (; a && b; a = a->next, b = b->next)
+    check_same_frame (a->data, b->data);
+  fail_unless (a == NULL && b == NULL);
+}
+
+/* 4x4 grid of tiles */
+static const TestLayer grid_layout[] = {
+  {0, 0, 80, 60, 1.0, GST_VIDEO_FORMAT_I420},
+  {80, 0, 80, 60, 1.0, GST_VIDEO_FORMAT_I420},
+  {160, 0, 80, 60, 1.0, GST_VIDEO_FORMAT_I420},
+  {240, 0, 80, 60, 1.0, GST_VIDEO_FORMAT_I420},
+  {0, 60, 80, 60, 1.0, GST_VIDEO_FORMAT_I420},
+  {80, 60, 80, 60, 1.0, GST_VIDEO_FORMAT_I420},
+  {160, 60, 80, 60, 1.0, GST_VIDEO_FORMAT_I420},
+  {240, 60, 80, 60, 1.0, GST_VIDEO_FORMAT_I420},
+  {0, 120, 80, 60, 1.0, GST_VIDEO_FORMAT_I420},
+  {80, 120, 80, 60, 1.0, GST_VIDEO_FORMAT_I420},
+  {160, 120, 80, 60, 1.0, GST_VIDEO_FORMAT_I420},
+  {240, 120, 80, 60, 1.0, GST_VIDEO_FORMAT_I420},
+  {0, 180, 80, 60, 1.0, GST_VIDEO_FORMAT_I420},
+  {80, 180, 80, 60, 1.0, GST_VIDEO_FORMAT_I420},
+  {160, 180, 80, 60, 1.0, GST_VIDEO_FORMAT_I420},
+  {240, 180, 80, 60, 1.0, GST_VIDEO_FORMAT_I420},
+};
+
+/* odd positions and sizes, partially transparent and converted pads
+ * overlapping each other */
+static const TestLayer cascade_layout[] = {
+  {0, 0, 320, 240, 1.0, GST_VIDEO_FORMAT_I420},
+  {-7, -3, 101, 77, 1.0, GST_VIDEO_FORMAT_I420},
+  {37, 23, 99, 61, 0.6, GST_VIDEO_FORMAT_Y42B},
+  {93, 51, 120, 90, 1.0, GST_VIDEO_FORMAT_I420},
+  {181, 3, 139, 97, 0.3, GST_VIDEO_FORMAT_I420},
+  {211, 131, 109, 109, 1.0, GST_VIDEO_FORMAT_Y444},
+  {5, 150, 75, 49, 0.0, GST_VIDEO_FORMAT_I420},
+  {1, 141, 157, 99, 1.0, GST_VIDEO_FORMAT_I420},
+};
+
+GST_START_TEST (test_blend_threads)
+{
+  const struct
+  {
+    const TestLayer *layers;
+    guint n_layers;
+  } layouts[] = {
+    {grid_layout, G_N_ELEMENTS (grid_layout)},
+    {cascade_layout, G_N_ELEMENTS (cascade_layout)},
+  };
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (layouts); i++) {
+    GList *ref, *threaded;
+
+    ref = mix_layers (layouts[i].layers, layouts[i].n_layers, 5, FALSE, 1,
+        NULL);
+    threaded = mix_layers (layouts[i].layers, layouts[i].n_layers, 5, FALSE,
+        4, NULL);
+    check_same_frames (ref, threaded);
+
+    g_list_free_full (ref, (GDestroyNotify) gst_buffer_unref);
+    g_list_free_full (threaded, (GDestroyNotify) gst_buffer_unref);
+  }
+}
+
+GST_END_TEST;
+
+/* a pad completely covering the output replaces everything below it */
+GST_START_TEST (test_blend_occluded)
+{
+  const TestLayer layers[] = {
+    {0, 0, 320, 240, 1.0, GST_VIDEO_FORMAT_I420},
+    {16, 16, 64, 64, 0.5, GST_VIDEO_FORMAT_I420},
+    {0, 0, 320, 240, 1.0, GST_VIDEO_FORMAT_I420},
+  };
+  GList *frames, *top;
+
+  frames = mix_layers (layers, G_N_ELEMENTS (layers), 3, FALSE, 1, NULL);
+  top = mix_layers (&layers[2], 1, 3, FALSE, 1, NULL);
+  check_same_frames (frames, top);
+
+  g_list_free_full (frames, (GDestroyNotify) gst_buffer_unref);
+  g_list_free_full (top, (GDestroyNotify) gst_buffer_unref);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_blend_static_inputs)
+{
+  GList *frames, *l;
+  GstMemory *mem = NULL;
+  guint i;
+
+  frames = mix_layers (cascade_layout, G_N_ELEMENTS (cascade_layout), 6, TRUE,
+      1, NULL);
+  for (l = frames->next; l; l = l->next)
+    check_same_frame (frames->data, l->data);
+
+  /* the second frame shows the inputs are static, from there on the frames
+   * share memory */
+  for (l = frames->next, i = 1; l; l = l->next, i++) {
+    if (!mem)
+      mem = gst_buffer_peek_memory (l->data, 0);
+    fail_unless (gst_buffer_peek_memory (l->data, 0) == mem,
+        "frame %u was blended again", i);
+  }
+
+  g_list_free_full (frames, (GDestroyNotify) gst_buffer_unref);
+}
+
+GST_END_TEST;
+
+#define PERF_FRAMES 10
+
+GST_START_TEST (test_blend_perf)
+{
+  TestLayer grid[16], overlap[5];
+  const struct
+  {
+    const gchar *name;
+    const TestLayer *layers;
+    guint n_layers;
+    gboolean static_inputs;
+  } layouts[] = {
+    {"16 tiles", grid, G_N_ELEMENTS (grid), FALSE},
+    {"16 static tiles", grid, G_N_ELEMENTS (grid), TRUE},
+    {"overlapping", overlap, G_N_ELEMENTS (overlap), FALSE},
+  };
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (grid); i++) {
+    grid[i].xpos = (i % 4) * 480;
+    grid[i].ypos = (i / 4) * 270;
+    grid[i].width = 480;
+    grid[i].height = 270;
+    grid[i].alpha = 1.0;
+    grid[i].format = GST_VIDEO_FORMAT_I420;
+  }
+
+  /* a full frame background with translucent pads stacked on top */
+  overlap[0].xpos = overlap[0].ypos = 0;
+  overlap[0].width = 1920;
+  overlap[0].height = 1080;
+  overlap[0].alpha = 1.0;
+  overlap[0].format = GST_VIDEO_FORMAT_I420;
+  for (i = 1; i < G_N_ELEMENTS (overlap); i++) {
+    overlap[i].xpos = i * 200;
+    overlap[i].ypos = i * 100;
+    overlap[i].width = 960;
+    overlap[i].height = 540;
+    overlap[i].alpha = 0.5;
+    overlap[i].format = GST_VIDEO_FORMAT_I420;
+  }
+
+  for (i = 0; i < G_N_ELEMENTS (layouts); i++) {
+    GstClockTime single, threaded;
+
+    g_list_free_full (mix_layers (layouts[i].layers, layouts[i].n_layers,
+            PERF_FRAMES, layouts[i].static_inputs, 1, &single),
+        (GDestroyNotify) gst_buffer_unref);
+    g_list_free_full (mix_layers (layouts[i].layers, layouts[i].n_layers,
+            PERF_FRAMES, layouts[i].static_inputs, 0, &threaded),
+        (GDestroyNotify) gst_buffer_unref);
+
+    GST_INFO ("%s: %.2f ms per frame, %.2f ms with %u threads",
+        layouts[i].name, (gdouble) single / GST_MSECOND / PERF_FRAMES,
+        (gdouble) threaded / GST_MSECOND / PERF_FRAMES,
+        g_get_num_processors ());
+  }
+}
+
+GST_END_TEST;
+
 #if 0
 GST_START_TEST (test_flush_start_flush_stop)
 {
@@ -1043,6 +1349,9 @@ videomixer_suite (void)
   tcase_add_test (tc_chain, test_duration_is_max);
   tcase_add_test (tc_chain, test_duration_unknown_overrides);
   tcase_add_test (tc_chain, test_loop);
+  tcase_add_test (tc_chain, test_blend_threads);
+  tcase_add_test (tc_chain, test_blend_occluded);
+  tcase_add_test (tc_chain, test_blend_static_inputs);
   /* This test is racy and occasionally fails in interesting ways
    * just like the corresponding adder test does/did, see
    * https://bugzilla.gnome.org/show_bug.cgi?id=708891
@@ -1063,6 +1372,14 @@ videomixer_suite (void)
     /* tcase_set_timeout (tc_chain, 6); */
   }
 
+  /* benchmarks only log their timings, run them with GST_CHECK_PERF=1 */
+  if (g_getenv ("GST_CHECK_PERF")) {
+    TCase *tc_perf = tcase_create ("perf");
+
+    suite_add_tcase (s, tc_perf);
+    tcase_add_test (tc_perf, test_blend_perf);
+  }
+
   return s;
 }
 